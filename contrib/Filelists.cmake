@@ -14,6 +14,7 @@ endif()
 
 set(lwipcontribexamples_SRCS
     ${LWIP_CONTRIB_DIR}/examples/httpd/fs_example/fs_example.c
+    ${LWIP_CONTRIB_DIR}/examples/httpd/fs_posix_example/fs_posix_example.c
     ${LWIP_CONTRIB_DIR}/examples/httpd/https_example/https_example.c
     ${LWIP_CONTRIB_DIR}/examples/httpd/ssi_example/ssi_example.c
     ${LWIP_CONTRIB_DIR}/examples/lwiperf/lwiperf_example.c
@@ -42,6 +42,7 @@ CONTRIBAPPFILES=$(CONTRIBDIR)/apps/httpserver/httpserver-netconn.c \
 	$(CONTRIBDIR)/apps/socket_examples/socket_examples.c \
 	$(CONTRIBDIR)/apps/rtp/rtp.c \
 	$(CONTRIBDIR)/examples/httpd/fs_example/fs_example.c \
+	$(CONTRIBDIR)/examples/httpd/fs_posix_example/fs_posix_example.c \
 	$(CONTRIBDIR)/examples/httpd/https_example/https_example.c \
 	$(CONTRIBDIR)/examples/httpd/ssi_example/ssi_example.c \
 	$(CONTRIBDIR)/examples/lwiperf/lwiperf_example.c \
@@ -83,6 +83,7 @@
 
 #include "examples/httpd/cgi_example/cgi_example.h"
 #include "examples/httpd/fs_example/fs_example.h"
+#include "examples/httpd/fs_posix_example/fs_posix_example.h"
 #include "examples/httpd/https_example/https_example.h"
 #include "examples/httpd/ssi_example/ssi_example.h"
 
@@ -530,6 +531,9 @@ apps_init(void)
 #else /* LWIP_HTTPD_APP_NETCONN */
 #if defined(LWIP_HTTPD_EXAMPLE_CUSTOMFILES) && LWIP_HTTPD_EXAMPLE_CUSTOMFILES && defined(LWIP_HTTPD_EXAMPLE_CUSTOMFILES_ROOTDIR)
   fs_ex_init(LWIP_HTTPD_EXAMPLE_CUSTOMFILES_ROOTDIR);
+#endif
+#if defined(LWIP_HTTPD_EXAMPLE_POSIXFILES) && LWIP_HTTPD_EXAMPLE_POSIXFILES && defined(LWIP_HTTPD_EXAMPLE_POSIXFILES_ROOTDIR)
+  fs_posix_init(LWIP_HTTPD_EXAMPLE_POSIXFILES_ROOTDIR);
 #endif
   httpd_init();
 #if defined(LWIP_HTTPD_EXAMPLE_SSI_SIMPLE) && LWIP_HTTPD_EXAMPLE_SSI_SIMPLE
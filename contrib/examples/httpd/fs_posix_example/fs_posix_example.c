@@ -0,0 +1,635 @@
+/**
+ * @file
+ * HTTPD file system serving a directory via POSIX file I/O
+ *
+ * This file system serves the files below a root directory. Files are read
+ * by a pool of worker threads into an LRU page cache shared by all
+ * connections, so reading from a slow disk does not block the tcpip thread:
+ * fs_read_async() copies data from cached pages or returns FS_READ_DELAYED
+ * and httpd is continued via a callback message (allocated when the read is
+ * queued) once the page has been read. If no page or queue entry is available,
+ * the read is retried when a page has been read or after FS_POSIX_RETRY_MS.
+ * While a file is sent, the pages following the current read position are
+ * read ahead.
+ *
+ * All cache and file state is only accessed from the tcpip thread; a worker
+ * thread only fills the data of a page that is reserved for it while loading.
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/opt.h"
+#include "fs_posix_example.h"
+
+#include "lwip/apps/fs.h"
+#include "lwip/def.h"
+#include "lwip/mem.h"
+#include "lwip/sys.h"
+#include "lwip/tcpip.h"
+#include "lwip/timeouts.h"
+
+#include <string.h>
+
+/** define LWIP_HTTPD_EXAMPLE_POSIXFILES to 1 to enable this file system */
+#ifndef LWIP_HTTPD_EXAMPLE_POSIXFILES
+#define LWIP_HTTPD_EXAMPLE_POSIXFILES 0
+#endif
+
+/** Number of worker threads reading files */
+#ifndef FS_POSIX_THREADS
+#define FS_POSIX_THREADS 2
+#endif
+
+/** Size of a cache page: files are read in units of this size */
+#ifndef FS_POSIX_PAGE_SIZE
+#define FS_POSIX_PAGE_SIZE 8192
+#endif
+
+/** Number of pages in the page cache */
+#ifndef FS_POSIX_CACHE_PAGES
+#define FS_POSIX_CACHE_PAGES 64
+#endif
+
+/** Number of hash buckets to look up cached pages (must be a power of 2) */
+#ifndef FS_POSIX_HASH_SIZE
+#define FS_POSIX_HASH_SIZE 32
+#endif
+
+/** Number of pages to read ahead of the current read position of a file */
+#ifndef FS_POSIX_READ_AHEAD
+#define FS_POSIX_READ_AHEAD 4
+#endif
+
+/** Number of page reads that can be queued for the worker threads */
+#ifndef FS_POSIX_QUEUE_LEN
+#define FS_POSIX_QUEUE_LEN 32
+#endif
+
+/** Time (in milliseconds) after which a read that could not be queued is
+ * retried (if no page has been read before) */
+#ifndef FS_POSIX_RETRY_MS
+#define FS_POSIX_RETRY_MS 10
+#endif
+
+#if LWIP_HTTPD_EXAMPLE_POSIXFILES
+
+#if NO_SYS
+#error This needs threads (NO_SYS==0)
+#endif
+#if !LWIP_HTTPD_CUSTOM_FILES
+#error This needs LWIP_HTTPD_CUSTOM_FILES
+#endif
+#if !LWIP_HTTPD_DYNAMIC_HEADERS
+#error This needs LWIP_HTTPD_DYNAMIC_HEADERS
+#endif
+#if !LWIP_HTTPD_DYNAMIC_FILE_READ
+#error This needs LWIP_HTTPD_DYNAMIC_FILE_READ
+#endif
+#if !LWIP_HTTPD_FS_ASYNC_READ
+#error This needs LWIP_HTTPD_FS_ASYNC_READ
+#endif
+#if !LWIP_HTTPD_FILE_EXTENSION
+#error This needs LWIP_HTTPD_FILE_EXTENSION
+#endif
+#if defined(LWIP_HTTPD_EXAMPLE_CUSTOMFILES) && LWIP_HTTPD_EXAMPLE_CUSTOMFILES
+#error LWIP_HTTPD_EXAMPLE_CUSTOMFILES and LWIP_HTTPD_EXAMPLE_POSIXFILES cannot be used together
+#endif
+#if (FS_POSIX_HASH_SIZE & (FS_POSIX_HASH_SIZE - 1)) != 0
+#error FS_POSIX_HASH_SIZE must be a power of 2
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FS_POSIX_PAGE_EMPTY   0
+#define FS_POSIX_PAGE_LOADING 1
+#define FS_POSIX_PAGE_VALID   2
+
+struct fs_posix_file;
+
+/** A page of the cache, identified by the file (device, inode and modification
+ * time, so that changed files are read again) and the page index in the file */
+struct fs_posix_page {
+  /* LRU list, the most recently used page first */
+  struct fs_posix_page *lru_prev;
+  struct fs_posix_page *lru_next;
+  /* hash bucket */
+  struct fs_posix_page *hash_next;
+  dev_t dev;
+  ino_t ino;
+  time_t mtime;
+  u32_t index;
+  /* file the page is read from while loading */
+  struct fs_posix_file *loader;
+  /* message passing the page back to the tcpip thread while loading */
+  struct tcpip_callback_msg *loaded_msg;
+  /* number of valid bytes (less than a page at the end of the file) */
+  int len;
+  u8_t state;
+  char *data;
+};
+
+/** State of an open file (file->pextension) */
+struct fs_posix_file {
+  int fd;
+  dev_t dev;
+  ino_t ino;
+  time_t mtime;
+  int len;
+  /* the open file and each page loading from it hold a reference */
+  u16_t refcount;
+  /* reading a page has failed */
+  u8_t error;
+  /* page this file waits for (linked into fs_posix_waiting while callback_fn
+     is set), NULL while waiting for a page or queue entry to become available */
+  struct fs_posix_page *wait_page;
+  fs_wait_cb callback_fn;
+  void *callback_arg;
+  struct fs_posix_file *wait_next;
+  /* to be continued by fs_posix_continue() */
+  u8_t wake;
+};
+
+static char *fs_posix_root_dir;
+static struct fs_posix_page fs_posix_pages[FS_POSIX_CACHE_PAGES];
+static struct fs_posix_page *fs_posix_hash[FS_POSIX_HASH_SIZE];
+static struct fs_posix_page *fs_posix_lru_first;
+static struct fs_posix_page *fs_posix_lru_last;
+static struct fs_posix_file *fs_posix_waiting;
+static sys_mbox_t fs_posix_queue;
+static u8_t fs_posix_retry_pending;
+
+static u16_t
+fs_posix_hash_idx(ino_t ino, u32_t index)
+{
+  u32_t h = (u32_t)ino * 2654435761UL;
+  h ^= index * 40503UL;
+  return (u16_t)((h ^ (h >> 16)) & (FS_POSIX_HASH_SIZE - 1));
+}
+
+static void
+fs_posix_lru_remove(struct fs_posix_page *page)
+{
+  if (page->lru_prev != NULL) {
+    page->lru_prev->lru_next = page->lru_next;
+  } else {
+    fs_posix_lru_first = page->lru_next;
+  }
+  if (page->lru_next != NULL) {
+    page->lru_next->lru_prev = page->lru_prev;
+  } else {
+    fs_posix_lru_last = page->lru_prev;
+  }
+}
+
+/** Mark a page as the most recently used one */
+static void
+fs_posix_lru_use(struct fs_posix_page *page)
+{
+  if (fs_posix_lru_first != page) {
+    fs_posix_lru_remove(page);
+    page->lru_prev = NULL;
+    page->lru_next = fs_posix_lru_first;
+    fs_posix_lru_first->lru_prev = page;
+    fs_posix_lru_first = page;
+  }
+}
+
+static void
+fs_posix_hash_remove(struct fs_posix_page *page)
+{
+  struct fs_posix_page **pp = &fs_posix_hash[fs_posix_hash_idx(page->ino, page->index)];
+  while (*pp != NULL) {
+    if (*pp == page) {
+      *pp = page->hash_next;
+      break;
+    }
+    pp = &(*pp)->hash_next;
+  }
+  page->hash_next = NULL;
+}
+
+static struct fs_posix_page *
+fs_posix_page_find(struct fs_posix_file *pf, u32_t index)
+{
+  struct fs_posix_page *page;
+  for (page = fs_posix_hash[fs_posix_hash_idx(pf->ino, index)]; page != NULL; page = page->hash_next) {
+    if ((page->index == index) && (page->ino == pf->ino) && (page->dev == pf->dev) &&
+        (page->mtime == pf->mtime)) {
+      return page;
+    }
+  }
+  return NULL;
+}
+
+static void
+fs_posix_file_unref(struct fs_posix_file *pf)
+{
+  LWIP_ASSERT("refcount != 0", pf->refcount != 0);
+  pf->refcount--;
+  if (pf->refcount == 0) {
+    close(pf->fd);
+    mem_free(pf);
+  }
+}
+
+/** Continue the files waiting for 'page' and those waiting for a page or
+ * queue entry to become available */
+static void
+fs_posix_continue(struct fs_posix_page *page)
+{
+  struct fs_posix_file *pf;
+
+  /* mark them first: a callback may wait again */
+  for (pf = fs_posix_waiting; pf != NULL; pf = pf->wait_next) {
+    if ((pf->wait_page == page) || (pf->wait_page == NULL)) {
+      pf->wake = 1;
+    }
+  }
+  /* a callback may change the list */
+  pf = fs_posix_waiting;
+  while (pf != NULL) {
+    if (pf->wake) {
+      struct fs_posix_file **pp = &fs_posix_waiting;
+      fs_wait_cb callback_fn = pf->callback_fn;
+      void *callback_arg = pf->callback_arg;
+      while (*pp != pf) {
+        pp = &(*pp)->wait_next;
+      }
+      *pp = pf->wait_next;
+      pf->wait_next = NULL;
+      pf->wait_page = NULL;
+      pf->callback_fn = NULL;
+      pf->callback_arg = NULL;
+      pf->wake = 0;
+      callback_fn(callback_arg);
+      pf = fs_posix_waiting;
+    } else {
+      pf = pf->wait_next;
+    }
+  }
+}
+
+/** Timer retrying reads that could not be queued */
+static void
+fs_posix_retry(void *arg)
+{
+  LWIP_UNUSED_ARG(arg);
+  fs_posix_retry_pending = 0;
+  fs_posix_continue(NULL);
+}
+
+/** Called in the tcpip thread when a worker thread has read a page */
+static void
+fs_posix_page_loaded(void *arg)
+{
+  struct fs_posix_page *page = (struct fs_posix_page *)arg;
+  struct fs_posix_file *pf;
+
+  LWIP_ASSERT("page is loading", page->state == FS_POSIX_PAGE_LOADING);
+  /* not used by tcpip_thread after calling us */
+  tcpip_callbackmsg_delete(page->loaded_msg);
+  page->loaded_msg = NULL;
+  if (page->len < 0) {
+    /* read error: don't cache, end the transfer of the waiting files */
+    page->len = 0;
+    page->state = FS_POSIX_PAGE_EMPTY;
+    fs_posix_hash_remove(page);
+    for (pf = fs_posix_waiting; pf != NULL; pf = pf->wait_next) {
+      if (pf->wait_page == page) {
+        pf->error = 1;
+      }
+    }
+  } else {
+    page->state = FS_POSIX_PAGE_VALID;
+  }
+  fs_posix_file_unref(page->loader);
+  page->loader = NULL;
+
+  /* a page is available again, too */
+  fs_posix_continue(page);
+}
+
+/** Worker thread: read the pages queued into the page data */
+static void
+fs_posix_worker(void *arg)
+{
+  LWIP_UNUSED_ARG(arg);
+
+  for (;;) {
+    struct fs_posix_page *page;
+    void *msg;
+    ssize_t len;
+
+    sys_mbox_fetch(&fs_posix_queue, &msg);
+    page = (struct fs_posix_page *)msg;
+    do {
+      len = pread(page->loader->fd, page->data, FS_POSIX_PAGE_SIZE,
+                  (off_t)page->index * FS_POSIX_PAGE_SIZE);
+    } while ((len < 0) && (errno == EINTR));
+    page->len = (len < 0) ? -1 : (int)len;
+    /* the page is reserved for this thread until fs_posix_page_loaded();
+       the message cannot fail to allocate, only the tcpip mbox may be full */
+    while (tcpip_callbackmsg_trycallback(page->loaded_msg) != ERR_OK) {
+      sys_msleep(1);
+    }
+  }
+}
+
+/** Queue a page of a file to be read by a worker thread.
+ *
+ * @return the page (loading) or NULL if no page, callback message or queue
+ *         entry is available
+ */
+static struct fs_posix_page *
+fs_posix_page_load(struct fs_posix_file *pf, u32_t index)
+{
+  struct fs_posix_page *page;
+  struct tcpip_callback_msg *msg;
+
+  /* reuse the least recently used page that is not loading */
+  for (page = fs_posix_lru_last; page != NULL; page = page->lru_prev) {
+    if (page->state != FS_POSIX_PAGE_LOADING) {
+      break;
+    }
+  }
+  if (page == NULL) {
+    return NULL;
+  }
+  msg = tcpip_callbackmsg_new(fs_posix_page_loaded, page);
+  if (msg == NULL) {
+    return NULL;
+  }
+  if (page->state == FS_POSIX_PAGE_VALID) {
+    fs_posix_hash_remove(page);
+  }
+  page->dev = pf->dev;
+  page->ino = pf->ino;
+  page->mtime = pf->mtime;
+  page->index = index;
+  page->len = 0;
+  page->loader = pf;
+  page->loaded_msg = msg;
+  page->state = FS_POSIX_PAGE_LOADING;
+  if (sys_mbox_trypost(&fs_posix_queue, page) != ERR_OK) {
+    tcpip_callbackmsg_delete(msg);
+    page->loaded_msg = NULL;
+    page->loader = NULL;
+    page->state = FS_POSIX_PAGE_EMPTY;
+    return NULL;
+  }
+  pf->refcount++;
+  page->hash_next = fs_posix_hash[fs_posix_hash_idx(page->ino, index)];
+  fs_posix_hash[fs_posix_hash_idx(page->ino, index)] = page;
+  fs_posix_lru_use(page);
+  return page;
+}
+
+/** Queue the pages following 'index' that are not cached yet */
+static void
+fs_posix_read_ahead(struct fs_posix_file *pf, u32_t index)
+{
+  u32_t last = (u32_t)(pf->len - 1) / FS_POSIX_PAGE_SIZE;
+  u32_t i;
+
+  for (i = index + 1; (i <= index + FS_POSIX_READ_AHEAD) && (i <= last); i++) {
+    if (fs_posix_page_find(pf, i) == NULL) {
+      if (fs_posix_page_load(pf, i) == NULL) {
+        /* cache or queue exhausted */
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * Initialize the file system and start the worker threads.
+ *
+ * @param httpd_root_dir directory to serve the files from
+ */
+void
+fs_posix_init(const char *httpd_root_dir)
+{
+  int i;
+
+  LWIP_ASSERT("httpd_root_dir != NULL", httpd_root_dir != NULL);
+  fs_posix_root_dir = strdup(httpd_root_dir);
+  LWIP_ASSERT("out of memory?", fs_posix_root_dir != NULL);
+  for (i = 0; i < FS_POSIX_CACHE_PAGES; i++) {
+    struct fs_posix_page *page = &fs_posix_pages[i];
+    page->data = (char *)malloc(FS_POSIX_PAGE_SIZE);
+    LWIP_ASSERT("out of memory?", page->data != NULL);
+    page->state = FS_POSIX_PAGE_EMPTY;
+    page->lru_prev = (i > 0) ? &fs_posix_pages[i - 1] : NULL;
+    page->lru_next = (i < FS_POSIX_CACHE_PAGES - 1) ? &fs_posix_pages[i + 1] : NULL;
+  }
+  fs_posix_lru_first = &fs_posix_pages[0];
+  fs_posix_lru_last = &fs_posix_pages[FS_POSIX_CACHE_PAGES - 1];
+  if (sys_mbox_new(&fs_posix_queue, FS_POSIX_QUEUE_LEN) != ERR_OK) {
+    LWIP_ASSERT("failed to create the read queue", 0);
+  }
+  for (i = 0; i < FS_POSIX_THREADS; i++) {
+    sys_thread_new("httpd_fs", fs_posix_worker, NULL, DEFAULT_THREAD_STACKSIZE, DEFAULT_THREAD_PRIO);
+  }
+}
+
+int
+fs_open_custom(struct fs_file *file, const char *name)
+{
+  char full_filename[256];
+  struct fs_posix_file *pf;
+  struct stat st;
+  const char *p;
+  int fd, ret;
+
+  /* don't allow to leave the root directory */
+  for (p = name; (p = strstr(p, "..")) != NULL; p += 2) {
+    if (((p == name) || (p[-1] == '/')) && ((p[2] == 0) || (p[2] == '/'))) {
+      return 0;
+    }
+  }
+  ret = snprintf(full_filename, sizeof(full_filename), "%s%s", fs_posix_root_dir, name);
+  if ((ret < 0) || ((size_t)ret >= sizeof(full_filename))) {
+    return 0;
+  }
+  fd = open(full_filename, O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+  if ((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode) || (st.st_size > 0x7FFFFFFF)) {
+    close(fd);
+    return 0;
+  }
+  pf = (struct fs_posix_file *)mem_malloc(sizeof(struct fs_posix_file));
+  if (pf == NULL) {
+    close(fd);
+    return 0;
+  }
+  memset(pf, 0, sizeof(struct fs_posix_file));
+  pf->fd = fd;
+  pf->dev = st.st_dev;
+  pf->ino = st.st_ino;
+  pf->mtime = st.st_mtime;
+  pf->len = (int)st.st_size;
+  pf->refcount = 1;
+
+  memset(file, 0, sizeof(struct fs_file));
+  file->len = pf->len;
+  file->flags = FS_FILE_FLAGS_HEADER_PERSISTENT;
+  file->pextension = pf;
+  return 1;
+}
+
+void
+fs_close_custom(struct fs_file *file)
+{
+  if (file && file->pextension) {
+    struct fs_posix_file *pf = (struct fs_posix_file *)file->pextension;
+    if (pf->callback_fn != NULL) {
+      struct fs_posix_file **pp = &fs_posix_waiting;
+      while (*pp != NULL) {
+        if (*pp == pf) {
+          *pp = pf->wait_next;
+          break;
+        }
+        pp = &(*pp)->wait_next;
+      }
+      pf->wait_page = NULL;
+      pf->callback_fn = NULL;
+      pf->callback_arg = NULL;
+    }
+    file->pextension = NULL;
+    /* pages still loading from this file keep it open */
+    fs_posix_file_unref(pf);
+  }
+}
+
+u8_t
+fs_canread_custom(struct fs_file *file)
+{
+  struct fs_posix_file *pf;
+  struct fs_posix_page *page;
+
+  LWIP_ASSERT("file != NULL", file != NULL);
+  pf = (struct fs_posix_file *)file->pextension;
+  if ((pf == NULL) || (file->index >= file->len)) {
+    return 1;
+  }
+  page = fs_posix_page_find(pf, (u32_t)file->index / FS_POSIX_PAGE_SIZE);
+  return (u8_t)((page != NULL) && (page->state == FS_POSIX_PAGE_VALID));
+}
+
+u8_t
+fs_wait_read_custom(struct fs_file *file, fs_wait_cb callback_fn, void *callback_arg)
+{
+  struct fs_posix_file *pf = (struct fs_posix_file *)file->pextension;
+  struct fs_posix_page *page;
+  u32_t index;
+
+  LWIP_ASSERT("data not set", pf != NULL);
+  LWIP_ASSERT("already waiting", pf->callback_fn == NULL);
+  index = (u32_t)file->index / FS_POSIX_PAGE_SIZE;
+  page = fs_posix_page_find(pf, index);
+  if (page == NULL) {
+    page = fs_posix_page_load(pf, index);
+    if ((page == NULL) && !fs_posix_retry_pending) {
+      /* no page, callback message or queue entry available: retry when a
+         page has been read or after a timeout (not reading synchronously,
+         that would block the tcpip thread) */
+      fs_posix_retry_pending = 1;
+      sys_timeout(FS_POSIX_RETRY_MS, fs_posix_retry, NULL);
+    }
+  } else if (page->state == FS_POSIX_PAGE_VALID) {
+    return 0;
+  }
+  pf->wait_page = page;
+  pf->callback_fn = callback_fn;
+  pf->callback_arg = callback_arg;
+  pf->wait_next = fs_posix_waiting;
+  fs_posix_waiting = pf;
+  /* 1: the callback is called when the page is read (or may be retried) */
+  return 1;
+}
+
+int
+fs_read_async_custom(struct fs_file *file, char *buffer, int count, fs_wait_cb callback_fn, void *callback_arg)
+{
+  struct fs_posix_file *pf = (struct fs_posix_file *)file->pextension;
+  struct fs_posix_page *page = NULL;
+  int read = 0;
+
+  LWIP_ASSERT("data not set", pf != NULL);
+  if (pf->error) {
+    return FS_READ_EOF;
+  }
+
+  /* copy as much as possible from consecutive cached pages */
+  while ((read < count) && (file->index < file->len)) {
+    u32_t index = (u32_t)file->index / FS_POSIX_PAGE_SIZE;
+    int offset = file->index - (int)(index * FS_POSIX_PAGE_SIZE);
+    int len;
+
+    page = fs_posix_page_find(pf, index);
+    if ((page == NULL) || (page->state != FS_POSIX_PAGE_VALID)) {
+      break;
+    }
+    fs_posix_lru_use(page);
+    if (offset >= page->len) {
+      /* the file has been truncated */
+      file->len = file->index;
+      break;
+    }
+    len = LWIP_MIN(count - read, page->len - offset);
+    MEMCPY(buffer + read, page->data + offset, len);
+    read += len;
+    file->index += len;
+  }
+  if (read > 0) {
+    fs_posix_read_ahead(pf, (u32_t)(file->index - 1) / FS_POSIX_PAGE_SIZE);
+    return read;
+  }
+  if (file->index >= file->len) {
+    return FS_READ_EOF;
+  }
+  /* the page is not cached: wait for it to be read */
+  if (fs_wait_read_custom(file, callback_fn, callback_arg)) {
+    return FS_READ_DELAYED;
+  }
+  /* not reached: the page is not valid */
+  return FS_READ_EOF;
+}
+
+#endif /* LWIP_HTTPD_EXAMPLE_POSIXFILES */
@@ -41,6 +41,8 @@ set(lwipcore_SRCS
     ${LWIP_DIR}/src/core/dns.c
     ${LWIP_DIR}/src/core/inet_chksum.c
     ${LWIP_DIR}/src/core/ip.c
+    ${LWIP_DIR}/src/core/ip_fwcache.c
+    ${LWIP_DIR}/src/core/ip_reass_tree.c
     ${LWIP_DIR}/src/core/mem.c
     ${LWIP_DIR}/src/core/memp.c
     ${LWIP_DIR}/src/core/netif.c
@@ -64,6 +66,9 @@ set(lwipcore4_SRCS
     ${LWIP_DIR}/src/core/ipv4/etharp.c
     ${LWIP_DIR}/src/core/ipv4/icmp.c
     ${LWIP_DIR}/src/core/ipv4/igmp.c
+    ${LWIP_DIR}/src/core/ipv4/ip4_fib.c
+    ${LWIP_DIR}/src/core/ipv4/ip4_pmtu.c
+    ${LWIP_DIR}/src/core/ipv4/ip4_mroute.c
     ${LWIP_DIR}/src/core/ipv4/ip4_frag.c
     ${LWIP_DIR}/src/core/ipv4/ip4.c
     ${LWIP_DIR}/src/core/ipv4/ip4_addr.c
@@ -75,6 +80,7 @@ set(lwipcore6_SRCS
     ${LWIP_DIR}/src/core/ipv6/inet6.c
     ${LWIP_DIR}/src/core/ipv6/ip6.c
     ${LWIP_DIR}/src/core/ipv6/ip6_addr.c
+    ${LWIP_DIR}/src/core/ipv6/ip6_fib.c
     ${LWIP_DIR}/src/core/ipv6/ip6_frag.c
     ${LWIP_DIR}/src/core/ipv6/mld6.c
     ${LWIP_DIR}/src/core/ipv6/nd6.c
@@ -221,6 +227,11 @@ set(lwipmqtt_SRCS
     ${LWIP_DIR}/src/apps/mqtt/mqtt.c
 )
 
+# pcapng packet capture files
+set(lwippcapng_SRCS
+    ${LWIP_DIR}/src/apps/pcapng/pcapng.c
+)
+
 # ARM MBEDTLS related files of lwIP rep
 set(lwipmbedtls_SRCS
     ${LWIP_DIR}/src/apps/altcp_tls/altcp_tls_mbedtls.c
@@ -250,6 +261,7 @@ set(lwipallapps_SRCS
     ${lwipnetbios_SRCS}
     ${lwiptftp_SRCS}
     ${lwipmqtt_SRCS}
+    ${lwippcapng_SRCS}
 )
 
 # Generate lwip/init.h (version info)
@@ -35,6 +35,8 @@ COREFILES=$(LWIPDIR)/core/init.c \
 	$(LWIPDIR)/core/dns.c \
 	$(LWIPDIR)/core/inet_chksum.c \
 	$(LWIPDIR)/core/ip.c \
+	$(LWIPDIR)/core/ip_fwcache.c \
+	$(LWIPDIR)/core/ip_reass_tree.c \
 	$(LWIPDIR)/core/mem.c \
 	$(LWIPDIR)/core/memp.c \
 	$(LWIPDIR)/core/netif.c \
@@ -57,6 +59,9 @@ CORE4FILES=$(LWIPDIR)/core/ipv4/acd.c \
 	$(LWIPDIR)/core/ipv4/etharp.c \
 	$(LWIPDIR)/core/ipv4/icmp.c \
 	$(LWIPDIR)/core/ipv4/igmp.c \
+	$(LWIPDIR)/core/ipv4/ip4_fib.c \
+	$(LWIPDIR)/core/ipv4/ip4_pmtu.c \
+	$(LWIPDIR)/core/ipv4/ip4_mroute.c \
 	$(LWIPDIR)/core/ipv4/ip4_frag.c \
 	$(LWIPDIR)/core/ipv4/ip4.c \
 	$(LWIPDIR)/core/ipv4/ip4_addr.c
@@ -67,6 +72,7 @@ CORE6FILES=$(LWIPDIR)/core/ipv6/dhcp6.c \
 	$(LWIPDIR)/core/ipv6/inet6.c \
 	$(LWIPDIR)/core/ipv6/ip6.c \
 	$(LWIPDIR)/core/ipv6/ip6_addr.c \
+	$(LWIPDIR)/core/ipv6/ip6_fib.c \
 	$(LWIPDIR)/core/ipv6/ip6_frag.c \
 	$(LWIPDIR)/core/ipv6/mld6.c \
 	$(LWIPDIR)/core/ipv6/nd6.c
@@ -190,6 +196,9 @@ TFTPFILES=$(LWIPDIR)/apps/tftp/tftp.c
 # MQTTFILES: MQTT client files
 MQTTFILES=$(LWIPDIR)/apps/mqtt/mqtt.c
 
+# PCAPNGFILES: pcapng packet capture files
+PCAPNGFILES=$(LWIPDIR)/apps/pcapng/pcapng.c
+
 # MBEDTLS_FILES: MBEDTLS related files of lwIP rep
 MBEDTLS_FILES=$(LWIPDIR)/apps/altcp_tls/altcp_tls_mbedtls.c \
 	$(LWIPDIR)/apps/altcp_tls/altcp_tls_mbedtls_mem.c \
@@ -205,4 +214,5 @@ LWIPAPPFILES=$(SNMPFILES) \
 	$(NETBIOSNSFILES) \
 	$(TFTPFILES) \
 	$(MQTTFILES) \
+	$(PCAPNGFILES) \
 	$(MBEDTLS_FILES)
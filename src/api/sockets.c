@@ -3167,8 +3167,29 @@ lwip_getsockopt_impl(int s, int level, int optname, void *optval, socklen_t *opt
 #if LWIP_TCP
     /* Level: IPPROTO_TCP */
     case IPPROTO_TCP:
-      /* Special case: all IPPROTO_TCP option take an int */
+#if LWIP_TCP_INFO
+      if (optname == TCP_INFO) {
+        LWIP_SOCKOPT_CHECK_OPTLEN_CONN_PCB_TYPE(sock, *optlen, struct tcp_pcb_info, NETCONN_TCP);
+        if ((sock->conn->pcb.tcp->state == LISTEN) ||
+            (tcp_get_info(sock->conn->pcb.tcp, (struct tcp_pcb_info *)optval) != ERR_OK)) {
+          done_socket(sock);
+          return EINVAL;
+        }
+        *optlen = sizeof(struct tcp_pcb_info);
+        LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_getsockopt(%d, IPPROTO_TCP, TCP_INFO)\n", s));
+        break;
+      }
+#endif /* LWIP_TCP_INFO */
+      /* Special case: all other IPPROTO_TCP option take an int */
       LWIP_SOCKOPT_CHECK_OPTLEN_CONN_PCB_TYPE(sock, *optlen, int, NETCONN_TCP);
+#if LWIP_TCP_FASTOPEN
+      if (optname == TCP_FASTOPEN) {
+        *(int *)optval = tcp_fastopen_enabled(sock->conn->pcb.tcp);
+        LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_getsockopt(%d, IPPROTO_TCP, TCP_FASTOPEN) = %d\n",
+                                    s, *(int *)optval));
+        break;
+      }
+#endif /* LWIP_TCP_FASTOPEN */
       if (sock->conn->pcb.tcp->state == LISTEN) {
         done_socket(sock);
         return EINVAL;
@@ -3643,6 +3664,15 @@ lwip_setsockopt_impl(int s, int level, int optname, const void *optval, socklen_
     case IPPROTO_TCP:
       /* Special case: all IPPROTO_TCP option take an int */
       LWIP_SOCKOPT_CHECK_OPTLEN_CONN_PCB_TYPE(sock, optlen, int, NETCONN_TCP);
+#if LWIP_TCP_FASTOPEN
+      if (optname == TCP_FASTOPEN) {
+        /* server side only (like Linux), valid before and after listen() */
+        tcp_fastopen(sock->conn->pcb.tcp, (u8_t)(*(const int *)optval != 0));
+        LWIP_DEBUGF(SOCKETS_DEBUG, ("lwip_setsockopt(%d, IPPROTO_TCP, TCP_FASTOPEN) -> %d\n",
+                                    s, *(const int *)optval));
+        break;
+      }
+#endif /* LWIP_TCP_FASTOPEN */
       if (sock->conn->pcb.tcp->state == LISTEN) {
         done_socket(sock);
         return EINVAL;
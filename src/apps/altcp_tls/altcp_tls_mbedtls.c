@@ -49,6 +49,10 @@
  *
  * Missing things / @todo:
  * - some unhandled/untested things might be caught by LWIP_ASSERTs...
+ * - RX data is copied twice (into the mbedTLS input buffer by the bio receive
+ *   callback, then decrypted into a pbuf by mbedtls_ssl_read()) and TX data is
+ *   copied into TCP: the public mbedTLS API does not allow decrypting in place
+ *   or keeping the output buffer until TCP has sent it.
  */
 
 #include "lwip/opt.h"
@@ -116,6 +120,7 @@ struct altcp_tls_config {
 #if defined(MBEDTLS_SSL_SESSION_TICKETS) && ALTCP_MBEDTLS_USE_SESSION_TICKETS
   mbedtls_ssl_ticket_context ticket_ctx;
 #endif
+  struct altcp_tls_stats stats;
 };
 
 /** Entropy and random generator are shared by all mbedTLS configuration */
@@ -298,6 +303,7 @@ altcp_mbedtls_lower_recv_process(struct altcp_pcb *conn, altcp_mbedtls_state_t *
     }
     if (ret != 0) {
       LWIP_DEBUGF(ALTCP_MBEDTLS_DEBUG, ("mbedtls_ssl_handshake failed: %d\n", ret));
+      ((struct altcp_tls_config *)state->conf)->stats.handshakes_failed++;
       /* handshake failed, connection has to be closed */
       if (conn->err) {
         conn->err(conn->arg, ERR_CLSD);
@@ -312,6 +318,7 @@ altcp_mbedtls_lower_recv_process(struct altcp_pcb *conn, altcp_mbedtls_state_t *
     LWIP_ASSERT("state", state->bio_bytes_read == 0);
     LWIP_ASSERT("state", state->bio_bytes_appl == 0);
     state->flags |= ALTCP_MBEDTLS_FLAGS_HANDSHAKE_DONE;
+    ((struct altcp_tls_config *)state->conf)->stats.handshakes++;
     /* issue "connect" callback" to upper connection (this can only happen for active open) */
     if (conn->connected) {
       err_t err;
@@ -392,8 +399,12 @@ altcp_mbedtls_handle_rx_appldata(struct altcp_pcb *conn, altcp_mbedtls_state_t *
     /* allocate a full-sized unchained PBUF_POOL: this is for RX! */
     struct pbuf *buf = pbuf_alloc(PBUF_RAW, PBUF_POOL_BUFSIZE, PBUF_POOL);
     if (buf == NULL) {
-      /* We're short on pbufs, try again later from 'poll' or 'recv' callbacks.
+      /* We're short on pbufs, pass on what has been decrypted already and try
+         again later from 'poll' or 'recv' callbacks.
          @todo: close on excessive allocation failures or leave this up to upper conn? */
+      if (altcp_mbedtls_pass_rx_data(conn, state) == ERR_ABRT) {
+        return ERR_ABRT;
+      }
       return ERR_OK;
     }
 
@@ -444,6 +455,11 @@ altcp_mbedtls_handle_rx_appldata(struct altcp_pcb *conn, altcp_mbedtls_state_t *
         } else {
           pbuf_cat(state->rx_app, buf);
         }
+        if (mbedtls_ssl_get_bytes_avail(&state->ssl_context) != 0) {
+          /* the rest of this record is decrypted already: collect it to pass
+             the whole record to the application in one call */
+          continue;
+        }
       } else {
         pbuf_free(buf);
         buf = NULL;
@@ -464,6 +480,8 @@ altcp_mbedtls_handle_rx_appldata(struct altcp_pcb *conn, altcp_mbedtls_state_t *
 
 /** Receive callback function called from mbedtls (set via mbedtls_ssl_set_bio)
  * This function mainly copies data from pbufs and frees the pbufs after copying.
+ * As much as requested is copied from the whole chain, so mbedTLS gets a
+ * record body with one call.
  */
 static int
 altcp_mbedtls_bio_recv(void *ctx, unsigned char *buf, size_t len)
@@ -473,9 +491,7 @@ altcp_mbedtls_bio_recv(void *ctx, unsigned char *buf, size_t len)
   struct pbuf *p;
   u16_t ret;
   u16_t copy_len;
-  err_t err;
 
-  LWIP_UNUSED_ARG(err); /* for LWIP_NOASSERT */
   if ((conn == NULL) || (conn->state == NULL)) {
     return MBEDTLS_ERR_NET_INVALID_CONTEXT;
   }
@@ -497,20 +513,12 @@ altcp_mbedtls_bio_recv(void *ctx, unsigned char *buf, size_t len)
     }
     return MBEDTLS_ERR_SSL_WANT_READ;
   }
-  /* limit number of bytes again to copy from first pbuf in a chain only */
-  copy_len = (u16_t)LWIP_MIN(len, p->len);
+  copy_len = (u16_t)LWIP_MIN(len, p->tot_len);
   /* copy the data */
   ret = pbuf_copy_partial(p, buf, copy_len, 0);
   LWIP_ASSERT("ret == copy_len", ret == copy_len);
-  /* hide the copied bytes from the pbuf */
-  err = pbuf_remove_header(p, ret);
-  LWIP_ASSERT("error", err == ERR_OK);
-  if (p->len == 0) {
-    /* the first pbuf has been fully read, free it */
-    state->rx = p->next;
-    p->next = NULL;
-    pbuf_free(p);
-  }
+  /* hide the copied bytes, freeing the pbufs that have been fully read */
+  state->rx = pbuf_free_header(p, ret);
 
   state->bio_bytes_read += (int)ret;
   return ret;
@@ -845,30 +853,64 @@ altcp_tls_create_config(int is_server, u8_t cert_count, u8_t pkey_count, int hav
   mbedtls_ssl_conf_dbg(&conf->conf, altcp_mbedtls_debug, stdout);
 #endif
 #if defined(MBEDTLS_SSL_CACHE_C) && ALTCP_MBEDTLS_USE_SESSION_CACHE
-  mbedtls_ssl_conf_session_cache(&conf->conf, &conf->cache, mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
-  mbedtls_ssl_cache_set_timeout(&conf->cache, ALTCP_MBEDTLS_SESSION_CACHE_TIMEOUT_SECONDS);
-  mbedtls_ssl_cache_set_max_entries(&conf->cache, ALTCP_MBEDTLS_SESSION_CACHE_SIZE);
+  mbedtls_ssl_cache_init(&conf->cache);
 #endif
-
 #if defined(MBEDTLS_SSL_SESSION_TICKETS) && ALTCP_MBEDTLS_USE_SESSION_TICKETS
   mbedtls_ssl_ticket_init(&conf->ticket_ctx);
+#endif
 
-  ret = mbedtls_ssl_ticket_setup(&conf->ticket_ctx, mbedtls_ctr_drbg_random, &altcp_tls_entropy_rng->ctr_drbg,
-    ALTCP_MBEDTLS_SESSION_TICKET_CIPHER, ALTCP_MBEDTLS_SESSION_TICKET_TIMEOUT_SECONDS);
-  if (ret) {
-    LWIP_DEBUGF(ALTCP_MBEDTLS_DEBUG, ("mbedtls_ssl_ticket_setup failed: %d\n", ret));
-    altcp_mbedtls_unref_entropy();
-    altcp_mbedtls_free_config(conf);
-    return NULL;
+  return conf;
+}
+
+#if defined(MBEDTLS_SSL_CACHE_C) && ALTCP_MBEDTLS_USE_SESSION_CACHE
+/** Session cache lookup: a hit means an abbreviated handshake */
+static int
+altcp_mbedtls_cache_get(void *data, mbedtls_ssl_session *session)
+{
+  struct altcp_tls_config *conf = (struct altcp_tls_config *)data;
+  int ret = mbedtls_ssl_cache_get(&conf->cache, session);
+  if (ret == 0) {
+    conf->stats.resumed_cache++;
   }
+  return ret;
+}
 
-  mbedtls_ssl_conf_session_tickets_cb(&conf->conf, mbedtls_ssl_ticket_write, mbedtls_ssl_ticket_parse,
-    &conf->ticket_ctx);
-#endif
+static int
+altcp_mbedtls_cache_set(void *data, const mbedtls_ssl_session *session)
+{
+  struct altcp_tls_config *conf = (struct altcp_tls_config *)data;
+  return mbedtls_ssl_cache_set(&conf->cache, session);
+}
+#endif /* MBEDTLS_SSL_CACHE_C && ALTCP_MBEDTLS_USE_SESSION_CACHE */
 
-  return conf;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && ALTCP_MBEDTLS_USE_SESSION_TICKETS
+static int
+altcp_mbedtls_ticket_write(void *p_ticket, const mbedtls_ssl_session *session,
+                           unsigned char *start, const unsigned char *end,
+                           size_t *tlen, uint32_t *lifetime)
+{
+  struct altcp_tls_config *conf = (struct altcp_tls_config *)p_ticket;
+  int ret = mbedtls_ssl_ticket_write(&conf->ticket_ctx, session, start, end, tlen, lifetime);
+  if (ret == 0) {
+    conf->stats.tickets_issued++;
+  }
+  return ret;
 }
 
+/** Session ticket parsing: success means an abbreviated handshake */
+static int
+altcp_mbedtls_ticket_parse(void *p_ticket, mbedtls_ssl_session *session,
+                           unsigned char *buf, size_t len)
+{
+  struct altcp_tls_config *conf = (struct altcp_tls_config *)p_ticket;
+  int ret = mbedtls_ssl_ticket_parse(&conf->ticket_ctx, session, buf, len);
+  if (ret == 0) {
+    conf->stats.resumed_ticket++;
+  }
+  return ret;
+}
+#endif /* MBEDTLS_SSL_SESSION_TICKETS && ALTCP_MBEDTLS_USE_SESSION_TICKETS */
+
 struct altcp_tls_config *altcp_tls_create_config_server(u8_t cert_count)
 {
   struct altcp_tls_config *conf = altcp_tls_create_config(1, cert_count, cert_count, 0);
@@ -877,9 +919,78 @@ struct altcp_tls_config *altcp_tls_create_config_server(u8_t cert_count)
   }
 
   mbedtls_ssl_conf_ca_chain(&conf->conf, NULL, NULL);
+
+#if defined(MBEDTLS_SSL_CACHE_C) && ALTCP_MBEDTLS_USE_SESSION_CACHE
+  altcp_tls_config_server_session_cache(conf, ALTCP_MBEDTLS_SESSION_CACHE_SIZE,
+    ALTCP_MBEDTLS_SESSION_CACHE_TIMEOUT_SECONDS);
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && ALTCP_MBEDTLS_USE_SESSION_TICKETS
+  if (altcp_tls_config_server_session_tickets(conf, ALTCP_MBEDTLS_SESSION_TICKET_TIMEOUT_SECONDS) != ERR_OK) {
+    altcp_tls_free_config(conf);
+    return NULL;
+  }
+#endif
   return conf;
 }
 
+err_t
+altcp_tls_config_server_session_cache(struct altcp_tls_config *config, int max_entries, u32_t timeout_seconds)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("altcp_tls_config_server_session_cache: invalid config", config != NULL, return ERR_ARG;);
+#if defined(MBEDTLS_SSL_CACHE_C) && ALTCP_MBEDTLS_USE_SESSION_CACHE
+  if (max_entries > 0) {
+    mbedtls_ssl_cache_set_timeout(&config->cache, (int)timeout_seconds);
+    mbedtls_ssl_cache_set_max_entries(&config->cache, max_entries);
+    mbedtls_ssl_conf_session_cache(&config->conf, config, altcp_mbedtls_cache_get, altcp_mbedtls_cache_set);
+  } else {
+    mbedtls_ssl_conf_session_cache(&config->conf, NULL, NULL, NULL);
+  }
+  return ERR_OK;
+#else
+  LWIP_UNUSED_ARG(max_entries);
+  LWIP_UNUSED_ARG(timeout_seconds);
+  return ERR_VAL;
+#endif
+}
+
+err_t
+altcp_tls_config_server_session_tickets(struct altcp_tls_config *config, u32_t lifetime_seconds)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("altcp_tls_config_server_session_tickets: invalid config", config != NULL, return ERR_ARG;);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && ALTCP_MBEDTLS_USE_SESSION_TICKETS
+  /* start over with new keys (tickets issued before cannot be used any more) */
+  mbedtls_ssl_conf_session_tickets_cb(&config->conf, NULL, NULL, NULL);
+  mbedtls_ssl_ticket_free(&config->ticket_ctx);
+  mbedtls_ssl_ticket_init(&config->ticket_ctx);
+  if (lifetime_seconds != 0) {
+    /* mbedTLS rotates the ticket key every 'lifetime_seconds' and accepts
+       tickets encrypted with the previous key */
+    int ret = mbedtls_ssl_ticket_setup(&config->ticket_ctx, mbedtls_ctr_drbg_random, &altcp_tls_entropy_rng->ctr_drbg,
+      ALTCP_MBEDTLS_SESSION_TICKET_CIPHER, lifetime_seconds);
+    if (ret) {
+      LWIP_DEBUGF(ALTCP_MBEDTLS_DEBUG, ("mbedtls_ssl_ticket_setup failed: %d\n", ret));
+      return ERR_VAL;
+    }
+    mbedtls_ssl_conf_session_tickets_cb(&config->conf, altcp_mbedtls_ticket_write, altcp_mbedtls_ticket_parse,
+      config);
+  }
+  return ERR_OK;
+#else
+  LWIP_UNUSED_ARG(lifetime_seconds);
+  return ERR_VAL;
+#endif
+}
+
+void
+altcp_tls_config_get_stats(struct altcp_tls_config *config, struct altcp_tls_stats *stats)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("altcp_tls_config_get_stats: invalid arguments", (config != NULL) && (stats != NULL), return;);
+  *stats = config->stats;
+}
+
 err_t altcp_tls_config_server_add_privkey_cert(struct altcp_tls_config *config,
       const u8_t *privkey, size_t privkey_len,
       const u8_t *privkey_pass, size_t privkey_pass_len,
@@ -1056,6 +1167,12 @@ altcp_tls_free_config(struct altcp_tls_config *conf)
   if (conf->ca) {
     mbedtls_x509_crt_free(conf->ca);
   }
+#if defined(MBEDTLS_SSL_CACHE_C) && ALTCP_MBEDTLS_USE_SESSION_CACHE
+  mbedtls_ssl_cache_free(&conf->cache);
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && ALTCP_MBEDTLS_USE_SESSION_TICKETS
+  mbedtls_ssl_ticket_free(&conf->ticket_ctx);
+#endif
   mbedtls_ssl_config_free(&conf->conf);
   altcp_mbedtls_free_config(conf);
   altcp_mbedtls_unref_entropy();
@@ -1174,6 +1291,16 @@ altcp_mbedtls_close(struct altcp_pcb *conn)
   return ERR_OK;
 }
 
+#if ALTCP_MBEDTLS_RECORD_SIZE_SMALL
+/** Record size policy: small records at connection start and after being idle */
+static u8_t
+altcp_mbedtls_small_records(altcp_mbedtls_state_t *state)
+{
+  return ((u32_t)(sys_now() - state->record_last_write) > ALTCP_MBEDTLS_RECORD_SIZE_IDLE_MS) ||
+         (state->record_bytes_sent < ALTCP_MBEDTLS_RECORD_SIZE_SMALL_BYTES);
+}
+#endif /* ALTCP_MBEDTLS_RECORD_SIZE_SMALL */
+
 /** Allow caller of altcp_write() to limit to negotiated chunk size
  *  or remaining sndbuf space of inner_conn.
  */
@@ -1200,6 +1327,12 @@ altcp_mbedtls_sndbuf(struct altcp_pcb *conn)
           /* @todo: adjust ssl_added to real value related to negotiated cipher */
           size_t max_frag_len = mbedtls_ssl_get_max_frag_len(&state->ssl_context);
           max_len = LWIP_MIN(max_frag_len, max_len);
+#endif
+#if ALTCP_MBEDTLS_RECORD_SIZE_SMALL
+          if (altcp_mbedtls_small_records(state)) {
+            /* one altcp_write() is one record */
+            max_len = LWIP_MIN(ALTCP_MBEDTLS_RECORD_SIZE_SMALL, max_len);
+          }
 #endif
           /* Adjust sndbuf of inner_conn with what added by SSL */
           ret = LWIP_MIN(sndbuf - ssl_added, max_len);
@@ -1254,6 +1387,16 @@ altcp_mbedtls_write(struct altcp_pcb *conn, const void *dataptr, u16_t len, u8_t
     if (ret == len) {
       /* update application sent counter */
       state->overhead_bytes_adjust -= ret;
+#if ALTCP_MBEDTLS_RECORD_SIZE_SMALL
+      if ((u32_t)(sys_now() - state->record_last_write) > ALTCP_MBEDTLS_RECORD_SIZE_IDLE_MS) {
+        /* the congestion window may have collapsed while idle: start small again */
+        state->record_bytes_sent = 0;
+      }
+      if (state->record_bytes_sent < ALTCP_MBEDTLS_RECORD_SIZE_SMALL_BYTES) {
+        state->record_bytes_sent += (u32_t)ret;
+      }
+      state->record_last_write = sys_now();
+#endif
       return ERR_OK;
     } else {
       /* @todo/@fixme: assumption: either everything sent or error */
@@ -1370,6 +1513,9 @@ const struct altcp_functions altcp_mbedtls_functions = {
 #ifdef LWIP_DEBUG
   , altcp_default_dbg_get_tcp_state
 #endif
+#if LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP
+  , altcp_default_write_chksum
+#endif
 };
 
 #endif /* LWIP_ALTCP_TLS && LWIP_ALTCP_TLS_MBEDTLS */
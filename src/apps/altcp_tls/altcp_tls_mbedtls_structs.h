@@ -72,6 +72,11 @@ typedef struct altcp_mbedtls_state_s {
   int bio_bytes_read;
   int bio_bytes_appl;
   int overhead_bytes_adjust;
+#if ALTCP_MBEDTLS_RECORD_SIZE_SMALL
+  /* record size policy: application bytes sent since connection start or idle */
+  u32_t record_bytes_sent;
+  u32_t record_last_write;
+#endif
 } altcp_mbedtls_state_t;
 
 #ifdef __cplusplus
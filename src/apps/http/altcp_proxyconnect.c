@@ -583,6 +583,9 @@ const struct altcp_functions altcp_proxyconnect_functions = {
 #ifdef LWIP_DEBUG
   , altcp_default_dbg_get_tcp_state
 #endif
+#if LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP
+  , altcp_default_write_chksum
+#endif
 };
 
 #endif /* LWIP_ALTCP */
@@ -38,6 +38,43 @@
 
 #include HTTPD_FSDATA_FILE
 
+/*-----------------------------------------------------------------------------------*/
+/** Find a file of the compiled-in file system by name.
+ * Files generated by makefsdata come with an array sorted by name
+ * (FS_SORTED_FILES) which is binary searched, older fsdata files only provide
+ * the linked list starting at FS_ROOT.
+ */
+static const struct fsdata_file *
+fs_find_file(const char *name)
+{
+#ifdef FS_SORTED_FILES
+  int lo = 0;
+  int hi = FS_NUMFILES - 1;
+
+  while (lo <= hi) {
+    int mid = lo + (hi - lo) / 2;
+    const struct fsdata_file *f = FS_SORTED_FILES[mid];
+    int cmp = strcmp(name, (const char *)f->name);
+    if (cmp == 0) {
+      return f;
+    } else if (cmp < 0) {
+      hi = mid - 1;
+    } else {
+      lo = mid + 1;
+    }
+  }
+#else /* FS_SORTED_FILES */
+  const struct fsdata_file *f;
+
+  for (f = FS_ROOT; f != NULL; f = f->next) {
+    if (!strcmp(name, (const char *)f->name)) {
+      return f;
+    }
+  }
+#endif /* FS_SORTED_FILES */
+  return NULL;
+}
+
 /*-----------------------------------------------------------------------------------*/
 err_t
 fs_open(struct fs_file *file, const char *name)
@@ -48,6 +85,9 @@ fs_open(struct fs_file *file, const char *name)
     return ERR_ARG;
   }
 
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+  file->validators = NULL;
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
 #if LWIP_HTTPD_CUSTOM_FILES
   if (fs_open_custom(file, name)) {
     file->flags |= FS_FILE_FLAGS_CUSTOM;
@@ -55,29 +95,65 @@ fs_open(struct fs_file *file, const char *name)
   }
 #endif /* LWIP_HTTPD_CUSTOM_FILES */
 
-  for (f = FS_ROOT; f != NULL; f = f->next) {
-    if (!strcmp(name, (const char *)f->name)) {
-      file->data = (const char *)f->data;
-      file->len = f->len;
-      file->index = f->len;
-      file->flags = f->flags;
+  f = fs_find_file(name);
+  if (f != NULL) {
+    file->data = (const char *)f->data;
+    file->len = f->len;
+    file->index = f->len;
+    file->flags = f->flags;
 #if HTTPD_PRECALCULATED_CHECKSUM
-      file->chksum_count = f->chksum_count;
-      file->chksum = f->chksum;
+    file->chksum_count = f->chksum_count;
+    file->chksum = f->chksum;
 #endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+    file->validators = f->validators;
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
 #if LWIP_HTTPD_FILE_EXTENSION
-      file->pextension = NULL;
+    file->pextension = NULL;
 #endif /* LWIP_HTTPD_FILE_EXTENSION */
 #if LWIP_HTTPD_FILE_STATE
-      file->state = fs_state_init(file, name);
+    file->state = fs_state_init(file, name);
 #endif /* #if LWIP_HTTPD_FILE_STATE */
-      return ERR_OK;
-    }
+    return ERR_OK;
   }
   /* file not found */
   return ERR_VAL;
 }
 
+/*-----------------------------------------------------------------------------------*/
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+/** Get the validators of a file without opening it, so that httpd can answer
+ * a conditional request with "304 Not Modified" before calling fs_open().
+ * Only the compiled-in file system is searched: with LWIP_HTTPD_CUSTOM_FILES,
+ * fs_open_custom() may replace any file, so NULL is returned and httpd checks
+ * the validators after opening the file instead.
+ *
+ * @param name the file name
+ * @param flags returns the FS_FILE_FLAGS_* of the file
+ * @return the validators of the file (see struct fs_file) or NULL
+ */
+const char *
+fs_get_validators(const char *name, u8_t *flags)
+{
+#if LWIP_HTTPD_CUSTOM_FILES
+  LWIP_UNUSED_ARG(name);
+  LWIP_UNUSED_ARG(flags);
+#else /* LWIP_HTTPD_CUSTOM_FILES */
+  const struct fsdata_file *f;
+
+  if ((name == NULL) || (flags == NULL)) {
+    return NULL;
+  }
+  f = fs_find_file(name);
+  if (f != NULL) {
+    *flags = f->flags;
+    return f->validators;
+  }
+#endif /* LWIP_HTTPD_CUSTOM_FILES */
+  return NULL;
+}
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+
 /*-----------------------------------------------------------------------------------*/
 void
 fs_close(struct fs_file *file)
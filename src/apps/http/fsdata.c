@@ -314,6 +314,12 @@ data__img_sics_gif,
 data__img_sics_gif + 16,
 sizeof(data__img_sics_gif) - 16,
 FS_FILE_FLAGS_HEADER_INCLUDED | FS_FILE_FLAGS_HEADER_PERSISTENT,
+#if HTTPD_PRECALCULATED_CHECKSUM
+0, NULL,
+#endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+NULL,
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
 }};
 
 const struct fsdata_file file__404_html[] = { {
@@ -322,6 +328,12 @@ data__404_html,
 data__404_html + 12,
 sizeof(data__404_html) - 12,
 FS_FILE_FLAGS_HEADER_INCLUDED | FS_FILE_FLAGS_HEADER_PERSISTENT,
+#if HTTPD_PRECALCULATED_CHECKSUM
+0, NULL,
+#endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+NULL,
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
 }};
 
 const struct fsdata_file file__index_html[] = { {
@@ -330,7 +342,22 @@ data__index_html,
 data__index_html + 12,
 sizeof(data__index_html) - 12,
 FS_FILE_FLAGS_HEADER_INCLUDED | FS_FILE_FLAGS_HEADER_PERSISTENT,
+#if HTTPD_PRECALCULATED_CHECKSUM
+0, NULL,
+#endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+NULL,
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
 }};
 
 #define FS_ROOT file__index_html
 #define FS_NUMFILES 3
+
+/* all files sorted by name for binary search in fs_open() */
+const struct fsdata_file *const fsdata_sorted_files[] = {
+file__404_html,
+file__img_sics_gif,
+file__index_html,
+};
+
+#define FS_SORTED_FILES fsdata_sorted_files
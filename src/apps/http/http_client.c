@@ -38,7 +38,7 @@
  * @defgroup httpc HTTP client
  * @ingroup apps
  * @todo:
- * - persistent connections
+ * - pipelining requests on persistent connections
  * - select outgoing http version
  * - optionally follow redirect
  * - check request uri for invalid characters? (e.g. encode spaces)
@@ -89,11 +89,20 @@
 
 #define HTTPC_CONTENT_LEN_INVALID 0xFFFFFFFF
 
+#if LWIP_HTTPC_KEEPALIVE
+/* HTTP/1.1 connections are persistent by default, but some proxies need this */
+#define HTTPC_REQ_CONNECTION "Connection: keep-alive\r\n"
+/* idle timeout in poll intervals (the tcp poll timer runs every 500 ms) */
+#define HTTPC_KEEPALIVE_IDLE_TICKS (LWIP_HTTPC_KEEPALIVE_IDLE_TIMEOUT * 2 / HTTPC_POLL_INTERVAL)
+#else
+#define HTTPC_REQ_CONNECTION "Connection: Close\r\n" /* persistent connections are disabled */
+#endif
+
 /* GET request basic */
 #define HTTPC_REQ_11 "GET %s HTTP/1.1\r\n" /* URI */\
     "User-Agent: %s\r\n" /* User-Agent */ \
     "Accept: */*\r\n" \
-    "Connection: Close\r\n" /* we don't support persistent connections, yet */ \
+    HTTPC_REQ_CONNECTION \
     "\r\n"
 #define HTTPC_REQ_11_FORMAT(uri) HTTPC_REQ_11, uri, HTTPC_CLIENT_AGENT
 
@@ -102,7 +111,7 @@
     "User-Agent: %s\r\n" /* User-Agent */ \
     "Accept: */*\r\n" \
     "Host: %s\r\n" /* server name */ \
-    "Connection: Close\r\n" /* we don't support persistent connections, yet */ \
+    HTTPC_REQ_CONNECTION \
     "\r\n"
 #define HTTPC_REQ_11_HOST_FORMAT(uri, srv_name) HTTPC_REQ_11_HOST, uri, HTTPC_CLIENT_AGENT, srv_name
 
@@ -111,7 +120,7 @@
     "User-Agent: %s\r\n" /* User-Agent */ \
     "Accept: */*\r\n" \
     "Host: %s\r\n" /* server name */ \
-    "Connection: Close\r\n" /* we don't support persistent connections, yet */ \
+    HTTPC_REQ_CONNECTION \
     "\r\n"
 #define HTTPC_REQ_11_PROXY_FORMAT(host, uri, srv_name) HTTPC_REQ_11_PROXY, host, uri, HTTPC_CLIENT_AGENT, srv_name
 
@@ -120,7 +129,7 @@
     "User-Agent: %s\r\n" /* User-Agent */ \
     "Accept: */*\r\n" \
     "Host: %s\r\n" /* server name */ \
-    "Connection: Close\r\n" /* we don't support persistent connections, yet */ \
+    HTTPC_REQ_CONNECTION \
     "\r\n"
 #define HTTPC_REQ_11_PROXY_PORT_FORMAT(host, host_port, uri, srv_name) HTTPC_REQ_11_PROXY_PORT, host, host_port, uri, HTTPC_CLIENT_AGENT, srv_name
 
@@ -130,6 +139,18 @@ typedef enum ehttpc_parse_state {
   HTTPC_PARSE_RX_DATA
 } httpc_parse_state_t;
 
+/* states for decoding "Transfer-Encoding: chunked" */
+typedef enum ehttpc_chunk_state {
+  HTTPC_CHUNK_NONE = 0,   /* not chunked */
+  HTTPC_CHUNK_SIZE,       /* parsing the chunk size */
+  HTTPC_CHUNK_EXT,        /* skipping chunk extensions up to LF */
+  HTTPC_CHUNK_DATA,       /* passing chunk data to the application */
+  HTTPC_CHUNK_DATA_END,   /* expecting CRLF after the chunk data */
+  HTTPC_CHUNK_TRAILER,    /* at the start of a trailer line */
+  HTTPC_CHUNK_TRAILER_LINE, /* skipping a trailer line */
+  HTTPC_CHUNK_DONE        /* last chunk and trailers received */
+} httpc_chunk_state_t;
+
 typedef struct _httpc_state
 {
   struct altcp_pcb* pcb;
@@ -146,12 +167,50 @@ typedef struct _httpc_state
   u32_t rx_content_len;
   u32_t hdr_content_len;
   httpc_parse_state_t parse_state;
-#if HTTPC_DEBUG_REQUEST
+  httpc_chunk_state_t chunk_state;
+  u32_t chunk_left;
+  /* body data refused by recv_fn, passed again before the data following it */
+  struct pbuf *rx_refused;
+  struct pbuf *rx_pending;
+  /* the server has closed the connection while data was refused */
+  u8_t rx_closed;
+#if LWIP_HTTPC_KEEPALIVE
+  u16_t server_port;
+  /* the response allows to keep the connection open */
+  u8_t keepalive;
+  /* the connection has been taken from the pool of idle connections */
+  u8_t reused;
+#endif
+#if HTTPC_DEBUG_REQUEST || LWIP_HTTPC_KEEPALIVE
   char* server_name;
+#endif
+#if HTTPC_DEBUG_REQUEST
   char* uri;
 #endif
 } httpc_state_t;
 
+#if LWIP_HTTPC_KEEPALIVE
+/** An idle connection kept open for later requests */
+typedef struct _httpc_pool_entry
+{
+  struct altcp_pcb* pcb;
+  ip_addr_t remote_addr;
+  u16_t remote_port;
+  u16_t server_port;
+  u16_t idle_ticks;
+  u8_t use_proxy;
+#if LWIP_ALTCP
+  altcp_allocator_t allocator;
+#endif
+  char server_name[LWIP_HTTPC_KEEPALIVE_HOST_LEN];
+} httpc_pool_entry_t;
+
+static httpc_pool_entry_t httpc_pool[LWIP_HTTPC_KEEPALIVE_POOL_SIZE];
+
+static err_t httpc_tcp_connected(void *arg, struct altcp_pcb *pcb, err_t err);
+static void httpc_init_pcb(httpc_state_t* req);
+#endif /* LWIP_HTTPC_KEEPALIVE */
+
 /** Free http client state and deallocate all resources within */
 static err_t
 httpc_free_state(httpc_state_t* req)
@@ -166,6 +225,14 @@ httpc_free_state(httpc_state_t* req)
     pbuf_free(req->rx_hdrs);
     req->rx_hdrs = NULL;
   }
+  if (req->rx_refused != NULL) {
+    pbuf_free(req->rx_refused);
+    req->rx_refused = NULL;
+  }
+  if (req->rx_pending != NULL) {
+    pbuf_free(req->rx_pending);
+    req->rx_pending = NULL;
+  }
 
   tpcb = req->pcb;
   mem_free(req);
@@ -202,6 +269,175 @@ httpc_close(httpc_state_t* req, httpc_result_t result, u32_t server_response, er
   return ERR_OK;
 }
 
+#if LWIP_HTTPC_KEEPALIVE
+/** Close an idle connection and free its pool entry */
+static err_t
+httpc_pool_free(httpc_pool_entry_t *entry)
+{
+  struct altcp_pcb *pcb = entry->pcb;
+
+  entry->pcb = NULL;
+  if (pcb != NULL) {
+    altcp_arg(pcb, NULL);
+    altcp_recv(pcb, NULL);
+    altcp_err(pcb, NULL);
+    altcp_poll(pcb, NULL, 0);
+    altcp_sent(pcb, NULL);
+    if (altcp_close(pcb) != ERR_OK) {
+      altcp_abort(pcb);
+      return ERR_ABRT;
+    }
+  }
+  return ERR_OK;
+}
+
+/** Idle connection tcp recv callback: closed by the server or unexpected data */
+static err_t
+httpc_pool_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t r)
+{
+  httpc_pool_entry_t *entry = (httpc_pool_entry_t *)arg;
+  LWIP_UNUSED_ARG(r);
+
+  if (p != NULL) {
+    altcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+  }
+  LWIP_DEBUGF(HTTPC_DEBUG_STATE, ("httpc: closing idle connection to %s\n", entry->server_name));
+  return httpc_pool_free(entry);
+}
+
+/** Idle connection tcp err callback */
+static void
+httpc_pool_err(void *arg, err_t err)
+{
+  httpc_pool_entry_t *entry = (httpc_pool_entry_t *)arg;
+  LWIP_UNUSED_ARG(err);
+
+  /* pcb has already been deallocated */
+  entry->pcb = NULL;
+}
+
+/** Idle connection tcp poll callback: implement idle timeout */
+static err_t
+httpc_pool_poll(void *arg, struct altcp_pcb *pcb)
+{
+  httpc_pool_entry_t *entry = (httpc_pool_entry_t *)arg;
+  LWIP_UNUSED_ARG(pcb);
+
+  entry->idle_ticks++;
+  if (entry->idle_ticks >= HTTPC_KEEPALIVE_IDLE_TICKS) {
+    LWIP_DEBUGF(HTTPC_DEBUG_STATE, ("httpc: idle timeout for connection to %s\n", entry->server_name));
+    return httpc_pool_free(entry);
+  }
+  return ERR_OK;
+}
+
+/** Put the connection of a finished request into the pool of idle connections
+ *
+ * @return 1 if the connection has been taken over by the pool (req->pcb is NULL now)
+ */
+static u8_t
+httpc_pool_put(httpc_state_t *req)
+{
+  httpc_pool_entry_t *entry = NULL;
+  const httpc_connection_t *settings = req->conn_settings;
+  size_t server_name_len;
+  int i;
+
+  if ((req->pcb == NULL) || (settings == NULL)) {
+    return 0;
+  }
+  server_name_len = strlen(req->server_name);
+  if (server_name_len >= LWIP_HTTPC_KEEPALIVE_HOST_LEN) {
+    return 0;
+  }
+  for (i = 0; i < LWIP_HTTPC_KEEPALIVE_POOL_SIZE; i++) {
+    if (httpc_pool[i].pcb == NULL) {
+      entry = &httpc_pool[i];
+      break;
+    }
+  }
+  if (entry == NULL) {
+    /* pool is full: close the connection idle for the longest time */
+    entry = &httpc_pool[0];
+    for (i = 1; i < LWIP_HTTPC_KEEPALIVE_POOL_SIZE; i++) {
+      if (httpc_pool[i].idle_ticks > entry->idle_ticks) {
+        entry = &httpc_pool[i];
+      }
+    }
+    httpc_pool_free(entry);
+  }
+  entry->pcb = req->pcb;
+  entry->remote_addr = req->remote_addr;
+  entry->remote_port = req->remote_port;
+  entry->server_port = req->server_port;
+  entry->idle_ticks = 0;
+  entry->use_proxy = settings->use_proxy ? 1 : 0;
+#if LWIP_ALTCP
+  if (settings->altcp_allocator != NULL) {
+    entry->allocator = *settings->altcp_allocator;
+  } else {
+    memset(&entry->allocator, 0, sizeof(entry->allocator));
+  }
+#endif
+  memcpy(entry->server_name, req->server_name, server_name_len + 1);
+
+  altcp_arg(entry->pcb, entry);
+  altcp_recv(entry->pcb, httpc_pool_recv);
+  altcp_err(entry->pcb, httpc_pool_err);
+  altcp_poll(entry->pcb, httpc_pool_poll, HTTPC_POLL_INTERVAL);
+  altcp_sent(entry->pcb, NULL);
+  req->pcb = NULL;
+  LWIP_DEBUGF(HTTPC_DEBUG_STATE, ("httpc: keeping connection to %s open\n", entry->server_name));
+  return 1;
+}
+
+/** Take an idle connection matching a new request from the pool */
+static struct altcp_pcb *
+httpc_pool_get(httpc_state_t *req, const httpc_connection_t *settings)
+{
+  int i;
+
+  for (i = 0; i < LWIP_HTTPC_KEEPALIVE_POOL_SIZE; i++) {
+    httpc_pool_entry_t *entry = &httpc_pool[i];
+    if ((entry->pcb != NULL) &&
+        (entry->server_port == req->server_port) &&
+        (entry->remote_port == req->remote_port) &&
+        (entry->use_proxy == (settings->use_proxy ? 1 : 0)) &&
+        (!entry->use_proxy || ip_addr_eq(&entry->remote_addr, &settings->proxy_addr)) &&
+#if LWIP_ALTCP
+        ((settings->altcp_allocator != NULL) ?
+         ((entry->allocator.alloc == settings->altcp_allocator->alloc) &&
+          (entry->allocator.arg == settings->altcp_allocator->arg)) :
+         (entry->allocator.alloc == NULL)) &&
+#endif
+        !strcmp(entry->server_name, req->server_name)) {
+      struct altcp_pcb *pcb = entry->pcb;
+      req->remote_addr = entry->remote_addr;
+      entry->pcb = NULL;
+      LWIP_DEBUGF(HTTPC_DEBUG_STATE, ("httpc: reusing connection to %s\n", entry->server_name));
+      return pcb;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @ingroup httpc
+ * Close all idle connections kept open for later requests (e.g. when the
+ * network configuration changes).
+ */
+void
+httpc_keepalive_close_all(void)
+{
+  int i;
+
+  for (i = 0; i < LWIP_HTTPC_KEEPALIVE_POOL_SIZE; i++) {
+    httpc_pool_free(&httpc_pool[i]);
+  }
+}
+#endif /* LWIP_HTTPC_KEEPALIVE */
+
 /** Parse http header response line 1 */
 static err_t
 http_parse_response_status(struct pbuf *p, u16_t *http_version, u16_t *http_status, u16_t *http_status_str_offset)
@@ -281,6 +517,401 @@ http_wait_headers(struct pbuf *p, u32_t *content_length, u16_t *total_header_len
   return ERR_VAL;
 }
 
+/** Compare (case-insensitive) a string in a pbuf to a lower case string */
+static u8_t
+httpc_pbuf_imatch(const struct pbuf *p, u16_t offset, const char *str, u16_t str_len)
+{
+  u16_t i;
+  for (i = 0; i < str_len; i++) {
+    u8_t c = pbuf_get_at(p, (u16_t)(offset + i));
+    if ((c >= 'A') && (c <= 'Z')) {
+      c = (u8_t)(c + ('a' - 'A'));
+    }
+    if (c != (u8_t)str[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/** Check if a header (name in lower case, including CRLF in front and the colon)
+ * contains a token (in lower case) */
+static u8_t
+httpc_hdr_has_token(const struct pbuf *p, u16_t hdr_len, const char *name, const char *token)
+{
+  u16_t name_len = (u16_t)strlen(name);
+  u16_t token_len = (u16_t)strlen(token);
+  u16_t i, j;
+
+  for (i = 0; i + name_len <= hdr_len; i++) {
+    if ((pbuf_get_at(p, i) == '\r') && httpc_pbuf_imatch(p, i, name, name_len)) {
+      u16_t end = pbuf_memfind(p, "\r\n", 2, (u16_t)(i + name_len));
+      if (end > hdr_len) {
+        end = hdr_len;
+      }
+      for (j = (u16_t)(i + name_len); j + token_len <= end; j++) {
+        if (httpc_pbuf_imatch(p, j, token, token_len)) {
+          return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+/** Check how the end of the response body is detected */
+static void
+httpc_parse_body_framing(httpc_state_t *req, u16_t hdr_len)
+{
+  if (httpc_hdr_has_token(req->rx_hdrs, hdr_len, "\r\ntransfer-encoding:", "chunked")) {
+    /* chunked encoding overrides Content-Length */
+    req->chunk_state = HTTPC_CHUNK_SIZE;
+    req->chunk_left = 0;
+    req->hdr_content_len = HTTPC_CONTENT_LEN_INVALID;
+  } else if ((req->rx_status == 204) || (req->rx_status == 304)) {
+    /* these responses never have a body */
+    req->hdr_content_len = 0;
+  }
+#if LWIP_HTTPC_KEEPALIVE
+  /* keep the connection only if the end of the response is known */
+  req->keepalive = (req->rx_http_version >= 0x0101) &&
+    !httpc_hdr_has_token(req->rx_hdrs, hdr_len, "\r\nconnection:", "close") &&
+    ((req->chunk_state != HTTPC_CHUNK_NONE) || (req->hdr_content_len != HTTPC_CONTENT_LEN_INVALID));
+#endif /* LWIP_HTTPC_KEEPALIVE */
+}
+
+/** Parse one byte of the chunked encoding framing */
+static err_t
+httpc_chunk_parse(httpc_state_t *req, u8_t c)
+{
+  if ((req->chunk_state == HTTPC_CHUNK_SIZE) || (req->chunk_state == HTTPC_CHUNK_EXT)) {
+    if (req->chunk_state == HTTPC_CHUNK_SIZE) {
+      u8_t digit = 0xFF;
+      if ((c >= '0') && (c <= '9')) {
+        digit = (u8_t)(c - '0');
+      } else if ((c >= 'a') && (c <= 'f')) {
+        digit = (u8_t)(c - 'a' + 10);
+      } else if ((c >= 'A') && (c <= 'F')) {
+        digit = (u8_t)(c - 'A' + 10);
+      }
+      if (digit != 0xFF) {
+        if (req->chunk_left > 0x0FFFFFFF) {
+          return ERR_VAL;
+        }
+        req->chunk_left = (req->chunk_left << 4) | digit;
+        return ERR_OK;
+      }
+    }
+    if (c == '\n') {
+      /* end of the chunk size line, a size of 0 marks the last chunk */
+      req->chunk_state = (req->chunk_left != 0) ? HTTPC_CHUNK_DATA : HTTPC_CHUNK_TRAILER;
+    } else {
+      req->chunk_state = HTTPC_CHUNK_EXT;
+    }
+  } else if (req->chunk_state == HTTPC_CHUNK_DATA_END) {
+    if (c == '\n') {
+      req->chunk_state = HTTPC_CHUNK_SIZE;
+    } else if (c != '\r') {
+      return ERR_VAL;
+    }
+  } else if (req->chunk_state == HTTPC_CHUNK_TRAILER) {
+    if (c == '\n') {
+      /* empty line: end of the response */
+      req->chunk_state = HTTPC_CHUNK_DONE;
+    } else if (c != '\r') {
+      req->chunk_state = HTTPC_CHUNK_TRAILER_LINE;
+    }
+  } else if (req->chunk_state == HTTPC_CHUNK_TRAILER_LINE) {
+    if (c == '\n') {
+      req->chunk_state = HTTPC_CHUNK_TRAILER;
+    }
+  }
+  return ERR_OK;
+}
+
+/** The response has been received completely */
+static err_t
+httpc_rx_done(httpc_state_t *req)
+{
+#if LWIP_HTTPC_KEEPALIVE
+  if (req->keepalive) {
+    /* keep the connection before calling the result callback so that it can
+       be reused for a request started from that callback */
+    httpc_pool_put(req);
+  }
+#endif /* LWIP_HTTPC_KEEPALIVE */
+  return httpc_close(req, HTTPC_RESULT_OK, req->rx_status, ERR_OK);
+}
+
+/** The server has closed the connection: check if the response is complete */
+static err_t
+httpc_rx_closed(httpc_state_t *req)
+{
+  httpc_result_t result;
+
+  if (req->parse_state != HTTPC_PARSE_RX_DATA) {
+    /* did not get RX data yet */
+    result = HTTPC_RESULT_ERR_CLOSED;
+  } else if (((req->hdr_content_len != HTTPC_CONTENT_LEN_INVALID) &&
+    (req->hdr_content_len != req->rx_content_len)) ||
+    (req->chunk_state != HTTPC_CHUNK_NONE)) {
+    /* header has been received with content length (or chunked encoding)
+       but not all data received */
+    result = HTTPC_RESULT_ERR_CONTENT_LEN;
+  } else {
+    /* receiving data and either all data received or no content length header */
+    result = HTTPC_RESULT_OK;
+  }
+  return httpc_close(req, result, req->rx_status, ERR_OK);
+}
+
+#if LWIP_SUPPORT_CUSTOM_PBUF
+/** A PBUF_REF pointing into another pbuf, holding a reference on it */
+typedef struct _httpc_pbuf_ref
+{
+  struct pbuf_custom pc;
+  struct pbuf *original;
+} httpc_pbuf_ref_t;
+
+/** Free a httpc_pbuf_ref_t and its reference on the original pbuf */
+static void
+httpc_pbuf_ref_free(struct pbuf *p)
+{
+  httpc_pbuf_ref_t *ref = (httpc_pbuf_ref_t *)p;
+  pbuf_free(ref->original);
+  mem_free(ref);
+}
+#endif /* LWIP_SUPPORT_CUSTOM_PBUF */
+
+/** Split a pbuf chain after 'len' bytes. The data is not copied: a pbuf
+ * containing the split offset is referenced by both parts (without custom pbuf
+ * support, the rest of that single pbuf is copied).
+ *
+ * @param p pbuf chain to split, shortened to 'len' bytes on success
+ * @param len number of bytes to keep in 'p' (0 < len < p->tot_len)
+ * @return the data following the first 'len' bytes, NULL if out of memory
+ */
+static struct pbuf *
+httpc_pbuf_split(struct pbuf *p, u16_t len)
+{
+  u16_t rest_len = (u16_t)(p->tot_len - len);
+  u16_t off = len;
+  struct pbuf *q = p;
+  struct pbuf *rest;
+
+  LWIP_ASSERT("invalid split offset", (len > 0) && (len < p->tot_len));
+  /* find the pbuf containing the last byte to keep */
+  while (off > q->len) {
+    off = (u16_t)(off - q->len);
+    q = q->next;
+  }
+  if (off == q->len) {
+    rest = q->next;
+  } else {
+#if LWIP_SUPPORT_CUSTOM_PBUF
+    httpc_pbuf_ref_t *ref = (httpc_pbuf_ref_t *)mem_malloc(sizeof(httpc_pbuf_ref_t));
+    if (ref == NULL) {
+      return NULL;
+    }
+    ref->pc.custom_free_function = httpc_pbuf_ref_free;
+    ref->original = q;
+    pbuf_ref(q);
+    rest = pbuf_alloced_custom(PBUF_RAW, (u16_t)(q->len - off), PBUF_REF, &ref->pc,
+                               (u8_t *)q->payload + off, (u16_t)(q->len - off));
+#else /* LWIP_SUPPORT_CUSTOM_PBUF */
+    rest = pbuf_alloc(PBUF_RAW, (u16_t)(q->len - off), PBUF_RAM);
+    if (rest == NULL) {
+      return NULL;
+    }
+    MEMCPY(rest->payload, (u8_t *)q->payload + off, rest->len);
+#endif /* LWIP_SUPPORT_CUSTOM_PBUF */
+    if (q->next != NULL) {
+      pbuf_cat(rest, q->next);
+    }
+    q->len = off;
+  }
+  q->next = NULL;
+  for (; p != NULL; p = p->next) {
+    p->tot_len = (u16_t)(p->tot_len - rest_len);
+  }
+  return rest;
+}
+
+/** Pass body data to the application. Data refused by the application is kept
+ * (with the data following it) and passed again later (backpressure).
+ *
+ * @param data the data to pass (chunked encoding framing removed)
+ * @param rest received data following 'data', not parsed yet (or NULL)
+ * @return ERR_OK if the data has been taken or kept, ERR_ABRT if the connection
+ *         has been aborted from the callback
+ */
+static err_t
+httpc_rx_data(httpc_state_t *req, struct altcp_pcb *pcb, struct pbuf *data, struct pbuf *rest)
+{
+  u16_t len = data->tot_len;
+  err_t err;
+
+  if (req->recv_fn == NULL) {
+    altcp_recved(pcb, len);
+    pbuf_free(data);
+    return ERR_OK;
+  }
+  req->rx_content_len += len;
+  err = req->recv_fn(req->callback_arg, pcb, data, ERR_OK);
+  if (err == ERR_OK) {
+    return ERR_OK;
+  }
+  if (err == ERR_ABRT) {
+    if (rest != NULL) {
+      pbuf_free(rest);
+    }
+    /* directly return here: the connection has been aborted from the callback! */
+    return ERR_ABRT;
+  }
+  LWIP_DEBUGF(HTTPC_DEBUG_TRACE, ("httpc: %"U16_F" bytes refused\n", len));
+  req->rx_content_len -= len;
+  req->rx_refused = data;
+  req->rx_pending = rest;
+  return ERR_OK;
+}
+
+/** Pass received body data to the application. The chunked encoding framing
+ * is removed on the pbuf chain (the data is not copied); data following the
+ * response is dropped.
+ */
+static err_t
+httpc_rx_body(httpc_state_t *req, struct altcp_pcb *pcb, struct pbuf *p)
+{
+  err_t err;
+
+  if (req->rx_refused != NULL) {
+    /* pass the refused data again first, new data is parsed after it */
+    struct pbuf *data = req->rx_refused;
+    if (p != NULL) {
+      if (req->rx_pending != NULL) {
+        pbuf_cat(req->rx_pending, p);
+      } else {
+        req->rx_pending = p;
+      }
+    }
+    p = req->rx_pending;
+    req->rx_refused = NULL;
+    req->rx_pending = NULL;
+    err = httpc_rx_data(req, pcb, data, p);
+    if ((err != ERR_OK) || (req->rx_refused != NULL)) {
+      return err;
+    }
+  }
+  while (p != NULL) {
+    struct pbuf *data = p;
+    u16_t dropped = 0;
+
+    p = NULL;
+    if (req->chunk_state != HTTPC_CHUNK_NONE) {
+      /* strip the framing in front of the data */
+      while ((data != NULL) && (req->chunk_state != HTTPC_CHUNK_DATA) && (req->chunk_state != HTTPC_CHUNK_DONE)) {
+        if (httpc_chunk_parse(req, pbuf_get_at(data, 0)) != ERR_OK) {
+          LWIP_DEBUGF(HTTPC_DEBUG_WARN, ("httpc: invalid chunked encoding\n"));
+          pbuf_free(data);
+          return httpc_close(req, HTTPC_RESULT_ERR_CONTENT_LEN, req->rx_status, ERR_VAL);
+        }
+        data = pbuf_free_header(data, 1);
+        dropped++;
+      }
+      if ((data != NULL) && (req->chunk_state == HTTPC_CHUNK_DATA)) {
+        if (data->tot_len > req->chunk_left) {
+          /* split off what follows the chunk data */
+          p = httpc_pbuf_split(data, (u16_t)req->chunk_left);
+          if (p == NULL) {
+            pbuf_free(data);
+            return httpc_close(req, HTTPC_RESULT_ERR_MEM, req->rx_status, ERR_MEM);
+          }
+        }
+        req->chunk_left -= data->tot_len;
+        if (req->chunk_left == 0) {
+          req->chunk_state = HTTPC_CHUNK_DATA_END;
+        }
+      }
+    }
+    if ((data != NULL) && ((req->chunk_state == HTTPC_CHUNK_DONE) ||
+        ((req->hdr_content_len != HTTPC_CONTENT_LEN_INVALID) &&
+         (req->rx_content_len + data->tot_len > req->hdr_content_len)))) {
+      /* data after the end of the response: drop it, don't reuse the connection */
+      u16_t keep = 0;
+      if (req->chunk_state == HTTPC_CHUNK_NONE) {
+        keep = (u16_t)(req->hdr_content_len - req->rx_content_len);
+      }
+      dropped = (u16_t)(dropped + data->tot_len - keep);
+#if LWIP_HTTPC_KEEPALIVE
+      req->keepalive = 0;
+#endif /* LWIP_HTTPC_KEEPALIVE */
+      if (keep == 0) {
+        pbuf_free(data);
+        data = NULL;
+      } else {
+        pbuf_realloc(data, keep);
+      }
+    }
+    if (dropped != 0) {
+      altcp_recved(pcb, dropped);
+    }
+    if (data != NULL) {
+      /* received valid data: reset timeout */
+      req->timeout_ticks = HTTPC_POLL_TIMEOUT;
+      err = httpc_rx_data(req, pcb, data, p);
+      if ((err != ERR_OK) || (req->rx_refused != NULL)) {
+        return err;
+      }
+    }
+  }
+  if ((req->chunk_state == HTTPC_CHUNK_DONE) ||
+      ((req->chunk_state == HTTPC_CHUNK_NONE) && (req->hdr_content_len == req->rx_content_len))) {
+    return httpc_rx_done(req);
+  }
+  if (req->rx_closed) {
+    return httpc_rx_closed(req);
+  }
+  return ERR_OK;
+}
+
+#if LWIP_HTTPC_KEEPALIVE
+/** A reused connection has been closed by the server before answering (e.g.
+ * on its idle timeout): send the request again on a new connection.
+ *
+ * @return ERR_ABRT if the old connection had to be aborted, ERR_OK otherwise
+ */
+static err_t
+httpc_keepalive_retry(httpc_state_t *req)
+{
+  struct altcp_pcb *old_pcb = req->pcb;
+  err_t ret = ERR_OK;
+  err_t err = ERR_MEM;
+
+  LWIP_DEBUGF(HTTPC_DEBUG_STATE, ("httpc: reused connection closed, retrying\n"));
+  req->reused = 0;
+  if (old_pcb != NULL) {
+    altcp_arg(old_pcb, NULL);
+    altcp_recv(old_pcb, NULL);
+    altcp_err(old_pcb, NULL);
+    altcp_poll(old_pcb, NULL, 0);
+    altcp_sent(old_pcb, NULL);
+    if (altcp_close(old_pcb) != ERR_OK) {
+      altcp_abort(old_pcb);
+      ret = ERR_ABRT;
+    }
+  }
+  req->pcb = altcp_new(req->conn_settings ? req->conn_settings->altcp_allocator : NULL);
+  if (req->pcb != NULL) {
+    httpc_init_pcb(req);
+    err = altcp_connect(req->pcb, &req->remote_addr, req->remote_port, httpc_tcp_connected);
+  }
+  if (err != ERR_OK) {
+    httpc_close(req, HTTPC_RESULT_ERR_CONNECT, 0, err);
+  }
+  return ret;
+}
+#endif /* LWIP_HTTPC_KEEPALIVE */
+
 /** http client tcp recv callback */
 static err_t
 httpc_tcp_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t r)
@@ -288,20 +919,27 @@ httpc_tcp_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t r)
   httpc_state_t* req = (httpc_state_t*)arg;
   LWIP_UNUSED_ARG(r);
 
+#if LWIP_HTTPC_KEEPALIVE
+  if (req->reused && (req->parse_state == HTTPC_PARSE_WAIT_FIRST_LINE) && (req->rx_hdrs == NULL)) {
+    if (p == NULL) {
+      return httpc_keepalive_retry(req);
+    }
+    /* the server answers: the request is not needed for a retry any more */
+    req->reused = 0;
+    if (req->request != NULL) {
+      pbuf_free(req->request);
+      req->request = NULL;
+    }
+  }
+#endif /* LWIP_HTTPC_KEEPALIVE */
+
   if (p == NULL) {
-    httpc_result_t result;
-    if (req->parse_state != HTTPC_PARSE_RX_DATA) {
-      /* did not get RX data yet */
-      result = HTTPC_RESULT_ERR_CLOSED;
-    } else if ((req->hdr_content_len != HTTPC_CONTENT_LEN_INVALID) &&
-      (req->hdr_content_len != req->rx_content_len)) {
-      /* header has been received with content length but not all data received */
-      result = HTTPC_RESULT_ERR_CONTENT_LEN;
-    } else {
-      /* receiving data and either all data received or no content length header */
-      result = HTTPC_RESULT_OK;
+    if (req->rx_refused != NULL) {
+      /* handle the close when the refused data has been passed */
+      req->rx_closed = 1;
+      return ERR_OK;
     }
-    return httpc_close(req, result, req->rx_status, ERR_OK);
+    return httpc_rx_closed(req);
   }
   if (req->parse_state != HTTPC_PARSE_RX_DATA) {
     if (req->rx_hdrs == NULL) {
@@ -324,6 +962,7 @@ httpc_tcp_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t r)
         struct pbuf *q;
         /* full header received, send window update for header bytes and call into client callback */
         altcp_recved(pcb, total_header_len);
+        httpc_parse_body_framing(req, total_header_len);
         if (req->conn_settings) {
           if (req->conn_settings->headers_done_fn) {
             err = req->conn_settings->headers_done_fn(req, req->callback_arg, req->rx_hdrs, total_header_len, req->hdr_content_len);
@@ -341,17 +980,8 @@ httpc_tcp_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t r)
       }
     }
   }
-  if ((p != NULL) && (req->parse_state == HTTPC_PARSE_RX_DATA)) {
-    req->rx_content_len += p->tot_len;
-    /* received valid data: reset timeout */
-    req->timeout_ticks = HTTPC_POLL_TIMEOUT;
-    if (req->recv_fn != NULL) {
-      /* directly return here: the connection might already be aborted from the callback! */
-      return req->recv_fn(req->callback_arg, pcb, p, r);
-    } else {
-      altcp_recved(pcb, p->tot_len);
-      pbuf_free(p);
-    }
+  if (req->parse_state == HTTPC_PARSE_RX_DATA) {
+    return httpc_rx_body(req, pcb, p);
   }
   return ERR_OK;
 }
@@ -364,6 +994,12 @@ httpc_tcp_err(void *arg, err_t err)
   if (req != NULL) {
     /* pcb has already been deallocated */
     req->pcb = NULL;
+#if LWIP_HTTPC_KEEPALIVE
+    if (req->reused && (req->parse_state == HTTPC_PARSE_WAIT_FIRST_LINE) && (req->rx_hdrs == NULL)) {
+      httpc_keepalive_retry(req);
+      return;
+    }
+#endif /* LWIP_HTTPC_KEEPALIVE */
     httpc_close(req, HTTPC_RESULT_ERR_CLOSED, 0, err);
   }
 }
@@ -374,7 +1010,6 @@ httpc_tcp_poll(void *arg, struct altcp_pcb *pcb)
 {
   /* implement timeout */
   httpc_state_t* req = (httpc_state_t*)arg;
-  LWIP_UNUSED_ARG(pcb);
   if (req != NULL) {
     if (req->timeout_ticks) {
       req->timeout_ticks--;
@@ -382,6 +1017,10 @@ httpc_tcp_poll(void *arg, struct altcp_pcb *pcb)
     if (!req->timeout_ticks) {
       return httpc_close(req, HTTPC_RESULT_ERR_TIMEOUT, 0, ERR_OK);
     }
+    if (req->rx_refused != NULL) {
+      /* pass the data refused by the application again */
+      return httpc_rx_body(req, pcb, NULL);
+    }
   }
   return ERR_OK;
 }
@@ -397,6 +1036,30 @@ httpc_tcp_sent(void *arg, struct altcp_pcb *pcb, u16_t len)
   return ERR_OK;
 }
 
+/** Send the request on the established connection */
+static err_t
+httpc_send_request(httpc_state_t* req)
+{
+  /* send request; last char is zero termination */
+  err_t r = altcp_write(req->pcb, req->request->payload, req->request->len - 1, TCP_WRITE_FLAG_COPY);
+  if (r != ERR_OK) {
+    return r;
+  }
+#if LWIP_HTTPC_KEEPALIVE
+  if (req->reused) {
+    /* keep the request to retry if the server has closed the connection */
+  } else
+#endif /* LWIP_HTTPC_KEEPALIVE */
+  {
+    /* everything written, we can free the request */
+    pbuf_free(req->request);
+    req->request = NULL;
+  }
+
+  altcp_output(req->pcb);
+  return ERR_OK;
+}
+
 /** http client tcp connected callback */
 static err_t
 httpc_tcp_connected(void *arg, struct altcp_pcb *pcb, err_t err)
@@ -406,20 +1069,25 @@ httpc_tcp_connected(void *arg, struct altcp_pcb *pcb, err_t err)
   LWIP_UNUSED_ARG(pcb);
   LWIP_UNUSED_ARG(err);
 
-  /* send request; last char is zero termination */
-  r = altcp_write(req->pcb, req->request->payload, req->request->len - 1, TCP_WRITE_FLAG_COPY);
+  r = httpc_send_request(req);
   if (r != ERR_OK) {
      /* could not write the single small request -> fail, don't retry */
      return httpc_close(req, HTTPC_RESULT_ERR_MEM, 0, r);
   }
-  /* everything written, we can free the request */
-  pbuf_free(req->request);
-  req->request = NULL;
-
-  altcp_output(req->pcb);
   return ERR_OK;
 }
 
+/** Set up the callbacks of a new connection */
+static void
+httpc_init_pcb(httpc_state_t* req)
+{
+  altcp_arg(req->pcb, req);
+  altcp_recv(req->pcb, httpc_tcp_recv);
+  altcp_err(req->pcb, httpc_tcp_err);
+  altcp_poll(req->pcb, httpc_tcp_poll, HTTPC_POLL_INTERVAL);
+  altcp_sent(req->pcb, httpc_tcp_sent);
+}
+
 /** Start the http request when the server IP addr is known */
 static err_t
 httpc_get_internal_addr(httpc_state_t* req, const ip_addr_t *ipaddr)
@@ -427,6 +1095,13 @@ httpc_get_internal_addr(httpc_state_t* req, const ip_addr_t *ipaddr)
   err_t err;
   LWIP_ASSERT("req != NULL", req != NULL);
 
+#if LWIP_HTTPC_KEEPALIVE
+  if (req->reused) {
+    /* connection is established already */
+    return httpc_send_request(req);
+  }
+#endif /* LWIP_HTTPC_KEEPALIVE */
+
   if (&req->remote_addr != ipaddr) {
     /* fill in remote addr if called externally */
     req->remote_addr = *ipaddr;
@@ -476,6 +1151,13 @@ httpc_get_internal_dns(httpc_state_t* req, const char* server_name)
   err_t err;
   LWIP_ASSERT("req != NULL", req != NULL);
 
+#if LWIP_HTTPC_KEEPALIVE
+  if (req->reused) {
+    /* connection is established already */
+    return httpc_send_request(req);
+  }
+#endif /* LWIP_HTTPC_KEEPALIVE */
+
 #if LWIP_DNS
   err = dns_gethostbyname(server_name, &req->remote_addr, httpc_dns_found, req);
 #else
@@ -519,8 +1201,11 @@ httpc_init_connection_common(httpc_state_t **connection, const httpc_connection_
   mem_size_t mem_alloc_len;
   int req_len, req_len2;
   httpc_state_t *req;
+#if HTTPC_DEBUG_REQUEST || LWIP_HTTPC_KEEPALIVE
+  size_t server_name_len;
+#endif
 #if HTTPC_DEBUG_REQUEST
-  size_t server_name_len, uri_len;
+  size_t uri_len;
 #endif
 
   LWIP_ERROR("httpc connection settings not give", settings != NULL, return ERR_ARG;);
@@ -533,10 +1218,13 @@ httpc_init_connection_common(httpc_state_t **connection, const httpc_connection_
   }
   /* alloc state and request in one block */
   alloc_len = sizeof(httpc_state_t);
-#if HTTPC_DEBUG_REQUEST
+#if HTTPC_DEBUG_REQUEST || LWIP_HTTPC_KEEPALIVE
   server_name_len = server_name ? strlen(server_name) : 0;
+  alloc_len += server_name_len + 1;
+#endif
+#if HTTPC_DEBUG_REQUEST
   uri_len = strlen(uri);
-  alloc_len += server_name_len + 1 + uri_len + 1;
+  alloc_len += uri_len + 1;
 #endif
   mem_alloc_len = (mem_size_t)alloc_len;
   if ((mem_alloc_len < alloc_len) || (req_len + 1 > 0xFFFF)) {
@@ -560,25 +1248,33 @@ httpc_init_connection_common(httpc_state_t **connection, const httpc_connection_
     return ERR_MEM;
   }
   req->hdr_content_len = HTTPC_CONTENT_LEN_INVALID;
-#if HTTPC_DEBUG_REQUEST
+#if HTTPC_DEBUG_REQUEST || LWIP_HTTPC_KEEPALIVE
   req->server_name = (char*)(req + 1);
   if (server_name) {
     memcpy(req->server_name, server_name, server_name_len + 1);
+  } else {
+    req->server_name[0] = 0;
   }
+#endif
+#if HTTPC_DEBUG_REQUEST
   req->uri = req->server_name + server_name_len + 1;
   memcpy(req->uri, uri, uri_len + 1);
 #endif
-  req->pcb = altcp_new(settings ? settings->altcp_allocator : NULL);
+  req->remote_port = (settings && settings->use_proxy) ? settings->proxy_port : server_port;
+#if LWIP_HTTPC_KEEPALIVE
+  req->server_port = server_port;
+  req->pcb = httpc_pool_get(req, settings);
+  req->reused = (req->pcb != NULL);
+  if (req->pcb == NULL)
+#endif /* LWIP_HTTPC_KEEPALIVE */
+  {
+    req->pcb = altcp_new(settings ? settings->altcp_allocator : NULL);
+  }
   if(req->pcb == NULL) {
     httpc_free_state(req);
     return ERR_MEM;
   }
-  req->remote_port = (settings && settings->use_proxy) ? settings->proxy_port : server_port;
-  altcp_arg(req->pcb, req);
-  altcp_recv(req->pcb, httpc_tcp_recv);
-  altcp_err(req->pcb, httpc_tcp_err);
-  altcp_poll(req->pcb, httpc_tcp_poll, HTTPC_POLL_INTERVAL);
-  altcp_sent(req->pcb, httpc_tcp_sent);
+  httpc_init_pcb(req);
 
   /* set up request buffer */
   req_len2 = httpc_create_request_string(settings, server_name, server_port, uri, use_host,
@@ -130,6 +130,29 @@
 
 /* This defines checks whether tcp_write has to copy data or not */
 
+/** Send files with precalculated checksums (see HTTPD_PRECALCULATED_CHECKSUM) */
+#define HTTPD_SEND_PRECALCULATED_CHECKSUM (HTTPD_PRECALCULATED_CHECKSUM && LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP)
+/** Answer conditional requests (see LWIP_HTTPD_CONDITIONAL_REQUESTS) */
+#define HTTPD_SEND_NOT_MODIFIED (LWIP_HTTPD_CONDITIONAL_REQUESTS && LWIP_HTTPD_DYNAMIC_HEADERS)
+/** Answer byte range requests (see LWIP_HTTPD_RANGE_REQUESTS) */
+#define HTTPD_SEND_RANGE (LWIP_HTTPD_RANGE_REQUESTS && LWIP_HTTPD_DYNAMIC_HEADERS)
+/** Queue pipelined requests (see LWIP_HTTPD_PIPELINING) */
+#define HTTPD_PIPELINING (LWIP_HTTPD_PIPELINING && LWIP_HTTPD_SUPPORT_11_KEEPALIVE && LWIP_HTTPD_SUPPORT_REQUESTLIST)
+
+#if LWIP_HTTPD_WEBSOCKET
+#if LWIP_HTTPD_WEBSOCKET_MAX_RX_LEN > (0xFFFF - 14)
+#error LWIP_HTTPD_WEBSOCKET_MAX_RX_LEN is too large
+#endif
+/* http_state->ws_state */
+#define HTTPD_WS_STATE_NONE     0 /* normal HTTP connection */
+#define HTTPD_WS_STATE_OPEN     1 /* WebSocket connection */
+#define HTTPD_WS_STATE_CLOSING  2 /* close frame has been queued */
+#define HTTPD_WS_STATE_CLOSED   3 /* closed, waiting for the written data to be acknowledged */
+/* A frame is passed to altcp_recved() only when it has been received completely,
+   so it must fit into the receive window */
+#define HTTPD_WS_MAX_RX_LEN     ((u32_t)LWIP_MIN(LWIP_HTTPD_WEBSOCKET_MAX_RX_LEN, TCP_WND - 14))
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
 #ifndef HTTP_IS_DATA_VOLATILE
 /** tcp_write does not have to copy data when sent from rom-file-system directly */
 #define HTTP_IS_DATA_VOLATILE(hs)       (HTTP_IS_DYNAMIC_FILE(hs) ? TCP_WRITE_FLAG_COPY : 0)
@@ -140,6 +163,7 @@
 #endif
 
 /* Return values for http_send_*() */
+#define HTTP_DATA_TO_SEND_NEXT     4
 #define HTTP_DATA_TO_SEND_FREED    3
 #define HTTP_DATA_TO_SEND_BREAK    2
 #define HTTP_DATA_TO_SEND_CONTINUE 1
@@ -179,16 +203,50 @@ static char httpd_req_buf[LWIP_HTTPD_MAX_REQ_LENGTH + 1];
 static char http_uri_buf[LWIP_HTTPD_URI_BUF_LEN + 1];
 #endif
 
+#if LWIP_HTTPD_CONTENT_ENCODING
+/* File name of a pre-compressed variant of the requested file */
+static char http_encoded_name_buf[LWIP_HTTPD_CONTENT_ENCODING_NAME_LEN + 1];
+
+/** Pre-compressed variants of files, in the order of preference */
+static const struct {
+  const char *suffix;
+  u8_t flag;
+} http_encodings[] = {
+  { ".br", FS_FILE_FLAGS_ENCODING_BR },
+  { ".gz", FS_FILE_FLAGS_ENCODING_GZIP }
+};
+#endif /* LWIP_HTTPD_CONTENT_ENCODING */
+
 #if LWIP_HTTPD_DYNAMIC_HEADERS
 /* The number of individual strings that comprise the headers sent before each
  * requested file.
  */
-#define NUM_FILE_HDR_STRINGS 5
 #define HDR_STRINGS_IDX_HTTP_STATUS           0 /* e.g. "HTTP/1.0 200 OK\r\n" */
 #define HDR_STRINGS_IDX_SERVER_NAME           1 /* e.g. "Server: "HTTPD_SERVER_AGENT"\r\n" */
 #define HDR_STRINGS_IDX_CONTENT_LEN_KEEPALIVE 2 /* e.g. "Content-Length: xy\r\n" and/or "Connection: keep-alive\r\n" */
 #define HDR_STRINGS_IDX_CONTENT_LEN_NR        3 /* the byte count, when content-length is used */
-#define HDR_STRINGS_IDX_CONTENT_TYPE          4 /* the content type (or default answer content type including default document) */
+#if LWIP_HTTPD_CONTENT_ENCODING
+#define HDR_STRINGS_IDX_CONTENT_ENCODING      4 /* e.g. "Content-Encoding: gzip\r\n" and/or "Vary: Accept-Encoding\r\n" */
+#define HDR_STRINGS_NUM_CONTENT_ENCODING      1
+#else /* LWIP_HTTPD_CONTENT_ENCODING */
+#define HDR_STRINGS_NUM_CONTENT_ENCODING      0
+#endif /* LWIP_HTTPD_CONTENT_ENCODING */
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+#define HDR_STRINGS_IDX_VALIDATORS            (4 + HDR_STRINGS_NUM_CONTENT_ENCODING) /* "ETag: ..." and/or "Last-Modified: ..." */
+#define HDR_STRINGS_NUM_VALIDATORS            1
+#else /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+#define HDR_STRINGS_NUM_VALIDATORS            0
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+#if HTTPD_SEND_RANGE
+#define HDR_STRINGS_IDX_CONTENT_RANGE         (4 + HDR_STRINGS_NUM_CONTENT_ENCODING + HDR_STRINGS_NUM_VALIDATORS) /* "Content-Range: ..." */
+#define HDR_STRINGS_NUM_CONTENT_RANGE         1
+/* "Content-Range: bytes " + 3 numbers + '-' + '/' + CRLF + NULL */
+#define HTTPD_CONTENT_RANGE_SIZE              (21 + 3 * 10 + 5)
+#else /* HTTPD_SEND_RANGE */
+#define HDR_STRINGS_NUM_CONTENT_RANGE         0
+#endif /* HTTPD_SEND_RANGE */
+#define HDR_STRINGS_IDX_CONTENT_TYPE          (4 + HDR_STRINGS_NUM_CONTENT_ENCODING + HDR_STRINGS_NUM_VALIDATORS + HDR_STRINGS_NUM_CONTENT_RANGE) /* the content type (or default answer content type including default document) */
+#define NUM_FILE_HDR_STRINGS                  (HDR_STRINGS_IDX_CONTENT_TYPE + 1)
 
 /* The dynamically generated Content-Length buffer needs space for CRLF + NULL */
 #define LWIP_HTTPD_MAX_CONTENT_LEN_OFFSET 3
@@ -249,16 +307,38 @@ struct http_state {
 #if LWIP_HTTPD_SUPPORT_REQUESTLIST
   struct pbuf *req;
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+#if LWIP_HTTPD_WEBSOCKET
+  struct pbuf *ws_rx;    /* Received data of an incomplete frame */
+  struct pbuf *ws_tx;    /* Data to send, starting with ws_tx_written bytes not acknowledged yet */
+  u32_t http_unacked;    /* HTTP data written but not acknowledged yet */
+  u16_t ws_tx_written;
+  u8_t ws_state;
+  u8_t ws_close_received;
+  u8_t ws_rx_fragmented; /* a fragmented message is being received */
+  u8_t ws_rx_text;       /* the message being received is a text message */
+  u8_t ws_rx_utf8;       /* UTF-8 decoder state of that message */
+#endif /* LWIP_HTTPD_WEBSOCKET */
+#if HTTPD_PIPELINING
+  struct pbuf *pipeline; /* Data received after the current request */
+  u16_t pipeline_unrecved; /* Bytes in pipeline not yet passed to altcp_recved() */
+#endif /* HTTPD_PIPELINING */
 
 #if LWIP_HTTPD_DYNAMIC_FILE_READ
   char *buf;        /* File read buffer. */
   int buf_len;      /* Size of file read buffer, buf. */
 #endif /* LWIP_HTTPD_DYNAMIC_FILE_READ */
   u32_t left;       /* Number of unsent bytes in buf. */
+#if HTTPD_SEND_PRECALCULATED_CHECKSUM
+  const struct fsdata_chksum *chksum; /* Precalculated checksums of the segment size used */
+  u16_t chksum_count;
+#endif /* HTTPD_SEND_PRECALCULATED_CHECKSUM */
   u8_t retries;
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
   u8_t keepalive;
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_CONTENT_ENCODING
+  u8_t accept_encoding; /* FS_FILE_FLAGS_ENCODING_* accepted by the client */
+#endif /* LWIP_HTTPD_CONTENT_ENCODING */
 #if LWIP_HTTPD_SSI
   struct http_ssi_state *ssi;
 #endif /* LWIP_HTTPD_SSI */
@@ -269,6 +349,9 @@ struct http_state {
 #if LWIP_HTTPD_DYNAMIC_HEADERS
   const char *hdrs[NUM_FILE_HDR_STRINGS]; /* HTTP headers to be sent. */
   char hdr_content_len[LWIP_HTTPD_MAX_CONTENT_LEN_SIZE];
+#if HTTPD_SEND_RANGE
+  char hdr_content_range[HTTPD_CONTENT_RANGE_SIZE];
+#endif /* HTTPD_SEND_RANGE */
   u16_t hdr_pos;     /* The position of the first unsent header byte in the
                         current string */
   u16_t hdr_index;   /* The index of the hdr string currently being sent. */
@@ -310,6 +393,12 @@ static err_t http_find_file(struct http_state *hs, const char *uri, int is_09);
 static err_t http_init_file(struct http_state *hs, struct fs_file *file, int is_09, const char *uri, u8_t tag_check, char *params);
 static err_t http_poll(void *arg, struct altcp_pcb *pcb);
 static u8_t http_check_eof(struct altcp_pcb *pcb, struct http_state *hs);
+#if HTTPD_PIPELINING
+static err_t http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pcb);
+#endif /* HTTPD_PIPELINING */
+#if LWIP_HTTPD_WEBSOCKET
+static void http_ws_output(struct altcp_pcb *pcb, struct http_state *hs);
+#endif /* LWIP_HTTPD_WEBSOCKET */
 #if LWIP_HTTPD_FS_ASYNC_READ
 static void http_continue(void *connection);
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
@@ -530,6 +619,30 @@ http_state_eof(struct http_state *hs)
     hs->req = NULL;
   }
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+#if HTTPD_PIPELINING
+  if (hs->pipeline) {
+    pbuf_free(hs->pipeline);
+    hs->pipeline = NULL;
+  }
+#endif /* HTTPD_PIPELINING */
+#if LWIP_HTTPD_WEBSOCKET
+  if (hs->ws_state != HTTPD_WS_STATE_NONE) {
+    hs->ws_state = HTTPD_WS_STATE_NONE;
+    httpd_websocket_closed(hs);
+  }
+  if (hs->ws_rx) {
+    pbuf_free(hs->ws_rx);
+    hs->ws_rx = NULL;
+  }
+  if (hs->ws_tx) {
+    pbuf_free(hs->ws_tx);
+    hs->ws_tx = NULL;
+  }
+  hs->ws_tx_written = 0;
+  hs->ws_rx_fragmented = 0;
+  hs->ws_rx_text = 0;
+  hs->ws_rx_utf8 = 0;
+#endif /* LWIP_HTTPD_WEBSOCKET */
   http_state_close_post(hs);
 }
 
@@ -549,6 +662,7 @@ http_state_free(struct http_state *hs)
 /** Call tcp_write() in a loop trying smaller and smaller length
  *
  * @param pcb altcp_pcb to send
+ * @param hs connection state
  * @param ptr Data to send
  * @param length Length of data to send (in/out: on return, contains the
  *        amount of data sent)
@@ -556,11 +670,12 @@ http_state_free(struct http_state *hs)
  * @return the return value of tcp_write
  */
 static err_t
-http_write(struct altcp_pcb *pcb, const void *ptr, u16_t *length, u8_t apiflags)
+http_write(struct altcp_pcb *pcb, struct http_state *hs, const void *ptr, u16_t *length, u8_t apiflags)
 {
   u16_t len, max_len;
   err_t err;
   LWIP_ASSERT("length != NULL", length != NULL);
+  LWIP_UNUSED_ARG(hs);
   len = *length;
   if (len == 0) {
     return ERR_OK;
@@ -596,6 +711,9 @@ http_write(struct altcp_pcb *pcb, const void *ptr, u16_t *length, u8_t apiflags)
   if (err == ERR_OK) {
     LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Sent %d bytes\n", len));
     *length = len;
+#if LWIP_HTTPD_WEBSOCKET
+    hs->http_unacked += len;
+#endif /* LWIP_HTTPD_WEBSOCKET */
   } else {
     LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Send failed with err %d (\"%s\")\n", err, lwip_strerr(err)));
     *length = 0;
@@ -624,6 +742,16 @@ http_close_or_abort_conn(struct altcp_pcb *pcb, struct http_state *hs, u8_t abor
   err_t err;
   LWIP_DEBUGF(HTTPD_DEBUG, ("Closing connection %p\n", (void *)pcb));
 
+#if LWIP_HTTPD_WEBSOCKET
+  if ((hs != NULL) && (hs->ws_tx_written != 0) && !abort_conn) {
+    /* the pcb still references WebSocket data: close when it has been
+       acknowledged (see http_sent), nothing more is sent or received */
+    LWIP_DEBUGF(HTTPD_DEBUG, ("Waiting for WebSocket data to be acknowledged\n"));
+    hs->ws_state = HTTPD_WS_STATE_CLOSED;
+    hs->ws_close_received = 1;
+    return ERR_OK;
+  }
+#endif /* LWIP_HTTPD_WEBSOCKET */
   http_state_close_post(hs);
 
   altcp_arg(pcb, NULL);
@@ -661,15 +789,150 @@ http_close_conn(struct altcp_pcb *pcb, struct http_state *hs)
   return http_close_or_abort_conn(pcb, hs, 0);
 }
 
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+/** Check if a response is being sent on a connection (so that a new request
+ * cannot be parsed yet)
+ */
+static u8_t
+http_is_busy(struct http_state *hs)
+{
+  return (u8_t)((hs->handle != NULL) || (hs->file != NULL)
+#if LWIP_HTTPD_DYNAMIC_HEADERS
+                || (hs->hdr_index < NUM_FILE_HDR_STRINGS)
+#endif /* LWIP_HTTPD_DYNAMIC_HEADERS */
+               );
+}
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+
+#if HTTPD_PIPELINING
+
+/** Keep the data following a complete request (pipelined requests) to parse
+ * it when the response to this request has been sent.
+ *
+ * @param hs http connection state
+ * @param req the received request data
+ * @param req_len length of the request (including the CRLFCRLF ending it)
+ */
+static void
+http_pipeline_save(struct http_state *hs, struct pbuf *req, u16_t req_len)
+{
+  struct pbuf *rest;
+
+  LWIP_ASSERT("pipeline already in use", hs->pipeline == NULL);
+  if (req->tot_len <= req_len) {
+    return;
+  }
+  rest = pbuf_alloc(PBUF_RAW, (u16_t)(req->tot_len - req_len), PBUF_RAM);
+  if (rest == NULL) {
+    /* cannot keep the next request: close after this one */
+    LWIP_DEBUGF(HTTPD_DEBUG, ("No memory for pipelined request, closing after this response\n"));
+    hs->keepalive = 0;
+    return;
+  }
+  pbuf_copy_partial(req, rest->payload, rest->len, req_len);
+  hs->pipeline = rest;
+}
+
+/** Queue data received while a response is being sent.
+ * The receive window is only updated when the data is processed, so that a
+ * client cannot pipeline more requests than fit into the window.
+ *
+ * @return 1 if the pbuf has been queued (or dropped), 0 if it must be processed
+ */
+static u8_t
+http_pipeline_queue(struct altcp_pcb *pcb, struct http_state *hs, struct pbuf *p)
+{
+#if LWIP_HTTPD_SUPPORT_POST
+  if (hs->post_content_len_left > 0) {
+    /* this is data for a POST */
+    return 0;
+  }
+#endif /* LWIP_HTTPD_SUPPORT_POST */
+  if ((hs->pipeline == NULL) && !http_is_busy(hs)) {
+    return 0;
+  }
+  if (hs->pipeline == NULL) {
+    hs->pipeline = p;
+  } else if ((u32_t)hs->pipeline->tot_len + p->tot_len <= 0xFFFF) {
+    pbuf_cat(hs->pipeline, p);
+  } else {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("Too many pipelined requests, closing after this response\n"));
+    hs->keepalive = 0;
+    altcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return 1;
+  }
+  LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Queued %"U16_F" bytes of pipelined requests\n", p->tot_len));
+  hs->pipeline_unrecved = (u16_t)(hs->pipeline_unrecved + p->tot_len);
+  return 1;
+}
+
+/** Parse the next pipelined request after a response has been sent.
+ *
+ * @return 1 if a response is ready to be sent, 0 otherwise
+ */
+static u8_t
+http_pipeline_process(struct altcp_pcb *pcb, struct http_state *hs)
+{
+  struct pbuf *p = hs->pipeline;
+  err_t parsed;
+
+  hs->pipeline = NULL;
+  if (hs->pipeline_unrecved != 0) {
+    /* the data is processed now, open the window again */
+    altcp_recved(pcb, hs->pipeline_unrecved);
+    hs->pipeline_unrecved = 0;
+  }
+  parsed = http_parse_request(p, hs, pcb);
+  if ((parsed != ERR_INPROGRESS) && (hs->req != NULL)) {
+    /* request fully parsed or error */
+    pbuf_free(hs->req);
+    hs->req = NULL;
+  }
+  pbuf_free(p);
+  if (parsed == ERR_OK) {
+#if LWIP_HTTPD_WEBSOCKET
+    if (hs->ws_state != HTTPD_WS_STATE_NONE) {
+      /* send the 101 response */
+      http_ws_output(pcb, hs);
+      return 0;
+    }
+#endif /* LWIP_HTTPD_WEBSOCKET */
+#if LWIP_HTTPD_SUPPORT_POST
+    if (hs->post_content_len_left != 0) {
+      /* wait for the POST data */
+      return 0;
+    }
+#endif /* LWIP_HTTPD_SUPPORT_POST */
+    return 1;
+  } else if (parsed == ERR_ARG) {
+    http_close_conn(pcb, hs);
+  }
+  return 0;
+}
+#endif /* HTTPD_PIPELINING */
+
 /** End of file: either close the connection (Connection: close) or
  * close the file (Connection: keep-alive)
+ *
+ * @return 1 if the connection stays open and the response to a pipelined
+ *         request is ready to be sent, 0 otherwise
  */
-static void
+static u8_t
 http_eof(struct altcp_pcb *pcb, struct http_state *hs)
 {
   /* HTTP/1.1 persistent connection? (Not supported for SSI) */
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
   if (hs->keepalive) {
+#if LWIP_HTTPD_WEBSOCKET
+    /* data of previous responses may not be acknowledged yet */
+    u32_t http_unacked = hs->http_unacked;
+#endif /* LWIP_HTTPD_WEBSOCKET */
+#if HTTPD_PIPELINING
+    struct pbuf *pipeline = hs->pipeline;
+    u16_t pipeline_unrecved = hs->pipeline_unrecved;
+    hs->pipeline = NULL;
+#endif /* HTTPD_PIPELINING */
     http_remove_connection(hs);
 
     http_state_eof(hs);
@@ -677,14 +940,25 @@ http_eof(struct altcp_pcb *pcb, struct http_state *hs)
     /* restore state: */
     hs->pcb = pcb;
     hs->keepalive = 1;
+#if LWIP_HTTPD_WEBSOCKET
+    hs->http_unacked = http_unacked;
+#endif /* LWIP_HTTPD_WEBSOCKET */
     http_add_connection(hs);
     /* ensure nagle doesn't interfere with sending all data as fast as possible: */
     altcp_nagle_disable(pcb);
+#if HTTPD_PIPELINING
+    hs->pipeline = pipeline;
+    hs->pipeline_unrecved = pipeline_unrecved;
+    if (pipeline != NULL) {
+      return http_pipeline_process(pcb, hs);
+    }
+#endif /* HTTPD_PIPELINING */
   } else
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
   {
     http_close_conn(pcb, hs);
   }
+  return 0;
 }
 
 #if LWIP_HTTPD_CGI || LWIP_HTTPD_CGI_SSI
@@ -864,6 +1138,24 @@ get_http_headers(struct http_state *hs, const char *uri)
   hs->hdrs[HDR_STRINGS_IDX_SERVER_NAME] = g_psHTTPHeaderStrings[HTTP_HDR_SERVER];
   hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEEPALIVE] = NULL;
   hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_NR] = NULL;
+#if LWIP_HTTPD_CONTENT_ENCODING
+  hs->hdrs[HDR_STRINGS_IDX_CONTENT_ENCODING] = NULL;
+  if (hs->handle != NULL) {
+    if (hs->handle->flags & FS_FILE_FLAGS_ENCODING_BR) {
+      hs->hdrs[HDR_STRINGS_IDX_CONTENT_ENCODING] = HTTP_HDR_ENCODING_BR;
+    } else if (hs->handle->flags & FS_FILE_FLAGS_ENCODING_GZIP) {
+      hs->hdrs[HDR_STRINGS_IDX_CONTENT_ENCODING] = HTTP_HDR_ENCODING_GZIP;
+    } else if (hs->handle->flags & FS_FILE_FLAGS_ENCODING_VARIANTS) {
+      hs->hdrs[HDR_STRINGS_IDX_CONTENT_ENCODING] = HTTP_HDR_VARY_ENCODING;
+    }
+  }
+#endif /* LWIP_HTTPD_CONTENT_ENCODING */
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+  hs->hdrs[HDR_STRINGS_IDX_VALIDATORS] = (hs->handle != NULL) ? hs->handle->validators : NULL;
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+#if HTTPD_SEND_RANGE
+  hs->hdrs[HDR_STRINGS_IDX_CONTENT_RANGE] = NULL;
+#endif /* HTTPD_SEND_RANGE */
 
   /* Is this a normal file or the special case we use to send back the
      default "404: Page not found" response? */
@@ -1006,6 +1298,8 @@ get_http_content_length(struct http_state *hs)
  *           - HTTP_DATA_TO_SEND_BREAK: data has been enqueued, headers pending,
  *                                      so don't send HTTP body yet
  *           - HTTP_DATA_TO_SEND_FREED: http_state and pcb are already freed
+ *           - HTTP_DATA_TO_SEND_NEXT: the response is finished and the
+ *                                     response to a pipelined request is ready
  */
 static u8_t
 http_send_headers(struct altcp_pcb *pcb, struct http_state *hs)
@@ -1043,10 +1337,16 @@ http_send_headers(struct altcp_pcb *pcb, struct http_state *hs)
       /* content-length is always volatile */
       apiflags |= TCP_WRITE_FLAG_COPY;
     }
+#if HTTPD_SEND_RANGE
+    if (hs->hdr_index == HDR_STRINGS_IDX_CONTENT_RANGE) {
+      /* content-range is always volatile */
+      apiflags |= TCP_WRITE_FLAG_COPY;
+    }
+#endif /* HTTPD_SEND_RANGE */
     if (hs->hdr_index < NUM_FILE_HDR_STRINGS - 1) {
       apiflags |= TCP_WRITE_FLAG_MORE;
     }
-    err = http_write(pcb, ptr, &sendlen, apiflags);
+    err = http_write(pcb, hs, ptr, &sendlen, apiflags);
     if ((err == ERR_OK) && (old_sendlen != sendlen)) {
       /* Remember that we added some more data to be transmitted. */
       data_to_send = HTTP_DATA_TO_SEND_CONTINUE;
@@ -1076,8 +1376,12 @@ http_send_headers(struct altcp_pcb *pcb, struct http_state *hs)
     /* When we are at the end of the headers, check for data to send
      * instead of waiting for ACK from remote side to continue
      * (which would happen when sending files from async read). */
-    if (http_check_eof(pcb, hs)) {
+    u8_t eof = http_check_eof(pcb, hs);
+    if (eof == 1) {
       data_to_send = HTTP_DATA_TO_SEND_BREAK;
+    } else if (eof == 2) {
+      /* response without body (e.g. 304) done, continue with the next one */
+      return HTTP_DATA_TO_SEND_NEXT;
     } else {
       /* At this point, for non-keepalive connections, hs is deallocated an
          pcb is closed. */
@@ -1101,6 +1405,8 @@ http_send_headers(struct altcp_pcb *pcb, struct http_state *hs)
  *
  * @returns: 0 if the file is finished or no data has been read
  *           1 if the file is not finished and data has been read
+ *           2 if the file is finished and the connection stays open with the
+ *             response to a pipelined request ready to be sent
  */
 static u8_t
 http_check_eof(struct altcp_pcb *pcb, struct http_state *hs)
@@ -1116,15 +1422,13 @@ http_check_eof(struct altcp_pcb *pcb, struct http_state *hs)
   /* Do we have a valid file handle? */
   if (hs->handle == NULL) {
     /* No - close the connection. */
-    http_eof(pcb, hs);
-    return 0;
+    return (u8_t)(http_eof(pcb, hs) ? 2 : 0);
   }
   bytes_left = fs_bytes_left(hs->handle);
   if (bytes_left <= 0) {
     /* We reached the end of the file so this request is done. */
     LWIP_DEBUGF(HTTPD_DEBUG, ("End of file.\n"));
-    http_eof(pcb, hs);
-    return 0;
+    return (u8_t)(http_eof(pcb, hs) ? 2 : 0);
   }
 #if LWIP_HTTPD_DYNAMIC_FILE_READ
   /* Do we already have a send buffer allocated? */
@@ -1176,8 +1480,7 @@ http_check_eof(struct altcp_pcb *pcb, struct http_state *hs)
     /* We reached the end of the file so this request is done.
      * @todo: close here for HTTP/1.1 when reading file fails */
     LWIP_DEBUGF(HTTPD_DEBUG, ("End of file.\n"));
-    http_eof(pcb, hs);
-    return 0;
+    return (u8_t)(http_eof(pcb, hs) ? 2 : 0);
   }
 
   /* Set up to send the block of data we just read */
@@ -1208,11 +1511,56 @@ http_send_data_nonssi(struct altcp_pcb *pcb, struct http_state *hs)
   u16_t len;
   u8_t data_to_send = 0;
 
+#if HTTPD_SEND_PRECALCULATED_CHECKSUM
+  if ((hs->chksum != NULL) && !HTTP_IS_DYNAMIC_FILE(hs)) {
+    u32_t offset = (u32_t)(hs->file - hs->handle->data);
+    u32_t written = 0;
+    u16_t idx = (u16_t)(offset / hs->chksum[0].len);
+    /* send whole chunks as long as we are aligned to them: each chunk is
+       put into one segment without reading the data for the checksum */
+    while ((idx < hs->chksum_count) && (hs->chksum[idx].offset == offset) &&
+           (hs->chksum[idx].len <= hs->left)) {
+      len = hs->chksum[idx].len;
+      if (altcp_sndbuf(pcb) < len) {
+        /* wait for more space */
+        return data_to_send;
+      }
+#ifdef HTTPD_MAX_WRITE_LEN
+      if ((written > 0) && (written + len > HTTPD_MAX_WRITE_LEN(pcb))) {
+        return data_to_send;
+      }
+#endif /* HTTPD_MAX_WRITE_LEN */
+      err = altcp_write_chksum(pcb, hs->file, len, 0, hs->chksum[idx].chksum);
+      if (err != ERR_OK) {
+        LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Send failed with err %d (\"%s\")\n", err, lwip_strerr(err)));
+        return data_to_send;
+      }
+      data_to_send = 1;
+#if LWIP_HTTPD_WEBSOCKET
+      hs->http_unacked += len;
+#endif /* LWIP_HTTPD_WEBSOCKET */
+      hs->file += len;
+      hs->left -= len;
+      offset += len;
+      written += len;
+      idx++;
+    }
+    if (data_to_send) {
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+      altcp_nagle_enable(pcb);
+#endif
+      return data_to_send;
+    }
+    /* not aligned to the precalculated chunks (e.g. HTTP/0.9 without header) */
+    hs->chksum = NULL;
+  }
+#endif /* HTTPD_SEND_PRECALCULATED_CHECKSUM */
+
   /* We are not processing an SHTML file so no tag checking is necessary.
    * Just send the data as we received it from the file. */
   len = (u16_t)LWIP_MIN(hs->left, 0xffff);
 
-  err = http_write(pcb, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
+  err = http_write(pcb, hs, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
   if (err == ERR_OK) {
     data_to_send = 1;
     hs->file += len;
@@ -1250,7 +1598,7 @@ http_send_data_ssi(struct altcp_pcb *pcb, struct http_state *hs)
   if (ssi->parsed > hs->file) {
     len = (u16_t)LWIP_MIN(ssi->parsed - hs->file, 0xffff);
 
-    err = http_write(pcb, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
+    err = http_write(pcb, hs, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
     if (err == ERR_OK) {
       data_to_send = 1;
       hs->file += len;
@@ -1442,7 +1790,7 @@ http_send_data_ssi(struct altcp_pcb *pcb, struct http_state *hs)
               len = (u16_t)LWIP_MIN(ssi->tag_started - hs->file, 0xffff);
 #endif /* LWIP_HTTPD_SSI_INCLUDE_TAG*/
 
-              err = http_write(pcb, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
+              err = http_write(pcb, hs, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
               if (err == ERR_OK) {
                 data_to_send = 1;
 #if !LWIP_HTTPD_SSI_INCLUDE_TAG
@@ -1483,7 +1831,7 @@ http_send_data_ssi(struct altcp_pcb *pcb, struct http_state *hs)
           len = (u16_t)LWIP_MIN(ssi->tag_started - hs->file, 0xffff);
 #endif /* LWIP_HTTPD_SSI_INCLUDE_TAG*/
           if (len != 0) {
-            err = http_write(pcb, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
+            err = http_write(pcb, hs, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
           } else {
             err = ERR_OK;
           }
@@ -1520,7 +1868,7 @@ http_send_data_ssi(struct altcp_pcb *pcb, struct http_state *hs)
              * single tag insert buffer per connection. If we don't do
              * this, insert corruption can occur if more than one insert
              * is processed before we call tcp_output. */
-            err = http_write(pcb, &(ssi->tag_insert[ssi->tag_index]), &len,
+            err = http_write(pcb, hs, &(ssi->tag_insert[ssi->tag_index]), &len,
                              HTTP_IS_TAG_VOLATILE(hs));
             if (err == ERR_OK) {
               data_to_send = 1;
@@ -1567,7 +1915,7 @@ http_send_data_ssi(struct altcp_pcb *pcb, struct http_state *hs)
       len = (u16_t)LWIP_MIN(ssi->parsed - hs->file, 0xffff);
     }
 
-    err = http_write(pcb, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
+    err = http_write(pcb, hs, hs->file, &len, HTTP_IS_DATA_VOLATILE(hs));
     if (err == ERR_OK) {
       data_to_send = 1;
       hs->file += len;
@@ -1578,16 +1926,17 @@ http_send_data_ssi(struct altcp_pcb *pcb, struct http_state *hs)
 }
 #endif /* LWIP_HTTPD_SSI */
 
-/**
- * Try to send more data on this pcb.
+/** Sub-function of http_send(): send the current response
  *
  * @param pcb the pcb to send data
  * @param hs connection state
+ * @returns: as http_send_headers()
  */
 static u8_t
-http_send(struct altcp_pcb *pcb, struct http_state *hs)
+http_send_response(struct altcp_pcb *pcb, struct http_state *hs)
 {
   u8_t data_to_send = HTTP_NO_DATA_TO_SEND;
+  u8_t eof;
 
   LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("http_send: pcb=%p hs=%p left=%d\n", (void *)pcb,
               (void *)hs, hs != NULL ? (int)hs->left : 0));
@@ -1615,7 +1964,7 @@ http_send(struct altcp_pcb *pcb, struct http_state *hs)
   /* Do we have any more header data to send for this file? */
   if (hs->hdr_index < NUM_FILE_HDR_STRINGS) {
     data_to_send = http_send_headers(pcb, hs);
-    if ((data_to_send == HTTP_DATA_TO_SEND_FREED) ||
+    if ((data_to_send == HTTP_DATA_TO_SEND_FREED) || (data_to_send == HTTP_DATA_TO_SEND_NEXT) ||
         ((data_to_send != HTTP_DATA_TO_SEND_CONTINUE) &&
          (hs->hdr_index < NUM_FILE_HDR_STRINGS))) {
       return data_to_send;
@@ -1631,7 +1980,10 @@ http_send(struct altcp_pcb *pcb, struct http_state *hs)
   /* Have we run out of file data to send? If so, we need to read the next
    * block from the file. */
   if (hs->left == 0) {
-    if (!http_check_eof(pcb, hs)) {
+    eof = http_check_eof(pcb, hs);
+    if (eof == 2) {
+      return HTTP_DATA_TO_SEND_NEXT;
+    } else if (eof == 0) {
       return 0;
     }
   }
@@ -1652,13 +2004,50 @@ http_send(struct altcp_pcb *pcb, struct http_state *hs)
     /* We reached the end of the file so this request is done.
      * This adds the FIN flag right into the last data segment. */
     LWIP_DEBUGF(HTTPD_DEBUG, ("End of file.\n"));
-    http_eof(pcb, hs);
+    if (http_eof(pcb, hs)) {
+      return HTTP_DATA_TO_SEND_NEXT;
+    }
     return 0;
   }
   LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("send_data end.\n"));
   return data_to_send;
 }
 
+/**
+ * Try to send more data on this pcb.
+ * When a response is finished and the next pipelined request has been parsed,
+ * its response is sent right away.
+ *
+ * @param pcb the pcb to send data
+ * @param hs connection state
+ */
+static u8_t
+http_send(struct altcp_pcb *pcb, struct http_state *hs)
+{
+  u8_t data_to_send;
+  u8_t sent = HTTP_NO_DATA_TO_SEND;
+
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  if ((hs != NULL) && hs->keepalive && !http_is_busy(hs)) {
+    /* persistent connection waiting for the next request: nothing to send
+       (and a partially received request must be kept) */
+    return HTTP_NO_DATA_TO_SEND;
+  }
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+  for (;;) {
+    data_to_send = http_send_response(pcb, hs);
+    if (data_to_send != HTTP_DATA_TO_SEND_NEXT) {
+      break;
+    }
+    /* the finished response has been enqueued */
+    sent = HTTP_DATA_TO_SEND_CONTINUE;
+  }
+  if (data_to_send == HTTP_NO_DATA_TO_SEND) {
+    return sent;
+  }
+  return data_to_send;
+}
+
 #if LWIP_HTTPD_SUPPORT_EXTSTATUS
 /** Initialize a http connection with a file to send for an error message
  *
@@ -1974,76 +2363,1429 @@ http_continue(void *connection)
 }
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
 
-/**
- * When data has been received in the correct state, try to parse it
- * as a HTTP request.
+#if LWIP_HTTPD_CONTENT_ENCODING
+/** Parse the "Accept-Encoding" header of a request.
+ * Content codings with a quality value of 0 are not accepted, other quality
+ * values are ignored (see http_encodings for the order of preference).
  *
- * @param inp the received pbuf
- * @param hs the connection state
- * @param pcb the altcp_pcb which received this packet
- * @return ERR_OK if request was OK and hs has been initialized correctly
- *         ERR_INPROGRESS if request was OK so far but not fully received
- *         another err_t otherwise
+ * @param data the request (including the headers)
+ * @param data_len length of the request
+ * @return FS_FILE_FLAGS_ENCODING_* flags of the codings accepted
  */
-static err_t
-http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pcb)
+static u8_t
+http_parse_accept_encoding(const char *data, u16_t data_len)
 {
-  char *data;
-  char *crlf;
-  u16_t data_len;
-  struct pbuf *p = inp;
-#if LWIP_HTTPD_SUPPORT_REQUESTLIST
-  u16_t clen;
-#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
-#if LWIP_HTTPD_SUPPORT_POST
-  err_t err;
-#endif /* LWIP_HTTPD_SUPPORT_POST */
+  const char *val, *end;
+  u8_t accepted = 0, refused = 0, wildcard = 0;
+  u16_t hdr_len = (u16_t)strlen(CRLF "Accept-Encoding:");
 
-  LWIP_UNUSED_ARG(pcb); /* only used for post */
-  LWIP_ASSERT("p != NULL", p != NULL);
-  LWIP_ASSERT("hs != NULL", hs != NULL);
+  val = lwip_strnistr(data, CRLF "Accept-Encoding:", data_len);
+  if (val == NULL) {
+    return 0;
+  }
+  val += hdr_len;
+  end = lwip_strnstr(val, CRLF, data_len - (u16_t)(val - data));
+  if (end == NULL) {
+    return 0;
+  }
+  while (val < end) {
+    const char *coding;
+    size_t coding_len;
+    u8_t flag = 0;
+    u8_t q_zero = 0;
+    while ((val < end) && ((*val == ' ') || (*val == '\t') || (*val == ','))) {
+      val++;
+    }
+    coding = val;
+    while ((val < end) && (*val != ',') && (*val != ';') && (*val != ' ') && (*val != '\t')) {
+      val++;
+    }
+    coding_len = (size_t)(val - coding);
+    if ((coding_len == 2) && !lwip_strnicmp(coding, "br", 2)) {
+      flag = FS_FILE_FLAGS_ENCODING_BR;
+    } else if ((coding_len == 4) && !lwip_strnicmp(coding, "gzip", 4)) {
+      flag = FS_FILE_FLAGS_ENCODING_GZIP;
+    } else if ((coding_len == 1) && (*coding == '*')) {
+      flag = FS_FILE_FLAGS_ENCODING_BR | FS_FILE_FLAGS_ENCODING_GZIP;
+    }
+    /* parameters: look for "q=0", "q=0.0" etc. */
+    while ((val < end) && (*val != ',')) {
+      if ((*val == ';') || (*val == ' ')) {
+        const char *q = val + 1;
+        while ((q < end) && (*q == ' ')) {
+          q++;
+        }
+        if ((end - q >= 3) && ((*q == 'q') || (*q == 'Q')) && (q[1] == '=') && (q[2] == '0')) {
+          q += 3;
+          if ((q < end) && (*q == '.')) {
+            q++;
+            while ((q < end) && (*q == '0')) {
+              q++;
+            }
+          }
+          q_zero = ((q == end) || (*q == ',') || (*q == ';') || (*q == ' ')) ? 1 : 0;
+        }
+      }
+      val++;
+    }
+    if (coding_len == 1) {
+      wildcard = (u8_t)(q_zero ? 0 : flag);
+    } else if (q_zero) {
+      refused |= flag;
+    } else {
+      accepted |= flag;
+    }
+  }
+  /* '*' matches all codings not listed explicitly */
+  return (u8_t)(accepted | (wildcard & ~(accepted | refused)));
+}
+#endif /* LWIP_HTTPD_CONTENT_ENCODING */
 
-  if ((hs->handle != NULL) || (hs->file != NULL)) {
-    LWIP_DEBUGF(HTTPD_DEBUG, ("Received data while sending a file\n"));
-    /* already sending a file */
-    /* @todo: abort? */
-    return ERR_USE;
+#if HTTPD_SEND_NOT_MODIFIED || HTTPD_SEND_RANGE || LWIP_HTTPD_WEBSOCKET
+/** Get the value of a header line in a list of header lines.
+ *
+ * @param lines header lines, each terminated by CRLF
+ * @param lines_end end of the header lines
+ * @param name name of the header including the colon, e.g. "ETag:"
+ * @param value_len returns the length of the value (up to the CRLF)
+ * @return pointer to the value or NULL if the header is not found
+ */
+static const char *
+http_get_header_value(const char *lines, const char *lines_end, const char *name, u16_t *value_len)
+{
+  size_t name_len = strlen(name);
+  const char *line = lines;
+
+  while (line < lines_end) {
+    const char *eol = lwip_strnstr(line, CRLF, (size_t)(lines_end - line));
+    if (eol == NULL) {
+      eol = lines_end;
+    }
+    if (((size_t)(eol - line) >= name_len) && !lwip_strnicmp(line, name, name_len)) {
+      const char *val = line + name_len;
+      while ((val < eol) && (*val == ' ')) {
+        val++;
+      }
+      *value_len = (u16_t)(eol - val);
+      return val;
+    }
+    line = eol + 2;
   }
+  return NULL;
+}
+#endif /* HTTPD_SEND_NOT_MODIFIED || HTTPD_SEND_RANGE || LWIP_HTTPD_WEBSOCKET */
 
-#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+#if HTTPD_SEND_NOT_MODIFIED
 
-  LWIP_DEBUGF(HTTPD_DEBUG, ("Received %"U16_F" bytes\n", p->tot_len));
+/** Check if an entity tag is in the list of an "If-None-Match" header
+ * (using the weak comparison, as required for If-None-Match).
+ *
+ * @param list the value of the If-None-Match header
+ * @param list_len length of the value
+ * @param etag the entity tag of the file (including the double quotes)
+ * @param etag_len length of the entity tag
+ * @return 1 if the entity tag is in the list (or the list is "*"), 0 otherwise
+ */
+static u8_t
+http_etag_in_list(const char *list, u16_t list_len, const char *etag, u16_t etag_len)
+{
+  const char *list_end = list + list_len;
 
-  /* first check allowed characters in this pbuf? */
+  if ((etag_len >= 2) && (etag[0] == 'W') && (etag[1] == '/')) {
+    etag += 2;
+    etag_len -= 2;
+  }
+  while (list < list_end) {
+    const char *tag;
+    while ((list < list_end) && ((*list == ' ') || (*list == '\t') || (*list == ','))) {
+      list++;
+    }
+    if (list == list_end) {
+      break;
+    }
+    if (*list == '*') {
+      return 1;
+    }
+    if ((list_end - list >= 2) && (list[0] == 'W') && (list[1] == '/')) {
+      list += 2;
+    }
+    tag = list;
+    if ((list < list_end) && (*list == '"')) {
+      /* opaque-tag: may contain anything but '"' */
+      list++;
+      while ((list < list_end) && (*list != '"')) {
+        list++;
+      }
+      if (list == list_end) {
+        return 0;
+      }
+      list++;
+    } else {
+      while ((list < list_end) && (*list != ',') && (*list != ' ')) {
+        list++;
+      }
+    }
+    if (((u16_t)(list - tag) == etag_len) && !memcmp(tag, etag, etag_len)) {
+      return 1;
+    }
+  }
+  return 0;
+}
 
-  /* enqueue the pbuf */
-  if (hs->req == NULL) {
-    LWIP_DEBUGF(HTTPD_DEBUG, ("First pbuf\n"));
-    hs->req = p;
-  } else {
-    LWIP_DEBUGF(HTTPD_DEBUG, ("pbuf enqueued\n"));
-    pbuf_cat(hs->req, p);
+/** Check if a file has not been modified according to the "If-None-Match"
+ * (or "If-Modified-Since") header of the request.
+ *
+ * @param validators the validators of the file (see struct fs_file)
+ * @param hdrs the request headers (starting with CRLF after the request line)
+ * @param hdrs_len length of the request headers
+ * @return 1 if "304 Not Modified" can be sent instead of the file
+ */
+static u8_t
+http_validators_match(const char *validators, const char *hdrs, u16_t hdrs_len)
+{
+  const char *validators_end, *val, *cond;
+  u16_t val_len, cond_len;
+
+  validators_end = validators + strlen(validators);
+
+  cond = lwip_strnistr(hdrs, CRLF "If-None-Match:", hdrs_len);
+  if (cond != NULL) {
+    /* If-None-Match takes precedence over If-Modified-Since */
+    cond = http_get_header_value(cond + 2, hdrs + hdrs_len, "If-None-Match:", &cond_len);
+    val = http_get_header_value(validators, validators_end, "ETag:", &val_len);
+    return (u8_t)((cond != NULL) && (val != NULL) && http_etag_in_list(cond, cond_len, val, val_len));
   }
-  /* increase pbuf ref counter as it is freed when we return but we want to
-     keep it on the req list */
-  pbuf_ref(p);
+  cond = lwip_strnistr(hdrs, CRLF "If-Modified-Since:", hdrs_len);
+  if (cond != NULL) {
+    /* dates are compared as strings: clients send back the Last-Modified date */
+    cond = http_get_header_value(cond + 2, hdrs + hdrs_len, "If-Modified-Since:", &cond_len);
+    val = http_get_header_value(validators, validators_end, "Last-Modified:", &val_len);
+    if ((cond != NULL) && (val != NULL)) {
+      while ((cond_len > 0) && (cond[cond_len - 1] == ' ')) {
+        cond_len--;
+      }
+      return (u8_t)((cond_len == val_len) && !memcmp(cond, val, val_len));
+    }
+  }
+  return 0;
+}
 
-  if (hs->req->next != NULL) {
-    data_len = LWIP_MIN(hs->req->tot_len, LWIP_HTTPD_MAX_REQ_LENGTH);
-    pbuf_copy_partial(hs->req, httpd_req_buf, data_len, 0);
-    data = httpd_req_buf;
+/** Check if the file opened for a GET request has not been modified.
+ *
+ * @param hs http connection state with the file opened
+ * @param hdrs the request headers (starting with CRLF after the request line)
+ * @param hdrs_len length of the request headers
+ * @return 1 if "304 Not Modified" can be sent instead of the file
+ */
+static u8_t
+http_is_not_modified(struct http_state *hs, const char *hdrs, u16_t hdrs_len)
+{
+  if ((hs->handle == NULL) || (hs->handle->validators == NULL)) {
+    return 0;
+  }
+#if LWIP_HTTPD_SSI
+  if (hs->ssi != NULL) {
+    /* content is generated */
+    return 0;
+  }
+#endif /* LWIP_HTTPD_SSI */
+  if (((hs->handle->flags & FS_FILE_FLAGS_HEADER_INCLUDED) == 0) &&
+      ((hs->hdr_index >= NUM_FILE_HDR_STRINGS) ||
+       (hs->hdrs[HDR_STRINGS_IDX_HTTP_STATUS] != g_psHTTPHeaderStrings[HTTP_HDR_OK]))) {
+    /* no headers or not a "200 OK" response */
+    return 0;
+  }
+  return http_validators_match(hs->handle->validators, hdrs, hdrs_len);
+}
+
+/** Set up "304 Not Modified" with the validators of a file instead of sending
+ * the file. If the file is opened, it is closed.
+ *
+ * @param hs http connection state
+ * @param validators the validators of the file
+ * @param flags the FS_FILE_FLAGS_* of the file
+ */
+static void
+http_init_not_modified(struct http_state *hs, const char *validators, u8_t flags)
+{
+  LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Not modified\n"));
+  hs->hdrs[HDR_STRINGS_IDX_HTTP_STATUS] = g_psHTTPHeaderStrings[HTTP_HDR_NOT_MODIFIED];
+  hs->hdrs[HDR_STRINGS_IDX_SERVER_NAME] = g_psHTTPHeaderStrings[HTTP_HDR_SERVER];
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  if (hs->keepalive) {
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEEPALIVE] = g_psHTTPHeaderStrings[HTTP_HDR_CONN_KEEPALIVE];
   } else
-#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
   {
-    data = (char *)p->payload;
-    data_len = p->len;
-    if (p->len != p->tot_len) {
-      LWIP_DEBUGF(HTTPD_DEBUG, ("Warning: incomplete header due to chained pbufs\n"));
-    }
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEEPALIVE] = g_psHTTPHeaderStrings[HTTP_HDR_CONN_CLOSE];
+  }
+  hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_NR] = NULL;
+#if LWIP_HTTPD_CONTENT_ENCODING
+  hs->hdrs[HDR_STRINGS_IDX_CONTENT_ENCODING] = NULL;
+  if (flags & (FS_FILE_FLAGS_ENCODING_VARIANTS | FS_FILE_FLAGS_ENCODING_GZIP | FS_FILE_FLAGS_ENCODING_BR)) {
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_ENCODING] = HTTP_HDR_VARY_ENCODING;
   }
+#else /* LWIP_HTTPD_CONTENT_ENCODING */
+  LWIP_UNUSED_ARG(flags);
+#endif /* LWIP_HTTPD_CONTENT_ENCODING */
+  hs->hdrs[HDR_STRINGS_IDX_VALIDATORS] = validators;
+#if HTTPD_SEND_RANGE
+  hs->hdrs[HDR_STRINGS_IDX_CONTENT_RANGE] = NULL;
+#endif /* HTTPD_SEND_RANGE */
+  /* no content type, just end the headers */
+  hs->hdrs[HDR_STRINGS_IDX_CONTENT_TYPE] = CRLF;
+  hs->hdr_index = 0;
+  hs->hdr_pos = 0;
 
-  /* received enough data for minimal request? */
-  if (data_len >= MIN_REQ_LEN) {
+  /* the file is not sent */
+  if (hs->handle != NULL) {
+    fs_close(hs->handle);
+    hs->handle = NULL;
+  }
+  hs->file = NULL;
+  hs->left = 0;
+}
+
+/** Answer a conditional GET request with "304 Not Modified" without opening
+ * the file, using the validators stored in the file system (fs_get_validators).
+ * Only file names that are passed to fs_open() unchanged are checked here
+ * (no default file, no parameters, no CGI), all other files are checked by
+ * http_is_not_modified() after opening them.
+ * makefsdata creates no validators for SSI files and error pages.
+ *
+ * @param hs http connection state
+ * @param uri the requested file name
+ * @param hdrs the request headers (starting with CRLF after the request line)
+ * @param hdrs_len length of the request headers
+ * @return 1 if "304 Not Modified" is sent, 0 if the file has to be opened
+ */
+static u8_t
+http_find_not_modified(struct http_state *hs, const char *uri, const char *hdrs, u16_t hdrs_len)
+{
+  const char *validators;
+  size_t uri_len;
+  u8_t flags = 0;
+#if LWIP_HTTPD_CGI
+  int i;
+#endif /* LWIP_HTTPD_CGI */
+
+  if ((lwip_strnistr(hdrs, CRLF "If-None-Match:", hdrs_len) == NULL) &&
+      (lwip_strnistr(hdrs, CRLF "If-Modified-Since:", hdrs_len) == NULL)) {
+    /* not a conditional request */
+    return 0;
+  }
+  uri_len = strlen(uri);
+  if ((uri_len == 0) || (uri[uri_len - 1] == '/') || (strchr(uri, '?') != NULL)) {
+    /* default file or parameters */
+    return 0;
+  }
+#if LWIP_HTTPD_CGI
+  if (httpd_num_cgis && httpd_cgis) {
+    for (i = 0; i < httpd_num_cgis; i++) {
+      if (strcmp(uri, httpd_cgis[i].pcCGIName) == 0) {
+        return 0;
+      }
+    }
+  }
+#endif /* LWIP_HTTPD_CGI */
+  validators = fs_get_validators(uri, &flags);
+  if ((validators == NULL) ||
+      (flags & (FS_FILE_FLAGS_SSI | FS_FILE_FLAGS_ENCODING_GZIP | FS_FILE_FLAGS_ENCODING_BR))) {
+    return 0;
+  }
+#if LWIP_HTTPD_CONTENT_ENCODING
+  if ((flags & FS_FILE_FLAGS_ENCODING_VARIANTS) && (hs->accept_encoding != 0)) {
+    /* the variant that would be sent has its own validators */
+    size_t j;
+    for (j = 0; j < LWIP_ARRAYSIZE(http_encodings); j++) {
+      size_t suffix_len = strlen(http_encodings[j].suffix);
+      const char *variant_validators;
+      u8_t variant_flags = 0;
+      if (((hs->accept_encoding & http_encodings[j].flag) == 0) ||
+          (uri_len + suffix_len > LWIP_HTTPD_CONTENT_ENCODING_NAME_LEN)) {
+        continue;
+      }
+      MEMCPY(http_encoded_name_buf, uri, uri_len);
+      MEMCPY(&http_encoded_name_buf[uri_len], http_encodings[j].suffix, suffix_len + 1);
+      variant_validators = fs_get_validators(http_encoded_name_buf, &variant_flags);
+      if (variant_flags & http_encodings[j].flag) {
+        validators = variant_validators;
+        flags = variant_flags;
+        break;
+      }
+    }
+    if (validators == NULL) {
+      return 0;
+    }
+  }
+#endif /* LWIP_HTTPD_CONTENT_ENCODING */
+  if (!http_validators_match(validators, hdrs, hdrs_len)) {
+    return 0;
+  }
+  /* set up the default headers for this uri to check for a "200 OK" response */
+  http_init_file(hs, NULL, 0, uri, 0, NULL);
+  if (((flags & FS_FILE_FLAGS_HEADER_INCLUDED) == 0) &&
+      ((hs->hdr_index >= NUM_FILE_HDR_STRINGS) ||
+       (hs->hdrs[HDR_STRINGS_IDX_HTTP_STATUS] != g_psHTTPHeaderStrings[HTTP_HDR_OK]))) {
+    return 0;
+  }
+  http_init_not_modified(hs, validators, flags);
+  return 1;
+}
+#endif /* HTTPD_SEND_NOT_MODIFIED */
+
+#if HTTPD_SEND_RANGE
+#define HTTP_RANGE_IGNORE           0
+#define HTTP_RANGE_OK               1
+#define HTTP_RANGE_NOT_SATISFIABLE  2
+
+/** Parse the value of a "Range" header. Only a single byte range is supported,
+ * other ranges (e.g. multiple ranges) are ignored.
+ *
+ * @param val the value of the Range header
+ * @param val_len length of the value
+ * @param file_len length of the file
+ * @param first returns the first byte of the range
+ * @param last returns the last byte of the range (inclusive)
+ * @return one of HTTP_RANGE_IGNORE, HTTP_RANGE_OK or HTTP_RANGE_NOT_SATISFIABLE
+ */
+static u8_t
+http_parse_range(const char *val, u16_t val_len, u32_t file_len, u32_t *first, u32_t *last)
+{
+  const char *end = val + val_len;
+  u32_t num[2];
+  u8_t has_num[2];
+  int i;
+
+  if ((val_len < 7) || lwip_strnicmp(val, "bytes=", 6)) {
+    return HTTP_RANGE_IGNORE;
+  }
+  val += 6;
+  for (i = 0; i < 2; i++) {
+    num[i] = 0;
+    has_num[i] = 0;
+    while ((val < end) && (*val == ' ')) {
+      val++;
+    }
+    while ((val < end) && lwip_isdigit(*val)) {
+      u32_t digit = (u32_t)(*val - '0');
+      if (num[i] > (0xFFFFFFFFUL - digit) / 10) {
+        /* saturate, the file cannot be that large anyway */
+        num[i] = 0xFFFFFFFFUL;
+      } else {
+        num[i] = num[i] * 10 + digit;
+      }
+      has_num[i] = 1;
+      val++;
+    }
+    while ((val < end) && (*val == ' ')) {
+      val++;
+    }
+    if ((i == 0) && ((val == end) || (*val != '-'))) {
+      return HTTP_RANGE_IGNORE;
+    }
+    if (i == 0) {
+      val++;
+    }
+  }
+  if (val != end) {
+    /* multiple ranges or invalid */
+    return HTTP_RANGE_IGNORE;
+  }
+  if (!has_num[0]) {
+    /* suffix range: the last n bytes */
+    if (!has_num[1]) {
+      return HTTP_RANGE_IGNORE;
+    }
+    if ((num[1] == 0) || (file_len == 0)) {
+      return HTTP_RANGE_NOT_SATISFIABLE;
+    }
+    *first = (num[1] < file_len) ? (file_len - num[1]) : 0;
+    *last = file_len - 1;
+    return HTTP_RANGE_OK;
+  }
+  if (has_num[1] && (num[1] < num[0])) {
+    return HTTP_RANGE_IGNORE;
+  }
+  if (num[0] >= file_len) {
+    return HTTP_RANGE_NOT_SATISFIABLE;
+  }
+  *first = num[0];
+  *last = (has_num[1] && (num[1] < file_len)) ? num[1] : (file_len - 1);
+  return HTTP_RANGE_OK;
+}
+
+/** Check if the "If-Range" header of a request matches the file, i.e. the
+ * range may be sent (the ETag is compared using the strong comparison).
+ * Without validators, the file is always sent completely.
+ */
+static u8_t
+http_if_range_matches(struct http_state *hs, const char *cond, const char *hdrs_end)
+{
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+  const char *validators, *val;
+  u16_t val_len, cond_len;
+
+  validators = hs->handle->validators;
+  if (validators == NULL) {
+    return 0;
+  }
+  cond = http_get_header_value(cond, hdrs_end, "If-Range:", &cond_len);
+  if (cond == NULL) {
+    return 0;
+  }
+  while ((cond_len > 0) && (cond[cond_len - 1] == ' ')) {
+    cond_len--;
+  }
+  if ((cond_len > 0) && (cond[0] == '"')) {
+    val = http_get_header_value(validators, validators + strlen(validators), "ETag:", &val_len);
+  } else {
+    val = http_get_header_value(validators, validators + strlen(validators), "Last-Modified:", &val_len);
+  }
+  return (u8_t)((val != NULL) && (cond_len == val_len) && !memcmp(cond, val, val_len));
+#else /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+  LWIP_UNUSED_ARG(hs);
+  LWIP_UNUSED_ARG(cond);
+  LWIP_UNUSED_ARG(hdrs_end);
+  return 0;
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+}
+
+/** Set the "Content-Length" header slots for a response of 'len' bytes */
+static void
+http_set_content_length(struct http_state *hs, u32_t len)
+{
+  size_t len_len;
+
+  lwip_itoa(hs->hdr_content_len, (size_t)LWIP_HTTPD_MAX_CONTENT_LEN_SIZE, (int)len);
+  len_len = strlen(hs->hdr_content_len);
+  if (len_len <= LWIP_HTTPD_MAX_CONTENT_LEN_SIZE - LWIP_HTTPD_MAX_CONTENT_LEN_OFFSET) {
+    SMEMCPY(&hs->hdr_content_len[len_len], CRLF, 3);
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_NR] = hs->hdr_content_len;
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+    if (hs->keepalive) {
+      hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEEPALIVE] = g_psHTTPHeaderStrings[HTTP_HDR_KEEPALIVE_LEN];
+    } else
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+    {
+      hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEEPALIVE] = g_psHTTPHeaderStrings[HTTP_HDR_CONTENT_LENGTH];
+    }
+  } else {
+    /* no content length: the connection has to be closed */
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+    hs->keepalive = 0;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_KEEPALIVE] = g_psHTTPHeaderStrings[HTTP_HDR_CONN_CLOSE];
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_LEN_NR] = NULL;
+  }
+}
+
+/** Set the "Content-Range" header, for a satisfiable range if 'count' != 0 */
+static void
+http_set_content_range(struct http_state *hs, u32_t first, u32_t count, u32_t file_len)
+{
+  char *buf = hs->hdr_content_range;
+  size_t pos = 21;
+
+  SMEMCPY(buf, "Content-Range: bytes ", pos);
+  if (count != 0) {
+    lwip_itoa(&buf[pos], HTTPD_CONTENT_RANGE_SIZE - pos, (int)first);
+    pos += strlen(&buf[pos]);
+    buf[pos++] = '-';
+    lwip_itoa(&buf[pos], HTTPD_CONTENT_RANGE_SIZE - pos, (int)(first + count - 1));
+    pos += strlen(&buf[pos]);
+  } else {
+    buf[pos++] = '*';
+  }
+  buf[pos++] = '/';
+  lwip_itoa(&buf[pos], HTTPD_CONTENT_RANGE_SIZE - pos, (int)file_len);
+  pos += strlen(&buf[pos]);
+  SMEMCPY(&buf[pos], CRLF, 3);
+  hs->hdrs[HDR_STRINGS_IDX_CONTENT_RANGE] = buf;
+}
+
+/** Check the "Range" header of a GET request and set up the connection to send
+ * "206 Partial Content" (or "416 Range Not Satisfiable") if it applies.
+ * Only files with all data in memory and without included headers are sent
+ * partially, for all other files, the Range header is ignored.
+ *
+ * @param hs http connection state with the file opened
+ * @param hdrs the request headers (starting with CRLF after the request line)
+ * @param hdrs_len length of the request headers
+ */
+static void
+http_init_range(struct http_state *hs, const char *hdrs, u16_t hdrs_len)
+{
+  const char *range, *cond;
+  u16_t range_len;
+  u32_t file_len, first, last;
+  u8_t ret;
+
+  if ((hs->handle == NULL) || (hs->handle->data == NULL) ||
+      (hs->file != hs->handle->data) || (fs_bytes_left(hs->handle) > 0) ||
+      (hs->handle->flags & FS_FILE_FLAGS_HEADER_INCLUDED) ||
+      (hs->hdr_index >= NUM_FILE_HDR_STRINGS) ||
+      (hs->hdrs[HDR_STRINGS_IDX_HTTP_STATUS] != g_psHTTPHeaderStrings[HTTP_HDR_OK])) {
+    /* not a "200 OK" response for a file in memory */
+    return;
+  }
+#if LWIP_HTTPD_SSI
+  if (hs->ssi != NULL) {
+    /* content is generated */
+    return;
+  }
+#endif /* LWIP_HTTPD_SSI */
+  range = lwip_strnistr(hdrs, CRLF "Range:", hdrs_len);
+  if (range == NULL) {
+    return;
+  }
+  range = http_get_header_value(range + 2, hdrs + hdrs_len, "Range:", &range_len);
+  if (range == NULL) {
+    return;
+  }
+  cond = lwip_strnistr(hdrs, CRLF "If-Range:", hdrs_len);
+  if ((cond != NULL) && !http_if_range_matches(hs, cond + 2, hdrs + hdrs_len)) {
+    /* the file has changed: send it completely */
+    return;
+  }
+  file_len = (u32_t)hs->handle->len;
+  ret = http_parse_range(range, range_len, file_len, &first, &last);
+  if (ret == HTTP_RANGE_OK) {
+    u32_t count = last - first + 1;
+    LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Sending range %"U32_F"-%"U32_F"\n", first, last));
+    hs->hdrs[HDR_STRINGS_IDX_HTTP_STATUS] = g_psHTTPHeaderStrings[HTTP_HDR_PARTIAL_11];
+    http_set_content_length(hs, count);
+    http_set_content_range(hs, first, count, file_len);
+    hs->file += first;
+    hs->left = (int)count;
+  } else if (ret == HTTP_RANGE_NOT_SATISFIABLE) {
+    LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Range not satisfiable\n"));
+    hs->hdrs[HDR_STRINGS_IDX_HTTP_STATUS] = g_psHTTPHeaderStrings[HTTP_HDR_RANGE_NOT_SATISFIABLE_11];
+    http_set_content_length(hs, 0);
+    http_set_content_range(hs, 0, 0, file_len);
+#if LWIP_HTTPD_CONTENT_ENCODING
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_ENCODING] = NULL;
+#endif /* LWIP_HTTPD_CONTENT_ENCODING */
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+    hs->hdrs[HDR_STRINGS_IDX_VALIDATORS] = NULL;
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+    /* no content type, just end the headers */
+    hs->hdrs[HDR_STRINGS_IDX_CONTENT_TYPE] = CRLF;
+
+    /* the file is not sent */
+    fs_close(hs->handle);
+    hs->handle = NULL;
+    hs->file = NULL;
+    hs->left = 0;
+  }
+}
+#endif /* HTTPD_SEND_RANGE */
+
+#if LWIP_HTTPD_WEBSOCKET
+#define HTTPD_WS_ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+/** Process one 64-byte block of SHA-1 */
+static void
+http_ws_sha1_block(u32_t *h, const u8_t *blk)
+{
+  u32_t w[16];
+  u32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+  int i;
+
+  for (i = 0; i < 16; i++) {
+    w[i] = ((u32_t)blk[4 * i] << 24) | ((u32_t)blk[4 * i + 1] << 16) |
+           ((u32_t)blk[4 * i + 2] << 8) | (u32_t)blk[4 * i + 3];
+  }
+  for (i = 0; i < 80; i++) {
+    u32_t f, t;
+    if (i >= 16) {
+      t = w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15];
+      w[i & 15] = HTTPD_WS_ROL(t, 1);
+    }
+    if (i < 20) {
+      f = ((b & c) | (~b & d)) + 0x5A827999UL;
+    } else if (i < 40) {
+      f = (b ^ c ^ d) + 0x6ED9EBA1UL;
+    } else if (i < 60) {
+      f = ((b & c) | (b & d) | (c & d)) + 0x8F1BBCDCUL;
+    } else {
+      f = (b ^ c ^ d) + 0xCA62C1D6UL;
+    }
+    t = HTTPD_WS_ROL(a, 5) + f + e + w[i & 15];
+    e = d;
+    d = c;
+    c = HTTPD_WS_ROL(b, 30);
+    b = a;
+    a = t;
+  }
+  h[0] += a;
+  h[1] += b;
+  h[2] += c;
+  h[3] += d;
+  h[4] += e;
+}
+
+/** Calculate the "Sec-WebSocket-Accept" value for a "Sec-WebSocket-Key":
+ * base64(SHA-1(key + GUID))
+ *
+ * @param key the key sent by the client
+ * @param key_len length of the key (at most 64 bytes)
+ * @param accept returns the value (28 characters and a terminating NULL byte)
+ */
+static void
+http_ws_accept_key(const char *key, u16_t key_len, char *accept)
+{
+  static const char guid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+  static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  u8_t msg[128];
+  u8_t digest[21];
+  u32_t h[5];
+  u16_t len = (u16_t)(key_len + sizeof(guid) - 1);
+  u16_t blocks, i;
+
+  LWIP_ASSERT("key too long", key_len <= 64);
+  /* message with padding and length in bits fits into 2 blocks */
+  memset(msg, 0, sizeof(msg));
+  MEMCPY(msg, key, key_len);
+  MEMCPY(&msg[key_len], guid, sizeof(guid) - 1);
+  msg[len] = 0x80;
+  blocks = (u16_t)((len + 8) / 64 + 1);
+  msg[blocks * 64 - 2] = (u8_t)((len * 8) >> 8);
+  msg[blocks * 64 - 1] = (u8_t)(len * 8);
+  h[0] = 0x67452301UL;
+  h[1] = 0xEFCDAB89UL;
+  h[2] = 0x98BADCFEUL;
+  h[3] = 0x10325476UL;
+  h[4] = 0xC3D2E1F0UL;
+  for (i = 0; i < blocks; i++) {
+    http_ws_sha1_block(h, &msg[i * 64]);
+  }
+  for (i = 0; i < 20; i++) {
+    digest[i] = (u8_t)(h[i / 4] >> (24 - 8 * (i % 4)));
+  }
+  digest[20] = 0;
+  for (i = 0; i < 7; i++) {
+    u32_t v = ((u32_t)digest[3 * i] << 16) | ((u32_t)digest[3 * i + 1] << 8) | digest[3 * i + 2];
+    accept[4 * i] = b64[(v >> 18) & 0x3F];
+    accept[4 * i + 1] = b64[(v >> 12) & 0x3F];
+    accept[4 * i + 2] = b64[(v >> 6) & 0x3F];
+    accept[4 * i + 3] = b64[v & 0x3F];
+  }
+  /* 20 bytes encode to 27 characters and one padding character */
+  accept[27] = '=';
+  accept[28] = 0;
+}
+
+/** Get the value of a request header
+ *
+ * @param data the request (including the headers)
+ * @param data_len length of the request
+ * @param name the name of the header including CRLF in front and the colon
+ * @param value_len returns the length of the value (trailing spaces removed)
+ */
+static const char *
+http_ws_get_header(const char *data, u16_t data_len, const char *name, u16_t *value_len)
+{
+  const char *hdr = lwip_strnistr(data, name, data_len);
+  const char *val;
+
+  if (hdr == NULL) {
+    return NULL;
+  }
+  val = http_get_header_value(hdr + 2, data + data_len, name + 2, value_len);
+  if (val != NULL) {
+    while ((*value_len > 0) && (val[*value_len - 1] == ' ')) {
+      (*value_len)--;
+    }
+  }
+  return val;
+}
+
+/** Queue a frame to be sent on a WebSocket. The frame header is prepended in
+ * the headroom of 'p' if possible, the data is not copied.
+ *
+ * @param hs http connection state
+ * @param b0 first byte of the frame header (FIN and opcode)
+ * @param p the payload (taken over on ERR_OK) or NULL
+ * @return ERR_OK if the frame has been queued, ERR_MEM otherwise
+ */
+static err_t
+http_ws_queue_frame(struct http_state *hs, u8_t b0, struct pbuf *p)
+{
+  u16_t len = (p != NULL) ? p->tot_len : 0;
+  u16_t hdr_len = (len < 126) ? 2 : 4;
+  struct pbuf *frame = p;
+  u8_t *hdr;
+
+  if ((u32_t)len + hdr_len + ((hs->ws_tx != NULL) ? hs->ws_tx->tot_len : 0) > 0xFFFF) {
+    return ERR_MEM;
+  }
+  if ((p == NULL) || pbuf_add_header(p, hdr_len)) {
+    /* no headroom: chain a pbuf for the header */
+    frame = pbuf_alloc(PBUF_RAW, hdr_len, PBUF_RAM);
+    if (frame == NULL) {
+      return ERR_MEM;
+    }
+    if (p != NULL) {
+      pbuf_cat(frame, p);
+    }
+  }
+  hdr = (u8_t *)frame->payload;
+  hdr[0] = b0;
+  if (hdr_len == 2) {
+    hdr[1] = (u8_t)len;
+  } else {
+    hdr[1] = 126;
+    hdr[2] = (u8_t)(len >> 8);
+    hdr[3] = (u8_t)len;
+  }
+  if (hs->ws_tx == NULL) {
+    hs->ws_tx = frame;
+  } else {
+    pbuf_cat(hs->ws_tx, frame);
+  }
+  return ERR_OK;
+}
+
+/** Queue a close frame and stop passing data to the application */
+static void
+http_ws_queue_close(struct http_state *hs, u16_t status)
+{
+  struct pbuf *p = NULL;
+
+  if (status != 0) {
+    p = pbuf_alloc(PBUF_RAW, 2, PBUF_RAM);
+    if (p != NULL) {
+      ((u8_t *)p->payload)[0] = (u8_t)(status >> 8);
+      ((u8_t *)p->payload)[1] = (u8_t)status;
+    }
+  }
+  if (http_ws_queue_frame(hs, HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_CLOSE, p) != ERR_OK) {
+    if (p != NULL) {
+      pbuf_free(p);
+    }
+    /* cannot send a close frame: close when the queued data has been sent */
+    hs->ws_close_received = 1;
+  }
+  hs->ws_state = HTTPD_WS_STATE_CLOSING;
+}
+
+/** Pass the queued data of a WebSocket to the pcb (without copying it) */
+static void
+http_ws_output(struct altcp_pcb *pcb, struct http_state *hs)
+{
+  struct pbuf *q = hs->ws_tx;
+  u16_t offset = hs->ws_tx_written;
+  u8_t written = 0;
+
+  /* skip the data passed to the pcb already */
+  while ((q != NULL) && (offset >= q->len)) {
+    offset = (u16_t)(offset - q->len);
+    q = q->next;
+  }
+  while (q != NULL) {
+    u16_t len = (u16_t)(q->len - offset);
+    u16_t sndbuf = altcp_sndbuf(pcb);
+    if (len > 0) {
+      if (sndbuf == 0) {
+        break;
+      }
+      if (len > sndbuf) {
+        len = sndbuf;
+      }
+      if (altcp_write(pcb, (const u8_t *)q->payload + offset, len,
+                      (q->next != NULL) ? TCP_WRITE_FLAG_MORE : 0) != ERR_OK) {
+        break;
+      }
+      hs->ws_tx_written = (u16_t)(hs->ws_tx_written + len);
+      written = 1;
+    }
+    offset = (u16_t)(offset + len);
+    if (offset == q->len) {
+      q = q->next;
+      offset = 0;
+    }
+  }
+  if (written) {
+    altcp_output(pcb);
+  }
+}
+
+/** Close the connection when the closing handshake is complete
+ *
+ * @return 1 if the connection has been closed (hs is freed)
+ */
+static u8_t
+http_ws_check_close(struct altcp_pcb *pcb, struct http_state *hs)
+{
+  if (((hs->ws_state == HTTPD_WS_STATE_CLOSING) && hs->ws_close_received && (hs->ws_tx == NULL)) ||
+      ((hs->ws_state == HTTPD_WS_STATE_CLOSED) && (hs->ws_tx_written == 0))) {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("WebSocket closed\n"));
+    http_close_conn(pcb, hs);
+    return 1;
+  }
+  return 0;
+}
+
+/** Fail a WebSocket connection: send a close frame and close the connection
+ * when it has been sent
+ *
+ * @return 1 if the connection has been closed (hs is freed)
+ */
+static u8_t
+http_ws_fail(struct altcp_pcb *pcb, struct http_state *hs, u16_t status)
+{
+  LWIP_DEBUGF(HTTPD_DEBUG, ("WebSocket error %"U16_F"\n", status));
+  if (hs->ws_rx != NULL) {
+    altcp_recved(pcb, hs->ws_rx->tot_len);
+    pbuf_free(hs->ws_rx);
+    hs->ws_rx = NULL;
+  }
+  if (hs->ws_state == HTTPD_WS_STATE_OPEN) {
+    http_ws_queue_close(hs, status);
+  }
+  hs->ws_close_received = 1;
+  http_ws_output(pcb, hs);
+  return http_ws_check_close(pcb, hs);
+}
+
+/* UTF-8 decoder state: the number of continuation bytes still expected
+   (bits 0-1) and the range allowed for the next one (bits 2-4) */
+#define HTTPD_WS_UTF8_NEED(s)     ((s) & 3)
+#define HTTPD_WS_UTF8_STATE(n, r) ((u8_t)((n) | ((r) << 2)))
+#define HTTPD_WS_UTF8_INVALID     0xFF
+
+/** Check (a part of) a text message for valid UTF-8 (RFC 3629): overlong
+ * encodings, surrogates and code points above U+10FFFF are rejected. A
+ * character may span frames, the state is carried over.
+ *
+ * @param state decoder state after the previous part (0 at the start)
+ * @param p the (unmasked) data
+ * @return the new decoder state or HTTPD_WS_UTF8_INVALID
+ */
+static u8_t
+http_ws_utf8_check(u8_t state, const struct pbuf *p)
+{
+  /* ranges allowed for the first continuation byte after E0, ED, F0 and F4 */
+  static const u8_t lo[5] = {0x80, 0xA0, 0x80, 0x90, 0x80};
+  static const u8_t hi[5] = {0xBF, 0xBF, 0x9F, 0xBF, 0x8F};
+  u16_t i;
+
+  for (; p != NULL; p = p->next) {
+    const u8_t *data = (const u8_t *)p->payload;
+    for (i = 0; i < p->len; i++) {
+      u8_t c = data[i];
+      if (HTTPD_WS_UTF8_NEED(state) != 0) {
+        u8_t range = (u8_t)(state >> 2);
+        if ((c < lo[range]) || (c > hi[range])) {
+          return HTTPD_WS_UTF8_INVALID;
+        }
+        state = HTTPD_WS_UTF8_STATE(HTTPD_WS_UTF8_NEED(state) - 1, 0);
+      } else if (c < 0x80) {
+        /* ASCII */
+      } else if ((c >= 0xC2) && (c <= 0xDF)) {
+        state = HTTPD_WS_UTF8_STATE(1, 0);
+      } else if ((c >= 0xE0) && (c <= 0xEF)) {
+        state = HTTPD_WS_UTF8_STATE(2, (c == 0xE0) ? 1 : ((c == 0xED) ? 2 : 0));
+      } else if ((c >= 0xF0) && (c <= 0xF4)) {
+        state = HTTPD_WS_UTF8_STATE(3, (c == 0xF0) ? 3 : ((c == 0xF4) ? 4 : 0));
+      } else {
+        return HTTPD_WS_UTF8_INVALID;
+      }
+    }
+  }
+  return state;
+}
+
+/** Handle a received (unmasked) frame
+ *
+ * @return 1 if the connection has been closed (hs is freed)
+ */
+static u8_t
+http_ws_frame_received(struct altcp_pcb *pcb, struct http_state *hs, u8_t b0, struct pbuf *p)
+{
+  switch (b0 & 0x0F) {
+    case HTTPD_WEBSOCKET_CONTINUATION:
+    case HTTPD_WEBSOCKET_TEXT:
+    case HTTPD_WEBSOCKET_BINARY:
+      if (((b0 & 0x0F) == HTTPD_WEBSOCKET_CONTINUATION) != (hs->ws_rx_fragmented != 0)) {
+        /* continuation without a message started or a new message before the
+           last one has been finished */
+        if (p != NULL) {
+          pbuf_free(p);
+        }
+        http_ws_fail(pcb, hs, 1002);
+        return 1;
+      }
+      hs->ws_rx_fragmented = (u8_t)((b0 & HTTPD_WEBSOCKET_FIN) == 0);
+      if ((b0 & 0x0F) != HTTPD_WEBSOCKET_CONTINUATION) {
+        hs->ws_rx_text = (u8_t)((b0 & 0x0F) == HTTPD_WEBSOCKET_TEXT);
+        hs->ws_rx_utf8 = 0;
+      }
+      if (hs->ws_state == HTTPD_WS_STATE_OPEN) {
+        if (hs->ws_rx_text) {
+          if (p != NULL) {
+            hs->ws_rx_utf8 = http_ws_utf8_check(hs->ws_rx_utf8, p);
+          }
+          if ((hs->ws_rx_utf8 == HTTPD_WS_UTF8_INVALID) ||
+              ((b0 & HTTPD_WEBSOCKET_FIN) && (hs->ws_rx_utf8 != 0))) {
+            /* invalid or incomplete UTF-8 in a text message (RFC 6455 section 8.1) */
+            if (p != NULL) {
+              pbuf_free(p);
+            }
+            http_ws_fail(pcb, hs, 1007);
+            return 1;
+          }
+        }
+        httpd_websocket_receive(hs, (u8_t)(b0 & (HTTPD_WEBSOCKET_FIN | 0x0F)), p);
+        return 0;
+      }
+      break;
+    case HTTPD_WEBSOCKET_PING:
+      /* answer with the same payload */
+      if ((hs->ws_state == HTTPD_WS_STATE_OPEN) &&
+          (http_ws_queue_frame(hs, HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_PONG, p) == ERR_OK)) {
+        http_ws_output(pcb, hs);
+        return 0;
+      }
+      break;
+    case HTTPD_WEBSOCKET_PONG:
+      break;
+    case HTTPD_WEBSOCKET_CLOSE:
+      hs->ws_close_received = 1;
+      if (hs->ws_state == HTTPD_WS_STATE_OPEN) {
+        /* echo the status code */
+        u16_t status = 1000;
+        if ((p != NULL) && (p->tot_len >= 2)) {
+          status = (u16_t)((pbuf_get_at(p, 0) << 8) | pbuf_get_at(p, 1));
+        }
+        http_ws_queue_close(hs, status);
+        http_ws_output(pcb, hs);
+      }
+      if (p != NULL) {
+        pbuf_free(p);
+      }
+      return http_ws_check_close(pcb, hs);
+    default:
+      if (p != NULL) {
+        pbuf_free(p);
+      }
+      http_ws_fail(pcb, hs, 1002);
+      return 1;
+  }
+  if (p != NULL) {
+    pbuf_free(p);
+  }
+  return 0;
+}
+
+#if LWIP_SUPPORT_CUSTOM_PBUF
+/** A PBUF_REF pointing into another pbuf, holding a reference on it */
+typedef struct _http_ws_pbuf_ref
+{
+  struct pbuf_custom pc;
+  struct pbuf *original;
+} http_ws_pbuf_ref_t;
+
+/** Free a http_ws_pbuf_ref_t and its reference on the original pbuf */
+static void
+http_ws_pbuf_ref_free(struct pbuf *p)
+{
+  http_ws_pbuf_ref_t *ref = (http_ws_pbuf_ref_t *)p;
+  pbuf_free(ref->original);
+  mem_free(ref);
+}
+#endif /* LWIP_SUPPORT_CUSTOM_PBUF */
+
+/** Split a pbuf chain after 'len' bytes. The data is not copied: a pbuf
+ * containing the split offset is referenced by both parts (without custom pbuf
+ * support, the rest of that single pbuf is copied).
+ *
+ * @param p pbuf chain to split, shortened to 'len' bytes on success
+ * @param len number of bytes to keep in 'p' (0 < len < p->tot_len)
+ * @return the data following the first 'len' bytes, NULL if out of memory
+ */
+static struct pbuf *
+http_ws_pbuf_split(struct pbuf *p, u16_t len)
+{
+  u16_t rest_len = (u16_t)(p->tot_len - len);
+  u16_t off = len;
+  struct pbuf *q = p;
+  struct pbuf *rest;
+
+  LWIP_ASSERT("invalid split offset", (len > 0) && (len < p->tot_len));
+  /* find the pbuf containing the last byte to keep */
+  while (off > q->len) {
+    off = (u16_t)(off - q->len);
+    q = q->next;
+  }
+  if (off == q->len) {
+    rest = q->next;
+  } else {
+#if LWIP_SUPPORT_CUSTOM_PBUF
+    http_ws_pbuf_ref_t *ref = (http_ws_pbuf_ref_t *)mem_malloc(sizeof(http_ws_pbuf_ref_t));
+    if (ref == NULL) {
+      return NULL;
+    }
+    ref->pc.custom_free_function = http_ws_pbuf_ref_free;
+    ref->original = q;
+    pbuf_ref(q);
+    rest = pbuf_alloced_custom(PBUF_RAW, (u16_t)(q->len - off), PBUF_REF, &ref->pc,
+                               (u8_t *)q->payload + off, (u16_t)(q->len - off));
+#else /* LWIP_SUPPORT_CUSTOM_PBUF */
+    rest = pbuf_alloc(PBUF_RAW, (u16_t)(q->len - off), PBUF_RAM);
+    if (rest == NULL) {
+      return NULL;
+    }
+    MEMCPY(rest->payload, (u8_t *)q->payload + off, rest->len);
+#endif /* LWIP_SUPPORT_CUSTOM_PBUF */
+    if (q->next != NULL) {
+      pbuf_cat(rest, q->next);
+    }
+    q->len = off;
+  }
+  q->next = NULL;
+  for (; p != NULL; p = p->next) {
+    p->tot_len = (u16_t)(p->tot_len - rest_len);
+  }
+  return rest;
+}
+
+/** Parse the frames received on a WebSocket. The payload is unmasked in place
+ * and passed on as (part of) the received pbuf chain: data following a frame
+ * is split off by reference, not copied. The data is passed to altcp_recved()
+ * when a frame has been consumed, so the receive window limits the data queued
+ * in ws_rx. If memory runs out, the frames are parsed again by http_poll().
+ *
+ * @return 1 if the connection has been closed (hs is freed)
+ */
+static u8_t
+http_ws_parse(struct altcp_pcb *pcb, struct http_state *hs)
+{
+  while (hs->ws_rx != NULL) {
+    struct pbuf *rx = hs->ws_rx;
+    struct pbuf *q;
+    u8_t b0, b1, mask[4];
+    u16_t hdr_len = 2, i;
+    u32_t len, offset;
+
+    if (rx->tot_len < 2) {
+      return 0;
+    }
+    b0 = pbuf_get_at(rx, 0);
+    b1 = pbuf_get_at(rx, 1);
+    if (((b1 & 0x80) == 0) || (b0 & 0x70)) {
+      /* client frames must be masked, no extensions are negotiated */
+      return http_ws_fail(pcb, hs, 1002);
+    }
+    len = b1 & 0x7F;
+    if (len == 126) {
+      hdr_len = 4;
+      if (rx->tot_len < hdr_len) {
+        return 0;
+      }
+      len = ((u32_t)pbuf_get_at(rx, 2) << 8) | pbuf_get_at(rx, 3);
+    } else if (len == 127) {
+      hdr_len = 10;
+      if (rx->tot_len < hdr_len) {
+        return 0;
+      }
+      len = 0;
+      for (i = 2; i < 10; i++) {
+        if ((i < 6) && (pbuf_get_at(rx, i) != 0)) {
+          return http_ws_fail(pcb, hs, 1009);
+        }
+        len = (len << 8) | pbuf_get_at(rx, i);
+      }
+    }
+    if ((b0 & 0x08) && ((len > 125) || ((b0 & HTTPD_WEBSOCKET_FIN) == 0))) {
+      /* control frames must not be fragmented */
+      return http_ws_fail(pcb, hs, 1002);
+    }
+    if (len > HTTPD_WS_MAX_RX_LEN) {
+      return http_ws_fail(pcb, hs, 1009);
+    }
+    if (rx->tot_len < hdr_len + 4 + len) {
+      /* wait for the rest of the frame */
+      return 0;
+    }
+    if ((rx->tot_len > hdr_len + 4 + len) && (len != 0)) {
+      /* split off the data following this frame before changing ws_rx, so
+         nothing is lost if that fails (the frame is tried again later) */
+      struct pbuf *rest = http_ws_pbuf_split(rx, (u16_t)(hdr_len + 4 + len));
+      if (rest == NULL) {
+        return 0;
+      }
+      hs->ws_rx = rest;
+    } else {
+      hs->ws_rx = NULL;
+    }
+    pbuf_copy_partial(rx, mask, 4, hdr_len);
+    altcp_recved(pcb, (u16_t)(hdr_len + 4 + len));
+    /* strip the header */
+    rx = pbuf_free_header(rx, (u16_t)(hdr_len + 4));
+    if ((rx != NULL) && (len == 0)) {
+      /* no payload: what is left is the next frame */
+      hs->ws_rx = rx;
+      rx = NULL;
+    }
+    /* unmask in place */
+    offset = 0;
+    for (q = rx; q != NULL; q = q->next) {
+      u8_t *data = (u8_t *)q->payload;
+      for (i = 0; i < q->len; i++) {
+        data[i] ^= mask[offset & 3];
+        offset++;
+      }
+    }
+    if (http_ws_frame_received(pcb, hs, b0, rx)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/** Queue received WebSocket data and parse it */
+static void
+http_ws_recv(struct altcp_pcb *pcb, struct http_state *hs, struct pbuf *p)
+{
+  if ((hs->ws_state != HTTPD_WS_STATE_OPEN) && hs->ws_close_received) {
+    /* closing handshake done, drop anything else */
+    altcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return;
+  }
+  if (hs->ws_rx == NULL) {
+    hs->ws_rx = p;
+  } else if ((u32_t)hs->ws_rx->tot_len + p->tot_len <= 0xFFFF) {
+    pbuf_cat(hs->ws_rx, p);
+  } else {
+    altcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    http_ws_fail(pcb, hs, 1009);
+    return;
+  }
+  http_ws_parse(pcb, hs);
+}
+
+/** Upgrade the connection if a GET request contains "Upgrade: websocket"
+ *
+ * @param hs http connection state
+ * @param uri the requested URI
+ * @param data the request (passed to httpd_websocket_accept())
+ * @param data_len length of the request
+ * @param hdrs the request headers, starting with the CRLF of the request line
+ * @param hdrs_len length of the request headers
+ * @return 1 if the connection has been upgraded, 0 if the request is handled as
+ *         a normal GET request, 2 for a bad request
+ */
+static u8_t
+http_ws_upgrade(struct http_state *hs, const char *uri, const char *data, u16_t data_len,
+                const char *hdrs, u16_t hdrs_len)
+{
+  static const char response1[] = "HTTP/1.1 101 Switching Protocols" CRLF
+                                  "Upgrade: websocket" CRLF
+                                  "Connection: Upgrade" CRLF
+                                  "Sec-WebSocket-Accept: ";
+  const char *key, *version, *upgrade;
+  u16_t key_len, version_len, upgrade_len;
+  struct pbuf *p;
+  char *buf;
+
+  upgrade = http_ws_get_header(hdrs, hdrs_len, CRLF "Upgrade:", &upgrade_len);
+  if ((upgrade == NULL) || (lwip_strnistr(upgrade, "websocket", upgrade_len) == NULL)) {
+    return 0;
+  }
+  version = http_ws_get_header(hdrs, hdrs_len, CRLF "Sec-WebSocket-Version:", &version_len);
+  key = http_ws_get_header(hdrs, hdrs_len, CRLF "Sec-WebSocket-Key:", &key_len);
+  if ((version == NULL) || (version_len != 2) || strncmp(version, "13", 2) ||
+      (key == NULL) || (key_len == 0) || (key_len > 64)) {
+    return 2;
+  }
+  p = pbuf_alloc(PBUF_RAW, (u16_t)(sizeof(response1) - 1 + 28 + 4), PBUF_RAM);
+  if (p == NULL) {
+    return 2;
+  }
+  buf = (char *)p->payload;
+  MEMCPY(buf, response1, sizeof(response1) - 1);
+  buf += sizeof(response1) - 1;
+  http_ws_accept_key(key, key_len, buf);
+  MEMCPY(buf + 28, CRLF CRLF, 4);
+
+  LWIP_ASSERT("ws_tx == NULL", hs->ws_tx == NULL);
+  hs->ws_tx = p;
+  hs->ws_state = HTTPD_WS_STATE_OPEN;
+  if (httpd_websocket_accept(hs, uri, data, data_len) != ERR_OK) {
+    hs->ws_state = HTTPD_WS_STATE_NONE;
+    pbuf_free(hs->ws_tx);
+    hs->ws_tx = NULL;
+    return 0;
+  }
+  LWIP_DEBUGF(HTTPD_DEBUG, ("WebSocket opened for \"%s\"\n", uri));
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  hs->keepalive = 0;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if HTTPD_PIPELINING
+  if (hs->pipeline != NULL) {
+    /* a client must wait for the response before sending frames */
+    pbuf_free(hs->pipeline);
+    hs->pipeline = NULL;
+  }
+#endif /* HTTPD_PIPELINING */
+  return 1;
+}
+
+/**
+ * @ingroup httpd
+ * Allocate a pbuf for data to send with httpd_websocket_send(), with room for
+ * the frame header in front of the data.
+ *
+ * @param len length of the data
+ * @return the pbuf or NULL if out of memory
+ */
+struct pbuf *
+httpd_websocket_alloc(u16_t len)
+{
+  struct pbuf *p;
+
+  if (len > 0xFFFF - HTTPD_WEBSOCKET_HEADER_LEN) {
+    return NULL;
+  }
+  p = pbuf_alloc(PBUF_RAW, (u16_t)(len + HTTPD_WEBSOCKET_HEADER_LEN), PBUF_RAM);
+  if (p != NULL) {
+    pbuf_remove_header(p, HTTPD_WEBSOCKET_HEADER_LEN);
+  }
+  return p;
+}
+
+/**
+ * @ingroup httpd
+ * Send a message (a single frame) on a WebSocket.
+ * The data is not copied: the frame header is prepended in the headroom of the
+ * pbuf (see httpd_websocket_alloc()) or in a chained pbuf and the pbuf is
+ * freed when the data has been acknowledged.
+ *
+ * @param connection Unique connection identifier.
+ * @param opcode HTTPD_WEBSOCKET_TEXT, HTTPD_WEBSOCKET_BINARY or HTTPD_WEBSOCKET_PING
+ * @param p the data to send, taken over by httpd on ERR_OK (must not be
+ *        changed afterwards), NULL to send an empty frame
+ * @return ERR_OK if the frame has been queued,
+ *         ERR_CONN if the connection is not an open WebSocket,
+ *         ERR_MEM if too much data is queued (p is not freed)
+ */
+err_t
+httpd_websocket_send(void *connection, u8_t opcode, struct pbuf *p)
+{
+  struct http_state *hs = (struct http_state *)connection;
+  err_t err;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("httpd_websocket_send: invalid opcode", (opcode == HTTPD_WEBSOCKET_TEXT) ||
+             (opcode == HTTPD_WEBSOCKET_BINARY) || (opcode == HTTPD_WEBSOCKET_PING), return ERR_ARG;);
+  if ((hs == NULL) || (hs->pcb == NULL) || (hs->ws_state != HTTPD_WS_STATE_OPEN)) {
+    return ERR_CONN;
+  }
+  err = http_ws_queue_frame(hs, (u8_t)(HTTPD_WEBSOCKET_FIN | opcode), p);
+  if (err == ERR_OK) {
+    http_ws_output(hs->pcb, hs);
+  }
+  return err;
+}
+
+/**
+ * @ingroup httpd
+ * Start closing a WebSocket: a close frame is sent and the connection is
+ * closed when the client has answered it.
+ *
+ * @param connection Unique connection identifier.
+ * @param status status code to send (e.g. 1000 for a normal closure) or 0
+ * @return ERR_OK or ERR_CONN if the connection is not an open WebSocket
+ */
+err_t
+httpd_websocket_close(void *connection, u16_t status)
+{
+  struct http_state *hs = (struct http_state *)connection;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  if ((hs == NULL) || (hs->pcb == NULL) || (hs->ws_state != HTTPD_WS_STATE_OPEN)) {
+    return ERR_CONN;
+  }
+  http_ws_queue_close(hs, status);
+  http_ws_output(hs->pcb, hs);
+  return ERR_OK;
+}
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
+/**
+ * When data has been received in the correct state, try to parse it
+ * as a HTTP request.
+ *
+ * @param inp the received pbuf
+ * @param hs the connection state
+ * @param pcb the altcp_pcb which received this packet
+ * @return ERR_OK if request was OK and hs has been initialized correctly
+ *         ERR_INPROGRESS if request was OK so far but not fully received
+ *         another err_t otherwise
+ */
+static err_t
+http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pcb)
+{
+  char *data;
+  char *crlf;
+  u16_t data_len;
+  struct pbuf *p = inp;
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+  u16_t clen;
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+#if LWIP_HTTPD_SUPPORT_POST
+  err_t err;
+#endif /* LWIP_HTTPD_SUPPORT_POST */
+
+  LWIP_UNUSED_ARG(pcb); /* only used for post */
+  LWIP_ASSERT("p != NULL", p != NULL);
+  LWIP_ASSERT("hs != NULL", hs != NULL);
+
+  if ((hs->handle != NULL) || (hs->file != NULL)) {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("Received data while sending a file\n"));
+    /* already sending a file */
+    /* @todo: abort? */
+    return ERR_USE;
+  }
+
+#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+
+  LWIP_DEBUGF(HTTPD_DEBUG, ("Received %"U16_F" bytes\n", p->tot_len));
+
+  /* first check allowed characters in this pbuf? */
+
+  /* enqueue the pbuf */
+  if (hs->req == NULL) {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("First pbuf\n"));
+    hs->req = p;
+  } else {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("pbuf enqueued\n"));
+    pbuf_cat(hs->req, p);
+  }
+  /* increase pbuf ref counter as it is freed when we return but we want to
+     keep it on the req list */
+  pbuf_ref(p);
+
+  if (hs->req->next != NULL) {
+    data_len = LWIP_MIN(hs->req->tot_len, LWIP_HTTPD_MAX_REQ_LENGTH);
+    pbuf_copy_partial(hs->req, httpd_req_buf, data_len, 0);
+    data = httpd_req_buf;
+  } else
+#endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+  {
+    data = (char *)p->payload;
+    data_len = p->len;
+    if (p->len != p->tot_len) {
+      LWIP_DEBUGF(HTTPD_DEBUG, ("Warning: incomplete header due to chained pbufs\n"));
+    }
+  }
+
+  /* received enough data for minimal request? */
+  if (data_len >= MIN_REQ_LEN) {
     /* wait for CRLF before parsing anything */
     crlf = lwip_strnstr(data, CRLF, data_len);
     if (crlf != NULL) {
@@ -2094,8 +3836,20 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
       uri_len = (u16_t)(sp2 - (sp1 + 1));
       if ((sp2 != NULL) && (sp2 > sp1)) {
         /* wait for CRLFCRLF (indicating end of HTTP headers) before parsing anything */
-        if (lwip_strnstr(data, CRLF CRLF, data_len) != NULL) {
+        char *hdrs_end = lwip_strnstr(data, CRLF CRLF, data_len);
+        if (hdrs_end != NULL) {
           char *uri = sp1 + 1;
+#if HTTPD_PIPELINING
+#if LWIP_HTTPD_SUPPORT_POST
+          if (!is_post)
+#endif /* LWIP_HTTPD_SUPPORT_POST */
+          {
+            /* keep pipelined requests following this one and
+               only look at the headers of this request */
+            data_len = (u16_t)(hdrs_end + 4 - data);
+            http_pipeline_save(hs, hs->req, data_len);
+          }
+#endif /* HTTPD_PIPELINING */
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
           /* This is HTTP/1.0 compatible: for strict 1.1, a connection
              would always be persistent unless "close" was specified. */
@@ -2105,6 +3859,9 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
             hs->keepalive = 0;
           }
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_CONTENT_ENCODING
+          hs->accept_encoding = is_09 ? 0 : http_parse_accept_encoding(data, data_len);
+#endif /* LWIP_HTTPD_CONTENT_ENCODING */
           /* null-terminate the METHOD (pbuf is freed anyway wen returning) */
           *sp1 = 0;
           uri[uri_len] = 0;
@@ -2143,6 +3900,23 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
               uri = replace_uri;
             }
 #endif /* LWIP_HTTPD_HEADERS_BEFORE_FILE_OPEN */
+#if LWIP_HTTPD_WEBSOCKET
+            if (!is_09) {
+              u8_t upgraded = http_ws_upgrade(hs, uri, data, data_len,
+                                              crlf, (u16_t)(data_len - (crlf - data)));
+              if (upgraded == 1) {
+                return ERR_OK;
+              } else if (upgraded == 2) {
+                return http_find_error_file(hs, 400);
+              }
+            }
+#endif /* LWIP_HTTPD_WEBSOCKET */
+#if HTTPD_SEND_NOT_MODIFIED
+            if (!is_09 && http_find_not_modified(hs, uri, crlf, (u16_t)(data_len - (crlf - data)))) {
+              /* the file is not opened */
+              return ERR_OK;
+            }
+#endif /* HTTPD_SEND_NOT_MODIFIED */
             err = http_find_file(hs, uri, is_09);
 #if LWIP_HTTPD_HEADERS_AFTER_FILE_OPEN
             if (err == ERR_OK) {
@@ -2153,6 +3927,17 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
                                             );
             }
 #endif /* LWIP_HTTPD_HEADERS_AFTER_FILE_OPEN */
+#if HTTPD_SEND_NOT_MODIFIED
+            if ((err == ERR_OK) && !is_09 &&
+                http_is_not_modified(hs, crlf, (u16_t)(data_len - (crlf - data)))) {
+              http_init_not_modified(hs, hs->handle->validators, hs->handle->flags);
+            }
+#endif /* HTTPD_SEND_NOT_MODIFIED */
+#if HTTPD_SEND_RANGE
+            if ((err == ERR_OK) && !is_09) {
+              http_init_range(hs, crlf, (u16_t)(data_len - (crlf - data)));
+            }
+#endif /* HTTPD_SEND_RANGE */
             return err;
           }
         }
@@ -2221,6 +4006,46 @@ http_uri_is_ssi(struct fs_file *file, const char *uri)
 }
 #endif /* LWIP_HTTPD_SSI */
 
+#if LWIP_HTTPD_CONTENT_ENCODING
+/** Replace a file by a pre-compressed variant if it has one that the client
+ * accepts.
+ *
+ * @param hs http connection state
+ * @param file the file opened for the request (a variant replaces it)
+ * @param uri the name of the file
+ */
+static void
+http_open_encoded_file(struct http_state *hs, struct fs_file *file, const char *uri)
+{
+  struct fs_file variant;
+  size_t uri_len, i;
+
+  if (((file->flags & FS_FILE_FLAGS_ENCODING_VARIANTS) == 0) || (hs->accept_encoding == 0) ||
+      (uri == NULL)) {
+    return;
+  }
+  uri_len = strlen(uri);
+  for (i = 0; i < LWIP_ARRAYSIZE(http_encodings); i++) {
+    size_t suffix_len = strlen(http_encodings[i].suffix);
+    if (((hs->accept_encoding & http_encodings[i].flag) == 0) ||
+        (uri_len + suffix_len > LWIP_HTTPD_CONTENT_ENCODING_NAME_LEN)) {
+      continue;
+    }
+    MEMCPY(http_encoded_name_buf, uri, uri_len);
+    MEMCPY(&http_encoded_name_buf[uri_len], http_encodings[i].suffix, suffix_len + 1);
+    if (fs_open(&variant, http_encoded_name_buf) == ERR_OK) {
+      if (variant.flags & http_encodings[i].flag) {
+        LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Sending %s\n", http_encoded_name_buf));
+        fs_close(file);
+        *file = variant;
+        return;
+      }
+      fs_close(&variant);
+    }
+  }
+}
+#endif /* LWIP_HTTPD_CONTENT_ENCODING */
+
 /** Try to find the file specified by uri and, if found, initialize hs
  * accordingly.
  *
@@ -2323,6 +4148,12 @@ http_find_file(struct http_state *hs, const char *uri, int is_09)
     LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Opening %s\n", uri));
 
     err = fs_open(&hs->file_handle, uri);
+    if ((err == ERR_OK) &&
+        (hs->file_handle.flags & (FS_FILE_FLAGS_ENCODING_GZIP | FS_FILE_FLAGS_ENCODING_BR))) {
+      /* pre-compressed variants are only sent in place of the original file */
+      fs_close(&hs->file_handle);
+      err = ERR_VAL;
+    }
     if (err == ERR_OK) {
       file = &hs->file_handle;
     } else {
@@ -2344,9 +4175,58 @@ http_find_file(struct http_state *hs, const char *uri, int is_09)
     /* None of the default filenames exist so send back a 404 page */
     file = http_get_404_file(hs, &uri);
   }
+#if LWIP_HTTPD_CONTENT_ENCODING
+  if ((file != NULL) && !tag_check) {
+    http_open_encoded_file(hs, file, uri);
+  }
+#endif /* LWIP_HTTPD_CONTENT_ENCODING */
   return http_init_file(hs, file, is_09, uri, tag_check, params);
 }
 
+#if HTTPD_SEND_PRECALCULATED_CHECKSUM
+/** Select the precalculated checksums to send a file with: the file may
+ * contain checksums for more than one segment size (each list starting at
+ * offset 0), take the largest segment size that fits into the MSS of the
+ * connection and into the send buffer.
+ *
+ * @param hs http connection state with the file to send
+ */
+static void
+http_select_chksum(struct http_state *hs)
+{
+  u16_t i, start;
+  u16_t max_len;
+  u16_t best_len = 0;
+
+  hs->chksum = NULL;
+  hs->chksum_count = 0;
+  if ((hs->handle == NULL) || ((hs->handle->flags & FS_FILE_FLAGS_CUSTOM) != 0) ||
+      (hs->handle->chksum == NULL) || (hs->handle->chksum_count == 0)) {
+    /* no checksums (custom files are read at runtime) */
+    return;
+  }
+  max_len = altcp_mss(hs->pcb);
+  if (max_len > TCP_SND_BUF) {
+    max_len = (u16_t)TCP_SND_BUF;
+  }
+  for (start = 0; start < hs->handle->chksum_count; start = i) {
+    const struct fsdata_chksum *list = &hs->handle->chksum[start];
+    for (i = (u16_t)(start + 1); i < hs->handle->chksum_count; i++) {
+      if (hs->handle->chksum[i].offset == 0) {
+        break;
+      }
+    }
+    /* the first chunk has the segment size of this list
+       (or is the whole file if it is smaller) */
+    if ((list->offset == 0) && (list->len > best_len) && (list->len <= max_len)) {
+      best_len = list->len;
+      hs->chksum = list;
+      hs->chksum_count = (u16_t)(i - start);
+    }
+  }
+}
+#endif /* HTTPD_SEND_PRECALCULATED_CHECKSUM */
+
 /** Initialize a http connection with a file to send (if found).
  * Called by http_find_file and http_find_error_file.
  *
@@ -2447,6 +4327,9 @@ http_init_file(struct http_state *hs, struct fs_file *file, int is_09, const cha
     hs->left = 0;
     hs->retries = 0;
   }
+#if HTTPD_SEND_PRECALCULATED_CHECKSUM
+  http_select_chksum(hs);
+#endif /* HTTPD_SEND_PRECALCULATED_CHECKSUM */
 #if LWIP_HTTPD_DYNAMIC_HEADERS
   /* Determine the HTTP headers to send based on the file extension of
    * the requested URI. */
@@ -2510,6 +4393,27 @@ http_sent(void *arg, struct altcp_pcb *pcb, u16_t len)
 
   hs->retries = 0;
 
+#if LWIP_HTTPD_WEBSOCKET
+  if (hs->http_unacked != 0) {
+    /* HTTP data (e.g. responses sent before an upgrade) is acknowledged first */
+    u16_t http_len = (u16_t)LWIP_MIN(len, hs->http_unacked);
+    hs->http_unacked -= http_len;
+    len = (u16_t)(len - http_len);
+  }
+  if (hs->ws_tx_written != 0) {
+    /* free the acknowledged part of the WebSocket data */
+    LWIP_ASSERT("acked more than written", len <= hs->ws_tx_written);
+    hs->ws_tx = pbuf_free_header(hs->ws_tx, len);
+    hs->ws_tx_written = (u16_t)(hs->ws_tx_written - len);
+  }
+  if (hs->ws_state != HTTPD_WS_STATE_NONE) {
+    if (!http_ws_check_close(pcb, hs) && (hs->ws_state != HTTPD_WS_STATE_CLOSED)) {
+      http_ws_output(pcb, hs);
+    }
+    return ERR_OK;
+  }
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
   http_send(pcb, hs);
 
   return ERR_OK;
@@ -2543,8 +4447,28 @@ http_poll(void *arg, struct altcp_pcb *pcb)
 #endif /* LWIP_HTTPD_ABORT_ON_CLOSE_MEM_ERROR */
     return ERR_OK;
   } else {
+#if LWIP_HTTPD_WEBSOCKET
+    if (hs->ws_state == HTTPD_WS_STATE_OPEN) {
+      /* an open WebSocket may be idle for any time */
+      hs->retries = 0;
+      /* frames may be pending after running out of memory */
+      if (http_ws_parse(pcb, hs)) {
+        return ERR_OK;
+      }
+      http_ws_output(pcb, hs);
+      return ERR_OK;
+    }
+#endif /* LWIP_HTTPD_WEBSOCKET */
     hs->retries++;
     if (hs->retries == HTTPD_MAX_RETRIES) {
+#if LWIP_HTTPD_WEBSOCKET
+      if (hs->ws_tx_written != 0) {
+        /* the WebSocket data written has not been acknowledged in time */
+        LWIP_DEBUGF(HTTPD_DEBUG, ("http_poll: too many retries, abort\n"));
+        http_close_or_abort_conn(pcb, hs, 1);
+        return ERR_ABRT;
+      }
+#endif /* LWIP_HTTPD_WEBSOCKET */
       LWIP_DEBUGF(HTTPD_DEBUG, ("http_poll: too many retries, close\n"));
       http_close_conn(pcb, hs);
       return ERR_OK;
@@ -2592,6 +4516,21 @@ http_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t err)
     return ERR_OK;
   }
 
+#if LWIP_HTTPD_WEBSOCKET
+  if (hs->ws_state != HTTPD_WS_STATE_NONE) {
+    /* frames are parsed on the pbuf chain, which is taken over */
+    http_ws_recv(pcb, hs, p);
+    return ERR_OK;
+  }
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
+#if HTTPD_PIPELINING
+  if (http_pipeline_queue(pcb, hs, p)) {
+    /* pipelined request, parsed when the current response has been sent */
+    return ERR_OK;
+  }
+#endif /* HTTPD_PIPELINING */
+
 #if LWIP_HTTPD_SUPPORT_POST && LWIP_HTTPD_POST_MANUAL_WND
   if (hs->no_auto_wnd) {
     hs->unrecved_bytes += p->tot_len;
@@ -2632,6 +4571,12 @@ http_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t err)
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
       pbuf_free(p);
       if (parsed == ERR_OK) {
+#if LWIP_HTTPD_WEBSOCKET
+        if (hs->ws_state != HTTPD_WS_STATE_NONE) {
+          /* send the 101 response */
+          http_ws_output(pcb, hs);
+        } else
+#endif /* LWIP_HTTPD_WEBSOCKET */
 #if LWIP_HTTPD_SUPPORT_POST
         if (hs->post_content_len_left == 0)
 #endif /* LWIP_HTTPD_SUPPORT_POST */
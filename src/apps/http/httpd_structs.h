@@ -27,6 +27,9 @@ static const char *const g_psHTTPHeaderStrings[] = {
   "Connection: keep-alive\r\n",
   "Connection: keep-alive\r\nContent-Length: ",
   "Server: "HTTPD_SERVER_AGENT"\r\n",
+  "HTTP/1.0 304 Not Modified\r\n",
+  "HTTP/1.1 206 Partial Content\r\n",
+  "HTTP/1.1 416 Range Not Satisfiable\r\n",
   "\r\n<html><body><h2>404: The requested file cannot be found.</h2></body></html>\r\n"
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
   , "Connection: keep-alive\r\nContent-Length: 77\r\n\r\n<html><body><h2>404: The requested file cannot be found.</h2></body></html>\r\n"
@@ -47,36 +50,49 @@ static const char *const g_psHTTPHeaderStrings[] = {
 #define HTTP_HDR_CONN_KEEPALIVE 10 /* Connection: keep-alive (HTTP 1.1) */
 #define HTTP_HDR_KEEPALIVE_LEN  11 /* Connection: keep-alive + Content-Length: (HTTP 1.1)*/
 #define HTTP_HDR_SERVER         12 /* Server: HTTPD_SERVER_AGENT */
-#define DEFAULT_404_HTML        13 /* default 404 body */
+#define HTTP_HDR_NOT_MODIFIED   13 /* 304 Not Modified */
+#define HTTP_HDR_PARTIAL_11     14 /* 206 Partial Content */
+#define HTTP_HDR_RANGE_NOT_SATISFIABLE_11 15 /* 416 Range Not Satisfiable */
+#define DEFAULT_404_HTML        16 /* default 404 body */
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
-#define DEFAULT_404_HTML_PERSISTENT 14 /* default 404 body, but including Connection: keep-alive */
+#define DEFAULT_404_HTML_PERSISTENT 17 /* default 404 body, but including Connection: keep-alive */
 #endif
 
 #define HTTP_CONTENT_TYPE(contenttype) "Content-Type: "contenttype"\r\n\r\n"
 #define HTTP_CONTENT_TYPE_ENCODING(contenttype, encoding) "Content-Type: "contenttype"\r\nContent-Encoding: "encoding"\r\n\r\n"
+/** Content type plus "Cache-Control" header line (or "") */
+#define HTTP_CONTENT_TYPE_CACHE(contenttype, cachecontrol) "Content-Type: "contenttype"\r\n"cachecontrol"\r\n"
+#define HTTP_CONTENT_TYPE_DOCUMENT(contenttype) HTTP_CONTENT_TYPE_CACHE(contenttype, LWIP_HTTPD_CACHE_CONTROL_DOCUMENT)
+#define HTTP_CONTENT_TYPE_ASSET(contenttype)    HTTP_CONTENT_TYPE_CACHE(contenttype, LWIP_HTTPD_CACHE_CONTROL_ASSET)
 
-#define HTTP_HDR_HTML           HTTP_CONTENT_TYPE("text/html")
+#define HTTP_HDR_HTML           HTTP_CONTENT_TYPE_DOCUMENT("text/html")
 #define HTTP_HDR_SSI            HTTP_CONTENT_TYPE("text/html\r\nExpires: Fri, 10 Apr 2008 14:00:00 GMT\r\nPragma: no-cache")
-#define HTTP_HDR_GIF            HTTP_CONTENT_TYPE("image/gif")
-#define HTTP_HDR_PNG            HTTP_CONTENT_TYPE("image/png")
-#define HTTP_HDR_JPG            HTTP_CONTENT_TYPE("image/jpeg")
-#define HTTP_HDR_BMP            HTTP_CONTENT_TYPE("image/bmp")
-#define HTTP_HDR_ICO            HTTP_CONTENT_TYPE("image/x-icon")
+#define HTTP_HDR_GIF            HTTP_CONTENT_TYPE_ASSET("image/gif")
+#define HTTP_HDR_PNG            HTTP_CONTENT_TYPE_ASSET("image/png")
+#define HTTP_HDR_JPG            HTTP_CONTENT_TYPE_ASSET("image/jpeg")
+#define HTTP_HDR_BMP            HTTP_CONTENT_TYPE_ASSET("image/bmp")
+#define HTTP_HDR_ICO            HTTP_CONTENT_TYPE_ASSET("image/x-icon")
 #define HTTP_HDR_APP            HTTP_CONTENT_TYPE("application/octet-stream")
-#define HTTP_HDR_JS             HTTP_CONTENT_TYPE("application/javascript")
-#define HTTP_HDR_RA             HTTP_CONTENT_TYPE("application/javascript")
-#define HTTP_HDR_CSS            HTTP_CONTENT_TYPE("text/css")
-#define HTTP_HDR_SWF            HTTP_CONTENT_TYPE("application/x-shockwave-flash")
-#define HTTP_HDR_XML            HTTP_CONTENT_TYPE("text/xml")
-#define HTTP_HDR_PDF            HTTP_CONTENT_TYPE("application/pdf")
-#define HTTP_HDR_JSON           HTTP_CONTENT_TYPE("application/json")
+#define HTTP_HDR_CLASS          HTTP_CONTENT_TYPE_ASSET("application/octet-stream")
+#define HTTP_HDR_JS             HTTP_CONTENT_TYPE_ASSET("application/javascript")
+#define HTTP_HDR_RA             HTTP_CONTENT_TYPE_ASSET("application/javascript")
+#define HTTP_HDR_CSS            HTTP_CONTENT_TYPE_ASSET("text/css")
+#define HTTP_HDR_SWF            HTTP_CONTENT_TYPE_ASSET("application/x-shockwave-flash")
+#define HTTP_HDR_XML            HTTP_CONTENT_TYPE_DOCUMENT("text/xml")
+#define HTTP_HDR_PDF            HTTP_CONTENT_TYPE_ASSET("application/pdf")
+#define HTTP_HDR_JSON           HTTP_CONTENT_TYPE_DOCUMENT("application/json")
 #define HTTP_HDR_CSV            HTTP_CONTENT_TYPE("text/csv")
 #define HTTP_HDR_TSV            HTTP_CONTENT_TYPE("text/tsv")
-#define HTTP_HDR_SVG            HTTP_CONTENT_TYPE("image/svg+xml")
+#define HTTP_HDR_SVG            HTTP_CONTENT_TYPE_ASSET("image/svg+xml")
 #define HTTP_HDR_SVGZ           HTTP_CONTENT_TYPE_ENCODING("image/svg+xml", "gzip")
 
 #define HTTP_HDR_DEFAULT_TYPE   HTTP_CONTENT_TYPE("text/plain")
 
+/** Headers sent with files that have pre-compressed variants */
+#define HTTP_HDR_VARY_ENCODING  "Vary: Accept-Encoding\r\n"
+#define HTTP_HDR_ENCODING_GZIP  "Content-Encoding: gzip\r\n" HTTP_HDR_VARY_ENCODING
+#define HTTP_HDR_ENCODING_BR    "Content-Encoding: br\r\n" HTTP_HDR_VARY_ENCODING
+
 /** A list of extension-to-HTTP header strings (see outdated RFC 1700 MEDIA TYPES
  * and http://www.iana.org/assignments/media-types for registered content types
  * and subtypes) */
@@ -91,8 +107,8 @@ static const tHTTPHeader g_psHTTPHeaders[] = {
   { "jpg",  HTTP_HDR_JPG},
   { "bmp",  HTTP_HDR_BMP},
   { "ico",  HTTP_HDR_ICO},
-  { "class", HTTP_HDR_APP},
-  { "cls",  HTTP_HDR_APP},
+  { "class", HTTP_HDR_CLASS},
+  { "cls",  HTTP_HDR_CLASS},
   { "js",   HTTP_HDR_JS},
   { "ram",  HTTP_HDR_RA},
   { "css",  HTTP_HDR_CSS},
@@ -104,6 +120,7 @@ static const tHTTPHeader g_psHTTPHeaders[] = {
 #ifdef HTTPD_ADDITIONAL_CONTENT_TYPES
   /* If you need to add content types not listed here:
    * #define HTTPD_ADDITIONAL_CONTENT_TYPES {"ct1", HTTP_CONTENT_TYPE("text/ct1")}, {"exe", HTTP_CONTENT_TYPE("application/exe")}
+   * (HTTP_CONTENT_TYPE_CACHE(type, "Cache-Control: ...\r\n") adds a Cache-Control header)
    */
   , HTTPD_ADDITIONAL_CONTENT_TYPES
 #endif
@@ -7,8 +7,7 @@
  *         Simon Goldschmidt
  *
  * @todo:
- * - take TCP_MSS, LWIP_TCP_TIMESTAMPS and
- *   PAYLOAD_ALIGN_TYPE/PAYLOAD_ALIGNMENT as arguments
+ * - take PAYLOAD_ALIGN_TYPE/PAYLOAD_ALIGNMENT as arguments
  */
 
 #include <stdio.h>
@@ -32,6 +31,16 @@
 #endif /* MAKEFS_SUPPORT_DEFLATE_ZLIB */
 #endif /* MAKEFS_SUPPORT_DEFLATE */
 
+/** Makefsdata can generate pre-compressed variants of files in addition to
+ * the uncompressed files ("-enc:gzip,br"), httpd then selects one by the
+ * "Accept-Encoding" header of a request (LWIP_HTTPD_CONTENT_ENCODING).
+ * gzip variants need MAKEFS_SUPPORT_DEFLATE, brotli variants need
+ * MAKEFS_SUPPORT_BROTLI and the brotli encoder library.
+ */
+#ifndef MAKEFS_SUPPORT_BROTLI
+#define MAKEFS_SUPPORT_BROTLI 0
+#endif /* MAKEFS_SUPPORT_BROTLI */
+
 #define COPY_BUFSIZE (1024*1024) /* 1 MByte */
 
 #if MAKEFS_SUPPORT_DEFLATE
@@ -64,12 +73,16 @@ static uint8 s_checkbuf[OUT_BUF_SIZE];
 tdefl_compressor g_deflator;
 #endif /* MAKEFS_SUPPORT_DEFLATE_ZLIB */
 
-static int deflate_level; /* default compression level, can be changed via command line */
+static int deflate_level = 10; /* default compression level, can be changed via command line */
 #define USAGE_ARG_DEFLATE " [-defl<:compr_level>]"
 #else /* MAKEFS_SUPPORT_DEFLATE */
 #define USAGE_ARG_DEFLATE ""
 #endif /* MAKEFS_SUPPORT_DEFLATE */
 
+#if MAKEFS_SUPPORT_BROTLI
+#include <brotli/encode.h>
+#endif /* MAKEFS_SUPPORT_BROTLI */
+
 #ifdef WIN32
 
 #define GETCWD(path, len)             GetCurrentDirectoryA(len, path)
@@ -123,15 +136,20 @@ static int payload_alingment_dummy_counter = 0;
 
 #define MAX_PATH_LEN 256
 
+/* maximum number of chunk sizes checksums can be precalculated for */
+#define MAX_CHKSUM_CHUNK_SIZES 8
+
 struct file_entry {
   struct file_entry *next;
-  const char *filename_c;
+  char *filename_c;
+  char *filename;
 };
 
 int process_sub(FILE *data_file, FILE *struct_file);
 int process_file(FILE *data_file, FILE *struct_file, const char *filename);
 int file_write_http_header(FILE *data_file, const char *filename, int file_size, u16_t *http_hdr_len,
-                           u16_t *http_hdr_chksum, u8_t provide_content_len, int is_compressed);
+                           u16_t *http_hdr_chksum, u8_t provide_content_len, int is_compressed, u8_t encoding,
+                           const char *etag);
 int file_put_ascii(FILE *file, const char *ascii_string, size_t len, int *i);
 int s_put_ascii(char *buf, const char *ascii_string, int len, int *i);
 void concat_files(const char *file1, const char *file2, const char *targetfile);
@@ -140,6 +158,7 @@ static int checkSsiByFilelist(const char* filename_listfile);
 static int ext_in_list(const char* filename, const char *ext_list);
 static int file_to_exclude(const char* filename);
 static int file_can_be_compressed(const char* filename);
+static void write_sorted_index(FILE *struct_file);
 
 /* 5 bytes per char + 3 bytes per line */
 static char file_buffer_c[COPY_BUFSIZE * 5 + ((COPY_BUFSIZE / HEX_BYTES_PER_LINE) * 3)];
@@ -153,7 +172,11 @@ static unsigned char includeHttpHeader = 1;
 static unsigned char useHttp11 = 0;
 static unsigned char supportSsi = 1;
 static unsigned char precalcChksum = 0;
+static int chksumChunkSizes[MAX_CHKSUM_CHUNK_SIZES];
+static int chksumChunkSizesCount = 0;
 static unsigned char includeLastModified = 0;
+static unsigned char includeEtag = 0;
+static u8_t encodingVariants = 0;
 #if MAKEFS_SUPPORT_DEFLATE
 static unsigned char deflateNonSsiFiles = 0;
 static size_t deflatedBytesReduced = 0;
@@ -171,7 +194,7 @@ static size_t ssi_file_num_lines;
 
 static void print_usage(void)
 {
-  printf(" Usage: htmlgen [targetdir] [-s] [-e] [-11] [-nossi] [-ssi:<filename>] [-c] [-f:<filename>] [-m] [-svr:<name>] [-x:<ext_list>] [-xc:<ext_list>" USAGE_ARG_DEFLATE NEWLINE NEWLINE);
+  printf(" Usage: htmlgen [targetdir] [-s] [-e] [-11] [-nossi] [-ssi:<filename>] [-c[:<mss_list>]] [-f:<filename>] [-m] [-etag] [-svr:<name>] [-x:<ext_list>] [-xc:<ext_list>] [-enc:<enc_list>" USAGE_ARG_DEFLATE NEWLINE NEWLINE);
   printf("   targetdir: relative or absolute path to files to convert" NEWLINE);
   printf("   switch -s: toggle processing of subdirectories (default is on)" NEWLINE);
   printf("   switch -e: exclude HTTP header from file (header is created at runtime, default is off)" NEWLINE);
@@ -179,11 +202,16 @@ static void print_usage(void)
   printf("   switch -nossi: no support for SSI (cannot calculate Content-Length for SSI)" NEWLINE);
   printf("   switch -ssi: ssi filename (ssi support controlled by file list, not by extension)" NEWLINE);
   printf("   switch -c: precalculate checksums for all pages (default is off)" NEWLINE);
+  printf("              with optional comma separated list of segment sizes (e.g., -c:536,1460)" NEWLINE);
   printf("   switch -f: target filename (default is \"fsdata.c\")" NEWLINE);
   printf("   switch -m: include \"Last-Modified\" header based on file time" NEWLINE);
+  printf("   switch -etag: include \"ETag\" header based on file contents" NEWLINE);
+  printf("              (-m and -etag also store validators for LWIP_HTTPD_CONDITIONAL_REQUESTS)" NEWLINE);
   printf("   switch -svr: server identifier sent in HTTP response header ('Server' field)" NEWLINE);
   printf("   switch -x: comma separated list of extensions of files to exclude (e.g., -x:json,txt)" NEWLINE);
   printf("   switch -xc: comma separated list of extensions of files to not compress (e.g., -xc:mp3,jpg)" NEWLINE);
+  printf("   switch -enc: add pre-compressed variants of non-SSI files (e.g., -enc:gzip,br)" NEWLINE);
+  printf("                httpd sends them to clients accepting the encoding (LWIP_HTTPD_CONTENT_ENCODING)" NEWLINE);
 #if MAKEFS_SUPPORT_DEFLATE
   printf("   switch -defl: deflate-compress all non-SSI files (with opt. compr.-level, default=10)" NEWLINE);
   printf("                 ATTENTION: browser has to support \"Content-Encoding: deflate\"!" NEWLINE);
@@ -239,12 +267,31 @@ int main(int argc, char *argv[])
         }
       } else if (!strcmp(argv[i], "-c")) {
         precalcChksum = 1;
+      } else if (strstr(argv[i], "-c:") == argv[i]) {
+        const char *mss_list = &argv[i][3];
+        precalcChksum = 1;
+        while (*mss_list != 0) {
+          int mss = atoi(mss_list);
+          if ((mss <= 0) || (mss > 0xffff) || (chksumChunkSizesCount >= MAX_CHKSUM_CHUNK_SIZES)) {
+            printf("ERROR: invalid segment size list \"%s\"" NEWLINE, &argv[i][3]);
+            exit(-1);
+          }
+          chksumChunkSizes[chksumChunkSizesCount++] = mss;
+          mss_list = strchr(mss_list, ',');
+          if (mss_list == NULL) {
+            break;
+          }
+          mss_list++;
+        }
+        printf("Precalculating checksums for %d segment size(s)" NEWLINE, chksumChunkSizesCount);
       } else if (strstr(argv[i], "-f:") == argv[i]) {
         strncpy(targetfile, &argv[i][3], sizeof(targetfile) - 1);
         targetfile[sizeof(targetfile) - 1] = 0;
         printf("Writing to file \"%s\"\n", targetfile);
       } else if (!strcmp(argv[i], "-m")) {
         includeLastModified = 1;
+      } else if (!strcmp(argv[i], "-etag")) {
+        includeEtag = 1;
       } else if (strstr(argv[i], "-defl") == argv[i]) {
 #if MAKEFS_SUPPORT_DEFLATE
         const char *colon = &argv[i][5];
@@ -271,6 +318,21 @@ int main(int argc, char *argv[])
       } else if (strstr(argv[i], "-xc:") == argv[i]) {
         ncompress_list = &argv[i][4];
         printf("Skipping compression for files with extensions %s" NEWLINE, ncompress_list);
+      } else if (strstr(argv[i], "-enc:") == argv[i]) {
+        if (strstr(&argv[i][5], "gzip") != NULL) {
+#if MAKEFS_SUPPORT_DEFLATE
+          encodingVariants |= FS_FILE_FLAGS_ENCODING_GZIP;
+#else
+          printf("WARNING: gzip support is disabled (MAKEFS_SUPPORT_DEFLATE)" NEWLINE);
+#endif
+        }
+        if (strstr(&argv[i][5], "br") != NULL) {
+#if MAKEFS_SUPPORT_BROTLI
+          encodingVariants |= FS_FILE_FLAGS_ENCODING_BR;
+#else
+          printf("WARNING: brotli support is disabled (MAKEFS_SUPPORT_BROTLI)" NEWLINE);
+#endif
+        }
       } else if ((strstr(argv[i], "-?")) || (strstr(argv[i], "-h"))) {
         print_usage();
         exit(0);
@@ -284,6 +346,16 @@ int main(int argc, char *argv[])
     }
   }
 
+  if (precalcChksum && (chksumChunkSizesCount == 0)) {
+    /* default to full-sized segments of the configured TCP_MSS */
+#if LWIP_TCP_TIMESTAMPS
+    /* when timestamps are used, usable space is 12 bytes less per segment */
+    chksumChunkSizes[chksumChunkSizesCount++] = TCP_MSS - 12;
+#else
+    chksumChunkSizes[chksumChunkSizesCount++] = TCP_MSS;
+#endif
+  }
+
   if (!check_path(path, sizeof(path))) {
     printf("Invalid path: \"%s\"." NEWLINE, path);
     exit(-1);
@@ -362,6 +434,7 @@ int main(int argc, char *argv[])
   fprintf(data_file, NEWLINE NEWLINE);
   fprintf(struct_file, "#define FS_ROOT file_%s" NEWLINE, lastFileVar);
   fprintf(struct_file, "#define FS_NUMFILES %d" NEWLINE NEWLINE, filesProcessed);
+  write_sorted_index(struct_file);
 
   fclose(data_file);
   fclose(struct_file);
@@ -395,6 +468,8 @@ int main(int argc, char *argv[])
   while (first_file != NULL) {
     struct file_entry *fe = first_file;
     first_file = fe->next;
+    free(fe->filename_c);
+    free(fe->filename);
     free(fe);
   }
 
@@ -530,6 +605,7 @@ int process_sub(FILE *data_file, FILE *struct_file)
 
         if (ret == 0) {
           if (!file.is_dir) {
+            int files;
 #if (defined _MSC_VER || defined __MINGW32__) && (defined _UNICODE)
             size_t num_char_converted;
             char curName[256];
@@ -551,11 +627,12 @@ int process_sub(FILE *data_file, FILE *struct_file)
 
             printf("processing %s/%s..." NEWLINE, curSubdir, curName);
 
-            if (process_file(data_file, struct_file, curName) < 0) {
+            files = process_file(data_file, struct_file, curName);
+            if (files < 0) {
               printf(NEWLINE "Error... aborting" NEWLINE);
               return -1;
             }
-            filesProcessed++;
+            filesProcessed += files;
           }
         }
       }
@@ -706,43 +783,47 @@ static void process_file_data(FILE *data_file, u8_t *file_data, size_t file_size
 }
 
 static int write_checksums(FILE *struct_file, const char *varname,
-                           u16_t hdr_len, u16_t hdr_chksum, const u8_t *file_data, size_t file_size)
+                           u16_t hdr_len, const u8_t *file_data, size_t file_size)
 {
-  int chunk_size = TCP_MSS;
-  int offset, src_offset;
-  size_t len;
+  size_t total_len = hdr_len + file_size;
+  u8_t *chunk;
+  int max_chunk_size = 0;
+  int s;
   int i = 0;
-#if LWIP_TCP_TIMESTAMPS
-  /* when timestamps are used, usable space is 12 bytes less per segment */
-  chunk_size -= 12;
-#if TCP_MSS <= 12
-#error TCP_MSS <= 12
-#endif
-#endif
+
+  for (s = 0; s < chksumChunkSizesCount; s++) {
+    max_chunk_size = LWIP_MAX(max_chunk_size, chksumChunkSizes[s]);
+  }
+  chunk = (u8_t *)malloc((size_t)max_chunk_size);
+  LWIP_ASSERT("out of memory", chunk != NULL);
 
   fprintf(struct_file, "#if HTTPD_PRECALCULATED_CHECKSUM" NEWLINE);
   fprintf(struct_file, "const struct fsdata_chksum chksums_%s[] = {" NEWLINE, varname);
 
-  if (hdr_len > 0) {
-    /* add checksum for HTTP header */
-    fprintf(struct_file, "{%d, 0x%04x, %d}," NEWLINE, 0, hdr_chksum, hdr_len);
-    i++;
-  }
-  src_offset = 0;
-  for (offset = hdr_len; ; offset += (int)len) {
-    unsigned short chksum;
-    const void *data = (const void *)&file_data[src_offset];
-    len = LWIP_MIN(chunk_size, (int)file_size - src_offset);
-    if (len == 0) {
-      break;
-    }
-    chksum = ~inet_chksum(data, (u16_t)len);
-    /* add checksum for data */
-    fprintf(struct_file, "{%d, 0x%04x, %"SZT_F"}," NEWLINE, offset, chksum, len);
-    i++;
+  /* The header (if included) and the data are sent as one stream, so the
+     chunks of each segment size cover both, starting at offset 0 */
+  for (s = 0; s < chksumChunkSizesCount; s++) {
+    size_t offset = 0;
+    do {
+      size_t len = LWIP_MIN((size_t)chksumChunkSizes[s], total_len - offset);
+      size_t hdr_part = 0;
+      unsigned short chksum;
+      if (offset < hdr_len) {
+        hdr_part = LWIP_MIN(len, hdr_len - offset);
+        memcpy(chunk, &hdr_buf[offset], hdr_part);
+      }
+      if (len > hdr_part) {
+        memcpy(&chunk[hdr_part], &file_data[offset + hdr_part - hdr_len], len - hdr_part);
+      }
+      chksum = ~inet_chksum(chunk, (u16_t)len);
+      fprintf(struct_file, "{%"SZT_F", 0x%04x, %"SZT_F"}," NEWLINE, offset, chksum, len);
+      i++;
+      offset += len;
+    } while (offset < total_len);
   }
   fprintf(struct_file, "};" NEWLINE);
   fprintf(struct_file, "#endif /* HTTPD_PRECALCULATED_CHECKSUM */" NEWLINE);
+  free(chunk);
   return i;
 }
 
@@ -795,10 +876,11 @@ static void fix_filename_for_c(char *qualifiedName, size_t max_len)
   free(new_name);
 }
 
-static void register_filename(const char *qualifiedName)
+static void register_filename(const char *varname, const char *qualifiedName)
 {
   struct file_entry *fe = (struct file_entry *)malloc(sizeof(struct file_entry));
-  fe->filename_c = strdup(qualifiedName);
+  fe->filename_c = strdup(varname);
+  fe->filename = strdup(qualifiedName);
   fe->next = NULL;
   if (first_file == NULL) {
     first_file = last_file = fe;
@@ -808,6 +890,46 @@ static void register_filename(const char *qualifiedName)
   }
 }
 
+static int compare_file_entries(const void *a, const void *b)
+{
+  const struct file_entry *fa = *(const struct file_entry * const *)a;
+  const struct file_entry *fb = *(const struct file_entry * const *)b;
+  return strcmp(fa->filename, fb->filename);
+}
+
+/** Write an array of all files sorted by name (in strcmp() order) so that
+ * fs_open() can find a file by binary search instead of walking FS_ROOT */
+static void write_sorted_index(FILE *struct_file)
+{
+  struct file_entry **sorted;
+  struct file_entry *fe;
+  size_t num_files = 0;
+  size_t i;
+
+  for (fe = first_file; fe != NULL; fe = fe->next) {
+    num_files++;
+  }
+  if (num_files == 0) {
+    return;
+  }
+  sorted = (struct file_entry **)malloc(num_files * sizeof(struct file_entry *));
+  LWIP_ASSERT("sorted != NULL", sorted != NULL);
+  i = 0;
+  for (fe = first_file; fe != NULL; fe = fe->next) {
+    sorted[i++] = fe;
+  }
+  qsort(sorted, num_files, sizeof(struct file_entry *), compare_file_entries);
+
+  fprintf(struct_file, "/* all files sorted by name for binary search in fs_open() */" NEWLINE);
+  fprintf(struct_file, "const struct fsdata_file *const fsdata_sorted_files[] = {" NEWLINE);
+  for (i = 0; i < num_files; i++) {
+    fprintf(struct_file, "file_%s," NEWLINE, sorted[i]->filename_c);
+  }
+  fprintf(struct_file, "};" NEWLINE NEWLINE);
+  fprintf(struct_file, "#define FS_SORTED_FILES fsdata_sorted_files" NEWLINE);
+  free(sorted);
+}
+
 static int checkSsiByFilelist(const char* filename_listfile)
 {
   FILE *f = fopen(filename_listfile, "r");
@@ -929,6 +1051,67 @@ static int is_ssi_file(const char *filename)
   return 0;
 }
 
+/* error pages are not sent as "200 OK", so they don't get validators */
+static int is_error_page(const char *filename)
+{
+  return (strstr(filename, "404.") == filename) || (strstr(filename, "400.") == filename) ||
+         (strstr(filename, "501.") == filename);
+}
+
+/* format the modification time of a file as HTTP date */
+static void get_last_modified(const char *filename, char *buf, size_t buf_size)
+{
+  struct stat stat_data;
+  struct tm *t;
+
+  memset(&stat_data, 0, sizeof(stat_data));
+  if (stat(filename, &stat_data) != 0) {
+    printf("stat(%s) failed with error %d\n", filename, errno);
+    exit(-1);
+  }
+  t = gmtime(&stat_data.st_mtime);
+  if (t == NULL) {
+    printf("gmtime() failed with error %d\n", errno);
+    exit(-1);
+  }
+  strftime(buf, buf_size, "%a, %d %b %Y %H:%M:%S GMT", t);
+}
+
+/* create a strong entity tag (including the double quotes) from the data sent
+   for a file: 64 bits built from FNV-1a hashes over the data in both directions */
+static void get_etag(const u8_t *data, int len, char *buf, size_t buf_size)
+{
+  u32_t h1 = 2166136261UL;
+  u32_t h2;
+  int i;
+
+  for (i = 0; i < len; i++) {
+    h1 = (h1 ^ data[i]) * 16777619UL;
+  }
+  h2 = h1 ^ (u32_t)len;
+  for (i = len; i > 0; i--) {
+    h2 = (h2 ^ data[i - 1]) * 16777619UL;
+  }
+  snprintf(buf, buf_size, "\"%08lx%08lx\"", (unsigned long)h1, (unsigned long)h2);
+}
+
+/* write a string as C string literal contents */
+static void fputs_c_string(const char *str, FILE *f)
+{
+  for (; *str != 0; str++) {
+    if (*str == '\r') {
+      fputs("\\r", f);
+    } else if (*str == '\n') {
+      fputs("\\n", f);
+    } else if ((*str == '"') || (*str == '\\')) {
+      fputc('\\', f);
+      fputc(*str, f);
+    } else {
+      fputc(*str, f);
+    }
+  }
+}
+
 static int ext_in_list(const char* filename, const char *ext_list)
 {
   int found = 0;
@@ -965,7 +1148,18 @@ static int file_can_be_compressed(const char *filename)
     return (ncompress_list == NULL) || !ext_in_list(filename, ncompress_list);
 }
 
-int process_file(FILE *data_file, FILE *struct_file, const char *filename)
+/** Write a file (or a pre-compressed variant of it) to the output files.
+ *
+ * @param filename name of the file in the current directory
+ * @param encoding FS_FILE_FLAGS_ENCODING_GZIP or FS_FILE_FLAGS_ENCODING_BR
+ *        for a variant (enc_data), FS_FILE_FLAGS_ENCODING_VARIANTS if the
+ *        file has variants, 0 otherwise
+ * @param enc_data data of a variant (freed by this function) or NULL to read
+ *        the file
+ * @param enc_size size of enc_data
+ */
+static int write_file_entry(FILE *data_file, FILE *struct_file, const char *filename,
+                            u8_t encoding, u8_t *enc_data, int enc_size)
 {
   char varname[MAX_PATH_LEN];
   int i = 0;
@@ -974,21 +1168,27 @@ int process_file(FILE *data_file, FILE *struct_file, const char *filename)
   u16_t http_hdr_chksum = 0;
   u16_t http_hdr_len = 0;
   int chksum_count = 0;
-  u8_t flags = 0;
+  u8_t flags = encoding;
   u8_t has_content_len;
   u8_t *file_data;
   int is_ssi;
   int can_be_compressed;
   int is_compressed = 0;
   int flags_printed;
+  int has_validators;
+  char etag[20];
 
   /* create qualified name (@todo: prepend slash or not?) */
-  snprintf(qualifiedName, sizeof(qualifiedName), "%s/%s", curSubdir, filename);
+  if (snprintf(qualifiedName, sizeof(qualifiedName), "%s/%s%s", curSubdir, filename,
+               (encoding & FS_FILE_FLAGS_ENCODING_BR) ? ".br" : ((encoding & FS_FILE_FLAGS_ENCODING_GZIP) ? ".gz" : "")) >= (int)sizeof(qualifiedName)) {
+    printf("Error: file name too long: %s/%s" NEWLINE, curSubdir, filename);
+    return -1;
+  }
   /* create C variable name */
   strncpy(varname, qualifiedName, sizeof(varname));
   /* convert slashes & dots to underscores */
   fix_filename_for_c(varname, MAX_PATH_LEN);
-  register_filename(varname);
+  register_filename(varname, qualifiedName);
 #if ALIGN_PAYLOAD
   /* to force even alignment of array, type 1 */
   fprintf(data_file, "#if FSDATA_FILE_ALIGNMENT==1" NEWLINE);
@@ -1013,10 +1213,22 @@ int process_file(FILE *data_file, FILE *struct_file, const char *filename)
     flags |= FS_FILE_FLAGS_SSI;
   }
   has_content_len = !is_ssi;
-  can_be_compressed = includeHttpHeader && !is_ssi && file_can_be_compressed(filename);
-  file_data = get_file_data(filename, &file_size, can_be_compressed, &is_compressed);
+  if (enc_data != NULL) {
+    file_data = enc_data;
+    file_size = enc_size;
+  } else {
+    can_be_compressed = includeHttpHeader && !is_ssi && file_can_be_compressed(filename);
+    file_data = get_file_data(filename, &file_size, can_be_compressed, &is_compressed);
+  }
+  /* validators for conditional requests (only for static "200 OK" files) */
+  has_validators = (includeEtag || includeLastModified) && !is_ssi && !is_error_page(filename);
+  etag[0] = 0;
+  if (has_validators && includeEtag) {
+    get_etag(file_data, file_size, etag, sizeof(etag));
+  }
   if (includeHttpHeader) {
-    file_write_http_header(data_file, filename, file_size, &http_hdr_len, &http_hdr_chksum, has_content_len, is_compressed);
+    file_write_http_header(data_file, filename, file_size, &http_hdr_len, &http_hdr_chksum, has_content_len,
+                           is_compressed, encoding, etag[0] ? etag : NULL);
     flags |= FS_FILE_FLAGS_HEADER_INCLUDED;
     if (has_content_len) {
       flags |= FS_FILE_FLAGS_HEADER_PERSISTENT;
@@ -1026,7 +1238,24 @@ int process_file(FILE *data_file, FILE *struct_file, const char *filename)
     }
   }
   if (precalcChksum) {
-    chksum_count = write_checksums(struct_file, varname, http_hdr_len, http_hdr_chksum, file_data, file_size);
+    chksum_count = write_checksums(struct_file, varname, http_hdr_len, file_data, file_size);
+  }
+
+  if (has_validators) {
+    char modbuf[64];
+    fprintf(struct_file, "#if LWIP_HTTPD_CONDITIONAL_REQUESTS" NEWLINE);
+    fprintf(struct_file, "static const char validators_%s[] = \"", varname);
+    if (etag[0]) {
+      fputs("ETag: ", struct_file);
+      fputs_c_string(etag, struct_file);
+      fputs("\\r\\n", struct_file);
+    }
+    if (includeLastModified) {
+      get_last_modified(filename, modbuf, sizeof(modbuf));
+      fprintf(struct_file, "Last-Modified: %s\\r\\n", modbuf);
+    }
+    fprintf(struct_file, "\";" NEWLINE);
+    fprintf(struct_file, "#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */" NEWLINE);
   }
 
   /* build declaration of struct fsdata_file in temp file */
@@ -1062,15 +1291,45 @@ int process_file(FILE *data_file, FILE *struct_file, const char *filename)
     fputs("FS_FILE_FLAGS_SSI", struct_file);
     flags_printed = 1;
   }
+  if (flags & FS_FILE_FLAGS_ENCODING_VARIANTS) {
+    if (flags_printed) {
+      fputs(" | ", struct_file);
+    }
+    fputs("FS_FILE_FLAGS_ENCODING_VARIANTS", struct_file);
+    flags_printed = 1;
+  }
+  if (flags & FS_FILE_FLAGS_ENCODING_GZIP) {
+    if (flags_printed) {
+      fputs(" | ", struct_file);
+    }
+    fputs("FS_FILE_FLAGS_ENCODING_GZIP", struct_file);
+    flags_printed = 1;
+  }
+  if (flags & FS_FILE_FLAGS_ENCODING_BR) {
+    if (flags_printed) {
+      fputs(" | ", struct_file);
+    }
+    fputs("FS_FILE_FLAGS_ENCODING_BR", struct_file);
+    flags_printed = 1;
+  }
   if (!flags_printed) {
     fputs("0", struct_file);
   }
   fputs("," NEWLINE, struct_file);
+  fprintf(struct_file, "#if HTTPD_PRECALCULATED_CHECKSUM" NEWLINE);
   if (precalcChksum) {
-    fprintf(struct_file, "#if HTTPD_PRECALCULATED_CHECKSUM" NEWLINE);
     fprintf(struct_file, "%d, chksums_%s," NEWLINE, chksum_count, varname);
-    fprintf(struct_file, "#endif /* HTTPD_PRECALCULATED_CHECKSUM */" NEWLINE);
+  } else {
+    fprintf(struct_file, "0, NULL," NEWLINE);
+  }
+  fprintf(struct_file, "#endif /* HTTPD_PRECALCULATED_CHECKSUM */" NEWLINE);
+  fprintf(struct_file, "#if LWIP_HTTPD_CONDITIONAL_REQUESTS" NEWLINE);
+  if (has_validators) {
+    fprintf(struct_file, "validators_%s," NEWLINE, varname);
+  } else {
+    fprintf(struct_file, "NULL," NEWLINE);
   }
+  fprintf(struct_file, "#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */" NEWLINE);
   fprintf(struct_file, "}};" NEWLINE NEWLINE);
   strcpy(lastFileVar, varname);
 
@@ -1083,8 +1342,168 @@ int process_file(FILE *data_file, FILE *struct_file, const char *filename)
   return 0;
 }
 
+#if MAKEFS_SUPPORT_DEFLATE
+/** gzip-compress file data, returns a malloc'ed buffer or NULL on error */
+static u8_t *compress_gzip(const u8_t *data, size_t size, size_t *out_size)
+{
+  u8_t *out;
+#if MAKEFS_SUPPORT_DEFLATE_ZLIB
+  z_stream strm;
+  size_t bound;
+  int status;
+
+  memset(&strm, 0, sizeof(strm));
+  /* windowBits + 16: write a gzip header and trailer */
+  if (deflateInit2(&strm, LWIP_MIN(deflate_level, Z_BEST_COMPRESSION), Z_DEFLATED, 15 + 16, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return NULL;
+  }
+  bound = deflateBound(&strm, (uLong)size);
+  out = (u8_t *)malloc(bound);
+  LWIP_ASSERT("out != NULL", out != NULL);
+  strm.next_in = LWIP_CONST_CAST(Bytef *, data);
+  strm.avail_in = (uInt)size;
+  strm.next_out = out;
+  strm.avail_out = (uInt)bound;
+  status = deflate(&strm, Z_FINISH);
+  *out_size = strm.total_out;
+  deflateEnd(&strm);
+  if (status != Z_STREAM_END) {
+    free(out);
+    return NULL;
+  }
+#else /* MAKEFS_SUPPORT_DEFLATE_ZLIB */
+  static const u8_t gzip_hdr[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+  mz_uint comp_flags = s_tdefl_num_probes[MZ_MIN(10, deflate_level)] | ((deflate_level <= 3) ? TDEFL_GREEDY_PARSING_FLAG : 0);
+  size_t deflated_size;
+  void *deflated;
+  mz_ulong crc;
+  size_t j;
+
+  /* raw deflate data framed by a gzip header and trailer (RFC 1952) */
+  deflated = tdefl_compress_mem_to_heap(data, size, &deflated_size, (int)comp_flags);
+  if (deflated == NULL) {
+    return NULL;
+  }
+  *out_size = sizeof(gzip_hdr) + deflated_size + 8;
+  out = (u8_t *)malloc(*out_size);
+  LWIP_ASSERT("out != NULL", out != NULL);
+  memcpy(out, gzip_hdr, sizeof(gzip_hdr));
+  memcpy(&out[sizeof(gzip_hdr)], deflated, deflated_size);
+  free(deflated);
+  crc = mz_crc32(MZ_CRC32_INIT, data, size);
+  for (j = 0; j < 4; j++) {
+    out[sizeof(gzip_hdr) + deflated_size + j] = (u8_t)(crc >> (8 * j));
+    out[sizeof(gzip_hdr) + deflated_size + 4 + j] = (u8_t)(size >> (8 * j));
+  }
+#endif /* MAKEFS_SUPPORT_DEFLATE_ZLIB */
+  return out;
+}
+#endif /* MAKEFS_SUPPORT_DEFLATE */
+
+#if MAKEFS_SUPPORT_BROTLI
+/** brotli-compress file data, returns a malloc'ed buffer or NULL on error */
+static u8_t *compress_brotli(const u8_t *data, size_t size, size_t *out_size)
+{
+  u8_t *out;
+
+  *out_size = BrotliEncoderMaxCompressedSize(size);
+  if (*out_size == 0) {
+    return NULL;
+  }
+  out = (u8_t *)malloc(*out_size);
+  LWIP_ASSERT("out != NULL", out != NULL);
+  if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC,
+                             size, data, out_size, out)) {
+    free(out);
+    return NULL;
+  }
+  return out;
+}
+#endif /* MAKEFS_SUPPORT_BROTLI */
+
+/** Write the pre-compressed variants of a file that are smaller than the file.
+ * @return the number of variants written
+ */
+static int write_encoded_variants(FILE *data_file, FILE *struct_file, const char *filename)
+{
+  static const struct {
+    u8_t flag;
+    const char *name;
+  } encodings[] = {
+    { FS_FILE_FLAGS_ENCODING_BR, "br" },
+    { FS_FILE_FLAGS_ENCODING_GZIP, "gzip" }
+  };
+  int file_size;
+  int is_compressed;
+  int written = 0;
+  size_t j;
+  u8_t *file_data = get_file_data(filename, &file_size, 0, &is_compressed);
+
+  for (j = 0; j < sizeof(encodings) / sizeof(encodings[0]); j++) {
+    u8_t *enc_data = NULL;
+    size_t enc_size = 0;
+    if ((encodingVariants & encodings[j].flag) == 0) {
+      continue;
+    }
+#if MAKEFS_SUPPORT_BROTLI
+    if (encodings[j].flag == FS_FILE_FLAGS_ENCODING_BR) {
+      enc_data = compress_brotli(file_data, (size_t)file_size, &enc_size);
+    }
+#endif /* MAKEFS_SUPPORT_BROTLI */
+#if MAKEFS_SUPPORT_DEFLATE
+    if (encodings[j].flag == FS_FILE_FLAGS_ENCODING_GZIP) {
+      enc_data = compress_gzip(file_data, (size_t)file_size, &enc_size);
+    }
+#endif /* MAKEFS_SUPPORT_DEFLATE */
+    if ((enc_data != NULL) && (enc_size < (size_t)file_size)) {
+      printf(" - %s: %d bytes -> %d bytes (%.02f%%)" NEWLINE, encodings[j].name, file_size, (int)enc_size,
+             (float)((enc_size * 100.0) / file_size));
+      if (write_file_entry(data_file, struct_file, filename, encodings[j].flag, enc_data, (int)enc_size) < 0) {
+        free(file_data);
+        return -1;
+      }
+      written++;
+    } else {
+      printf(" - %s: no variant (not smaller)" NEWLINE, encodings[j].name);
+      free(enc_data);
+    }
+  }
+  free(file_data);
+  return written;
+}
+
+/** Process a file in the current directory.
+ * @return the number of files written (including pre-compressed variants)
+ *         or -1 on error
+ */
+int process_file(FILE *data_file, FILE *struct_file, const char *filename)
+{
+  u8_t encoding = 0;
+  int files = 0;
+
+  if (encodingVariants && !is_ssi_file(filename) && file_can_be_compressed(filename)
+#if MAKEFS_SUPPORT_DEFLATE
+      && !deflateNonSsiFiles
+#endif /* MAKEFS_SUPPORT_DEFLATE */
+     ) {
+    files = write_encoded_variants(data_file, struct_file, filename);
+    if (files < 0) {
+      return -1;
+    }
+    if (files > 0) {
+      encoding = FS_FILE_FLAGS_ENCODING_VARIANTS;
+    }
+  }
+  if (write_file_entry(data_file, struct_file, filename, encoding, NULL, 0) < 0) {
+    return -1;
+  }
+  return files + 1;
+}
+
 int file_write_http_header(FILE *data_file, const char *filename, int file_size, u16_t *http_hdr_len,
-                           u16_t *http_hdr_chksum, u8_t provide_content_len, int is_compressed)
+                           u16_t *http_hdr_chksum, u8_t provide_content_len, int is_compressed, u8_t encoding,
+                           const char *etag)
 {
   int i = 0;
   int response_type = HTTP_HDR_OK;
@@ -1193,22 +1612,10 @@ int file_write_http_header(FILE *data_file, const char *filename, int file_size,
   }
   if (provide_last_modified) {
     char modbuf[256];
-    struct stat stat_data;
-    struct tm *t;
     memset(modbuf, 0, sizeof(modbuf));
-    memset(&stat_data, 0, sizeof(stat_data));
     cur_string = modbuf;
     strcpy(modbuf, "Last-Modified: ");
-    if (stat(filename, &stat_data) != 0) {
-      printf("stat(%s) failed with error %d\n", filename, errno);
-      exit(-1);
-    }
-    t = gmtime(&stat_data.st_mtime);
-    if (t == NULL) {
-      printf("gmtime() failed with error %d\n", errno);
-      exit(-1);
-    }
-    strftime(&modbuf[15], sizeof(modbuf) - 15, "%a, %d %b %Y %H:%M:%S GMT", t);
+    get_last_modified(filename, &modbuf[15], sizeof(modbuf) - 15);
     cur_len = strlen(cur_string);
     fprintf(data_file, NEWLINE "/* \"%s\"\r\n\" (%"SZT_F"+ bytes) */" NEWLINE, cur_string, cur_len + 2);
     written += file_put_ascii(data_file, cur_string, cur_len, &i);
@@ -1227,6 +1634,19 @@ int file_write_http_header(FILE *data_file, const char *filename, int file_size,
       hdr_len += cur_len;
     }
   }
+  if (etag != NULL) {
+    char etagbuf[64];
+    snprintf(etagbuf, sizeof(etagbuf), "ETag: %s\r\n", etag);
+    cur_string = etagbuf;
+    cur_len = strlen(cur_string);
+    fprintf(data_file, NEWLINE "/* \"ETag: %s\r\n\" (%"SZT_F" bytes) */" NEWLINE, etag, cur_len);
+    written += file_put_ascii(data_file, cur_string, cur_len, &i);
+    i = 0;
+    if (precalcChksum) {
+      memcpy(&hdr_buf[hdr_len], cur_string, cur_len);
+      hdr_len += cur_len;
+    }
+  }
 
   /* HTTP/1.1 implements persistent connections */
   if (useHttp11) {
@@ -1253,14 +1673,39 @@ int file_write_http_header(FILE *data_file, const char *filename, int file_size,
     LWIP_ASSERT("error", deflateNonSsiFiles);
     cur_string = "Content-Encoding: deflate\r\n";
     cur_len = strlen(cur_string);
-    fprintf(data_file, NEWLINE "/* \"%s\" (%d bytes) */" NEWLINE, cur_string, cur_len);
+    fprintf(data_file, NEWLINE "/* \"%s\" (%"SZT_F" bytes) */" NEWLINE, cur_string, cur_len);
     written += file_put_ascii(data_file, cur_string, cur_len, &i);
     i = 0;
+    if (precalcChksum) {
+      LWIP_ASSERT("hdr_len + cur_len <= sizeof(hdr_buf)", hdr_len + cur_len <= sizeof(hdr_buf));
+      memcpy(&hdr_buf[hdr_len], cur_string, cur_len);
+      hdr_len += cur_len;
+    }
   }
 #else
   LWIP_UNUSED_ARG(is_compressed);
 #endif
 
+  if (encoding != 0) {
+    /* tell the client about the encoding of a variant (or that there are variants) */
+    if (encoding & FS_FILE_FLAGS_ENCODING_BR) {
+      cur_string = HTTP_HDR_ENCODING_BR;
+    } else if (encoding & FS_FILE_FLAGS_ENCODING_GZIP) {
+      cur_string = HTTP_HDR_ENCODING_GZIP;
+    } else {
+      cur_string = HTTP_HDR_VARY_ENCODING;
+    }
+    cur_len = strlen(cur_string);
+    fprintf(data_file, NEWLINE "/* \"%s\" (%"SZT_F" bytes) */" NEWLINE, cur_string, cur_len);
+    written += file_put_ascii(data_file, cur_string, cur_len, &i);
+    i = 0;
+    if (precalcChksum) {
+      LWIP_ASSERT("hdr_len + cur_len <= sizeof(hdr_buf)", hdr_len + cur_len <= sizeof(hdr_buf));
+      memcpy(&hdr_buf[hdr_len], cur_string, cur_len);
+      hdr_len += cur_len;
+    }
+  }
+
   /* write content-type, ATTENTION: this includes the double-CRLF! */
   cur_string = file_type;
   cur_len = strlen(cur_string);
@@ -0,0 +1,1086 @@
+/**
+ * @file
+ * pcapng packet capture for lwIP netifs
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+/**
+ * @defgroup pcapng pcapng capture
+ * @ingroup apps
+ *
+ * Live packet capture of lwIP netifs into a RAM ring buffer in pcapng format
+ * (https://www.ietf.org/archive/id/draft-ietf-opsawg-pcapng-03.html).
+ *
+ * @ref pcapng_attach hooks into netif->input and netif->linkoutput of
+ * ethernet netifs (or netif->output/output_ip6 of other netifs, which are
+ * captured as raw IP). Every frame passing through is checked against an
+ * optional filter and stored as Enhanced Packet Block in the ring buffer.
+ * To get a pcapng file, write the result of @ref pcapng_get_header once and
+ * append the blocks returned by @ref pcapng_read.
+ *
+ * Filters are compiled from a small tcpdump-like expression language:
+ * - protocols: ip, ip6, arp, tcp, udp, icmp, icmp6
+ * - [src|dst] host ADDR (IPv4 or IPv6 address)
+ * - [src|dst] port NUM (TCP and UDP)
+ * - inbound, outbound
+ * - combined with 'and'/'&&', 'or'/'||', 'not'/'!' and parentheses.
+ *   Adjacent primitives are combined with 'and' ("tcp port 80").
+ *
+ * The capture functions may run in the context of the netif driver (e.g.
+ * when netif->input is tcpip_input), so the ring buffer is protected by
+ * SYS_ARCH_PROTECT. All API functions have to be called from tcpip_thread
+ * context. Only change the filter while capturing is stopped.
+ */
+
+#include "lwip/apps/pcapng.h"
+
+#include "lwip/opt.h"
+#include "lwip/sys.h"
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/ip4_addr.h"
+#include "lwip/ip6_addr.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip6.h"
+
+#include <string.h>
+
+#if PCAPNG_MAX_NETIFS > 0
+
+#define PCAPNG_RING_WORDS        (PCAPNG_RINGBUF_SIZE / 4)
+#define PCAPNG_RING_BYTES        (PCAPNG_RING_WORDS * 4)
+
+/* pcapng block types */
+#define PCAPNG_BT_SHB            0x0A0D0D0AUL
+#define PCAPNG_BT_IDB            0x00000001UL
+#define PCAPNG_BT_EPB            0x00000006UL
+#define PCAPNG_BYTE_ORDER_MAGIC  0x1A2B3C4DUL
+
+/* pcapng option codes */
+#define PCAPNG_OPT_ENDOFOPT      0
+#define PCAPNG_OPT_IF_NAME       2
+#define PCAPNG_OPT_IF_TSRESOL    9
+#define PCAPNG_OPT_EPB_FLAGS     2
+
+/* LINKTYPE_* values */
+#define PCAPNG_LINKTYPE_ETHERNET 1
+#define PCAPNG_LINKTYPE_RAW      101
+
+/* EPB: 28 bytes header, epb_flags option (8), end of options (4), trailer (4) */
+#define PCAPNG_EPB_OVERHEAD      44
+/* SHB is fixed size without options */
+#define PCAPNG_SHB_LEN           28
+/* IDB: 16 bytes header, if_name (4 + 8), if_tsresol (8), end of options (4), trailer (4) */
+#define PCAPNG_IF_NAME_LEN       8
+#define PCAPNG_IDB_LEN           (16 + 4 + PCAPNG_IF_NAME_LEN + 8 + 4 + 4)
+
+#define PCAPNG_PAD4(x)           (((x) + 3U) & ~3U)
+
+/* two u16_t in host byte order as stored in one u32_t
+   (option code + length, version major + minor, ...) */
+#if BYTE_ORDER == LITTLE_ENDIAN
+#define PCAPNG_U16X2(first, second) ((u32_t)(first) | ((u32_t)(second) << 16))
+#else
+#define PCAPNG_U16X2(first, second) (((u32_t)(first) << 16) | (u32_t)(second))
+#endif
+
+/* direction, stored as epb_flags inbound/outbound value */
+#define PCAPNG_DIR_IN            1
+#define PCAPNG_DIR_OUT           2
+
+/* bytes of a frame copied to evaluate the filter (VLAN + IPv4 w/ options + ports) */
+#define PCAPNG_PARSE_LEN         84
+
+/* filter instructions (postfix) */
+#define PCAPNG_OP_PROTO          0
+#define PCAPNG_OP_HOST           1
+#define PCAPNG_OP_PORT           2
+#define PCAPNG_OP_DIR            3
+#define PCAPNG_OP_AND            4
+#define PCAPNG_OP_OR             5
+#define PCAPNG_OP_NOT            6
+
+/* PCAPNG_OP_PROTO arguments */
+#define PCAPNG_PROTO_IP          0
+#define PCAPNG_PROTO_IP6         1
+#define PCAPNG_PROTO_ARP         2
+#define PCAPNG_PROTO_TCP         3
+#define PCAPNG_PROTO_UDP         4
+#define PCAPNG_PROTO_ICMP        5
+#define PCAPNG_PROTO_ICMP6       6
+
+/* PCAPNG_OP_HOST/PCAPNG_OP_PORT arguments */
+#define PCAPNG_MATCH_ANY         0
+#define PCAPNG_MATCH_SRC         1
+#define PCAPNG_MATCH_DST         2
+
+/* layer 3 protocol of a parsed packet */
+#define PCAPNG_L3_OTHER          0
+#define PCAPNG_L3_IP4            1
+#define PCAPNG_L3_IP6            2
+#define PCAPNG_L3_ARP            3
+
+struct pcapng_insn {
+  u8_t op;
+  u8_t arg;
+  u16_t port;
+  u8_t addr_len;
+  u32_t addr[4];
+};
+
+/** Header fields of a packet as needed by the filter */
+struct pcapng_pkt {
+  u8_t l3;
+  u8_t l4;
+  u8_t dir;
+  u8_t addr_len;
+  u8_t has_ports;
+  u16_t sport;
+  u16_t dport;
+  u32_t src[4];
+  u32_t dst[4];
+};
+
+/** One attached netif and its original functions */
+struct pcapng_if {
+  struct netif *netif;
+  netif_input_fn input;
+  netif_linkoutput_fn linkoutput;
+#if LWIP_IPV4
+  netif_output_fn output;
+#endif /* LWIP_IPV4 */
+#if LWIP_IPV6
+  netif_output_ip6_fn output_ip6;
+#endif /* LWIP_IPV6 */
+  u16_t linktype;
+};
+
+/** Filter compiler state */
+struct pcapng_compiler {
+  const char *pos;
+  struct pcapng_insn *prog;
+  u8_t len;
+  u8_t depth;
+  char tok[48];
+};
+
+static struct pcapng_if pcapng_ifs[PCAPNG_MAX_NETIFS];
+static u32_t pcapng_ring[PCAPNG_RING_WORDS];
+static u32_t pcapng_head;
+static u32_t pcapng_tail;
+static u32_t pcapng_used;
+static struct pcapng_stats pcapng_stats_data;
+static struct pcapng_insn pcapng_filter[PCAPNG_FILTER_MAX_INSNS];
+static u8_t pcapng_filter_len;
+static u16_t pcapng_snaplen = PCAPNG_DEFAULT_SNAPLEN;
+static u8_t pcapng_mode = PCAPNG_MODE_DROP_NEW;
+static volatile u8_t pcapng_running;
+
+/* ---------------------------- ring buffer ---------------------------- */
+
+static void
+pcapng_ring_put32(u32_t val)
+{
+  pcapng_ring[pcapng_head / 4] = val;
+  pcapng_head = (pcapng_head + 4) % PCAPNG_RING_BYTES;
+}
+
+static void
+pcapng_ring_put_pbuf(struct pbuf *p, u16_t len)
+{
+  u8_t *ring = (u8_t *)pcapng_ring;
+  u16_t first = (u16_t)LWIP_MIN(len, PCAPNG_RING_BYTES - pcapng_head);
+
+  pbuf_copy_partial(p, &ring[pcapng_head], first, 0);
+  if (first < len) {
+    pbuf_copy_partial(p, ring, (u16_t)(len - first), first);
+  }
+  pcapng_head = (pcapng_head + len) % PCAPNG_RING_BYTES;
+  /* zero padding up to the next 32-bit boundary */
+  while (pcapng_head & 3) {
+    ring[pcapng_head++] = 0;
+  }
+  pcapng_head %= PCAPNG_RING_BYTES;
+}
+
+/** Copy the block at the read position out of the ring (does not remove it) */
+static void
+pcapng_ring_peek(u8_t *dst, u32_t len)
+{
+  const u8_t *ring = (const u8_t *)pcapng_ring;
+  u32_t first = LWIP_MIN(len, PCAPNG_RING_BYTES - pcapng_tail);
+
+  MEMCPY(dst, &ring[pcapng_tail], first);
+  if (first < len) {
+    MEMCPY(dst + first, ring, len - first);
+  }
+}
+
+static u32_t
+pcapng_ring_first_block_len(void)
+{
+  return pcapng_ring[((pcapng_tail + 4) % PCAPNG_RING_BYTES) / 4];
+}
+
+static void
+pcapng_ring_drop_first(void)
+{
+  u32_t blocklen = pcapng_ring_first_block_len();
+  pcapng_tail = (pcapng_tail + blocklen) % PCAPNG_RING_BYTES;
+  pcapng_used -= blocklen;
+}
+
+/* ------------------------------ filter ------------------------------- */
+
+static void
+pcapng_parse(struct pbuf *p, u16_t linktype, u8_t dir, struct pcapng_pkt *pkt)
+{
+  u8_t hdr[PCAPNG_PARSE_LEN];
+  u16_t len, off = 0;
+
+  memset(pkt, 0, sizeof(struct pcapng_pkt));
+  pkt->dir = dir;
+  len = pbuf_copy_partial(p, hdr, sizeof(hdr), 0);
+
+  if (linktype == PCAPNG_LINKTYPE_ETHERNET) {
+    u16_t type;
+    if (len < SIZEOF_ETH_HDR) {
+      return;
+    }
+    type = (u16_t)((hdr[12] << 8) | hdr[13]);
+    off = SIZEOF_ETH_HDR;
+    if ((type == ETHTYPE_VLAN) && (len >= SIZEOF_ETH_HDR + SIZEOF_VLAN_HDR)) {
+      type = (u16_t)((hdr[16] << 8) | hdr[17]);
+      off = SIZEOF_ETH_HDR + SIZEOF_VLAN_HDR;
+    }
+    if (type == ETHTYPE_ARP) {
+      pkt->l3 = PCAPNG_L3_ARP;
+    } else if (type == ETHTYPE_IP) {
+      pkt->l3 = PCAPNG_L3_IP4;
+    } else if (type == ETHTYPE_IPV6) {
+      pkt->l3 = PCAPNG_L3_IP6;
+    }
+  } else if (len > 0) {
+    if ((hdr[0] >> 4) == 4) {
+      pkt->l3 = PCAPNG_L3_IP4;
+    } else if ((hdr[0] >> 4) == 6) {
+      pkt->l3 = PCAPNG_L3_IP6;
+    }
+  }
+
+  if ((pkt->l3 == PCAPNG_L3_IP4) && (len >= off + 20)) {
+    u16_t ihl = (u16_t)((hdr[off] & 0x0f) * 4);
+    u16_t frag = (u16_t)(((hdr[off + 6] & 0x1f) << 8) | hdr[off + 7]);
+    pkt->l4 = hdr[off + 9];
+    pkt->addr_len = 4;
+    MEMCPY(pkt->src, &hdr[off + 12], 4);
+    MEMCPY(pkt->dst, &hdr[off + 16], 4);
+    if (frag != 0) {
+      /* no transport header in non-first fragments */
+      return;
+    }
+    off = (u16_t)(off + ihl);
+  } else if ((pkt->l3 == PCAPNG_L3_IP6) && (len >= off + IP6_HLEN)) {
+    /* extension headers are not parsed */
+    pkt->l4 = hdr[off + 6];
+    pkt->addr_len = 16;
+    MEMCPY(pkt->src, &hdr[off + 8], 16);
+    MEMCPY(pkt->dst, &hdr[off + 24], 16);
+    off = (u16_t)(off + IP6_HLEN);
+  } else {
+    return;
+  }
+
+  if (((pkt->l4 == IP_PROTO_TCP) || (pkt->l4 == IP_PROTO_UDP) || (pkt->l4 == IP_PROTO_UDPLITE)) &&
+      (len >= off + 4)) {
+    pkt->has_ports = 1;
+    pkt->sport = (u16_t)((hdr[off] << 8) | hdr[off + 1]);
+    pkt->dport = (u16_t)((hdr[off + 2] << 8) | hdr[off + 3]);
+  }
+}
+
+static u8_t
+pcapng_match_proto(const struct pcapng_pkt *pkt, u8_t proto)
+{
+  switch (proto) {
+    case PCAPNG_PROTO_IP:
+      return pkt->l3 == PCAPNG_L3_IP4;
+    case PCAPNG_PROTO_IP6:
+      return pkt->l3 == PCAPNG_L3_IP6;
+    case PCAPNG_PROTO_ARP:
+      return pkt->l3 == PCAPNG_L3_ARP;
+    case PCAPNG_PROTO_TCP:
+      return (pkt->addr_len != 0) && (pkt->l4 == IP_PROTO_TCP);
+    case PCAPNG_PROTO_UDP:
+      return (pkt->addr_len != 0) && (pkt->l4 == IP_PROTO_UDP);
+    case PCAPNG_PROTO_ICMP:
+      return (pkt->l3 == PCAPNG_L3_IP4) && (pkt->addr_len != 0) && (pkt->l4 == IP_PROTO_ICMP);
+    case PCAPNG_PROTO_ICMP6:
+      return (pkt->l3 == PCAPNG_L3_IP6) && (pkt->addr_len != 0) && (pkt->l4 == IP6_NEXTH_ICMP6);
+    default:
+      return 0;
+  }
+}
+
+static u8_t
+pcapng_match_insn(const struct pcapng_insn *insn, const struct pcapng_pkt *pkt)
+{
+  switch (insn->op) {
+    case PCAPNG_OP_PROTO:
+      return pcapng_match_proto(pkt, insn->arg);
+    case PCAPNG_OP_HOST:
+      if (pkt->addr_len != insn->addr_len) {
+        return 0;
+      }
+      return ((insn->arg != PCAPNG_MATCH_DST) && !memcmp(pkt->src, insn->addr, insn->addr_len)) ||
+             ((insn->arg != PCAPNG_MATCH_SRC) && !memcmp(pkt->dst, insn->addr, insn->addr_len));
+    case PCAPNG_OP_PORT:
+      if (!pkt->has_ports) {
+        return 0;
+      }
+      return ((insn->arg != PCAPNG_MATCH_DST) && (pkt->sport == insn->port)) ||
+             ((insn->arg != PCAPNG_MATCH_SRC) && (pkt->dport == insn->port));
+    case PCAPNG_OP_DIR:
+      return pkt->dir == insn->arg;
+    default:
+      return 0;
+  }
+}
+
+/** Run the filter program on a parsed packet */
+static u8_t
+pcapng_filter_match(const struct pcapng_pkt *pkt)
+{
+  u8_t stack[PCAPNG_FILTER_MAX_INSNS];
+  u8_t sp = 0;
+  u8_t i;
+
+  for (i = 0; i < pcapng_filter_len; i++) {
+    const struct pcapng_insn *insn = &pcapng_filter[i];
+    switch (insn->op) {
+      case PCAPNG_OP_AND:
+        sp--;
+        stack[sp - 1] = (u8_t)(stack[sp - 1] && stack[sp]);
+        break;
+      case PCAPNG_OP_OR:
+        sp--;
+        stack[sp - 1] = (u8_t)(stack[sp - 1] || stack[sp]);
+        break;
+      case PCAPNG_OP_NOT:
+        stack[sp - 1] = (u8_t)!stack[sp - 1];
+        break;
+      default:
+        stack[sp++] = pcapng_match_insn(insn, pkt);
+        break;
+    }
+  }
+  return stack[0];
+}
+
+/** Read the next token into c->tok, returns 0 at the end of the expression */
+static u8_t
+pcapng_next_token(struct pcapng_compiler *c, u8_t consume)
+{
+  const char *s = c->pos;
+  size_t n = 0;
+
+  while (*s == ' ' || *s == '\t') {
+    s++;
+  }
+  if (*s == 0) {
+    c->tok[0] = 0;
+    c->pos = s;
+    return 0;
+  }
+  if ((*s == '(') || (*s == ')') || (*s == '!')) {
+    c->tok[n++] = *s++;
+  } else if (((s[0] == '&') && (s[1] == '&')) || ((s[0] == '|') && (s[1] == '|'))) {
+    c->tok[n++] = *s++;
+    c->tok[n++] = *s++;
+  } else {
+    while (*s && (*s != ' ') && (*s != '\t') && (*s != '(') && (*s != ')') && (*s != '!') &&
+           (*s != '&') && (*s != '|')) {
+      if (n >= sizeof(c->tok) - 1) {
+        /* too long: return an invalid token */
+        c->tok[0] = '#';
+        c->tok[1] = 0;
+        return 1;
+      }
+      c->tok[n++] = *s++;
+    }
+    if (n == 0) {
+      /* single '&' or '|' */
+      c->tok[n++] = *s++;
+    }
+  }
+  c->tok[n] = 0;
+  if (consume) {
+    c->pos = s;
+  }
+  return 1;
+}
+
+static err_t
+pcapng_emit(struct pcapng_compiler *c, const struct pcapng_insn *insn)
+{
+  if (c->len >= PCAPNG_FILTER_MAX_INSNS) {
+    LWIP_DEBUGF(PCAPNG_DEBUG, ("pcapng: filter too long\n"));
+    return ERR_MEM;
+  }
+  c->prog[c->len++] = *insn;
+  return ERR_OK;
+}
+
+static err_t
+pcapng_emit_op(struct pcapng_compiler *c, u8_t op)
+{
+  struct pcapng_insn insn;
+  memset(&insn, 0, sizeof(insn));
+  insn.op = op;
+  return pcapng_emit(c, &insn);
+}
+
+static err_t pcapng_compile_or(struct pcapng_compiler *c);
+
+static err_t
+pcapng_compile_primitive(struct pcapng_compiler *c)
+{
+  static const char *const protos[] = {"ip", "ip6", "arp", "tcp", "udp", "icmp", "icmp6"};
+  struct pcapng_insn insn;
+  u8_t i;
+
+  memset(&insn, 0, sizeof(insn));
+  if (!pcapng_next_token(c, 1)) {
+    return ERR_ARG;
+  }
+  for (i = 0; i < LWIP_ARRAYSIZE(protos); i++) {
+    if (!strcmp(c->tok, protos[i])) {
+      insn.op = PCAPNG_OP_PROTO;
+      insn.arg = i;
+      return pcapng_emit(c, &insn);
+    }
+  }
+  if (!strcmp(c->tok, "inbound") || !strcmp(c->tok, "outbound")) {
+    insn.op = PCAPNG_OP_DIR;
+    insn.arg = (c->tok[0] == 'i') ? PCAPNG_DIR_IN : PCAPNG_DIR_OUT;
+    return pcapng_emit(c, &insn);
+  }
+  insn.arg = PCAPNG_MATCH_ANY;
+  if (!strcmp(c->tok, "src") || !strcmp(c->tok, "dst")) {
+    insn.arg = (c->tok[0] == 's') ? PCAPNG_MATCH_SRC : PCAPNG_MATCH_DST;
+    if (!pcapng_next_token(c, 1)) {
+      return ERR_ARG;
+    }
+  }
+  if (!strcmp(c->tok, "host")) {
+    if (!pcapng_next_token(c, 1)) {
+      return ERR_ARG;
+    }
+    insn.op = PCAPNG_OP_HOST;
+#if LWIP_IPV4
+    {
+      ip4_addr_t addr4;
+      if (ip4addr_aton(c->tok, &addr4)) {
+        insn.addr_len = 4;
+        insn.addr[0] = ip4_addr_get_u32(&addr4);
+        return pcapng_emit(c, &insn);
+      }
+    }
+#endif /* LWIP_IPV4 */
+#if LWIP_IPV6
+    {
+      ip6_addr_t addr6;
+      if (ip6addr_aton(c->tok, &addr6)) {
+        insn.addr_len = 16;
+        MEMCPY(insn.addr, addr6.addr, 16);
+        return pcapng_emit(c, &insn);
+      }
+    }
+#endif /* LWIP_IPV6 */
+    LWIP_DEBUGF(PCAPNG_DEBUG, ("pcapng: invalid host '%s'\n", c->tok));
+    return ERR_ARG;
+  }
+  if (!strcmp(c->tok, "port")) {
+    const char *s;
+    u32_t port = 0;
+    if (!pcapng_next_token(c, 1) || (c->tok[0] == 0)) {
+      return ERR_ARG;
+    }
+    for (s = c->tok; *s; s++) {
+      if ((*s < '0') || (*s > '9')) {
+        return ERR_ARG;
+      }
+      port = port * 10 + (u32_t)(*s - '0');
+      if (port > 0xffff) {
+        return ERR_ARG;
+      }
+    }
+    insn.op = PCAPNG_OP_PORT;
+    insn.port = (u16_t)port;
+    return pcapng_emit(c, &insn);
+  }
+  LWIP_DEBUGF(PCAPNG_DEBUG, ("pcapng: unexpected token '%s'\n", c->tok));
+  return ERR_ARG;
+}
+
+static err_t
+pcapng_compile_not(struct pcapng_compiler *c)
+{
+  err_t err;
+
+  if (c->depth > PCAPNG_FILTER_MAX_DEPTH) {
+    /* bound the recursion (and so the stack usage) */
+    LWIP_DEBUGF(PCAPNG_DEBUG, ("pcapng: filter nested too deeply\n"));
+    return ERR_ARG;
+  }
+  if (!pcapng_next_token(c, 0)) {
+    return ERR_ARG;
+  }
+  if (!strcmp(c->tok, "not") || !strcmp(c->tok, "!")) {
+    pcapng_next_token(c, 1);
+    c->depth++;
+    err = pcapng_compile_not(c);
+    c->depth--;
+    if (err != ERR_OK) {
+      return err;
+    }
+    return pcapng_emit_op(c, PCAPNG_OP_NOT);
+  }
+  if (!strcmp(c->tok, "(")) {
+    pcapng_next_token(c, 1);
+    c->depth++;
+    err = pcapng_compile_or(c);
+    c->depth--;
+    if (err != ERR_OK) {
+      return err;
+    }
+    if (!pcapng_next_token(c, 1) || strcmp(c->tok, ")")) {
+      return ERR_ARG;
+    }
+    return ERR_OK;
+  }
+  return pcapng_compile_primitive(c);
+}
+
+static err_t
+pcapng_compile_and(struct pcapng_compiler *c)
+{
+  err_t err = pcapng_compile_not(c);
+
+  while ((err == ERR_OK) && pcapng_next_token(c, 0) &&
+         strcmp(c->tok, "or") && strcmp(c->tok, "||") && strcmp(c->tok, ")")) {
+    if (!strcmp(c->tok, "and") || !strcmp(c->tok, "&&")) {
+      pcapng_next_token(c, 1);
+    }
+    /* else: implicit 'and' between adjacent primitives */
+    err = pcapng_compile_not(c);
+    if (err == ERR_OK) {
+      err = pcapng_emit_op(c, PCAPNG_OP_AND);
+    }
+  }
+  return err;
+}
+
+static err_t
+pcapng_compile_or(struct pcapng_compiler *c)
+{
+  err_t err = pcapng_compile_and(c);
+
+  while ((err == ERR_OK) && pcapng_next_token(c, 0) &&
+         (!strcmp(c->tok, "or") || !strcmp(c->tok, "||"))) {
+    pcapng_next_token(c, 1);
+    err = pcapng_compile_and(c);
+    if (err == ERR_OK) {
+      err = pcapng_emit_op(c, PCAPNG_OP_OR);
+    }
+  }
+  return err;
+}
+
+/* ------------------------------ capture ------------------------------ */
+
+static void
+pcapng_capture(const struct pcapng_if *pif, struct pbuf *p, u8_t dir)
+{
+  u32_t caplen, blocklen, ts;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  caplen = LWIP_MIN(p->tot_len, pcapng_snaplen);
+  blocklen = PCAPNG_EPB_OVERHEAD + PCAPNG_PAD4(caplen);
+
+  if ((pcapng_mode == PCAPNG_MODE_DROP_NEW) || (blocklen > PCAPNG_RING_BYTES)) {
+    /* cheap check first: don't parse packets that would be dropped anyway */
+    if (blocklen > PCAPNG_RING_BYTES - pcapng_used) {
+      SYS_ARCH_PROTECT(lev);
+      pcapng_stats_data.dropped++;
+      SYS_ARCH_UNPROTECT(lev);
+      return;
+    }
+  }
+
+  if (pcapng_filter_len > 0) {
+    struct pcapng_pkt pkt;
+    pcapng_parse(p, pif->linktype, dir, &pkt);
+    if (!pcapng_filter_match(&pkt)) {
+      SYS_ARCH_PROTECT(lev);
+      pcapng_stats_data.filtered++;
+      SYS_ARCH_UNPROTECT(lev);
+      return;
+    }
+  }
+
+  ts = sys_now();
+
+  SYS_ARCH_PROTECT(lev);
+  if (blocklen > PCAPNG_RING_BYTES - pcapng_used) {
+    if (pcapng_mode == PCAPNG_MODE_DROP_NEW) {
+      pcapng_stats_data.dropped++;
+      SYS_ARCH_UNPROTECT(lev);
+      return;
+    }
+    while (blocklen > PCAPNG_RING_BYTES - pcapng_used) {
+      pcapng_ring_drop_first();
+      pcapng_stats_data.overwritten++;
+    }
+  }
+  pcapng_ring_put32(PCAPNG_BT_EPB);
+  pcapng_ring_put32(blocklen);
+  pcapng_ring_put32((u32_t)(pif - pcapng_ifs));
+  /* timestamps are in milliseconds (if_tsresol), sys_now() wraps at 32 bit */
+  pcapng_ring_put32(0);
+  pcapng_ring_put32(ts);
+  pcapng_ring_put32(caplen);
+  pcapng_ring_put32(p->tot_len);
+  pcapng_ring_put_pbuf(p, (u16_t)caplen);
+  pcapng_ring_put32(PCAPNG_U16X2(PCAPNG_OPT_EPB_FLAGS, 4));
+  pcapng_ring_put32(dir);
+  pcapng_ring_put32(PCAPNG_OPT_ENDOFOPT);
+  pcapng_ring_put32(blocklen);
+  pcapng_used += blocklen;
+  pcapng_stats_data.captured++;
+  SYS_ARCH_UNPROTECT(lev);
+}
+
+static struct pcapng_if *
+pcapng_find(const struct netif *netif)
+{
+  u8_t i;
+  for (i = 0; i < PCAPNG_MAX_NETIFS; i++) {
+    if (pcapng_ifs[i].netif == netif) {
+      return &pcapng_ifs[i];
+    }
+  }
+  return NULL;
+}
+
+static err_t
+pcapng_input(struct pbuf *p, struct netif *inp)
+{
+  struct pcapng_if *pif = pcapng_find(inp);
+  LWIP_ASSERT("pcapng_input: netif not attached", pif != NULL);
+
+  if (pcapng_running) {
+    pcapng_capture(pif, p, PCAPNG_DIR_IN);
+  }
+  return pif->input(p, inp);
+}
+
+static err_t
+pcapng_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  struct pcapng_if *pif = pcapng_find(netif);
+  LWIP_ASSERT("pcapng_linkoutput: netif not attached", pif != NULL);
+
+  if (pcapng_running) {
+    pcapng_capture(pif, p, PCAPNG_DIR_OUT);
+  }
+  return pif->linkoutput(netif, p);
+}
+
+#if LWIP_IPV4
+static err_t
+pcapng_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  struct pcapng_if *pif = pcapng_find(netif);
+  LWIP_ASSERT("pcapng_output: netif not attached", pif != NULL);
+
+  if (pcapng_running) {
+    pcapng_capture(pif, p, PCAPNG_DIR_OUT);
+  }
+  return pif->output(netif, p, ipaddr);
+}
+#endif /* LWIP_IPV4 */
+
+#if LWIP_IPV6
+static err_t
+pcapng_output_ip6(struct netif *netif, struct pbuf *p, const ip6_addr_t *ipaddr)
+{
+  struct pcapng_if *pif = pcapng_find(netif);
+  LWIP_ASSERT("pcapng_output_ip6: netif not attached", pif != NULL);
+
+  if (pcapng_running) {
+    pcapng_capture(pif, p, PCAPNG_DIR_OUT);
+  }
+  return pif->output_ip6(netif, p, ipaddr);
+}
+#endif /* LWIP_IPV6 */
+
+/* -------------------------------- API -------------------------------- */
+
+/**
+ * @ingroup pcapng
+ * Stop capturing, detach all netifs, clear the ring buffer, statistics and
+ * filter and restore the default mode and snaplen.
+ */
+void
+pcapng_init(void)
+{
+  u8_t i;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  pcapng_running = 0;
+  for (i = 0; i < PCAPNG_MAX_NETIFS; i++) {
+    if (pcapng_ifs[i].netif != NULL) {
+      pcapng_detach(pcapng_ifs[i].netif);
+    }
+  }
+  pcapng_head = pcapng_tail = pcapng_used = 0;
+  memset(&pcapng_stats_data, 0, sizeof(pcapng_stats_data));
+  pcapng_filter_len = 0;
+  pcapng_snaplen = PCAPNG_DEFAULT_SNAPLEN;
+  pcapng_mode = PCAPNG_MODE_DROP_NEW;
+}
+
+/**
+ * @ingroup pcapng
+ * Start capturing on a netif. Ethernet netifs are captured at link level
+ * (input and linkoutput), other netifs at IP level (input and output).
+ * The interface id in the capture is the index of the attach slot.
+ *
+ * @param netif the netif to capture. Its functions must not be changed by
+ *              anyone else while attached. If netif->input is called from
+ *              a driver thread, attach while the netif is not receiving.
+ * @return ERR_OK on success, ERR_MEM if PCAPNG_MAX_NETIFS are attached
+ */
+err_t
+pcapng_attach(struct netif *netif)
+{
+  struct pcapng_if *pif;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("pcapng_attach: invalid netif", netif != NULL, return ERR_ARG);
+
+  if (pcapng_find(netif) != NULL) {
+    return ERR_ALREADY;
+  }
+  pif = pcapng_find(NULL);
+  if (pif == NULL) {
+    return ERR_MEM;
+  }
+  memset(pif, 0, sizeof(struct pcapng_if));
+  pif->netif = netif;
+  pif->input = netif->input;
+  netif->input = pcapng_input;
+  if ((netif->flags & (NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET)) && (netif->linkoutput != NULL)) {
+    pif->linktype = PCAPNG_LINKTYPE_ETHERNET;
+    pif->linkoutput = netif->linkoutput;
+    netif->linkoutput = pcapng_linkoutput;
+  } else {
+    pif->linktype = PCAPNG_LINKTYPE_RAW;
+#if LWIP_IPV4
+    if (netif->output != NULL) {
+      pif->output = netif->output;
+      netif->output = pcapng_output;
+    }
+#endif /* LWIP_IPV4 */
+#if LWIP_IPV6
+    if (netif->output_ip6 != NULL) {
+      pif->output_ip6 = netif->output_ip6;
+      netif->output_ip6 = pcapng_output_ip6;
+    }
+#endif /* LWIP_IPV6 */
+  }
+  return ERR_OK;
+}
+
+/**
+ * @ingroup pcapng
+ * Stop capturing on a netif and restore its functions.
+ * If netif->input is called from a driver thread, detach while the netif is
+ * not receiving.
+ *
+ * @param netif the netif passed to @ref pcapng_attach
+ * @return ERR_OK on success, ERR_VAL if the netif is not attached
+ */
+err_t
+pcapng_detach(struct netif *netif)
+{
+  struct pcapng_if *pif;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("pcapng_detach: invalid netif", netif != NULL, return ERR_ARG);
+
+  pif = pcapng_find(netif);
+  if (pif == NULL) {
+    return ERR_VAL;
+  }
+  netif->input = pif->input;
+  if (pif->linkoutput != NULL) {
+    netif->linkoutput = pif->linkoutput;
+  }
+#if LWIP_IPV4
+  if (pif->output != NULL) {
+    netif->output = pif->output;
+  }
+#endif /* LWIP_IPV4 */
+#if LWIP_IPV6
+  if (pif->output_ip6 != NULL) {
+    netif->output_ip6 = pif->output_ip6;
+  }
+#endif /* LWIP_IPV6 */
+  /* keep linktype so that the interface description stays valid */
+  pif->netif = NULL;
+  return ERR_OK;
+}
+
+/**
+ * @ingroup pcapng
+ * Compile and install a capture filter (see @ref pcapng for the syntax).
+ *
+ * @param expr filter expression, NULL or "" to capture everything
+ * @return ERR_OK on success, ERR_ARG on syntax errors (or nesting deeper than
+ *         PCAPNG_FILTER_MAX_DEPTH), ERR_MEM if the filter needs more than
+ *         PCAPNG_FILTER_MAX_INSNS instructions. On error,
+ *         the previous filter is kept.
+ */
+err_t
+pcapng_set_filter(const char *expr)
+{
+  struct pcapng_insn prog[PCAPNG_FILTER_MAX_INSNS];
+  struct pcapng_compiler c;
+  err_t err;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  memset(&c, 0, sizeof(c));
+  c.pos = expr;
+  c.prog = prog;
+  if ((expr == NULL) || !pcapng_next_token(&c, 0)) {
+    pcapng_filter_len = 0;
+    return ERR_OK;
+  }
+  err = pcapng_compile_or(&c);
+  if ((err == ERR_OK) && pcapng_next_token(&c, 0)) {
+    /* trailing garbage, e.g. unbalanced ')' */
+    LWIP_DEBUGF(PCAPNG_DEBUG, ("pcapng: unexpected token '%s'\n", c.tok));
+    err = ERR_ARG;
+  }
+  if (err != ERR_OK) {
+    return err;
+  }
+  MEMCPY(pcapng_filter, prog, c.len * sizeof(struct pcapng_insn));
+  pcapng_filter_len = c.len;
+  return ERR_OK;
+}
+
+/**
+ * @ingroup pcapng
+ * Set what happens when the ring buffer is full.
+ *
+ * @param mode PCAPNG_MODE_DROP_NEW or PCAPNG_MODE_OVERWRITE
+ */
+void
+pcapng_set_mode(u8_t mode)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  pcapng_mode = mode;
+}
+
+/**
+ * @ingroup pcapng
+ * Set the maximum number of bytes stored per packet. Changing this while
+ * there is data in the ring buffer makes the snaplen reported by
+ * @ref pcapng_get_header inaccurate for older packets (which is harmless).
+ */
+void
+pcapng_set_snaplen(u16_t snaplen)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  pcapng_snaplen = snaplen;
+}
+
+/**
+ * @ingroup pcapng
+ * Start capturing on all attached netifs.
+ */
+void
+pcapng_start(void)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  pcapng_running = 1;
+}
+
+/**
+ * @ingroup pcapng
+ * Stop capturing. The ring buffer keeps its contents.
+ */
+void
+pcapng_stop(void)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  pcapng_running = 0;
+}
+
+static void
+pcapng_put32(u8_t *buf, u16_t *off, u32_t val)
+{
+  MEMCPY(&buf[*off], &val, 4);
+  *off = (u16_t)(*off + 4);
+}
+
+/**
+ * @ingroup pcapng
+ * Get the pcapng file header: a Section Header Block plus one Interface
+ * Description Block per attach slot used so far.
+ *
+ * @param buf buffer to write the header to
+ * @param len size of buf
+ * @return number of bytes written or 0 if buf is too small
+ */
+u16_t
+pcapng_get_header(u8_t *buf, u16_t len)
+{
+  u16_t off = 0;
+  u8_t i, num_ifs = 0;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("pcapng_get_header: invalid buf", buf != NULL, return 0);
+
+  for (i = 0; i < PCAPNG_MAX_NETIFS; i++) {
+    if (pcapng_ifs[i].linktype != 0) {
+      num_ifs = (u8_t)(i + 1);
+    }
+  }
+  if (len < PCAPNG_SHB_LEN + num_ifs * PCAPNG_IDB_LEN) {
+    return 0;
+  }
+
+  pcapng_put32(buf, &off, PCAPNG_BT_SHB);
+  pcapng_put32(buf, &off, PCAPNG_SHB_LEN);
+  pcapng_put32(buf, &off, PCAPNG_BYTE_ORDER_MAGIC);
+  /* version 1.0 */
+  pcapng_put32(buf, &off, PCAPNG_U16X2(1, 0));
+  /* section length unknown */
+  pcapng_put32(buf, &off, 0xFFFFFFFFUL);
+  pcapng_put32(buf, &off, 0xFFFFFFFFUL);
+  pcapng_put32(buf, &off, PCAPNG_SHB_LEN);
+
+  for (i = 0; i < num_ifs; i++) {
+    const struct pcapng_if *pif = &pcapng_ifs[i];
+    char name[PCAPNG_IF_NAME_LEN];
+    u16_t linktype = pif->linktype ? pif->linktype : PCAPNG_LINKTYPE_ETHERNET;
+    u8_t tsresol[4] = {3, 0, 0, 0};
+
+    memset(name, 0, sizeof(name));
+    if (pif->netif != NULL) {
+      name[0] = pif->netif->name[0];
+      name[1] = pif->netif->name[1];
+      lwip_itoa(&name[2], sizeof(name) - 2, pif->netif->num);
+    }
+    pcapng_put32(buf, &off, PCAPNG_BT_IDB);
+    pcapng_put32(buf, &off, PCAPNG_IDB_LEN);
+    pcapng_put32(buf, &off, PCAPNG_U16X2(linktype, 0));
+    pcapng_put32(buf, &off, pcapng_snaplen);
+    pcapng_put32(buf, &off, PCAPNG_U16X2(PCAPNG_OPT_IF_NAME, PCAPNG_IF_NAME_LEN));
+    MEMCPY(&buf[off], name, PCAPNG_IF_NAME_LEN);
+    off = (u16_t)(off + PCAPNG_IF_NAME_LEN);
+    /* timestamp resolution 10^-3 (sys_now() ticks) */
+    pcapng_put32(buf, &off, PCAPNG_U16X2(PCAPNG_OPT_IF_TSRESOL, 1));
+    MEMCPY(&buf[off], tsresol, 4);
+    off = (u16_t)(off + 4);
+    pcapng_put32(buf, &off, PCAPNG_OPT_ENDOFOPT);
+    pcapng_put32(buf, &off, PCAPNG_IDB_LEN);
+  }
+  return off;
+}
+
+/**
+ * @ingroup pcapng
+ * Remove captured packets (complete Enhanced Packet Blocks) from the ring
+ * buffer.
+ *
+ * @param buf buffer to copy the blocks to
+ * @param len size of buf
+ * @return number of bytes copied (0 if there is no data or the first block
+ *         does not fit into buf)
+ */
+u32_t
+pcapng_read(u8_t *buf, u32_t len)
+{
+  u32_t off = 0;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  LWIP_ERROR("pcapng_read: invalid buf", buf != NULL, return 0);
+
+  SYS_ARCH_PROTECT(lev);
+  while (pcapng_used > 0) {
+    u32_t blocklen = pcapng_ring_first_block_len();
+    if (blocklen > len - off) {
+      break;
+    }
+    pcapng_ring_peek(&buf[off], blocklen);
+    pcapng_ring_drop_first();
+    off += blocklen;
+  }
+  SYS_ARCH_UNPROTECT(lev);
+  return off;
+}
+
+/**
+ * @ingroup pcapng
+ * Get the capture statistics.
+ */
+void
+pcapng_get_stats(struct pcapng_stats *stats)
+{
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  LWIP_ERROR("pcapng_get_stats: invalid stats", stats != NULL, return);
+
+  SYS_ARCH_PROTECT(lev);
+  *stats = pcapng_stats_data;
+  SYS_ARCH_UNPROTECT(lev);
+}
+
+#endif /* PCAPNG_MAX_NETIFS > 0 */
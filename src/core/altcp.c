@@ -385,6 +385,26 @@ altcp_write(struct altcp_pcb *conn, const void *dataptr, u16_t len, u8_t apiflag
   return ERR_VAL;
 }
 
+#if LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP
+/**
+ * @ingroup altcp
+ * Write data with a checksum calculated in advance. Only plain TCP
+ * connections use the checksum, layers that transform the data pass it to
+ * altcp_write() (see altcp_default_write_chksum()), as do layers that don't
+ * implement write_chksum.
+ * @see tcp_write_chksum()
+ */
+err_t
+altcp_write_chksum(struct altcp_pcb *conn, const void *dataptr, u16_t len, u8_t apiflags, u16_t chksum)
+{
+  if (conn && conn->fns && conn->fns->write_chksum) {
+    return conn->fns->write_chksum(conn, dataptr, len, apiflags, chksum);
+  }
+  LWIP_UNUSED_ARG(chksum);
+  return altcp_write(conn, dataptr, len, apiflags);
+}
+#endif /* LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP */
+
 /**
  * @ingroup altcp
  * @see tcp_output()
@@ -702,6 +722,16 @@ altcp_default_keepalive_enable(struct altcp_pcb *conn, u32_t idle, u32_t intvl,
 }
 #endif
 
+#if LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP
+err_t
+altcp_default_write_chksum(struct altcp_pcb *conn, const void *dataptr, u16_t len, u8_t apiflags, u16_t chksum)
+{
+  /* the data is written through this layer, which may transform it */
+  LWIP_UNUSED_ARG(chksum);
+  return altcp_write(conn, dataptr, len, apiflags);
+}
+#endif
+
 #ifdef LWIP_DEBUG
 enum tcp_state
 altcp_default_dbg_get_tcp_state(struct altcp_pcb *conn)
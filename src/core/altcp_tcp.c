@@ -363,6 +363,20 @@ altcp_tcp_write(struct altcp_pcb *conn, const void *dataptr, u16_t len, u8_t api
   return tcp_write(pcb, dataptr, len, apiflags);
 }
 
+#if LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP
+static err_t
+altcp_tcp_write_chksum(struct altcp_pcb *conn, const void *dataptr, u16_t len, u8_t apiflags, u16_t chksum)
+{
+  struct tcp_pcb *pcb;
+  if (conn == NULL) {
+    return ERR_VAL;
+  }
+  ALTCP_TCP_ASSERT_CONN(conn);
+  pcb = (struct tcp_pcb *)conn->state;
+  return tcp_write_chksum(pcb, dataptr, len, apiflags, chksum);
+}
+#endif
+
 static err_t
 altcp_tcp_output(struct altcp_pcb *conn)
 {
@@ -573,6 +587,9 @@ const struct altcp_functions altcp_tcp_functions = {
 #ifdef LWIP_DEBUG
   , altcp_tcp_dbg_get_tcp_state
 #endif
+#if LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP
+  , altcp_tcp_write_chksum
+#endif
 };
 
 #endif /* LWIP_ALTCP */
@@ -169,6 +169,12 @@ PACK_STRUCT_END
 #if (LWIP_TCP && LWIP_TCP_SACK_OUT && (LWIP_TCP_MAX_SACK_NUM < 1))
 #error "LWIP_TCP_MAX_SACK_NUM must be greater than 0"
 #endif
+#if (LWIP_TCP && LWIP_TCP_SYNCOOKIES && !(LWIP_CALLBACK_API || TCP_LISTEN_BACKLOG))
+#error "LWIP_TCP_SYNCOOKIES needs LWIP_CALLBACK_API or TCP_LISTEN_BACKLOG to track the SYN queue"
+#endif
+#if (LWIP_IPV4 && LWIP_IPV4_FIB && LWIP_SINGLE_NETIF)
+#error "LWIP_IPV4_FIB makes no sense with LWIP_SINGLE_NETIF"
+#endif
 #if (LWIP_NETIF_API && (NO_SYS==1))
 #error "If you want to use NETIF API, you have to define NO_SYS=0 in your lwipopts.h"
 #endif
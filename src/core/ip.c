@@ -59,6 +59,9 @@
 
 #include "lwip/ip_addr.h"
 #include "lwip/ip.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/ip6.h"
 
 /** Global data for both IPv4 and IPv6 */
 struct ip_globals ip_data;
@@ -164,4 +167,206 @@ ip_input(struct pbuf *p, struct netif *inp)
 
 #endif /* LWIP_IPV4 && LWIP_IPV6 */
 
+#if LWIP_FIB_ECMP
+/** Mix one word into a flow hash (MurmurHash3 block step) */
+static u32_t
+ip_flow_hash_mix(u32_t h, u32_t v)
+{
+  v *= 0xcc9e2d51UL;
+  v = (v << 15) | (v >> 17);
+  v *= 0x1b873593UL;
+  h ^= v;
+  h = (h << 13) | (h >> 19);
+  return (h * 5) + 0xe6546b64UL;
+}
+
+/** Mix the transport protocol and ports into a flow hash and finalize it */
+static u32_t
+ip_flow_hash_final(u32_t h, u8_t proto, u16_t sport, u16_t dport)
+{
+  h = ip_flow_hash_mix(h, ((u32_t)sport << 16) | dport);
+  h ^= proto;
+  h ^= h >> 16;
+  h *= 0x85ebca6bUL;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35UL;
+  h ^= h >> 16;
+  return h;
+}
+
+#if LWIP_IPV4
+/**
+ * @ingroup ip4
+ * Calculate the hash of a flow used to select one of several equal-cost
+ * paths (see ip4_route_flow()).
+ *
+ * @param src source address or NULL for locally originated traffic (the
+ *        local address is only known after the route lookup)
+ * @param dest destination address
+ * @param proto transport protocol
+ * @param sport source port or 0
+ * @param dport destination port or 0
+ * @return the flow hash
+ */
+u32_t
+ip4_flow_hash(const ip4_addr_t *src, const ip4_addr_t *dest, u8_t proto, u16_t sport, u16_t dport)
+{
+  u32_t h = ip_flow_hash_mix(0, ip4_addr_get_u32(dest));
+  if (src != NULL) {
+    h = ip_flow_hash_mix(h, ip4_addr_get_u32(src));
+  }
+  return ip_flow_hash_final(h, proto, sport, dport);
+}
+#endif /* LWIP_IPV4 */
+
+#if LWIP_IPV6
+/**
+ * @ingroup ip6
+ * Calculate the hash of a flow used to select one of several equal-cost
+ * paths (see ip6_route_flow()).
+ *
+ * @param src source address or NULL for locally originated traffic (the
+ *        local address is only known after the route lookup)
+ * @param dest destination address
+ * @param proto transport protocol
+ * @param sport source port or 0
+ * @param dport destination port or 0
+ * @return the flow hash
+ */
+u32_t
+ip6_flow_hash(const ip6_addr_t *src, const ip6_addr_t *dest, u8_t proto, u16_t sport, u16_t dport)
+{
+  u32_t h = 0;
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    h = ip_flow_hash_mix(h, dest->addr[i]);
+  }
+  if (src != NULL) {
+    for (i = 0; i < 4; i++) {
+      h = ip_flow_hash_mix(h, src->addr[i]);
+    }
+  }
+  return ip_flow_hash_final(h, proto, sport, dport);
+}
+#endif /* LWIP_IPV6 */
+#endif /* LWIP_FIB_ECMP */
+
+#if LWIP_NETIF_FRAG_OFFLOAD
+/** Read a 16 bit field in network byte order from a packet */
+static u16_t
+ip_frag_offload_get_u16(const struct pbuf *p, u16_t offset)
+{
+  return (u16_t)((pbuf_get_at(p, offset) << 8) | pbuf_get_at(p, (u16_t)(offset + 1)));
+}
+
+/**
+ * @ingroup ip
+ * Get the layout of the fragments a netif doing fragmentation itself (see
+ * LWIP_NETIF_FRAG_OFFLOAD) has to create from an outgoing packet.
+ * Each fragment consists of a copy of the first desc->hdr_len bytes of the
+ * packet, adapted by ip_frag_offload_hdr(), followed by the next (up to)
+ * desc->frag_size of the desc->data_len data bytes following them.
+ *
+ * @param p the packet as passed to netif->linkoutput()
+ * @param ip_offset offset of the IP header in p (the link header length)
+ * @param desc filled with the fragment layout
+ * @return ERR_OK if the packet has to be fragmented,
+ *         ERR_VAL if it can be sent as is
+ */
+err_t
+ip_frag_offload_desc(const struct pbuf *p, u16_t ip_offset, struct ip_frag_desc *desc)
+{
+  int v;
+
+  LWIP_ASSERT("p != NULL", p != NULL);
+  LWIP_ASSERT("desc != NULL", desc != NULL);
+
+  if (p->frag_size == 0) {
+    return ERR_VAL;
+  }
+  v = pbuf_try_get_at(p, ip_offset);
+  if (v < 0) {
+    return ERR_VAL;
+  }
+  desc->ip_offset = ip_offset;
+  desc->frag_size = p->frag_size;
+  desc->ip_version = (u8_t)(v >> 4);
+  switch (desc->ip_version) {
+#if LWIP_IPV4
+    case 4: {
+      u16_t hlen = (u16_t)((v & 0x0f) * 4);
+      desc->hdr_len = (u16_t)(ip_offset + hlen);
+      desc->data_len = (u16_t)(ip_frag_offload_get_u16(p, (u16_t)(ip_offset + 2)) - hlen);
+      break;
+    }
+#endif /* LWIP_IPV4 */
+#if LWIP_IPV6
+    case 6:
+      /* ip6_frag() has inserted the fragment header right after the IPv6 header */
+      if (pbuf_get_at(p, (u16_t)(ip_offset + 6)) != IP6_NEXTH_FRAGMENT) {
+        return ERR_VAL;
+      }
+      desc->hdr_len = (u16_t)(ip_offset + IP6_HLEN + IP6_FRAG_HLEN);
+      desc->data_len = (u16_t)(ip_frag_offload_get_u16(p, (u16_t)(ip_offset + 4)) - IP6_FRAG_HLEN);
+      break;
+#endif /* LWIP_IPV6 */
+    default:
+      return ERR_VAL;
+  }
+  LWIP_ERROR("ip_frag_offload_desc: packet too short",
+             p->tot_len >= desc->hdr_len + desc->data_len, return ERR_VAL;);
+  return (desc->data_len > desc->frag_size) ? ERR_OK : ERR_VAL;
+}
+
+/**
+ * @ingroup ip
+ * Adapt the headers of one fragment created by a netif doing fragmentation
+ * itself (see ip_frag_offload_desc()).
+ *
+ * @param netif the netif sending the fragment (for its checksum settings)
+ * @param desc fragment layout from ip_frag_offload_desc()
+ * @param hdr copy of the first desc->hdr_len bytes of the packet, aligned like
+ *        the packet (modified)
+ * @param offset offset of the fragment's data (a multiple of desc->frag_size)
+ * @param len number of data bytes in the fragment
+ */
+void
+ip_frag_offload_hdr(struct netif *netif, const struct ip_frag_desc *desc, u8_t *hdr, u16_t offset, u16_t len)
+{
+  u8_t last;
+
+  LWIP_ASSERT("invalid fragment", ((offset & 7) == 0) && (offset + len <= desc->data_len));
+  last = ((offset + len) == desc->data_len) ? 1 : 0;
+#if LWIP_IPV4
+  if (desc->ip_version == 4) {
+    struct ip_hdr *iphdr = (struct ip_hdr *)(void *)(hdr + desc->ip_offset);
+    u16_t tmp = lwip_ntohs(IPH_OFFSET(iphdr));
+    /* the packet may be a fragment already: keep its offset and MF */
+    u16_t ofo = (u16_t)(((tmp & IP_OFFMASK) + (offset / 8)) & IP_OFFMASK);
+    if (!last || ((tmp & IP_MF) != 0)) {
+      ofo |= IP_MF;
+    }
+    IPH_OFFSET_SET(iphdr, lwip_htons(ofo));
+    IPH_LEN_SET(iphdr, lwip_htons((u16_t)(len + IPH_HL_BYTES(iphdr))));
+    IPH_CHKSUM_SET(iphdr, 0);
+#if CHECKSUM_GEN_IP
+    IF__NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_IP) {
+      IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IPH_HL_BYTES(iphdr)));
+    }
+#endif /* CHECKSUM_GEN_IP */
+  }
+#endif /* LWIP_IPV4 */
+#if LWIP_IPV6
+  if (desc->ip_version == 6) {
+    struct ip6_hdr *ip6hdr = (struct ip6_hdr *)(void *)(hdr + desc->ip_offset);
+    struct ip6_frag_hdr *frag_hdr = (struct ip6_frag_hdr *)(void *)(hdr + desc->ip_offset + IP6_HLEN);
+    frag_hdr->_fragment_offset = lwip_htons((u16_t)((offset & IP6_FRAG_OFFSET_MASK) | (last ? 0 : IP6_FRAG_MORE_FLAG)));
+    IP6H_PLEN_SET(ip6hdr, (u16_t)(len + IP6_FRAG_HLEN));
+  }
+#endif /* LWIP_IPV6 */
+  LWIP_UNUSED_ARG(netif);
+}
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
+
 #endif /* LWIP_IPV4 || LWIP_IPV6 */
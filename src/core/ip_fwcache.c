@@ -0,0 +1,275 @@
+/**
+ * @file
+ * IP forwarding flow cache
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+
+/**
+ * @defgroup ip_fwcache Forwarding flow cache
+ * @ingroup ip
+ *
+ * Cache of forwarding decisions keyed on (input netif, destination address)
+ * and, with LWIP_FIB_ECMP, the flow hash that selected the path, used by
+ * ip4_forward() and ip6_forward() so that packets of an established flow skip
+ * the route lookup and, on netifs using etharp_output(), the gateway
+ * selection and ARP table search. The MTU of the output netif is cached, too.
+ *
+ * The cache is direct-mapped (IP_FORWARD_FLOW_CACHE_SIZE slots, a new flow
+ * replaces the one in its slot). Instead of tracking which entries depend on
+ * which route, every change that can affect routing (netif up/down, link,
+ * address, gateway and default netif changes, ip4_fib/ip6_fib changes)
+ * increments a generation counter, which invalidates all entries at once.
+ * ARP entries are not tracked by the generation: the cached ARP table index is
+ * validated for every packet and looked up again if it went stale.
+ *
+ * Routing decisions made by hooks (LWIP_HOOK_IP4_ROUTE_SRC,
+ * LWIP_HOOK_IP6_ROUTE, LWIP_HOOK_ETHARP_GET_GW) are cached as well: call
+ * ip_fwcache_invalidate() when their result changes. If
+ * LWIP_HOOK_IP4_ROUTE_SRC is defined, the IPv4 source address is part of
+ * the key (ip6_forward() doesn't pass the source address to its hook).
+ * Drivers that change netif->mtu of an active netif must call
+ * ip_fwcache_invalidate(), too.
+ */
+
+#include "lwip/opt.h"
+
+#if IP_FORWARD_FLOW_CACHE /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/ip_fwcache.h"
+#include "lwip/ip.h"
+#include "lwip/etharp.h"
+#include "lwip/priv/hash_priv.h"
+
+#include <string.h>
+
+#if (IP_FORWARD_FLOW_CACHE_SIZE & (IP_FORWARD_FLOW_CACHE_SIZE - 1)) != 0
+#error "IP_FORWARD_FLOW_CACHE_SIZE must be a power of 2"
+#endif
+
+/** Entries with another generation are invalid (0 is never used, so that
+ * zero-initialized entries are invalid) */
+static u16_t ip_fwcache_generation = 1;
+
+#if LWIP_IPV4 && IP_FORWARD
+static struct ip4_fwcache_entry ip4_fwcache[IP_FORWARD_FLOW_CACHE_SIZE];
+
+/** Slot of (src, dest, inp, flow_hash) */
+static u16_t
+ip4_fwcache_hash(const ip4_addr_t *src, const ip4_addr_t *dest, const struct netif *inp, u32_t flow_hash)
+{
+  u32_t h = ip4_addr_get_u32(dest) ^ flow_hash ^ inp->num;
+#ifdef LWIP_HOOK_IP4_ROUTE_SRC
+  h ^= ip4_addr_get_u32(src) * 0x9E3779B1UL;
+#else /* LWIP_HOOK_IP4_ROUTE_SRC */
+  LWIP_UNUSED_ARG(src);
+#endif /* LWIP_HOOK_IP4_ROUTE_SRC */
+  return LWIP_HASH_BUCKET(h, IP_FORWARD_FLOW_CACHE_SIZE);
+}
+
+/**
+ * Look up the cached forwarding decision for a packet.
+ *
+ * @param src source address of the packet (only used with LWIP_HOOK_IP4_ROUTE_SRC)
+ * @param dest destination address of the packet
+ * @param inp netif the packet was received on
+ * @param flow_hash ip4_flow_hash() of the packet with LWIP_FIB_ECMP, else 0
+ * @return the valid cache entry or NULL
+ */
+struct ip4_fwcache_entry *
+ip4_fwcache_lookup(const ip4_addr_t *src, const ip4_addr_t *dest, const struct netif *inp, u32_t flow_hash)
+{
+  struct ip4_fwcache_entry *entry = &ip4_fwcache[ip4_fwcache_hash(src, dest, inp, flow_hash)];
+
+  if ((entry->generation == ip_fwcache_generation) && (entry->inp == inp) &&
+#if LWIP_FIB_ECMP
+      (entry->flow_hash == flow_hash) &&
+#endif /* LWIP_FIB_ECMP */
+#ifdef LWIP_HOOK_IP4_ROUTE_SRC
+      ip4_addr_eq(&entry->src, src) &&
+#endif /* LWIP_HOOK_IP4_ROUTE_SRC */
+      ip4_addr_eq(&entry->dest, dest)) {
+    return entry;
+  }
+  return NULL;
+}
+
+/**
+ * Cache the forwarding decision for packets to dest received on inp
+ * (replacing the entry in its slot).
+ *
+ * @param src source address (only used with LWIP_HOOK_IP4_ROUTE_SRC)
+ * @param dest destination address
+ * @param inp input netif
+ * @param netif output netif found by ip4_route_flow()
+ * @param flow_hash ip4_flow_hash() of the packet with LWIP_FIB_ECMP, else 0
+ * @return the new cache entry
+ */
+struct ip4_fwcache_entry *
+ip4_fwcache_add(const ip4_addr_t *src, const ip4_addr_t *dest, struct netif *inp, struct netif *netif, u32_t flow_hash)
+{
+  struct ip4_fwcache_entry *entry = &ip4_fwcache[ip4_fwcache_hash(src, dest, inp, flow_hash)];
+
+  ip4_addr_copy(entry->dest, *dest);
+#ifdef LWIP_HOOK_IP4_ROUTE_SRC
+  ip4_addr_copy(entry->src, *src);
+#endif /* LWIP_HOOK_IP4_ROUTE_SRC */
+  entry->inp = inp;
+#if LWIP_FIB_ECMP
+  entry->flow_hash = flow_hash;
+#endif /* LWIP_FIB_ECMP */
+  entry->netif = netif;
+  entry->mtu = netif->mtu;
+#if LWIP_ARP
+  ip4_addr_set_any(&entry->next_hop);
+  entry->arp_idx = ARP_TABLE_SIZE;
+  if ((netif->output == etharp_output) &&
+      !ip4_addr_isbroadcast(dest, netif) && !ip4_addr_ismulticast(dest)) {
+    const ip4_addr_t *next_hop = etharp_next_hop(netif, dest);
+    if (next_hop != NULL) {
+      ip4_addr_copy(entry->next_hop, *next_hop);
+    }
+  }
+#endif /* LWIP_ARP */
+  entry->generation = ip_fwcache_generation;
+  return entry;
+}
+
+/**
+ * Send a forwarded packet as decided by a cache entry.
+ *
+ * @param entry cache entry returned by ip4_fwcache_lookup() or ip4_fwcache_add()
+ * @param p the packet to send (p->payload points to the IP header)
+ * @return the return value of the netif output function
+ */
+err_t
+ip4_fwcache_output(struct ip4_fwcache_entry *entry, struct pbuf *p)
+{
+#if LWIP_ARP
+  if (!ip4_addr_isany_val(entry->next_hop)
+#if LWIP_AUTOIP
+      /* packets from link-local sources must be sent directly to their
+         destination (RFC 3927 2.6.2), let etharp_output() handle these */
+      && !ip4_addr_islinklocal(ip4_current_src_addr())
+#endif /* LWIP_AUTOIP */
+     ) {
+    return etharp_output_to_next_hop(entry->netif, p, &entry->next_hop, &entry->arp_idx);
+  }
+#endif /* LWIP_ARP */
+  return entry->netif->output(entry->netif, p, &entry->dest);
+}
+#endif /* LWIP_IPV4 && IP_FORWARD */
+
+#if LWIP_IPV6 && LWIP_IPV6_FORWARD && LWIP_IPV6_FIB
+static struct ip6_fwcache_entry ip6_fwcache[IP_FORWARD_FLOW_CACHE_SIZE];
+
+/** Slot of (dest, inp, flow_hash) */
+static u16_t
+ip6_fwcache_hash(const ip6_addr_t *dest, const struct netif *inp, u32_t flow_hash)
+{
+  u32_t h = dest->addr[0] ^ dest->addr[1] ^ dest->addr[2] ^ dest->addr[3] ^ flow_hash ^ inp->num;
+  return LWIP_HASH_BUCKET(h, IP_FORWARD_FLOW_CACHE_SIZE);
+}
+
+/**
+ * Look up the cached forwarding decision for a packet.
+ *
+ * @param dest destination address of the packet
+ * @param inp netif the packet was received on
+ * @param flow_hash ip6_flow_hash() of the packet with LWIP_FIB_ECMP, else 0
+ * @return the valid cache entry or NULL
+ */
+const struct ip6_fwcache_entry *
+ip6_fwcache_lookup(const ip6_addr_t *dest, const struct netif *inp, u32_t flow_hash)
+{
+  struct ip6_fwcache_entry *entry = &ip6_fwcache[ip6_fwcache_hash(dest, inp, flow_hash)];
+
+  if ((entry->generation == ip_fwcache_generation) && (entry->inp == inp) &&
+#if LWIP_FIB_ECMP
+      (entry->flow_hash == flow_hash) &&
+#endif /* LWIP_FIB_ECMP */
+      ip6_addr_eq(&entry->dest, dest)) {
+    return entry;
+  }
+  return NULL;
+}
+
+/**
+ * Cache the forwarding decision for packets to dest received on inp
+ * (replacing the entry in its slot).
+ *
+ * @param dest destination address
+ * @param inp input netif
+ * @param netif output netif found by ip6_route_flow()
+ * @param flow_hash ip6_flow_hash() of the packet with LWIP_FIB_ECMP, else 0
+ * @return the new cache entry
+ */
+const struct ip6_fwcache_entry *
+ip6_fwcache_add(const ip6_addr_t *dest, struct netif *inp, struct netif *netif, u32_t flow_hash)
+{
+  struct ip6_fwcache_entry *entry = &ip6_fwcache[ip6_fwcache_hash(dest, inp, flow_hash)];
+
+  ip6_addr_copy(entry->dest, *dest);
+  entry->inp = inp;
+#if LWIP_FIB_ECMP
+  entry->flow_hash = flow_hash;
+#endif /* LWIP_FIB_ECMP */
+  entry->netif = netif;
+  entry->mtu = netif->mtu;
+  entry->generation = ip_fwcache_generation;
+  return entry;
+}
+#endif /* LWIP_IPV6 && LWIP_IPV6_FORWARD && LWIP_IPV6_FIB */
+
+/**
+ * @ingroup ip_fwcache
+ * Invalidate all cached forwarding decisions. This is called by the stack
+ * for all routing changes it knows of; call it when the result of a routing
+ * hook changes.
+ */
+void
+ip_fwcache_invalidate(void)
+{
+  ip_fwcache_generation++;
+  if (ip_fwcache_generation == 0) {
+    /* wrapped: clear the entries so that old generations cannot match */
+#if LWIP_IPV4 && IP_FORWARD
+    memset(ip4_fwcache, 0, sizeof(ip4_fwcache));
+#endif /* LWIP_IPV4 && IP_FORWARD */
+#if LWIP_IPV6 && LWIP_IPV6_FORWARD && LWIP_IPV6_FIB
+    memset(ip6_fwcache, 0, sizeof(ip6_fwcache));
+#endif /* LWIP_IPV6 && LWIP_IPV6_FORWARD && LWIP_IPV6_FIB */
+    ip_fwcache_generation = 1;
+  }
+}
+
+#endif /* IP_FORWARD_FLOW_CACHE */
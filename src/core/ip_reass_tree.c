@@ -0,0 +1,323 @@
+/**
+ * @file
+ * Fragment tree shared by IPv4 and IPv6 reassembly
+ *
+ * The fragments of a datagram being reassembled are kept in a splay tree
+ * sorted by their offset, with the tree node stored in place of the header in
+ * front of each fragment's data (see struct ip_reass_node). Inserting a
+ * fragment and checking it against its neighbours for overlap costs
+ * O(log n) amortized instead of walking a list of all fragments received so
+ * far, which keeps reassembly of datagrams sent in many small or reordered
+ * fragments cheap.
+ *
+ * When a datagram is complete, the tree is flattened into a list sorted by
+ * offset (linked via 'right') in one pass, which is also a valid (degenerate)
+ * tree.
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#include "lwip/opt.h"
+
+#if (LWIP_IPV4 && IP_REASSEMBLY) || (LWIP_IPV6 && LWIP_IPV6_REASS)
+
+#include "lwip/priv/ip_reass_tree.h"
+#include "lwip/debug.h"
+
+/**
+ * Top-down splay: reorganize the tree so that the fragment starting at
+ * 'start' (or the last fragment on the search path for it, i.e. its
+ * predecessor or successor) becomes the root.
+ *
+ * @param t root of the tree
+ * @param start offset to search for
+ * @return the new root
+ */
+static struct pbuf *
+ip_reass_tree_splay(struct pbuf *t, u16_t start)
+{
+  struct pbuf *l = NULL, *r = NULL;
+  struct pbuf *lmax = NULL, *rmin = NULL;
+  struct pbuf *y;
+
+  if (t == NULL) {
+    return NULL;
+  }
+  for (;;) {
+    if (start < IP_REASS_NODE(t)->start) {
+      y = IP_REASS_NODE(t)->left;
+      if (y == NULL) {
+        break;
+      }
+      if (start < IP_REASS_NODE(y)->start) {
+        /* rotate right */
+        IP_REASS_NODE(t)->left = IP_REASS_NODE(y)->right;
+        IP_REASS_NODE(y)->right = t;
+        t = y;
+        if (IP_REASS_NODE(t)->left == NULL) {
+          break;
+        }
+      }
+      /* link t into the right tree */
+      if (rmin == NULL) {
+        r = t;
+      } else {
+        IP_REASS_NODE(rmin)->left = t;
+      }
+      rmin = t;
+      t = IP_REASS_NODE(t)->left;
+    } else if (start > IP_REASS_NODE(t)->start) {
+      y = IP_REASS_NODE(t)->right;
+      if (y == NULL) {
+        break;
+      }
+      if (start > IP_REASS_NODE(y)->start) {
+        /* rotate left */
+        IP_REASS_NODE(t)->right = IP_REASS_NODE(y)->left;
+        IP_REASS_NODE(y)->left = t;
+        t = y;
+        if (IP_REASS_NODE(t)->right == NULL) {
+          break;
+        }
+      }
+      /* link t into the left tree */
+      if (lmax == NULL) {
+        l = t;
+      } else {
+        IP_REASS_NODE(lmax)->right = t;
+      }
+      lmax = t;
+      t = IP_REASS_NODE(t)->right;
+    } else {
+      break;
+    }
+  }
+  /* reassemble */
+  if (lmax == NULL) {
+    l = IP_REASS_NODE(t)->left;
+  } else {
+    IP_REASS_NODE(lmax)->right = IP_REASS_NODE(t)->left;
+  }
+  if (rmin == NULL) {
+    r = IP_REASS_NODE(t)->right;
+  } else {
+    IP_REASS_NODE(rmin)->left = IP_REASS_NODE(t)->right;
+  }
+  IP_REASS_NODE(t)->left = l;
+  IP_REASS_NODE(t)->right = r;
+  return t;
+}
+
+/**
+ * Check whether a new fragment may be inserted into the tree.
+ * This prepares the tree for ip_reass_tree_link(), which must follow without
+ * modifying the tree in between if the fragment is to be queued.
+ *
+ * @param root pointer to the root of the tree (modified)
+ * @param start offset of the new fragment
+ * @param end offset following the last byte of the new fragment
+ * @param check_overlap if != 0, fragments overlapping a queued one are refused
+ * @return 1 if the fragment can be inserted, 0 if it is a duplicate or overlaps
+ */
+u8_t
+ip_reass_tree_check(struct pbuf **root, u16_t start, u16_t end, u8_t check_overlap)
+{
+  struct pbuf *t, *q;
+
+  LWIP_ASSERT("root != NULL", root != NULL);
+  t = ip_reass_tree_splay(*root, start);
+  *root = t;
+  if (t == NULL) {
+    return 1;
+  }
+  if (IP_REASS_NODE(t)->start == start) {
+    /* received the same fragment twice */
+    return 0;
+  }
+  if (check_overlap) {
+    if (IP_REASS_NODE(t)->start < start) {
+      /* the root is the predecessor, the successor is the minimum on the right */
+      if (IP_REASS_NODE(t)->end > start) {
+        return 0;
+      }
+      q = IP_REASS_NODE(t)->right;
+      if (q != NULL) {
+        while (IP_REASS_NODE(q)->left != NULL) {
+          q = IP_REASS_NODE(q)->left;
+        }
+        if (end > IP_REASS_NODE(q)->start) {
+          return 0;
+        }
+      }
+    } else {
+      /* the root is the successor, the predecessor is the maximum on the left */
+      if (end > IP_REASS_NODE(t)->start) {
+        return 0;
+      }
+      q = IP_REASS_NODE(t)->left;
+      if (q != NULL) {
+        while (IP_REASS_NODE(q)->right != NULL) {
+          q = IP_REASS_NODE(q)->right;
+        }
+        if (IP_REASS_NODE(q)->end > start) {
+          return 0;
+        }
+      }
+    }
+  }
+  return 1;
+}
+
+/**
+ * Insert a fragment as the new root of the tree. Must directly follow a
+ * successful call to ip_reass_tree_check() for the same offset.
+ * This is the first time the node in front of the fragment data is written.
+ *
+ * @param root pointer to the root of the tree (modified)
+ * @param p the fragment, p->payload pointing to the space for the node
+ * @param start offset of the fragment
+ * @param end offset following the last byte of the fragment
+ */
+void
+ip_reass_tree_link(struct pbuf **root, struct pbuf *p, u16_t start, u16_t end)
+{
+  struct ip_reass_node *node = IP_REASS_NODE(p);
+  struct pbuf *t = *root;
+
+  node->start = start;
+  node->end = end;
+  if (t == NULL) {
+    node->left = NULL;
+    node->right = NULL;
+  } else if (IP_REASS_NODE(t)->start < start) {
+    node->left = t;
+    node->right = IP_REASS_NODE(t)->right;
+    IP_REASS_NODE(t)->right = NULL;
+  } else {
+    LWIP_ASSERT("duplicate fragment offset", IP_REASS_NODE(t)->start > start);
+    node->right = t;
+    node->left = IP_REASS_NODE(t)->left;
+    IP_REASS_NODE(t)->left = NULL;
+  }
+  *root = p;
+}
+
+/**
+ * Move the fragment with the lowest offset to the root of the tree.
+ *
+ * @param root pointer to the root of the tree (modified)
+ * @return the fragment with the lowest offset (the root, its 'left' is NULL)
+ *         or NULL if the tree is empty
+ */
+struct pbuf *
+ip_reass_tree_first(struct pbuf **root)
+{
+  *root = ip_reass_tree_splay(*root, 0);
+  return *root;
+}
+
+/**
+ * Get the end offset of the fragment with the highest offset. If fragments
+ * are not allowed to overlap, this is the highest end offset in the tree.
+ *
+ * @param root root of the tree
+ * @return the end offset or 0 if the tree is empty
+ */
+u16_t
+ip_reass_tree_last_end(struct pbuf *root)
+{
+  if (root == NULL) {
+    return 0;
+  }
+  while (IP_REASS_NODE(root)->right != NULL) {
+    root = IP_REASS_NODE(root)->right;
+  }
+  return IP_REASS_NODE(root)->end;
+}
+
+/**
+ * Flatten the tree into a list sorted by offset, linked via 'right' (all
+ * 'left' pointers are NULL afterwards). The list stays a valid tree.
+ *
+ * @param root pointer to the root of the tree (modified)
+ * @return the first fragment of the list (the new root)
+ */
+struct pbuf *
+ip_reass_tree_to_list(struct pbuf **root)
+{
+  struct pbuf *tail = NULL;
+  struct pbuf *rest = *root;
+
+  while (rest != NULL) {
+    struct pbuf *l = IP_REASS_NODE(rest)->left;
+    if (l == NULL) {
+      tail = rest;
+      rest = IP_REASS_NODE(rest)->right;
+    } else {
+      /* rotate right, the left child takes the place of 'rest' */
+      IP_REASS_NODE(rest)->left = IP_REASS_NODE(l)->right;
+      IP_REASS_NODE(l)->right = rest;
+      rest = l;
+      if (tail == NULL) {
+        *root = l;
+      } else {
+        IP_REASS_NODE(tail)->right = l;
+      }
+    }
+  }
+  return *root;
+}
+
+/**
+ * Check if the fragments in the tree seamlessly cover a datagram.
+ * Used when overlapping fragments are not refused, so that the amount of data
+ * received cannot tell this. Flattens the tree (see ip_reass_tree_to_list()).
+ *
+ * @param root pointer to the root of the tree (modified)
+ * @param datagram_len length of the datagram
+ * @return 1 if the datagram is complete, 0 otherwise
+ */
+u8_t
+ip_reass_tree_complete(struct pbuf **root, u16_t datagram_len)
+{
+  struct pbuf *q;
+  u16_t expected = 0;
+
+  for (q = ip_reass_tree_to_list(root); q != NULL; q = IP_REASS_NODE(q)->right) {
+    if (IP_REASS_NODE(q)->start != expected) {
+      return 0;
+    }
+    expected = IP_REASS_NODE(q)->end;
+  }
+  return (expected == datagram_len) ? 1 : 0;
+}
+
+#endif /* (LWIP_IPV4 && IP_REASSEMBLY) || (LWIP_IPV6 && LWIP_IPV6_REASS) */
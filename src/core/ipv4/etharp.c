@@ -48,12 +48,14 @@
 #if LWIP_IPV4 && LWIP_ARP /* don't build if not configured for use in lwipopts.h */
 
 #include "lwip/etharp.h"
+#include "lwip/ip4_fib.h"
 #include "lwip/stats.h"
 #include "lwip/snmp.h"
 #include "lwip/dhcp.h"
 #include "lwip/autoip.h"
 #include "lwip/acd.h"
 #include "lwip/prot/iana.h"
+#include "lwip/priv/hash_priv.h"
 #include "netif/ethernet.h"
 
 #include <string.h>
@@ -99,12 +101,35 @@ struct etharp_entry {
   ip4_addr_t ipaddr;
   struct netif *netif;
   struct eth_addr ethaddr;
+#if ETHARP_TABLE_HASH
+  /** next entry in the same hash bucket (or on the free list) */
+  netif_addr_idx_t hash_next;
+  /** neighbors on the age list (dynamic entries only) */
+  netif_addr_idx_t age_prev, age_next;
+#endif /* ETHARP_TABLE_HASH */
   u16_t ctime;
   u8_t state;
 };
 
 static struct etharp_entry arp_table[ARP_TABLE_SIZE];
 
+#if ETHARP_TABLE_HASH
+#define ETHARP_LINK_NONE       LWIP_HASH_LINK_NONE
+#define ETHARP_LINK(i)         LWIP_HASH_LINK(netif_addr_idx_t, i)
+#define ETHARP_LINK_IDX(link)  LWIP_HASH_LINK_IDX(link)
+
+/** First entry of each hash bucket */
+static netif_addr_idx_t arp_hash[ETHARP_TABLE_HASH_SIZE];
+/** Entries freed after use, linked via hash_next */
+static netif_addr_idx_t arp_free;
+/** Number of entries that have been taken into use so far */
+static s16_t arp_used;
+/** Number of entries currently in use */
+static s16_t arp_count;
+/** Dynamic entries, most recently updated first */
+static netif_addr_idx_t arp_age_head, arp_age_tail;
+#endif /* ETHARP_TABLE_HASH */
+
 #if !LWIP_NETIF_HWADDRHINT
 static netif_addr_idx_t etharp_cached_entry;
 #endif /* !LWIP_NETIF_HWADDRHINT */
@@ -129,6 +154,9 @@ static netif_addr_idx_t etharp_cached_entry;
 #if (ARP_TABLE_SIZE > NETIF_ADDR_IDX_MAX)
 #error "ARP_TABLE_SIZE must fit in an s16_t, you have to reduce it in your lwipopts.h"
 #endif
+#if ETHARP_TABLE_HASH && ((ETHARP_TABLE_HASH_SIZE & (ETHARP_TABLE_HASH_SIZE - 1)) != 0)
+#error "ETHARP_TABLE_HASH_SIZE must be a power of 2"
+#endif
 
 
 static err_t etharp_request_dst(struct netif *netif, const ip4_addr_t *ipaddr, const struct eth_addr *hw_dst_addr);
@@ -164,10 +192,85 @@ free_etharp_q(struct etharp_q_entry *q)
 
 #endif /* ARP_QUEUEING */
 
+#if ETHARP_TABLE_HASH
+/** Hash bucket of an IP address */
+static u16_t
+etharp_hash(const ip4_addr_t *ipaddr)
+{
+  u32_t h = ip4_addr_get_u32(ipaddr);
+  return LWIP_HASH_BUCKET(h, ETHARP_TABLE_HASH_SIZE);
+}
+
+/** Remove an entry from the age list */
+static void
+etharp_age_unlink(int i)
+{
+  netif_addr_idx_t prev = arp_table[i].age_prev;
+  netif_addr_idx_t next = arp_table[i].age_next;
+
+  if (prev == ETHARP_LINK_NONE) {
+    arp_age_head = next;
+  } else {
+    arp_table[ETHARP_LINK_IDX(prev)].age_next = next;
+  }
+  if (next == ETHARP_LINK_NONE) {
+    arp_age_tail = prev;
+  } else {
+    arp_table[ETHARP_LINK_IDX(next)].age_prev = prev;
+  }
+}
+
+/** Insert an entry at the head (youngest end) of the age list */
+static void
+etharp_age_push(int i)
+{
+  arp_table[i].age_prev = ETHARP_LINK_NONE;
+  arp_table[i].age_next = arp_age_head;
+  if (arp_age_head == ETHARP_LINK_NONE) {
+    arp_age_tail = ETHARP_LINK(i);
+  } else {
+    arp_table[ETHARP_LINK_IDX(arp_age_head)].age_prev = ETHARP_LINK(i);
+  }
+  arp_age_head = ETHARP_LINK(i);
+}
+
+/** Remove an entry from its hash bucket and the age list and put it on the
+ * free list */
+static void
+etharp_hash_remove(int i)
+{
+  netif_addr_idx_t *link = &arp_hash[etharp_hash(&arp_table[i].ipaddr)];
+
+  while (*link != ETHARP_LINK(i)) {
+    LWIP_ASSERT("entry not in its hash bucket", *link != ETHARP_LINK_NONE);
+    link = &arp_table[ETHARP_LINK_IDX(*link)].hash_next;
+  }
+  *link = arp_table[i].hash_next;
+#if ETHARP_SUPPORT_STATIC_ENTRIES
+  /* static entries never expire and are not on the age list */
+  if (arp_table[i].state != ETHARP_STATE_STATIC)
+#endif /* ETHARP_SUPPORT_STATIC_ENTRIES */
+  {
+    etharp_age_unlink(i);
+  }
+  if (--arp_count == 0) {
+    /* table is empty: hand out entries in index order again */
+    arp_free = ETHARP_LINK_NONE;
+    arp_used = 0;
+  } else {
+    arp_table[i].hash_next = arp_free;
+    arp_free = ETHARP_LINK(i);
+  }
+}
+#endif /* ETHARP_TABLE_HASH */
+
 /** Clean up ARP table entries */
 static void
 etharp_free_entry(int i)
 {
+#if ETHARP_TABLE_HASH
+  etharp_hash_remove(i);
+#endif /* ETHARP_TABLE_HASH */
   /* remove from SNMP ARP index tree */
   mib2_remove_arp_entry(arp_table[i].netif, &arp_table[i].ipaddr);
   /* and empty packet queue */
@@ -255,6 +358,98 @@ etharp_tmr(void)
  */
 static s16_t
 etharp_find_entry(const ip4_addr_t *ipaddr, u8_t flags, struct netif *netif)
+#if ETHARP_TABLE_HASH
+{
+  s16_t i = 0;
+  netif_addr_idx_t link;
+
+  LWIP_UNUSED_ARG(netif);
+
+  /* a) search the hash bucket of ipaddr for a pending or stable entry */
+  if (ipaddr != NULL) {
+    for (link = arp_hash[etharp_hash(ipaddr)]; link != ETHARP_LINK_NONE; link = arp_table[i].hash_next) {
+      i = ETHARP_LINK_IDX(link);
+      if (ip4_addr_eq(ipaddr, &arp_table[i].ipaddr)
+#if ETHARP_TABLE_MATCH_NETIF
+          && ((netif == NULL) || (netif == arp_table[i].netif))
+#endif /* ETHARP_TABLE_MATCH_NETIF */
+         ) {
+        LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_find_entry: found matching entry %d\n", (int)i));
+        return i;
+      }
+    }
+  }
+
+  /* don't create new entry, only search? */
+  if ((flags & ETHARP_FLAG_FIND_ONLY) != 0) {
+    return (s16_t)ERR_MEM;
+  }
+
+  /* b) take an empty entry or recycle the least destructive one:
+   * 1) the oldest stable entry
+   * 2) the oldest pending entry without queued packets
+   * 3) the oldest pending entry with queued packets
+   * Stable entries are usually at the old end of the age list since pending
+   * entries expire (or become stable) quickly.
+   */
+  if ((arp_free == ETHARP_LINK_NONE) && (arp_used == ARP_TABLE_SIZE)) {
+    s16_t old_pending = ARP_TABLE_SIZE, old_queue = ARP_TABLE_SIZE;
+
+    if ((flags & ETHARP_FLAG_TRY_HARD) == 0) {
+      LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_find_entry: no empty entry found and not allowed to recycle\n"));
+      return (s16_t)ERR_MEM;
+    }
+    for (link = arp_age_tail; link != ETHARP_LINK_NONE; link = arp_table[i].age_prev) {
+      i = ETHARP_LINK_IDX(link);
+      if (arp_table[i].state >= ETHARP_STATE_STABLE) {
+        /* no queued packets should exist on stable entries */
+        LWIP_ASSERT("arp_table[i].q == NULL", arp_table[i].q == NULL);
+        break;
+      }
+      if ((arp_table[i].q == NULL) && (old_pending == ARP_TABLE_SIZE)) {
+        old_pending = i;
+      } else if ((arp_table[i].q != NULL) && (old_queue == ARP_TABLE_SIZE)) {
+        old_queue = i;
+      }
+    }
+    if (link == ETHARP_LINK_NONE) {
+      i = (old_pending < ARP_TABLE_SIZE) ? old_pending : old_queue;
+      if (i == ARP_TABLE_SIZE) {
+        LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_find_entry: no empty or recyclable entries found\n"));
+        return (s16_t)ERR_MEM;
+      }
+    }
+    LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("etharp_find_entry: recycling entry %d\n", (int)i));
+    /* puts the entry on the free list (queued packets are freed) */
+    etharp_free_entry(i);
+  }
+  if (arp_free != ETHARP_LINK_NONE) {
+    i = ETHARP_LINK_IDX(arp_free);
+    arp_free = arp_table[i].hash_next;
+  } else {
+    i = arp_used++;
+  }
+  arp_count++;
+
+  LWIP_ASSERT("i < ARP_TABLE_SIZE", i < ARP_TABLE_SIZE);
+  LWIP_ASSERT("arp_table[i].state == ETHARP_STATE_EMPTY",
+              arp_table[i].state == ETHARP_STATE_EMPTY);
+
+  /* c) initialize the entry and link it into its bucket and the age list */
+  if (ipaddr != NULL) {
+    ip4_addr_copy(arp_table[i].ipaddr, *ipaddr);
+  }
+  arp_table[i].ctime = 0;
+#if ETHARP_TABLE_MATCH_NETIF
+  arp_table[i].netif = netif;
+#endif /* ETHARP_TABLE_MATCH_NETIF */
+  link = arp_hash[etharp_hash(&arp_table[i].ipaddr)];
+  arp_table[i].hash_next = link;
+  arp_hash[etharp_hash(&arp_table[i].ipaddr)] = ETHARP_LINK(i);
+  etharp_age_push(i);
+  return i;
+}
+#else /* ETHARP_TABLE_HASH */
 {
   s16_t old_pending = ARP_TABLE_SIZE, old_stable = ARP_TABLE_SIZE;
   s16_t empty = ARP_TABLE_SIZE;
@@ -400,6 +595,7 @@ etharp_find_entry(const ip4_addr_t *ipaddr, u8_t flags, struct netif *netif)
 #endif /* ETHARP_TABLE_MATCH_NETIF */
   return (s16_t)i;
 }
+#endif /* ETHARP_TABLE_HASH */
 
 /**
  * Update (or insert) a IP/MAC address pair in the ARP cache.
@@ -444,6 +640,12 @@ etharp_update_arp_entry(struct netif *netif, const ip4_addr_t *ipaddr, struct et
 
 #if ETHARP_SUPPORT_STATIC_ENTRIES
   if (flags & ETHARP_FLAG_STATIC_ENTRY) {
+#if ETHARP_TABLE_HASH
+    if (arp_table[i].state != ETHARP_STATE_STATIC) {
+      /* static entries don't age */
+      etharp_age_unlink(i);
+    }
+#endif /* ETHARP_TABLE_HASH */
     /* record static type */
     arp_table[i].state = ETHARP_STATE_STATIC;
   } else if (arp_table[i].state == ETHARP_STATE_STATIC) {
@@ -454,6 +656,11 @@ etharp_update_arp_entry(struct netif *netif, const ip4_addr_t *ipaddr, struct et
   {
     /* mark it stable */
     arp_table[i].state = ETHARP_STATE_STABLE;
+#if ETHARP_TABLE_HASH
+    /* the entry is the youngest one now */
+    etharp_age_unlink(i);
+    etharp_age_push(i);
+#endif /* ETHARP_TABLE_HASH */
   }
 
   /* record network interface */
@@ -770,6 +977,59 @@ etharp_output_to_arp_index(struct netif *netif, struct pbuf *q, netif_addr_idx_t
   return ethernet_output(netif, q, (struct eth_addr *)(netif->hwaddr), &arp_table[arp_idx].ethaddr, ETHTYPE_IP);
 }
 
+/**
+ * Get the IP address a unicast packet to ipaddr sent on netif must be
+ * resolved for: ipaddr itself if it is on the netif's subnet (or link-local),
+ * else the gateway. With LWIP_IPV4_FIB, a route that is more specific than
+ * the netif's subnet takes precedence (as in ip4_route()).
+ *
+ * @param netif The lwIP network interface the packet is sent on.
+ * @param ipaddr The IP address of the packet destination.
+ *
+ * @return the next hop or NULL if ipaddr is off-link and no gateway is known
+ */
+const ip4_addr_t *
+etharp_next_hop(struct netif *netif, const ip4_addr_t *ipaddr)
+{
+  const ip4_addr_t *dst_addr = ipaddr;
+
+  /* outside local network? if so, this can neither be a global broadcast nor
+     a subnet broadcast. */
+  if (!ip4_addr_net_eq(ipaddr, netif_ip4_addr(netif), netif_ip4_netmask(netif)) &&
+      !ip4_addr_islinklocal(ipaddr)) {
+#ifdef LWIP_HOOK_ETHARP_GET_GW
+    /* For advanced routing, a single default gateway might not be enough, so get
+       the IP address of the gateway to handle the current destination address. */
+    dst_addr = LWIP_HOOK_ETHARP_GET_GW(netif, ipaddr);
+    if (dst_addr == NULL)
+#endif /* LWIP_HOOK_ETHARP_GET_GW */
+#if LWIP_IPV4_FIB
+    /* gateway of a route via this netif? */
+    if ((dst_addr = ip4_fib_next_hop(ipaddr, netif)) == NULL)
+#endif /* LWIP_IPV4_FIB */
+    {
+      /* interface has default gateway? */
+      if (!ip4_addr_isany_val(*netif_ip4_gw(netif))) {
+        /* send to hardware address of default gateway IP address */
+        dst_addr = netif_ip4_gw(netif);
+        /* no default gateway available */
+      } else {
+        return NULL;
+      }
+    }
+  }
+#if LWIP_IPV4_FIB
+  else if (!ip4_addr_islinklocal(ipaddr)) {
+    /* on-link, unless a more specific route points to a gateway */
+    const ip4_addr_t *next_hop = ip4_fib_next_hop(ipaddr, netif);
+    if (next_hop != NULL) {
+      dst_addr = next_hop;
+    }
+  }
+#endif /* LWIP_IPV4_FIB */
+  return dst_addr;
+}
+
 /**
  * Resolve and fill-in Ethernet address header for outgoing IP packet.
  *
@@ -821,36 +1081,19 @@ etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr)
     /* unicast destination IP address? */
   } else {
     netif_addr_idx_t i;
-    /* outside local network? if so, this can neither be a global broadcast nor
-       a subnet broadcast. */
-    if (!ip4_addr_net_eq(ipaddr, netif_ip4_addr(netif), netif_ip4_netmask(netif)) &&
-        !ip4_addr_islinklocal(ipaddr)) {
 #if LWIP_AUTOIP
-      struct ip_hdr *iphdr = LWIP_ALIGNMENT_CAST(struct ip_hdr *, q->payload);
-      /* According to RFC 3297, chapter 2.6.2 (Forwarding Rules), a packet with
-         a link-local source address must always be "directly to its destination
-         on the same physical link. The host MUST NOT send the packet to any
-         router for forwarding". */
-      if (!ip4_addr_islinklocal(&iphdr->src))
+    struct ip_hdr *iphdr = LWIP_ALIGNMENT_CAST(struct ip_hdr *, q->payload);
+    /* According to RFC 3297, chapter 2.6.2 (Forwarding Rules), a packet with
+       a link-local source address must always be "directly to its destination
+       on the same physical link. The host MUST NOT send the packet to any
+       router for forwarding". */
+    if (!ip4_addr_islinklocal(&iphdr->src))
 #endif /* LWIP_AUTOIP */
-      {
-#ifdef LWIP_HOOK_ETHARP_GET_GW
-        /* For advanced routing, a single default gateway might not be enough, so get
-           the IP address of the gateway to handle the current destination address. */
-        dst_addr = LWIP_HOOK_ETHARP_GET_GW(netif, ipaddr);
-        if (dst_addr == NULL)
-#endif /* LWIP_HOOK_ETHARP_GET_GW */
-        {
-          /* interface has default gateway? */
-          if (!ip4_addr_isany_val(*netif_ip4_gw(netif))) {
-            /* send to hardware address of default gateway IP address */
-            dst_addr = netif_ip4_gw(netif);
-            /* no default gateway available */
-          } else {
-            /* no route to destination error (default gateway missing) */
-            return ERR_RTE;
-          }
-        }
+    {
+      dst_addr = etharp_next_hop(netif, ipaddr);
+      if (dst_addr == NULL) {
+        /* no route to destination error (default gateway missing) */
+        return ERR_RTE;
       }
     }
 #if LWIP_NETIF_HWADDRHINT
@@ -873,6 +1116,24 @@ etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr)
     }
 #endif /* LWIP_NETIF_HWADDRHINT */
 
+#if ETHARP_TABLE_HASH
+    /* find stable entry in the hash bucket of dst_addr */
+    {
+      netif_addr_idx_t link;
+      for (link = arp_hash[etharp_hash(dst_addr)]; link != ETHARP_LINK_NONE; link = arp_table[i].hash_next) {
+        i = (netif_addr_idx_t)ETHARP_LINK_IDX(link);
+        if ((arp_table[i].state >= ETHARP_STATE_STABLE) &&
+#if ETHARP_TABLE_MATCH_NETIF
+            (arp_table[i].netif == netif) &&
+#endif
+            (ip4_addr_eq(dst_addr, &arp_table[i].ipaddr))) {
+          /* found an existing, stable entry */
+          ETHARP_SET_ADDRHINT(netif, i);
+          return etharp_output_to_arp_index(netif, q, i);
+        }
+      }
+    }
+#else /* ETHARP_TABLE_HASH */
     /* find stable entry: do this here since this is a critical path for
        throughput and etharp_find_entry() is kind of slow */
     for (i = 0; i < ARP_TABLE_SIZE; i++) {
@@ -886,6 +1147,7 @@ etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr)
         return etharp_output_to_arp_index(netif, q, i);
       }
     }
+#endif /* ETHARP_TABLE_HASH */
     /* no stable entry found, use the (slower) query function:
        queue on destination Ethernet address belonging to ipaddr */
     return etharp_query(netif, dst_addr, q);
@@ -897,6 +1159,50 @@ etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr)
   return ethernet_output(netif, q, (struct eth_addr *)(netif->hwaddr), dest, ETHTYPE_IP);
 }
 
+#if IP_FORWARD_FLOW_CACHE
+/**
+ * Send an IP packet to a next hop that is already known (see
+ * etharp_next_hop()), skipping the route and broadcast checks of
+ * etharp_output(). Used by the forwarding flow cache.
+ *
+ * @param netif The lwIP network interface which the IP packet will be sent on.
+ * @param q The pbuf(s) containing the IP packet to be sent.
+ * @param next_hop The IP address to send the packet to on the link.
+ * @param arp_idx Cached ARP table index of next_hop (ARP_TABLE_SIZE if not
+ *        known yet), updated when the entry is found elsewhere.
+ *
+ * @return the return type of either etharp_query() or ethernet_output().
+ */
+err_t
+etharp_output_to_next_hop(struct netif *netif, struct pbuf *q, const ip4_addr_t *next_hop,
+                          netif_addr_idx_t *arp_idx)
+{
+  netif_addr_idx_t i = *arp_idx;
+  s16_t i_err;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  if ((i < ARP_TABLE_SIZE) &&
+      (arp_table[i].state >= ETHARP_STATE_STABLE) &&
+#if ETHARP_TABLE_MATCH_NETIF
+      (arp_table[i].netif == netif) &&
+#endif
+      (ip4_addr_eq(next_hop, &arp_table[i].ipaddr))) {
+    /* the cached entry is stable and the right one! */
+    ETHARP_STATS_INC(etharp.cachehit);
+    return etharp_output_to_arp_index(netif, q, i);
+  }
+  i_err = etharp_find_entry(next_hop, ETHARP_FLAG_FIND_ONLY, netif);
+  if ((i_err >= 0) && (arp_table[i_err].state >= ETHARP_STATE_STABLE)) {
+    i = (netif_addr_idx_t)i_err;
+    *arp_idx = i;
+    return etharp_output_to_arp_index(netif, q, i);
+  }
+  /* not resolved yet: queue on the pending entry */
+  return etharp_query(netif, next_hop, q);
+}
+#endif /* IP_FORWARD_FLOW_CACHE */
+
 /**
  * Send an ARP request for the given IP address and/or queue a packet.
  *
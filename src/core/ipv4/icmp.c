@@ -48,6 +48,9 @@
 #include "lwip/ip.h"
 #include "lwip/def.h"
 #include "lwip/stats.h"
+#include "lwip/ip4_pmtu.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/prot/tcp.h"
 
 #include <string.h>
 
@@ -65,7 +68,86 @@
 /* The maximum amount of data from the original packet to return in a dest-unreachable */
 #define ICMP_DEST_UNREACH_DATASIZE 8
 
-static void icmp_send_response(struct pbuf *p, u8_t type, u8_t code);
+static void icmp_send_response(struct pbuf *p, u8_t type, u8_t code, u32_t data);
+
+#if LWIP_IPV4_PMTU
+/**
+ * Process an ICMP 'fragmentation needed' message (RFC 1191): store the path
+ * MTU to the destination of the packet that was too big and let TCP reduce
+ * the MSS of the connection that sent it.
+ *
+ * @param p the ICMP message, p->payload pointing to the ICMP header
+ * @param inp the netif on which the message was received
+ */
+static void
+icmp_input_frag_needed(struct pbuf *p, struct netif *inp)
+{
+  const struct icmp_hdr *icmphdr;
+  const struct ip_hdr *iphdr;
+  ip4_addr_t dest;
+  u16_t hlen, tot_len, mtu;
+
+  LWIP_UNUSED_ARG(inp); /* in case checksum checking is disabled */
+
+  /* the message must contain the IP header of the packet that was too big */
+  if (p->len < sizeof(struct icmp_hdr) + IP_HLEN) {
+    LWIP_DEBUGF(ICMP_DEBUG, ("icmp_input: short ICMP fragmentation needed (%"U16_F" bytes) received\n", p->tot_len));
+    ICMP_STATS_INC(icmp.lenerr);
+    MIB2_STATS_INC(mib2.icmpinerrors);
+    return;
+  }
+#if CHECKSUM_CHECK_ICMP
+  IF__NETIF_CHECKSUM_ENABLED(inp, NETIF_CHECKSUM_CHECK_ICMP) {
+    if (inet_chksum_pbuf(p) != 0) {
+      LWIP_DEBUGF(ICMP_DEBUG, ("icmp_input: checksum failed for received ICMP fragmentation needed\n"));
+      ICMP_STATS_INC(icmp.chkerr);
+      MIB2_STATS_INC(mib2.icmpinerrors);
+      return;
+    }
+  }
+#endif /* CHECKSUM_CHECK_ICMP */
+
+  icmphdr = (const struct icmp_hdr *)p->payload;
+  iphdr = (const struct ip_hdr *)((const u8_t *)p->payload + sizeof(struct icmp_hdr));
+  hlen = IPH_HL_BYTES(iphdr);
+  if ((IPH_V(iphdr) != 4) || (hlen < IP_HLEN)) {
+    ICMP_STATS_INC(icmp.proterr);
+    return;
+  }
+  ip4_addr_copy(dest, iphdr->dest);
+  tot_len = lwip_ntohs(IPH_LEN(iphdr));
+  /* the next-hop MTU is in the low 16 bits of the rest of the ICMP header */
+  mtu = (u16_t)(lwip_ntohl(icmphdr->data) & 0xFFFF);
+  if ((mtu == 0) || (mtu >= tot_len)) {
+    /* old router that does not report the next-hop MTU */
+    mtu = ip4_pmtu_plateau(tot_len);
+  }
+
+#if LWIP_TCP && TCP_CALCULATE_EFF_SEND_MSS
+  /* Only TCP segments are sent with DF set. To make spoofing harder, the
+     message must quote a segment of a connection with data in flight. */
+  if ((IPH_PROTO(iphdr) == IP_PROTO_TCP) && (p->len >= sizeof(struct icmp_hdr) + hlen + ICMP_DEST_UNREACH_DATASIZE)) {
+    /* the first 8 bytes of the segment contain its ports and sequence number */
+    const struct tcp_hdr *tcphdr = (const struct tcp_hdr *)((const u8_t *)iphdr + hlen);
+    struct tcp_pcb *pcb;
+    ip_addr_t local_ip, remote_ip;
+
+    ip_addr_copy_from_ip4(local_ip, iphdr->src);
+    ip_addr_copy_from_ip4(remote_ip, dest);
+    pcb = tcp_pmtu_lookup(&local_ip, &remote_ip, lwip_ntohs(tcphdr->src), lwip_ntohs(tcphdr->dest),
+                          lwip_ntohl(tcphdr->seqno));
+    if (pcb != NULL) {
+      ip4_pmtu_update(&dest, mtu);
+      tcp_pmtu_update(pcb);
+      return;
+    }
+  }
+#endif /* LWIP_TCP && TCP_CALCULATE_EFF_SEND_MSS */
+  LWIP_DEBUGF(ICMP_DEBUG, ("icmp_input: ICMP fragmentation needed for no connection ignored\n"));
+  LWIP_UNUSED_ARG(dest);
+  LWIP_UNUSED_ARG(mtu);
+}
+#endif /* LWIP_IPV4_PMTU */
 
 /**
  * Processes ICMP input packets, called from ip_input().
@@ -258,6 +340,12 @@ icmp_input(struct pbuf *p, struct netif *inp)
     default:
       if (type == ICMP_DUR) {
         MIB2_STATS_INC(mib2.icmpindestunreachs);
+#if LWIP_IPV4_PMTU
+        if (*(((u8_t *)p->payload) + 1) == ICMP_DUR_FRAG) {
+          icmp_input_frag_needed(p, inp);
+          break;
+        }
+#endif /* LWIP_IPV4_PMTU */
       } else if (type == ICMP_TE) {
         MIB2_STATS_INC(mib2.icmpintimeexcds);
       } else if (type == ICMP_PP) {
@@ -309,7 +397,7 @@ void
 icmp_dest_unreach(struct pbuf *p, enum icmp_dur_type t)
 {
   MIB2_STATS_INC(mib2.icmpoutdestunreachs);
-  icmp_send_response(p, ICMP_DUR, t);
+  icmp_send_response(p, ICMP_DUR, t, 0);
 }
 
 #if IP_FORWARD || IP_REASSEMBLY
@@ -324,11 +412,28 @@ void
 icmp_time_exceeded(struct pbuf *p, enum icmp_te_type t)
 {
   MIB2_STATS_INC(mib2.icmpouttimeexcds);
-  icmp_send_response(p, ICMP_TE, t);
+  icmp_send_response(p, ICMP_TE, t, 0);
 }
 
 #endif /* IP_FORWARD || IP_REASSEMBLY */
 
+#if IP_FORWARD
+/**
+ * Send a 'fragmentation needed' packet (RFC 1191), called from ip_forward()
+ * if a packet with the DF flag set is too big for the next hop.
+ *
+ * @param p the input packet for which the message should be sent,
+ *          p->payload pointing to the IP header
+ * @param mtu MTU of the next hop
+ */
+void
+icmp_frag_needed(struct pbuf *p, u16_t mtu)
+{
+  MIB2_STATS_INC(mib2.icmpoutdestunreachs);
+  icmp_send_response(p, ICMP_DUR, ICMP_DUR_FRAG, mtu);
+}
+#endif /* IP_FORWARD */
+
 /**
  * Send an icmp packet in response to an incoming packet.
  *
@@ -336,9 +441,10 @@ icmp_time_exceeded(struct pbuf *p, enum icmp_te_type t)
  *          p->payload pointing to the IP header
  * @param type Type of the ICMP header
  * @param code Code of the ICMP header
+ * @param data Rest of the ICMP header (host byte order)
  */
 static void
-icmp_send_response(struct pbuf *p, u8_t type, u8_t code)
+icmp_send_response(struct pbuf *p, u8_t type, u8_t code, u32_t data)
 {
   struct pbuf *q;
   struct ip_hdr *iphdr;
@@ -376,7 +482,7 @@ icmp_send_response(struct pbuf *p, u8_t type, u8_t code)
   icmphdr = (struct icmp_hdr *)q->payload;
   icmphdr->type = type;
   icmphdr->code = code;
-  icmphdr->data = 0;
+  icmphdr->data = lwip_htonl(data);
 
   /* copy fields from original packet */
   pbuf_copy_partial_pbuf(q, p, response_pkt_len, sizeof(struct icmp_hdr));
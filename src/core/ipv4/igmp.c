@@ -93,6 +93,7 @@ Steve Reynolds
 #include "lwip/netif.h"
 #include "lwip/stats.h"
 #include "lwip/prot/igmp.h"
+#include "lwip/priv/hash_priv.h"
 
 #include <string.h>
 
@@ -103,10 +104,67 @@ static void   igmp_start_timer(struct igmp_group *group, u8_t max_time);
 static void   igmp_delaying_member(struct igmp_group *group, u8_t maxresp);
 static err_t  igmp_ip_output_if(struct pbuf *p, const ip4_addr_t *src, const ip4_addr_t *dest, struct netif *netif);
 static void   igmp_send(struct netif *netif, struct igmp_group *group, u8_t type);
+static void   igmp_start_member(struct netif *netif, struct igmp_group *group);
+static void   igmp_stop_member(struct netif *netif, struct igmp_group *group);
 
 static ip4_addr_t     allsystems;
 static ip4_addr_t     allrouters;
 
+#if IGMP_GROUP_HASH_SIZE
+#if (IGMP_GROUP_HASH_SIZE & (IGMP_GROUP_HASH_SIZE - 1)) != 0
+#error "IGMP_GROUP_HASH_SIZE must be a power of 2"
+#endif
+
+/** The groups joined on all netifs, hashed by address and netif */
+static struct igmp_group *igmp_group_hash[IGMP_GROUP_HASH_SIZE];
+
+/** Bucket of a group address joined on the netif with index netif_idx */
+static u16_t
+igmp_group_hash_idx(const ip4_addr_t *addr, u8_t netif_idx)
+{
+  /* host order: groups used side by side mostly differ in the last octet,
+     which netif_idx is added to */
+  u32_t h = lwip_ntohl(ip4_addr_get_u32(addr)) + netif_idx;
+  return LWIP_HASH_BUCKET(h, IGMP_GROUP_HASH_SIZE);
+}
+
+static void
+igmp_group_hash_add(struct netif *netif, struct igmp_group *group)
+{
+  u16_t idx;
+
+  group->netif_idx = netif_get_index(netif);
+  idx = igmp_group_hash_idx(&group->group_address, group->netif_idx);
+  group->hash_next = igmp_group_hash[idx];
+  igmp_group_hash[idx] = group;
+}
+
+static void
+igmp_group_hash_remove(struct igmp_group *group)
+{
+  struct igmp_group **link = &igmp_group_hash[igmp_group_hash_idx(&group->group_address, group->netif_idx)];
+
+  for (; *link != NULL; link = &(*link)->hash_next) {
+    if (*link == group) {
+      *link = group->hash_next;
+      break;
+    }
+  }
+}
+#endif /* IGMP_GROUP_HASH_SIZE */
+
+#if LWIP_IGMP_SOURCE_FILTER
+static void
+igmp_free_sources(struct igmp_group *group)
+{
+  while (group->sources != NULL) {
+    struct igmp_source *next = group->sources->next;
+    memp_free(MEMP_IGMP_SOURCE, group->sources);
+    group->sources = next;
+  }
+}
+#endif /* LWIP_IGMP_SOURCE_FILTER */
+
 /**
  * Initialize the IGMP module
  */
@@ -174,6 +232,12 @@ igmp_stop(struct netif *netif)
       netif->igmp_mac_filter(netif, &(group->group_address), NETIF_DEL_MAC_FILTER);
     }
 
+#if IGMP_GROUP_HASH_SIZE
+    igmp_group_hash_remove(group);
+#endif /* IGMP_GROUP_HASH_SIZE */
+#if LWIP_IGMP_SOURCE_FILTER
+    igmp_free_sources(group);
+#endif /* LWIP_IGMP_SOURCE_FILTER */
     /* free group */
     memp_free(MEMP_IGMP_GROUP, group);
 
@@ -217,6 +281,17 @@ igmp_report_groups(struct netif *netif)
 struct igmp_group *
 igmp_lookfor_group(struct netif *ifp, const ip4_addr_t *addr)
 {
+#if IGMP_GROUP_HASH_SIZE
+  u8_t netif_idx = netif_get_index(ifp);
+  struct igmp_group *group = igmp_group_hash[igmp_group_hash_idx(addr, netif_idx)];
+
+  while (group != NULL) {
+    if ((group->netif_idx == netif_idx) && ip4_addr_eq(&(group->group_address), addr)) {
+      return group;
+    }
+    group = group->hash_next;
+  }
+#else /* IGMP_GROUP_HASH_SIZE */
   struct igmp_group *group = netif_igmp_data(ifp);
 
   while (group != NULL) {
@@ -225,6 +300,7 @@ igmp_lookfor_group(struct netif *ifp, const ip4_addr_t *addr)
     }
     group = group->next;
   }
+#endif /* IGMP_GROUP_HASH_SIZE */
 
   /* to be clearer, we return NULL here instead of
    * 'group' (which is also NULL at this point).
@@ -261,6 +337,12 @@ igmp_lookup_group(struct netif *ifp, const ip4_addr_t *addr)
     group->group_state        = IGMP_GROUP_NON_MEMBER;
     group->last_reporter_flag = 0;
     group->use                = 0;
+#if LWIP_IGMP_SOURCE_FILTER
+    group->sources            = NULL;
+#endif /* LWIP_IGMP_SOURCE_FILTER */
+#if IGMP_GROUP_HASH_SIZE
+    igmp_group_hash_add(ifp, group);
+#endif /* IGMP_GROUP_HASH_SIZE */
 
     /* Ensure allsystems group is always first in list */
     if (list_head == NULL) {
@@ -308,6 +390,11 @@ igmp_remove_group(struct netif *netif, struct igmp_group *group)
   if (tmp_group == NULL) {
     err = ERR_ARG;
   }
+#if IGMP_GROUP_HASH_SIZE
+  else {
+    igmp_group_hash_remove(group);
+  }
+#endif /* IGMP_GROUP_HASH_SIZE */
 
   return err;
 }
@@ -437,6 +524,68 @@ igmp_input(struct pbuf *p, struct netif *inp, const ip4_addr_t *dest)
   return;
 }
 
+/**
+ * Start the membership of a new group: allow it at the MAC level and report it.
+ *
+ * @param netif the network interface the group is joined on
+ * @param group the new group (in state IGMP_GROUP_NON_MEMBER)
+ */
+static void
+igmp_start_member(struct netif *netif, struct igmp_group *group)
+{
+  LWIP_DEBUGF(IGMP_DEBUG, ("igmp_joingroup_netif: join to new group: "));
+  ip4_addr_debug_print_val(IGMP_DEBUG, group->group_address);
+  LWIP_DEBUGF(IGMP_DEBUG, ("\n"));
+
+  /* If first use of the group, allow the group at the MAC level */
+  if ((group->use == 0) && (netif->igmp_mac_filter != NULL)) {
+    LWIP_DEBUGF(IGMP_DEBUG, ("igmp_joingroup_netif: igmp_mac_filter(ADD "));
+    ip4_addr_debug_print_val(IGMP_DEBUG, group->group_address);
+    LWIP_DEBUGF(IGMP_DEBUG, (") on if %p\n", (void *)netif));
+    netif->igmp_mac_filter(netif, &group->group_address, NETIF_ADD_MAC_FILTER);
+  }
+
+  IGMP_STATS_INC(igmp.tx_join);
+  igmp_send(netif, group, IGMP_V2_MEMB_REPORT);
+
+  igmp_start_timer(group, IGMP_JOIN_DELAYING_MEMBER_TMR);
+
+  /* Need to work out where this timer comes from */
+  group->group_state = IGMP_GROUP_DELAYING_MEMBER;
+}
+
+/**
+ * End the membership of a group that is no longer used: remove it from the
+ * netif's list, send a leave message if necessary and free it.
+ *
+ * @param netif the network interface the group is joined on
+ * @param group the group to leave
+ */
+static void
+igmp_stop_member(struct netif *netif, struct igmp_group *group)
+{
+  /* Remove the group from the list */
+  igmp_remove_group(netif, group);
+
+  /* If we are the last reporter for this group */
+  if (group->last_reporter_flag) {
+    LWIP_DEBUGF(IGMP_DEBUG, ("igmp_leavegroup_netif: sending leaving group\n"));
+    IGMP_STATS_INC(igmp.tx_leave);
+    igmp_send(netif, group, IGMP_LEAVE_GROUP);
+  }
+
+  /* Disable the group at the MAC level */
+  if (netif->igmp_mac_filter != NULL) {
+    LWIP_DEBUGF(IGMP_DEBUG, ("igmp_leavegroup_netif: igmp_mac_filter(DEL "));
+    ip4_addr_debug_print_val(IGMP_DEBUG, group->group_address);
+    LWIP_DEBUGF(IGMP_DEBUG, (") on if %p\n", (void *)netif));
+    netif->igmp_mac_filter(netif, &group->group_address, NETIF_DEL_MAC_FILTER);
+  }
+
+  /* Free group struct */
+  memp_free(MEMP_IGMP_GROUP, group);
+}
+
 /**
  * @ingroup igmp
  * Join a group on one network interface.
@@ -504,25 +653,7 @@ igmp_joingroup_netif(struct netif *netif, const ip4_addr_t *groupaddr)
       LWIP_DEBUGF(IGMP_DEBUG, ("igmp_joingroup_netif: join to group not in state IGMP_GROUP_NON_MEMBER\n"));
     } else {
       /* OK - it was new group */
-      LWIP_DEBUGF(IGMP_DEBUG, ("igmp_joingroup_netif: join to new group: "));
-      ip4_addr_debug_print(IGMP_DEBUG, groupaddr);
-      LWIP_DEBUGF(IGMP_DEBUG, ("\n"));
-
-      /* If first use of the group, allow the group at the MAC level */
-      if ((group->use == 0) && (netif->igmp_mac_filter != NULL)) {
-        LWIP_DEBUGF(IGMP_DEBUG, ("igmp_joingroup_netif: igmp_mac_filter(ADD "));
-        ip4_addr_debug_print(IGMP_DEBUG, groupaddr);
-        LWIP_DEBUGF(IGMP_DEBUG, (") on if %p\n", (void *)netif));
-        netif->igmp_mac_filter(netif, groupaddr, NETIF_ADD_MAC_FILTER);
-      }
-
-      IGMP_STATS_INC(igmp.tx_join);
-      igmp_send(netif, group, IGMP_V2_MEMB_REPORT);
-
-      igmp_start_timer(group, IGMP_JOIN_DELAYING_MEMBER_TMR);
-
-      /* Need to work out where this timer comes from */
-      group->group_state = IGMP_GROUP_DELAYING_MEMBER;
+      igmp_start_member(netif, group);
     }
     /* Increment group use */
     group->use++;
@@ -600,28 +731,20 @@ igmp_leavegroup_netif(struct netif *netif, const ip4_addr_t *groupaddr)
     ip4_addr_debug_print(IGMP_DEBUG, groupaddr);
     LWIP_DEBUGF(IGMP_DEBUG, ("\n"));
 
+#if LWIP_IGMP_SOURCE_FILTER
+    if (group->use == 0) {
+      LWIP_DEBUGF(IGMP_DEBUG, ("igmp_leavegroup_netif: only joined for specific sources\n"));
+      return ERR_VAL;
+    }
+    if (group->sources != NULL) {
+      /* Still joined for specific sources */
+      group->use--;
+      return ERR_OK;
+    }
+#endif /* LWIP_IGMP_SOURCE_FILTER */
     /* If there is no other use of the group */
     if (group->use <= 1) {
-      /* Remove the group from the list */
-      igmp_remove_group(netif, group);
-
-      /* If we are the last reporter for this group */
-      if (group->last_reporter_flag) {
-        LWIP_DEBUGF(IGMP_DEBUG, ("igmp_leavegroup_netif: sending leaving group\n"));
-        IGMP_STATS_INC(igmp.tx_leave);
-        igmp_send(netif, group, IGMP_LEAVE_GROUP);
-      }
-
-      /* Disable the group at the MAC level */
-      if (netif->igmp_mac_filter != NULL) {
-        LWIP_DEBUGF(IGMP_DEBUG, ("igmp_leavegroup_netif: igmp_mac_filter(DEL "));
-        ip4_addr_debug_print(IGMP_DEBUG, groupaddr);
-        LWIP_DEBUGF(IGMP_DEBUG, (") on if %p\n", (void *)netif));
-        netif->igmp_mac_filter(netif, groupaddr, NETIF_DEL_MAC_FILTER);
-      }
-
-      /* Free group struct */
-      memp_free(MEMP_IGMP_GROUP, group);
+      igmp_stop_member(netif, group);
     } else {
       /* Decrement group use */
       group->use--;
@@ -633,6 +756,142 @@ igmp_leavegroup_netif(struct netif *netif, const ip4_addr_t *groupaddr)
   }
 }
 
+#if LWIP_IGMP_SOURCE_FILTER
+/**
+ * @ingroup igmp
+ * Join a group for one source on one network interface (source-specific
+ * multicast, RFC 4607). Packets to the group are only received from the
+ * sources joined like this, unless the group is also joined for any source
+ * with igmp_joingroup_netif().
+ *
+ * The membership is reported with IGMPv2, which cannot carry sources, so the
+ * group is received from all sources and filtered by this host.
+ *
+ * @param netif the network interface which should join the group
+ * @param groupaddr the ip address of the group which to join
+ * @param srcaddr the unicast ip address of the source to receive from
+ * @return ERR_OK if the group was joined for the source, an err_t otherwise
+ */
+err_t
+igmp_joingroup_source_netif(struct netif *netif, const ip4_addr_t *groupaddr, const ip4_addr_t *srcaddr)
+{
+  struct igmp_group *group;
+  struct igmp_source *src;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("igmp_joingroup_source_netif: attempt to join non-multicast address", ip4_addr_ismulticast(groupaddr), return ERR_VAL;);
+  LWIP_ERROR("igmp_joingroup_source_netif: attempt to join allsystems address", (!ip4_addr_eq(groupaddr, &allsystems)), return ERR_VAL;);
+  LWIP_ERROR("igmp_joingroup_source_netif: invalid source address",
+             (srcaddr != NULL) && !ip4_addr_isany(srcaddr) && !ip4_addr_ismulticast(srcaddr), return ERR_VAL;);
+  LWIP_ERROR("igmp_joingroup_source_netif: attempt to join on non-IGMP netif", netif->flags & NETIF_FLAG_IGMP, return ERR_VAL;);
+
+  /* find group or create a new one if not found */
+  group = igmp_lookup_group(netif, groupaddr);
+  if (group == NULL) {
+    return ERR_MEM;
+  }
+  for (src = group->sources; src != NULL; src = src->next) {
+    if (ip4_addr_eq(&src->source_address, srcaddr)) {
+      src->use++;
+      return ERR_OK;
+    }
+  }
+  src = (struct igmp_source *)memp_malloc(MEMP_IGMP_SOURCE);
+  if (src == NULL) {
+    LWIP_DEBUGF(IGMP_DEBUG, ("igmp_joingroup_source_netif: Not enough memory to join to source\n"));
+    if (group->group_state == IGMP_GROUP_NON_MEMBER) {
+      /* the group has just been created for this source */
+      igmp_remove_group(netif, group);
+      memp_free(MEMP_IGMP_GROUP, group);
+    }
+    return ERR_MEM;
+  }
+  ip4_addr_copy(src->source_address, *srcaddr);
+  src->use = 1;
+  src->next = group->sources;
+  group->sources = src;
+
+  if (group->group_state == IGMP_GROUP_NON_MEMBER) {
+    igmp_start_member(netif, group);
+  }
+  return ERR_OK;
+}
+
+/**
+ * @ingroup igmp
+ * Leave a group for one source on one network interface.
+ *
+ * @param netif the network interface which should leave the group
+ * @param groupaddr the ip address of the group which to leave
+ * @param srcaddr the ip address of the source joined with
+ *        igmp_joingroup_source_netif()
+ * @return ERR_OK if the source was left, an err_t otherwise
+ */
+err_t
+igmp_leavegroup_source_netif(struct netif *netif, const ip4_addr_t *groupaddr, const ip4_addr_t *srcaddr)
+{
+  struct igmp_group *group;
+  struct igmp_source **link;
+  struct igmp_source *src;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("igmp_leavegroup_source_netif: invalid source address", srcaddr != NULL, return ERR_VAL;);
+  LWIP_ERROR("igmp_leavegroup_source_netif: attempt to leave on non-IGMP netif", netif->flags & NETIF_FLAG_IGMP, return ERR_VAL;);
+
+  group = igmp_lookfor_group(netif, groupaddr);
+  if (group == NULL) {
+    return ERR_VAL;
+  }
+  for (link = &group->sources; *link != NULL; link = &(*link)->next) {
+    if (ip4_addr_eq(&(*link)->source_address, srcaddr)) {
+      break;
+    }
+  }
+  src = *link;
+  if (src == NULL) {
+    LWIP_DEBUGF(IGMP_DEBUG, ("igmp_leavegroup_source_netif: not member of group for this source\n"));
+    return ERR_VAL;
+  }
+  if (src->use > 1) {
+    src->use--;
+    return ERR_OK;
+  }
+  *link = src->next;
+  memp_free(MEMP_IGMP_SOURCE, src);
+
+  if ((group->use == 0) && (group->sources == NULL)) {
+    igmp_stop_member(netif, group);
+  }
+  return ERR_OK;
+}
+
+/**
+ * Check if packets to a group from a source are received, i.e. if the group
+ * is joined for any source or for this source. Called by ip4_input().
+ *
+ * @param group a group joined on the input netif
+ * @param srcaddr source address of the packet
+ * @return 1 if the packet is accepted, 0 otherwise
+ */
+u8_t
+igmp_group_accepts_source(const struct igmp_group *group, const ip4_addr_t *srcaddr)
+{
+  const struct igmp_source *src;
+
+  if (group->use > 0) {
+    return 1;
+  }
+  for (src = group->sources; src != NULL; src = src->next) {
+    if (ip4_addr_eq(&src->source_address, srcaddr)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+#endif /* LWIP_IGMP_SOURCE_FILTER */
+
 /**
  * The igmp timer function (both for NO_SYS=1 and =0)
  * Should be called every IGMP_TMR_INTERVAL milliseconds (100 ms is default).
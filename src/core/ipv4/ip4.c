@@ -46,6 +46,10 @@
 #include "lwip/def.h"
 #include "lwip/mem.h"
 #include "lwip/ip4_frag.h"
+#include "lwip/ip4_fib.h"
+#include "lwip/ip4_pmtu.h"
+#include "lwip/ip4_mroute.h"
+#include "lwip/ip_fwcache.h"
 #include "lwip/inet_chksum.h"
 #include "lwip/netif.h"
 #include "lwip/icmp.h"
@@ -146,13 +150,17 @@ ip4_route_src(const ip4_addr_t *src, const ip4_addr_t *dest)
  * IP address given to the function.
  *
  * @param dest the destination IP address for which to find the route
+ * @param flow_hash selects one of several equal-cost routes (LWIP_FIB_ECMP)
  * @return the netif on which to send to reach dest
  */
-struct netif *
-ip4_route(const ip4_addr_t *dest)
+static struct netif *
+ip4_route_hashed(const ip4_addr_t *dest, u32_t flow_hash)
 {
 #if !LWIP_SINGLE_NETIF
   struct netif *netif;
+#if LWIP_IPV4_FIB
+  const struct ip4_fib_entry *route;
+#endif /* LWIP_IPV4_FIB */
 
   LWIP_ASSERT_CORE_LOCKED();
 
@@ -166,12 +174,24 @@ ip4_route(const ip4_addr_t *dest)
   /* bug #54569: in case LWIP_SINGLE_NETIF=1 and LWIP_DEBUGF() disabled, the following loop is optimized away */
   LWIP_UNUSED_ARG(dest);
 
+#if LWIP_IPV4_FIB && LWIP_FIB_ECMP
+  route = ip4_fib_lookup_flow(dest, flow_hash);
+#elif LWIP_IPV4_FIB
+  route = ip4_fib_lookup(dest);
+#endif /* LWIP_IPV4_FIB */
+
   /* iterate through netifs */
   NETIF_FOREACH(netif) {
     /* is the netif up, does it have a link and a valid address? */
     if (netif_is_up(netif) && netif_is_link_up(netif) && !ip4_addr_isany_val(*netif_ip4_addr(netif))) {
       /* network mask matches? */
-      if (ip4_addr_net_eq(dest, netif_ip4_addr(netif), netif_ip4_netmask(netif))) {
+      if (ip4_addr_net_eq(dest, netif_ip4_addr(netif), netif_ip4_netmask(netif))
+#if LWIP_IPV4_FIB
+          /* a route to a more specific prefix takes precedence */
+          && ((route == NULL) ||
+              (IP4_FIB_PREFIX_MASK(route->prefix_len) <= lwip_ntohl(ip4_addr_get_u32(netif_ip4_netmask(netif)))))
+#endif /* LWIP_IPV4_FIB */
+         ) {
         /* return netif on which to forward IP packet */
         return netif;
       }
@@ -200,6 +220,12 @@ ip4_route(const ip4_addr_t *dest)
   }
 #endif /* LWIP_NETIF_LOOPBACK && !LWIP_HAVE_LOOPIF */
 
+#if LWIP_IPV4_FIB
+  if (route != NULL) {
+    return route->netif;
+  }
+#endif /* LWIP_IPV4_FIB */
+
 #ifdef LWIP_HOOK_IP4_ROUTE_SRC
   netif = LWIP_HOOK_IP4_ROUTE_SRC(NULL, dest);
   if (netif != NULL) {
@@ -212,6 +238,7 @@ ip4_route(const ip4_addr_t *dest)
   }
 #endif
 #endif /* !LWIP_SINGLE_NETIF */
+  LWIP_UNUSED_ARG(flow_hash);
 
   if ((netif_default == NULL) || !netif_is_up(netif_default) || !netif_is_link_up(netif_default) ||
       ip4_addr_isany_val(*netif_ip4_addr(netif_default)) || ip4_addr_isloopback(dest)) {
@@ -227,6 +254,47 @@ ip4_route(const ip4_addr_t *dest)
   return netif_default;
 }
 
+/**
+ * Finds the appropriate network interface for a given IP address
+ * (see ip4_route_hashed()).
+ *
+ * @param dest the destination IP address for which to find the route
+ * @return the netif on which to send to reach dest
+ */
+struct netif *
+ip4_route(const ip4_addr_t *dest)
+{
+  return ip4_route_hashed(dest, 0);
+}
+
+#if LWIP_FIB_ECMP
+/**
+ * @ingroup ip4
+ * Source based IPv4 routing for a flow: like ip4_route_src(), but if the
+ * route to dest has several equal-cost paths, flow_hash selects the path.
+ *
+ * @param src the source IP address (may be NULL)
+ * @param dest the destination IP address for which to find the route
+ * @param flow_hash hash of the flow (see ip4_flow_hash())
+ * @return the netif on which to send to reach dest
+ */
+struct netif *
+ip4_route_flow(const ip4_addr_t *src, const ip4_addr_t *dest, u32_t flow_hash)
+{
+#ifdef LWIP_HOOK_IP4_ROUTE_SRC
+  if (src != NULL) {
+    struct netif *netif = LWIP_HOOK_IP4_ROUTE_SRC(src, dest);
+    if (netif != NULL) {
+      return netif;
+    }
+  }
+#else /* LWIP_HOOK_IP4_ROUTE_SRC */
+  LWIP_UNUSED_ARG(src);
+#endif /* LWIP_HOOK_IP4_ROUTE_SRC */
+  return ip4_route_hashed(dest, flow_hash);
+}
+#endif /* LWIP_FIB_ECMP */
+
 #if IP_FORWARD
 /**
  * Determine whether an IP address is in a reserved set of addresses
@@ -268,6 +336,31 @@ ip4_canforward(struct pbuf *p)
   return 1;
 }
 
+#if LWIP_FIB_ECMP
+/**
+ * Flow hash of a packet to forward: addresses, protocol and, for TCP and UDP,
+ * the ports. Fragments are hashed without ports (only the first one has
+ * them) so that all fragments of a datagram take the same path.
+ */
+static u32_t
+ip4_forward_flow_hash(const struct pbuf *p, const struct ip_hdr *iphdr)
+{
+  u16_t sport = 0;
+  u16_t dport = 0;
+  u16_t hlen = IPH_HL_BYTES(iphdr);
+
+  if (((IPH_PROTO(iphdr) == IP_PROTO_TCP) || (IPH_PROTO(iphdr) == IP_PROTO_UDP) ||
+       (IPH_PROTO(iphdr) == IP_PROTO_UDPLITE)) &&
+      ((IPH_OFFSET(iphdr) & PP_HTONS(IP_OFFMASK | IP_MF)) == 0) && (p->len >= hlen + 4)) {
+    /* TCP and UDP both start with source and destination port */
+    const u16_t *ports = (const u16_t *)(const void *)((const u8_t *)iphdr + hlen);
+    sport = lwip_ntohs(ports[0]);
+    dport = lwip_ntohs(ports[1]);
+  }
+  return ip4_flow_hash(ip4_current_src_addr(), ip4_current_dest_addr(), IPH_PROTO(iphdr), sport, dport);
+}
+#endif /* LWIP_FIB_ECMP */
+
 /**
  * Forwards an IP packet. It finds an appropriate route for the
  * packet, decrements the TTL value of the packet, adjusts the
@@ -281,6 +374,11 @@ static void
 ip4_forward(struct pbuf *p, struct ip_hdr *iphdr, struct netif *inp)
 {
   struct netif *netif;
+  u16_t mtu;
+  u32_t flow_hash = 0;
+#if IP_FORWARD_FLOW_CACHE
+  struct ip4_fwcache_entry *flow;
+#endif /* IP_FORWARD_FLOW_CACHE */
 
   PERF_START;
   LWIP_UNUSED_ARG(inp);
@@ -297,23 +395,42 @@ ip4_forward(struct pbuf *p, struct ip_hdr *iphdr, struct netif *inp)
     goto return_noroute;
   }
 
-  /* Find network interface where to forward this IP packet to. */
-  netif = ip4_route_src(ip4_current_src_addr(), ip4_current_dest_addr());
-  if (netif == NULL) {
-    LWIP_DEBUGF(IP_DEBUG, ("ip4_forward: no forwarding route for %"U16_F".%"U16_F".%"U16_F".%"U16_F" found\n",
-                           ip4_addr1_16(ip4_current_dest_addr()), ip4_addr2_16(ip4_current_dest_addr()),
-                           ip4_addr3_16(ip4_current_dest_addr()), ip4_addr4_16(ip4_current_dest_addr())));
-    /* @todo: send ICMP_DUR_NET? */
-    goto return_noroute;
-  }
+#if LWIP_FIB_ECMP
+  flow_hash = ip4_forward_flow_hash(p, iphdr);
+#endif /* LWIP_FIB_ECMP */
+  LWIP_UNUSED_ARG(flow_hash);
+
+#if IP_FORWARD_FLOW_CACHE
+  /* Known flow? Use the cached output netif and next hop. */
+  flow = ip4_fwcache_lookup(ip4_current_src_addr(), ip4_current_dest_addr(), inp, flow_hash);
+  if (flow != NULL) {
+    netif = flow->netif;
+    mtu = flow->mtu;
+  } else
+#endif /* IP_FORWARD_FLOW_CACHE */
+  {
+    /* Find network interface where to forward this IP packet to. */
+    netif = ip4_route_flow(ip4_current_src_addr(), ip4_current_dest_addr(), flow_hash);
+    if (netif == NULL) {
+      LWIP_DEBUGF(IP_DEBUG, ("ip4_forward: no forwarding route for %"U16_F".%"U16_F".%"U16_F".%"U16_F" found\n",
+                             ip4_addr1_16(ip4_current_dest_addr()), ip4_addr2_16(ip4_current_dest_addr()),
+                             ip4_addr3_16(ip4_current_dest_addr()), ip4_addr4_16(ip4_current_dest_addr())));
+      /* @todo: send ICMP_DUR_NET? */
+      goto return_noroute;
+    }
 #if !IP_FORWARD_ALLOW_TX_ON_RX_NETIF
-  /* Do not forward packets onto the same network interface on which
-   * they arrived. */
-  if (netif == inp) {
-    LWIP_DEBUGF(IP_DEBUG, ("ip4_forward: not bouncing packets back on incoming interface.\n"));
-    goto return_noroute;
-  }
+    /* Do not forward packets onto the same network interface on which
+     * they arrived. */
+    if (netif == inp) {
+      LWIP_DEBUGF(IP_DEBUG, ("ip4_forward: not bouncing packets back on incoming interface.\n"));
+      goto return_noroute;
+    }
 #endif /* IP_FORWARD_ALLOW_TX_ON_RX_NETIF */
+    mtu = netif->mtu;
+#if IP_FORWARD_FLOW_CACHE
+    flow = ip4_fwcache_add(ip4_current_src_addr(), ip4_current_dest_addr(), inp, netif, flow_hash);
+#endif /* IP_FORWARD_FLOW_CACHE */
+  }
 
   /* decrement TTL */
   IPH_TTL_SET(iphdr, IPH_TTL(iphdr) - 1);
@@ -380,7 +497,7 @@ ip4_forward(struct pbuf *p, struct ip_hdr *iphdr, struct netif *inp)
 
   PERF_STOP("ip4_forward");
   /* don't fragment if interface has mtu set to 0 [loopif] */
-  if (netif->mtu && (p->tot_len > netif->mtu)) {
+  if (mtu && (p->tot_len > mtu)) {
     if ((IPH_OFFSET(iphdr) & PP_NTOHS(IP_DF)) == 0) {
 #if IP_FRAG
       ip4_frag(p, netif, ip4_current_dest_addr());
@@ -390,13 +507,17 @@ ip4_forward(struct pbuf *p, struct ip_hdr *iphdr, struct netif *inp)
     } else {
 #if LWIP_ICMP
       /* send ICMP Destination Unreachable code 4: "Fragmentation Needed and DF Set" */
-      icmp_dest_unreach(p, ICMP_DUR_FRAG);
+      icmp_frag_needed(p, mtu);
 #endif /* LWIP_ICMP */
     }
     return;
   }
   /* transmit pbuf on chosen interface */
+#if IP_FORWARD_FLOW_CACHE
+  ip4_fwcache_output(flow, p);
+#else /* IP_FORWARD_FLOW_CACHE */
   netif->output(netif, p, ip4_current_dest_addr());
+#endif /* IP_FORWARD_FLOW_CACHE */
   return;
 return_noroute:
   MIB2_STATS_INC(mib2.ipoutnoroutes);
@@ -552,7 +673,19 @@ ip4_input(struct pbuf *p, struct netif *inp)
   /* match packet against an interface, i.e. is this packet for us? */
   if (ip4_addr_ismulticast(ip4_current_dest_addr())) {
 #if LWIP_IGMP
-    if ((inp->flags & NETIF_FLAG_IGMP) && (igmp_lookfor_group(inp, ip4_current_dest_addr()))) {
+    struct igmp_group *group = NULL;
+    if (inp->flags & NETIF_FLAG_IGMP) {
+      group = igmp_lookfor_group(inp, ip4_current_dest_addr());
+#if LWIP_IGMP_SOURCE_FILTER
+      /* IGMP messages are processed regardless of the sources joined */
+      if ((group != NULL) && (IPH_PROTO(iphdr) != IP_PROTO_IGMP) &&
+          !igmp_group_accepts_source(group, ip4_current_src_addr())) {
+        LWIP_DEBUGF(IP_DEBUG | LWIP_DBG_TRACE, ("ip4_input: multicast source not joined.\n"));
+        group = NULL;
+      }
+#endif /* LWIP_IGMP_SOURCE_FILTER */
+    }
+    if (group != NULL) {
       /* IGMP snooping switches need 0.0.0.0 to be allowed as source address (RFC 4541) */
       ip4_addr_t allsystems;
       IP4_ADDR(&allsystems, 224, 0, 0, 1);
@@ -648,6 +781,13 @@ ip4_input(struct pbuf *p, struct netif *inp)
     }
   }
 
+#if LWIP_IPV4_MROUTE
+  if (ip4_addr_ismulticast(ip4_current_dest_addr())) {
+    /* forward copies to the output netifs of a multicast route */
+    ip4_mroute_forward(p, inp);
+  }
+#endif /* LWIP_IPV4_MROUTE */
+
   /* packet not for us? */
   if (netif == NULL) {
     /* packet not for us, route or discard */
@@ -960,7 +1100,15 @@ ip4_output_if_opt_src(struct pbuf *p, const ip4_addr_t *src, const ip4_addr_t *d
 #if CHECKSUM_GEN_IP_INLINE
     chk_sum += iphdr->_len;
 #endif /* CHECKSUM_GEN_IP_INLINE */
+#if LWIP_IPV4_PMTU
+    /* TCP adapts its segments to the path MTU, so they must not be fragmented */
+    IPH_OFFSET_SET(iphdr, (proto == IP_PROTO_TCP) ? PP_HTONS(IP_DF) : 0);
+#if CHECKSUM_GEN_IP_INLINE
+    chk_sum += iphdr->_offset;
+#endif /* CHECKSUM_GEN_IP_INLINE */
+#else /* LWIP_IPV4_PMTU */
     IPH_OFFSET_SET(iphdr, 0);
+#endif /* LWIP_IPV4_PMTU */
     if ((proto == IP_PROTO_TCP) && (p->tot_len <= IP4_MIN_MTU_LENGTH))
     {
       /* For small TCP packets, e.g. protocol handshake,
@@ -1040,12 +1188,32 @@ ip4_output_if_opt_src(struct pbuf *p, const ip4_addr_t *src, const ip4_addr_t *d
   }
 #endif /* LWIP_MULTICAST_TX_OPTIONS */
 #endif /* ENABLE_LOOPBACK */
+#if LWIP_IPV4_PMTU
+  if ((p->tot_len > ip4_pmtu_lowest) && (p->tot_len <= netif->mtu) &&
+      ((IPH_OFFSET(iphdr) & PP_HTONS(IP_DF)) != 0) && (p->tot_len > ip4_pmtu_get(dest, netif))) {
+    /* Too big for the path and must not be fragmented: don't send it only
+       for a router on the path to drop it. TCP reduces its MSS before
+       sending (see tcp_pmtu_check()), so this is for other protocols. */
+    LWIP_DEBUGF(IP_DEBUG, ("ip4_output_if: DF packet exceeds path MTU\n"));
+    IP_STATS_INC(ip.drop);
+    MIB2_STATS_INC(mib2.ipoutdiscards);
+    return ERR_MTU;
+  }
+#endif /* LWIP_IPV4_PMTU */
 #if IP_FRAG
   /* don't fragment if interface has mtu set to 0 [loopif] */
-  if (netif->mtu && (p->tot_len > netif->mtu)) {
+  if (netif->mtu && ((p->tot_len > netif->mtu)
+#if LWIP_IPV4_PMTU
+                     || ((p->tot_len > ip4_pmtu_lowest) && (p->tot_len > ip4_pmtu_get(dest, netif)))
+#endif /* LWIP_IPV4_PMTU */
+                    )) {
     return ip4_frag(p, netif, dest);
   }
 #endif /* IP_FRAG */
+#if LWIP_NETIF_FRAG_OFFLOAD
+  /* the pbuf might have been fragmented by a netif before */
+  p->frag_size = 0;
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
 
   LWIP_DEBUGF(IP_DEBUG, ("ip4_output_if: call netif->output()\n"));
   return netif->output(netif, p, dest);
@@ -0,0 +1,523 @@
+/**
+ * @file
+ * IPv4 forwarding information base (longest-prefix-match routing table)
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+/**
+ * @defgroup ip4_fib IPv4 routing table
+ * @ingroup ip4
+ *
+ * Static IPv4 routes with longest-prefix-match lookup, used by ip4_route()
+ * for destinations that are not on a netif's own subnet and by
+ * etharp_output() to select the gateway of a route.
+ *
+ * Routes are kept in a path-compressed binary trie: every node stores its
+ * full prefix, and nodes are only created where routes are or where two
+ * routes branch. A lookup therefore visits at most one node per distinct
+ * prefix length on the path to the destination instead of every route.
+ * Nodes come from the MEMP_IP4_FIB_NODE pool; n routes need at most
+ * 2 * n - 1 nodes.
+ *
+ * A route to a more specific prefix than a netif's own subnet takes
+ * precedence over that subnet in ip4_route(). Routes whose netif is down
+ * or has no link are skipped (the next less specific route is used).
+ *
+ * With LWIP_FIB_ECMP, a prefix can be added once per netif. The extra paths
+ * take one MEMP_IP4_FIB_NODE each and are chosen by ip4_fib_lookup_flow()
+ * from a flow hash modulo the number of usable paths.
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_IPV4 && LWIP_IPV4_FIB /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/ip4_fib.h"
+#include "lwip/def.h"
+#include "lwip/memp.h"
+#include "lwip/ip4.h"
+#include "lwip/ip_fwcache.h"
+
+#include <string.h>
+
+/** The bit of 'key' following the first 'pos' bits */
+#define IP4_FIB_BIT(key, pos) ((u8_t)(((key) >> (31 - (pos))) & 1))
+/** Does the node's prefix cover 'key'? */
+#define IP4_FIB_MATCH(key, node) ((((key) ^ (node)->prefix) & IP4_FIB_PREFIX_MASK((node)->prefix_len)) == 0)
+
+static struct ip4_fib_entry *ip4_fib_root;
+
+/** The node link pointing to 'node' */
+static struct ip4_fib_entry **
+ip4_fib_link(struct ip4_fib_entry *node)
+{
+  struct ip4_fib_entry *parent = node->parent;
+  if (parent == NULL) {
+    return &ip4_fib_root;
+  }
+  return &parent->child[parent->child[1] == node];
+}
+
+/** Remove a node that is not a route any more and its parent if that only
+ * branched to this node */
+static void
+ip4_fib_prune(struct ip4_fib_entry *node)
+{
+  while ((node != NULL) && (node->netif == NULL) &&
+         ((node->child[0] == NULL) || (node->child[1] == NULL))) {
+    struct ip4_fib_entry *parent = node->parent;
+    struct ip4_fib_entry *child = (node->child[0] != NULL) ? node->child[0] : node->child[1];
+
+    *ip4_fib_link(node) = child;
+    if (child != NULL) {
+      child->parent = parent;
+    }
+    memp_free(MEMP_IP4_FIB_NODE, node);
+    node = parent;
+  }
+}
+
+/** Remove the path via 'netif' from a route node.
+ * @return 1 if the path was removed (the node may have been freed), 0 if
+ *         the route has no path via 'netif'
+ */
+static int
+ip4_fib_drop_path(struct ip4_fib_entry *node, const struct netif *netif)
+{
+#if LWIP_FIB_ECMP
+  struct ip4_fib_entry **link;
+  struct ip4_fib_entry *path;
+
+  if (node->netif != netif) {
+    for (link = &node->next; (path = *link) != NULL; link = &path->next) {
+      if (path->netif == netif) {
+        *link = path->next;
+        memp_free(MEMP_IP4_FIB_NODE, path);
+        return 1;
+      }
+    }
+    return 0;
+  }
+  path = node->next;
+  if (path != NULL) {
+    /* the next path takes over the trie node */
+    ip4_addr_copy(node->gw, path->gw);
+    node->netif = path->netif;
+    node->next = path->next;
+    memp_free(MEMP_IP4_FIB_NODE, path);
+    return 1;
+  }
+#else /* LWIP_FIB_ECMP */
+  if (node->netif != netif) {
+    return 0;
+  }
+#endif /* LWIP_FIB_ECMP */
+  node->netif = NULL;
+  ip4_fib_prune(node);
+  return 1;
+}
+
+/** Can packets be sent along this path? */
+static int
+ip4_fib_usable(const struct ip4_fib_entry *path)
+{
+  return (path->netif != NULL) && netif_is_up(path->netif) && netif_is_link_up(path->netif);
+}
+
+/** The first usable path of a route node (NULL if there is none) */
+static const struct ip4_fib_entry *
+ip4_fib_first_usable(const struct ip4_fib_entry *node)
+{
+#if LWIP_FIB_ECMP
+  for (; node != NULL; node = node->next) {
+    if (ip4_fib_usable(node)) {
+      return node;
+    }
+  }
+  return NULL;
+#else /* LWIP_FIB_ECMP */
+  return ip4_fib_usable(node) ? node : NULL;
+#endif /* LWIP_FIB_ECMP */
+}
+
+/** Find the most specific route node to 'dest' with a usable path */
+static const struct ip4_fib_entry *
+ip4_fib_find_best(const ip4_addr_t *dest)
+{
+  const struct ip4_fib_entry *node = ip4_fib_root;
+  const struct ip4_fib_entry *best = NULL;
+  u32_t key = lwip_ntohl(ip4_addr_get_u32(dest));
+
+  while ((node != NULL) && IP4_FIB_MATCH(key, node)) {
+    if (ip4_fib_first_usable(node) != NULL) {
+      best = node;
+    }
+    if (node->prefix_len == 32) {
+      break;
+    }
+    node = node->child[IP4_FIB_BIT(key, node->prefix_len)];
+  }
+  return best;
+}
+
+/** Pre-order successor of a node (or NULL at the end of the trie) */
+static struct ip4_fib_entry *
+ip4_fib_walk_next(struct ip4_fib_entry *node)
+{
+  if (node->child[0] != NULL) {
+    return node->child[0];
+  }
+  if (node->child[1] != NULL) {
+    return node->child[1];
+  }
+  while (node->parent != NULL) {
+    struct ip4_fib_entry *parent = node->parent;
+    if ((parent->child[0] == node) && (parent->child[1] != NULL)) {
+      return parent->child[1];
+    }
+    node = parent;
+  }
+  return NULL;
+}
+
+/**
+ * @ingroup ip4_fib
+ * Add a route.
+ *
+ * @param prefix destination network (host bits must be 0)
+ * @param prefix_len length of the network prefix (0..32, 0 is a default route)
+ * @param gw gateway to send to (NULL or IP4_ADDR_ANY for on-link routes)
+ * @param netif netif to send on
+ * @return ERR_OK on success, ERR_USE if a route for this prefix exists
+ *         (with LWIP_FIB_ECMP: a route for this prefix via this netif),
+ *         ERR_MEM if the MEMP_IP4_FIB_NODE pool is exhausted
+ */
+err_t
+ip4_fib_add(const ip4_addr_t *prefix, u8_t prefix_len, const ip4_addr_t *gw, struct netif *netif)
+{
+  struct ip4_fib_entry **link = &ip4_fib_root;
+  struct ip4_fib_entry *parent = NULL;
+  struct ip4_fib_entry *node, *entry;
+  u32_t key;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("ip4_fib_add: invalid prefix", (prefix != NULL) && (prefix_len <= 32), return ERR_VAL;);
+  LWIP_ERROR("ip4_fib_add: invalid netif", netif != NULL, return ERR_VAL;);
+
+  key = lwip_ntohl(ip4_addr_get_u32(prefix));
+  LWIP_ERROR("ip4_fib_add: host bits set in prefix", (key & ~IP4_FIB_PREFIX_MASK(prefix_len)) == 0, return ERR_VAL;);
+  IP_FWCACHE_INVALIDATE();
+
+  /* descend while the nodes are prefixes of the new route */
+  while ((node = *link) != NULL) {
+    if ((node->prefix_len > prefix_len) || !IP4_FIB_MATCH(key, node)) {
+      break;
+    }
+    if (node->prefix_len == prefix_len) {
+#if LWIP_FIB_ECMP
+      if (node->netif != NULL) {
+        /* add another path to the route */
+        struct ip4_fib_entry **tail = &node->next;
+        if (node->netif == netif) {
+          return ERR_USE;
+        }
+        for (; *tail != NULL; tail = &(*tail)->next) {
+          if ((*tail)->netif == netif) {
+            return ERR_USE;
+          }
+        }
+        entry = (struct ip4_fib_entry *)memp_malloc(MEMP_IP4_FIB_NODE);
+        if (entry == NULL) {
+          return ERR_MEM;
+        }
+        memset(entry, 0, sizeof(struct ip4_fib_entry));
+        entry->prefix = key;
+        entry->prefix_len = prefix_len;
+        ip4_addr_set(&entry->gw, gw);
+        entry->netif = netif;
+        *tail = entry;
+        return ERR_OK;
+      }
+#else /* LWIP_FIB_ECMP */
+      if (node->netif != NULL) {
+        return ERR_USE;
+      }
+#endif /* LWIP_FIB_ECMP */
+      /* turn the branch node into a route */
+      ip4_addr_set(&node->gw, gw);
+      node->netif = netif;
+      return ERR_OK;
+    }
+    parent = node;
+    link = &node->child[IP4_FIB_BIT(key, node->prefix_len)];
+  }
+
+  entry = (struct ip4_fib_entry *)memp_malloc(MEMP_IP4_FIB_NODE);
+  if (entry == NULL) {
+    return ERR_MEM;
+  }
+  entry->child[0] = entry->child[1] = NULL;
+  entry->parent = parent;
+#if LWIP_FIB_ECMP
+  entry->next = NULL;
+#endif /* LWIP_FIB_ECMP */
+  entry->prefix = key;
+  entry->prefix_len = prefix_len;
+  ip4_addr_set(&entry->gw, gw);
+  entry->netif = netif;
+
+  if (node != NULL) {
+    /* 'node' is more specific than or diverges from the new route */
+    u32_t diff = key ^ node->prefix;
+    u8_t common = 0;
+    u8_t max = LWIP_MIN(prefix_len, node->prefix_len);
+    while ((common < max) && !(diff & (0x80000000UL >> common))) {
+      common++;
+    }
+    if (common == prefix_len) {
+      /* the new route is a prefix of 'node': insert it above */
+      entry->child[IP4_FIB_BIT(node->prefix, prefix_len)] = node;
+      node->parent = entry;
+    } else {
+      /* branch at the first differing bit */
+      struct ip4_fib_entry *branch = (struct ip4_fib_entry *)memp_malloc(MEMP_IP4_FIB_NODE);
+      if (branch == NULL) {
+        memp_free(MEMP_IP4_FIB_NODE, entry);
+        return ERR_MEM;
+      }
+      branch->parent = parent;
+      branch->prefix = key & IP4_FIB_PREFIX_MASK(common);
+      branch->prefix_len = common;
+      ip4_addr_set_any(&branch->gw);
+      branch->netif = NULL;
+#if LWIP_FIB_ECMP
+      branch->next = NULL;
+#endif /* LWIP_FIB_ECMP */
+      branch->child[IP4_FIB_BIT(key, common)] = entry;
+      branch->child[IP4_FIB_BIT(node->prefix, common)] = node;
+      entry->parent = branch;
+      node->parent = branch;
+      entry = branch;
+    }
+  }
+  *link = entry;
+  return ERR_OK;
+}
+
+/**
+ * @ingroup ip4_fib
+ * Remove a route (with LWIP_FIB_ECMP: all its paths).
+ *
+ * @param prefix destination network of the route
+ * @param prefix_len length of the network prefix
+ * @return ERR_OK on success, ERR_VAL if there is no such route
+ */
+err_t
+ip4_fib_remove(const ip4_addr_t *prefix, u8_t prefix_len)
+{
+  struct ip4_fib_entry *node = ip4_fib_root;
+  u32_t key;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("ip4_fib_remove: invalid prefix", (prefix != NULL) && (prefix_len <= 32), return ERR_VAL;);
+
+  key = lwip_ntohl(ip4_addr_get_u32(prefix));
+  while ((node != NULL) && (node->prefix_len <= prefix_len) && IP4_FIB_MATCH(key, node)) {
+    if (node->prefix_len == prefix_len) {
+      if (node->netif == NULL) {
+        break;
+      }
+#if LWIP_FIB_ECMP
+      while (node->next != NULL) {
+        struct ip4_fib_entry *path = node->next;
+        node->next = path->next;
+        memp_free(MEMP_IP4_FIB_NODE, path);
+      }
+#endif /* LWIP_FIB_ECMP */
+      node->netif = NULL;
+      ip4_fib_prune(node);
+      IP_FWCACHE_INVALIDATE();
+      return ERR_OK;
+    }
+    node = node->child[IP4_FIB_BIT(key, node->prefix_len)];
+  }
+  return ERR_VAL;
+}
+
+#if LWIP_FIB_ECMP
+/**
+ * @ingroup ip4_fib
+ * Remove one path of a route.
+ *
+ * @param prefix destination network of the route
+ * @param prefix_len length of the network prefix
+ * @param netif netif of the path to remove
+ * @return ERR_OK on success, ERR_VAL if there is no such path
+ */
+err_t
+ip4_fib_remove_path(const ip4_addr_t *prefix, u8_t prefix_len, const struct netif *netif)
+{
+  struct ip4_fib_entry *node = ip4_fib_root;
+  u32_t key;
+
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("ip4_fib_remove_path: invalid prefix", (prefix != NULL) && (prefix_len <= 32), return ERR_VAL;);
+  LWIP_ERROR("ip4_fib_remove_path: invalid netif", netif != NULL, return ERR_VAL;);
+
+  key = lwip_ntohl(ip4_addr_get_u32(prefix));
+  while ((node != NULL) && (node->prefix_len <= prefix_len) && IP4_FIB_MATCH(key, node)) {
+    if (node->prefix_len == prefix_len) {
+      if (!ip4_fib_drop_path(node, netif)) {
+        break;
+      }
+      IP_FWCACHE_INVALIDATE();
+      return ERR_OK;
+    }
+    node = node->child[IP4_FIB_BIT(key, node->prefix_len)];
+  }
+  return ERR_VAL;
+}
+
+/**
+ * @ingroup ip4_fib
+ * Find the most specific route to a destination that has a usable path and
+ * select one of its usable paths by a flow hash.
+ *
+ * @param dest destination address
+ * @param flow_hash hash of the flow (see ip4_flow_hash()); packets with the
+ *        same hash take the same path as long as the set of usable paths
+ *        does not change
+ * @return the selected path or NULL if no route matches
+ */
+const struct ip4_fib_entry *
+ip4_fib_lookup_flow(const ip4_addr_t *dest, u32_t flow_hash)
+{
+  const struct ip4_fib_entry *best = ip4_fib_find_best(dest);
+  const struct ip4_fib_entry *path;
+  u32_t n = 0;
+
+  if (best == NULL) {
+    return NULL;
+  }
+  for (path = best; path != NULL; path = path->next) {
+    if (ip4_fib_usable(path)) {
+      n++;
+    }
+  }
+  n = flow_hash % n;
+  for (path = best; ; path = path->next) {
+    if (ip4_fib_usable(path)) {
+      if (n == 0) {
+        return path;
+      }
+      n--;
+    }
+  }
+}
+#endif /* LWIP_FIB_ECMP */
+
+/**
+ * @ingroup ip4_fib
+ * Find the most specific route to a destination whose netif is up and has
+ * a link (with LWIP_FIB_ECMP: its first usable path).
+ *
+ * @param dest destination address
+ * @return the route or NULL if no route matches
+ */
+const struct ip4_fib_entry *
+ip4_fib_lookup(const ip4_addr_t *dest)
+{
+  const struct ip4_fib_entry *best = ip4_fib_find_best(dest);
+
+  if (best == NULL) {
+    return NULL;
+  }
+  return ip4_fib_first_usable(best);
+}
+
+/**
+ * Get the next hop for a destination that ip4_route() sent via a netif
+ * because of a route (used by etharp_output()).
+ *
+ * @param dest destination address
+ * @param netif the netif the packet is sent on
+ * @return the gateway of the matching route, dest for on-link routes or NULL
+ *         if no route to dest via netif exists or the subnet of netif is
+ *         at least as specific as the route
+ */
+const ip4_addr_t *
+ip4_fib_next_hop(const ip4_addr_t *dest, const struct netif *netif)
+{
+  const struct ip4_fib_entry *route = ip4_fib_find_best(dest);
+
+#if LWIP_FIB_ECMP
+  /* the path via netif that ip4_fib_lookup_flow() may have selected */
+  while ((route != NULL) && ((route->netif != netif) || !ip4_fib_usable(route))) {
+    route = route->next;
+  }
+#endif /* LWIP_FIB_ECMP */
+  if ((route == NULL) || (route->netif != netif)) {
+    return NULL;
+  }
+  if (ip4_addr_net_eq(dest, netif_ip4_addr(netif), netif_ip4_netmask(netif)) &&
+      (IP4_FIB_PREFIX_MASK(route->prefix_len) <= lwip_ntohl(ip4_addr_get_u32(netif_ip4_netmask(netif))))) {
+    /* ip4_route() prefers the subnet of the netif */
+    return NULL;
+  }
+  if (ip4_addr_isany_val(route->gw)) {
+    return dest;
+  }
+  return &route->gw;
+}
+
+/**
+ * Remove all routes via a netif (called when the netif is removed).
+ *
+ * @param netif the netif being removed
+ */
+void
+ip4_fib_cleanup_netif(const struct netif *netif)
+{
+  struct ip4_fib_entry *node = ip4_fib_root;
+
+  IP_FWCACHE_INVALIDATE();
+  while (node != NULL) {
+    if (ip4_fib_drop_path(node, netif)) {
+      /* pruning may free any node on the path: restart */
+      node = ip4_fib_root;
+    } else {
+      node = ip4_fib_walk_next(node);
+    }
+  }
+}
+
+#endif /* LWIP_IPV4 && LWIP_IPV4_FIB */
@@ -43,11 +43,13 @@
 #if LWIP_IPV4
 
 #include "lwip/ip4_frag.h"
+#include "lwip/ip4_pmtu.h"
 #include "lwip/def.h"
 #include "lwip/inet_chksum.h"
 #include "lwip/netif.h"
 #include "lwip/stats.h"
 #include "lwip/icmp.h"
+#include "lwip/priv/ip_reass_tree.h"
 
 #include <string.h>
 
@@ -59,6 +61,11 @@
  *   currently, overlapping or duplicate fragments are thrown away
  *   if IP_REASS_CHECK_OVERLAP=1 (the default)!
  *
+ * Datagrams are kept in IP_REASS_HASH_SIZE lists hashed by source address
+ * (which also allows limiting the pbufs per source, see
+ * IP_REASS_MAX_PBUFS_PER_SOURCE), the fragments of a datagram in a tree
+ * sorted by offset (see ip_reass_tree.c).
+ *
  * @todo: work with IP header options
  */
 
@@ -83,40 +90,22 @@
 #define IP_REASS_VALIDATE_PBUF_QUEUED        0
 #define IP_REASS_VALIDATE_PBUF_DROPPED       -1
 
-/** This is a helper struct which holds the starting
- * offset and the ending offset of this fragment to
- * easily chain the fragments.
- * It has the same packing requirements as the IP header, since it replaces
- * the IP header in memory in incoming fragments (after copying it) to keep
- * track of the various fragments. (-> If the IP header doesn't need packing,
- * this struct doesn't need packing, too.)
- */
-#ifdef PACK_STRUCT_USE_INCLUDES
-#  include "arch/bpstruct.h"
-#endif
-PACK_STRUCT_BEGIN
-struct ip_reass_helper {
-  PACK_STRUCT_FIELD(struct pbuf *next_pbuf);
-  PACK_STRUCT_FIELD(u16_t start);
-  PACK_STRUCT_FIELD(u16_t end);
-} PACK_STRUCT_STRUCT;
-PACK_STRUCT_END
-#ifdef PACK_STRUCT_USE_INCLUDES
-#  include "arch/epstruct.h"
-#endif
-
 #define IP_ADDRESSES_AND_ID_MATCH(iphdrA, iphdrB)  \
   (ip4_addr_eq(&(iphdrA)->src, &(iphdrB)->src) && \
    ip4_addr_eq(&(iphdrA)->dest, &(iphdrB)->dest) && \
-   IPH_ID(iphdrA) == IPH_ID(iphdrB)) ? 1 : 0
+   IPH_ID(iphdrA) == IPH_ID(iphdrB) && \
+   IPH_PROTO(iphdrA) == IPH_PROTO(iphdrB)) ? 1 : 0
+
+/** Hash bucket of the datagrams from the source address of an IP header */
+#define IP_REASS_BUCKET(iphdr) IP_REASS_HASH(ip4_addr_get_u32(&(iphdr)->src))
 
 /* global variables */
-static struct ip_reassdata *reassdatagrams;
+static struct ip_reassdata *reassdatagrams[IP_REASS_HASH_SIZE];
 static u16_t ip_reass_pbufcount;
 
 /* function prototypes */
-static void ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev);
-static int ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev);
+static void ip_reass_dequeue_datagram(struct ip_reassdata *ipr);
+static int ip_reass_free_complete_datagram(struct ip_reassdata *ipr);
 
 /**
  * Reassembly timer base function
@@ -127,26 +116,28 @@ static int ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_r
 void
 ip_reass_tmr(void)
 {
-  struct ip_reassdata *r, *prev = NULL;
-
-  r = reassdatagrams;
-  while (r != NULL) {
-    /* Decrement the timer. Once it reaches 0,
-     * clean up the incomplete fragment assembly */
-    if (r->timer > 0) {
-      r->timer--;
-      LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_tmr: timer dec %"U16_F"\n", (u16_t)r->timer));
-      prev = r;
-      r = r->next;
-    } else {
-      /* reassembly timed out */
-      struct ip_reassdata *tmp;
-      LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_tmr: timer timed out\n"));
-      tmp = r;
-      /* get the next pointer before freeing */
-      r = r->next;
-      /* free the helper struct and all enqueued pbufs */
-      ip_reass_free_complete_datagram(tmp, prev);
+  struct ip_reassdata *r;
+  u16_t i;
+
+  for (i = 0; i < IP_REASS_HASH_SIZE; i++) {
+    r = reassdatagrams[i];
+    while (r != NULL) {
+      /* Decrement the timer. Once it reaches 0,
+       * clean up the incomplete fragment assembly */
+      if (r->timer > 0) {
+        r->timer--;
+        LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_tmr: timer dec %"U16_F"\n", (u16_t)r->timer));
+        r = r->next;
+      } else {
+        /* reassembly timed out */
+        struct ip_reassdata *tmp;
+        LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_tmr: timer timed out\n"));
+        tmp = r;
+        /* get the next pointer before freeing */
+        r = r->next;
+        /* free the helper struct and all enqueued pbufs */
+        ip_reass_free_complete_datagram(tmp);
+      }
     }
   }
 }
@@ -157,58 +148,47 @@ ip_reass_tmr(void)
  * SNMP counters and sends an ICMP time exceeded packet.
  *
  * @param ipr datagram to free
- * @param prev the previous datagram in the linked list
  * @return the number of pbufs freed
  */
 static int
-ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev)
+ip_reass_free_complete_datagram(struct ip_reassdata *ipr)
 {
   u16_t pbufs_freed = 0;
   u16_t clen;
   struct pbuf *p;
-  struct ip_reass_helper *iprh;
-
-  LWIP_ASSERT("prev != ipr", prev != ipr);
-  if (prev != NULL) {
-    LWIP_ASSERT("prev->next == ipr", prev->next == ipr);
-  }
 
   MIB2_STATS_INC(mib2.ipreasmfails);
 #if LWIP_ICMP
-  if (ipr->p != NULL) {
-    iprh = (struct ip_reass_helper *)ipr->p->payload;
-    if (iprh->start == 0) {
-      /* The first fragment was received, send ICMP time exceeded. */
-      /* First, de-queue the first pbuf from r->p. */
-      p = ipr->p;
-      ipr->p = iprh->next_pbuf;
-      /* Then, copy the original header into it. */
-      SMEMCPY(p->payload, &ipr->iphdr, IP_HLEN);
-      icmp_time_exceeded(p, ICMP_TE_FRAG);
-      clen = pbuf_clen(p);
-      LWIP_ASSERT("pbufs_freed + clen <= 0xffff", pbufs_freed + clen <= 0xffff);
-      pbufs_freed = (u16_t)(pbufs_freed + clen);
-      pbuf_free(p);
-    }
+  p = ip_reass_tree_first(&ipr->p);
+  if ((p != NULL) && (IP_REASS_NODE(p)->start == 0)) {
+    /* The first fragment was received, send ICMP time exceeded. */
+    /* First, de-queue the first pbuf from r->p (it has no left subtree). */
+    ipr->p = IP_REASS_NODE(p)->right;
+    /* Then, copy the original header into it. */
+    SMEMCPY(p->payload, &ipr->iphdr, IP_HLEN);
+    icmp_time_exceeded(p, ICMP_TE_FRAG);
+    clen = pbuf_clen(p);
+    LWIP_ASSERT("pbufs_freed + clen <= 0xffff", pbufs_freed + clen <= 0xffff);
+    pbufs_freed = (u16_t)(pbufs_freed + clen);
+    pbuf_free(p);
   }
 #endif /* LWIP_ICMP */
 
   /* First, free all received pbufs.  The individual pbufs need to be released
      separately as they have not yet been chained */
-  p = ipr->p;
+  p = ip_reass_tree_to_list(&ipr->p);
   while (p != NULL) {
     struct pbuf *pcur;
-    iprh = (struct ip_reass_helper *)p->payload;
     pcur = p;
     /* get the next pointer before freeing */
-    p = iprh->next_pbuf;
+    p = IP_REASS_NODE(p)->right;
     clen = pbuf_clen(pcur);
     LWIP_ASSERT("pbufs_freed + clen <= 0xffff", pbufs_freed + clen <= 0xffff);
     pbufs_freed = (u16_t)(pbufs_freed + clen);
     pbuf_free(pcur);
   }
   /* Then, unchain the struct ip_reassdata from the list and free it. */
-  ip_reass_dequeue_datagram(ipr, prev);
+  ip_reass_dequeue_datagram(ipr);
   LWIP_ASSERT("ip_reass_pbufcount >= pbufs_freed", ip_reass_pbufcount >= pbufs_freed);
   ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount - pbufs_freed);
 
@@ -228,41 +208,32 @@ ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_reassdata *p
 static int
 ip_reass_remove_oldest_datagram(struct ip_hdr *fraghdr, int pbufs_needed)
 {
-  /* @todo Can't we simply remove the last datagram in the
-   *       linked list behind reassdatagrams?
-   */
-  struct ip_reassdata *r, *oldest, *prev, *oldest_prev;
+  struct ip_reassdata *r, *oldest;
   int pbufs_freed = 0, pbufs_freed_current;
   int other_datagrams;
+  u16_t i;
 
   /* Free datagrams until being allowed to enqueue 'pbufs_needed' pbufs,
    * but don't free the datagram that 'fraghdr' belongs to! */
   do {
     oldest = NULL;
-    prev = NULL;
-    oldest_prev = NULL;
     other_datagrams = 0;
-    r = reassdatagrams;
-    while (r != NULL) {
-      if (!IP_ADDRESSES_AND_ID_MATCH(&r->iphdr, fraghdr)) {
-        /* Not the same datagram as fraghdr */
-        other_datagrams++;
-        if (oldest == NULL) {
-          oldest = r;
-          oldest_prev = prev;
-        } else if (r->timer <= oldest->timer) {
-          /* older than the previous oldest */
-          oldest = r;
-          oldest_prev = prev;
+    for (i = 0; i < IP_REASS_HASH_SIZE; i++) {
+      for (r = reassdatagrams[i]; r != NULL; r = r->next) {
+        if (!IP_ADDRESSES_AND_ID_MATCH(&r->iphdr, fraghdr)) {
+          /* Not the same datagram as fraghdr */
+          other_datagrams++;
+          if (oldest == NULL) {
+            oldest = r;
+          } else if (r->timer <= oldest->timer) {
+            /* older than the previous oldest */
+            oldest = r;
+          }
         }
       }
-      if (r->next != NULL) {
-        prev = r;
-      }
-      r = r->next;
     }
     if (oldest != NULL) {
-      pbufs_freed_current = ip_reass_free_complete_datagram(oldest, oldest_prev);
+      pbufs_freed_current = ip_reass_free_complete_datagram(oldest);
       pbufs_freed += pbufs_freed_current;
     }
   } while ((pbufs_freed < pbufs_needed) && (other_datagrams > 1));
@@ -280,6 +251,7 @@ static struct ip_reassdata *
 ip_reass_enqueue_new_datagram(struct ip_hdr *fraghdr, int clen)
 {
   struct ip_reassdata *ipr;
+  u16_t bucket;
 #if ! IP_REASS_FREE_OLDEST
   LWIP_UNUSED_ARG(clen);
 #endif
@@ -302,9 +274,10 @@ ip_reass_enqueue_new_datagram(struct ip_hdr *fraghdr, int clen)
   memset(ipr, 0, sizeof(struct ip_reassdata));
   ipr->timer = IP_REASS_MAXAGE;
 
-  /* enqueue the new structure to the front of the list */
-  ipr->next = reassdatagrams;
-  reassdatagrams = ipr;
+  /* enqueue the new structure to the front of its list */
+  bucket = IP_REASS_BUCKET(fraghdr);
+  ipr->next = reassdatagrams[bucket];
+  reassdatagrams[bucket] = ipr;
   /* copy the ip header for later tests and input */
   /* @todo: no ip options supported? */
   SMEMCPY(&(ipr->iphdr), fraghdr, IP_HLEN);
@@ -316,27 +289,24 @@ ip_reass_enqueue_new_datagram(struct ip_hdr *fraghdr, int clen)
  * @param ipr points to the queue entry to dequeue
  */
 static void
-ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev)
+ip_reass_dequeue_datagram(struct ip_reassdata *ipr)
 {
+  struct ip_reassdata **link;
+
   /* dequeue the reass struct  */
-  if (reassdatagrams == ipr) {
-    /* it was the first in the list */
-    reassdatagrams = ipr->next;
-  } else {
-    /* it wasn't the first, so it must have a valid 'prev' */
-    LWIP_ASSERT("sanity check linked list", prev != NULL);
-    prev->next = ipr->next;
+  for (link = &reassdatagrams[IP_REASS_BUCKET(&ipr->iphdr)]; *link != ipr; link = &(*link)->next) {
+    LWIP_ASSERT("sanity check linked list", *link != NULL);
   }
+  *link = ipr->next;
 
   /* now we can free the ip_reassdata struct */
   memp_free(MEMP_REASSDATA, ipr);
 }
 
 /**
- * Chain a new pbuf into the pbuf list that composes the datagram.  The pbuf list
- * will grow over time as  new pbufs are rx.
- * Also checks that the datagram passes basic continuity checks (if the last
- * fragment was received at least once).
+ * Insert a new pbuf into the fragment tree of the datagram.
+ * Also checks whether the datagram is complete (if the last fragment was
+ * received at least once).
  * @param ipr points to the reassembly state
  * @param new_p points to the pbuf for the current fragment
  * @param is_last is 1 if this pbuf has MF==0 (ipr->flags not updated yet)
@@ -345,12 +315,9 @@ ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev)
 static int
 ip_reass_chain_frag_into_datagram_and_validate(struct ip_reassdata *ipr, struct pbuf *new_p, int is_last)
 {
-  struct ip_reass_helper *iprh, *iprh_tmp, *iprh_prev = NULL;
-  struct pbuf *q;
-  u16_t offset, len;
+  u16_t offset, len, end, datagram_len;
   u8_t hlen;
   struct ip_hdr *fraghdr;
-  int valid = 1;
 
   /* Extract length and fragment offset from current fragment */
   fraghdr = (struct ip_hdr *)new_p->payload;
@@ -362,137 +329,64 @@ ip_reass_chain_frag_into_datagram_and_validate(struct ip_reassdata *ipr, struct
   }
   len = (u16_t)(len - hlen);
   offset = IPH_OFFSET_BYTES(fraghdr);
-
-  /* overwrite the fragment's ip header from the pbuf with our helper struct,
-   * and setup the embedded helper structure. */
-  /* make sure the struct ip_reass_helper fits into the IP header */
-  LWIP_ASSERT("sizeof(struct ip_reass_helper) <= IP_HLEN",
-              sizeof(struct ip_reass_helper) <= IP_HLEN);
-  iprh = (struct ip_reass_helper *)new_p->payload;
-  iprh->next_pbuf = NULL;
-  iprh->start = offset;
-  iprh->end = (u16_t)(offset + len);
-  if (iprh->end < offset) {
+  end = (u16_t)(offset + len);
+  if (end < offset) {
     /* u16_t overflow, cannot handle this */
     return IP_REASS_VALIDATE_PBUF_DROPPED;
   }
 
-  /* Iterate through until we either get to the end of the list (append),
-   * or we find one with a larger offset (insert). */
-  for (q = ipr->p; q != NULL;) {
-    iprh_tmp = (struct ip_reass_helper *)q->payload;
-    if (iprh->start < iprh_tmp->start) {
-      /* the new pbuf should be inserted before this */
-      iprh->next_pbuf = q;
-      if (iprh_prev != NULL) {
-        /* not the fragment with the lowest offset */
-#if IP_REASS_CHECK_OVERLAP
-        if ((iprh->start < iprh_prev->end) || (iprh->end > iprh_tmp->start)) {
-          /* fragment overlaps with previous or following, throw away */
-          return IP_REASS_VALIDATE_PBUF_DROPPED;
-        }
-#endif /* IP_REASS_CHECK_OVERLAP */
-        iprh_prev->next_pbuf = new_p;
-        if (iprh_prev->end != iprh->start) {
-          /* There is a fragment missing between the current
-           * and the previous fragment */
-          valid = 0;
-        }
-      } else {
-#if IP_REASS_CHECK_OVERLAP
-        if (iprh->end > iprh_tmp->start) {
-          /* fragment overlaps with following, throw away */
-          return IP_REASS_VALIDATE_PBUF_DROPPED;
-        }
-#endif /* IP_REASS_CHECK_OVERLAP */
-        /* fragment with the lowest offset */
-        ipr->p = new_p;
-      }
-      break;
-    } else if (iprh->start == iprh_tmp->start) {
-      /* received the same datagram twice: no need to keep the datagram */
+  if (is_last) {
+    if (((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0) && (end != ipr->datagram_len)) {
+      /* another last fragment with a different length, throw away */
       return IP_REASS_VALIDATE_PBUF_DROPPED;
+    }
 #if IP_REASS_CHECK_OVERLAP
-    } else if (iprh->start < iprh_tmp->end) {
-      /* overlap: no need to keep the new datagram */
+    if (ip_reass_tree_last_end(ipr->p) > end) {
+      /* data received beyond the end of the datagram, throw away */
       return IP_REASS_VALIDATE_PBUF_DROPPED;
-#endif /* IP_REASS_CHECK_OVERLAP */
-    } else {
-      /* Check if the fragments received so far have no holes. */
-      if (iprh_prev != NULL) {
-        if (iprh_prev->end != iprh_tmp->start) {
-          /* There is a fragment missing between the current
-           * and the previous fragment */
-          valid = 0;
-        }
-      }
     }
-    q = iprh_tmp->next_pbuf;
-    iprh_prev = iprh_tmp;
-  }
-
-  /* If q is NULL, then we made it to the end of the list. Determine what to do now */
-  if (q == NULL) {
-    if (iprh_prev != NULL) {
-      /* this is (for now), the fragment with the highest offset:
-       * chain it to the last fragment */
-#if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("check fragments don't overlap", iprh_prev->end <= iprh->start);
 #endif /* IP_REASS_CHECK_OVERLAP */
-      iprh_prev->next_pbuf = new_p;
-      if (iprh_prev->end != iprh->start) {
-        valid = 0;
-      }
-    } else {
+    datagram_len = end;
+  } else if ((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0) {
 #if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("no previous fragment, this must be the first fragment!",
-                  ipr->p == NULL);
-#endif /* IP_REASS_CHECK_OVERLAP */
-      /* this is the first fragment we ever received for this ip datagram */
-      ipr->p = new_p;
+    if (end > ipr->datagram_len) {
+      /* fragment beyond the end of the datagram, throw away */
+      return IP_REASS_VALIDATE_PBUF_DROPPED;
     }
+#endif /* IP_REASS_CHECK_OVERLAP */
+    datagram_len = ipr->datagram_len;
+  } else {
+    datagram_len = 0;
   }
 
+  /* find the right place to insert this pbuf: duplicate (and, with
+   * IP_REASS_CHECK_OVERLAP, overlapping) fragments are thrown away */
+  if (!ip_reass_tree_check(&ipr->p, offset, end, IP_REASS_CHECK_OVERLAP)) {
+    return IP_REASS_VALIDATE_PBUF_DROPPED;
+  }
+  /* overwrite the fragment's ip header from the pbuf with the tree node */
+  /* make sure the struct ip_reass_node fits into the IP header */
+  LWIP_ASSERT("sizeof(struct ip_reass_node) <= IP_HLEN",
+              sizeof(struct ip_reass_node) <= IP_HLEN);
+  ip_reass_tree_link(&ipr->p, new_p, offset, end);
+  ipr->received += len;
+
   /* At this point, the validation part begins: */
-  /* If we already received the last fragment */
-  if (is_last || ((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0)) {
-    /* and had no holes so far */
-    if (valid) {
-      /* then check if the rest of the fragments is here */
-      /* Check if the queue starts with the first datagram */
-      if ((ipr->p == NULL) || (((struct ip_reass_helper *)ipr->p->payload)->start != 0)) {
-        valid = 0;
-      } else {
-        /* and check that there are no holes after this datagram */
-        iprh_prev = iprh;
-        q = iprh->next_pbuf;
-        while (q != NULL) {
-          iprh = (struct ip_reass_helper *)q->payload;
-          if (iprh_prev->end != iprh->start) {
-            valid = 0;
-            break;
-          }
-          iprh_prev = iprh;
-          q = iprh->next_pbuf;
-        }
-        /* if still valid, all fragments are received
-         * (because to the MF==0 already arrived */
-        if (valid) {
-          LWIP_ASSERT("sanity check", ipr->p != NULL);
-          LWIP_ASSERT("sanity check",
-                      ((struct ip_reass_helper *)ipr->p->payload) != iprh);
-          LWIP_ASSERT("validate_datagram:next_pbuf!=NULL",
-                      iprh->next_pbuf == NULL);
-        }
-      }
-    }
-    /* If valid is 0 here, there are some fragments missing in the middle
-     * (since MF == 0 has already arrived). Such datagrams simply time out if
-     * no more fragments are received... */
-    return valid ? IP_REASS_VALIDATE_TELEGRAM_FINISHED : IP_REASS_VALIDATE_PBUF_QUEUED;
+  if (datagram_len == 0) {
+    /* the last fragment was not received yet */
+    return IP_REASS_VALIDATE_PBUF_QUEUED;
   }
-  /* If we come here, not all fragments were received, yet! */
-  return IP_REASS_VALIDATE_PBUF_QUEUED; /* not yet valid! */
+#if IP_REASS_CHECK_OVERLAP
+  /* fragments neither overlap nor exceed the datagram: the datagram is
+   * complete if as many bytes as it is long have been received */
+  return (ipr->received == datagram_len) ? IP_REASS_VALIDATE_TELEGRAM_FINISHED : IP_REASS_VALIDATE_PBUF_QUEUED;
+#else /* IP_REASS_CHECK_OVERLAP */
+  if (ipr->received < datagram_len) {
+    return IP_REASS_VALIDATE_PBUF_QUEUED;
+  }
+  /* there might be holes since fragments may overlap: check the list */
+  return ip_reass_tree_complete(&ipr->p, datagram_len) ? IP_REASS_VALIDATE_TELEGRAM_FINISHED : IP_REASS_VALIDATE_PBUF_QUEUED;
+#endif /* IP_REASS_CHECK_OVERLAP */
 }
 
 /**
@@ -506,9 +400,8 @@ ip4_reass(struct pbuf *p)
 {
   struct pbuf *r;
   struct ip_hdr *fraghdr;
-  struct ip_reassdata *ipr;
-  struct ip_reass_helper *iprh;
-  u16_t offset, len, clen;
+  struct ip_reassdata *ipr, *iprs;
+  u16_t offset, len, clen, src_pbufs;
   u8_t hlen;
   int valid;
   int is_last;
@@ -533,8 +426,36 @@ ip4_reass(struct pbuf *p)
   }
   len = (u16_t)(len - hlen);
 
-  /* Check if we are allowed to enqueue more datagrams. */
+  /* Look for the datagram the fragment belongs to in the list of its source,
+   * counting the pbufs enqueued for that source. */
+  ipr = NULL;
+  src_pbufs = 0;
+  for (iprs = reassdatagrams[IP_REASS_BUCKET(fraghdr)]; iprs != NULL; iprs = iprs->next) {
+    if (ip4_addr_eq(&iprs->iphdr.src, &fraghdr->src)) {
+      src_pbufs = (u16_t)(src_pbufs + iprs->pbufs);
+      /* Check if the incoming fragment matches the one currently present
+         in the reassembly buffer. If so, we proceed with copying the
+         fragment into the buffer. */
+      if ((ipr == NULL) && IP_ADDRESSES_AND_ID_MATCH(&iprs->iphdr, fraghdr)) {
+        LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: matching previous fragment ID=%"X16_F"\n",
+                                     lwip_ntohs(IPH_ID(fraghdr))));
+        IPFRAG_STATS_INC(ip_frag.cachehit);
+        ipr = iprs;
+      }
+    }
+  }
+
+  /* Check if this source is allowed to enqueue more pbufs: don't free other
+   * datagrams for a source exceeding its share. */
   clen = pbuf_clen(p);
+  if ((src_pbufs + clen) > IP_REASS_MAX_PBUFS_PER_SOURCE) {
+    LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: Per source limit exceeded: pbufct=%d, clen=%d\n",
+                                 src_pbufs, clen));
+    IPFRAG_STATS_INC(ip_frag.memerr);
+    goto nullreturn;
+  }
+
+  /* Check if we are allowed to enqueue more datagrams. */
   if ((ip_reass_pbufcount + clen) > IP_REASS_MAX_PBUFS) {
 #if IP_REASS_FREE_OLDEST
     if (!ip_reass_remove_oldest_datagram(fraghdr, clen) ||
@@ -551,20 +472,6 @@ ip4_reass(struct pbuf *p)
     }
   }
 
-  /* Look for the datagram the fragment belongs to in the current datagram queue,
-   * remembering the previous in the queue for later dequeueing. */
-  for (ipr = reassdatagrams; ipr != NULL; ipr = ipr->next) {
-    /* Check if the incoming fragment matches the one currently present
-       in the reassembly buffer. If so, we proceed with copying the
-       fragment into the buffer. */
-    if (IP_ADDRESSES_AND_ID_MATCH(&ipr->iphdr, fraghdr)) {
-      LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: matching previous fragment ID=%"X16_F"\n",
-                                   lwip_ntohs(IPH_ID(fraghdr))));
-      IPFRAG_STATS_INC(ip_frag.cachehit);
-      break;
-    }
-  }
-
   if (ipr == NULL) {
     /* Enqueue a new datagram into the datagram queue */
     ipr = ip_reass_enqueue_new_datagram(fraghdr, clen);
@@ -607,6 +514,7 @@ ip4_reass(struct pbuf *p)
      the number of fragments that may be enqueued at any one time
      (overflow checked by testing against IP_REASS_MAX_PBUFS) */
   ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount + clen);
+  ipr->pbufs = (u16_t)(ipr->pbufs + clen);
   if (is_last) {
     u16_t datagram_len = (u16_t)(offset + len);
     ipr->datagram_len = datagram_len;
@@ -617,16 +525,17 @@ ip4_reass(struct pbuf *p)
   }
 
   if (valid == IP_REASS_VALIDATE_TELEGRAM_FINISHED) {
-    struct ip_reassdata *ipr_prev;
     /* the totally last fragment (flag more fragments = 0) was received at least
      * once AND all fragments are received */
     u16_t datagram_len = (u16_t)(ipr->datagram_len + IP_HLEN);
 
-    /* save the second pbuf before copying the header over the pointer */
-    r = ((struct ip_reass_helper *)ipr->p->payload)->next_pbuf;
+    /* sort the fragments and save the second pbuf before copying the header
+     * over the tree node */
+    p = ip_reass_tree_to_list(&ipr->p);
+    r = IP_REASS_NODE(p)->right;
 
     /* copy the original ip header back to the first pbuf */
-    fraghdr = (struct ip_hdr *)(ipr->p->payload);
+    fraghdr = (struct ip_hdr *)(p->payload);
     SMEMCPY(fraghdr, &ipr->iphdr, IP_HLEN);
     IPH_LEN_SET(fraghdr, lwip_htons(datagram_len));
     IPH_OFFSET_SET(fraghdr, 0);
@@ -638,31 +547,18 @@ ip4_reass(struct pbuf *p)
     }
 #endif /* CHECKSUM_GEN_IP */
 
-    p = ipr->p;
-
     /* chain together the pbufs contained within the reass_data list. */
     while (r != NULL) {
-      iprh = (struct ip_reass_helper *)r->payload;
+      struct pbuf *next = IP_REASS_NODE(r)->right;
 
       /* hide the ip header for every succeeding fragment */
       pbuf_remove_header(r, IP_HLEN);
       pbuf_cat(p, r);
-      r = iprh->next_pbuf;
-    }
-
-    /* find the previous entry in the linked list */
-    if (ipr == reassdatagrams) {
-      ipr_prev = NULL;
-    } else {
-      for (ipr_prev = reassdatagrams; ipr_prev != NULL; ipr_prev = ipr_prev->next) {
-        if (ipr_prev->next == ipr) {
-          break;
-        }
-      }
+      r = next;
     }
 
     /* release the sources allocate for the fragment queue entry */
-    ip_reass_dequeue_datagram(ipr, ipr_prev);
+    ip_reass_dequeue_datagram(ipr);
 
     /* and adjust the number of pbufs currently queued for reassembly. */
     clen = pbuf_clen(p);
@@ -682,8 +578,7 @@ nullreturn_ipr:
   LWIP_ASSERT("ipr != NULL", ipr != NULL);
   if (ipr->p == NULL) {
     /* dropped pbuf after creating a new datagram entry: remove the entry, too */
-    LWIP_ASSERT("not firstalthough just enqueued", ipr == reassdatagrams);
-    ip_reass_dequeue_datagram(ipr, NULL);
+    ip_reass_dequeue_datagram(ipr);
   }
 
 nullreturn:
@@ -749,7 +644,12 @@ ip4_frag(struct pbuf *p, struct netif *netif, const ip4_addr_t *dest)
 #endif
   struct ip_hdr *original_iphdr;
   struct ip_hdr *iphdr;
-  const u16_t nfb = (u16_t)((netif->mtu - IP_HLEN) / 8);
+#if LWIP_IPV4_PMTU
+  const u16_t mtu = ip4_pmtu_get(dest, netif);
+#else /* LWIP_IPV4_PMTU */
+  const u16_t mtu = netif->mtu;
+#endif /* LWIP_IPV4_PMTU */
+  const u16_t nfb = (u16_t)((mtu - IP_HLEN) / 8);
   u16_t left, fragsize;
   u16_t ofo;
   int last;
@@ -765,6 +665,17 @@ ip4_frag(struct pbuf *p, struct netif *netif, const ip4_addr_t *dest)
   }
   LWIP_ERROR("ip4_frag(): pbuf too short", p->len >= IP_HLEN, return ERR_VAL);
 
+#if LWIP_NETIF_FRAG_OFFLOAD
+  if (NETIF_FRAG_OFFLOAD_ENABLED(netif, NETIF_FRAG_OFFLOAD_IP4)) {
+    /* the netif splits the packet, the IP header is the template for all
+       fragments (see ip_frag_offload_hdr()) */
+    p->frag_size = (u16_t)(nfb * 8);
+    IPFRAG_STATS_INC(ip_frag.xmit);
+    MIB2_STATS_INC(mib2.ipfragoks);
+    return netif->output(netif, p, dest);
+  }
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
+
   /* Save original offset */
   tmp = lwip_ntohs(IPH_OFFSET(iphdr));
   ofo = tmp & IP_OFFMASK;
@@ -851,7 +762,7 @@ ip4_frag(struct pbuf *p, struct netif *netif, const ip4_addr_t *dest)
 #endif /* LWIP_NETIF_TX_SINGLE_PBUF */
 
     /* Correct header */
-    last = (left <= netif->mtu - IP_HLEN);
+    last = (left <= mtu - IP_HLEN);
 
     /* Set new offset and MF flag */
     tmp = (IP_OFFMASK & (ofo));
@@ -0,0 +1,305 @@
+/**
+ * @file
+ * IPv4 multicast forwarding (multicast route cache)
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+/**
+ * @defgroup ip4_mroute IPv4 multicast forwarding
+ * @ingroup ip4
+ *
+ * Multicast routes forward packets to a group between netifs, e.g. on a
+ * bridge or router passing IPTV streams from an uplink to local segments.
+ * A route is either for one source and group (S,G) or for a group from any
+ * source (*,G), the (S,G) route taking precedence. Packets are only
+ * forwarded if they arrive on the input netif of their route (reverse path
+ * check). They are copied to every other output netif of the route with the
+ * TTL decremented, in addition to being received locally if the group is
+ * joined. Link-local groups (224.0.0.0/24) and packets with a TTL of 1 are
+ * never forwarded, and no ICMP errors are sent for multicast packets.
+ *
+ * Routes are kept in a table of IP4_MROUTE_CACHE_SIZE entries hashed by
+ * group address, so the (S,G) and the (*,G) route of a packet are found in
+ * the same bucket.
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_IPV4 && LWIP_IPV4_MROUTE /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/ip4_mroute.h"
+#include "lwip/ip4.h"
+#include "lwip/ip4_frag.h"
+#include "lwip/def.h"
+#include "lwip/stats.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/priv/hash_priv.h"
+
+#if (IP4_MROUTE_CACHE_SIZE < 1) || ((IP4_MROUTE_CACHE_SIZE & (IP4_MROUTE_CACHE_SIZE - 1)) != 0)
+#error "IP4_MROUTE_CACHE_SIZE must be a power of 2"
+#endif
+
+struct ip4_mroute_entry {
+  /** next route in the same bucket */
+  struct ip4_mroute_entry *next;
+  /** source address, IP4_ADDR_ANY for a (*,G) route */
+  ip4_addr_t source;
+  /** group address, IP4_ADDR_ANY if the entry is unused */
+  ip4_addr_t group;
+  /** output netifs, see IP4_MROUTE_OIF() */
+  u32_t oifs;
+  /** index of the input netif */
+  u8_t iif;
+};
+
+static struct ip4_mroute_entry ip4_mroute_table[IP4_MROUTE_CACHE_SIZE];
+static struct ip4_mroute_entry *ip4_mroute_hash[IP4_MROUTE_CACHE_SIZE];
+
+/** Bucket of a group */
+static u16_t
+ip4_mroute_hash_idx(const ip4_addr_t *group)
+{
+  u32_t h = ip4_addr_get_u32(group);
+  return LWIP_HASH_BUCKET(h, IP4_MROUTE_CACHE_SIZE);
+}
+
+/** Find the link pointing to the route for (source, group) */
+static struct ip4_mroute_entry **
+ip4_mroute_find(const ip4_addr_t *source, const ip4_addr_t *group)
+{
+  struct ip4_mroute_entry **link;
+
+  for (link = &ip4_mroute_hash[ip4_mroute_hash_idx(group)]; *link != NULL; link = &(*link)->next) {
+    if (ip4_addr_eq(&(*link)->group, group) && ip4_addr_eq(&(*link)->source, source)) {
+      return link;
+    }
+  }
+  return NULL;
+}
+
+static void
+ip4_mroute_unlink(struct ip4_mroute_entry **link)
+{
+  struct ip4_mroute_entry *entry = *link;
+
+  *link = entry->next;
+  ip4_addr_set_any(&entry->group);
+  entry->next = NULL;
+}
+
+/**
+ * @ingroup ip4_mroute
+ * Add a multicast route or change an existing one.
+ *
+ * @param source the source address or NULL/IP4_ADDR_ANY for a (*,G) route
+ * @param group the multicast group (224.0.0.0/24 is never forwarded)
+ * @param iif the netif packets must arrive on to be forwarded
+ * @param oifs the netifs to forward to: IP4_MROUTE_OIF() of each, or'ed
+ * @return ERR_OK on success, ERR_MEM if the table is full, ERR_ARG on
+ *         invalid arguments
+ */
+err_t
+ip4_mroute_add(const ip4_addr_t *source, const ip4_addr_t *group, struct netif *iif, u32_t oifs)
+{
+  struct ip4_mroute_entry **link;
+  struct ip4_mroute_entry *entry;
+  u16_t i, idx;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("ip4_mroute_add: invalid group", (group != NULL) && ip4_addr_ismulticast(group), return ERR_ARG;);
+  LWIP_ERROR("ip4_mroute_add: invalid iif", (iif != NULL) && (netif_get_index(iif) <= IP4_MROUTE_MAX_NETIF_INDEX),
+             return ERR_ARG;);
+  if (source == NULL) {
+    source = IP4_ADDR_ANY4;
+  }
+  LWIP_ERROR("ip4_mroute_add: invalid source", !ip4_addr_ismulticast(source), return ERR_ARG;);
+
+  link = ip4_mroute_find(source, group);
+  if (link != NULL) {
+    entry = *link;
+  } else {
+    entry = NULL;
+    for (i = 0; i < IP4_MROUTE_CACHE_SIZE; i++) {
+      if (ip4_addr_isany_val(ip4_mroute_table[i].group)) {
+        entry = &ip4_mroute_table[i];
+        break;
+      }
+    }
+    if (entry == NULL) {
+      LWIP_DEBUGF(IP_DEBUG, ("ip4_mroute_add: table full\n"));
+      return ERR_MEM;
+    }
+    ip4_addr_copy(entry->source, *source);
+    ip4_addr_copy(entry->group, *group);
+    idx = ip4_mroute_hash_idx(group);
+    entry->next = ip4_mroute_hash[idx];
+    ip4_mroute_hash[idx] = entry;
+  }
+  entry->iif = netif_get_index(iif);
+  entry->oifs = oifs;
+  return ERR_OK;
+}
+
+/**
+ * @ingroup ip4_mroute
+ * Remove a multicast route.
+ *
+ * @param source the source address or NULL/IP4_ADDR_ANY for a (*,G) route
+ * @param group the multicast group
+ * @return ERR_OK if the route was removed, ERR_VAL if it was not found
+ */
+err_t
+ip4_mroute_remove(const ip4_addr_t *source, const ip4_addr_t *group)
+{
+  struct ip4_mroute_entry **link;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("ip4_mroute_remove: invalid group", group != NULL, return ERR_ARG;);
+  if (source == NULL) {
+    source = IP4_ADDR_ANY4;
+  }
+  link = ip4_mroute_find(source, group);
+  if (link == NULL) {
+    return ERR_VAL;
+  }
+  ip4_mroute_unlink(link);
+  return ERR_OK;
+}
+
+/**
+ * Remove a netif from all multicast routes, called by netif_remove().
+ * Routes with the netif as input netif are removed.
+ *
+ * @param netif the netif being removed
+ */
+void
+ip4_mroute_cleanup_netif(const struct netif *netif)
+{
+  u16_t i;
+  u8_t idx = netif_get_index(netif);
+
+  for (i = 0; i < IP4_MROUTE_CACHE_SIZE; i++) {
+    struct ip4_mroute_entry *entry = &ip4_mroute_table[i];
+    if (ip4_addr_isany_val(entry->group)) {
+      continue;
+    }
+    if (entry->iif == idx) {
+      ip4_mroute_unlink(ip4_mroute_find(&entry->source, &entry->group));
+    } else if (idx <= IP4_MROUTE_MAX_NETIF_INDEX) {
+      entry->oifs &= ~IP4_MROUTE_OIF(netif);
+    }
+  }
+}
+
+/**
+ * Forward copies of a received multicast packet according to its route.
+ * Called by ip4_input() before the packet is received locally, the packet
+ * itself is not changed.
+ *
+ * @param p the received packet (p->payload points to the IP header)
+ * @param inp the netif on which the packet was received
+ */
+void
+ip4_mroute_forward(struct pbuf *p, struct netif *inp)
+{
+  const struct ip_hdr *iphdr = (const struct ip_hdr *)p->payload;
+  const ip4_addr_t *group = ip4_current_dest_addr();
+  const struct ip4_mroute_entry *entry;
+  const struct ip4_mroute_entry *route = NULL;
+  struct netif *netif;
+
+  if ((IPH_TTL(iphdr) <= 1) ||
+      ((lwip_ntohl(ip4_addr_get_u32(group)) & 0xffffff00UL) == 0xe0000000UL)) {
+    /* expiring or link-local (224.0.0.0/24) */
+    return;
+  }
+  for (entry = ip4_mroute_hash[ip4_mroute_hash_idx(group)]; entry != NULL; entry = entry->next) {
+    if (ip4_addr_eq(&entry->group, group)) {
+      if (ip4_addr_eq(&entry->source, ip4_current_src_addr())) {
+        route = entry;
+        break;
+      }
+      if (ip4_addr_isany_val(entry->source)) {
+        /* (*,G), keep looking for (S,G) */
+        route = entry;
+      }
+    }
+  }
+  if (route == NULL) {
+    return;
+  }
+  if (route->iif != netif_get_index(inp)) {
+    LWIP_DEBUGF(IP_DEBUG, ("ip4_mroute_forward: packet not received on the input netif of its route\n"));
+    return;
+  }
+
+  NETIF_FOREACH(netif) {
+    struct pbuf *q;
+    struct ip_hdr *qhdr;
+
+    if ((netif == inp) || (netif_get_index(netif) > IP4_MROUTE_MAX_NETIF_INDEX) ||
+        !(route->oifs & IP4_MROUTE_OIF(netif)) || !netif_is_up(netif) || !netif_is_link_up(netif)) {
+      continue;
+    }
+    q = pbuf_clone(PBUF_LINK, PBUF_RAM, p);
+    if (q == NULL) {
+      IP_STATS_INC(ip.memerr);
+      continue;
+    }
+    qhdr = (struct ip_hdr *)q->payload;
+    /* decrement TTL and incrementally update the IP checksum */
+    IPH_TTL_SET(qhdr, IPH_TTL(qhdr) - 1);
+    if (IPH_CHKSUM(qhdr) >= PP_HTONS(0xffffU - 0x100)) {
+      IPH_CHKSUM_SET(qhdr, (u16_t)(IPH_CHKSUM(qhdr) + PP_HTONS(0x100) + 1));
+    } else {
+      IPH_CHKSUM_SET(qhdr, (u16_t)(IPH_CHKSUM(qhdr) + PP_HTONS(0x100)));
+    }
+
+    IP_STATS_INC(ip.fw);
+    MIB2_STATS_INC(mib2.ipforwdatagrams);
+    IP_STATS_INC(ip.xmit);
+    if (netif->mtu && (q->tot_len > netif->mtu)) {
+#if IP_FRAG
+      if ((IPH_OFFSET(qhdr) & PP_HTONS(IP_DF)) == 0) {
+        ip4_frag(q, netif, group);
+      }
+#endif /* IP_FRAG */
+    } else {
+      netif->output(netif, q, group);
+    }
+    pbuf_free(q);
+  }
+}
+
+#endif /* LWIP_IPV4 && LWIP_IPV4_MROUTE */
@@ -0,0 +1,233 @@
+/**
+ * @file
+ * IPv4 path MTU cache (RFC 1191)
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+/**
+ * @defgroup ip4_pmtu IPv4 path MTU cache
+ * @ingroup ip4
+ *
+ * Path MTU discovery for IPv4 (RFC 1191). TCP segments are sent with the DF
+ * flag. When a router cannot forward one of them, it answers with an ICMP
+ * "fragmentation needed" message carrying the MTU of its next hop. This MTU
+ * is stored here per destination if the message quotes a segment of a TCP
+ * connection with data in flight, which then reduces its MSS (see
+ * tcp_pmtu_update()). Other connections to the destination reduce their MSS
+ * before they send the next segment (see tcp_pmtu_check()). ip4_output_if()
+ * rejects other packets with DF set that exceed the PMTU with ERR_MTU.
+ * Packets without DF are fragmented to the PMTU.
+ *
+ * Only destinations with a PMTU below the MTU of their netif are stored.
+ * An entry is forgotten after IP4_PMTU_TIMEOUT seconds so that a larger PMTU
+ * (e.g. after a route change) is used again. TCP connections then find it
+ * with TCP_PLPMTUD.
+ *
+ * The cache is small and searched linearly. ip4_pmtu_lowest lets the output
+ * path skip the search for all packets that fit the smallest PMTU.
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_IPV4 && LWIP_IPV4_PMTU /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/ip4_pmtu.h"
+#include "lwip/debug.h"
+
+#if IP4_PMTU_CACHE_SIZE < 1
+#error "IP4_PMTU_CACHE_SIZE must be at least 1"
+#endif
+#if IP4_PMTU_MIN < 68
+#error "IP4_PMTU_MIN must be at least 68 (RFC 791)"
+#endif
+
+struct ip4_pmtu_entry {
+  ip4_addr_t dest;
+  u16_t pmtu;
+  /** seconds until the entry expires, 0 if the entry is unused */
+  u16_t timer;
+};
+
+static struct ip4_pmtu_entry ip4_pmtu_cache[IP4_PMTU_CACHE_SIZE];
+
+u16_t ip4_pmtu_lowest = 0xffff;
+
+/** MTU plateaus of RFC 1191 section 7 (RFC 791's 68 is replaced by IP4_PMTU_MIN) */
+static const u16_t ip4_pmtu_plateaus[] = {
+  32000, 17914, 8166, 4352, 2002, 1492, 1006, 508, 296
+};
+
+static struct ip4_pmtu_entry *
+ip4_pmtu_find(const ip4_addr_t *dest)
+{
+  int i;
+
+  for (i = 0; i < IP4_PMTU_CACHE_SIZE; i++) {
+    if ((ip4_pmtu_cache[i].timer != 0) && ip4_addr_eq(&ip4_pmtu_cache[i].dest, dest)) {
+      return &ip4_pmtu_cache[i];
+    }
+  }
+  return NULL;
+}
+
+static void
+ip4_pmtu_update_lowest(void)
+{
+  int i;
+
+  ip4_pmtu_lowest = 0xffff;
+  for (i = 0; i < IP4_PMTU_CACHE_SIZE; i++) {
+    if ((ip4_pmtu_cache[i].timer != 0) && (ip4_pmtu_cache[i].pmtu < ip4_pmtu_lowest)) {
+      ip4_pmtu_lowest = ip4_pmtu_cache[i].pmtu;
+    }
+  }
+}
+
+/**
+ * Expire old entries. Called every IP4_PMTU_TMR_INTERVAL milliseconds.
+ */
+void
+ip4_pmtu_tmr(void)
+{
+  int i;
+  u8_t expired = 0;
+
+  for (i = 0; i < IP4_PMTU_CACHE_SIZE; i++) {
+    if ((ip4_pmtu_cache[i].timer != 0) && (--ip4_pmtu_cache[i].timer == 0)) {
+      LWIP_DEBUGF(IP_DEBUG, ("ip4_pmtu_tmr: PMTU %"U16_F" to %"U16_F".%"U16_F".%"U16_F".%"U16_F" expired\n",
+                             ip4_pmtu_cache[i].pmtu,
+                             ip4_addr1_16(&ip4_pmtu_cache[i].dest), ip4_addr2_16(&ip4_pmtu_cache[i].dest),
+                             ip4_addr3_16(&ip4_pmtu_cache[i].dest), ip4_addr4_16(&ip4_pmtu_cache[i].dest)));
+      expired = 1;
+    }
+  }
+  if (expired) {
+    ip4_pmtu_update_lowest();
+  }
+}
+
+/**
+ * @ingroup ip4_pmtu
+ * Get the path MTU to a destination.
+ *
+ * @param dest the destination address
+ * @param netif the netif used to reach dest
+ * @return the cached PMTU if it is below the MTU of netif (or netif has no
+ *         MTU), else the MTU of netif
+ */
+u16_t
+ip4_pmtu_get(const ip4_addr_t *dest, const struct netif *netif)
+{
+  const struct ip4_pmtu_entry *entry;
+
+  LWIP_ASSERT("ip4_pmtu_get: invalid dest", dest != NULL);
+  LWIP_ASSERT("ip4_pmtu_get: invalid netif", netif != NULL);
+
+  if ((netif->mtu != 0) && (ip4_pmtu_lowest >= netif->mtu)) {
+    /* no cached PMTU is below this MTU */
+    return netif->mtu;
+  }
+  entry = ip4_pmtu_find(dest);
+  if ((entry != NULL) && ((netif->mtu == 0) || (entry->pmtu < netif->mtu))) {
+    return entry->pmtu;
+  }
+  return netif->mtu;
+}
+
+/**
+ * @ingroup ip4_pmtu
+ * Store a smaller path MTU to a destination, e.g. reported by an ICMP
+ * "fragmentation needed" message. The PMTU is never increased by this (an
+ * entry is only replaced by a larger PMTU when it expires) and is limited to
+ * IP4_PMTU_MIN. When the cache is full, the entry closest to expiry is
+ * replaced.
+ *
+ * @param dest the destination address
+ * @param mtu the new path MTU
+ * @return the PMTU to dest now in the cache
+ */
+u16_t
+ip4_pmtu_update(const ip4_addr_t *dest, u16_t mtu)
+{
+  struct ip4_pmtu_entry *entry;
+  int i;
+
+  LWIP_ASSERT("ip4_pmtu_update: invalid dest", dest != NULL);
+
+  if (mtu < IP4_PMTU_MIN) {
+    mtu = IP4_PMTU_MIN;
+  }
+  entry = ip4_pmtu_find(dest);
+  if (entry != NULL) {
+    if (entry->pmtu <= mtu) {
+      return entry->pmtu;
+    }
+  } else {
+    entry = &ip4_pmtu_cache[0];
+    for (i = 1; (i < IP4_PMTU_CACHE_SIZE) && (entry->timer != 0); i++) {
+      if (ip4_pmtu_cache[i].timer < entry->timer) {
+        entry = &ip4_pmtu_cache[i];
+      }
+    }
+    ip4_addr_copy(entry->dest, *dest);
+  }
+  LWIP_DEBUGF(IP_DEBUG, ("ip4_pmtu_update: PMTU to %"U16_F".%"U16_F".%"U16_F".%"U16_F" is %"U16_F"\n",
+                         ip4_addr1_16(dest), ip4_addr2_16(dest), ip4_addr3_16(dest), ip4_addr4_16(dest), mtu));
+  entry->pmtu = mtu;
+  entry->timer = IP4_PMTU_TIMEOUT;
+  ip4_pmtu_update_lowest();
+  return mtu;
+}
+
+/**
+ * @ingroup ip4_pmtu
+ * Estimate the next-hop MTU for an ICMP "fragmentation needed" message sent
+ * by a router that does not report it (RFC 1191 section 5): the largest
+ * plateau below the total length of the packet that was too big.
+ *
+ * @param tot_len total length of the packet that was too big
+ * @return the estimated path MTU
+ */
+u16_t
+ip4_pmtu_plateau(u16_t tot_len)
+{
+  size_t i;
+
+  for (i = 0; i < LWIP_ARRAYSIZE(ip4_pmtu_plateaus); i++) {
+    if (ip4_pmtu_plateaus[i] < tot_len) {
+      return LWIP_MAX(ip4_pmtu_plateaus[i], IP4_PMTU_MIN);
+    }
+  }
+  return IP4_PMTU_MIN;
+}
+
+#endif /* LWIP_IPV4 && LWIP_IPV4_PMTU */
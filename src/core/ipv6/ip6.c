@@ -50,6 +50,8 @@
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
 #include "lwip/ip6_frag.h"
+#include "lwip/ip6_fib.h"
+#include "lwip/ip_fwcache.h"
 #include "lwip/icmp6.h"
 #include "lwip/priv/raw_priv.h"
 #include "lwip/udp.h"
@@ -80,19 +82,25 @@
  *
  * @param src the source IPv6 address, if known
  * @param dest the destination IPv6 address for which to find the route
+ * @param flow_hash selects one of several equal-cost routes (LWIP_FIB_ECMP)
  * @return the netif on which to send to reach dest
  */
-struct netif *
-ip6_route(const ip6_addr_t *src, const ip6_addr_t *dest)
+static struct netif *
+ip6_route_hashed(const ip6_addr_t *src, const ip6_addr_t *dest, u32_t flow_hash)
 {
 #if LWIP_SINGLE_NETIF
   LWIP_UNUSED_ARG(src);
   LWIP_UNUSED_ARG(dest);
+  LWIP_UNUSED_ARG(flow_hash);
 #else /* LWIP_SINGLE_NETIF */
   struct netif *netif;
   s8_t i;
+#if LWIP_IPV6_FIB
+  const struct ip6_fib_entry *route;
+#endif /* LWIP_IPV6_FIB */
 
   LWIP_ASSERT_CORE_LOCKED();
+  LWIP_UNUSED_ARG(flow_hash);
 
   /* If single netif configuration, fast return. */
   if ((netif_list != NULL) && (netif_list->next == NULL)) {
@@ -207,11 +215,23 @@ ip6_route(const ip6_addr_t *src, const ip6_addr_t *dest)
     }
   }
 
+#if LWIP_IPV6_FIB
+  /* Get the netif of the most specific static or router-announced route. */
+#if LWIP_FIB_ECMP
+  route = ip6_fib_lookup_flow(dest, flow_hash);
+#else /* LWIP_FIB_ECMP */
+  route = ip6_fib_lookup(dest, NULL);
+#endif /* LWIP_FIB_ECMP */
+  if (route != NULL) {
+    return route->netif;
+  }
+#else /* LWIP_IPV6_FIB */
   /* Get the netif for a suitable router-announced route. */
   netif = nd6_find_route(dest);
   if (netif != NULL) {
     return netif;
   }
+#endif /* LWIP_IPV6_FIB */
 
   /* Try with the netif that matches the source address. Given the earlier rule
    * for scoped source addresses, this applies to unscoped addresses only. */
@@ -254,6 +274,38 @@ ip6_route(const ip6_addr_t *src, const ip6_addr_t *dest)
   return netif_default;
 }
 
+/**
+ * Finds the appropriate network interface for a given IPv6 address
+ * (see ip6_route_hashed()).
+ *
+ * @param src the source IPv6 address, if known
+ * @param dest the destination IPv6 address for which to find the route
+ * @return the netif on which to send to reach dest
+ */
+struct netif *
+ip6_route(const ip6_addr_t *src, const ip6_addr_t *dest)
+{
+  return ip6_route_hashed(src, dest, 0);
+}
+
+#if LWIP_FIB_ECMP
+/**
+ * @ingroup ip6
+ * Like ip6_route(), but if the route to dest has several equal-cost paths,
+ * flow_hash selects the path.
+ *
+ * @param src the source IPv6 address, if known
+ * @param dest the destination IPv6 address for which to find the route
+ * @param flow_hash hash of the flow (see ip6_flow_hash())
+ * @return the netif on which to send to reach dest
+ */
+struct netif *
+ip6_route_flow(const ip6_addr_t *src, const ip6_addr_t *dest, u32_t flow_hash)
+{
+  return ip6_route_hashed(src, dest, flow_hash);
+}
+#endif /* LWIP_FIB_ECMP */
+
 /**
  * @ingroup ip6
  * Select the best IPv6 source address for a given destination IPv6 address.
@@ -353,6 +405,33 @@ ip6_select_source_address(struct netif *netif, const ip6_addr_t *dest)
 }
 
 #if LWIP_IPV6_FORWARD
+#if LWIP_FIB_ECMP
+/**
+ * Flow hash of a packet to forward: addresses, next header and the ports of
+ * TCP and UDP packets without extension headers. Other packets (including
+ * fragments) use the flow label instead of the ports.
+ */
+static u32_t
+ip6_forward_flow_hash(const struct pbuf *p, const struct ip6_hdr *iphdr)
+{
+  u8_t nexth = IP6H_NEXTH(iphdr);
+  u16_t sport, dport;
+
+  if (((nexth == IP6_NEXTH_TCP) || (nexth == IP6_NEXTH_UDP) || (nexth == IP6_NEXTH_UDPLITE)) &&
+      (p->len >= IP6_HLEN + 4)) {
+    /* TCP and UDP both start with source and destination port */
+    const u16_t *ports = (const u16_t *)(const void *)((const u8_t *)iphdr + IP6_HLEN);
+    sport = lwip_ntohs(ports[0]);
+    dport = lwip_ntohs(ports[1]);
+  } else {
+    u32_t fl = IP6H_FL(iphdr);
+    sport = (u16_t)(fl >> 16);
+    dport = (u16_t)fl;
+  }
+  return ip6_flow_hash(ip6_current_src_addr(), ip6_current_dest_addr(), nexth, sport, dport);
+}
+#endif /* LWIP_FIB_ECMP */
+
 /**
  * Forwards an IPv6 packet. It finds an appropriate route for the
  * packet, decrements the HL value of the packet, and outputs
@@ -366,6 +445,11 @@ static void
 ip6_forward(struct pbuf *p, struct ip6_hdr *iphdr, struct netif *inp)
 {
   struct netif *netif;
+  u16_t mtu;
+  u32_t flow_hash = 0;
+#if IP_FORWARD_FLOW_CACHE && LWIP_IPV6_FIB
+  const struct ip6_fwcache_entry *flow;
+#endif /* IP_FORWARD_FLOW_CACHE && LWIP_IPV6_FIB */
 
   /* do not forward link-local or loopback addresses */
   if (ip6_addr_islinklocal(ip6_current_dest_addr()) ||
@@ -376,8 +460,22 @@ ip6_forward(struct pbuf *p, struct ip6_hdr *iphdr, struct netif *inp)
     return;
   }
 
-  /* Find network interface where to forward this IP packet to. */
-  netif = ip6_route(IP6_ADDR_ANY6, ip6_current_dest_addr());
+#if LWIP_FIB_ECMP
+  flow_hash = ip6_forward_flow_hash(p, iphdr);
+#endif /* LWIP_FIB_ECMP */
+  LWIP_UNUSED_ARG(flow_hash);
+
+#if IP_FORWARD_FLOW_CACHE && LWIP_IPV6_FIB
+  /* Known flow? Use the cached output netif. */
+  flow = ip6_fwcache_lookup(ip6_current_dest_addr(), inp, flow_hash);
+  if (flow != NULL) {
+    netif = flow->netif;
+  } else
+#endif /* IP_FORWARD_FLOW_CACHE && LWIP_IPV6_FIB */
+  {
+    /* Find network interface where to forward this IP packet to. */
+    netif = ip6_route_flow(IP6_ADDR_ANY6, ip6_current_dest_addr(), flow_hash);
+  }
   if (netif == NULL) {
     LWIP_DEBUGF(IP6_DEBUG, ("ip6_forward: no route for %"X16_F":%"X16_F":%"X16_F":%"X16_F":%"X16_F":%"X16_F":%"X16_F":%"X16_F"\n",
         IP6_ADDR_BLOCK1(ip6_current_dest_addr()),
@@ -420,6 +518,14 @@ ip6_forward(struct pbuf *p, struct ip6_hdr *iphdr, struct netif *inp)
     IP6_STATS_INC(ip6.drop);
     return;
   }
+#if IP_FORWARD_FLOW_CACHE && LWIP_IPV6_FIB
+  if (flow == NULL) {
+    flow = ip6_fwcache_add(ip6_current_dest_addr(), inp, netif, flow_hash);
+  }
+  mtu = flow->mtu;
+#else /* IP_FORWARD_FLOW_CACHE && LWIP_IPV6_FIB */
+  mtu = netif->mtu;
+#endif /* IP_FORWARD_FLOW_CACHE && LWIP_IPV6_FIB */
 
   /* decrement HL */
   IP6H_HOPLIM_SET(iphdr, IP6H_HOPLIM(iphdr) - 1);
@@ -435,11 +541,11 @@ ip6_forward(struct pbuf *p, struct ip6_hdr *iphdr, struct netif *inp)
     return;
   }
 
-  if (netif->mtu && (p->tot_len > netif->mtu)) {
+  if (mtu && (p->tot_len > mtu)) {
 #if LWIP_ICMP6
     /* Don't send ICMP messages in response to ICMP messages */
     if (IP6H_NEXTH(iphdr) != IP6_NEXTH_ICMP6) {
-      icmp6_packet_too_big(p, netif->mtu);
+      icmp6_packet_too_big(p, mtu);
     }
 #endif /* LWIP_ICMP6 */
     IP6_STATS_INC(ip6.drop);
@@ -519,6 +625,9 @@ ip6_input(struct pbuf *p, struct netif *inp)
 #if LWIP_RAW
   raw_input_state_t raw_status;
 #endif /* LWIP_RAW */
+#if LWIP_IPV6_MLD && LWIP_MLD6_SOURCE_FILTER
+  struct mld_group *mld6_group;
+#endif /* LWIP_IPV6_MLD && LWIP_MLD6_SOURCE_FILTER */
 
   LWIP_ASSERT_CORE_LOCKED();
 
@@ -600,9 +709,23 @@ ip6_input(struct pbuf *p, struct netif *inp)
       netif = inp;
     }
 #if LWIP_IPV6_MLD
+#if LWIP_MLD6_SOURCE_FILTER
+    else if ((mld6_group = mld6_lookfor_group(inp, ip6_current_dest_addr())) != NULL) {
+      /* MLD messages (with a hop-by-hop router alert) are processed
+         regardless of the sources joined */
+      if ((IP6H_NEXTH(ip6hdr) == IP6_NEXTH_HOPBYHOP) || (IP6H_NEXTH(ip6hdr) == IP6_NEXTH_ICMP6) ||
+          mld6_group_accepts_source(mld6_group, ip6_current_src_addr())) {
+        netif = inp;
+      } else {
+        LWIP_DEBUGF(IP6_DEBUG, ("ip6_input: multicast source not joined\n"));
+        netif = NULL;
+      }
+    }
+#else /* LWIP_MLD6_SOURCE_FILTER */
     else if (mld6_lookfor_group(inp, ip6_current_dest_addr())) {
       netif = inp;
     }
+#endif /* LWIP_MLD6_SOURCE_FILTER */
 #else /* LWIP_IPV6_MLD */
     else if (ip6_addr_issolicitednode(ip6_current_dest_addr())) {
       u8_t i;
@@ -0,0 +1,557 @@
+/**
+ * @file
+ * IPv6 forwarding information base (longest-prefix-match routing table)
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+/**
+ * @defgroup ip6_fib IPv6 routing table
+ * @ingroup ip6
+ *
+ * IPv6 routes with longest-prefix-match lookup. The table holds static
+ * routes (ip6_fib_add()) as well as the on-link prefixes and default routers
+ * learned from router advertisements, so ip6_route() and the next hop
+ * selection in nd6 need a single trie walk instead of scanning the prefix and
+ * router lists.
+ *
+ * Routes are kept in a path-compressed binary trie: every node stores its
+ * full prefix, and nodes are only created where routes are or where two
+ * routes branch, so a lookup visits at most one node per distinct prefix
+ * length on the path to the destination. Several routes to the same prefix
+ * (e.g. via different routers) hang off the trie node sorted by metric; the
+ * lowest metric route whose netif is usable is selected. With LWIP_FIB_ECMP,
+ * ip6_fib_lookup_flow() spreads flows across all usable routes sharing that
+ * lowest metric.
+ *
+ * Default routes learned from router advertisements are used for routing
+ * only; the router itself is still chosen by nd6 (preferring reachable
+ * routers as per RFC 4861).
+ */
+
+#include "lwip/opt.h"
+
+#if LWIP_IPV6 && LWIP_IPV6_FIB /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/ip6_fib.h"
+#include "lwip/def.h"
+#include "lwip/memp.h"
+#include "lwip/ip_fwcache.h"
+
+#include <string.h>
+
+/** The bit of 'key' following the first 'pos' bits */
+#define IP6_FIB_BIT(key, pos) ((u8_t)(((key)[(pos) >> 5] >> (31 - ((pos) & 31))) & 1))
+
+static struct ip6_fib_entry *ip6_fib_root;
+
+/** Convert an address into a key in host byte order */
+static void
+ip6_fib_key(u32_t *key, const ip6_addr_t *addr)
+{
+  int i;
+  for (i = 0; i < 4; i++) {
+    key[i] = lwip_ntohl(addr->addr[i]);
+  }
+}
+
+/** Length of the common prefix of two keys, limited to 'max' */
+static u8_t
+ip6_fib_common_len(const u32_t *a, const u32_t *b, u8_t max)
+{
+  u8_t len = 0;
+  int i;
+
+  for (i = 0; (i < 4) && (len < max); i++) {
+    u32_t diff = a[i] ^ b[i];
+    if (diff != 0) {
+      while (!(diff & 0x80000000UL)) {
+        diff <<= 1;
+        len++;
+      }
+      break;
+    }
+    len = (u8_t)(len + 32);
+  }
+  return LWIP_MIN(len, max);
+}
+
+/** Clear the host bits of an address (advertised prefixes may have them set) */
+static void
+ip6_fib_mask(ip6_addr_t *net, const ip6_addr_t *addr, u8_t prefix_len)
+{
+  int i;
+
+  ip6_addr_copy(*net, *addr);
+  for (i = 0; i < 4; i++) {
+    if (prefix_len <= i * 32) {
+      net->addr[i] = 0;
+    } else if (prefix_len < (i + 1) * 32) {
+      net->addr[i] &= lwip_htonl(0xffffffffUL << ((i + 1) * 32 - prefix_len));
+    }
+  }
+}
+
+/** Does the node's prefix cover 'key'? */
+static int
+ip6_fib_match(const u32_t *key, const struct ip6_fib_entry *node)
+{
+  return ip6_fib_common_len(key, node->prefix, node->prefix_len) == node->prefix_len;
+}
+
+/** Copy the route data (not the trie links) */
+static void
+ip6_fib_copy_route(struct ip6_fib_entry *dst, const struct ip6_fib_entry *src)
+{
+  ip6_addr_copy(dst->gw, src->gw);
+  dst->netif = src->netif;
+  dst->metric = src->metric;
+  dst->origin = src->origin;
+}
+
+/** Does an entry hold the route via gw (NULL: on-link) and netif? */
+static int
+ip6_fib_route_eq(const struct ip6_fib_entry *entry, const ip6_addr_t *gw, const struct netif *netif, u8_t origin)
+{
+  return (entry->netif == netif) && (entry->origin == origin) &&
+         ((gw == NULL) ? ip6_addr_isany(&entry->gw) : ip6_addr_zoneless_eq(&entry->gw, gw));
+}
+
+/** The node link pointing to 'node' */
+static struct ip6_fib_entry **
+ip6_fib_link(struct ip6_fib_entry *node)
+{
+  struct ip6_fib_entry *parent = node->parent;
+  if (parent == NULL) {
+    return &ip6_fib_root;
+  }
+  return &parent->child[parent->child[1] == node];
+}
+
+/** Remove a node that is not a route any more and its parent if that only
+ * branched to this node */
+static void
+ip6_fib_prune(struct ip6_fib_entry *node)
+{
+  while ((node != NULL) && (node->netif == NULL) &&
+         ((node->child[0] == NULL) || (node->child[1] == NULL))) {
+    struct ip6_fib_entry *parent = node->parent;
+    struct ip6_fib_entry *child = (node->child[0] != NULL) ? node->child[0] : node->child[1];
+
+    LWIP_ASSERT("branch node without routes", node->next == NULL);
+    *ip6_fib_link(node) = child;
+    if (child != NULL) {
+      child->parent = parent;
+    }
+    memp_free(MEMP_IP6_FIB_ENTRY, node);
+    node = parent;
+  }
+}
+
+/** Pre-order successor of a trie node (or NULL at the end of the trie) */
+static struct ip6_fib_entry *
+ip6_fib_walk_next(struct ip6_fib_entry *node)
+{
+  if (node->child[0] != NULL) {
+    return node->child[0];
+  }
+  if (node->child[1] != NULL) {
+    return node->child[1];
+  }
+  while (node->parent != NULL) {
+    struct ip6_fib_entry *parent = node->parent;
+    if ((parent->child[0] == node) && (parent->child[1] != NULL)) {
+      return parent->child[1];
+    }
+    node = parent;
+  }
+  return NULL;
+}
+
+/** Find the trie node of a prefix */
+static struct ip6_fib_entry *
+ip6_fib_find_node(const u32_t *key, u8_t prefix_len)
+{
+  struct ip6_fib_entry *node = ip6_fib_root;
+
+  while ((node != NULL) && (node->prefix_len <= prefix_len) && ip6_fib_match(key, node)) {
+    if (node->prefix_len == prefix_len) {
+      return node;
+    }
+    node = node->child[IP6_FIB_BIT(key, node->prefix_len)];
+  }
+  return NULL;
+}
+
+/** Unlink a route from the list of its trie node (freeing an entry) */
+static void
+ip6_fib_unlink_route(struct ip6_fib_entry *node, struct ip6_fib_entry *prev)
+{
+  struct ip6_fib_entry *entry;
+
+  IP_FWCACHE_INVALIDATE();
+  if (prev == NULL) {
+    /* the route is stored in the trie node */
+    entry = node->next;
+    if (entry == NULL) {
+      node->netif = NULL;
+      ip6_fib_prune(node);
+      return;
+    }
+    ip6_fib_copy_route(node, entry);
+    node->next = entry->next;
+  } else {
+    entry = prev->next;
+    prev->next = entry->next;
+  }
+  memp_free(MEMP_IP6_FIB_ENTRY, entry);
+}
+
+/** Remove the route to a prefix via gw and netif */
+static err_t
+ip6_fib_delete(const ip6_addr_t *prefix, u8_t prefix_len, const ip6_addr_t *gw, const struct netif *netif, u8_t origin)
+{
+  struct ip6_fib_entry *node, *prev;
+  u32_t key[4];
+
+  ip6_fib_key(key, prefix);
+  node = ip6_fib_find_node(key, prefix_len);
+  if ((node == NULL) || (node->netif == NULL)) {
+    return ERR_VAL;
+  }
+  if (ip6_fib_route_eq(node, gw, netif, origin)) {
+    ip6_fib_unlink_route(node, NULL);
+    return ERR_OK;
+  }
+  for (prev = node; prev->next != NULL; prev = prev->next) {
+    if (ip6_fib_route_eq(prev->next, gw, netif, origin)) {
+      ip6_fib_unlink_route(node, prev);
+      return ERR_OK;
+    }
+  }
+  return ERR_VAL;
+}
+
+static err_t
+ip6_fib_insert(const ip6_addr_t *prefix, u8_t prefix_len, const ip6_addr_t *gw, struct netif *netif,
+               u16_t metric, u8_t origin)
+{
+  struct ip6_fib_entry **link = &ip6_fib_root;
+  struct ip6_fib_entry *parent = NULL;
+  struct ip6_fib_entry *node, *entry, *prev;
+  u32_t key[4];
+  int i;
+
+  LWIP_ERROR("ip6_fib_add: invalid prefix", (prefix != NULL) && (prefix_len <= 128), return ERR_VAL;);
+  LWIP_ERROR("ip6_fib_add: invalid netif", netif != NULL, return ERR_VAL;);
+
+  ip6_fib_key(key, prefix);
+  for (i = 0; i < 4; i++) {
+    if (prefix_len < (i + 1) * 32) {
+      u32_t mask = (prefix_len <= i * 32) ? 0 : (0xffffffffUL << ((i + 1) * 32 - prefix_len));
+      LWIP_ERROR("ip6_fib_add: host bits set in prefix", (key[i] & ~mask) == 0, return ERR_VAL;);
+    }
+  }
+
+  /* check for duplicates before allocating (advertisements are repeated) */
+  for (prev = ip6_fib_find_node(key, prefix_len); (prev != NULL) && (prev->netif != NULL); prev = prev->next) {
+    if (ip6_fib_route_eq(prev, gw, netif, origin)) {
+      return ERR_USE;
+    }
+  }
+
+  entry = (struct ip6_fib_entry *)memp_malloc(MEMP_IP6_FIB_ENTRY);
+  if (entry == NULL) {
+    return ERR_MEM;
+  }
+  IP_FWCACHE_INVALIDATE();
+  memset(entry, 0, sizeof(struct ip6_fib_entry));
+  MEMCPY(entry->prefix, key, sizeof(key));
+  entry->prefix_len = prefix_len;
+  if (gw != NULL) {
+    ip6_addr_set(&entry->gw, gw);
+    ip6_addr_assign_zone(&entry->gw, IP6_UNICAST, netif);
+  }
+  entry->netif = netif;
+  entry->metric = metric;
+  entry->origin = origin;
+
+  /* descend while the nodes are prefixes of the new route */
+  while ((node = *link) != NULL) {
+    if ((node->prefix_len > prefix_len) || !ip6_fib_match(key, node)) {
+      break;
+    }
+    if (node->prefix_len == prefix_len) {
+      if (node->netif == NULL) {
+        /* turn the branch node into a route */
+        ip6_fib_copy_route(node, entry);
+        memp_free(MEMP_IP6_FIB_ENTRY, entry);
+        return ERR_OK;
+      }
+      if (metric < node->metric) {
+        /* the trie node holds the best route: swap */
+        struct ip6_fib_entry tmp;
+        ip6_fib_copy_route(&tmp, node);
+        ip6_fib_copy_route(node, entry);
+        ip6_fib_copy_route(entry, &tmp);
+        prev = node;
+      } else {
+        for (prev = node; (prev->next != NULL) && (prev->next->metric <= metric); prev = prev->next);
+      }
+      entry->next = prev->next;
+      prev->next = entry;
+      return ERR_OK;
+    }
+    parent = node;
+    link = &node->child[IP6_FIB_BIT(key, node->prefix_len)];
+  }
+
+  entry->parent = parent;
+  if (node != NULL) {
+    /* 'node' is more specific than or diverges from the new route */
+    u8_t common = ip6_fib_common_len(key, node->prefix, LWIP_MIN(prefix_len, node->prefix_len));
+    if (common == prefix_len) {
+      /* the new route is a prefix of 'node': insert it above */
+      entry->child[IP6_FIB_BIT(node->prefix, prefix_len)] = node;
+      node->parent = entry;
+    } else {
+      /* branch at the first differing bit */
+      struct ip6_fib_entry *branch = (struct ip6_fib_entry *)memp_malloc(MEMP_IP6_FIB_ENTRY);
+      if (branch == NULL) {
+        memp_free(MEMP_IP6_FIB_ENTRY, entry);
+        return ERR_MEM;
+      }
+      memset(branch, 0, sizeof(struct ip6_fib_entry));
+      for (i = 0; i < 4; i++) {
+        if (common >= (i + 1) * 32) {
+          branch->prefix[i] = key[i];
+        } else if (common > i * 32) {
+          branch->prefix[i] = key[i] & (0xffffffffUL << ((i + 1) * 32 - common));
+        }
+      }
+      branch->prefix_len = common;
+      branch->parent = parent;
+      branch->child[IP6_FIB_BIT(key, common)] = entry;
+      branch->child[IP6_FIB_BIT(node->prefix, common)] = node;
+      entry->parent = branch;
+      node->parent = branch;
+      entry = branch;
+    }
+  }
+  *link = entry;
+  return ERR_OK;
+}
+
+/**
+ * @ingroup ip6_fib
+ * Add a static route.
+ *
+ * @param prefix destination network (host bits must be 0)
+ * @param prefix_len length of the network prefix (0..128, 0 is a default route)
+ * @param gw gateway to send to (NULL for on-link routes); link-local gateways
+ *        get the zone of netif
+ * @param netif netif to send on
+ * @param metric lower metrics are preferred among routes to the same prefix
+ * @return ERR_OK on success, ERR_USE if the same route exists,
+ *         ERR_MEM if the MEMP_IP6_FIB_ENTRY pool is exhausted
+ */
+err_t
+ip6_fib_add(const ip6_addr_t *prefix, u8_t prefix_len, const ip6_addr_t *gw, struct netif *netif, u16_t metric)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  return ip6_fib_insert(prefix, prefix_len, gw, netif, metric, IP6_FIB_ORIGIN_STATIC);
+}
+
+/**
+ * @ingroup ip6_fib
+ * Remove a static route.
+ *
+ * @param prefix destination network of the route
+ * @param prefix_len length of the network prefix
+ * @param gw gateway of the route (NULL for on-link routes)
+ * @param netif netif of the route
+ * @return ERR_OK on success, ERR_VAL if there is no such route
+ */
+err_t
+ip6_fib_remove(const ip6_addr_t *prefix, u8_t prefix_len, const ip6_addr_t *gw, struct netif *netif)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+  LWIP_ERROR("ip6_fib_remove: invalid prefix", (prefix != NULL) && (prefix_len <= 128), return ERR_VAL;);
+
+  return ip6_fib_delete(prefix, prefix_len, gw, netif, IP6_FIB_ORIGIN_STATIC);
+}
+
+/**
+ * @ingroup ip6_fib
+ * Find the route to a destination with the longest matching prefix (and the
+ * lowest metric among those).
+ *
+ * @param dest destination address
+ * @param netif if not NULL, only routes via this netif are considered;
+ *        otherwise only routes whose netif is up and has a link
+ * @return the route or NULL if no route matches
+ */
+const struct ip6_fib_entry *
+ip6_fib_lookup(const ip6_addr_t *dest, const struct netif *netif)
+{
+  const struct ip6_fib_entry *node = ip6_fib_root;
+  const struct ip6_fib_entry *best = NULL;
+  const struct ip6_fib_entry *route;
+  u32_t key[4];
+
+  ip6_fib_key(key, dest);
+  while ((node != NULL) && ip6_fib_match(key, node)) {
+    for (route = node; (route != NULL) && (route->netif != NULL); route = route->next) {
+      if ((netif != NULL) ? (route->netif == netif) :
+          (netif_is_up(route->netif) && netif_is_link_up(route->netif))) {
+        best = route;
+        break;
+      }
+    }
+    if (node->prefix_len == 128) {
+      break;
+    }
+    node = node->child[IP6_FIB_BIT(key, node->prefix_len)];
+  }
+  return best;
+}
+
+#if LWIP_FIB_ECMP
+/**
+ * @ingroup ip6_fib
+ * Find the routes to a destination with the longest matching prefix and the
+ * lowest metric among those whose netif is up and has a link, and select one
+ * of them by a flow hash.
+ *
+ * @param dest destination address
+ * @param flow_hash hash of the flow (see ip6_flow_hash()); packets with the
+ *        same hash take the same route as long as the set of usable routes
+ *        does not change
+ * @return the selected route or NULL if no route matches
+ */
+const struct ip6_fib_entry *
+ip6_fib_lookup_flow(const ip6_addr_t *dest, u32_t flow_hash)
+{
+  const struct ip6_fib_entry *best = ip6_fib_lookup(dest, NULL);
+  const struct ip6_fib_entry *route;
+  u32_t n = 0;
+
+  if (best == NULL) {
+    return NULL;
+  }
+  /* routes of a prefix are sorted by metric: the equal-cost ones follow best */
+  for (route = best; (route != NULL) && (route->metric == best->metric); route = route->next) {
+    if (netif_is_up(route->netif) && netif_is_link_up(route->netif)) {
+      n++;
+    }
+  }
+  n = flow_hash % n;
+  for (route = best; ; route = route->next) {
+    if (netif_is_up(route->netif) && netif_is_link_up(route->netif)) {
+      if (n == 0) {
+        return route;
+      }
+      n--;
+    }
+  }
+}
+#endif /* LWIP_FIB_ECMP */
+
+/**
+ * Remove all routes via a netif (called when the netif is removed).
+ *
+ * @param netif the netif being removed
+ */
+void
+ip6_fib_cleanup_netif(const struct netif *netif)
+{
+  struct ip6_fib_entry *node = ip6_fib_root;
+
+  while (node != NULL) {
+    struct ip6_fib_entry *prev = node;
+    while (prev->next != NULL) {
+      if (prev->next->netif == netif) {
+        ip6_fib_unlink_route(node, prev);
+      } else {
+        prev = prev->next;
+      }
+    }
+    if (node->netif == netif) {
+      if (node->next == NULL) {
+        ip6_fib_unlink_route(node, NULL);
+        /* pruning may free any node on the path: restart */
+        node = ip6_fib_root;
+        continue;
+      }
+      ip6_fib_unlink_route(node, NULL);
+    }
+    node = ip6_fib_walk_next(node);
+  }
+}
+
+/**
+ * Add (or keep) a route learned from a router advertisement.
+ *
+ * @param prefix destination network
+ * @param prefix_len length of the network prefix
+ * @param gw the router (NULL for on-link prefixes)
+ * @param netif netif the advertisement was received on
+ * @return ERR_OK if the route is in the table
+ */
+err_t
+ip6_fib_add_ra(const ip6_addr_t *prefix, u8_t prefix_len, const ip6_addr_t *gw, struct netif *netif)
+{
+  ip6_addr_t net;
+  err_t err;
+
+  ip6_fib_mask(&net, prefix, prefix_len);
+  err = ip6_fib_insert(&net, prefix_len, gw, netif, IP6_FIB_METRIC_RA, IP6_FIB_ORIGIN_RA);
+  return (err == ERR_USE) ? ERR_OK : err;
+}
+
+/**
+ * Remove a route learned from a router advertisement (if it exists).
+ *
+ * @param prefix destination network
+ * @param prefix_len length of the network prefix
+ * @param gw the router (NULL for on-link prefixes)
+ * @param netif netif the advertisement was received on
+ */
+void
+ip6_fib_remove_ra(const ip6_addr_t *prefix, u8_t prefix_len, const ip6_addr_t *gw, struct netif *netif)
+{
+  ip6_addr_t net;
+
+  ip6_fib_mask(&net, prefix, prefix_len);
+  ip6_fib_delete(&net, prefix_len, gw, netif, IP6_FIB_ORIGIN_RA);
+}
+
+#endif /* LWIP_IPV6 && LWIP_IPV6_FIB */
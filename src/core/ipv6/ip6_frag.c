@@ -49,6 +49,7 @@
 #include "lwip/pbuf.h"
 #include "lwip/memp.h"
 #include "lwip/stats.h"
+#include "lwip/priv/ip_reass_tree.h"
 
 #include <string.h>
 
@@ -70,37 +71,15 @@
 #define IP_REASS_FREE_OLDEST 1
 #endif /* IP_REASS_FREE_OLDEST */
 
-#if IPV6_FRAG_COPYHEADER
 /* The number of bytes we need to "borrow" from (i.e., overwrite in) the header
  * that precedes the fragment header for reassembly pruposes. */
-#define IPV6_FRAG_REQROOM ((s16_t)(sizeof(struct ip6_reass_helper) - IP6_FRAG_HLEN))
-#endif
+#define IPV6_FRAG_REQROOM ((s16_t)(sizeof(struct ip_reass_node) - IP6_FRAG_HLEN))
 
-#define IP_REASS_FLAG_LASTFRAG 0x01
-
-/** This is a helper struct which holds the starting
- * offset and the ending offset of this fragment to
- * easily chain the fragments.
- * It has the same packing requirements as the IPv6 header, since it replaces
- * the Fragment Header in memory in incoming fragments to keep
- * track of the various fragments.
- */
-#ifdef PACK_STRUCT_USE_INCLUDES
-#  include "arch/bpstruct.h"
-#endif
-PACK_STRUCT_BEGIN
-struct ip6_reass_helper {
-  PACK_STRUCT_FIELD(struct pbuf *next_pbuf);
-  PACK_STRUCT_FIELD(u16_t start);
-  PACK_STRUCT_FIELD(u16_t end);
-} PACK_STRUCT_STRUCT;
-PACK_STRUCT_END
-#ifdef PACK_STRUCT_USE_INCLUDES
-#  include "arch/epstruct.h"
-#endif
+/** Hash bucket of the datagrams from a source address */
+#define IP6_REASS_BUCKET(src) IP_REASS_HASH((src)->addr[0] ^ (src)->addr[1] ^ (src)->addr[2] ^ (src)->addr[3])
 
 /* static variables */
-static struct ip6_reassdata *reassdatagrams;
+static struct ip6_reassdata *reassdatagrams[IP_REASS_HASH_SIZE];
 static u16_t ip6_reass_pbufcount;
 
 /* Forward declarations. */
@@ -113,28 +92,44 @@ void
 ip6_reass_tmr(void)
 {
   struct ip6_reassdata *r, *tmp;
+  u16_t i;
 
-#if !IPV6_FRAG_COPYHEADER
-  LWIP_ASSERT("sizeof(struct ip6_reass_helper) <= IP6_FRAG_HLEN, set IPV6_FRAG_COPYHEADER to 1",
-    sizeof(struct ip6_reass_helper) <= IP6_FRAG_HLEN);
-#endif /* !IPV6_FRAG_COPYHEADER */
-
-  r = reassdatagrams;
-  while (r != NULL) {
-    /* Decrement the timer. Once it reaches 0,
-     * clean up the incomplete fragment assembly */
-    if (r->timer > 0) {
-      r->timer--;
-      r = r->next;
-    } else {
-      /* reassembly timed out */
-      tmp = r;
-      /* get the next pointer before freeing */
-      r = r->next;
-      /* free the helper struct and all enqueued pbufs */
-      ip6_reass_free_complete_datagram(tmp);
-     }
-   }
+  for (i = 0; i < IP_REASS_HASH_SIZE; i++) {
+    r = reassdatagrams[i];
+    while (r != NULL) {
+      /* Decrement the timer. Once it reaches 0,
+       * clean up the incomplete fragment assembly */
+      if (r->timer > 0) {
+        r->timer--;
+        r = r->next;
+      } else {
+        /* reassembly timed out */
+        tmp = r;
+        /* get the next pointer before freeing */
+        r = r->next;
+        /* free the helper struct and all enqueued pbufs */
+        ip6_reass_free_complete_datagram(tmp);
+      }
+    }
+  }
+}
+
+/**
+ * Unchain a datagram (struct ip6_reassdata) from its list and free it.
+ * Doesn't deallocate the pbufs.
+ *
+ * @param ipr datagram to dequeue
+ */
+static void
+ip6_reass_dequeue_datagram(struct ip6_reassdata *ipr)
+{
+  struct ip6_reassdata **link;
+
+  for (link = &reassdatagrams[IP6_REASS_BUCKET(&ipr->src)]; *link != ipr; link = &(*link)->next) {
+    LWIP_ASSERT("sanity check linked list", *link != NULL);
+  }
+  *link = ipr->next;
+  memp_free(MEMP_IP6_REASSDATA, ipr);
 }
 
 /**
@@ -147,56 +142,50 @@ ip6_reass_tmr(void)
 static void
 ip6_reass_free_complete_datagram(struct ip6_reassdata *ipr)
 {
-  struct ip6_reassdata *prev;
   u16_t pbufs_freed = 0;
   u16_t clen;
   struct pbuf *p;
-  struct ip6_reass_helper *iprh;
 
 #if LWIP_ICMP6
-  if (ipr->p != NULL) {
-    iprh = (struct ip6_reass_helper *)ipr->p->payload;
-    if (iprh->start == 0) {
-      /* The first fragment was received, send ICMP time exceeded. */
-      /* First, de-queue the first pbuf from r->p. */
-      p = ipr->p;
-      ipr->p = iprh->next_pbuf;
-      /* Restore the part that we've overwritten with our helper structure, or we
-       * might send garbage (and disclose a pointer) in the ICMPv6 reply. */
-      MEMCPY(p->payload, ipr->orig_hdr, sizeof(*iprh));
-      /* Then, move back to the original ipv6 header (we are now pointing to Fragment header).
-         This cannot fail since we already checked when receiving this fragment. */
-      if (pbuf_header_force(p, (s16_t)((u8_t*)p->payload - (u8_t*)ipr->iphdr))) {
-        LWIP_ASSERT("ip6_reass_free: moving p->payload to ip6 header failed", 0);
-      }
-      else {
-        /* Reconstruct the zoned source and destination addresses, so that we do
-         * not end up sending the ICMP response over the wrong link. */
-        ip6_addr_t src_addr, dest_addr;
-        ip6_addr_copy_from_packed(src_addr, IPV6_FRAG_SRC(ipr));
-        ip6_addr_set_zone(&src_addr, ipr->src_zone);
-        ip6_addr_copy_from_packed(dest_addr, IPV6_FRAG_DEST(ipr));
-        ip6_addr_set_zone(&dest_addr, ipr->dest_zone);
-        /* Send the actual ICMP response. */
-        icmp6_time_exceeded_with_addrs(p, ICMP6_TE_FRAG, &src_addr, &dest_addr);
-      }
-      clen = pbuf_clen(p);
-      LWIP_ASSERT("pbufs_freed + clen <= 0xffff", pbufs_freed + clen <= 0xffff);
-      pbufs_freed = (u16_t)(pbufs_freed + clen);
-      pbuf_free(p);
+  p = ip_reass_tree_first(&ipr->p);
+  if ((p != NULL) && (IP_REASS_NODE(p)->start == 0)) {
+    /* The first fragment was received, send ICMP time exceeded. */
+    /* First, de-queue the first pbuf from r->p (it has no left subtree). */
+    ipr->p = IP_REASS_NODE(p)->right;
+    /* Restore the part that we've overwritten with our helper structure, or we
+     * might send garbage (and disclose a pointer) in the ICMPv6 reply. */
+    MEMCPY(p->payload, ipr->orig_hdr, sizeof(struct ip_reass_node));
+    /* Then, move back to the original ipv6 header (we are now pointing to Fragment header).
+       This cannot fail since we already checked when receiving this fragment. */
+    if (pbuf_header_force(p, (s16_t)((u8_t*)p->payload - (u8_t*)ipr->iphdr))) {
+      LWIP_ASSERT("ip6_reass_free: moving p->payload to ip6 header failed", 0);
     }
+    else {
+      /* Reconstruct the zoned source and destination addresses, so that we do
+       * not end up sending the ICMP response over the wrong link. */
+      ip6_addr_t src_addr, dest_addr;
+      ip6_addr_copy_from_packed(src_addr, IPV6_FRAG_SRC(ipr));
+      ip6_addr_set_zone(&src_addr, ipr->src_zone);
+      ip6_addr_copy_from_packed(dest_addr, IPV6_FRAG_DEST(ipr));
+      ip6_addr_set_zone(&dest_addr, ipr->dest_zone);
+      /* Send the actual ICMP response. */
+      icmp6_time_exceeded_with_addrs(p, ICMP6_TE_FRAG, &src_addr, &dest_addr);
+    }
+    clen = pbuf_clen(p);
+    LWIP_ASSERT("pbufs_freed + clen <= 0xffff", pbufs_freed + clen <= 0xffff);
+    pbufs_freed = (u16_t)(pbufs_freed + clen);
+    pbuf_free(p);
   }
 #endif /* LWIP_ICMP6 */
 
   /* First, free all received pbufs.  The individual pbufs need to be released
      separately as they have not yet been chained */
-  p = ipr->p;
+  p = ip_reass_tree_to_list(&ipr->p);
   while (p != NULL) {
     struct pbuf *pcur;
-    iprh = (struct ip6_reass_helper *)p->payload;
     pcur = p;
     /* get the next pointer before freeing */
-    p = iprh->next_pbuf;
+    p = IP_REASS_NODE(p)->right;
     clen = pbuf_clen(pcur);
     LWIP_ASSERT("pbufs_freed + clen <= 0xffff", pbufs_freed + clen <= 0xffff);
     pbufs_freed = (u16_t)(pbufs_freed + clen);
@@ -204,21 +193,7 @@ ip6_reass_free_complete_datagram(struct ip6_reassdata *ipr)
   }
 
   /* Then, unchain the struct ip6_reassdata from the list and free it. */
-  if (ipr == reassdatagrams) {
-    reassdatagrams = ipr->next;
-  } else {
-    prev = reassdatagrams;
-    while (prev != NULL) {
-      if (prev->next == ipr) {
-        break;
-      }
-      prev = prev->next;
-    }
-    if (prev != NULL) {
-      prev->next = ipr->next;
-    }
-  }
-  memp_free(MEMP_IP6_REASSDATA, ipr);
+  ip6_reass_dequeue_datagram(ipr);
 
   /* Finally, update number of pbufs in reassembly queue */
   LWIP_ASSERT("ip_reass_pbufcount >= clen", ip6_reass_pbufcount >= pbufs_freed);
@@ -238,28 +213,28 @@ static void
 ip6_reass_remove_oldest_datagram(struct ip6_reassdata *ipr, int pbufs_needed)
 {
   struct ip6_reassdata *r, *oldest;
+  u16_t i;
 
   /* Free datagrams until being allowed to enqueue 'pbufs_needed' pbufs,
    * but don't free the current datagram! */
   do {
-    r = oldest = reassdatagrams;
-    while (r != NULL) {
-      if (r != ipr) {
-        if (r->timer <= oldest->timer) {
-          /* older than the previous oldest */
-          oldest = r;
+    oldest = NULL;
+    for (i = 0; i < IP_REASS_HASH_SIZE; i++) {
+      for (r = reassdatagrams[i]; r != NULL; r = r->next) {
+        if (r != ipr) {
+          if ((oldest == NULL) || (r->timer <= oldest->timer)) {
+            /* older than the previous oldest */
+            oldest = r;
+          }
         }
       }
-      r = r->next;
     }
-    if (oldest == ipr) {
+    if (oldest == NULL) {
       /* nothing to free, ipr is the only element on the list */
       return;
     }
-    if (oldest != NULL) {
-      ip6_reass_free_complete_datagram(oldest);
-    }
-  } while (((ip6_reass_pbufcount + pbufs_needed) > IP_REASS_MAX_PBUFS) && (reassdatagrams != NULL));
+    ip6_reass_free_complete_datagram(oldest);
+  } while ((ip6_reass_pbufcount + pbufs_needed) > IP_REASS_MAX_PBUFS);
 }
 #endif /* IP_REASS_FREE_OLDEST */
 
@@ -273,14 +248,13 @@ ip6_reass_remove_oldest_datagram(struct ip6_reassdata *ipr, int pbufs_needed)
 struct pbuf *
 ip6_reass(struct pbuf *p)
 {
-  struct ip6_reassdata *ipr, *ipr_prev;
-  struct ip6_reass_helper *iprh, *iprh_tmp, *iprh_prev=NULL;
+  struct ip6_reassdata *ipr, *iprs;
   struct ip6_frag_hdr *frag_hdr;
   u16_t offset, len, start, end;
   ptrdiff_t hdrdiff;
-  u16_t clen;
-  u8_t valid = 1;
-  struct pbuf *q, *next_pbuf;
+  u16_t clen, src_pbufs, bucket;
+  u8_t valid;
+  struct pbuf *next_pbuf;
 
   IP6_FRAG_STATS_INC(ip6_frag.recv);
 
@@ -314,20 +288,32 @@ ip6_reass(struct pbuf *p)
     IP6_FRAG_STATS_INC(ip6_frag.proterr);
     goto nullreturn;
   }
+  end = (u16_t)(start + len);
 
-  /* Look for the datagram the fragment belongs to in the current datagram queue,
-   * remembering the previous in the queue for later dequeueing. */
-  for (ipr = reassdatagrams, ipr_prev = NULL; ipr != NULL; ipr = ipr->next) {
-    /* Check if the incoming fragment matches the one currently present
-       in the reassembly buffer. If so, we proceed with copying the
-       fragment into the buffer. */
-    if ((frag_hdr->_identification == ipr->identification) &&
-        ip6_addr_packed_eq(ip6_current_src_addr(), &(IPV6_FRAG_SRC(ipr)), ipr->src_zone) &&
-        ip6_addr_packed_eq(ip6_current_dest_addr(), &(IPV6_FRAG_DEST(ipr)), ipr->dest_zone)) {
-      IP6_FRAG_STATS_INC(ip6_frag.cachehit);
-      break;
+  /* Look for the datagram the fragment belongs to in the list of its source,
+   * counting the pbufs enqueued for that source. */
+  bucket = IP6_REASS_BUCKET(ip6_current_src_addr());
+  ipr = NULL;
+  src_pbufs = 0;
+  for (iprs = reassdatagrams[bucket]; iprs != NULL; iprs = iprs->next) {
+    if (ip6_addr_packed_eq(ip6_current_src_addr(), &(IPV6_FRAG_SRC(iprs)), iprs->src_zone)) {
+      src_pbufs = (u16_t)(src_pbufs + iprs->pbufs);
+      /* Check if the incoming fragment matches the one currently present
+         in the reassembly buffer. If so, we proceed with copying the
+         fragment into the buffer. */
+      if ((ipr == NULL) && (frag_hdr->_identification == iprs->identification) &&
+          ip6_addr_packed_eq(ip6_current_dest_addr(), &(IPV6_FRAG_DEST(iprs)), iprs->dest_zone)) {
+        IP6_FRAG_STATS_INC(ip6_frag.cachehit);
+        ipr = iprs;
+      }
     }
-    ipr_prev = ipr;
+  }
+
+  /* Check if this source is allowed to enqueue more pbufs: don't free other
+   * datagrams for a source exceeding its share. */
+  if ((src_pbufs + clen) > IP_REASS_MAX_PBUFS_PER_SOURCE) {
+    IP6_FRAG_STATS_INC(ip6_frag.memerr);
+    goto nullreturn;
   }
 
   if (ipr == NULL) {
@@ -338,14 +324,7 @@ ip6_reass(struct pbuf *p)
       /* Make room and try again. */
       ip6_reass_remove_oldest_datagram(ipr, clen);
       ipr = (struct ip6_reassdata *)memp_malloc(MEMP_IP6_REASSDATA);
-      if (ipr != NULL) {
-        /* re-search ipr_prev since it might have been removed */
-        for (ipr_prev = reassdatagrams; ipr_prev != NULL; ipr_prev = ipr_prev->next) {
-          if (ipr_prev->next == ipr) {
-            break;
-          }
-        }
-      } else
+      if (ipr == NULL)
 #endif /* IP_REASS_FREE_OLDEST */
       {
         IP6_FRAG_STATS_INC(ip6_frag.memerr);
@@ -356,19 +335,17 @@ ip6_reass(struct pbuf *p)
     memset(ipr, 0, sizeof(struct ip6_reassdata));
     ipr->timer = IPV6_REASS_MAXAGE;
 
-    /* enqueue the new structure to the front of the list */
-    ipr->next = reassdatagrams;
-    reassdatagrams = ipr;
+    /* enqueue the new structure to the front of its list */
+    ipr->next = reassdatagrams[bucket];
+    reassdatagrams[bucket] = ipr;
 
     /* Use the current IPv6 header for src/dest address reference.
      * Eventually, we will replace it when we get the first fragment
      * (it might be this one, in any case, it is done later). */
     /* need to use the none-const pointer here: */
     ipr->iphdr = ip_data.current_ip6_header;
-#if IPV6_FRAG_COPYHEADER
     MEMCPY(&ipr->src, &ip6_current_header()->src, sizeof(ipr->src));
     MEMCPY(&ipr->dest, &ip6_current_header()->dest, sizeof(ipr->dest));
-#endif /* IPV6_FRAG_COPYHEADER */
 #if LWIP_IPV6_SCOPES
     /* Also store the address zone information.
      * @todo It is possible that due to netif destruction and recreation, the
@@ -390,14 +367,7 @@ ip6_reass(struct pbuf *p)
   if ((ip6_reass_pbufcount + clen) > IP_REASS_MAX_PBUFS) {
 #if IP_REASS_FREE_OLDEST
     ip6_reass_remove_oldest_datagram(ipr, clen);
-    if ((ip6_reass_pbufcount + clen) <= IP_REASS_MAX_PBUFS) {
-      /* re-search ipr_prev since it might have been removed */
-      for (ipr_prev = reassdatagrams; ipr_prev != NULL; ipr_prev = ipr_prev->next) {
-        if (ipr_prev->next == ipr) {
-          break;
-        }
-      }
-    } else
+    if ((ip6_reass_pbufcount + clen) > IP_REASS_MAX_PBUFS)
 #endif /* IP_REASS_FREE_OLDEST */
     {
       /* @todo: send ICMPv6 time exceeded here? */
@@ -407,119 +377,50 @@ ip6_reass(struct pbuf *p)
     }
   }
 
-  /* Overwrite Fragment Header with our own helper struct. */
-#if IPV6_FRAG_COPYHEADER
-  if (IPV6_FRAG_REQROOM > 0) {
-    /* Make room for struct ip6_reass_helper (only required if sizeof(void*) > 4).
-       This cannot fail since we already checked when receiving this fragment. */
-    u8_t hdrerr = pbuf_header_force(p, IPV6_FRAG_REQROOM);
-    LWIP_UNUSED_ARG(hdrerr); /* in case of LWIP_NOASSERT */
-    LWIP_ASSERT("no room for struct ip6_reass_helper", hdrerr == 0);
+  /* Overwrite Fragment Header with our own helper struct: make room for the
+     part of struct ip_reass_node that does not fit into the fragment header.
+     This cannot fail since we already checked when receiving this fragment. */
+  if (pbuf_header_force(p, IPV6_FRAG_REQROOM)) {
+    LWIP_ASSERT("no room for struct ip_reass_node", 0);
+    goto nullreturn;
   }
-#else /* IPV6_FRAG_COPYHEADER */
-  LWIP_ASSERT("sizeof(struct ip6_reass_helper) <= IP6_FRAG_HLEN, set IPV6_FRAG_COPYHEADER to 1",
-    sizeof(struct ip6_reass_helper) <= IP6_FRAG_HLEN);
-#endif /* IPV6_FRAG_COPYHEADER */
 
-  /* Prepare the pointer to the helper structure, and its initial values.
-   * Do not yet write to the structure itself, as we still have to make a
-   * backup of the original data, and we should not do that until we know for
-   * sure that we are going to add this packet to the list. */
-  iprh = (struct ip6_reass_helper *)p->payload;
-  next_pbuf = NULL;
-  end = (u16_t)(start + len);
-
-  /* find the right place to insert this pbuf */
-  /* Iterate through until we either get to the end of the list (append),
-   * or we find on with a larger offset (insert). */
-  for (q = ipr->p; q != NULL;) {
-    iprh_tmp = (struct ip6_reass_helper*)q->payload;
-    if (start < iprh_tmp->start) {
-#if IP_REASS_CHECK_OVERLAP
-      if (end > iprh_tmp->start) {
-        /* fragment overlaps with following, throw away */
-        IP6_FRAG_STATS_INC(ip6_frag.proterr);
-        goto nullreturn;
-      }
-      if (iprh_prev != NULL) {
-        if (start < iprh_prev->end) {
-          /* fragment overlaps with previous, throw away */
-          IP6_FRAG_STATS_INC(ip6_frag.proterr);
-          goto nullreturn;
-        }
-      }
-#endif /* IP_REASS_CHECK_OVERLAP */
-      /* Check if the fragments received so far have no gaps. */
-      if (iprh_prev != NULL) {
-        if (iprh_prev->end != start) {
-          /* There is a fragment missing between the current
-           * and the previous fragment */
-          valid = 0;
-        }
-      }
-      if (end != iprh_tmp->start) {
-        /* There is a fragment missing between the current
-         * and the following fragment */
-        valid = 0;
-      }
-      /* the new pbuf should be inserted before this */
-      next_pbuf = q;
-      if (iprh_prev != NULL) {
-        /* not the fragment with the lowest offset */
-        iprh_prev->next_pbuf = p;
-      } else {
-        /* fragment with the lowest offset */
-        ipr->p = p;
-      }
-      break;
-    } else if (start == iprh_tmp->start) {
-      /* received the same datagram twice: no need to keep the datagram */
+  /* Check the fragment against the end of the datagram, if known. */
+  if ((offset & IP6_FRAG_MORE_FLAG) == 0) {
+    if ((ipr->datagram_len != 0) && (end != ipr->datagram_len)) {
+      /* another last fragment with a different length, throw away */
+      IP6_FRAG_STATS_INC(ip6_frag.proterr);
       goto nullreturn;
+    }
 #if IP_REASS_CHECK_OVERLAP
-    } else if (start < iprh_tmp->end) {
-      /* overlap: no need to keep the new datagram */
+    if (ip_reass_tree_last_end(ipr->p) > end) {
+      /* data received beyond the end of the datagram, throw away */
       IP6_FRAG_STATS_INC(ip6_frag.proterr);
       goto nullreturn;
-#endif /* IP_REASS_CHECK_OVERLAP */
-    } else {
-      /* Check if the fragments received so far have no gaps. */
-      if (iprh_prev != NULL) {
-        if (iprh_prev->end != iprh_tmp->start) {
-          /* There is a fragment missing between the current
-           * and the previous fragment */
-          valid = 0;
-        }
-      }
     }
-    q = iprh_tmp->next_pbuf;
-    iprh_prev = iprh_tmp;
-  }
-
-  /* If q is NULL, then we made it to the end of the list. Determine what to do now */
-  if (q == NULL) {
-    if (iprh_prev != NULL) {
-      /* this is (for now), the fragment with the highest offset:
-       * chain it to the last fragment */
-#if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("check fragments don't overlap", iprh_prev->end <= start);
 #endif /* IP_REASS_CHECK_OVERLAP */
-      iprh_prev->next_pbuf = p;
-      if (iprh_prev->end != start) {
-        valid = 0;
-      }
-    } else {
+  }
 #if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("no previous fragment, this must be the first fragment!",
-        ipr->p == NULL);
+  else if ((ipr->datagram_len != 0) && (end > ipr->datagram_len)) {
+    /* fragment beyond the end of the datagram, throw away */
+    IP6_FRAG_STATS_INC(ip6_frag.proterr);
+    goto nullreturn;
+  }
 #endif /* IP_REASS_CHECK_OVERLAP */
-      /* this is the first fragment we ever received for this ip datagram */
-      ipr->p = p;
-    }
+
+  /* find the right place to insert this pbuf: duplicate (and, with
+   * IP_REASS_CHECK_OVERLAP, overlapping) fragments are thrown away.
+   * Do not yet write to the helper structure, as we still have to make a
+   * backup of the original data, and we should not do that until we know for
+   * sure that we are going to add this packet to the tree. */
+  if (!ip_reass_tree_check(&ipr->p, start, end, IP_REASS_CHECK_OVERLAP)) {
+    goto nullreturn;
   }
 
   /* Track the current number of pbufs current 'in-flight', in order to limit
   the number of fragments that may be enqueued at any one time */
   ip6_reass_pbufcount = (u16_t)(ip6_reass_pbufcount + clen);
+  ipr->pbufs = (u16_t)(ipr->pbufs + clen);
 
   /* Remember IPv6 header if this is the first fragment. */
   if (start == 0) {
@@ -527,90 +428,63 @@ ip6_reass(struct pbuf *p)
     ipr->iphdr = ip_data.current_ip6_header;
     /* Make a backup of the part of the packet data that we are about to
      * overwrite, so that we can restore the original later. */
-    MEMCPY(ipr->orig_hdr, p->payload, sizeof(*iprh));
-    /* For IPV6_FRAG_COPYHEADER there is no need to copy src/dst again, as they
-     * will be the same as they were. With LWIP_IPV6_SCOPES, the same applies
-     * to the source/destination zones. */
+    MEMCPY(ipr->orig_hdr, p->payload, sizeof(struct ip_reass_node));
+    /* There is no need to copy src/dst again, as they will be the same as
+     * they were. With LWIP_IPV6_SCOPES, the same applies to the
+     * source/destination zones. */
   }
   /* Only after the backup do we get to fill in the actual helper structure. */
-  iprh->next_pbuf = next_pbuf;
-  iprh->start = start;
-  iprh->end = end;
+  ip_reass_tree_link(&ipr->p, p, start, end);
+  ipr->received += len;
 
   /* If this is the last fragment, calculate total packet length. */
   if ((offset & IP6_FRAG_MORE_FLAG) == 0) {
-    ipr->datagram_len = iprh->end;
-  }
-
-  /* Additional validity tests: we have received first and last fragment. */
-  iprh_tmp = (struct ip6_reass_helper*)ipr->p->payload;
-  if (iprh_tmp->start != 0) {
-    valid = 0;
-  }
-  if (ipr->datagram_len == 0) {
-    valid = 0;
+    ipr->datagram_len = end;
   }
 
-  /* Final validity test: no gaps between current and last fragment. */
-  iprh_prev = iprh;
-  q = iprh->next_pbuf;
-  while ((q != NULL) && valid) {
-    iprh = (struct ip6_reass_helper*)q->payload;
-    if (iprh_prev->end != iprh->start) {
-      valid = 0;
-      break;
+  /* Validity test: we have received the last fragment and all data up to it. */
+  valid = 0;
+  if (ipr->datagram_len != 0) {
+#if IP_REASS_CHECK_OVERLAP
+    /* fragments neither overlap nor exceed the datagram */
+    valid = (ipr->received == ipr->datagram_len) ? 1 : 0;
+#else /* IP_REASS_CHECK_OVERLAP */
+    /* there might be holes since fragments may overlap: check the list */
+    if (ipr->received >= ipr->datagram_len) {
+      valid = ip_reass_tree_complete(&ipr->p, ipr->datagram_len);
     }
-    iprh_prev = iprh;
-    q = iprh->next_pbuf;
+#endif /* IP_REASS_CHECK_OVERLAP */
   }
 
   if (valid) {
     /* All fragments have been received */
     struct ip6_hdr* iphdr_ptr;
 
-    /* chain together the pbufs contained within the ip6_reassdata list. */
-    iprh = (struct ip6_reass_helper*) ipr->p->payload;
-    while (iprh != NULL) {
-      next_pbuf = iprh->next_pbuf;
-      if (next_pbuf != NULL) {
-        /* Save next helper struct (will be hidden in next step). */
-        iprh_tmp = (struct ip6_reass_helper*)next_pbuf->payload;
-
-        /* hide the fragment header for every succeeding fragment */
-        pbuf_remove_header(next_pbuf, IP6_FRAG_HLEN);
-#if IPV6_FRAG_COPYHEADER
-        if (IPV6_FRAG_REQROOM > 0) {
-          /* hide the extra bytes borrowed from ip6_hdr for struct ip6_reass_helper */
-          u8_t hdrerr = pbuf_remove_header(next_pbuf, IPV6_FRAG_REQROOM);
-          LWIP_UNUSED_ARG(hdrerr); /* in case of LWIP_NOASSERT */
-          LWIP_ASSERT("no room for struct ip6_reass_helper", hdrerr == 0);
-        }
-#endif
-        pbuf_cat(ipr->p, next_pbuf);
-      }
-      else {
-        iprh_tmp = NULL;
+    /* chain together the pbufs contained within the ip6_reassdata tree,
+     * sorted by offset. */
+    p = ip_reass_tree_to_list(&ipr->p);
+    next_pbuf = IP_REASS_NODE(p)->right;
+    while (next_pbuf != NULL) {
+      struct pbuf *q = next_pbuf;
+      /* Save next fragment (will be hidden in next step). */
+      next_pbuf = IP_REASS_NODE(q)->right;
+
+      /* hide the fragment header and the extra bytes borrowed from the
+       * preceding header for every succeeding fragment */
+      if (pbuf_remove_header(q, sizeof(struct ip_reass_node))) {
+        LWIP_ASSERT("no room for struct ip_reass_node", 0);
       }
-
-      iprh = iprh_tmp;
+      pbuf_cat(p, q);
     }
 
-    /* Get the first pbuf. */
-    p = ipr->p;
-
-#if IPV6_FRAG_COPYHEADER
-    if (IPV6_FRAG_REQROOM > 0) {
-      u8_t hdrerr;
-      /* Restore (only) the bytes that we overwrote beyond the fragment header.
-       * Those bytes may belong to either the IPv6 header or an extension
-       * header placed before the fragment header. */
-      MEMCPY(p->payload, ipr->orig_hdr, IPV6_FRAG_REQROOM);
-      /* get back room for struct ip6_reass_helper (only required if sizeof(void*) > 4) */
-      hdrerr = pbuf_remove_header(p, IPV6_FRAG_REQROOM);
-      LWIP_UNUSED_ARG(hdrerr); /* in case of LWIP_NOASSERT */
-      LWIP_ASSERT("no room for struct ip6_reass_helper", hdrerr == 0);
+    /* Restore (only) the bytes that we overwrote beyond the fragment header.
+     * Those bytes may belong to either the IPv6 header or an extension
+     * header placed before the fragment header. */
+    MEMCPY(p->payload, ipr->orig_hdr, IPV6_FRAG_REQROOM);
+    /* get back room for struct ip_reass_node */
+    if (pbuf_remove_header(p, IPV6_FRAG_REQROOM)) {
+      LWIP_ASSERT("no room for struct ip_reass_node", 0);
     }
-#endif
 
     /* We need to get rid of the fragment header itself, which is somewhere in
      * the middle of the packet (but still in the first pbuf of the chain).
@@ -650,15 +524,7 @@ ip6_reass(struct pbuf *p)
     }
 
     /* release the resources allocated for the fragment queue entry */
-    if (reassdatagrams == ipr) {
-      /* it was the first in the list */
-      reassdatagrams = ipr->next;
-    } else {
-      /* it wasn't the first, so it must have a valid 'prev' */
-      LWIP_ASSERT("sanity check linked list", ipr_prev != NULL);
-      ipr_prev->next = ipr->next;
-    }
-    memp_free(MEMP_IP6_REASSDATA, ipr);
+    ip6_reass_dequeue_datagram(ipr);
 
     /* adjust the number of pbufs currently queued for reassembly. */
     clen = pbuf_clen(p);
@@ -762,6 +628,14 @@ ip6_frag(struct pbuf *p, struct netif *netif, const ip6_addr_t *dest)
 
   while (left) {
     last = (left <= nfb);
+#if LWIP_NETIF_FRAG_OFFLOAD
+    if (NETIF_FRAG_OFFLOAD_ENABLED(netif, NETIF_FRAG_OFFLOAD_IP6)) {
+      /* the netif splits the packet: create one (atomic) fragment holding all
+         data, its headers are the template for all fragments (see
+         ip_frag_offload_hdr()) */
+      last = 1;
+    }
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
 
     /* Fill this fragment */
     cop = last ? left : nfb;
@@ -855,6 +729,12 @@ ip6_frag(struct pbuf *p, struct netif *netif, const ip6_addr_t *dest)
     IP6H_NEXTH_SET(ip6hdr, IP6_NEXTH_FRAGMENT);
     IP6H_PLEN_SET(ip6hdr, (u16_t)(cop + IP6_FRAG_HLEN));
 
+#if LWIP_NETIF_FRAG_OFFLOAD
+    if (NETIF_FRAG_OFFLOAD_ENABLED(netif, NETIF_FRAG_OFFLOAD_IP6)) {
+      rambuf->frag_size = nfb;
+    }
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
+
     /* No need for separate header pbuf - we allowed room for it in rambuf
      * when allocated.
      */
@@ -66,6 +66,7 @@
 #include "lwip/netif.h"
 #include "lwip/memp.h"
 #include "lwip/stats.h"
+#include "lwip/priv/hash_priv.h"
 
 #include <string.h>
 
@@ -85,6 +86,63 @@ static struct mld_group *mld6_new_group(struct netif *ifp, const ip6_addr_t *add
 static err_t mld6_remove_group(struct netif *netif, struct mld_group *group);
 static void mld6_delayed_report(struct mld_group *group, u16_t maxresp);
 static void mld6_send(struct netif *netif, struct mld_group *group, u8_t type);
+static void mld6_start_member(struct netif *netif, struct mld_group *group);
+static void mld6_stop_member(struct netif *netif, struct mld_group *group);
+
+#if MLD6_GROUP_HASH_SIZE
+#if (MLD6_GROUP_HASH_SIZE & (MLD6_GROUP_HASH_SIZE - 1)) != 0
+#error "MLD6_GROUP_HASH_SIZE must be a power of 2"
+#endif
+
+/** The groups joined on all netifs, hashed by address and netif */
+static struct mld_group *mld6_group_hash[MLD6_GROUP_HASH_SIZE];
+
+/** Bucket of a group address joined on the netif with index netif_idx */
+static u16_t
+mld6_group_hash_idx(const ip6_addr_t *addr, u8_t netif_idx)
+{
+  /* groups used side by side mostly differ in the group ID (last 32 bits) */
+  u32_t h = lwip_ntohl(addr->addr[3]) ^ lwip_ntohl(addr->addr[0]);
+  h += netif_idx;
+  return LWIP_HASH_BUCKET(h, MLD6_GROUP_HASH_SIZE);
+}
+
+static void
+mld6_group_hash_add(struct netif *netif, struct mld_group *group)
+{
+  u16_t idx;
+
+  group->netif_idx = netif_get_index(netif);
+  idx = mld6_group_hash_idx(&group->group_address, group->netif_idx);
+  group->hash_next = mld6_group_hash[idx];
+  mld6_group_hash[idx] = group;
+}
+
+static void
+mld6_group_hash_remove(struct mld_group *group)
+{
+  struct mld_group **link = &mld6_group_hash[mld6_group_hash_idx(&group->group_address, group->netif_idx)];
+
+  for (; *link != NULL; link = &(*link)->hash_next) {
+    if (*link == group) {
+      *link = group->hash_next;
+      break;
+    }
+  }
+}
+#endif /* MLD6_GROUP_HASH_SIZE */
+
+#if LWIP_MLD6_SOURCE_FILTER
+static void
+mld6_free_sources(struct mld_group *group)
+{
+  while (group->sources != NULL) {
+    struct mld_source *next = group->sources->next;
+    memp_free(MEMP_MLD6_SOURCE, group->sources);
+    group->sources = next;
+  }
+}
+#endif /* LWIP_MLD6_SOURCE_FILTER */
 
 
 /**
@@ -107,6 +165,12 @@ mld6_stop(struct netif *netif)
       netif->mld_mac_filter(netif, &(group->group_address), NETIF_DEL_MAC_FILTER);
     }
 
+#if MLD6_GROUP_HASH_SIZE
+    mld6_group_hash_remove(group);
+#endif /* MLD6_GROUP_HASH_SIZE */
+#if LWIP_MLD6_SOURCE_FILTER
+    mld6_free_sources(group);
+#endif /* LWIP_MLD6_SOURCE_FILTER */
     /* free group */
     memp_free(MEMP_MLD6_GROUP, group);
 
@@ -143,6 +207,17 @@ mld6_report_groups(struct netif *netif)
 struct mld_group *
 mld6_lookfor_group(struct netif *ifp, const ip6_addr_t *addr)
 {
+#if MLD6_GROUP_HASH_SIZE
+  u8_t netif_idx = netif_get_index(ifp);
+  struct mld_group *group = mld6_group_hash[mld6_group_hash_idx(addr, netif_idx)];
+
+  while (group != NULL) {
+    if ((group->netif_idx == netif_idx) && ip6_addr_eq(&(group->group_address), addr)) {
+      return group;
+    }
+    group = group->hash_next;
+  }
+#else /* MLD6_GROUP_HASH_SIZE */
   struct mld_group *group = netif_mld6_data(ifp);
 
   while (group != NULL) {
@@ -151,6 +226,7 @@ mld6_lookfor_group(struct netif *ifp, const ip6_addr_t *addr)
     }
     group = group->next;
   }
+#endif /* MLD6_GROUP_HASH_SIZE */
 
   return NULL;
 }
@@ -177,6 +253,12 @@ mld6_new_group(struct netif *ifp, const ip6_addr_t *addr)
     group->last_reporter_flag = 0;
     group->use                = 0;
     group->next               = netif_mld6_data(ifp);
+#if LWIP_MLD6_SOURCE_FILTER
+    group->sources            = NULL;
+#endif /* LWIP_MLD6_SOURCE_FILTER */
+#if MLD6_GROUP_HASH_SIZE
+    mld6_group_hash_add(ifp, group);
+#endif /* MLD6_GROUP_HASH_SIZE */
 
     netif_set_client_data(ifp, LWIP_NETIF_CLIENT_DATA_INDEX_MLD6, group);
   }
@@ -212,6 +294,11 @@ mld6_remove_group(struct netif *netif, struct mld_group *group)
       err = ERR_ARG;
     }
   }
+#if MLD6_GROUP_HASH_SIZE
+  if (err == ERR_OK) {
+    mld6_group_hash_remove(group);
+  }
+#endif /* MLD6_GROUP_HASH_SIZE */
 
   return err;
 }
@@ -296,6 +383,55 @@ mld6_input(struct pbuf *p, struct netif *inp)
   pbuf_free(p);
 }
 
+/**
+ * Start the membership of a new group: activate it on the MAC layer and
+ * report it.
+ *
+ * @param netif the network interface the group is joined on
+ * @param group the new group
+ */
+static void
+mld6_start_member(struct netif *netif, struct mld_group *group)
+{
+  /* Activate this address on the MAC layer. */
+  if (netif->mld_mac_filter != NULL) {
+    netif->mld_mac_filter(netif, &group->group_address, NETIF_ADD_MAC_FILTER);
+  }
+
+  /* Report our membership. */
+  MLD6_STATS_INC(mld6.tx_report);
+  mld6_send(netif, group, ICMP6_TYPE_MLR);
+  mld6_delayed_report(group, MLD6_JOIN_DELAYING_MEMBER_TMR_MS);
+}
+
+/**
+ * End the membership of a group that is no longer used: remove it from the
+ * netif's list, send a done message if necessary and free it.
+ *
+ * @param netif the network interface the group is joined on
+ * @param group the group to leave
+ */
+static void
+mld6_stop_member(struct netif *netif, struct mld_group *group)
+{
+  /* Remove the group from the list */
+  mld6_remove_group(netif, group);
+
+  /* If we are the last reporter for this group */
+  if (group->last_reporter_flag) {
+    MLD6_STATS_INC(mld6.tx_leave);
+    mld6_send(netif, group, ICMP6_TYPE_MLD);
+  }
+
+  /* Disable the group at the MAC level */
+  if (netif->mld_mac_filter != NULL) {
+    netif->mld_mac_filter(netif, &group->group_address, NETIF_DEL_MAC_FILTER);
+  }
+
+  /* free group struct */
+  memp_free(MEMP_MLD6_GROUP, group);
+}
+
 /**
  * @ingroup mld6
  * Join a group on one or all network interfaces.
@@ -371,16 +507,7 @@ mld6_joingroup_netif(struct netif *netif, const ip6_addr_t *groupaddr)
     if (group == NULL) {
       return ERR_MEM;
     }
-
-    /* Activate this address on the MAC layer. */
-    if (netif->mld_mac_filter != NULL) {
-      netif->mld_mac_filter(netif, groupaddr, NETIF_ADD_MAC_FILTER);
-    }
-
-    /* Report our membership. */
-    MLD6_STATS_INC(mld6.tx_report);
-    mld6_send(netif, group, ICMP6_TYPE_MLR);
-    mld6_delayed_report(group, MLD6_JOIN_DELAYING_MEMBER_TMR_MS);
+    mld6_start_member(netif, group);
   }
 
   /* Increment group use */
@@ -454,24 +581,20 @@ mld6_leavegroup_netif(struct netif *netif, const ip6_addr_t *groupaddr)
   group = mld6_lookfor_group(netif, groupaddr);
 
   if (group != NULL) {
+#if LWIP_MLD6_SOURCE_FILTER
+    if (group->use == 0) {
+      /* only joined for specific sources */
+      return ERR_VAL;
+    }
+    if (group->sources != NULL) {
+      /* still joined for specific sources */
+      group->use--;
+      return ERR_OK;
+    }
+#endif /* LWIP_MLD6_SOURCE_FILTER */
     /* Leave if there is no other use of the group */
     if (group->use <= 1) {
-      /* Remove the group from the list */
-      mld6_remove_group(netif, group);
-
-      /* If we are the last reporter for this group */
-      if (group->last_reporter_flag) {
-        MLD6_STATS_INC(mld6.tx_leave);
-        mld6_send(netif, group, ICMP6_TYPE_MLD);
-      }
-
-      /* Disable the group at the MAC level */
-      if (netif->mld_mac_filter != NULL) {
-        netif->mld_mac_filter(netif, groupaddr, NETIF_DEL_MAC_FILTER);
-      }
-
-      /* free group struct */
-      memp_free(MEMP_MLD6_GROUP, group);
+      mld6_stop_member(netif, group);
     } else {
       /* Decrement group use */
       group->use--;
@@ -486,6 +609,156 @@ mld6_leavegroup_netif(struct netif *netif, const ip6_addr_t *groupaddr)
 }
 
 
+#if LWIP_MLD6_SOURCE_FILTER
+/**
+ * @ingroup mld6
+ * Join a group for one source on a network interface (source-specific
+ * multicast, RFC 4607). Packets to the group are only received from the
+ * sources joined like this, unless the group is also joined for any source
+ * with mld6_joingroup_netif().
+ *
+ * The membership is reported with MLDv1, which cannot carry sources, so the
+ * group is received from all sources and filtered by this host.
+ *
+ * @param netif the network interface which should join the group
+ * @param groupaddr the ipv6 address of the group to join (possibly but not
+ *                  necessarily zoned)
+ * @param srcaddr the unicast ipv6 address of the source to receive from
+ * @return ERR_OK if the group was joined for the source, an err_t otherwise
+ */
+err_t
+mld6_joingroup_source_netif(struct netif *netif, const ip6_addr_t *groupaddr, const ip6_addr_t *srcaddr)
+{
+  struct mld_group *group;
+  struct mld_source *src;
+#if LWIP_IPV6_SCOPES
+  ip6_addr_t ip6addr;
+
+  if (ip6_addr_lacks_zone(groupaddr, IP6_MULTICAST)) {
+    ip6_addr_set(&ip6addr, groupaddr);
+    ip6_addr_assign_zone(&ip6addr, IP6_MULTICAST, netif);
+    groupaddr = &ip6addr;
+  }
+  IP6_ADDR_ZONECHECK_NETIF(groupaddr, netif);
+#endif /* LWIP_IPV6_SCOPES */
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("mld6_joingroup_source_netif: invalid source address",
+             (srcaddr != NULL) && !ip6_addr_isany(srcaddr) && !ip6_addr_ismulticast(srcaddr), return ERR_VAL;);
+
+  group = mld6_lookfor_group(netif, groupaddr);
+  if (group != NULL) {
+    for (src = group->sources; src != NULL; src = src->next) {
+      if (ip6_addr_zoneless_eq(&src->source_address, srcaddr)) {
+        src->use++;
+        return ERR_OK;
+      }
+    }
+  }
+  src = (struct mld_source *)memp_malloc(MEMP_MLD6_SOURCE);
+  if (src == NULL) {
+    return ERR_MEM;
+  }
+  if (group == NULL) {
+    /* Joining a new group. Create a new group entry. */
+    group = mld6_new_group(netif, groupaddr);
+    if (group == NULL) {
+      memp_free(MEMP_MLD6_SOURCE, src);
+      return ERR_MEM;
+    }
+    mld6_start_member(netif, group);
+  }
+  ip6_addr_copy(src->source_address, *srcaddr);
+  src->use = 1;
+  src->next = group->sources;
+  group->sources = src;
+  return ERR_OK;
+}
+
+/**
+ * @ingroup mld6
+ * Leave a group for one source on a network interface.
+ *
+ * @param netif the network interface which should leave the group
+ * @param groupaddr the ipv6 address of the group to leave (possibly, but not
+ *                  necessarily zoned)
+ * @param srcaddr the ipv6 address of the source joined with
+ *        mld6_joingroup_source_netif()
+ * @return ERR_OK if the source was left, an err_t otherwise
+ */
+err_t
+mld6_leavegroup_source_netif(struct netif *netif, const ip6_addr_t *groupaddr, const ip6_addr_t *srcaddr)
+{
+  struct mld_group *group;
+  struct mld_source **link;
+  struct mld_source *src;
+#if LWIP_IPV6_SCOPES
+  ip6_addr_t ip6addr;
+
+  if (ip6_addr_lacks_zone(groupaddr, IP6_MULTICAST)) {
+    ip6_addr_set(&ip6addr, groupaddr);
+    ip6_addr_assign_zone(&ip6addr, IP6_MULTICAST, netif);
+    groupaddr = &ip6addr;
+  }
+  IP6_ADDR_ZONECHECK_NETIF(groupaddr, netif);
+#endif /* LWIP_IPV6_SCOPES */
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("mld6_leavegroup_source_netif: invalid source address", srcaddr != NULL, return ERR_VAL;);
+
+  group = mld6_lookfor_group(netif, groupaddr);
+  if (group == NULL) {
+    return ERR_VAL;
+  }
+  for (link = &group->sources; *link != NULL; link = &(*link)->next) {
+    if (ip6_addr_zoneless_eq(&(*link)->source_address, srcaddr)) {
+      break;
+    }
+  }
+  src = *link;
+  if (src == NULL) {
+    return ERR_VAL;
+  }
+  if (src->use > 1) {
+    src->use--;
+    return ERR_OK;
+  }
+  *link = src->next;
+  memp_free(MEMP_MLD6_SOURCE, src);
+
+  if ((group->use == 0) && (group->sources == NULL)) {
+    mld6_stop_member(netif, group);
+  }
+  return ERR_OK;
+}
+
+/**
+ * Check if packets to a group from a source are received, i.e. if the group
+ * is joined for any source or for this source. Called by ip6_input().
+ *
+ * @param group a group joined on the input netif
+ * @param srcaddr source address of the packet
+ * @return 1 if the packet is accepted, 0 otherwise
+ */
+u8_t
+mld6_group_accepts_source(const struct mld_group *group, const ip6_addr_t *srcaddr)
+{
+  const struct mld_source *src;
+
+  if (group->use > 0) {
+    return 1;
+  }
+  for (src = group->sources; src != NULL; src = src->next) {
+    if (ip6_addr_zoneless_eq(&src->source_address, srcaddr)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+#endif /* LWIP_MLD6_SOURCE_FILTER */
+
 /**
  * Periodic timer for mld processing. Must be called every
  * MLD6_TMR_INTERVAL milliseconds (100).
@@ -47,6 +47,7 @@
 
 #include "lwip/nd6.h"
 #include "lwip/priv/nd6_priv.h"
+#include "lwip/priv/hash_priv.h"
 #include "lwip/prot/nd6.h"
 #include "lwip/prot/icmp6.h"
 #include "lwip/pbuf.h"
@@ -54,6 +55,7 @@
 #include "lwip/memp.h"
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
+#include "lwip/ip6_fib.h"
 #include "lwip/inet_chksum.h"
 #include "lwip/netif.h"
 #include "lwip/icmp6.h"
@@ -62,6 +64,8 @@
 #include "lwip/ip.h"
 #include "lwip/stats.h"
 #include "lwip/dns.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/prot/tcp.h"
 
 #include <string.h>
 
@@ -72,12 +76,15 @@
 #if LWIP_IPV6_DUP_DETECT_ATTEMPTS > IP6_ADDR_TENTATIVE_COUNT_MASK
 #error LWIP_IPV6_DUP_DETECT_ATTEMPTS > IP6_ADDR_TENTATIVE_COUNT_MASK
 #endif
-#if LWIP_ND6_NUM_NEIGHBORS > 127
-#error LWIP_ND6_NUM_NEIGHBORS must fit into an s8_t (max value: 127)
+#if LWIP_ND6_NUM_NEIGHBORS > 32767
+#error LWIP_ND6_NUM_NEIGHBORS must fit into an s16_t (max value: 32767)
 #endif
 #if LWIP_ND6_NUM_DESTINATIONS > 32767
 #error LWIP_ND6_NUM_DESTINATIONS must fit into an s16_t (max value: 32767)
 #endif
+#if LWIP_ND6_CACHE_HASH && ((LWIP_ND6_CACHE_HASH_SIZE & (LWIP_ND6_CACHE_HASH_SIZE - 1)) != 0)
+#error LWIP_ND6_CACHE_HASH_SIZE must be a power of 2
+#endif
 #if LWIP_ND6_NUM_PREFIXES > 127
 #error LWIP_ND6_NUM_PREFIXES must fit into an s8_t (max value: 127)
 #endif
@@ -102,6 +109,41 @@ static u8_t nd6_queue_size = 0;
 /* Index for cache entries. */
 static netif_addr_idx_t nd6_cached_destination_index;
 
+#if LWIP_ND6_CACHE_HASH
+#define ND6_LINK_NONE       LWIP_HASH_LINK_NONE
+#define ND6_LINK(i)         LWIP_HASH_LINK(u16_t, i)
+#define ND6_LINK_IDX(link)  LWIP_HASH_LINK_IDX(link)
+
+/** Number of slots of the neighbor timer wheel (power of 2), i.e. the
+ * number of nd6_tmr() ticks after which a slot is visited again */
+#define ND6_WHEEL_SIZE      64
+/** Timer list of STALE neighbors (they have no timer), oldest at the tail */
+#define ND6_LIST_STALE      ND6_WHEEL_SIZE
+/** Timer list of neighbors whose timer is being processed by nd6_tmr() */
+#define ND6_LIST_DUE        (ND6_WHEEL_SIZE + 1)
+#define ND6_NUM_LISTS       (ND6_WHEEL_SIZE + 2)
+/** timer_list of a neighbor that is on no timer list */
+#define ND6_LIST_NONE       0xFFFF
+
+static u16_t nd6_neighbor_hash[LWIP_ND6_CACHE_HASH_SIZE];
+/** Neighbor entries freed after use, linked via hash_next */
+static u16_t nd6_neighbor_free;
+/** Number of neighbor entries that have been taken into use so far */
+static s16_t nd6_neighbors_used;
+static u16_t nd6_timer_head[ND6_NUM_LISTS];
+static u16_t nd6_timer_tail[ND6_NUM_LISTS];
+/** Number of nd6_tmr() calls so far */
+static u32_t nd6_ticks;
+
+static u16_t nd6_destination_hash[LWIP_ND6_CACHE_HASH_SIZE];
+/** Destination entries freed after use, linked via hash_next */
+static u16_t nd6_destination_free;
+/** Number of destination entries that have been taken into use so far */
+static s16_t nd6_destinations_used;
+/** Destination entries, most recently used first */
+static u16_t nd6_destination_lru_head, nd6_destination_lru_tail;
+#endif /* LWIP_ND6_CACHE_HASH */
+
 /* Multicast address holder. */
 static ip6_addr_t multicast_address;
 
@@ -119,19 +161,20 @@ union ra_options {
 static union ra_options nd6_ra_buffer;
 
 /* Forward declarations. */
-static s8_t nd6_find_neighbor_cache_entry(const ip6_addr_t *ip6addr);
-static s8_t nd6_new_neighbor_cache_entry(void);
-static void nd6_free_neighbor_cache_entry(s8_t i);
+static s16_t nd6_find_neighbor_cache_entry(const ip6_addr_t *ip6addr);
+static s16_t nd6_new_neighbor_cache_entry(const ip6_addr_t *ip6addr);
+static void nd6_free_neighbor_cache_entry(s16_t i);
 static s16_t nd6_find_destination_cache_entry(const ip6_addr_t *ip6addr);
-static s16_t nd6_new_destination_cache_entry(void);
+static s16_t nd6_new_destination_cache_entry(const ip6_addr_t *ip6addr);
+static void nd6_free_destination_cache_entry(s16_t i);
 static int nd6_is_prefix_in_netif(const ip6_addr_t *ip6addr, struct netif *netif);
 static s8_t nd6_select_router(const ip6_addr_t *ip6addr, struct netif *netif);
 static s8_t nd6_get_router(const ip6_addr_t *router_addr, struct netif *netif);
 static s8_t nd6_new_router(const ip6_addr_t *router_addr, struct netif *netif);
 static s8_t nd6_get_onlink_prefix(const ip6_addr_t *prefix, struct netif *netif);
 static s8_t nd6_new_onlink_prefix(const ip6_addr_t *prefix, struct netif *netif);
-static s8_t nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif);
-static err_t nd6_queue_packet(s8_t neighbor_index, struct pbuf *q);
+static s16_t nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif);
+static err_t nd6_queue_packet(s16_t neighbor_index, struct pbuf *q);
 
 #define ND6_SEND_FLAG_MULTICAST_DEST 0x01
 #define ND6_SEND_FLAG_ALLNODES_DEST 0x02
@@ -148,7 +191,17 @@ static void nd6_free_q(struct nd6_q_entry *q);
 #else /* LWIP_ND6_QUEUEING */
 #define nd6_free_q(q) pbuf_free(q)
 #endif /* LWIP_ND6_QUEUEING */
-static void nd6_send_q(s8_t i);
+static void nd6_send_q(s16_t i);
+
+#if LWIP_ND6_CACHE_HASH
+static void nd6_timer_unlink(s16_t i);
+static void nd6_timer_push(s16_t i, u16_t list);
+static void nd6_neighbor_timer_update(s16_t i);
+static void nd6_neighbor_timeout(s16_t i);
+#define ND6_NEIGHBOR_TIMER_UPDATE(i) nd6_neighbor_timer_update(i)
+#else /* LWIP_ND6_CACHE_HASH */
+#define ND6_NEIGHBOR_TIMER_UPDATE(i)
+#endif /* LWIP_ND6_CACHE_HASH */
 
 
 /**
@@ -342,7 +395,7 @@ void
 nd6_input(struct pbuf *p, struct netif *inp)
 {
   u8_t msg_type;
-  s8_t i;
+  s16_t i;
   s16_t dest_idx;
 
   ND6_STATS_INC(nd6.recv);
@@ -452,6 +505,7 @@ nd6_input(struct pbuf *p, struct netif *inp)
       neighbor_cache[i].netif = inp;
       neighbor_cache[i].state = ND6_REACHABLE;
       neighbor_cache[i].counter.reachable_time = reachable_time;
+      ND6_NEIGHBOR_TIMER_UPDATE(i);
 
       /* Send queued packets, if any. */
       if (neighbor_cache[i].q != NULL) {
@@ -553,12 +607,13 @@ nd6_input(struct pbuf *p, struct netif *inp)
           /* Delay probe in case we get confirmation of reachability from upper layer (TCP). */
           neighbor_cache[i].state = ND6_DELAY;
           neighbor_cache[i].counter.delay_time = LWIP_ND6_DELAY_FIRST_PROBE_TIME / ND6_TMR_INTERVAL;
+          ND6_NEIGHBOR_TIMER_UPDATE(i);
         }
       } else {
         /* Add their IPv6 address and link-layer address to neighbor cache.
          * We will need it at least to send a unicast NA message, but most
          * likely we will also be communicating with this node soon. */
-        i = nd6_new_neighbor_cache_entry();
+        i = nd6_new_neighbor_cache_entry(ip6_current_src_addr());
         if (i < 0) {
           /* We couldn't assign a cache entry for this neighbor.
            * we won't be able to reply. drop it. */
@@ -568,12 +623,12 @@ nd6_input(struct pbuf *p, struct netif *inp)
         }
         neighbor_cache[i].netif = inp;
         nd6_store_neighbor_lladdr(&neighbor_cache[i], lladdr_opt, inp);
-        ip6_addr_set(&(neighbor_cache[i].next_hop_address), ip6_current_src_addr());
 
         /* Receiving a message does not prove reachability: only in one direction.
          * Delay probe in case we get confirmation of reachability from upper layer (TCP). */
         neighbor_cache[i].state = ND6_DELAY;
         neighbor_cache[i].counter.delay_time = LWIP_ND6_DELAY_FIRST_PROBE_TIME / ND6_TMR_INTERVAL;
+        ND6_NEIGHBOR_TIMER_UPDATE(i);
       }
 
       /* Send back a NA for us. Allocate the reply pbuf. */
@@ -641,6 +696,15 @@ nd6_input(struct pbuf *p, struct netif *inp)
 
     /* Re-set invalidation timer. */
     default_router_list[i].invalidation_timer = lwip_htons(ra_hdr->router_lifetime);
+#if LWIP_IPV6_FIB
+    if (ra_hdr->router_lifetime != 0) {
+      if (ip6_fib_add_ra(IP6_ADDR_ANY6, 0, ip6_current_src_addr(), inp) != ERR_OK) {
+        ND6_STATS_INC(nd6.memerr);
+      }
+    } else {
+      ip6_fib_remove_ra(IP6_ADDR_ANY6, 0, ip6_current_src_addr(), inp);
+    }
+#endif /* LWIP_IPV6_FIB */
 
     /* Re-set default timer values. */
 #if LWIP_ND6_ALLOW_RA_UPDATES
@@ -712,6 +776,7 @@ nd6_input(struct pbuf *p, struct netif *inp)
           nd6_store_neighbor_lladdr(default_router_list[i].neighbor_entry, lladdr_opt, inp);
           default_router_list[i].neighbor_entry->state = ND6_REACHABLE;
           default_router_list[i].neighbor_entry->counter.reachable_time = reachable_time;
+          ND6_NEIGHBOR_TIMER_UPDATE((s16_t)(default_router_list[i].neighbor_entry - neighbor_cache));
         }
         break;
       }
@@ -767,6 +832,15 @@ nd6_input(struct pbuf *p, struct netif *inp)
             }
             if (prefix >= 0) {
               prefix_list[prefix].invalidation_timer = valid_life;
+#if LWIP_IPV6_FIB
+              if (valid_life > 0) {
+                if (ip6_fib_add_ra(&prefix_addr, 64, NULL, inp) != ERR_OK) {
+                  ND6_STATS_INC(nd6.memerr);
+                }
+              } else {
+                ip6_fib_remove_ra(&prefix_addr, 64, NULL, inp);
+              }
+#endif /* LWIP_IPV6_FIB */
             }
           }
 #if LWIP_IPV6_AUTOCONFIG
@@ -892,16 +966,16 @@ nd6_input(struct pbuf *p, struct netif *inp)
     if (lladdr_opt != NULL) {
       i = nd6_find_neighbor_cache_entry(&target_address);
       if (i < 0) {
-        i = nd6_new_neighbor_cache_entry();
+        i = nd6_new_neighbor_cache_entry(&target_address);
         if (i >= 0) {
           neighbor_cache[i].netif = inp;
           nd6_store_neighbor_lladdr(&neighbor_cache[i], lladdr_opt, inp);
-          ip6_addr_copy(neighbor_cache[i].next_hop_address, target_address);
 
           /* Receiving a message does not prove reachability: only in one direction.
             * Delay probe in case we get confirmation of reachability from upper layer (TCP). */
           neighbor_cache[i].state = ND6_DELAY;
           neighbor_cache[i].counter.delay_time = LWIP_ND6_DELAY_FIRST_PROBE_TIME / ND6_TMR_INTERVAL;
+          ND6_NEIGHBOR_TIMER_UPDATE(i);
         }
       }
       if (i >= 0) {
@@ -911,6 +985,7 @@ nd6_input(struct pbuf *p, struct netif *inp)
             * Delay probe in case we get confirmation of reachability from upper layer (TCP). */
           neighbor_cache[i].state = ND6_DELAY;
           neighbor_cache[i].counter.delay_time = LWIP_ND6_DELAY_FIRST_PROBE_TIME / ND6_TMR_INTERVAL;
+          ND6_NEIGHBOR_TIMER_UPDATE(i);
         }
       }
     }
@@ -947,9 +1022,33 @@ nd6_input(struct pbuf *p, struct netif *inp)
       return;
     }
 
-    /* Change the Path MTU. */
+    /* Change the Path MTU. It is never raised by this message and never drops
+       below the minimum IPv6 MTU (RFC 8201). */
     pmtu = lwip_htonl(icmp6hdr->data);
-    destination_cache[dest_idx].pmtu = (u16_t)LWIP_MIN(pmtu, 0xFFFF);
+    pmtu = LWIP_MAX(pmtu, IP6_MIN_MTU_LENGTH);
+    if ((destination_cache[dest_idx].pmtu == 0) || (pmtu < destination_cache[dest_idx].pmtu)) {
+      destination_cache[dest_idx].pmtu = (u16_t)LWIP_MIN(pmtu, 0xFFFF);
+    }
+
+#if LWIP_TCP && TCP_CALCULATE_EFF_SEND_MSS
+    if ((IP6H_NEXTH(ip6hdr) == IP6_NEXTH_TCP) &&
+        (p->len >= sizeof(struct icmp6_hdr) + IP6_HLEN + 8)) {
+      /* Let TCP reduce the MSS of the connection that sent the packet. The
+         first 8 bytes of the segment contain its ports and sequence number. */
+      const struct tcp_hdr *tcphdr = (const struct tcp_hdr *)((const u8_t *)ip6hdr + IP6_HLEN);
+      struct tcp_pcb *pcb;
+      ip_addr_t local_ip, remote_ip;
+
+      ip_addr_copy_from_ip6_packed(local_ip, ip6hdr->src);
+      ip6_addr_assign_zone(ip_2_ip6(&local_ip), IP6_UNKNOWN, inp);
+      ip_addr_copy_from_ip6(remote_ip, destination_address);
+      pcb = tcp_pmtu_lookup(&local_ip, &remote_ip, lwip_ntohs(tcphdr->src), lwip_ntohs(tcphdr->dest),
+                            lwip_ntohl(tcphdr->seqno));
+      if (pcb != NULL) {
+        tcp_pmtu_update(pcb);
+      }
+    }
+#endif /* LWIP_TCP && TCP_CALCULATE_EFF_SEND_MSS */
 
     break; /* ICMP6_TYPE_PTB */
   }
@@ -982,8 +1081,30 @@ lenerr_drop_free_return:
 void
 nd6_tmr(void)
 {
-  s8_t i;
+  s16_t i;
   struct netif *netif;
+#if LWIP_ND6_CACHE_HASH
+  u16_t link;
+
+  /* Process the neighbor entries whose timer expires now. Move them to the
+   * due list first: processing one may send packets and so change others. */
+  nd6_ticks++;
+  link = nd6_timer_head[nd6_ticks & (ND6_WHEEL_SIZE - 1)];
+  while (link != ND6_LINK_NONE) {
+    i = ND6_LINK_IDX(link);
+    link = neighbor_cache[i].timer_next;
+    if (neighbor_cache[i].timer_expire == nd6_ticks) {
+      nd6_timer_unlink(i);
+      nd6_timer_push(i, ND6_LIST_DUE);
+    }
+  }
+  while (nd6_timer_head[ND6_LIST_DUE] != ND6_LINK_NONE) {
+    i = ND6_LINK_IDX(nd6_timer_head[ND6_LIST_DUE]);
+    nd6_timer_unlink(i);
+    nd6_neighbor_timeout(i);
+  }
+  /* Destination entries are recycled in LRU order and don't need to age. */
+#else /* LWIP_ND6_CACHE_HASH */
 
   /* Process neighbor entries. */
   for (i = 0; i < LWIP_ND6_NUM_NEIGHBORS; i++) {
@@ -1046,6 +1167,7 @@ nd6_tmr(void)
   for (i = 0; i < LWIP_ND6_NUM_DESTINATIONS; i++) {
     destination_cache[i].age++;
   }
+#endif /* LWIP_ND6_CACHE_HASH */
 
   /* Process router entries. */
   for (i = 0; i < LWIP_ND6_NUM_ROUTERS; i++) {
@@ -1054,13 +1176,17 @@ nd6_tmr(void)
       if (default_router_list[i].invalidation_timer <= ND6_TMR_INTERVAL / 1000) {
         /* No more than 1 second remaining. Clear this entry. Also clear any of
          * its destination cache entries, as per RFC 4861 Sec. 5.3 and 6.3.5. */
-        s8_t j;
+        s16_t j;
         for (j = 0; j < LWIP_ND6_NUM_DESTINATIONS; j++) {
           if (ip6_addr_eq(&destination_cache[j].next_hop_addr,
                &default_router_list[i].neighbor_entry->next_hop_address)) {
-             ip6_addr_set_any(&destination_cache[j].destination_addr);
+             nd6_free_destination_cache_entry(j);
           }
         }
+#if LWIP_IPV6_FIB
+        ip6_fib_remove_ra(IP6_ADDR_ANY6, 0, &default_router_list[i].neighbor_entry->next_hop_address,
+                          default_router_list[i].neighbor_entry->netif);
+#endif /* LWIP_IPV6_FIB */
         default_router_list[i].neighbor_entry->isrouter = 0;
         default_router_list[i].neighbor_entry = NULL;
         default_router_list[i].invalidation_timer = 0;
@@ -1076,6 +1202,9 @@ nd6_tmr(void)
     if (prefix_list[i].netif != NULL) {
       if (prefix_list[i].invalidation_timer <= ND6_TMR_INTERVAL / 1000) {
         /* Entry timed out, remove it */
+#if LWIP_IPV6_FIB
+        ip6_fib_remove_ra(&prefix_list[i].prefix, 64, NULL, prefix_list[i].netif);
+#endif /* LWIP_IPV6_FIB */
         prefix_list[i].invalidation_timer = 0;
         prefix_list[i].netif = NULL;
       } else {
@@ -1426,6 +1555,187 @@ nd6_send_rs(struct netif *netif)
 }
 #endif /* LWIP_IPV6_SEND_ROUTER_SOLICIT */
 
+#if LWIP_ND6_CACHE_HASH
+/** Hash bucket of an address (the zone is not hashed) */
+static u16_t
+nd6_hash(const ip6_addr_t *ip6addr)
+{
+  u32_t h = ip6addr->addr[0] ^ ip6addr->addr[1] ^ ip6addr->addr[2] ^ ip6addr->addr[3];
+  return LWIP_HASH_BUCKET(h, LWIP_ND6_CACHE_HASH_SIZE);
+}
+
+/** Remove a neighbor cache entry from its timer list */
+static void
+nd6_timer_unlink(s16_t i)
+{
+  struct nd6_neighbor_cache_entry *entry = &neighbor_cache[i];
+
+  if (entry->timer_list == ND6_LIST_NONE) {
+    return;
+  }
+  if (entry->timer_prev == ND6_LINK_NONE) {
+    nd6_timer_head[entry->timer_list] = entry->timer_next;
+  } else {
+    neighbor_cache[ND6_LINK_IDX(entry->timer_prev)].timer_next = entry->timer_next;
+  }
+  if (entry->timer_next == ND6_LINK_NONE) {
+    nd6_timer_tail[entry->timer_list] = entry->timer_prev;
+  } else {
+    neighbor_cache[ND6_LINK_IDX(entry->timer_next)].timer_prev = entry->timer_prev;
+  }
+  entry->timer_list = ND6_LIST_NONE;
+}
+
+/** Insert a neighbor cache entry at the head of a timer list */
+static void
+nd6_timer_push(s16_t i, u16_t list)
+{
+  struct nd6_neighbor_cache_entry *entry = &neighbor_cache[i];
+
+  entry->timer_list = list;
+  entry->timer_prev = ND6_LINK_NONE;
+  entry->timer_next = nd6_timer_head[list];
+  if (nd6_timer_head[list] == ND6_LINK_NONE) {
+    nd6_timer_tail[list] = ND6_LINK(i);
+  } else {
+    neighbor_cache[ND6_LINK_IDX(nd6_timer_head[list])].timer_prev = ND6_LINK(i);
+  }
+  nd6_timer_head[list] = ND6_LINK(i);
+}
+
+/**
+ * (Re-)arm the timer of a neighbor cache entry after its state changed.
+ * The timer expires after the number of nd6_tmr() ticks the per-tick state
+ * machine would take to leave the current state.
+ *
+ * @param i the neighbor cache entry index
+ */
+static void
+nd6_neighbor_timer_update(s16_t i)
+{
+  struct nd6_neighbor_cache_entry *entry = &neighbor_cache[i];
+  u32_t ticks;
+
+  nd6_timer_unlink(i);
+  switch (entry->state) {
+  case ND6_INCOMPLETE:
+  case ND6_PROBE:
+    /* send a probe every tick */
+    ticks = 1;
+    break;
+  case ND6_REACHABLE:
+    ticks = (entry->counter.reachable_time / ND6_TMR_INTERVAL) +
+            ((entry->counter.reachable_time % ND6_TMR_INTERVAL) != 0);
+    break;
+  case ND6_DELAY:
+    ticks = entry->counter.delay_time;
+    break;
+  case ND6_STALE:
+    /* no timer, but keep the entries in the order they became stale */
+    nd6_timer_push(i, ND6_LIST_STALE);
+    return;
+  case ND6_NO_ENTRY:
+  default:
+    return;
+  }
+  if (ticks == 0) {
+    ticks = 1;
+  }
+  entry->timer_expire = nd6_ticks + ticks;
+  nd6_timer_push(i, (u16_t)(entry->timer_expire & (ND6_WHEEL_SIZE - 1)));
+}
+
+/**
+ * The timer of a neighbor cache entry expired: the timer wheel variant of
+ * the neighbor state machine in nd6_tmr().
+ *
+ * @param i the neighbor cache entry index
+ */
+static void
+nd6_neighbor_timeout(s16_t i)
+{
+  switch (neighbor_cache[i].state) {
+  case ND6_INCOMPLETE:
+    if ((neighbor_cache[i].counter.probes_sent >= LWIP_ND6_MAX_MULTICAST_SOLICIT) &&
+        (!neighbor_cache[i].isrouter)) {
+      /* Retries exceeded. */
+      nd6_free_neighbor_cache_entry(i);
+      return;
+    }
+    /* Send a NS for this entry. */
+    neighbor_cache[i].counter.probes_sent++;
+    nd6_send_neighbor_cache_probe(&neighbor_cache[i], ND6_SEND_FLAG_MULTICAST_DEST);
+    break;
+  case ND6_REACHABLE:
+    /* Send queued packets, if any are left. Should have been sent already. */
+    if (neighbor_cache[i].q != NULL) {
+      nd6_send_q(i);
+    }
+    /* Change to stale state. */
+    neighbor_cache[i].state = ND6_STALE;
+    neighbor_cache[i].counter.stale_time = 0;
+    break;
+  case ND6_DELAY:
+    /* Change to PROBE state. */
+    neighbor_cache[i].state = ND6_PROBE;
+    neighbor_cache[i].counter.probes_sent = 0;
+    break;
+  case ND6_PROBE:
+    if ((neighbor_cache[i].counter.probes_sent >= LWIP_ND6_MAX_MULTICAST_SOLICIT) &&
+        (!neighbor_cache[i].isrouter)) {
+      /* Retries exceeded. */
+      nd6_free_neighbor_cache_entry(i);
+      return;
+    }
+    /* Send a NS for this entry. */
+    neighbor_cache[i].counter.probes_sent++;
+    nd6_send_neighbor_cache_probe(&neighbor_cache[i], 0);
+    break;
+  case ND6_STALE:
+  case ND6_NO_ENTRY:
+  default:
+    /* Do nothing. */
+    return;
+  }
+  nd6_neighbor_timer_update(i);
+}
+
+/** Remove a destination cache entry from the LRU list */
+static void
+nd6_destination_lru_unlink(s16_t i)
+{
+  struct nd6_destination_cache_entry *entry = &destination_cache[i];
+
+  if (entry->lru_prev == ND6_LINK_NONE) {
+    nd6_destination_lru_head = entry->lru_next;
+  } else {
+    destination_cache[ND6_LINK_IDX(entry->lru_prev)].lru_next = entry->lru_next;
+  }
+  if (entry->lru_next == ND6_LINK_NONE) {
+    nd6_destination_lru_tail = entry->lru_prev;
+  } else {
+    destination_cache[ND6_LINK_IDX(entry->lru_next)].lru_prev = entry->lru_prev;
+  }
+}
+
+/** Insert a destination cache entry at the head (most recently used end) of
+ * the LRU list */
+static void
+nd6_destination_lru_push(s16_t i)
+{
+  struct nd6_destination_cache_entry *entry = &destination_cache[i];
+
+  entry->lru_prev = ND6_LINK_NONE;
+  entry->lru_next = nd6_destination_lru_head;
+  if (nd6_destination_lru_head == ND6_LINK_NONE) {
+    nd6_destination_lru_tail = ND6_LINK(i);
+  } else {
+    destination_cache[ND6_LINK_IDX(nd6_destination_lru_head)].lru_prev = ND6_LINK(i);
+  }
+  nd6_destination_lru_head = ND6_LINK(i);
+}
+#endif /* LWIP_ND6_CACHE_HASH */
+
 /**
  * Search for a neighbor cache entry
  *
@@ -1433,34 +1743,65 @@ nd6_send_rs(struct netif *netif)
  * @return The neighbor cache entry index that matched, -1 if no
  * entry is found
  */
-static s8_t
+static s16_t
 nd6_find_neighbor_cache_entry(const ip6_addr_t *ip6addr)
 {
-  s8_t i;
+  s16_t i;
+#if LWIP_ND6_CACHE_HASH
+  u16_t link;
+  for (link = nd6_neighbor_hash[nd6_hash(ip6addr)]; link != ND6_LINK_NONE; link = neighbor_cache[i].hash_next) {
+    i = ND6_LINK_IDX(link);
+    if (ip6_addr_eq(ip6addr, &(neighbor_cache[i].next_hop_address))) {
+      return i;
+    }
+  }
+#else /* LWIP_ND6_CACHE_HASH */
   for (i = 0; i < LWIP_ND6_NUM_NEIGHBORS; i++) {
     if (ip6_addr_eq(ip6addr, &(neighbor_cache[i].next_hop_address))) {
       return i;
     }
   }
+#endif /* LWIP_ND6_CACHE_HASH */
   return -1;
 }
 
 /**
- * Create a new neighbor cache entry.
+ * Select an unused neighbor cache entry.
  *
  * If no unused entry is found, will try to recycle an old entry
  * according to ad-hoc "age" heuristic.
  *
- * @return The neighbor cache entry index that was created, -1 if no
- * entry could be created
+ * @return The neighbor cache entry index that was selected, -1 if no
+ * entry could be found
  */
-static s8_t
-nd6_new_neighbor_cache_entry(void)
+static s16_t
+nd6_select_neighbor_cache_entry(void)
 {
-  s8_t i;
-  s8_t j;
+  s16_t i;
+  s16_t j;
   u32_t time;
+#if LWIP_ND6_CACHE_HASH
+  u16_t link;
 
+  /* First, take an unused entry. */
+  if (nd6_neighbor_free != ND6_LINK_NONE) {
+    return ND6_LINK_IDX(nd6_neighbor_free);
+  }
+  if (nd6_neighbors_used < LWIP_ND6_NUM_NEIGHBORS) {
+    return nd6_neighbors_used++;
+  }
+
+  /* We need to recycle an entry. in general, do not recycle if it is a router. */
+
+  /* Next, try to find the oldest Stale entry. */
+  for (link = nd6_timer_tail[ND6_LIST_STALE]; link != ND6_LINK_NONE; link = neighbor_cache[i].timer_prev) {
+    i = ND6_LINK_IDX(link);
+    if (!neighbor_cache[i].isrouter) {
+      nd6_free_neighbor_cache_entry(i);
+      return i;
+    }
+  }
+#else /* LWIP_ND6_CACHE_HASH */
 
   /* First, try to find an empty entry. */
   for (i = 0; i < LWIP_ND6_NUM_NEIGHBORS; i++) {
@@ -1479,6 +1820,7 @@ nd6_new_neighbor_cache_entry(void)
       return i;
     }
   }
+#endif /* LWIP_ND6_CACHE_HASH */
 
   /* Next, try to find a Probe entry. */
   for (i = 0; i < LWIP_ND6_NUM_NEIGHBORS; i++) {
@@ -1504,10 +1846,18 @@ nd6_new_neighbor_cache_entry(void)
   for (i = 0; i < LWIP_ND6_NUM_NEIGHBORS; i++) {
     if ((neighbor_cache[i].state == ND6_REACHABLE) &&
         (!neighbor_cache[i].isrouter)) {
+#if LWIP_ND6_CACHE_HASH
+      /* the remaining reachable time is kept by the timer */
+      if (neighbor_cache[i].timer_expire - nd6_ticks < time) {
+        j = i;
+        time = neighbor_cache[i].timer_expire - nd6_ticks;
+      }
+#else /* LWIP_ND6_CACHE_HASH */
       if (neighbor_cache[i].counter.reachable_time < time) {
         j = i;
         time = neighbor_cache[i].counter.reachable_time;
       }
+#endif /* LWIP_ND6_CACHE_HASH */
     }
   }
   if (j >= 0) {
@@ -1555,6 +1905,34 @@ nd6_new_neighbor_cache_entry(void)
   return -1;
 }
 
+/**
+ * Create a new neighbor cache entry.
+ *
+ * @param ip6addr the IPv6 address of the neighbor
+ * @return The neighbor cache entry index that was created, -1 if no
+ * entry could be created
+ */
+static s16_t
+nd6_new_neighbor_cache_entry(const ip6_addr_t *ip6addr)
+{
+  s16_t i = nd6_select_neighbor_cache_entry();
+
+  if (i >= 0) {
+#if LWIP_ND6_CACHE_HASH
+    u16_t bucket = nd6_hash(ip6addr);
+    if (nd6_neighbor_free == ND6_LINK(i)) {
+      /* unused or just recycled entry */
+      nd6_neighbor_free = neighbor_cache[i].hash_next;
+    }
+    neighbor_cache[i].hash_next = nd6_neighbor_hash[bucket];
+    nd6_neighbor_hash[bucket] = ND6_LINK(i);
+    neighbor_cache[i].timer_list = ND6_LIST_NONE;
+#endif /* LWIP_ND6_CACHE_HASH */
+    ip6_addr_set(&(neighbor_cache[i].next_hop_address), ip6addr);
+  }
+  return i;
+}
+
 /**
  * Will free any resources associated with a neighbor cache
  * entry, and will mark it as unused.
@@ -1562,7 +1940,7 @@ nd6_new_neighbor_cache_entry(void)
  * @param i the neighbor cache entry index to free
  */
 static void
-nd6_free_neighbor_cache_entry(s8_t i)
+nd6_free_neighbor_cache_entry(s16_t i)
 {
   if ((i < 0) || (i >= LWIP_ND6_NUM_NEIGHBORS)) {
     return;
@@ -1571,6 +1949,21 @@ nd6_free_neighbor_cache_entry(s8_t i)
     /* isrouter needs to be cleared before deleting a neighbor cache entry */
     return;
   }
+#if LWIP_ND6_CACHE_HASH
+  if (neighbor_cache[i].state != ND6_NO_ENTRY) {
+    u16_t *link = &nd6_neighbor_hash[nd6_hash(&neighbor_cache[i].next_hop_address)];
+
+    /* remove from the hash bucket and the timer list, add to the free list */
+    while (*link != ND6_LINK(i)) {
+      LWIP_ASSERT("entry not in its hash bucket", *link != ND6_LINK_NONE);
+      link = &neighbor_cache[ND6_LINK_IDX(*link)].hash_next;
+    }
+    *link = neighbor_cache[i].hash_next;
+    nd6_timer_unlink(i);
+    neighbor_cache[i].hash_next = nd6_neighbor_free;
+    nd6_neighbor_free = ND6_LINK(i);
+  }
+#endif /* LWIP_ND6_CACHE_HASH */
 
   /* Free any queued packets. */
   if (neighbor_cache[i].q != NULL) {
@@ -1596,14 +1989,26 @@ static s16_t
 nd6_find_destination_cache_entry(const ip6_addr_t *ip6addr)
 {
   s16_t i;
+#if LWIP_ND6_CACHE_HASH
+  u16_t link;
+#endif /* LWIP_ND6_CACHE_HASH */
 
   IP6_ADDR_ZONECHECK(ip6addr);
 
+#if LWIP_ND6_CACHE_HASH
+  for (link = nd6_destination_hash[nd6_hash(ip6addr)]; link != ND6_LINK_NONE; link = destination_cache[i].hash_next) {
+    i = ND6_LINK_IDX(link);
+    if (ip6_addr_eq(ip6addr, &(destination_cache[i].destination_addr))) {
+      return i;
+    }
+  }
+#else /* LWIP_ND6_CACHE_HASH */
   for (i = 0; i < LWIP_ND6_NUM_DESTINATIONS; i++) {
     if (ip6_addr_eq(ip6addr, &(destination_cache[i].destination_addr))) {
       return i;
     }
   }
+#endif /* LWIP_ND6_CACHE_HASH */
   return -1;
 }
 
@@ -1611,18 +2016,43 @@ nd6_find_destination_cache_entry(const ip6_addr_t *ip6addr)
  * Create a new destination cache entry. If no unused entry is found,
  * will recycle oldest entry.
  *
+ * @param ip6addr the IPv6 address of the destination
  * @return The destination cache entry index that was created, -1 if no
  * entry was created
  */
 static s16_t
-nd6_new_destination_cache_entry(void)
+nd6_new_destination_cache_entry(const ip6_addr_t *ip6addr)
 {
+#if LWIP_ND6_CACHE_HASH
+  s16_t i;
+  u16_t bucket;
+
+  if ((nd6_destination_free == ND6_LINK_NONE) &&
+      (nd6_destinations_used == LWIP_ND6_NUM_DESTINATIONS)) {
+    /* Recycle the least recently used entry. */
+    nd6_free_destination_cache_entry(ND6_LINK_IDX(nd6_destination_lru_tail));
+  }
+  if (nd6_destination_free != ND6_LINK_NONE) {
+    i = ND6_LINK_IDX(nd6_destination_free);
+    nd6_destination_free = destination_cache[i].hash_next;
+  } else {
+    i = nd6_destinations_used++;
+  }
+
+  ip6_addr_set(&destination_cache[i].destination_addr, ip6addr);
+  bucket = nd6_hash(ip6addr);
+  destination_cache[i].hash_next = nd6_destination_hash[bucket];
+  nd6_destination_hash[bucket] = ND6_LINK(i);
+  nd6_destination_lru_push(i);
+  return i;
+#else /* LWIP_ND6_CACHE_HASH */
   s16_t i, j;
   u32_t age;
 
   /* Find an empty entry. */
   for (i = 0; i < LWIP_ND6_NUM_DESTINATIONS; i++) {
     if (ip6_addr_isany(&(destination_cache[i].destination_addr))) {
+      ip6_addr_set(&destination_cache[i].destination_addr, ip6addr);
       return i;
     }
   }
@@ -1636,7 +2066,35 @@ nd6_new_destination_cache_entry(void)
     }
   }
 
+  ip6_addr_set(&destination_cache[j].destination_addr, ip6addr);
   return j;
+#endif /* LWIP_ND6_CACHE_HASH */
+}
+
+/**
+ * Invalidate a destination cache entry.
+ *
+ * @param i the destination cache entry index to free
+ */
+static void
+nd6_free_destination_cache_entry(s16_t i)
+{
+#if LWIP_ND6_CACHE_HASH
+  if (!ip6_addr_isany(&destination_cache[i].destination_addr)) {
+    u16_t *link = &nd6_destination_hash[nd6_hash(&destination_cache[i].destination_addr)];
+
+    /* remove from the hash bucket and the LRU list, add to the free list */
+    while (*link != ND6_LINK(i)) {
+      LWIP_ASSERT("entry not in its hash bucket", *link != ND6_LINK_NONE);
+      link = &destination_cache[ND6_LINK_IDX(*link)].hash_next;
+    }
+    *link = destination_cache[i].hash_next;
+    nd6_destination_lru_unlink(i);
+    destination_cache[i].hash_next = nd6_destination_free;
+    nd6_destination_free = ND6_LINK(i);
+  }
+#endif /* LWIP_ND6_CACHE_HASH */
+  ip6_addr_set_any(&destination_cache[i].destination_addr);
 }
 
 /**
@@ -1648,10 +2106,10 @@ nd6_new_destination_cache_entry(void)
 void
 nd6_clear_destination_cache(void)
 {
-  int i;
+  s16_t i;
 
   for (i = 0; i < LWIP_ND6_NUM_DESTINATIONS; i++) {
-    ip6_addr_set_any(&destination_cache[i].destination_addr);
+    nd6_free_destination_cache_entry(i);
   }
 }
 
@@ -1667,7 +2125,9 @@ nd6_is_prefix_in_netif(const ip6_addr_t *ip6addr, struct netif *netif)
 {
   s8_t i;
 
-  /* Check to see if the address matches an on-link prefix. */
+#if !LWIP_IPV6_FIB
+  /* Check to see if the address matches an on-link prefix (with
+   * LWIP_IPV6_FIB, these are looked up in the routing table instead). */
   for (i = 0; i < LWIP_ND6_NUM_PREFIXES; i++) {
     if ((prefix_list[i].netif == netif) &&
         (prefix_list[i].invalidation_timer > 0) &&
@@ -1675,6 +2135,7 @@ nd6_is_prefix_in_netif(const ip6_addr_t *ip6addr, struct netif *netif)
       return 1;
     }
   }
+#endif /* !LWIP_IPV6_FIB */
   /* Check to see if address prefix matches a manually configured (= static)
    * address. Static addresses have an implied /64 subnet assignment. Dynamic
    * addresses (from autoconfiguration) have no implied subnet assignment, and
@@ -1842,7 +2303,7 @@ nd6_new_router(const ip6_addr_t *router_addr, struct netif *netif)
 {
   s8_t router_index;
   s8_t free_router_index;
-  s8_t neighbor_index;
+  s16_t neighbor_index;
 
   IP6_ADDR_ZONECHECK_NETIF(router_addr, netif);
 
@@ -1850,16 +2311,16 @@ nd6_new_router(const ip6_addr_t *router_addr, struct netif *netif)
   neighbor_index = nd6_find_neighbor_cache_entry(router_addr);
   if (neighbor_index < 0) {
     /* Create a neighbor entry for this router. */
-    neighbor_index = nd6_new_neighbor_cache_entry();
+    neighbor_index = nd6_new_neighbor_cache_entry(router_addr);
     if (neighbor_index < 0) {
       /* Could not create neighbor entry for this router. */
       return -1;
     }
-    ip6_addr_set(&(neighbor_cache[neighbor_index].next_hop_address), router_addr);
     neighbor_cache[neighbor_index].netif = netif;
     neighbor_cache[neighbor_index].q = NULL;
     neighbor_cache[neighbor_index].state = ND6_INCOMPLETE;
     neighbor_cache[neighbor_index].counter.probes_sent = 1;
+    ND6_NEIGHBOR_TIMER_UPDATE(neighbor_index);
     nd6_send_neighbor_cache_probe(&neighbor_cache[neighbor_index], ND6_SEND_FLAG_MULTICAST_DEST);
   }
 
@@ -1944,6 +2405,27 @@ nd6_new_onlink_prefix(const ip6_addr_t *prefix, struct netif *netif)
   return -1;
 }
 
+#if LWIP_IPV6_FIB && LWIP_FIB_ECMP
+/**
+ * Was the next hop of a destination cache entry resolved for another netif?
+ * With equal-cost routes, packets to one destination may leave on several
+ * netifs, so such an entry has to be resolved again.
+ */
+static int
+nd6_destination_netif_differs(const struct nd6_destination_cache_entry *dest, const struct netif *netif)
+{
+  s16_t i = (s16_t)dest->cached_neighbor_idx;
+
+  if (!ip6_addr_eq(&dest->next_hop_addr, &neighbor_cache[i].next_hop_address)) {
+    i = nd6_find_neighbor_cache_entry(&dest->next_hop_addr);
+    if (i < 0) {
+      return 0;
+    }
+  }
+  return neighbor_cache[i].netif != netif;
+}
+#endif /* LWIP_IPV6_FIB && LWIP_FIB_ECMP */
+
 /**
  * Determine the next hop for a destination. Will determine if the
  * destination is on-link, else a suitable on-link router is selected.
@@ -1956,13 +2438,16 @@ nd6_new_onlink_prefix(const ip6_addr_t *prefix, struct netif *netif)
  *         suitable next hop was found, ERR_MEM if no cache entry
  *         could be created
  */
-static s8_t
+static s16_t
 nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
 {
 #ifdef LWIP_HOOK_ND6_GET_GW
   const ip6_addr_t *next_hop_addr;
 #endif /* LWIP_HOOK_ND6_GET_GW */
-  s8_t i;
+#if LWIP_IPV6_FIB
+  const struct ip6_fib_entry *route;
+#endif /* LWIP_IPV6_FIB */
+  s16_t i;
   s16_t dst_idx;
   struct nd6_destination_cache_entry *dest;
 
@@ -1982,13 +2467,24 @@ nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
 
   /* Look for ip6addr in destination cache. */
   dest = &destination_cache[nd6_cached_destination_index];
-  if (ip6_addr_eq(ip6addr, &dest->destination_addr)) {
+  if (ip6_addr_eq(ip6addr, &dest->destination_addr)
+#if LWIP_IPV6_FIB && LWIP_FIB_ECMP
+      && !nd6_destination_netif_differs(dest, netif)
+#endif /* LWIP_IPV6_FIB && LWIP_FIB_ECMP */
+     ) {
     /* the cached entry index is the right one! */
     /* do nothing. */
     ND6_STATS_INC(nd6.cachehit);
   } else {
     /* Search destination cache. */
     dst_idx = nd6_find_destination_cache_entry(ip6addr);
+#if LWIP_IPV6_FIB && LWIP_FIB_ECMP
+    if ((dst_idx >= 0) && nd6_destination_netif_differs(&destination_cache[dst_idx], netif)) {
+      /* resolved for another path: resolve again for this netif */
+      nd6_free_destination_cache_entry(dst_idx);
+      dst_idx = -1;
+    }
+#endif /* LWIP_IPV6_FIB && LWIP_FIB_ECMP */
     if (dst_idx >= 0) {
       /* found destination entry. make it our new cached index. */
       LWIP_ASSERT("type overflow", (size_t)dst_idx < NETIF_ADDR_IDX_MAX);
@@ -1996,7 +2492,7 @@ nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
       dest = &destination_cache[dst_idx];
     } else {
       /* Not found. Create a new destination entry. */
-      dst_idx = nd6_new_destination_cache_entry();
+      dst_idx = nd6_new_destination_cache_entry(ip6addr);
       if (dst_idx >= 0) {
         /* got new destination entry. make it our new cached index. */
         LWIP_ASSERT("type overflow", (size_t)dst_idx < NETIF_ADDR_IDX_MAX);
@@ -2007,15 +2503,23 @@ nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
         return ERR_MEM;
       }
 
-      /* Copy dest address to destination cache. */
-      ip6_addr_set(&dest->destination_addr, ip6addr);
-
       /* Now find the next hop. is it a neighbor? */
       if (ip6_addr_islinklocal(ip6addr) ||
           nd6_is_prefix_in_netif(ip6addr, netif)) {
         /* Destination in local link. */
         dest->pmtu = netif_mtu6(netif);
         ip6_addr_copy(dest->next_hop_addr, dest->destination_addr);
+#if LWIP_IPV6_FIB
+      } else if (((route = ip6_fib_lookup(ip6addr, netif)) != NULL) &&
+                 ((route->origin != IP6_FIB_ORIGIN_RA) || (route->prefix_len != 0))) {
+        /* On-link prefix or static route (default routers are selected below). */
+        dest->pmtu = netif_mtu6(netif);
+        if (ip6_addr_isany(&route->gw)) {
+          ip6_addr_copy(dest->next_hop_addr, dest->destination_addr);
+        } else {
+          ip6_addr_copy(dest->next_hop_addr, route->gw);
+        }
+#endif /* LWIP_IPV6_FIB */
 #ifdef LWIP_HOOK_ND6_GET_GW
       } else if ((next_hop_addr = LWIP_HOOK_ND6_GET_GW(netif, ip6addr)) != NULL) {
         /* Next hop for destination provided by hook function. */
@@ -2027,7 +2531,7 @@ nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
         i = nd6_select_router(ip6addr, netif);
         if (i < 0) {
           /* No router found. */
-          ip6_addr_set_any(&dest->destination_addr);
+          nd6_free_destination_cache_entry(dst_idx);
           return ERR_RTE;
         }
         dest->pmtu = netif_mtu6(netif); /* Start with netif mtu, correct through ICMPv6 if necessary */
@@ -2052,32 +2556,40 @@ nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
     i = nd6_find_neighbor_cache_entry(&dest->next_hop_addr);
     if (i >= 0) {
       /* Found a matching record, make it new cached entry. */
-      dest->cached_neighbor_idx = i;
+      dest->cached_neighbor_idx = (u16_t)i;
     } else {
       /* Neighbor not in cache. Make a new entry. */
-      i = nd6_new_neighbor_cache_entry();
+      i = nd6_new_neighbor_cache_entry(&dest->next_hop_addr);
       if (i >= 0) {
         /* got new neighbor entry. make it our new cached index. */
-        dest->cached_neighbor_idx = i;
+        dest->cached_neighbor_idx = (u16_t)i;
       } else {
         /* Could not create a neighbor cache entry. */
         return ERR_MEM;
       }
 
       /* Initialize fields. */
-      ip6_addr_copy(neighbor_cache[i].next_hop_address, dest->next_hop_addr);
       neighbor_cache[i].isrouter = 0;
       neighbor_cache[i].netif = netif;
       neighbor_cache[i].state = ND6_INCOMPLETE;
       neighbor_cache[i].counter.probes_sent = 1;
+      ND6_NEIGHBOR_TIMER_UPDATE(i);
       nd6_send_neighbor_cache_probe(&neighbor_cache[i], ND6_SEND_FLAG_MULTICAST_DEST);
     }
   }
 
   /* Reset this destination's age. */
   dest->age = 0;
+#if LWIP_ND6_CACHE_HASH
+  if (!ip6_addr_isany(&dest->destination_addr) &&
+      (nd6_destination_lru_head != ND6_LINK(nd6_cached_destination_index))) {
+    /* most recently used entry now */
+    nd6_destination_lru_unlink((s16_t)nd6_cached_destination_index);
+    nd6_destination_lru_push((s16_t)nd6_cached_destination_index);
+  }
+#endif /* LWIP_ND6_CACHE_HASH */
 
-  return dest->cached_neighbor_idx;
+  return (s16_t)dest->cached_neighbor_idx;
 }
 
 /**
@@ -2088,7 +2600,7 @@ nd6_get_next_hop_entry(const ip6_addr_t *ip6addr, struct netif *netif)
  * @return ERR_OK if succeeded, ERR_MEM if out of memory
  */
 static err_t
-nd6_queue_packet(s8_t neighbor_index, struct pbuf *q)
+nd6_queue_packet(s16_t neighbor_index, struct pbuf *q)
 {
   err_t result = ERR_MEM;
   struct pbuf *p;
@@ -2219,7 +2731,7 @@ nd6_free_q(struct nd6_q_entry *q)
  * @param i the neighbor to send packets to
  */
 static void
-nd6_send_q(s8_t i)
+nd6_send_q(s16_t i)
 {
   struct ip6_hdr *ip6hdr;
   ip6_addr_t dest;
@@ -2293,13 +2805,13 @@ nd6_send_q(s8_t i)
 err_t
 nd6_get_next_hop_addr_or_queue(struct netif *netif, struct pbuf *q, const ip6_addr_t *ip6addr, const u8_t **hwaddrp)
 {
-  s8_t i;
+  s16_t i;
 
   /* Get next hop record. */
   i = nd6_get_next_hop_entry(ip6addr, netif);
   if (i < 0) {
     /* failed to get a next hop neighbor record. */
-    return i;
+    return (err_t)i;
   }
 
   /* Now that we have a destination record, send or queue the packet. */
@@ -2307,6 +2819,7 @@ nd6_get_next_hop_addr_or_queue(struct netif *netif, struct pbuf *q, const ip6_ad
     /* Switch to delay state. */
     neighbor_cache[i].state = ND6_DELAY;
     neighbor_cache[i].counter.delay_time = LWIP_ND6_DELAY_FIRST_PROBE_TIME / ND6_TMR_INTERVAL;
+    ND6_NEIGHBOR_TIMER_UPDATE(i);
   }
   /* @todo should we send or queue if PROBE? send for now, to let unicast NS pass. */
   if ((neighbor_cache[i].state == ND6_REACHABLE) ||
@@ -2364,7 +2877,7 @@ nd6_get_destination_mtu(const ip6_addr_t *ip6addr, struct netif *netif)
 void
 nd6_reachability_hint(const ip6_addr_t *ip6addr)
 {
-  s8_t i;
+  s16_t i;
   s16_t dst_idx;
   struct nd6_destination_cache_entry *dest;
 
@@ -2382,7 +2895,7 @@ nd6_reachability_hint(const ip6_addr_t *ip6addr)
   /* Find next hop neighbor in cache. */
   dest = &destination_cache[dst_idx];
   if (ip6_addr_eq(&dest->next_hop_addr, &(neighbor_cache[dest->cached_neighbor_idx].next_hop_address))) {
-    i = dest->cached_neighbor_idx;
+    i = (s16_t)dest->cached_neighbor_idx;
     ND6_STATS_INC(nd6.cachehit);
   } else {
     i = nd6_find_neighbor_cache_entry(&dest->next_hop_addr);
@@ -2399,6 +2912,7 @@ nd6_reachability_hint(const ip6_addr_t *ip6addr)
   /* Set reachability state. */
   neighbor_cache[i].state = ND6_REACHABLE;
   neighbor_cache[i].counter.reachable_time = reachable_time;
+  ND6_NEIGHBOR_TIMER_UPDATE(i);
 }
 #endif /* LWIP_ND6_TCP_REACHABILITY_HINTS */
 
@@ -2410,10 +2924,13 @@ nd6_reachability_hint(const ip6_addr_t *ip6addr)
 void
 nd6_cleanup_netif(struct netif *netif)
 {
-  u8_t i;
+  s16_t i;
   s8_t router_index;
   for (i = 0; i < LWIP_ND6_NUM_PREFIXES; i++) {
     if (prefix_list[i].netif == netif) {
+#if LWIP_IPV6_FIB
+      ip6_fib_remove_ra(&prefix_list[i].prefix, 64, NULL, netif);
+#endif /* LWIP_IPV6_FIB */
       prefix_list[i].netif = NULL;
     }
   }
@@ -2421,6 +2938,9 @@ nd6_cleanup_netif(struct netif *netif)
     if (neighbor_cache[i].netif == netif) {
       for (router_index = 0; router_index < LWIP_ND6_NUM_ROUTERS; router_index++) {
         if (default_router_list[router_index].neighbor_entry == &neighbor_cache[i]) {
+#if LWIP_IPV6_FIB
+          ip6_fib_remove_ra(IP6_ADDR_ANY6, 0, &neighbor_cache[i].next_hop_address, netif);
+#endif /* LWIP_IPV6_FIB */
           default_router_list[router_index].neighbor_entry = NULL;
           default_router_list[router_index].flags = 0;
         }
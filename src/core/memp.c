@@ -59,6 +59,7 @@
 #include "lwip/priv/tcp_priv.h"
 #include "lwip/altcp.h"
 #include "lwip/ip4_frag.h"
+#include "lwip/ip4_fib.h"
 #include "lwip/netbuf.h"
 #include "lwip/api.h"
 #include "lwip/priv/tcpip_priv.h"
@@ -73,6 +74,7 @@
 #include "lwip/dns.h"
 #include "lwip/priv/nd6_priv.h"
 #include "lwip/ip6_frag.h"
+#include "lwip/ip6_fib.h"
 #include "lwip/mld6.h"
 
 #define LWIP_MEMPOOL(name,num,size,desc) LWIP_MEMPOOL_DECLARE(name,num,size,desc)
@@ -63,6 +63,10 @@
 #include "lwip/snmp.h"
 #include "lwip/igmp.h"
 #include "lwip/etharp.h"
+#include "lwip/ip4_fib.h"
+#include "lwip/ip4_mroute.h"
+#include "lwip/ip6_fib.h"
+#include "lwip/ip_fwcache.h"
 #include "lwip/stats.h"
 #include "lwip/sys.h"
 #include "lwip/ip.h"
@@ -335,6 +339,7 @@ netif_add(struct netif *netif,
   netif->output_ip6 = netif_null_output_ip6;
 #endif /* LWIP_IPV6 */
   NETIF_SET_CHECKSUM_CTRL(netif, NETIF_CHECKSUM_ENABLE_ALL);
+  NETIF_SET_FRAG_OFFLOAD(netif, 0);
   netif->mtu = 0;
   netif->flags = 0;
 #ifdef netif_get_client_data
@@ -498,6 +503,7 @@ netif_do_set_ipaddr(struct netif *netif, const ip4_addr_t *ipaddr, ip_addr_t *ol
     /* set new IP address to netif */
     ip4_addr_set(ip_2_ip4(&netif->ip_addr), ipaddr);
     IP_SET_TYPE_VAL(netif->ip_addr, IPADDR_TYPE_V4);
+    IP_FWCACHE_INVALIDATE();
     mib2_add_ip4(netif);
     mib2_add_route_ip4(0, netif);
 
@@ -557,6 +563,7 @@ netif_do_set_netmask(struct netif *netif, const ip4_addr_t *netmask, ip_addr_t *
     /* set new netmask to netif */
     ip4_addr_set(ip_2_ip4(&netif->netmask), netmask);
     IP_SET_TYPE_VAL(netif->netmask, IPADDR_TYPE_V4);
+    IP_FWCACHE_INVALIDATE();
     mib2_add_route_ip4(0, netif);
     LWIP_DEBUGF(NETIF_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, ("netif: netmask of interface %c%c set to %"U16_F".%"U16_F".%"U16_F".%"U16_F"\n",
                 netif->name[0], netif->name[1],
@@ -620,6 +627,7 @@ netif_do_set_gw(struct netif *netif, const ip4_addr_t *gw, ip_addr_t *old_gw)
 
     ip4_addr_set(ip_2_ip4(&netif->gw), gw);
     IP_SET_TYPE_VAL(netif->gw, IPADDR_TYPE_V4);
+    IP_FWCACHE_INVALIDATE();
     LWIP_DEBUGF(NETIF_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, ("netif: GW address of interface %c%c set to %"U16_F".%"U16_F".%"U16_F".%"U16_F"\n",
                 netif->name[0], netif->name[1],
                 ip4_addr1_16(netif_ip4_gw(netif)),
@@ -776,6 +784,7 @@ netif_remove(struct netif *netif)
   }
 
   netif_invoke_ext_callback(netif, LWIP_NSC_NETIF_REMOVED, NULL);
+  IP_FWCACHE_INVALIDATE();
 
 #if LWIP_IPV4
   if (!ip4_addr_isany_val(*netif_ip4_addr(netif))) {
@@ -788,6 +797,12 @@ netif_remove(struct netif *netif)
     igmp_stop(netif);
   }
 #endif /* LWIP_IGMP */
+#if LWIP_IPV4_FIB
+  ip4_fib_cleanup_netif(netif);
+#endif /* LWIP_IPV4_FIB */
+#if LWIP_IPV4_MROUTE
+  ip4_mroute_cleanup_netif(netif);
+#endif /* LWIP_IPV4_MROUTE */
 #endif /* LWIP_IPV4*/
 
 #if LWIP_IPV6
@@ -800,6 +815,9 @@ netif_remove(struct netif *netif)
   /* stop MLD processing */
   mld6_stop(netif);
 #endif /* LWIP_IPV6_MLD */
+#if LWIP_IPV6_FIB
+  ip6_fib_cleanup_netif(netif);
+#endif /* LWIP_IPV6_FIB */
 #endif /* LWIP_IPV6 */
   if (netif_is_up(netif)) {
     /* set netif down before removing (call callback function) */
@@ -860,6 +878,7 @@ netif_set_default(struct netif *netif)
     mib2_add_route_ip4(1, netif);
   }
   netif_default = netif;
+  IP_FWCACHE_INVALIDATE();
   LWIP_DEBUGF(NETIF_DEBUG, ("netif: setting default interface %c%c\n",
                             netif ? netif->name[0] : '\'', netif ? netif->name[1] : '\''));
 }
@@ -878,6 +897,7 @@ netif_set_up(struct netif *netif)
 
   if (!(netif->flags & NETIF_FLAG_UP)) {
     netif_set_flags(netif, NETIF_FLAG_UP);
+    IP_FWCACHE_INVALIDATE();
 
     MIB2_COPY_SYSUPTIME_TO(&netif->ts);
 
@@ -964,6 +984,7 @@ netif_set_down(struct netif *netif)
 #endif
 
     netif_clear_flags(netif, NETIF_FLAG_UP);
+    IP_FWCACHE_INVALIDATE();
     MIB2_COPY_SYSUPTIME_TO(&netif->ts);
 
 #if LWIP_IPV4 && LWIP_ARP
@@ -1025,6 +1046,7 @@ netif_set_link_up(struct netif *netif)
 
   if (!(netif->flags & NETIF_FLAG_LINK_UP)) {
     netif_set_flags(netif, NETIF_FLAG_LINK_UP);
+    IP_FWCACHE_INVALIDATE();
 
 #if LWIP_DHCP
     dhcp_network_changed_link_up(netif);
@@ -1063,6 +1085,7 @@ netif_set_link_down(struct netif *netif)
 
   if (netif->flags & NETIF_FLAG_LINK_UP) {
     netif_clear_flags(netif, NETIF_FLAG_LINK_UP);
+    IP_FWCACHE_INVALIDATE();
 
 #if LWIP_AUTOIP
     autoip_network_changed_link_down(netif);
@@ -1414,6 +1437,7 @@ netif_ip6_addr_set_parts(struct netif *netif, s8_t addr_idx, u32_t i0, u32_t i1,
     /* @todo: remove/re-add mib2 ip6 entries? */
 
     ip_addr_copy(netif->ip6_addr[addr_idx], new_ipaddr);
+    IP_FWCACHE_INVALIDATE();
 
     if (ip6_addr_isvalid(netif_ip6_addr_state(netif, addr_idx))) {
       netif_issue_reports(netif, NETIF_REPORT_TYPE_IPV6);
@@ -1473,6 +1497,9 @@ netif_ip6_addr_set_state(struct netif *netif, s8_t addr_idx, u8_t state)
       /* @todo: remove mib2 ip6 entries? */
     }
     netif->ip6_addr_state[addr_idx] = state;
+    if (old_valid != new_valid) {
+      IP_FWCACHE_INVALIDATE();
+    }
 
     if (!old_valid && new_valid) {
       /* address added by setting valid */
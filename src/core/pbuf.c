@@ -186,6 +186,9 @@ pbuf_init_alloced_pbuf(struct pbuf *p, void *payload, u16_t tot_len, u16_t len,
   p->flags = flags;
   p->ref = 1;
   p->if_idx = NETIF_NO_INDEX;
+#if LWIP_NETIF_FRAG_OFFLOAD
+  p->frag_size = 0;
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
 
   LWIP_PBUF_CUSTOM_DATA_INIT(p);
 }
@@ -1333,7 +1336,8 @@ pbuf_coalesce(struct pbuf *p, pbuf_layer layer)
 /**
  * @ingroup pbuf
  * Allocates a new pbuf of same length (via pbuf_alloc()) and copies the source
- * pbuf into this new pbuf (using pbuf_copy()).
+ * pbuf into this new pbuf (using pbuf_copy()). With LWIP_NETIF_FRAG_OFFLOAD,
+ * p->frag_size is copied, too.
  *
  * @param layer pbuf_layer of the new pbuf
  * @param type this parameter decides how and where the pbuf should be allocated
@@ -1354,6 +1358,9 @@ pbuf_clone(pbuf_layer layer, pbuf_type type, struct pbuf *p)
   err = pbuf_copy(q, p);
   LWIP_UNUSED_ARG(err); /* in case of LWIP_NOASSERT */
   LWIP_ASSERT("pbuf_copy failed", err == ERR_OK);
+#if LWIP_NETIF_FRAG_OFFLOAD
+  q->frag_size = p->frag_size;
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
   return q;
 }
 
@@ -111,6 +111,7 @@
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
 #include "lwip/nd6.h"
+#include "lwip/ip4_pmtu.h"
 
 #include <string.h>
 
@@ -184,6 +185,22 @@ struct tcp_pcb **const tcp_pcb_lists[] = {&tcp_listen_pcbs.pcbs, &tcp_bound_pcbs
 
 u8_t tcp_active_pcbs_changed;
 
+#if LWIP_TCP_FASTOPEN || LWIP_TCP_SYNCOOKIES
+/** Secret key for TCP Fast Open cookies and SYN cookies (see tcp_set_secret_key()) */
+static u8_t tcp_secret_key[8];
+#endif /* LWIP_TCP_FASTOPEN || LWIP_TCP_SYNCOOKIES */
+
+#if LWIP_TCP_FASTOPEN
+/** Cached TCP Fast Open cookies of remote hosts */
+struct tcp_fastopen_cache_entry {
+  ip_addr_t addr;
+  u8_t len;
+  u8_t cookie[TCP_FASTOPEN_COOKIE_LEN];
+};
+static struct tcp_fastopen_cache_entry tcp_fastopen_cache[TCP_FASTOPEN_CACHE_SIZE];
+static u8_t tcp_fastopen_cache_next;
+#endif /* LWIP_TCP_FASTOPEN */
+
 /** Timer counter to handle calling slow-timer from tcp_tmr() */
 static u8_t tcp_timer;
 static u8_t tcp_timer_ctr;
@@ -202,6 +219,14 @@ tcp_init(void)
 {
 #ifdef LWIP_RAND
   tcp_port = TCP_ENSURE_LOCAL_PORT_RANGE(LWIP_RAND());
+#if LWIP_TCP_FASTOPEN || LWIP_TCP_SYNCOOKIES
+  {
+    u8_t i;
+    for (i = 0; i < sizeof(tcp_secret_key); i++) {
+      tcp_secret_key[i] = (u8_t)LWIP_RAND();
+    }
+  }
+#endif /* LWIP_TCP_FASTOPEN || LWIP_TCP_SYNCOOKIES */
 #endif /* LWIP_RAND */
 }
 
@@ -416,6 +441,7 @@ tcp_close_shutdown_fin(struct tcp_pcb *pcb)
       err = tcp_send_fin(pcb);
       if (err == ERR_OK) {
         tcp_backlog_accepted(pcb);
+        tcp_syn_queue_remove(pcb);
         MIB2_STATS_INC(mib2.tcpattemptfails);
         pcb->state = FIN_WAIT_1;
       }
@@ -907,6 +933,9 @@ tcp_listen_with_backlog_and_err(struct tcp_pcb *pcb, u8_t backlog, err_t *err)
   /* copy over ext_args to listening pcb  */
   memcpy(&lpcb->ext_args, &pcb->ext_args, sizeof(pcb->ext_args));
 #endif
+#if LWIP_TCP_FASTOPEN
+  lpcb->fastopen = tcp_is_flag_set(pcb, TF_FASTOPEN);
+#endif /* LWIP_TCP_FASTOPEN */
   tcp_free(pcb);
 #if LWIP_CALLBACK_API
   lpcb->accept = tcp_accept_null;
@@ -915,6 +944,9 @@ tcp_listen_with_backlog_and_err(struct tcp_pcb *pcb, u8_t backlog, err_t *err)
   lpcb->accepts_pending = 0;
   tcp_backlog_set(lpcb, backlog);
 #endif /* TCP_LISTEN_BACKLOG */
+#if LWIP_TCP_SYNCOOKIES
+  lpcb->syn_queued = 0;
+#endif /* LWIP_TCP_SYNCOOKIES */
   TCP_REG(&tcp_listen_pcbs.pcbs, (struct tcp_pcb *)lpcb);
   res = ERR_OK;
 done:
@@ -1070,6 +1102,30 @@ again:
 err_t
 tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
             tcp_connected_fn connected)
+{
+  return tcp_connect_flags(pcb, ipaddr, port, connected, 0);
+}
+
+/**
+ * @ingroup tcp_raw
+ * Like @ref tcp_connect, with additional flags:
+ * - TCP_CONNECT_FLAG_FASTOPEN: use TCP Fast Open (RFC 7413). If a cookie for
+ *   the remote host is cached, the SYN is not sent right away but on the next
+ *   call to tcp_output(), together with the first segment queued by
+ *   tcp_write() (which may be called in SYN_SENT state). Without a cookie,
+ *   the SYN is sent immediately and requests a cookie for future connections.
+ *
+ * @param pcb the tcp_pcb used to establish the connection
+ * @param ipaddr the remote ip address to connect to
+ * @param port the remote tcp port to connect to
+ * @param connected callback function to call when connected (on error,
+                    the err callback will be called)
+ * @param flags combination of TCP_CONNECT_FLAG_* flags
+ * @return see @ref tcp_connect
+ */
+err_t
+tcp_connect_flags(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
+                  tcp_connected_fn connected, u8_t flags)
 {
   struct netif *netif = NULL;
   err_t ret;
@@ -1082,19 +1138,35 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
   LWIP_ERROR("tcp_connect: invalid ipaddr", ipaddr != NULL, return ERR_ARG);
 
   LWIP_ERROR("tcp_connect: can only connect from state CLOSED", pcb->state == CLOSED, return ERR_ISCONN);
+#if LWIP_TCP_FASTOPEN
+  LWIP_ERROR("tcp_connect: invalid flags", (flags & ~TCP_CONNECT_FLAG_FASTOPEN) == 0, return ERR_ARG);
+#else /* LWIP_TCP_FASTOPEN */
+  LWIP_ERROR("tcp_connect: invalid flags", flags == 0, return ERR_ARG);
+#endif /* LWIP_TCP_FASTOPEN */
 
   LWIP_DEBUGF(TCP_DEBUG, ("tcp_connect to port %"U16_F"\n", port));
   ip_addr_set(&pcb->remote_ip, ipaddr);
   pcb->remote_port = port;
 
+  /* the local port is assigned before routing since it selects the path
+     if there are several (LWIP_FIB_ECMP) */
+  old_local_port = pcb->local_port;
+  if (pcb->local_port == 0) {
+    pcb->local_port = tcp_new_port();
+    if (pcb->local_port == 0) {
+      return ERR_BUF;
+    }
+  }
+
   if (pcb->netif_idx != NETIF_NO_INDEX) {
     netif = netif_get_by_index(pcb->netif_idx);
   } else {
     /* check if we have a route to the remote host */
-    netif = ip_route(&pcb->local_ip, &pcb->remote_ip);
+    netif = ip_route_flow(&pcb->local_ip, &pcb->remote_ip, IP_PROTO_TCP, pcb->local_port, port);
   }
   if (netif == NULL) {
     /* Don't even try to send a SYN packet if we have no route since that will fail. */
+    pcb->local_port = old_local_port;
     return ERR_RTE;
   }
 
@@ -1102,6 +1174,7 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
   if (ip_addr_isany(&pcb->local_ip)) {
     const ip_addr_t *local_ip = ip_netif_get_local_ip(netif, ipaddr);
     if (local_ip == NULL) {
+      pcb->local_port = old_local_port;
       return ERR_RTE;
     }
     ip_addr_copy(pcb->local_ip, *local_ip);
@@ -1116,14 +1189,8 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
   }
 #endif /* LWIP_IPV6 && LWIP_IPV6_SCOPES */
 
-  old_local_port = pcb->local_port;
-  if (pcb->local_port == 0) {
-    pcb->local_port = tcp_new_port();
-    if (pcb->local_port == 0) {
-      return ERR_BUF;
-    }
-  } else {
 #if SO_REUSE
+  if (old_local_port != 0) {
     if (ip_get_option(pcb, SOF_REUSEADDR)) {
       /* Since SOF_REUSEADDR allows reusing a local address, we have to make sure
          now that the 5-tuple is unique. */
@@ -1142,8 +1209,8 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
         }
       }
     }
-#endif /* SO_REUSE */
   }
+#endif /* SO_REUSE */
 
   iss = tcp_next_iss(pcb);
   pcb->rcv_nxt = 0;
@@ -1168,6 +1235,15 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
 #else /* LWIP_CALLBACK_API */
   LWIP_UNUSED_ARG(connected);
 #endif /* LWIP_CALLBACK_API */
+#if LWIP_TCP_FASTOPEN
+  if (flags & TCP_CONNECT_FLAG_FASTOPEN) {
+    tcp_set_flags(pcb, TF_FASTOPEN);
+    pcb->tfo_cookie_len = tcp_fastopen_cache_get(&pcb->remote_ip, pcb->tfo_cookie);
+  } else {
+    tcp_clear_flags(pcb, TF_FASTOPEN);
+    pcb->tfo_cookie_len = 0;
+  }
+#endif /* LWIP_TCP_FASTOPEN */
 
   /* Send a SYN together with the MSS option. */
   ret = tcp_enqueue_flags(pcb, TCP_SYN);
@@ -1180,6 +1256,12 @@ tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port,
     TCP_REG_ACTIVE(pcb);
     MIB2_STATS_INC(mib2.tcpactiveopens);
 
+#if LWIP_TCP_FASTOPEN
+    if (pcb->tfo_cookie_len != 0) {
+      /* wait for data to send with the SYN */
+      return ERR_OK;
+    }
+#endif /* LWIP_TCP_FASTOPEN */
     tcp_output(pcb);
   }
   return ret;
@@ -1285,6 +1367,9 @@ tcp_slowtmr_start:
              still execute the backoff calculations below, as this means we somehow
              failed to send segment. */
           if ((tcp_rexmit_rto_prepare(pcb) == ERR_OK) || ((pcb->unacked == NULL) && (pcb->unsent != NULL))) {
+#if TCP_PLPMTUD
+            tcp_plpmtud_rexmit(pcb, 1);
+#endif /* TCP_PLPMTUD */
             /* Double retransmission time-out unless we are trying to
              * connect to somebody (i.e., we are in SYN_SENT). */
             if (pcb->state != SYN_SENT) {
@@ -1379,6 +1464,12 @@ tcp_slowtmr_start:
       }
     }
 
+#if TCP_PLPMTUD
+    if ((pcb->state == ESTABLISHED) || (pcb->state == CLOSE_WAIT)) {
+      tcp_plpmtud_tmr(pcb);
+    }
+#endif /* TCP_PLPMTUD */
+
     /* If the PCB should be removed, do it. */
     if (pcb_remove) {
       struct tcp_pcb *pcb2;
@@ -2145,6 +2236,7 @@ tcp_pcb_purge(struct tcp_pcb *pcb)
     LWIP_DEBUGF(TCP_DEBUG, ("tcp_pcb_purge\n"));
 
     tcp_backlog_accepted(pcb);
+    tcp_syn_queue_remove(pcb);
 
     if (pcb->refused_data != NULL) {
       LWIP_DEBUGF(TCP_DEBUG, ("tcp_pcb_purge: data left on ->refused_data\n"));
@@ -2241,8 +2333,8 @@ tcp_next_iss(struct tcp_pcb *pcb)
 #if TCP_CALCULATE_EFF_SEND_MSS
 /**
  * Calculates the effective send mss that can be used for a specific IP address
- * by calculating the minimum of TCP_MSS and the mtu (if set) of the target
- * netif (if not NULL).
+ * by calculating the minimum of TCP_MSS and the path MTU or the mtu (if set)
+ * of the target netif (if not NULL).
  */
 u16_t
 tcp_eff_send_mss_netif(u16_t sendmss, struct netif *outif, const ip_addr_t *dest)
@@ -2271,7 +2363,12 @@ tcp_eff_send_mss_netif(u16_t sendmss, struct netif *outif, const ip_addr_t *dest
     if (outif == NULL) {
       return sendmss;
     }
+#if LWIP_IPV4_PMTU
+    /* Look for a Path MTU learned from ICMP. */
+    mtu = ip4_pmtu_get(ip_2_ip4(dest), outif);
+#else /* LWIP_IPV4_PMTU */
     mtu = outif->mtu;
+#endif /* LWIP_IPV4_PMTU */
   }
 #endif /* LWIP_IPV4 */
 
@@ -2302,8 +2399,231 @@ tcp_eff_send_mss_netif(u16_t sendmss, struct netif *outif, const ip_addr_t *dest
   }
   return sendmss;
 }
+
+/**
+ * Called by ICMP and ICMPv6 when a segment was too big for the path to its
+ * destination (RFC 1191, RFC 8201) to find the connection that sent it.
+ * Only messages about data in flight are believed (RFC 5927, section 4.1).
+ *
+ * @param local_ip source address of the segment that was too big
+ * @param remote_ip destination address of the segment that was too big
+ * @param local_port source port of the segment that was too big
+ * @param remote_port destination port of the segment that was too big
+ * @param seqno sequence number of the segment that was too big
+ * @return the connection, or NULL if there is none or seqno is not in flight
+ */
+struct tcp_pcb *
+tcp_pmtu_lookup(const ip_addr_t *local_ip, const ip_addr_t *remote_ip,
+                u16_t local_port, u16_t remote_port, u32_t seqno)
+{
+  struct tcp_pcb *pcb;
+
+  LWIP_ASSERT("tcp_pmtu_lookup: invalid local_ip", local_ip != NULL);
+  LWIP_ASSERT("tcp_pmtu_lookup: invalid remote_ip", remote_ip != NULL);
+
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+    if ((pcb->local_port == local_port) && (pcb->remote_port == remote_port) &&
+        ip_addr_eq(&pcb->local_ip, local_ip) && ip_addr_eq(&pcb->remote_ip, remote_ip)) {
+      break;
+    }
+  }
+  if ((pcb != NULL) && (TCP_SEQ_LT(seqno, pcb->lastack) || TCP_SEQ_GEQ(seqno, pcb->snd_nxt))) {
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_pmtu_lookup: seqno %"U32_F" not in flight\n", seqno));
+    return NULL;
+  }
+  return pcb;
+}
+
+/**
+ * Recalculate the MSS of a connection from the path MTU to its destination
+ * and reduce it if it is too big. The congestion window is kept, this is no
+ * congestion signal.
+ *
+ * @param pcb the tcp_pcb to check
+ * @param netif the netif used to reach the remote address (may be NULL)
+ * @return 1 if the MSS has been reduced, 0 otherwise
+ */
+u8_t
+tcp_pmtu_check(struct tcp_pcb *pcb, struct netif *netif)
+{
+  u16_t mss = tcp_eff_send_mss_netif(pcb->mss, netif, &pcb->remote_ip);
+  if (mss >= pcb->mss) {
+    return 0;
+  }
+  LWIP_DEBUGF(TCP_DEBUG, ("tcp_pmtu_check: mss %"U16_F" -> %"U16_F"\n", pcb->mss, mss));
+#if TCP_PLPMTUD
+  if (pcb->plpmtud_max == 0) {
+    pcb->plpmtud_max = pcb->mss;
+  }
+  /* don't probe beyond the path MTU before the next search */
+  pcb->plpmtud_high = mss;
+  pcb->plpmtud_state = TCP_PLPMTUD_IDLE;
+  pcb->plpmtud_tmr = TCP_PLPMTUD_INTERVAL_TICKS;
+#endif /* TCP_PLPMTUD */
+  tcp_reduce_mss(pcb, mss);
+  return 1;
+}
+
+/**
+ * Called by ICMP and ICMPv6 after the new path MTU of a connection found by
+ * tcp_pmtu_lookup() is stored: the MSS of the connection is recalculated. If
+ * it decreased, the data in flight is retransmitted in smaller segments right
+ * away.
+ *
+ * @param pcb the tcp_pcb that sent the segment that was too big
+ */
+void
+tcp_pmtu_update(struct tcp_pcb *pcb)
+{
+  LWIP_ASSERT("tcp_pmtu_update: invalid pcb", pcb != NULL);
+
+  if (!tcp_pmtu_check(pcb, tcp_route(pcb, &pcb->local_ip, &pcb->remote_ip))) {
+    return;
+  }
+  if (tcp_rexmit_rto_prepare(pcb) == ERR_OK) {
+    /* tcp_output() splits the segments to the new MSS */
+    tcp_output(pcb);
+  }
+}
 #endif /* TCP_CALCULATE_EFF_SEND_MSS */
 
+/**
+ * Reduce the MSS of a connection, e.g. because the path MTU decreased.
+ * Queued segments that are too big for the new MSS are split by
+ * tcp_output() when they are (re)sent.
+ *
+ * @param pcb the tcp_pcb to update
+ * @param mss the new MSS
+ */
+void
+tcp_reduce_mss(struct tcp_pcb *pcb, u16_t mss)
+{
+  LWIP_ASSERT("tcp_reduce_mss: invalid pcb", pcb != NULL);
+  LWIP_ASSERT("tcp_reduce_mss: mss must not grow", mss <= pcb->mss);
+
+  pcb->mss = mss;
+#if TCP_OVERSIZE
+  /* tcp_write() must not fill the last unsent segment beyond the new MSS */
+  pcb->unsent_oversize = 0;
+#if TCP_OVERSIZE_DBGCHECK
+  if (pcb->unsent != NULL) {
+    struct tcp_seg *last_unsent;
+    for (last_unsent = pcb->unsent; last_unsent->next != NULL; last_unsent = last_unsent->next);
+    last_unsent->oversize_left = 0;
+  }
+#endif /* TCP_OVERSIZE_DBGCHECK */
+#endif /* TCP_OVERSIZE */
+}
+
+#if TCP_PLPMTUD
+/** Continue the search with the next tcp_slowtmr() tick or, if it is done,
+ * after TCP_PLPMTUD_INTERVAL. */
+static void
+tcp_plpmtud_next(struct tcp_pcb *pcb)
+{
+  pcb->plpmtud_state = TCP_PLPMTUD_IDLE;
+  if (pcb->plpmtud_high >= pcb->mss + TCP_PLPMTUD_SEARCH_DONE) {
+    pcb->plpmtud_tmr = 1;
+  } else {
+    pcb->plpmtud_tmr = TCP_PLPMTUD_INTERVAL_TICKS;
+  }
+}
+
+/**
+ * Packetization layer path MTU discovery (RFC 4821), called by tcp_slowtmr()
+ * for connections that can send data.
+ *
+ * When the MSS of a connection is below the MSS it started with (see
+ * tcp_plpmtud_rexmit() and tcp_pmtu_update()) and the search timer expires,
+ * the MSS is raised to the middle of the range not searched yet. tcp_output()
+ * takes the first segment that would not have fit the old MSS as the probe.
+ * If it is acknowledged, the larger MSS is kept, if it has to be
+ * retransmitted, the old MSS is restored. Either way, the search continues
+ * in the remaining half of the range until it is smaller than
+ * TCP_PLPMTUD_SEARCH_DONE.
+ *
+ * @param pcb the tcp_pcb to search the MSS for
+ */
+void
+tcp_plpmtud_tmr(struct tcp_pcb *pcb)
+{
+  if (pcb->plpmtud_max == 0) {
+    pcb->plpmtud_max = pcb->mss;
+  }
+  if ((pcb->plpmtud_state != TCP_PLPMTUD_IDLE) ||
+      (pcb->mss + TCP_PLPMTUD_SEARCH_DONE > pcb->plpmtud_max)) {
+    return;
+  }
+  if (pcb->plpmtud_tmr > 1) {
+    pcb->plpmtud_tmr--;
+    return;
+  }
+  if (pcb->flags & (TF_RTO | TF_INFR)) {
+    /* wait until the connection has recovered from losses */
+    return;
+  }
+  if (pcb->plpmtud_high < pcb->mss + TCP_PLPMTUD_SEARCH_DONE) {
+    /* the last search is done, search the whole range again */
+    pcb->plpmtud_high = pcb->plpmtud_max;
+  }
+  pcb->plpmtud_low = pcb->mss;
+  pcb->mss = (u16_t)((pcb->mss + pcb->plpmtud_high + 1) / 2);
+  pcb->plpmtud_state = TCP_PLPMTUD_PROBE;
+  LWIP_DEBUGF(TCP_DEBUG, ("tcp_plpmtud: probing mss %"U16_F"\n", pcb->mss));
+}
+
+/**
+ * Called by tcp_receive() when the probe has been acknowledged: the probed
+ * MSS gets through.
+ *
+ * @param pcb the tcp_pcb that sent the probe
+ */
+void
+tcp_plpmtud_acked(struct tcp_pcb *pcb)
+{
+  LWIP_ASSERT("tcp_plpmtud_acked: no probe", pcb->plpmtud_state == TCP_PLPMTUD_INFLIGHT);
+  LWIP_DEBUGF(TCP_DEBUG, ("tcp_plpmtud: mss %"U16_F" confirmed\n", pcb->mss));
+  tcp_plpmtud_next(pcb);
+}
+
+/**
+ * Called when segments are retransmitted, by the retransmission timer
+ * (rto != 0, after the segments have been moved to pcb->unsent) or by fast
+ * retransmit. A probe in flight is taken as lost. If the retransmission timer
+ * fires TCP_PLPMTUD_BLACKHOLE_RTX times in a row for a full-sized segment,
+ * the path is assumed to drop segments of this size without sending ICMP
+ * messages (a PMTU black hole, RFC 4821 section 7.7), so the MSS falls back
+ * to TCP_PLPMTUD_BASE_MSS.
+ *
+ * @param pcb the tcp_pcb that retransmits
+ * @param rto != 0 if the retransmission timer fired
+ */
+void
+tcp_plpmtud_rexmit(struct tcp_pcb *pcb, u8_t rto)
+{
+  if (pcb->plpmtud_state == TCP_PLPMTUD_INFLIGHT) {
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_plpmtud: probe with mss %"U16_F" lost\n", pcb->mss));
+    pcb->plpmtud_high = (u16_t)(pcb->mss - 1);
+    tcp_reduce_mss(pcb, pcb->plpmtud_low);
+    tcp_plpmtud_next(pcb);
+  } else if (pcb->plpmtud_state == TCP_PLPMTUD_PROBE) {
+    /* no probe sent yet, so this says nothing about the probed MSS */
+    tcp_reduce_mss(pcb, pcb->plpmtud_low);
+    pcb->plpmtud_state = TCP_PLPMTUD_IDLE;
+  } else if (rto && (pcb->nrtx + 1 >= TCP_PLPMTUD_BLACKHOLE_RTX) &&
+             (pcb->mss > TCP_PLPMTUD_BASE_MSS) && (pcb->unsent != NULL) &&
+             (pcb->unsent->len + LWIP_TCP_OPT_LENGTH(pcb->unsent->flags) > TCP_PLPMTUD_BASE_MSS)) {
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_plpmtud: black hole detected at mss %"U16_F"\n", pcb->mss));
+    if (pcb->plpmtud_max == 0) {
+      pcb->plpmtud_max = pcb->mss;
+    }
+    pcb->plpmtud_high = (u16_t)(pcb->mss - 1);
+    tcp_reduce_mss(pcb, TCP_PLPMTUD_BASE_MSS);
+    tcp_plpmtud_next(pcb);
+  }
+}
+#endif /* TCP_PLPMTUD */
+
 /** Helper function for tcp_netif_ip_addr_changed() that iterates a pcb list */
 static void
 tcp_netif_ip_addr_changed_pcblist(const ip_addr_t *old_addr, struct tcp_pcb *pcb_list)
@@ -2390,6 +2710,440 @@ tcp_tcp_get_tcp_addrinfo(struct tcp_pcb *pcb, int local, ip_addr_t *addr, u16_t
   return ERR_VAL;
 }
 
+#if LWIP_TCP_INFO
+/**
+ * @ingroup tcp_raw
+ * Get statistics and state information of a connection.
+ * Can be used to find slow connections (high RTT, retransmissions,
+ * zero windows) without capturing packets.
+ *
+ * @param pcb the tcp_pcb to query (must not be a listening pcb)
+ * @param info filled with the current values
+ * @return ERR_OK on success, ERR_ARG for invalid arguments
+ */
+err_t
+tcp_get_info(const struct tcp_pcb *pcb, struct tcp_pcb_info *info)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("tcp_get_info: invalid pcb", pcb != NULL, return ERR_ARG);
+  LWIP_ERROR("tcp_get_info: invalid info", info != NULL, return ERR_ARG);
+  LWIP_ERROR("tcp_get_info: called for listen-pcb", pcb->state != LISTEN, return ERR_ARG);
+
+  memset(info, 0, sizeof(struct tcp_pcb_info));
+  info->state = (u8_t)pcb->state;
+  info->nrtx = pcb->nrtx;
+  info->dupacks = pcb->dupacks;
+  info->mss = pcb->mss;
+  /* sa is scaled by 8, sv by 4 (see tcp_receive) */
+  info->srtt = (u32_t)LWIP_MAX(pcb->sa >> 3, 0) * TCP_SLOW_INTERVAL;
+  info->rttvar = (u32_t)LWIP_MAX(pcb->sv >> 2, 0) * TCP_SLOW_INTERVAL;
+  info->rto = (u32_t)LWIP_MAX(pcb->rto, 0) * TCP_SLOW_INTERVAL;
+  info->cwnd = pcb->cwnd;
+  info->ssthresh = pcb->ssthresh;
+  info->snd_wnd = pcb->snd_wnd;
+  info->rcv_wnd = pcb->rcv_wnd;
+  if (pcb->state >= ESTABLISHED) {
+    info->bytes_in_flight = pcb->snd_nxt - pcb->lastack;
+    info->snd_queue = pcb->snd_lbb - pcb->lastack;
+    if (pcb->rcv_wnd < TCP_WND_MAX(pcb)) {
+      info->rcv_queue = (u32_t)(TCP_WND_MAX(pcb) - pcb->rcv_wnd);
+    }
+  }
+  info->snd_queuelen = pcb->snd_queuelen;
+  info->total_retrans = pcb->info_retrans;
+  info->total_dupacks = pcb->info_dupacks;
+  info->zero_wnd_events = pcb->info_zero_wnd;
+  return ERR_OK;
+}
+
+/**
+ * @ingroup tcp_raw
+ * Call a function for every active and TIME_WAIT pcb.
+ * Listening pcbs and pcbs that are only bound are not passed.
+ *
+ * @param fn function to call (must not close or abort the pcb!)
+ * @param arg argument passed to fn
+ */
+void
+tcp_pcb_foreach(tcp_pcb_iter_fn fn, void *arg)
+{
+  struct tcp_pcb *pcb;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("tcp_pcb_foreach: invalid fn", fn != NULL, return);
+
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+    fn(pcb, arg);
+  }
+  for (pcb = tcp_tw_pcbs; pcb != NULL; pcb = pcb->next) {
+    fn(pcb, arg);
+  }
+}
+#endif /* LWIP_TCP_INFO */
+
+#if LWIP_TCP_FASTOPEN
+/**
+ * @ingroup tcp_raw
+ * Enable or disable TCP Fast Open (RFC 7413) for passive opens.
+ * For a listening pcb (or a pcb that is later passed to tcp_listen()), this
+ * controls whether cookies are handed out and data in SYN segments carrying a
+ * valid cookie is accepted (the accept callback is then called right away and
+ * the data is passed to the recv callback before the handshake completes).
+ *
+ * Active opens use TCP_CONNECT_FLAG_FASTOPEN with @ref tcp_connect_flags.
+ *
+ * @param pcb the tcp_pcb to change
+ * @param enable 1 to enable, 0 to disable TCP Fast Open
+ */
+void
+tcp_fastopen(struct tcp_pcb *pcb, u8_t enable)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("tcp_fastopen: invalid pcb", pcb != NULL, return);
+
+  if (pcb->state == LISTEN) {
+    ((struct tcp_pcb_listen *)pcb)->fastopen = enable ? 1 : 0;
+  } else if (enable) {
+    tcp_set_flags(pcb, TF_FASTOPEN);
+  } else {
+    tcp_clear_flags(pcb, TF_FASTOPEN);
+  }
+}
+
+/**
+ * @ingroup tcp_raw
+ * Returns 1 if TCP Fast Open has been enabled for this pcb, 0 otherwise.
+ */
+u8_t
+tcp_fastopen_enabled(const struct tcp_pcb *pcb)
+{
+  LWIP_ERROR("tcp_fastopen_enabled: invalid pcb", pcb != NULL, return 0);
+
+  if (pcb->state == LISTEN) {
+    return ((const struct tcp_pcb_listen *)pcb)->fastopen;
+  }
+  return tcp_is_flag_set(pcb, TF_FASTOPEN) ? 1 : 0;
+}
+#endif /* LWIP_TCP_FASTOPEN */
+
+#if LWIP_TCP_FASTOPEN || LWIP_TCP_SYNCOOKIES
+/**
+ * @ingroup tcp_raw
+ * Set the 8 byte secret key used to generate TCP Fast Open cookies and
+ * SYN cookies.
+ * The key is initialized randomly by tcp_init() if LWIP_RAND is available;
+ * all hosts sharing a virtual address (anycast/load balancing) should use
+ * the same key. Changing the key invalidates all cookies handed out so far.
+ *
+ * @param key pointer to 8 bytes of secret key
+ */
+void
+tcp_set_secret_key(const u8_t *key)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("tcp_set_secret_key: invalid key", key != NULL, return);
+
+  MEMCPY(tcp_secret_key, key, sizeof(tcp_secret_key));
+}
+
+#define TCP_ROTL(x, b) (u32_t)(((x) << (b)) | ((x) >> (32 - (b))))
+#define TCP_SIPROUND(v0, v1, v2, v3) do { \
+  v0 += v1; v1 = TCP_ROTL(v1, 5);  v1 ^= v0; v0 = TCP_ROTL(v0, 16); \
+  v2 += v3; v3 = TCP_ROTL(v3, 8);  v3 ^= v2; \
+  v0 += v3; v3 = TCP_ROTL(v3, 7);  v3 ^= v0; \
+  v2 += v1; v1 = TCP_ROTL(v1, 13); v1 ^= v2; v2 = TCP_ROTL(v2, 16); } while(0)
+#define TCP_U8TO32_LE(p) \
+  (((u32_t)(p)[0]) | ((u32_t)(p)[1] << 8) | ((u32_t)(p)[2] << 16) | ((u32_t)(p)[3] << 24))
+
+/**
+ * Keyed hash (HalfSipHash-2-4) over data with the secret key set by
+ * tcp_set_secret_key().
+ *
+ * @param data data to hash
+ * @param len length of data
+ * @param out where to store the hash value (little endian)
+ * @param outlen length of the hash value, 4 or 8 bytes
+ */
+void
+tcp_keyed_hash(const void *data, u16_t len, u8_t *out, u8_t outlen)
+{
+  const u8_t *in = (const u8_t *)data;
+  u32_t k0 = TCP_U8TO32_LE(&tcp_secret_key[0]);
+  u32_t k1 = TCP_U8TO32_LE(&tcp_secret_key[4]);
+  u32_t v0 = k0;
+  u32_t v1 = k1;
+  u32_t v2 = 0x6c796765UL ^ k0;
+  u32_t v3 = 0x74656462UL ^ k1;
+  u32_t b = (u32_t)len << 24;
+  u32_t m;
+  u8_t left = (u8_t)(len & 3);
+  u8_t i, j;
+
+  LWIP_ASSERT("tcp_keyed_hash: invalid outlen", (outlen == 4) || (outlen == 8));
+
+  if (outlen == 8) {
+    v1 ^= 0xee;
+  }
+  for (; len >= 4; len = (u16_t)(len - 4), in += 4) {
+    m = TCP_U8TO32_LE(in);
+    v3 ^= m;
+    TCP_SIPROUND(v0, v1, v2, v3);
+    TCP_SIPROUND(v0, v1, v2, v3);
+    v0 ^= m;
+  }
+  if (left >= 3) {
+    b |= (u32_t)in[2] << 16;
+  }
+  if (left >= 2) {
+    b |= (u32_t)in[1] << 8;
+  }
+  if (left >= 1) {
+    b |= in[0];
+  }
+  v3 ^= b;
+  TCP_SIPROUND(v0, v1, v2, v3);
+  TCP_SIPROUND(v0, v1, v2, v3);
+  v0 ^= b;
+  v2 ^= (outlen == 8) ? 0xee : 0xff;
+  for (j = 0; j < outlen; j += 4) {
+    if (j != 0) {
+      v1 ^= 0xdd;
+    }
+    for (i = 0; i < 4; i++) {
+      TCP_SIPROUND(v0, v1, v2, v3);
+    }
+    b = v1 ^ v3;
+    out[j] = (u8_t)b;
+    out[j + 1] = (u8_t)(b >> 8);
+    out[j + 2] = (u8_t)(b >> 16);
+    out[j + 3] = (u8_t)(b >> 24);
+  }
+}
+
+#endif /* LWIP_TCP_FASTOPEN || LWIP_TCP_SYNCOOKIES */
+
+#if LWIP_TCP_SYNCOOKIES
+/* SYN cookie layout (the ISS of the <SYN,ACK>):
+ * 31..27: time counter (64 seconds per step), 26..25: MSS index,
+ * 24..21: window scale, 20: SACK permitted, 19: timestamps, 18..0: keyed hash */
+#define TCP_SYNCOOKIE_PERIOD    (64000 / TCP_SLOW_INTERVAL)
+#define TCP_SYNCOOKIE_HASH_MASK 0x0007FFFFUL
+static const u16_t tcp_syncookie_mss[] = {536, 1220, 1440, 1460};
+
+static u32_t
+tcp_syncookie_hash(const ip_addr_t *local_ip, const ip_addr_t *remote_ip,
+                   u16_t local_port, u16_t remote_port, u32_t irs, u32_t bits)
+{
+  u8_t buf[2 * 16 + 3 * 4];
+  u8_t hash[4];
+  u16_t len = 0;
+
+#if LWIP_IPV6
+  if (IP_IS_V6(remote_ip)) {
+    MEMCPY(&buf[len], ip_2_ip6(local_ip)->addr, 16);
+    MEMCPY(&buf[len + 16], ip_2_ip6(remote_ip)->addr, 16);
+    len = 32;
+  } else
+#endif /* LWIP_IPV6 */
+  {
+#if LWIP_IPV4
+    MEMCPY(&buf[len], &ip_2_ip4(local_ip)->addr, 4);
+    MEMCPY(&buf[len + 4], &ip_2_ip4(remote_ip)->addr, 4);
+    len = 8;
+#endif /* LWIP_IPV4 */
+  }
+  buf[len++] = (u8_t)(local_port >> 8);
+  buf[len++] = (u8_t)local_port;
+  buf[len++] = (u8_t)(remote_port >> 8);
+  buf[len++] = (u8_t)remote_port;
+  buf[len++] = (u8_t)(irs >> 24);
+  buf[len++] = (u8_t)(irs >> 16);
+  buf[len++] = (u8_t)(irs >> 8);
+  buf[len++] = (u8_t)irs;
+  buf[len++] = (u8_t)(bits >> 24);
+  buf[len++] = (u8_t)(bits >> 16);
+  buf[len++] = (u8_t)(bits >> 8);
+  buf[len++] = (u8_t)bits;
+  tcp_keyed_hash(buf, len, hash, sizeof(hash));
+  return TCP_U8TO32_LE(hash) & TCP_SYNCOOKIE_HASH_MASK;
+}
+
+/**
+ * Create a SYN cookie (the ISS to use in a stateless <SYN,ACK>).
+ *
+ * @param local_ip local address of the connection
+ * @param remote_ip remote address of the connection
+ * @param local_port local port of the connection
+ * @param remote_port remote port of the connection
+ * @param irs the sequence number of the received SYN
+ * @param mss MSS announced in the SYN, set to the value that is encoded
+ * @param wscale window scale of the SYN or TCP_SYNCOOKIE_NO_WSCALE
+ * @param sack 1 if the SYN carried the SACK_PERM option
+ * @param ts 1 if the SYN carried the timestamp option (and it is answered)
+ * @return the SYN cookie
+ */
+u32_t
+tcp_syncookie_create(const ip_addr_t *local_ip, const ip_addr_t *remote_ip,
+                     u16_t local_port, u16_t remote_port, u32_t irs,
+                     u16_t *mss, u8_t wscale, u8_t sack, u8_t ts)
+{
+  u32_t bits;
+  u8_t idx;
+
+  /* largest table entry not exceeding the remote MSS */
+  for (idx = LWIP_ARRAYSIZE(tcp_syncookie_mss) - 1; idx > 0; idx--) {
+    if (tcp_syncookie_mss[idx] <= *mss) {
+      break;
+    }
+  }
+  *mss = tcp_syncookie_mss[idx];
+
+  bits = ((tcp_ticks / TCP_SYNCOOKIE_PERIOD) & 0x1F) << 27;
+  bits |= (u32_t)idx << 25;
+  bits |= (u32_t)(LWIP_MIN(wscale, TCP_SYNCOOKIE_NO_WSCALE) & 0x0F) << 21;
+  bits |= (u32_t)(sack ? 1 : 0) << 20;
+  bits |= (u32_t)(ts ? 1 : 0) << 19;
+  return bits | tcp_syncookie_hash(local_ip, remote_ip, local_port, remote_port, irs, bits);
+}
+
+/**
+ * Check a SYN cookie returned in the ACK of a handshake and decode it.
+ *
+ * @param local_ip local address of the connection
+ * @param remote_ip remote address of the connection
+ * @param local_port local port of the connection
+ * @param remote_port remote port of the connection
+ * @param irs the sequence number of the SYN (seqno of the ACK - 1)
+ * @param cookie the cookie (ackno of the ACK - 1)
+ * @param mss returns the MSS encoded in the cookie
+ * @param wscale returns the window scale (or TCP_SYNCOOKIE_NO_WSCALE)
+ * @param sack returns 1 if SACK is permitted
+ * @param ts returns 1 if timestamps have been negotiated
+ * @return 1 if the cookie is valid and not older than 2 periods, 0 otherwise
+ */
+u8_t
+tcp_syncookie_check(const ip_addr_t *local_ip, const ip_addr_t *remote_ip,
+                    u16_t local_port, u16_t remote_port, u32_t irs, u32_t cookie,
+                    u16_t *mss, u8_t *wscale, u8_t *sack, u8_t *ts)
+{
+  u32_t bits = cookie & ~TCP_SYNCOOKIE_HASH_MASK;
+  u32_t age = ((tcp_ticks / TCP_SYNCOOKIE_PERIOD) - (cookie >> 27)) & 0x1F;
+  u8_t idx = (u8_t)((cookie >> 25) & 3);
+
+  if ((age > 1) ||
+      ((cookie & TCP_SYNCOOKIE_HASH_MASK) !=
+       tcp_syncookie_hash(local_ip, remote_ip, local_port, remote_port, irs, bits))) {
+    return 0;
+  }
+  *mss = tcp_syncookie_mss[idx];
+  *wscale = (u8_t)((cookie >> 21) & 0x0F);
+  *sack = (u8_t)((cookie >> 20) & 1);
+  *ts = (u8_t)((cookie >> 19) & 1);
+  return 1;
+}
+
+/**
+ * Called when a connection pcb leaves SYN_RCVD state (or is removed):
+ * decreases the SYN queue length of its listener.
+ *
+ * @param pcb the connection pcb
+ */
+void
+tcp_syn_queue_remove(struct tcp_pcb *pcb)
+{
+  if ((pcb->flags & TF_SYNQUEUED) != 0) {
+    if (pcb->listener != NULL) {
+      LWIP_ASSERT("syn_queued != 0", pcb->listener->syn_queued != 0);
+      pcb->listener->syn_queued--;
+    }
+    tcp_clear_flags(pcb, TF_SYNQUEUED);
+  }
+}
+#endif /* LWIP_TCP_SYNCOOKIES */
+
+#if LWIP_TCP_FASTOPEN
+/**
+ * Generate the TCP Fast Open cookie for a client address.
+ *
+ * @param addr remote (client) address
+ * @param cookie where to store the cookie (TCP_FASTOPEN_COOKIE_LEN bytes)
+ */
+void
+tcp_fastopen_cookie(const ip_addr_t *addr, u8_t *cookie)
+{
+#if LWIP_IPV6
+  if (IP_IS_V6(addr)) {
+    tcp_keyed_hash(ip_2_ip6(addr)->addr, sizeof(ip_2_ip6(addr)->addr), cookie, TCP_FASTOPEN_COOKIE_LEN);
+    return;
+  }
+#endif /* LWIP_IPV6 */
+#if LWIP_IPV4
+  tcp_keyed_hash(&ip_2_ip4(addr)->addr, sizeof(ip_2_ip4(addr)->addr), cookie, TCP_FASTOPEN_COOKIE_LEN);
+#endif /* LWIP_IPV4 */
+}
+
+/**
+ * Look up the cached TCP Fast Open cookie of a remote host.
+ *
+ * @param addr remote (server) address
+ * @param cookie where to store the cookie (TCP_FASTOPEN_COOKIE_LEN bytes)
+ * @return length of the cookie or 0 if no cookie is known for addr
+ */
+u8_t
+tcp_fastopen_cache_get(const ip_addr_t *addr, u8_t *cookie)
+{
+  u8_t i;
+
+  for (i = 0; i < TCP_FASTOPEN_CACHE_SIZE; i++) {
+    struct tcp_fastopen_cache_entry *e = &tcp_fastopen_cache[i];
+    if ((e->len != 0) && ip_addr_eq(&e->addr, addr)) {
+      MEMCPY(cookie, e->cookie, e->len);
+      return e->len;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Store the TCP Fast Open cookie received from a remote host.
+ *
+ * @param addr remote (server) address
+ * @param cookie the cookie
+ * @param len length of the cookie (0 to remove the cached cookie)
+ */
+void
+tcp_fastopen_cache_set(const ip_addr_t *addr, const u8_t *cookie, u8_t len)
+{
+  struct tcp_fastopen_cache_entry *e = NULL;
+  u8_t i;
+
+  LWIP_ASSERT("tcp_fastopen_cache_set: invalid len", len <= TCP_FASTOPEN_COOKIE_LEN);
+
+  for (i = 0; i < TCP_FASTOPEN_CACHE_SIZE; i++) {
+    if ((tcp_fastopen_cache[i].len != 0) && ip_addr_eq(&tcp_fastopen_cache[i].addr, addr)) {
+      e = &tcp_fastopen_cache[i];
+      break;
+    }
+  }
+  if (e == NULL) {
+    if (len == 0) {
+      return;
+    }
+    e = &tcp_fastopen_cache[tcp_fastopen_cache_next];
+    tcp_fastopen_cache_next = (u8_t)((tcp_fastopen_cache_next + 1) % TCP_FASTOPEN_CACHE_SIZE);
+  }
+  ip_addr_copy(e->addr, *addr);
+  e->len = len;
+  if (len != 0) {
+    MEMCPY(e->cookie, cookie, len);
+  }
+}
+#endif /* LWIP_TCP_FASTOPEN */
+
 #if TCP_QUEUE_OOSEQ
 /* Free all ooseq pbufs (and possibly reset SACK state) */
 void
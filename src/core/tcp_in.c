@@ -85,6 +85,12 @@ static u8_t flags;
 static u8_t recv_flags;
 static struct pbuf *recv_data;
 
+#if LWIP_TCP_FASTOPEN
+/* Length of the TCP Fast Open option cookie in the current SYN (-1: no option) */
+static s8_t tcp_fastopen_optlen;
+static u8_t tcp_fastopen_optcookie[TCP_FASTOPEN_COOKIE_LEN];
+#endif /* LWIP_TCP_FASTOPEN */
+
 struct tcp_pcb *tcp_input_pcb;
 
 /* Forward declarations. */
@@ -92,8 +98,17 @@ static err_t tcp_process(struct tcp_pcb *pcb);
 static void tcp_receive(struct tcp_pcb *pcb);
 static void tcp_parseopt(struct tcp_pcb *pcb);
 
-static void tcp_listen_input(struct tcp_pcb_listen *pcb);
+static struct tcp_pcb *tcp_listen_input(struct tcp_pcb_listen *pcb, struct pbuf *p);
+static struct tcp_pcb *tcp_listen_alloc_pcb(struct tcp_pcb_listen *pcb);
+#if LWIP_TCP_SYNCOOKIES
+static void tcp_listen_syncookie_synack(void);
+static struct tcp_pcb *tcp_listen_syncookie_ack(struct tcp_pcb_listen *pcb, u16_t mss, u8_t wscale, u8_t sack, u8_t ts);
+static void tcp_syncookie_parseopt(u16_t *mss, u8_t *wscale, u8_t *sack, u8_t *ts, u32_t *tsval);
+#endif /* LWIP_TCP_SYNCOOKIES */
 static void tcp_timewait_input(struct tcp_pcb *pcb);
+#if LWIP_TCP_FASTOPEN
+static err_t tcp_fastopen_accept_syn_data(struct tcp_pcb *pcb, struct pbuf *p);
+#endif /* LWIP_TCP_FASTOPEN */
 
 static int tcp_input_delayed_close(struct tcp_pcb *pcb);
 
@@ -377,10 +392,14 @@ tcp_input(struct pbuf *p, struct netif *inp)
                                      tcphdr_opt1len, tcphdr_opt2, p) == ERR_OK)
 #endif
       {
-        tcp_listen_input(lpcb);
+        pcb = tcp_listen_input(lpcb, p);
       }
-      pbuf_free(p);
-      return;
+      if (pcb == NULL) {
+        pbuf_free(p);
+        return;
+      }
+      /* the ACK completing a SYN cookie handshake created a pcb in SYN_RCVD
+         state: process the segment for that pcb */
     }
   }
 
@@ -622,20 +641,30 @@ tcp_input_delayed_close(struct tcp_pcb *pcb)
  * connection (from tcp_input()).
  *
  * @param pcb the tcp_pcb_listen for which a segment arrived
+ * @param p the received segment (payload pointing to the data), data in a SYN
+ *          is passed to the application if TCP Fast Open is enabled
  *
- * @note the segment which arrived is saved in global variables, therefore only the pcb
- *       involved is passed as a parameter to this function
+ * @return a new pcb in SYN_RCVD state if the segment is the ACK of a SYN
+ *         cookie handshake (the segment has to be processed for it), NULL if
+ *         the segment has been handled
+ *
+ * @note the rest of the segment which arrived is saved in global variables
  */
-static void
-tcp_listen_input(struct tcp_pcb_listen *pcb)
+static struct tcp_pcb *
+tcp_listen_input(struct tcp_pcb_listen *pcb, struct pbuf *p)
 {
   struct tcp_pcb *npcb;
   u32_t iss;
   err_t rc;
+#if LWIP_TCP_FASTOPEN
+  struct pbuf *syn_data = NULL;
+#else
+  LWIP_UNUSED_ARG(p);
+#endif /* LWIP_TCP_FASTOPEN */
 
   if (flags & TCP_RST) {
     /* An incoming RST should be ignored. Return. */
-    return;
+    return NULL;
   }
 
   LWIP_ASSERT("tcp_listen_input: invalid pcb", pcb != NULL);
@@ -643,41 +672,60 @@ tcp_listen_input(struct tcp_pcb_listen *pcb)
   /* In the LISTEN state, we check for incoming SYN segments,
      creates a new PCB, and responds with a SYN|ACK. */
   if (flags & TCP_ACK) {
+#if LWIP_TCP_SYNCOOKIES
+    u16_t mss;
+    u8_t wscale, sack, ts;
+    if (!(flags & TCP_SYN) &&
+        tcp_syncookie_check(ip_current_dest_addr(), ip_current_src_addr(), tcphdr->dest, tcphdr->src,
+                            seqno - 1, ackno - 1, &mss, &wscale, &sack, &ts)) {
+      /* ACK for a <SYN,ACK> carrying a SYN cookie */
+      return tcp_listen_syncookie_ack(pcb, mss, wscale, sack, ts);
+    }
+#endif /* LWIP_TCP_SYNCOOKIES */
     /* For incoming segments with the ACK flag set, respond with a
        RST. */
     LWIP_DEBUGF(TCP_RST_DEBUG, ("tcp_listen_input: ACK in LISTEN, sending reset\n"));
     tcp_rst_netif(ip_data.current_input_netif, ackno, seqno + tcplen, ip_current_dest_addr(),
             ip_current_src_addr(), tcphdr->dest, tcphdr->src);
   } else if (flags & TCP_SYN) {
+#if LWIP_TCP_SYNCOOKIES
+    u16_t syn_queued = pcb->syn_queued;
+    u8_t use_cookie = (syn_queued >= TCP_SYN_QUEUE_LEN);
+#endif /* LWIP_TCP_SYNCOOKIES */
     LWIP_DEBUGF(TCP_DEBUG, ("TCP connection request %"U16_F" -> %"U16_F".\n", tcphdr->src, tcphdr->dest));
 #if TCP_LISTEN_BACKLOG
     if (pcb->accepts_pending >= pcb->backlog) {
-      LWIP_DEBUGF(TCP_DEBUG, ("tcp_listen_input: listen backlog exceeded for port %"U16_F"\n", tcphdr->dest));
-      return;
+#if LWIP_TCP_SYNCOOKIES
+      /* half-open connections don't count against the backlog when
+         SYN cookies can be used instead */
+      if ((int)pcb->accepts_pending - (int)syn_queued < (int)pcb->backlog) {
+        use_cookie = 1;
+      } else
+#endif /* LWIP_TCP_SYNCOOKIES */
+      {
+        LWIP_DEBUGF(TCP_DEBUG, ("tcp_listen_input: listen backlog exceeded for port %"U16_F"\n", tcphdr->dest));
+        return NULL;
+      }
     }
 #endif /* TCP_LISTEN_BACKLOG */
-    npcb = tcp_alloc(pcb->prio);
+#if LWIP_TCP_SYNCOOKIES
+    if (use_cookie) {
+      /* SYN queue full: answer without allocating a pcb */
+      tcp_listen_syncookie_synack();
+      return NULL;
+    }
+#endif /* LWIP_TCP_SYNCOOKIES */
+    npcb = tcp_listen_alloc_pcb(pcb);
     /* If a new PCB could not be created (probably due to lack of memory),
        we don't do anything, but rely on the sender will retransmit the
        SYN at a time when we have more memory available. */
     if (npcb == NULL) {
-      err_t err;
-      LWIP_DEBUGF(TCP_DEBUG, ("tcp_listen_input: could not allocate PCB\n"));
-      TCP_STATS_INC(tcp.memerr);
-      TCP_EVENT_ACCEPT(pcb, NULL, pcb->callback_arg, ERR_MEM, err);
-      LWIP_UNUSED_ARG(err); /* err not useful here */
-      return;
+      return NULL;
     }
-#if TCP_LISTEN_BACKLOG
-    pcb->accepts_pending++;
-    tcp_set_flags(npcb, TF_BACKLOGPEND);
-#endif /* TCP_LISTEN_BACKLOG */
-    /* Set up the new PCB. */
-    ip_addr_copy(npcb->local_ip, *ip_current_dest_addr());
-    ip_addr_copy(npcb->remote_ip, *ip_current_src_addr());
-    npcb->local_port = pcb->local_port;
-    npcb->remote_port = tcphdr->src;
-    npcb->state = SYN_RCVD;
+#if LWIP_TCP_SYNCOOKIES
+    pcb->syn_queued++;
+    tcp_set_flags(npcb, TF_SYNQUEUED);
+#endif /* LWIP_TCP_SYNCOOKIES */
     npcb->rcv_nxt = seqno + 1;
     npcb->rcv_ann_right_edge = npcb->rcv_nxt;
     iss = tcp_next_iss(npcb);
@@ -686,16 +734,6 @@ tcp_listen_input(struct tcp_pcb_listen *pcb)
     npcb->lastack = iss;
     npcb->snd_lbb = iss;
     npcb->snd_wl1 = seqno - 1;/* initialise to seqno-1 to force window update */
-    npcb->callback_arg = pcb->callback_arg;
-#if LWIP_CALLBACK_API || TCP_LISTEN_BACKLOG
-    npcb->listener = pcb;
-#endif /* LWIP_CALLBACK_API || TCP_LISTEN_BACKLOG */
-#if LWIP_VLAN_PCP
-    npcb->netif_hints.tci = pcb->netif_hints.tci;
-#endif /* LWIP_VLAN_PCP */
-    /* inherit socket options */
-    npcb->so_options = pcb->so_options & SOF_INHERITED;
-    npcb->netif_idx = pcb->netif_idx;
     /* Register the new PCB so that we can begin receiving segments
        for it. */
     TCP_REG_ACTIVE(npcb);
@@ -709,12 +747,30 @@ tcp_listen_input(struct tcp_pcb_listen *pcb)
     npcb->mss = tcp_eff_send_mss(npcb->mss, &npcb->local_ip, &npcb->remote_ip);
 #endif /* TCP_CALCULATE_EFF_SEND_MSS */
 
+#if LWIP_TCP_FASTOPEN
+    if (pcb->fastopen && (tcp_fastopen_optlen >= 0)) {
+      u8_t cookie[TCP_FASTOPEN_COOKIE_LEN];
+      tcp_fastopen_cookie(&npcb->remote_ip, cookie);
+      if ((tcp_fastopen_optlen == TCP_FASTOPEN_COOKIE_LEN) &&
+          (memcmp(cookie, tcp_fastopen_optcookie, TCP_FASTOPEN_COOKIE_LEN) == 0)) {
+        /* valid cookie: data in the SYN can be accepted right away */
+        if ((p->tot_len > 0) && (p->tot_len <= npcb->rcv_wnd)) {
+          syn_data = p;
+        }
+      } else {
+        /* cookie request or invalid cookie: send a (new) cookie in <SYN,ACK> */
+        MEMCPY(npcb->tfo_cookie, cookie, TCP_FASTOPEN_COOKIE_LEN);
+        npcb->tfo_cookie_len = TCP_FASTOPEN_COOKIE_LEN;
+      }
+    }
+#endif /* LWIP_TCP_FASTOPEN */
+
     MIB2_STATS_INC(mib2.tcppassiveopens);
 
 #if LWIP_TCP_PCB_NUM_EXT_ARGS
     if (tcp_ext_arg_invoke_callbacks_passive_open(pcb, npcb) != ERR_OK) {
       tcp_abandon(npcb, 0);
-      return;
+      return NULL;
     }
 #endif
 
@@ -722,12 +778,223 @@ tcp_listen_input(struct tcp_pcb_listen *pcb)
     rc = tcp_enqueue_flags(npcb, TCP_SYN | TCP_ACK);
     if (rc != ERR_OK) {
       tcp_abandon(npcb, 0);
-      return;
+      return NULL;
+    }
+#if LWIP_TCP_FASTOPEN
+    if (syn_data != NULL) {
+      if (tcp_fastopen_accept_syn_data(npcb, syn_data) == ERR_ABRT) {
+        return NULL;
+      }
     }
+#endif /* LWIP_TCP_FASTOPEN */
     tcp_output(npcb);
   }
-  return;
+  return NULL;
+}
+
+/**
+ * Allocate a pcb for a connection request to a listening pcb and set it up
+ * in SYN_RCVD state (except for sequence numbers and options).
+ *
+ * @param pcb the tcp_pcb_listen for which a segment arrived
+ * @return the new pcb (not registered yet) or NULL if out of memory
+ */
+static struct tcp_pcb *
+tcp_listen_alloc_pcb(struct tcp_pcb_listen *pcb)
+{
+  struct tcp_pcb *npcb;
+
+  npcb = tcp_alloc(pcb->prio);
+  if (npcb == NULL) {
+    err_t err;
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_listen_input: could not allocate PCB\n"));
+    TCP_STATS_INC(tcp.memerr);
+    TCP_EVENT_ACCEPT(pcb, NULL, pcb->callback_arg, ERR_MEM, err);
+    LWIP_UNUSED_ARG(err); /* err not useful here */
+    return NULL;
+  }
+#if TCP_LISTEN_BACKLOG
+  pcb->accepts_pending++;
+  tcp_set_flags(npcb, TF_BACKLOGPEND);
+#endif /* TCP_LISTEN_BACKLOG */
+  /* Set up the new PCB. */
+  ip_addr_copy(npcb->local_ip, *ip_current_dest_addr());
+  ip_addr_copy(npcb->remote_ip, *ip_current_src_addr());
+  npcb->local_port = pcb->local_port;
+  npcb->remote_port = tcphdr->src;
+  npcb->state = SYN_RCVD;
+  npcb->callback_arg = pcb->callback_arg;
+#if LWIP_CALLBACK_API || TCP_LISTEN_BACKLOG
+  npcb->listener = pcb;
+#endif /* LWIP_CALLBACK_API || TCP_LISTEN_BACKLOG */
+#if LWIP_VLAN_PCP
+  npcb->netif_hints.tci = pcb->netif_hints.tci;
+#endif /* LWIP_VLAN_PCP */
+  /* inherit socket options */
+  npcb->so_options = pcb->so_options & SOF_INHERITED;
+  npcb->netif_idx = pcb->netif_idx;
+  return npcb;
+}
+
+#if LWIP_TCP_SYNCOOKIES
+/** Answer the SYN in the global variables with a SYN cookie */
+static void
+tcp_listen_syncookie_synack(void)
+{
+  u16_t mss = 536; /* RFC 9293 default if no MSS option */
+  u8_t wscale = TCP_SYNCOOKIE_NO_WSCALE;
+  u8_t sack = 0;
+  u8_t ts = 0;
+  u32_t tsval = 0;
+  u32_t cookie;
+
+  tcp_syncookie_parseopt(&mss, &wscale, &sack, &ts, &tsval);
+  cookie = tcp_syncookie_create(ip_current_dest_addr(), ip_current_src_addr(), tcphdr->dest, tcphdr->src,
+                                seqno, &mss, wscale, sack, ts);
+  tcp_syncookie_synack(ip_data.current_input_netif, cookie, seqno + 1, ip_current_dest_addr(),
+                       ip_current_src_addr(), tcphdr->dest, tcphdr->src, wscale, sack, ts, tsval);
+}
+
+/**
+ * Create the pcb for a connection whose SYN was answered with a SYN cookie
+ * after its ACK has been validated.
+ *
+ * @param pcb the tcp_pcb_listen for which the ACK arrived
+ * @param mss the MSS decoded from the cookie
+ * @param wscale the window scale decoded from the cookie
+ * @param sack 1 if SACK is permitted
+ * @param ts 1 if the timestamp option has been answered in the <SYN,ACK>
+ * @return the new pcb in SYN_RCVD state or NULL if the ACK is dropped
+ */
+static struct tcp_pcb *
+tcp_listen_syncookie_ack(struct tcp_pcb_listen *pcb, u16_t mss, u8_t wscale, u8_t sack, u8_t ts)
+{
+  struct tcp_pcb *npcb;
+#if LWIP_TCP_TIMESTAMPS
+  u16_t opt_mss = 0;
+  u8_t opt_wscale = 0, opt_sack = 0, opt_ts = 0;
+  u32_t tsval = 0;
+#endif /* LWIP_TCP_TIMESTAMPS */
+
+#if TCP_LISTEN_BACKLOG
+  if (pcb->accepts_pending >= pcb->backlog) {
+    /* the peer will retransmit (or time out) */
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_listen_input: listen backlog exceeded for port %"U16_F"\n", tcphdr->dest));
+    return NULL;
+  }
+#endif /* TCP_LISTEN_BACKLOG */
+  npcb = tcp_listen_alloc_pcb(pcb);
+  if (npcb == NULL) {
+    return NULL;
+  }
+  /* the <SYN,ACK> has been sent: set up the state it created */
+  npcb->rcv_nxt = seqno;
+  npcb->rcv_ann_right_edge = npcb->rcv_nxt;
+  npcb->snd_wl2 = ackno - 1;
+  npcb->lastack = ackno - 1;
+  npcb->snd_nxt = ackno;
+  npcb->snd_lbb = ackno;
+  npcb->snd_wl1 = seqno - 2; /* SYN seqno - 1 to force window update */
+  npcb->mss = LWIP_MIN(mss, TCP_MSS);
+#if LWIP_WND_SCALE
+  if (wscale != TCP_SYNCOOKIE_NO_WSCALE) {
+    npcb->snd_scale = LWIP_MIN(wscale, 14);
+    npcb->rcv_scale = TCP_RCV_SCALE;
+    tcp_set_flags(npcb, TF_WND_SCALE);
+    npcb->rcv_wnd = npcb->rcv_ann_wnd = TCP_WND;
+  }
+#else
+  LWIP_UNUSED_ARG(wscale);
+#endif /* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK_OUT
+  if (sack) {
+    tcp_set_flags(npcb, TF_SACK);
+  }
+#else
+  LWIP_UNUSED_ARG(sack);
+#endif /* LWIP_TCP_SACK_OUT */
+#if LWIP_TCP_TIMESTAMPS
+  if (ts) {
+    /* the timestamp of the ACK is the one to echo next */
+    tcp_syncookie_parseopt(&opt_mss, &opt_wscale, &opt_sack, &opt_ts, &tsval);
+    if (opt_ts) {
+      npcb->ts_recent = tsval;
+      npcb->ts_lastacksent = npcb->rcv_nxt;
+      tcp_set_flags(npcb, TF_TIMESTAMP);
+    }
+  }
+#else
+  LWIP_UNUSED_ARG(ts);
+#endif /* LWIP_TCP_TIMESTAMPS */
+  TCP_REG_ACTIVE(npcb);
+
+#if TCP_CALCULATE_EFF_SEND_MSS
+  npcb->mss = tcp_eff_send_mss(npcb->mss, &npcb->local_ip, &npcb->remote_ip);
+#endif /* TCP_CALCULATE_EFF_SEND_MSS */
+
+  MIB2_STATS_INC(mib2.tcppassiveopens);
+
+#if LWIP_TCP_PCB_NUM_EXT_ARGS
+  if (tcp_ext_arg_invoke_callbacks_passive_open(pcb, npcb) != ERR_OK) {
+    tcp_abandon(npcb, 0);
+    return NULL;
+  }
+#endif
+  return npcb;
 }
+#endif /* LWIP_TCP_SYNCOOKIES */
+
+#if LWIP_TCP_FASTOPEN
+/**
+ * Called by tcp_listen_input() for a SYN with a valid TCP Fast Open cookie:
+ * accepts the connection before the handshake completes (so that the
+ * <SYN,ACK> acknowledges the data) and passes the SYN data to the
+ * application.
+ *
+ * @param pcb the new tcp_pcb in SYN_RCVD state
+ * @param p the data received with the SYN
+ * @return ERR_ABRT if the pcb has been aborted, ERR_OK otherwise
+ */
+static err_t
+tcp_fastopen_accept_syn_data(struct tcp_pcb *pcb, struct pbuf *p)
+{
+  err_t err;
+
+  pcb->rcv_nxt += p->tot_len;
+  pcb->rcv_wnd -= p->tot_len;
+  tcp_update_rcv_ann_wnd(pcb);
+  tcp_set_flags(pcb, TF_FASTOPEN_ACC);
+  /* RFC 7413: the server may send data before the handshake completes */
+  pcb->cwnd = LWIP_TCP_CALC_INITIAL_CWND(pcb->mss);
+  LWIP_DEBUGF(TCP_DEBUG, ("tcp_fastopen_accept_syn_data: %"U16_F" bytes accepted\n", p->tot_len));
+
+#if LWIP_CALLBACK_API
+  LWIP_ASSERT("pcb->listener->accept != NULL", pcb->listener->accept != NULL);
+#endif
+  tcp_backlog_accepted(pcb);
+  TCP_EVENT_ACCEPT(pcb->listener, pcb, pcb->callback_arg, ERR_OK, err);
+  if (err != ERR_OK) {
+    /* Already aborted? */
+    if (err != ERR_ABRT) {
+      tcp_abort(pcb);
+    }
+    return ERR_ABRT;
+  }
+
+  /* the caller frees p */
+  pbuf_ref(p);
+  if (flags & TCP_PSH) {
+    p->flags |= PBUF_FLAG_PUSH;
+  }
+  TCP_EVENT_RECV(pcb, p, ERR_OK, err);
+  if (err == ERR_ABRT) {
+    return ERR_ABRT;
+  } else if (err != ERR_OK) {
+    pcb->refused_data = p;
+  }
+  return ERR_OK;
+}
+#endif /* LWIP_TCP_FASTOPEN */
 
 /**
  * Called by tcp_input() when a segment arrives for a connection in
@@ -867,7 +1134,34 @@ tcp_process(struct tcp_pcb *pcb)
                                     pcb->unacked ? lwip_ntohl(pcb->unacked->tcphdr->seqno) : 0));
       /* received SYN ACK with expected sequence number? */
       if ((flags & TCP_ACK) && (flags & TCP_SYN)
-          && (ackno == pcb->lastack + 1)) {
+          && ((ackno == pcb->lastack + 1)
+#if LWIP_TCP_FASTOPEN
+              /* or acknowledging data sent with the SYN */
+              || ((ackno == pcb->snd_nxt) && TCP_SEQ_GT(ackno, pcb->lastack + 1))
+#endif /* LWIP_TCP_FASTOPEN */
+             )) {
+#if LWIP_TCP_FASTOPEN
+        struct tcp_seg *rexmit_seg = NULL;
+        rseg = (pcb->unacked != NULL) ? pcb->unacked : pcb->unsent;
+        LWIP_ASSERT("no segment to free", rseg != NULL);
+        if ((rseg->len > 0) && (ackno == pcb->lastack + 1)) {
+          /* data sent with the SYN was not accepted, send it again */
+          rexmit_seg = tcp_fastopen_syn_data_seg(pcb, rseg);
+          if (rexmit_seg == NULL) {
+            /* drop the <SYN,ACK>, it will be retransmitted */
+            break;
+          }
+        }
+        if (tcp_fastopen_optlen > 0) {
+          /* remember the cookie for the next connection to this host */
+          if ((tcp_fastopen_optlen >= LWIP_TCP_OPT_LEN_FASTOPEN_MIN) && !(tcp_fastopen_optlen & 1)) {
+            tcp_fastopen_cache_set(&pcb->remote_ip, tcp_fastopen_optcookie, (u8_t)tcp_fastopen_optlen);
+          }
+        } else if (rexmit_seg != NULL) {
+          /* the server does not support (or has disabled) TCP Fast Open */
+          tcp_fastopen_cache_set(&pcb->remote_ip, NULL, 0);
+        }
+#endif /* LWIP_TCP_FASTOPEN */
         pcb->rcv_nxt = seqno + 1;
         pcb->rcv_ann_right_edge = pcb->rcv_nxt;
         pcb->lastack = ackno;
@@ -884,9 +1178,6 @@ tcp_process(struct tcp_pcb *pcb)
         LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_process (SENT): cwnd %"TCPWNDSIZE_F
                                      " ssthresh %"TCPWNDSIZE_F"\n",
                                      pcb->cwnd, pcb->ssthresh));
-        LWIP_ASSERT("pcb->snd_queuelen > 0", (pcb->snd_queuelen > 0));
-        --pcb->snd_queuelen;
-        LWIP_DEBUGF(TCP_QLEN_DEBUG, ("tcp_process: SYN-SENT --queuelen %"TCPWNDSIZE_F"\n", (tcpwnd_size_t)pcb->snd_queuelen));
         rseg = pcb->unacked;
         if (rseg == NULL) {
           /* might happen if tcp_output fails in tcp_rexmit_rto()
@@ -897,6 +1188,27 @@ tcp_process(struct tcp_pcb *pcb)
         } else {
           pcb->unacked = rseg->next;
         }
+#if LWIP_TCP_FASTOPEN
+        LWIP_ASSERT("pcb->snd_queuelen >= pbuf_clen(rseg->p)", (pcb->snd_queuelen >= pbuf_clen(rseg->p)));
+        pcb->snd_queuelen = (u16_t)(pcb->snd_queuelen - pbuf_clen(rseg->p));
+        if (rseg->len > 0) {
+          if (rexmit_seg != NULL) {
+            /* queue the data again right after the SYN */
+            rexmit_seg->next = pcb->unsent;
+            pcb->unsent = rexmit_seg;
+            pcb->snd_queuelen = (u16_t)(pcb->snd_queuelen + pbuf_clen(rexmit_seg->p));
+            pcb->snd_nxt = ackno;
+          } else {
+            /* data sent with the SYN was acknowledged */
+            pcb->snd_buf = (tcpwnd_size_t)(pcb->snd_buf + rseg->len);
+            recv_acked = rseg->len;
+          }
+        }
+#else /* LWIP_TCP_FASTOPEN */
+        LWIP_ASSERT("pcb->snd_queuelen > 0", (pcb->snd_queuelen > 0));
+        --pcb->snd_queuelen;
+#endif /* LWIP_TCP_FASTOPEN */
+        LWIP_DEBUGF(TCP_QLEN_DEBUG, ("tcp_process: SYN-SENT --queuelen %"TCPWNDSIZE_F"\n", (tcpwnd_size_t)pcb->snd_queuelen));
         tcp_seg_free(rseg);
 
         /* If there's nothing left to acknowledge, stop the retransmit
@@ -932,7 +1244,11 @@ tcp_process(struct tcp_pcb *pcb)
       break;
     case SYN_RCVD:
       if (flags & TCP_SYN) {
-        if (seqno == pcb->rcv_nxt - 1) {
+        if ((seqno == pcb->rcv_nxt - 1)
+#if LWIP_TCP_FASTOPEN
+            || ((pcb->flags & TF_FASTOPEN_ACC) && (seqno + tcplen == pcb->rcv_nxt))
+#endif /* LWIP_TCP_FASTOPEN */
+           ) {
           /* Looks like another copy of the SYN - retransmit our SYN-ACK */
           tcp_rexmit(pcb);
         }
@@ -940,7 +1256,14 @@ tcp_process(struct tcp_pcb *pcb)
         /* expected ACK number? */
         if (TCP_SEQ_BETWEEN(ackno, pcb->lastack + 1, pcb->snd_nxt)) {
           pcb->state = ESTABLISHED;
+          tcp_syn_queue_remove(pcb);
           LWIP_DEBUGF(TCP_DEBUG, ("TCP connection established %"U16_F" -> %"U16_F".\n", inseg.tcphdr->src, inseg.tcphdr->dest));
+#if LWIP_TCP_FASTOPEN
+          if (pcb->flags & TF_FASTOPEN_ACC) {
+            /* already accepted with the data in the SYN */
+            err = ERR_OK;
+          } else
+#endif /* LWIP_TCP_FASTOPEN */
 #if LWIP_CALLBACK_API || TCP_LISTEN_BACKLOG
           if (pcb->listener == NULL) {
             /* listen pcb might be closed by now */
@@ -1166,6 +1489,11 @@ tcp_receive(struct tcp_pcb *pcb)
     if (TCP_SEQ_LT(pcb->snd_wl1, seqno) ||
         (pcb->snd_wl1 == seqno && TCP_SEQ_LT(pcb->snd_wl2, ackno)) ||
         (pcb->snd_wl2 == ackno && (u32_t)SND_WND_SCALE(pcb, tcphdr->wnd) > pcb->snd_wnd)) {
+#if LWIP_TCP_INFO
+      if ((pcb->snd_wnd != 0) && (tcphdr->wnd == 0)) {
+        pcb->info_zero_wnd++;
+      }
+#endif /* LWIP_TCP_INFO */
       pcb->snd_wnd = SND_WND_SCALE(pcb, tcphdr->wnd);
       /* keep track of the biggest window announced by the remote host to calculate
          the maximum segment size */
@@ -1219,6 +1547,9 @@ tcp_receive(struct tcp_pcb *pcb)
               if ((u8_t)(pcb->dupacks + 1) > pcb->dupacks) {
                 ++pcb->dupacks;
               }
+#if LWIP_TCP_INFO
+              pcb->info_dupacks++;
+#endif /* LWIP_TCP_INFO */
               if (pcb->dupacks > 3) {
                 /* Inflate the congestion window */
                 TCP_WND_INC(pcb->cwnd, pcb->mss);
@@ -1256,6 +1587,11 @@ tcp_receive(struct tcp_pcb *pcb)
       /* Reset the fast retransmit variables. */
       pcb->dupacks = 0;
       pcb->lastack = ackno;
+#if TCP_PLPMTUD
+      if ((pcb->plpmtud_state == TCP_PLPMTUD_INFLIGHT) && TCP_SEQ_GEQ(ackno, pcb->plpmtud_probe_end)) {
+        tcp_plpmtud_acked(pcb);
+      }
+#endif /* TCP_PLPMTUD */
 
       /* Update the congestion control variables (cwnd and
          ssthresh). */
@@ -1936,6 +2272,10 @@ tcp_parseopt(struct tcp_pcb *pcb)
 
   LWIP_ASSERT("tcp_parseopt: invalid pcb", pcb != NULL);
 
+#if LWIP_TCP_FASTOPEN
+  tcp_fastopen_optlen = -1;
+#endif /* LWIP_TCP_FASTOPEN */
+
   /* Parse the TCP MSS option, if present. */
   if (tcphdr_optlen != 0) {
     for (tcp_optidx = 0; tcp_optidx < tcphdr_optlen; ) {
@@ -2028,6 +2368,32 @@ tcp_parseopt(struct tcp_pcb *pcb)
           }
           break;
 #endif /* LWIP_TCP_SACK_OUT */
+#if LWIP_TCP_FASTOPEN
+        case LWIP_TCP_OPT_FASTOPEN:
+          LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: FASTOPEN\n"));
+          data = tcp_get_next_optbyte();
+          if ((data < 2) || (tcp_optidx - 2 + data) > tcphdr_optlen) {
+            /* Bad length */
+            LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: bad length\n"));
+            return;
+          }
+          if (flags & TCP_SYN) {
+            /* a cookie or a cookie request (length 0), longer cookies
+               than we support are truncated and never match */
+            u8_t i;
+            u8_t cookie_len = (u8_t)(data - 2);
+            for (i = 0; i < cookie_len; i++) {
+              u8_t b = tcp_get_next_optbyte();
+              if (i < TCP_FASTOPEN_COOKIE_LEN) {
+                tcp_fastopen_optcookie[i] = b;
+              }
+            }
+            tcp_fastopen_optlen = (s8_t)LWIP_MIN(cookie_len, TCP_FASTOPEN_COOKIE_LEN + 1);
+          } else {
+            tcp_optidx += data - 2;
+          }
+          break;
+#endif /* LWIP_TCP_FASTOPEN */
         default:
           LWIP_DEBUGF(TCP_INPUT_DEBUG, ("tcp_parseopt: other\n"));
           data = tcp_get_next_optbyte();
@@ -2045,6 +2411,88 @@ tcp_parseopt(struct tcp_pcb *pcb)
   }
 }
 
+#if LWIP_TCP_SYNCOOKIES
+/**
+ * Parses the options of a SYN that is answered with a SYN cookie (no pcb)
+ * or of the ACK returning the cookie.
+ *
+ * @param mss returns the MSS option (unchanged if not present)
+ * @param wscale returns the window scale option (unchanged if not present)
+ * @param sack returns 1 if the SACK_PERM option is present
+ * @param ts returns 1 if the timestamp option is present
+ * @param tsval returns the timestamp value (unchanged if not present)
+ */
+static void
+tcp_syncookie_parseopt(u16_t *mss, u8_t *wscale, u8_t *sack, u8_t *ts, u32_t *tsval)
+{
+  u8_t data;
+
+#if !LWIP_WND_SCALE
+  LWIP_UNUSED_ARG(wscale);
+#endif /* !LWIP_WND_SCALE */
+#if !LWIP_TCP_SACK_OUT
+  LWIP_UNUSED_ARG(sack);
+#endif /* !LWIP_TCP_SACK_OUT */
+#if !LWIP_TCP_TIMESTAMPS
+  LWIP_UNUSED_ARG(ts);
+  LWIP_UNUSED_ARG(tsval);
+#endif /* !LWIP_TCP_TIMESTAMPS */
+  for (tcp_optidx = 0; tcp_optidx < tcphdr_optlen; ) {
+    u8_t opt = tcp_get_next_optbyte();
+    switch (opt) {
+      case LWIP_TCP_OPT_EOL:
+        return;
+      case LWIP_TCP_OPT_NOP:
+        break;
+      case LWIP_TCP_OPT_MSS:
+        if (tcp_get_next_optbyte() != LWIP_TCP_OPT_LEN_MSS || (tcp_optidx - 2 + LWIP_TCP_OPT_LEN_MSS) > tcphdr_optlen) {
+          return;
+        }
+        *mss = (u16_t)(tcp_get_next_optbyte() << 8);
+        *mss |= tcp_get_next_optbyte();
+        break;
+#if LWIP_WND_SCALE
+      case LWIP_TCP_OPT_WS:
+        if (tcp_get_next_optbyte() != LWIP_TCP_OPT_LEN_WS || (tcp_optidx - 2 + LWIP_TCP_OPT_LEN_WS) > tcphdr_optlen) {
+          return;
+        }
+        *wscale = (u8_t)LWIP_MIN(tcp_get_next_optbyte(), 14);
+        break;
+#endif /* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK_OUT
+      case LWIP_TCP_OPT_SACK_PERM:
+        if (tcp_get_next_optbyte() != LWIP_TCP_OPT_LEN_SACK_PERM || (tcp_optidx - 2 + LWIP_TCP_OPT_LEN_SACK_PERM) > tcphdr_optlen) {
+          return;
+        }
+        *sack = 1;
+        break;
+#endif /* LWIP_TCP_SACK_OUT */
+#if LWIP_TCP_TIMESTAMPS
+      case LWIP_TCP_OPT_TS:
+        if (tcp_get_next_optbyte() != LWIP_TCP_OPT_LEN_TS || (tcp_optidx - 2 + LWIP_TCP_OPT_LEN_TS) > tcphdr_optlen) {
+          return;
+        }
+        *tsval = (u32_t)tcp_get_next_optbyte() << 24;
+        *tsval |= (u32_t)tcp_get_next_optbyte() << 16;
+        *tsval |= (u32_t)tcp_get_next_optbyte() << 8;
+        *tsval |= tcp_get_next_optbyte();
+        *ts = 1;
+        /* skip the echo reply (6 bytes already read) */
+        tcp_optidx += LWIP_TCP_OPT_LEN_TS - 6;
+        break;
+#endif /* LWIP_TCP_TIMESTAMPS */
+      default:
+        data = tcp_get_next_optbyte();
+        if (data < 2) {
+          return;
+        }
+        tcp_optidx += data - 2;
+        break;
+    }
+  }
+}
+#endif /* LWIP_TCP_SYNCOOKIES */
+
 void
 tcp_trigger_input_pcb_close(void)
 {
@@ -74,6 +74,7 @@
 #include "lwip/stats.h"
 #include "lwip/ip6.h"
 #include "lwip/ip6_addr.h"
+#include "lwip/ip4_pmtu.h"
 #if LWIP_TCP_TIMESTAMPS
 #include "lwip/sys.h"
 #endif
@@ -130,14 +131,17 @@ static err_t tcp_output_control_segment_netif(const struct tcp_pcb *pcb, struct
                                               const ip_addr_t *src, const ip_addr_t *dst,
                                               struct netif *netif);
 
-/* tcp_route: common code that returns a fixed bound netif or calls ip_route */
-static struct netif *
+/* tcp_route: common code that returns a fixed bound netif or calls ip_route
+   (ip_route_flow for a pcb, so that all segments take the same path) */
+struct netif *
 tcp_route(const struct tcp_pcb *pcb, const ip_addr_t *src, const ip_addr_t *dst)
 {
   LWIP_UNUSED_ARG(src); /* in case IPv4-only and source-based routing is disabled */
 
   if ((pcb != NULL) && (pcb->netif_idx != NETIF_NO_INDEX)) {
     return netif_get_by_index(pcb->netif_idx);
+  } else if (pcb != NULL) {
+    return ip_route_flow(src, dst, IP_PROTO_TCP, pcb->local_port, pcb->remote_port);
   } else {
     return ip_route(src, dst);
   }
@@ -351,46 +355,13 @@ tcp_write_checks(struct tcp_pcb *pcb, u16_t len)
 }
 
 /**
- * @ingroup tcp_raw
- * Write data for sending (but does not send it immediately).
- *
- * It waits in the expectation of more data being sent soon (as
- * it can send them more efficiently by combining them together).
- * To prompt the system to send data now, call tcp_output() after
- * calling tcp_write().
- *
- * This function enqueues the data pointed to by the argument dataptr. The length of
- * the data is passed as the len parameter. The apiflags can be one or more of:
- * - TCP_WRITE_FLAG_COPY: indicates whether the new memory should be allocated
- *   for the data to be copied into. If this flag is not given, no new memory
- *   should be allocated and the data should only be referenced by pointer. This
- *   also means that the memory behind dataptr must not change until the data is
- *   ACKed by the remote host
- * - TCP_WRITE_FLAG_MORE: indicates that more data follows. If this is omitted,
- *   the PSH flag is set in the last segment created by this call to tcp_write.
- *   If this flag is given, the PSH flag is not set.
- *
- * The tcp_write() function will fail and return ERR_MEM if the length
- * of the data exceeds the current send buffer size or if the length of
- * the queue of outgoing segment is larger than the upper limit defined
- * in lwipopts.h. The number of bytes available in the output queue can
- * be retrieved with the tcp_sndbuf() function.
+ * Enqueue data for sending, see tcp_write().
  *
- * The proper way to use this function is to call the function with at
- * most tcp_sndbuf() bytes of data. If the function returns ERR_MEM,
- * the application should wait until some of the currently enqueued
- * data has been successfully received by the other host and try again.
- *
- * @param pcb Protocol control block for the TCP connection to enqueue data for.
- * @param arg Pointer to the data to be enqueued for sending.
- * @param len Data length in bytes
- * @param apiflags combination of following flags :
- * - TCP_WRITE_FLAG_COPY (0x01) data will be copied into memory belonging to the stack
- * - TCP_WRITE_FLAG_MORE (0x02) for TCP connection, PSH flag will not be set on last segment sent,
- * @return ERR_OK if enqueued, another err_t on error
+ * @param data_chksum if != NULL, the checksum of the data calculated in
+ *        advance (only used if the data is not copied and not split)
  */
-err_t
-tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
+static err_t
+tcp_write_data(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags, const u16_t *data_chksum)
 {
   struct pbuf *concat_p = NULL;
   struct tcp_seg *last_unsent = NULL, *seg = NULL, *prev_seg = NULL, *queue = NULL;
@@ -426,6 +397,14 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
   /* Always copy to try to create single pbufs for TX */
   apiflags |= TCP_WRITE_FLAG_COPY;
 #endif /* LWIP_NETIF_TX_SINGLE_PBUF */
+#if TCP_CHECKSUM_ON_COPY
+  if (apiflags & TCP_WRITE_FLAG_COPY) {
+    /* copied data is checksummed while copying */
+    data_chksum = NULL;
+  }
+#else /* TCP_CHECKSUM_ON_COPY */
+  LWIP_UNUSED_ARG(data_chksum);
+#endif /* TCP_CHECKSUM_ON_COPY */
 
   LWIP_DEBUGF(TCP_OUTPUT_DEBUG, ("tcp_write(pcb=%p, data=%p, len=%"U16_F", apiflags=%"U16_F")\n",
                                  (void *)pcb, arg, len, (u16_t)apiflags));
@@ -486,8 +465,12 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
 
     /* Usable space at the end of the last unsent segment */
     unsent_optlen = LWIP_TCP_OPT_LENGTH_SEGMENT(last_unsent->flags, pcb);
-    LWIP_ASSERT("mss_local is too small", mss_local >= last_unsent->len + unsent_optlen);
-    space = mss_local - (last_unsent->len + unsent_optlen);
+    if (mss_local > last_unsent->len + unsent_optlen) {
+      space = (u16_t)(mss_local - (last_unsent->len + unsent_optlen));
+    } else {
+      /* no space left (or the MSS has been reduced, see tcp_reduce_mss()) */
+      space = 0;
+    }
 
     /*
      * Phase 1: Copy data directly into an oversized pbuf.
@@ -514,6 +497,20 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
     /* now we are either finished or oversize is zero */
     LWIP_ASSERT("inconsistent oversize vs. len", (oversize == 0) || (pos == len));
 #endif /* TCP_OVERSIZE */
+#if TCP_CHECKSUM_ON_COPY
+    if (data_chksum != NULL) {
+      if (pos > 0) {
+        /* partly copied into the oversized pbuf */
+        data_chksum = NULL;
+      } else if (len > mss_local - optlen) {
+        /* cannot be sent in one segment anyway, checksum the parts */
+        data_chksum = NULL;
+      } else if (space < len) {
+        /* don't split the data, start a new segment */
+        space = 0;
+      }
+    }
+#endif /* TCP_CHECKSUM_ON_COPY */
 
 #if !LWIP_NETIF_TX_SINGLE_PBUF
     /*
@@ -574,9 +571,13 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
           queuelen += pbuf_clen(concat_p);
         }
 #if TCP_CHECKSUM_ON_COPY
-        /* calculate the checksum of nocopy-data */
-        tcp_seg_add_chksum(~inet_chksum((const u8_t *)arg + pos, seglen), seglen,
-                           &concat_chksum, &concat_chksum_swapped);
+        if (data_chksum != NULL) {
+          tcp_seg_add_chksum(*data_chksum, seglen, &concat_chksum, &concat_chksum_swapped);
+        } else {
+          /* calculate the checksum of nocopy-data */
+          tcp_seg_add_chksum(~inet_chksum((const u8_t *)arg + pos, seglen), seglen,
+                             &concat_chksum, &concat_chksum_swapped);
+        }
         concat_chksummed += seglen;
 #endif /* TCP_CHECKSUM_ON_COPY */
       }
@@ -597,6 +598,12 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
    * The new segments are chained together in the local 'queue'
    * variable, ready to be appended to pcb->unsent.
    */
+#if TCP_CHECKSUM_ON_COPY
+  if ((data_chksum != NULL) && ((pos > 0) || (len > mss_local - optlen))) {
+    /* not sent in one new segment, checksum the parts */
+    data_chksum = NULL;
+  }
+#endif /* TCP_CHECKSUM_ON_COPY */
   while (pos < len) {
     struct pbuf *p;
     u16_t left = len - pos;
@@ -632,8 +639,12 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
         goto memerr;
       }
 #if TCP_CHECKSUM_ON_COPY
-      /* calculate the checksum of nocopy-data */
-      chksum = ~inet_chksum((const u8_t *)arg + pos, seglen);
+      if (data_chksum != NULL) {
+        chksum = *data_chksum;
+      } else {
+        /* calculate the checksum of nocopy-data */
+        chksum = ~inet_chksum((const u8_t *)arg + pos, seglen);
+      }
       if (seglen & 1) {
         chksum_swapped = 1;
         chksum = SWAP_BYTES_IN_WORD(chksum);
@@ -814,6 +825,77 @@ memerr:
   return ERR_MEM;
 }
 
+/**
+ * @ingroup tcp_raw
+ * Write data for sending (but does not send it immediately).
+ *
+ * It waits in the expectation of more data being sent soon (as
+ * it can send them more efficiently by combining them together).
+ * To prompt the system to send data now, call tcp_output() after
+ * calling tcp_write().
+ *
+ * This function enqueues the data pointed to by the argument dataptr. The length of
+ * the data is passed as the len parameter. The apiflags can be one or more of:
+ * - TCP_WRITE_FLAG_COPY: indicates whether the new memory should be allocated
+ *   for the data to be copied into. If this flag is not given, no new memory
+ *   should be allocated and the data should only be referenced by pointer. This
+ *   also means that the memory behind dataptr must not change until the data is
+ *   ACKed by the remote host
+ * - TCP_WRITE_FLAG_MORE: indicates that more data follows. If this is omitted,
+ *   the PSH flag is set in the last segment created by this call to tcp_write.
+ *   If this flag is given, the PSH flag is not set.
+ *
+ * The tcp_write() function will fail and return ERR_MEM if the length
+ * of the data exceeds the current send buffer size or if the length of
+ * the queue of outgoing segment is larger than the upper limit defined
+ * in lwipopts.h. The number of bytes available in the output queue can
+ * be retrieved with the tcp_sndbuf() function.
+ *
+ * The proper way to use this function is to call the function with at
+ * most tcp_sndbuf() bytes of data. If the function returns ERR_MEM,
+ * the application should wait until some of the currently enqueued
+ * data has been successfully received by the other host and try again.
+ *
+ * @param pcb Protocol control block for the TCP connection to enqueue data for.
+ * @param arg Pointer to the data to be enqueued for sending.
+ * @param len Data length in bytes
+ * @param apiflags combination of following flags :
+ * - TCP_WRITE_FLAG_COPY (0x01) data will be copied into memory belonging to the stack
+ * - TCP_WRITE_FLAG_MORE (0x02) for TCP connection, PSH flag will not be set on last segment sent,
+ * @return ERR_OK if enqueued, another err_t on error
+ */
+err_t
+tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
+{
+  return tcp_write_data(pcb, arg, len, apiflags, NULL);
+}
+
+#if TCP_CHECKSUM_ON_COPY
+/**
+ * @ingroup tcp_raw
+ * Write data that is not copied (like tcp_write() without TCP_WRITE_FLAG_COPY)
+ * with its checksum calculated in advance, e.g. at compile time for data in
+ * ROM. This way, the data is not even read before the netif sends it.
+ *
+ * The data is put into one segment if it fits into the MSS (a new segment is
+ * started if it does not fit into the space left in the last unsent one).
+ * Otherwise, the checksum is ignored and calculated for the parts.
+ *
+ * @param pcb Protocol control block for the TCP connection to enqueue data for.
+ * @param arg Pointer to the data to be enqueued for sending.
+ * @param len Data length in bytes
+ * @param apiflags TCP_WRITE_FLAG_MORE (see tcp_write()), if TCP_WRITE_FLAG_COPY
+ *        is given, the checksum is not used
+ * @param chksum the one's complement sum of the data: ~inet_chksum(arg, len)
+ * @return ERR_OK if enqueued, another err_t on error
+ */
+err_t
+tcp_write_chksum(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags, u16_t chksum)
+{
+  return tcp_write_data(pcb, arg, len, apiflags, &chksum);
+}
+#endif /* TCP_CHECKSUM_ON_COPY */
+
 /**
  * Split segment on the head of the unsent queue.  If return is not
  * ERR_OK, existing head remains intact
@@ -1066,6 +1148,17 @@ tcp_enqueue_flags(struct tcp_pcb *pcb, u8_t flags)
       optflags |= TF_SEG_OPTS_SACK_PERM;
     }
 #endif /* LWIP_TCP_SACK_OUT */
+#if LWIP_TCP_FASTOPEN
+    if (pcb->state != SYN_RCVD) {
+      if (pcb->flags & TF_FASTOPEN) {
+        /* send our cookie or request one */
+        optflags |= (pcb->tfo_cookie_len != 0) ? TF_SEG_OPTS_FASTOPEN : TF_SEG_OPTS_FASTOPEN_REQ;
+      }
+    } else if (pcb->tfo_cookie_len != 0) {
+      /* hand out a cookie in <SYN,ACK> */
+      optflags |= TF_SEG_OPTS_FASTOPEN;
+    }
+#endif /* LWIP_TCP_FASTOPEN */
   }
 #if LWIP_TCP_TIMESTAMPS
   if ((pcb->flags & TF_TIMESTAMP) || ((flags & TCP_SYN) && (pcb->state != SYN_RCVD))) {
@@ -1133,6 +1226,157 @@ tcp_enqueue_flags(struct tcp_pcb *pcb, u8_t flags)
   return ERR_OK;
 }
 
+#if LWIP_TCP_FASTOPEN
+/**
+ * Called by tcp_output() in SYN_SENT state: if we have a TCP Fast Open cookie
+ * for the remote host and the SYN has not been sent yet, move the data of the
+ * first segment queued by tcp_write() into the SYN segment.
+ *
+ * @param pcb the tcp_pcb for which to send the SYN
+ */
+void
+tcp_fastopen_add_syn_data(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *syn, *data;
+  u8_t data_flags;
+
+  LWIP_ASSERT("tcp_fastopen_add_syn_data: invalid pcb", pcb != NULL);
+
+  syn = pcb->unsent;
+  if ((syn == NULL) || (pcb->unacked != NULL) || (pcb->nrtx != 0) ||
+      !(TCPH_FLAGS(syn->tcphdr) & TCP_SYN) ||
+      !(syn->flags & TF_SEG_OPTS_FASTOPEN) || (syn->len != 0)) {
+    /* SYN already sent (data is only sent with the first SYN) */
+    return;
+  }
+  data = syn->next;
+  if ((data == NULL) || (data->len == 0)) {
+    return;
+  }
+  data_flags = TCPH_FLAGS(data->tcphdr);
+  if ((data_flags & TCP_FIN) ||
+      (data->len + LWIP_TCP_OPT_LENGTH_SEGMENT(syn->flags, pcb) > pcb->mss)) {
+    /* send the data after the handshake */
+    return;
+  }
+
+  /* strip the header of the data segment and append its pbufs to the SYN */
+  pbuf_remove_header(data->p, TCPH_HDRLEN_BYTES(data->tcphdr));
+  pbuf_cat(syn->p, data->p);
+  syn->len = data->len;
+  TCPH_SET_FLAG(syn->tcphdr, data_flags & TCP_PSH);
+#if TCP_CHECKSUM_ON_COPY
+  syn->chksum = data->chksum;
+  syn->chksum_swapped = data->chksum_swapped;
+  syn->flags |= data->flags & TF_SEG_DATA_CHECKSUMMED;
+#endif /* TCP_CHECKSUM_ON_COPY */
+  syn->next = data->next;
+  data->p = NULL;
+  tcp_seg_free(data);
+#if TCP_OVERSIZE
+  if (syn->next == NULL) {
+    /* don't let tcp_write() append to the SYN */
+    pcb->unsent_oversize = 0;
+  }
+#endif /* TCP_OVERSIZE */
+#if TCP_OVERSIZE_DBGCHECK
+  syn->oversize_left = 0;
+#endif /* TCP_OVERSIZE_DBGCHECK */
+
+  /* the congestion window must allow sending the data with the SYN */
+  if (pcb->cwnd < syn->len) {
+    pcb->cwnd = syn->len;
+  }
+  LWIP_DEBUGF(TCP_OUTPUT_DEBUG, ("tcp_fastopen_add_syn_data: %"U16_F" bytes of data in SYN\n", syn->len));
+}
+
+/**
+ * Called by tcp_process() when a SYN|ACK only acknowledged the SYN but not
+ * the data sent with it: creates a new segment holding that data.
+ *
+ * @param pcb the tcp_pcb in SYN_SENT state
+ * @param syn the SYN segment carrying data
+ * @return the new data segment (to be put at the head of pcb->unsent)
+ *         or NULL when out of memory
+ */
+struct tcp_seg *
+tcp_fastopen_syn_data_seg(struct tcp_pcb *pcb, const struct tcp_seg *syn)
+{
+  struct pbuf *p;
+  struct tcp_seg *seg;
+  u8_t optflags = 0;
+  u8_t optlen;
+#if TCP_CHECKSUM_ON_COPY
+  u16_t chksum = 0;
+  u8_t chksum_swapped = 0;
+#endif /* TCP_CHECKSUM_ON_COPY */
+
+  LWIP_ASSERT("tcp_fastopen_syn_data_seg: invalid pcb", pcb != NULL);
+  LWIP_ASSERT("tcp_fastopen_syn_data_seg: no data", (syn != NULL) && (syn->len > 0));
+
+#if LWIP_TCP_TIMESTAMPS
+  if (pcb->flags & TF_TIMESTAMP) {
+    optflags = TF_SEG_OPTS_TS;
+  }
+#endif /* LWIP_TCP_TIMESTAMPS */
+  optlen = LWIP_TCP_OPT_LENGTH_SEGMENT(optflags, pcb);
+
+  p = pbuf_alloc(PBUF_TRANSPORT, (u16_t)(optlen + syn->len), PBUF_RAM);
+  if (p == NULL) {
+    TCP_STATS_INC(tcp.memerr);
+    return NULL;
+  }
+  /* data follows all headers in syn->p */
+  if (pbuf_copy_partial(syn->p, (u8_t *)p->payload + optlen, syn->len,
+                        (u16_t)(syn->p->tot_len - syn->len)) != syn->len) {
+    pbuf_free(p);
+    return NULL;
+  }
+#if TCP_CHECKSUM_ON_COPY
+  tcp_seg_add_chksum(~inet_chksum((const u8_t *)p->payload + optlen, syn->len), syn->len,
+                     &chksum, &chksum_swapped);
+#endif /* TCP_CHECKSUM_ON_COPY */
+
+  seg = tcp_create_segment(pcb, p, (u8_t)(TCPH_FLAGS(syn->tcphdr) & TCP_PSH),
+                           lwip_ntohl(syn->tcphdr->seqno) + 1, optflags);
+  if (seg == NULL) {
+    TCP_STATS_INC(tcp.memerr);
+    return NULL;
+  }
+#if TCP_CHECKSUM_ON_COPY
+  seg->chksum = chksum;
+  seg->chksum_swapped = chksum_swapped;
+  seg->flags |= TF_SEG_DATA_CHECKSUMMED;
+#endif /* TCP_CHECKSUM_ON_COPY */
+  return seg;
+}
+
+/* Build a TCP Fast Open option (cookie or cookie request) at the specified
+ * options pointer, padded with NOPs */
+static u32_t *
+tcp_build_fastopen_option(const struct tcp_pcb *pcb, u8_t optflags, u32_t *opts)
+{
+  u8_t *opt = (u8_t *)opts;
+  u8_t cookie_len = 0;
+  u8_t optlen = LWIP_TCP_OPT_LEN_FASTOPEN_REQ_OUT;
+  u8_t i;
+
+  if (optflags & TF_SEG_OPTS_FASTOPEN) {
+    cookie_len = pcb->tfo_cookie_len;
+    optlen = LWIP_TCP_OPT_LEN_FASTOPEN_OUT;
+  }
+  opt[0] = LWIP_TCP_OPT_FASTOPEN;
+  opt[1] = (u8_t)(2 + cookie_len);
+  for (i = 0; i < cookie_len; i++) {
+    opt[2 + i] = pcb->tfo_cookie[i];
+  }
+  for (i = (u8_t)(2 + cookie_len); i < optlen; i++) {
+    opt[i] = LWIP_TCP_OPT_NOP;
+  }
+  return opts + optlen / 4;
+}
+#endif /* LWIP_TCP_FASTOPEN */
+
 #if LWIP_TCP_TIMESTAMPS
 /* Build a timestamp option (12 bytes long) at the specified options pointer)
  *
@@ -1229,6 +1473,28 @@ tcp_build_wnd_scale_option(u32_t *opts)
 }
 #endif
 
+/**
+ * Split the first unsent segment if it is bigger than the MSS, which happens
+ * when the MSS has been reduced (see tcp_reduce_mss()) after the segment was
+ * created. If splitting fails, the segment is sent as it is.
+ *
+ * @param pcb the tcp_pcb for which to check the unsent head
+ */
+static void
+tcp_output_fit_mss(struct tcp_pcb *pcb)
+{
+  struct tcp_seg *seg = pcb->unsent;
+  u16_t optlen;
+
+  if ((seg == NULL) || (TCPH_FLAGS(seg->tcphdr) & TCP_SYN)) {
+    return;
+  }
+  optlen = LWIP_TCP_OPT_LENGTH_SEGMENT(seg->flags, pcb);
+  if ((pcb->mss > optlen) && (seg->len > pcb->mss - optlen)) {
+    tcp_split_unsent_seg(pcb, (u16_t)(pcb->mss - optlen));
+  }
+}
+
 /**
  * @ingroup tcp_raw
  * Find out what we can send and send it
@@ -1263,8 +1529,15 @@ tcp_output(struct tcp_pcb *pcb)
     return ERR_OK;
   }
 
+#if LWIP_TCP_FASTOPEN
+  if ((pcb->state == SYN_SENT) && (pcb->tfo_cookie_len != 0)) {
+    tcp_fastopen_add_syn_data(pcb);
+  }
+#endif /* LWIP_TCP_FASTOPEN */
+
   wnd = LWIP_MIN(pcb->snd_wnd, pcb->cwnd);
 
+  tcp_output_fit_mss(pcb);
   seg = pcb->unsent;
 
   if (seg == NULL) {
@@ -1305,6 +1578,16 @@ tcp_output(struct tcp_pcb *pcb)
     ip_addr_copy(pcb->local_ip, *local_ip);
   }
 
+#if LWIP_IPV4 && LWIP_IPV4_PMTU && TCP_CALCULATE_EFF_SEND_MSS
+  /* a smaller path MTU may have been learned since the MSS was set (e.g. by
+     another connection): ip4_output_if() would reject bigger segments */
+  if (IP_IS_V4(&pcb->remote_ip) && (ip4_pmtu_lowest < pcb->mss + IP_HLEN + TCP_HLEN) &&
+      tcp_pmtu_check(pcb, netif)) {
+    tcp_output_fit_mss(pcb);
+    seg = pcb->unsent;
+  }
+#endif /* LWIP_IPV4 && LWIP_IPV4_PMTU && TCP_CALCULATE_EFF_SEND_MSS */
+
   /* Handle the current segment not fitting within the window */
   if (lwip_ntohl(seg->tcphdr->seqno) - pcb->lastack + seg->len > wnd) {
     /* We need to start the persistent timer when the next unsent segment does not fit
@@ -1370,6 +1653,14 @@ tcp_output(struct tcp_pcb *pcb)
 #if TCP_OVERSIZE_DBGCHECK
     seg->oversize_left = 0;
 #endif /* TCP_OVERSIZE_DBGCHECK */
+#if TCP_PLPMTUD
+    if ((pcb->plpmtud_state == TCP_PLPMTUD_PROBE) &&
+        (seg->len + LWIP_TCP_OPT_LENGTH_SEGMENT(seg->flags, pcb) > pcb->plpmtud_low)) {
+      /* this segment would not have fit the old MSS: it is the probe */
+      pcb->plpmtud_state = TCP_PLPMTUD_INFLIGHT;
+      pcb->plpmtud_probe_end = lwip_ntohl(seg->tcphdr->seqno) + TCP_TCPLEN(seg);
+    }
+#endif /* TCP_PLPMTUD */
     pcb->unsent = seg->next;
     if (pcb->state != SYN_SENT) {
       tcp_clear_flags(pcb, TF_ACK_DELAY | TF_ACK_NOW);
@@ -1409,6 +1700,7 @@ tcp_output(struct tcp_pcb *pcb)
     } else {
       tcp_seg_free(seg);
     }
+    tcp_output_fit_mss(pcb);
     seg = pcb->unsent;
   }
 #if TCP_OVERSIZE
@@ -1532,6 +1824,11 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
     *(opts++) = PP_HTONL(0x01010402);
   }
 #endif
+#if LWIP_TCP_FASTOPEN
+  if (seg->flags & (TF_SEG_OPTS_FASTOPEN | TF_SEG_OPTS_FASTOPEN_REQ)) {
+    opts = tcp_build_fastopen_option(pcb, seg->flags, opts);
+  }
+#endif /* LWIP_TCP_FASTOPEN */
 
   /* Set retransmission timer running if it is not currently enabled
      This must be set before checking the route. */
@@ -1695,6 +1992,9 @@ tcp_rexmit_rto_commit(struct tcp_pcb *pcb)
   if (pcb->nrtx < 0xFF) {
     ++pcb->nrtx;
   }
+#if LWIP_TCP_INFO
+  pcb->info_retrans++;
+#endif /* LWIP_TCP_INFO */
   /* Do the actual retransmission */
   tcp_output(pcb);
 }
@@ -1766,6 +2066,9 @@ tcp_rexmit(struct tcp_pcb *pcb)
   if (pcb->nrtx < 0xFF) {
     ++pcb->nrtx;
   }
+#if LWIP_TCP_INFO
+  pcb->info_retrans++;
+#endif /* LWIP_TCP_INFO */
 
   /* Don't take any rtt measurements after retransmitting. */
   pcb->rttest = 0;
@@ -1796,6 +2099,9 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
                  (u16_t)pcb->dupacks, pcb->lastack,
                  lwip_ntohl(pcb->unacked->tcphdr->seqno)));
     if (tcp_rexmit(pcb) == ERR_OK) {
+#if TCP_PLPMTUD
+      tcp_plpmtud_rexmit(pcb, 0);
+#endif /* TCP_PLPMTUD */
       /* Set ssthresh to half of the minimum of the current
        * cwnd and the advertised window */
       pcb->ssthresh = LWIP_MIN(pcb->cwnd, pcb->snd_wnd) / 2;
@@ -2080,6 +2386,99 @@ tcp_rst_netif(struct netif *netif, u32_t seqno, u32_t ackno,
   }
 }
 
+#if LWIP_TCP_SYNCOOKIES
+/**
+ * Send a <SYN,ACK> carrying a SYN cookie: no pcb exists for the connection,
+ * so everything needed is passed as arguments.
+ *
+ * Called by tcp_listen_input() when the SYN queue of a listening pcb is full.
+ *
+ * @param netif the netif on which to send the <SYN,ACK>
+ * @param iss the SYN cookie (sequence number of the <SYN,ACK>)
+ * @param ackno the acknowledge number (sequence number of the SYN + 1)
+ * @param local_ip the local IP address to send the segment from
+ * @param remote_ip the remote IP address to send the segment to
+ * @param local_port the local TCP port to send the segment from
+ * @param remote_port the remote TCP port to send the segment to
+ * @param wscale window scale of the SYN or TCP_SYNCOOKIE_NO_WSCALE
+ * @param sack 1 if the SYN carried the SACK_PERM option
+ * @param ts 1 if the SYN carried the timestamp option
+ * @param ts_recent the timestamp value of the SYN (echoed if ts is 1)
+ */
+void
+tcp_syncookie_synack(struct netif *netif, u32_t iss, u32_t ackno,
+                     const ip_addr_t *local_ip, const ip_addr_t *remote_ip,
+                     u16_t local_port, u16_t remote_port, u8_t wscale, u8_t sack,
+                     u8_t ts, u32_t ts_recent)
+{
+  struct pbuf *p;
+  u32_t *opts;
+  u16_t mss;
+  u8_t optflags = TF_SEG_OPTS_MSS;
+
+  LWIP_ASSERT("tcp_syncookie_synack: invalid netif", netif != NULL);
+
+#if LWIP_TCP_TIMESTAMPS
+  if (ts) {
+    optflags |= TF_SEG_OPTS_TS;
+  }
+#else
+  LWIP_UNUSED_ARG(ts);
+  LWIP_UNUSED_ARG(ts_recent);
+#endif /* LWIP_TCP_TIMESTAMPS */
+#if LWIP_WND_SCALE
+  if (wscale != TCP_SYNCOOKIE_NO_WSCALE) {
+    optflags |= TF_SEG_OPTS_WND_SCALE;
+  }
+#else
+  LWIP_UNUSED_ARG(wscale);
+#endif /* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK_OUT
+  if (sack) {
+    optflags |= TF_SEG_OPTS_SACK_PERM;
+  }
+#else
+  LWIP_UNUSED_ARG(sack);
+#endif /* LWIP_TCP_SACK_OUT */
+
+  p = tcp_output_alloc_header_common(ackno, LWIP_TCP_OPT_LENGTH(optflags), 0, lwip_htonl(iss),
+    local_port, remote_port, TCP_SYN | TCP_ACK, TCPWND_MIN16(TCP_WND));
+  if (p == NULL) {
+    LWIP_DEBUGF(TCP_DEBUG, ("tcp_syncookie_synack: could not allocate memory for pbuf\n"));
+    return;
+  }
+  opts = (u32_t *)(void *)((struct tcp_hdr *)p->payload + 1);
+#if TCP_CALCULATE_EFF_SEND_MSS
+  mss = tcp_eff_send_mss_netif(TCP_MSS, netif, remote_ip);
+#else /* TCP_CALCULATE_EFF_SEND_MSS */
+  mss = TCP_MSS;
+#endif /* TCP_CALCULATE_EFF_SEND_MSS */
+  *(opts++) = TCP_BUILD_MSS_OPTION(mss);
+#if LWIP_TCP_TIMESTAMPS
+  if (optflags & TF_SEG_OPTS_TS) {
+    *(opts++) = PP_HTONL(0x0101080A);
+    *(opts++) = lwip_htonl(sys_now());
+    *(opts++) = lwip_htonl(ts_recent);
+  }
+#endif /* LWIP_TCP_TIMESTAMPS */
+#if LWIP_WND_SCALE
+  if (optflags & TF_SEG_OPTS_WND_SCALE) {
+    tcp_build_wnd_scale_option(opts);
+    opts += LWIP_TCP_OPT_LEN_WS_OUT / 4;
+  }
+#endif /* LWIP_WND_SCALE */
+#if LWIP_TCP_SACK_OUT
+  if (optflags & TF_SEG_OPTS_SACK_PERM) {
+    *(opts++) = PP_HTONL(0x01010402);
+  }
+#endif /* LWIP_TCP_SACK_OUT */
+  LWIP_UNUSED_ARG(opts); /* for LWIP_NOASSERT */
+
+  LWIP_DEBUGF(TCP_DEBUG, ("tcp_syncookie_synack: cookie %"U32_F"\n", iss));
+  tcp_output_control_segment_netif(NULL, p, local_ip, remote_ip, netif);
+}
+#endif /* LWIP_TCP_SYNCOOKIES */
+
 /**
  * Send an ACK without data.
  *
@@ -49,6 +49,7 @@
 #include "lwip/priv/tcpip_priv.h"
 
 #include "lwip/ip4_frag.h"
+#include "lwip/ip4_pmtu.h"
 #include "lwip/etharp.h"
 #include "lwip/dhcp.h"
 #include "lwip/acd.h"
@@ -97,6 +98,9 @@ const struct lwip_cyclic_timer lwip_cyclic_timers[] = {
 #if LWIP_IGMP
   {IGMP_TMR_INTERVAL, HANDLER(igmp_tmr)},
 #endif /* LWIP_IGMP */
+#if LWIP_IPV4_PMTU
+  {IP4_PMTU_TMR_INTERVAL, HANDLER(ip4_pmtu_tmr)},
+#endif /* LWIP_IPV4_PMTU */
 #endif /* LWIP_IPV4 */
 #if LWIP_DNS
   {DNS_TMR_INTERVAL, HANDLER(dns_tmr)},
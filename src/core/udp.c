@@ -580,8 +580,17 @@ udp_sendto_chksum(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip,
     if (netif == NULL)
 #endif /* LWIP_MULTICAST_TX_OPTIONS */
     {
+#if LWIP_FIB_ECMP
+      /* the local port selects the path: bind now instead of in udp_sendto_if_src() */
+      if (pcb->local_port == 0) {
+        err_t err = udp_bind(pcb, &pcb->local_ip, pcb->local_port);
+        if (err != ERR_OK) {
+          return err;
+        }
+      }
+#endif /* LWIP_FIB_ECMP */
       /* find the outgoing network interface for this packet */
-      netif = ip_route(&pcb->local_ip, dst_ip);
+      netif = ip_route_flow(&pcb->local_ip, dst_ip, IP_PROTO_UDP, pcb->local_port, dst_port);
     }
   }
 
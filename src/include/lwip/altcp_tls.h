@@ -80,6 +80,57 @@ err_t altcp_tls_config_server_add_privkey_cert(struct altcp_tls_config *config,
       const u8_t *privkey_pass, size_t privkey_pass_len,
       const u8_t *cert, size_t cert_len);
 
+/** @ingroup altcp_tls
+ * Configure the server-side session cache of an ALTCP_TLS server configuration:
+ * clients reconnecting with the session ID of a cached session do an
+ * abbreviated handshake (no key exchange).
+ * Enabled with default settings by @ref altcp_tls_create_config_server if
+ * supported by the port (e.g. ALTCP_MBEDTLS_USE_SESSION_CACHE).
+ *
+ * @param config the server configuration
+ * @param max_entries maximum number of cached sessions, 0 disables the cache
+ * @param timeout_seconds sessions expire after this time
+ * @return ERR_OK or ERR_VAL if not supported
+ */
+err_t altcp_tls_config_server_session_cache(struct altcp_tls_config *config, int max_entries, u32_t timeout_seconds);
+
+/** @ingroup altcp_tls
+ * Configure session tickets (RFC 5077) of an ALTCP_TLS server configuration:
+ * the session state is sent to the client encrypted with a key known only to
+ * the server, so no per-client state is needed for an abbreviated handshake.
+ * The ticket key is rotated every 'lifetime_seconds' (tickets encrypted with
+ * the previous key are still accepted). Calling this function creates new keys.
+ * Enabled with default settings by @ref altcp_tls_create_config_server if
+ * supported by the port (e.g. ALTCP_MBEDTLS_USE_SESSION_TICKETS).
+ *
+ * @param config the server configuration
+ * @param lifetime_seconds ticket lifetime and key rotation interval, 0 disables tickets
+ * @return ERR_OK or ERR_VAL if not supported or on error
+ */
+err_t altcp_tls_config_server_session_tickets(struct altcp_tls_config *config, u32_t lifetime_seconds);
+
+/** @ingroup altcp_tls
+ * Handshake statistics of an ALTCP_TLS configuration
+ * (full handshakes = handshakes - resumed_cache - resumed_ticket)
+ */
+struct altcp_tls_stats {
+  /** successfully completed handshakes (full or abbreviated) */
+  u32_t handshakes;
+  /** failed handshakes */
+  u32_t handshakes_failed;
+  /** sessions resumed from the server-side session cache */
+  u32_t resumed_cache;
+  /** sessions resumed from a session ticket */
+  u32_t resumed_ticket;
+  /** session tickets sent to clients */
+  u32_t tickets_issued;
+};
+
+/** @ingroup altcp_tls
+ * Get the handshake statistics of an ALTCP_TLS configuration
+ */
+void altcp_tls_config_get_stats(struct altcp_tls_config *config, struct altcp_tls_stats *stats);
+
 /** @ingroup altcp_tls
  * Create an ALTCP_TLS server configuration handle with one certificate
  * (short version of calling @ref altcp_tls_create_config_server and
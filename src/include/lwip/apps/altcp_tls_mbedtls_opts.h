@@ -65,7 +65,8 @@
 #define ALTCP_MBEDTLS_LIB_DEBUG_LEVEL_MIN             0
 #endif
 
-/** Enable the basic session cache
+/** Enable the basic server-side session cache (configured with the defaults
+ * below for server configurations, see altcp_tls_config_server_session_cache())
  * ATTENTION: Using a session cache can lower security by reusing keys!
  */
 #ifndef ALTCP_MBEDTLS_USE_SESSION_CACHE
@@ -83,7 +84,8 @@
 #endif
 
 /** Use session tickets to speed up connection setup (needs
- * MBEDTLS_SSL_SESSION_TICKETS enabled in mbedTLS config).
+ * MBEDTLS_SSL_SESSION_TICKETS enabled in mbedTLS config). Configured with the
+ * defaults below for server configurations, see altcp_tls_config_server_session_tickets().
  * ATTENTION: Using session tickets can lower security by reusing keys!
  */
 #ifndef ALTCP_MBEDTLS_USE_SESSION_TICKETS
@@ -95,11 +97,39 @@
 #define ALTCP_MBEDTLS_SESSION_TICKET_CIPHER           MBEDTLS_CIPHER_AES_256_GCM
 #endif
 
-/** Maximum timeout for session tickets */
+/** Maximum timeout for session tickets, the ticket key is rotated after this time */
 #ifndef ALTCP_MBEDTLS_SESSION_TICKET_TIMEOUT_SECONDS
 #define ALTCP_MBEDTLS_SESSION_TICKET_TIMEOUT_SECONDS  (60 * 60 * 24)
 #endif
 
+/** Record size policy: plaintext size of the TLS records written at the start
+ * of a connection and after it has been idle (see ALTCP_MBEDTLS_RECORD_SIZE_IDLE_MS),
+ * 0 disables the policy.
+ * Small records can be decrypted by the peer as soon as the TCP segment carrying
+ * them arrives (while the congestion window is small), large records save
+ * per-record CPU and overhead for bulk data. For one record per segment, use
+ * TCP_MSS minus the record expansion of the cipher suite (e.g. 29 bytes for AES-GCM).
+ * The limit is applied via altcp_sndbuf(), which applications use to size their
+ * writes.
+ */
+#ifndef ALTCP_MBEDTLS_RECORD_SIZE_SMALL
+#define ALTCP_MBEDTLS_RECORD_SIZE_SMALL               0
+#endif
+
+/** Record size policy: number of application bytes sent in small records before
+ * switching to the largest record size allowed by the send buffer
+ */
+#ifndef ALTCP_MBEDTLS_RECORD_SIZE_SMALL_BYTES
+#define ALTCP_MBEDTLS_RECORD_SIZE_SMALL_BYTES         (16 * 1024)
+#endif
+
+/** Record size policy: return to small records after the connection has not
+ * sent for this number of milliseconds
+ */
+#ifndef ALTCP_MBEDTLS_RECORD_SIZE_IDLE_MS
+#define ALTCP_MBEDTLS_RECORD_SIZE_IDLE_MS             1000
+#endif
+
 /** Certificate verification mode: MBEDTLS_SSL_VERIFY_NONE, MBEDTLS_SSL_VERIFY_OPTIONAL (default),
  * MBEDTLS_SSL_VERIFY_REQUIRED (recommended)*/
 #ifndef ALTCP_MBEDTLS_AUTHMODE
@@ -43,6 +43,9 @@ extern "C" {
 #define FS_READ_DELAYED -2
 
 #if HTTPD_PRECALCULATED_CHECKSUM
+/** Checksum of a chunk of a file (including the HTTP header, if included).
+ * A file can have lists of chunks for more than one segment size, each list
+ * starts with a chunk at offset 0. */
 struct fsdata_chksum {
   u32_t offset;
   u16_t chksum;
@@ -55,6 +58,12 @@ struct fsdata_chksum {
 #define FS_FILE_FLAGS_HEADER_HTTPVER_1_1  0x04
 #define FS_FILE_FLAGS_SSI                 0x08
 #define FS_FILE_FLAGS_CUSTOM              0x10
+/** Pre-compressed variants of this file exist ("<name>.gz", "<name>.br") */
+#define FS_FILE_FLAGS_ENCODING_VARIANTS   0x20
+/** The file data is gzip-compressed (Content-Encoding: gzip) */
+#define FS_FILE_FLAGS_ENCODING_GZIP       0x40
+/** The file data is brotli-compressed (Content-Encoding: br) */
+#define FS_FILE_FLAGS_ENCODING_BR         0x80
 
 /** Define FS_FILE_EXTENSION_T_DEFINED if you have typedef'ed to your private
  * pointer type (defaults to 'void' so the default usage is 'void*')
@@ -76,6 +85,12 @@ struct fs_file {
   const struct fsdata_chksum *chksum;
   u16_t chksum_count;
 #endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+  /* HTTP header lines with the validators of the file ("ETag: ...\r\n"
+     and/or "Last-Modified: ...\r\n") or NULL, must stay valid after
+     fs_close() */
+  const char *validators;
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
   u8_t flags;
 #if LWIP_HTTPD_FILE_STATE
   void *state;
@@ -99,6 +114,9 @@ int fs_read(struct fs_file *file, char *buffer, int count);
 int fs_is_file_ready(struct fs_file *file, fs_wait_cb callback_fn, void *callback_arg);
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
 int fs_bytes_left(struct fs_file *file);
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+const char *fs_get_validators(const char *name, u8_t *flags);
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
 
 #if LWIP_HTTPD_FILE_STATE
 /** This user-defined function is called when a file is opened. */
@@ -117,6 +135,9 @@ struct fsdata_file {
   u16_t chksum_count;
   const struct fsdata_chksum *chksum;
 #endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+  const char *validators;
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
 };
 
 #if LWIP_HTTPD_CUSTOM_FILES
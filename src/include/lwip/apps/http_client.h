@@ -61,6 +61,45 @@ extern "C" {
 #define LWIP_HTTPC_HAVE_FILE_IO   0
 #endif
 
+/**
+ * @ingroup httpc
+ * LWIP_HTTPC_KEEPALIVE==1: keep connections open after a complete response
+ * (HTTP/1.1 persistent connections) and reuse them for later requests to the
+ * same server (same host name/address, port, proxy and altcp allocator, i.e.
+ * TLS config). Idle connections are kept in a pool of
+ * LWIP_HTTPC_KEEPALIVE_POOL_SIZE entries and closed after
+ * LWIP_HTTPC_KEEPALIVE_IDLE_TIMEOUT seconds.
+ */
+#ifndef LWIP_HTTPC_KEEPALIVE
+#define LWIP_HTTPC_KEEPALIVE      0
+#endif
+
+/**
+ * @ingroup httpc
+ * Maximum number of idle connections kept open (the connection idle for the
+ * longest time is closed to make room for a new one)
+ */
+#ifndef LWIP_HTTPC_KEEPALIVE_POOL_SIZE
+#define LWIP_HTTPC_KEEPALIVE_POOL_SIZE  2
+#endif
+
+/**
+ * @ingroup httpc
+ * Idle connections are closed after this number of seconds
+ */
+#ifndef LWIP_HTTPC_KEEPALIVE_IDLE_TIMEOUT
+#define LWIP_HTTPC_KEEPALIVE_IDLE_TIMEOUT  10
+#endif
+
+/**
+ * @ingroup httpc
+ * Maximum length of a server name (including the terminating NULL byte) for
+ * a connection to be kept open
+ */
+#ifndef LWIP_HTTPC_KEEPALIVE_HOST_LEN
+#define LWIP_HTTPC_KEEPALIVE_HOST_LEN  64
+#endif
+
 /**
  * @ingroup httpc
  * The default TCP port used for HTTP
@@ -151,6 +190,10 @@ err_t httpc_get_file_dns_to_disk(const char* server_name, u16_t port, const char
                      void* callback_arg, const char* local_file_name, httpc_state_t **connection);
 #endif /* LWIP_HTTPC_HAVE_FILE_IO */
 
+#if LWIP_HTTPC_KEEPALIVE
+void httpc_keepalive_close_all(void);
+#endif /* LWIP_HTTPC_KEEPALIVE */
+
 #ifdef __cplusplus
 }
 #endif
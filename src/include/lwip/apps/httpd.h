@@ -242,6 +242,70 @@ void httpd_post_data_recved(void *connection, u16_t recved_len);
 
 #endif /* LWIP_HTTPD_SUPPORT_POST */
 
+#if LWIP_HTTPD_WEBSOCKET
+
+/** WebSocket opcodes */
+#define HTTPD_WEBSOCKET_CONTINUATION  0x00
+#define HTTPD_WEBSOCKET_TEXT          0x01
+#define HTTPD_WEBSOCKET_BINARY        0x02
+#define HTTPD_WEBSOCKET_CLOSE         0x08
+#define HTTPD_WEBSOCKET_PING          0x09
+#define HTTPD_WEBSOCKET_PONG          0x0A
+/** Flag passed to httpd_websocket_receive() with the last frame of a message */
+#define HTTPD_WEBSOCKET_FIN           0x80
+/** Space needed in front of the data of a pbuf passed to httpd_websocket_send()
+ * to prepend the frame header without allocating another pbuf */
+#define HTTPD_WEBSOCKET_HEADER_LEN    4
+
+/* These functions must be implemented by the application */
+
+/**
+ * @ingroup httpd
+ * Called when a client requests to upgrade a GET request to a WebSocket.
+ * The application can decide whether to accept it or not. Data may already
+ * be sent from this callback.
+ *
+ * @param connection Unique connection identifier, valid until
+ *        httpd_websocket_closed is called.
+ * @param uri The URI of the request.
+ * @param http_request The raw HTTP request.
+ * @param http_request_len Size of 'http_request'.
+ * @return ERR_OK: Accept the upgrade, "101 Switching Protocols" is sent
+ *         another err_t: Deny the upgrade, the request is handled as a normal
+ *         GET request
+ */
+err_t httpd_websocket_accept(void *connection, const char *uri, const char *http_request,
+                             u16_t http_request_len);
+
+/**
+ * @ingroup httpd
+ * Called for each data frame received on a WebSocket (control frames are
+ * handled by httpd). The payload is unmasked already. Text messages are checked
+ * to be valid UTF-8 (a character may still be split between two frames), the
+ * connection is closed with status 1007 otherwise.
+ * ATTENTION: The application is responsible for freeing the pbufs passed in!
+ *
+ * @param connection Unique connection identifier.
+ * @param opcode HTTPD_WEBSOCKET_TEXT, _BINARY or _CONTINUATION (for fragmented
+ *        messages), or'ed with HTTPD_WEBSOCKET_FIN for the last frame of a message
+ * @param p Payload of the frame, NULL for empty frames
+ */
+void httpd_websocket_receive(void *connection, u8_t opcode, struct pbuf *p);
+
+/**
+ * @ingroup httpd
+ * Called when a WebSocket connection is closed.
+ *
+ * @param connection Unique connection identifier, invalid after returning.
+ */
+void httpd_websocket_closed(void *connection);
+
+struct pbuf *httpd_websocket_alloc(u16_t len);
+err_t httpd_websocket_send(void *connection, u8_t opcode, struct pbuf *p);
+err_t httpd_websocket_close(void *connection, u16_t status);
+
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
 #if LWIP_HTTPD_HEADERS_BEFORE_FILE_OPEN
 
 /**
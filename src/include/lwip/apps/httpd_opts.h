@@ -136,6 +136,25 @@
 #define LWIP_HTTPD_SUPPORT_POST   0
 #endif
 
+/** Set this to 1 to support WebSocket connections (RFC 6455): GET requests
+ * with "Upgrade: websocket" are passed to httpd_websocket_accept() and, if
+ * accepted, the connection is switched to WebSocket frames.
+ * The application has to implement the httpd_websocket_* callbacks (see httpd.h).
+ */
+#if !defined LWIP_HTTPD_WEBSOCKET || defined __DOXYGEN__
+#define LWIP_HTTPD_WEBSOCKET      0
+#endif
+
+/** Maximum payload length of a received WebSocket frame. The payload is
+ * collected in a pbuf chain before being passed to the application, larger
+ * frames close the connection (status 1009). Must not exceed 0xFFFF - 14.
+ * Frames are limited to TCP_WND - 14 bytes, too, as a frame is passed to
+ * altcp_recved() only when it has been received completely.
+ */
+#if !defined LWIP_HTTPD_WEBSOCKET_MAX_RX_LEN || defined __DOXYGEN__
+#define LWIP_HTTPD_WEBSOCKET_MAX_RX_LEN 4096
+#endif
+
 /* The maximum number of parameters that the CGI handler can be sent. */
 #if !defined LWIP_HTTPD_MAX_CGI_PARAMETERS || defined __DOXYGEN__
 #define LWIP_HTTPD_MAX_CGI_PARAMETERS 16
@@ -324,6 +343,81 @@
 #define LWIP_HTTPD_MAX_REQUEST_URI_LEN      63
 #endif
 
+/** Set this to 1 to serve pre-compressed variants of files to clients
+ * accepting them: for a file with FS_FILE_FLAGS_ENCODING_VARIANTS set, the
+ * file "<name>.br" or "<name>.gz" is sent instead (with "Content-Encoding")
+ * if the "Accept-Encoding" header of the request allows it.
+ * The variants are created by makefsdata using "-enc:gzip,br". They are not
+ * sent when requested by their own name ("404 Not Found" instead).
+ */
+#if !defined LWIP_HTTPD_CONTENT_ENCODING || defined __DOXYGEN__
+#define LWIP_HTTPD_CONTENT_ENCODING         0
+#endif
+
+/** This is the size of a static buffer used to build the file names of
+ * pre-compressed variants (the name of the file plus ".br" or ".gz").
+ * Variants of files with longer names are not used.
+ */
+#if !defined LWIP_HTTPD_CONTENT_ENCODING_NAME_LEN || defined __DOXYGEN__
+#define LWIP_HTTPD_CONTENT_ENCODING_NAME_LEN 63
+#endif
+
+/** Set this to 1 to answer conditional GET requests: if the "If-None-Match"
+ * (or, without it, the "If-Modified-Since") header of a request matches the
+ * validators of the file (see struct fs_file), "304 Not Modified" is sent
+ * instead of the file.
+ * The validators ("ETag" and "Last-Modified") are created by makefsdata
+ * using "-etag" and "-m". If-Modified-Since must match the Last-Modified
+ * date exactly (as browsers send it back unchanged).
+ * Files of the compiled-in file system are checked before they are opened
+ * (see fs_get_validators()).
+ * This needs LWIP_HTTPD_DYNAMIC_HEADERS.
+ */
+#if !defined LWIP_HTTPD_CONDITIONAL_REQUESTS || defined __DOXYGEN__
+#define LWIP_HTTPD_CONDITIONAL_REQUESTS     0
+#endif
+
+/** Set this to 1 to answer requests pipelined on a persistent connection:
+ * data received while a response is being sent is queued in the connection
+ * state (the TCP window is only opened again when it is processed) and the
+ * next request is parsed as soon as the response is complete.
+ * Without this, such requests are dropped.
+ * This needs LWIP_HTTPD_SUPPORT_11_KEEPALIVE and LWIP_HTTPD_SUPPORT_REQUESTLIST.
+ */
+#if !defined LWIP_HTTPD_PIPELINING || defined __DOXYGEN__
+#define LWIP_HTTPD_PIPELINING               0
+#endif
+
+/** Set this to 1 to answer GET requests for a single byte range
+ * ("Range: bytes=first-last") with "206 Partial Content" (e.g. to resume
+ * downloads). Only files with their data in memory (file->data != NULL) and
+ * without HTTP header included in the file (makefsdata -e) are sent
+ * partially, other files are sent completely.
+ * "If-Range" is supported with LWIP_HTTPD_CONDITIONAL_REQUESTS, without it,
+ * requests with "If-Range" get the complete file.
+ * This needs LWIP_HTTPD_DYNAMIC_HEADERS.
+ */
+#if !defined LWIP_HTTPD_RANGE_REQUESTS || defined __DOXYGEN__
+#define LWIP_HTTPD_RANGE_REQUESTS           0
+#endif
+
+/** "Cache-Control" header line (including CRLF) sent with documents
+ * (html, xml, json), e.g. "Cache-Control: no-cache\r\n" to let browsers
+ * revalidate every time (which is cheap with LWIP_HTTPD_CONDITIONAL_REQUESTS).
+ * Default is empty (no Cache-Control).
+ */
+#if !defined LWIP_HTTPD_CACHE_CONTROL_DOCUMENT || defined __DOXYGEN__
+#define LWIP_HTTPD_CACHE_CONTROL_DOCUMENT   ""
+#endif
+
+/** "Cache-Control" header line (including CRLF) sent with static assets
+ * (images, scripts, style sheets etc.), e.g.
+ * "Cache-Control: max-age=86400\r\n". Default is empty (no Cache-Control).
+ */
+#if !defined LWIP_HTTPD_CACHE_CONTROL_ASSET || defined __DOXYGEN__
+#define LWIP_HTTPD_CACHE_CONTROL_ASSET      ""
+#endif
+
 /** Maximum length of the filename to send as response to a POST request,
  * filled in by the application when a POST is finished.
  */
@@ -418,7 +512,12 @@
 
 /** HTTPD_PRECALCULATED_CHECKSUM==1: include precompiled checksums for
  * predefined (MSS-sized) chunks of the files to prevent having to calculate
- * the checksums at runtime. */
+ * the checksums at runtime.
+ * Create them with "makefsdata -c" (for TCP_MSS) or "makefsdata -c:<list>"
+ * (for a list of segment sizes, the largest one fitting the MSS of a
+ * connection is used). The files are then sent one chunk per segment
+ * without the data being read by the CPU, which needs LWIP_CHECKSUM_ON_COPY
+ * (otherwise, the checksums are ignored). */
 #if !defined HTTPD_PRECALCULATED_CHECKSUM || defined __DOXYGEN__
 #define HTTPD_PRECALCULATED_CHECKSUM  0
 #endif
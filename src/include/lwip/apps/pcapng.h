@@ -0,0 +1,81 @@
+/**
+ * @file
+ * pcapng packet capture API
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_APPS_PCAPNG_H
+#define LWIP_HDR_APPS_PCAPNG_H
+
+#include "lwip/apps/pcapng_opts.h"
+#include "lwip/netif.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @ingroup pcapng
+ * Ring buffer full: drop new packets (lowest overhead, this is the default) */
+#define PCAPNG_MODE_DROP_NEW   0
+/** @ingroup pcapng
+ * Ring buffer full: discard the oldest packets to make room */
+#define PCAPNG_MODE_OVERWRITE  1
+
+/** @ingroup pcapng
+ * Capture statistics */
+struct pcapng_stats {
+  /** packets stored in the ring buffer */
+  u32_t captured;
+  /** packets not matching the filter */
+  u32_t filtered;
+  /** packets dropped because the ring buffer was full (PCAPNG_MODE_DROP_NEW) */
+  u32_t dropped;
+  /** packets discarded from the ring buffer to make room (PCAPNG_MODE_OVERWRITE) */
+  u32_t overwritten;
+};
+
+void  pcapng_init(void);
+err_t pcapng_attach(struct netif *netif);
+err_t pcapng_detach(struct netif *netif);
+err_t pcapng_set_filter(const char *expr);
+void  pcapng_set_mode(u8_t mode);
+void  pcapng_set_snaplen(u16_t snaplen);
+void  pcapng_start(void);
+void  pcapng_stop(void);
+u16_t pcapng_get_header(u8_t *buf, u16_t len);
+u32_t pcapng_read(u8_t *buf, u32_t len);
+void  pcapng_get_stats(struct pcapng_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HDR_APPS_PCAPNG_H */
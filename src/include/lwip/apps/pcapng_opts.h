@@ -0,0 +1,89 @@
+/**
+ * @file
+ * pcapng packet capture options list
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_APPS_PCAPNG_OPTS_H
+#define LWIP_HDR_APPS_PCAPNG_OPTS_H
+
+#include "lwip/opt.h"
+
+/**
+ * @defgroup pcapng_opts Options
+ * @ingroup pcapng
+ * @{
+ */
+
+/** Size of the capture ring buffer in bytes (rounded down to a multiple of 4).
+ * Each captured packet needs (44 + captured length rounded up to 4) bytes.
+ */
+#if !defined PCAPNG_RINGBUF_SIZE || defined __DOXYGEN__
+#define PCAPNG_RINGBUF_SIZE             8192
+#endif
+
+/** Maximum number of netifs that can be attached at the same time */
+#if !defined PCAPNG_MAX_NETIFS || defined __DOXYGEN__
+#define PCAPNG_MAX_NETIFS               2
+#endif
+
+/** Default number of bytes captured per packet (can be changed at runtime
+ * via @ref pcapng_set_snaplen) */
+#if !defined PCAPNG_DEFAULT_SNAPLEN || defined __DOXYGEN__
+#define PCAPNG_DEFAULT_SNAPLEN          128
+#endif
+
+/** Maximum number of instructions a compiled capture filter may contain.
+ * Every primitive and every 'and', 'or', 'not' takes one instruction.
+ */
+#if !defined PCAPNG_FILTER_MAX_INSNS || defined __DOXYGEN__
+#define PCAPNG_FILTER_MAX_INSNS         16
+#endif
+
+/** Maximum nesting of 'not' and parentheses in a capture filter expression.
+ * The filter compiler recurses once per level, so this bounds its stack usage.
+ */
+#if !defined PCAPNG_FILTER_MAX_DEPTH || defined __DOXYGEN__
+#define PCAPNG_FILTER_MAX_DEPTH         8
+#endif
+
+/**
+ * PCAPNG_DEBUG: Enable debugging for pcapng capture.
+ */
+#if !defined PCAPNG_DEBUG || defined __DOXYGEN__
+#define PCAPNG_DEBUG                    LWIP_DBG_OFF
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* LWIP_HDR_APPS_PCAPNG_OPTS_H */
@@ -81,6 +81,11 @@ int etharp_get_entry(size_t i, ip4_addr_t **ipaddr, struct netif **netif, struct
 err_t etharp_output(struct netif *netif, struct pbuf *q, const ip4_addr_t *ipaddr);
 err_t etharp_query(struct netif *netif, const ip4_addr_t *ipaddr, struct pbuf *q);
 err_t etharp_request(struct netif *netif, const ip4_addr_t *ipaddr);
+const ip4_addr_t *etharp_next_hop(struct netif *netif, const ip4_addr_t *ipaddr);
+#if IP_FORWARD_FLOW_CACHE
+err_t etharp_output_to_next_hop(struct netif *netif, struct pbuf *q, const ip4_addr_t *next_hop,
+                                netif_addr_idx_t *arp_idx);
+#endif /* IP_FORWARD_FLOW_CACHE */
 /** For Ethernet network interfaces, we might want to send "gratuitous ARP";
  *  this is an ARP packet sent by a node in order to spontaneously cause other
  *  nodes to update an entry in their ARP cache.
@@ -71,9 +71,29 @@ extern "C" {
  * will not run the state machine as it is used to kick off reports
  * from all the other groups
  */
+#if LWIP_IGMP_SOURCE_FILTER
+/** A source a group is joined for (see igmp_joingroup_source_netif()) */
+struct igmp_source {
+  /** next source of the same group */
+  struct igmp_source *next;
+  /** unicast address of the source */
+  ip4_addr_t          source_address;
+  /** counter of simultaneous uses */
+  u8_t                use;
+};
+#endif /* LWIP_IGMP_SOURCE_FILTER */
+
 struct igmp_group {
   /** next link */
   struct igmp_group *next;
+#if IGMP_GROUP_HASH_SIZE
+  /** next group in the same bucket of the membership hash table */
+  struct igmp_group *hash_next;
+#endif /* IGMP_GROUP_HASH_SIZE */
+#if LWIP_IGMP_SOURCE_FILTER
+  /** sources joined with igmp_joingroup_source_netif() */
+  struct igmp_source *sources;
+#endif /* LWIP_IGMP_SOURCE_FILTER */
   /** multicast address */
   ip4_addr_t         group_address;
   /** signifies we were the last person to report */
@@ -82,8 +102,12 @@ struct igmp_group {
   u8_t               group_state;
   /** timer for reporting, negative is OFF */
   u16_t              timer;
-  /** counter of simultaneous uses */
+  /** counter of simultaneous uses (joins for any source) */
   u8_t               use;
+#if IGMP_GROUP_HASH_SIZE
+  /** index of the netif the group is joined on */
+  u8_t               netif_idx;
+#endif /* IGMP_GROUP_HASH_SIZE */
 };
 
 /*  Prototypes */
@@ -97,6 +121,11 @@ err_t  igmp_joingroup(const ip4_addr_t *ifaddr, const ip4_addr_t *groupaddr);
 err_t  igmp_joingroup_netif(struct netif *netif, const ip4_addr_t *groupaddr);
 err_t  igmp_leavegroup(const ip4_addr_t *ifaddr, const ip4_addr_t *groupaddr);
 err_t  igmp_leavegroup_netif(struct netif *netif, const ip4_addr_t *groupaddr);
+#if LWIP_IGMP_SOURCE_FILTER
+err_t  igmp_joingroup_source_netif(struct netif *netif, const ip4_addr_t *groupaddr, const ip4_addr_t *srcaddr);
+err_t  igmp_leavegroup_source_netif(struct netif *netif, const ip4_addr_t *groupaddr, const ip4_addr_t *srcaddr);
+u8_t   igmp_group_accepts_source(const struct igmp_group *group, const ip4_addr_t *srcaddr);
+#endif /* LWIP_IGMP_SOURCE_FILTER */
 void   igmp_tmr(void);
 
 /** @ingroup igmp
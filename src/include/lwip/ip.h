@@ -332,6 +332,48 @@ err_t ip_input(struct pbuf *p, struct netif *inp);
   (ipaddr) = ip_netif_get_local_ip(netif, dest); \
 }while(0)
 
+/**
+ * @ingroup ip
+ * Get netif for a TCP or UDP flow. With LWIP_FIB_ECMP, the flow's ports
+ * select one of several equal-cost paths; otherwise this is ip_route().
+ */
+#if LWIP_FIB_ECMP && LWIP_IPV4 && LWIP_IPV6
+#define ip_route_flow(src, dest, proto, sport, dport) \
+        (IP_IS_V6(dest) ? \
+        ip6_route_flow(ip_2_ip6(src), ip_2_ip6(dest), ip6_flow_hash(NULL, ip_2_ip6(dest), proto, sport, dport)) : \
+        ip4_route_flow(ip_2_ip4(src), ip_2_ip4(dest), ip4_flow_hash(NULL, ip_2_ip4(dest), proto, sport, dport)))
+#elif LWIP_FIB_ECMP && LWIP_IPV4
+#define ip_route_flow(src, dest, proto, sport, dport) \
+        ip4_route_flow(src, dest, ip4_flow_hash(NULL, dest, proto, sport, dport))
+#elif LWIP_FIB_ECMP && LWIP_IPV6
+#define ip_route_flow(src, dest, proto, sport, dport) \
+        ip6_route_flow(src, dest, ip6_flow_hash(NULL, dest, proto, sport, dport))
+#else /* LWIP_FIB_ECMP */
+#define ip_route_flow(src, dest, proto, sport, dport) ip_route(src, dest)
+#endif /* LWIP_FIB_ECMP */
+
+#if LWIP_NETIF_FRAG_OFFLOAD
+/** Layout of the fragments a netif doing fragmentation itself has to create
+ * from a packet, see ip_frag_offload_desc() */
+struct ip_frag_desc {
+  /** offset of the IP header in the packet (the link header length) */
+  u16_t ip_offset;
+  /** number of bytes at the start of the packet to repeat in front of the
+   * data of every fragment (link and IP header, for IPv6 also the fragment
+   * header) */
+  u16_t hdr_len;
+  /** number of data bytes following the headers */
+  u16_t data_len;
+  /** data bytes per fragment (a multiple of 8, the last one may be shorter) */
+  u16_t frag_size;
+  /** 4 or 6 */
+  u8_t ip_version;
+};
+
+err_t ip_frag_offload_desc(const struct pbuf *p, u16_t ip_offset, struct ip_frag_desc *desc);
+void  ip_frag_offload_hdr(struct netif *netif, const struct ip_frag_desc *desc, u8_t *hdr, u16_t offset, u16_t len);
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
+
 #ifdef __cplusplus
 }
 #endif
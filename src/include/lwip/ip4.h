@@ -68,6 +68,12 @@ struct netif *ip4_route_src(const ip4_addr_t *src, const ip4_addr_t *dest);
 #else /* LWIP_IPV4_SRC_ROUTING */
 #define ip4_route_src(src, dest) ip4_route(dest)
 #endif /* LWIP_IPV4_SRC_ROUTING */
+#if LWIP_FIB_ECMP
+struct netif *ip4_route_flow(const ip4_addr_t *src, const ip4_addr_t *dest, u32_t flow_hash);
+u32_t ip4_flow_hash(const ip4_addr_t *src, const ip4_addr_t *dest, u8_t proto, u16_t sport, u16_t dport);
+#else /* LWIP_FIB_ECMP */
+#define ip4_route_flow(src, dest, flow_hash) ip4_route_src(src, dest)
+#endif /* LWIP_FIB_ECMP */
 err_t ip4_input(struct pbuf *p, struct netif *inp);
 err_t ip4_output(struct pbuf *p, const ip4_addr_t *src, const ip4_addr_t *dest,
        u8_t ttl, u8_t tos, u8_t proto);
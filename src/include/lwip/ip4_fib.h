@@ -0,0 +1,91 @@
+/**
+ * @file
+ * IPv4 forwarding information base (longest-prefix-match routing table)
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#ifndef LWIP_HDR_IP4_FIB_H
+#define LWIP_HDR_IP4_FIB_H
+
+#include "lwip/opt.h"
+
+#if LWIP_IPV4 && LWIP_IPV4_FIB /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/err.h"
+#include "lwip/ip4_addr.h"
+#include "lwip/netif.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Netmask (host byte order) of a prefix length 0..32 */
+#define IP4_FIB_PREFIX_MASK(len) (((len) == 0) ? 0 : (u32_t)(0xffffffffUL << (32 - (len))))
+
+/** A node of the FIB trie.
+ * Nodes with netif != NULL are routes, the others only branch the trie.
+ * With LWIP_FIB_ECMP, further paths to the same prefix are linked to the
+ * route via 'next'; these entries are not linked into the trie.
+ * This is exported because memp needs to know the size.
+ */
+struct ip4_fib_entry {
+  struct ip4_fib_entry *child[2];
+  struct ip4_fib_entry *parent;
+#if LWIP_FIB_ECMP
+  struct ip4_fib_entry *next;
+#endif /* LWIP_FIB_ECMP */
+  /** destination prefix in host byte order (host bits are 0) */
+  u32_t prefix;
+  /** next hop or IP4_ADDR_ANY if the destination is on-link */
+  ip4_addr_t gw;
+  /** output netif (NULL for branch nodes) */
+  struct netif *netif;
+  u8_t prefix_len;
+};
+
+err_t ip4_fib_add(const ip4_addr_t *prefix, u8_t prefix_len, const ip4_addr_t *gw, struct netif *netif);
+err_t ip4_fib_remove(const ip4_addr_t *prefix, u8_t prefix_len);
+const struct ip4_fib_entry *ip4_fib_lookup(const ip4_addr_t *dest);
+#if LWIP_FIB_ECMP
+err_t ip4_fib_remove_path(const ip4_addr_t *prefix, u8_t prefix_len, const struct netif *netif);
+const struct ip4_fib_entry *ip4_fib_lookup_flow(const ip4_addr_t *dest, u32_t flow_hash);
+#endif /* LWIP_FIB_ECMP */
+const ip4_addr_t *ip4_fib_next_hop(const ip4_addr_t *dest, const struct netif *netif);
+void ip4_fib_cleanup_netif(const struct netif *netif);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_IPV4 && LWIP_IPV4_FIB */
+
+#endif /* LWIP_HDR_IP4_FIB_H */
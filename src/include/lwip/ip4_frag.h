@@ -60,9 +60,14 @@ extern "C" {
  */
 struct ip_reassdata {
   struct ip_reassdata *next;
+  /** root of the fragment tree */
   struct pbuf *p;
   struct ip_hdr iphdr;
+  /** number of data bytes queued */
+  u32_t received;
   u16_t datagram_len;
+  /** number of pbufs queued */
+  u16_t pbufs;
   u8_t flags;
   u8_t timer;
 };
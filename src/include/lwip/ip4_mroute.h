@@ -0,0 +1,70 @@
+/**
+ * @file
+ * IPv4 multicast forwarding (multicast route cache)
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#ifndef LWIP_HDR_IP4_MROUTE_H
+#define LWIP_HDR_IP4_MROUTE_H
+
+#include "lwip/opt.h"
+
+#if LWIP_IPV4 && LWIP_IPV4_MROUTE /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/err.h"
+#include "lwip/ip4_addr.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Highest netif index that can be an output netif of a multicast route */
+#define IP4_MROUTE_MAX_NETIF_INDEX  32
+
+/** @ingroup ip4_mroute
+ * Bit of a netif in the set of output netifs passed to ip4_mroute_add() */
+#define IP4_MROUTE_OIF(netif)       ((u32_t)1 << (netif_get_index(netif) - 1))
+
+err_t ip4_mroute_add(const ip4_addr_t *source, const ip4_addr_t *group, struct netif *iif, u32_t oifs);
+err_t ip4_mroute_remove(const ip4_addr_t *source, const ip4_addr_t *group);
+void  ip4_mroute_cleanup_netif(const struct netif *netif);
+void  ip4_mroute_forward(struct pbuf *p, struct netif *inp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_IPV4 && LWIP_IPV4_MROUTE */
+
+#endif /* LWIP_HDR_IP4_MROUTE_H */
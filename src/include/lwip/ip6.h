@@ -58,6 +58,12 @@ extern "C" {
 #endif
 
 struct netif *ip6_route(const ip6_addr_t *src, const ip6_addr_t *dest);
+#if LWIP_FIB_ECMP
+struct netif *ip6_route_flow(const ip6_addr_t *src, const ip6_addr_t *dest, u32_t flow_hash);
+u32_t ip6_flow_hash(const ip6_addr_t *src, const ip6_addr_t *dest, u8_t proto, u16_t sport, u16_t dport);
+#else /* LWIP_FIB_ECMP */
+#define ip6_route_flow(src, dest, flow_hash) ip6_route(src, dest)
+#endif /* LWIP_FIB_ECMP */
 const ip_addr_t *ip6_select_source_address(struct netif *netif, const ip6_addr_t * dest);
 err_t         ip6_input(struct pbuf *p, struct netif *inp);
 err_t         ip6_output(struct pbuf *p, const ip6_addr_t *src, const ip6_addr_t *dest,
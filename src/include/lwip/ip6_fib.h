@@ -0,0 +1,99 @@
+/**
+ * @file
+ * IPv6 forwarding information base (longest-prefix-match routing table)
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#ifndef LWIP_HDR_IP6_FIB_H
+#define LWIP_HDR_IP6_FIB_H
+
+#include "lwip/opt.h"
+
+#if LWIP_IPV6 && LWIP_IPV6_FIB /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/err.h"
+#include "lwip/ip6_addr.h"
+#include "lwip/netif.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Route configured with ip6_fib_add() */
+#define IP6_FIB_ORIGIN_STATIC   0
+/** Route learned from a router advertisement */
+#define IP6_FIB_ORIGIN_RA       1
+
+/** Metric of routes learned from router advertisements */
+#define IP6_FIB_METRIC_RA       1024
+
+/** An IPv6 route and/or a node of the FIB trie.
+ * Trie nodes with netif == NULL only branch the trie. Further routes to the
+ * same prefix are linked to the trie node via 'next', sorted by ascending
+ * metric.
+ * This is exported because memp needs to know the size.
+ */
+struct ip6_fib_entry {
+  struct ip6_fib_entry *child[2];
+  struct ip6_fib_entry *parent;
+  struct ip6_fib_entry *next;
+  /** destination prefix in host byte order (host bits are 0) */
+  u32_t prefix[4];
+  /** next hop or IP6_ADDR_ANY if the destination is on-link */
+  ip6_addr_t gw;
+  /** output netif (NULL for branch nodes) */
+  struct netif *netif;
+  u16_t metric;
+  u8_t prefix_len;
+  /** IP6_FIB_ORIGIN_STATIC or IP6_FIB_ORIGIN_RA */
+  u8_t origin;
+};
+
+err_t ip6_fib_add(const ip6_addr_t *prefix, u8_t prefix_len, const ip6_addr_t *gw, struct netif *netif, u16_t metric);
+err_t ip6_fib_remove(const ip6_addr_t *prefix, u8_t prefix_len, const ip6_addr_t *gw, struct netif *netif);
+const struct ip6_fib_entry *ip6_fib_lookup(const ip6_addr_t *dest, const struct netif *netif);
+#if LWIP_FIB_ECMP
+const struct ip6_fib_entry *ip6_fib_lookup_flow(const ip6_addr_t *dest, u32_t flow_hash);
+#endif /* LWIP_FIB_ECMP */
+void ip6_fib_cleanup_netif(const struct netif *netif);
+
+/* for nd6 */
+err_t ip6_fib_add_ra(const ip6_addr_t *prefix, u8_t prefix_len, const ip6_addr_t *gw, struct netif *netif);
+void ip6_fib_remove_ra(const ip6_addr_t *prefix, u8_t prefix_len, const ip6_addr_t *gw, struct netif *netif);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_IPV6 && LWIP_IPV6_FIB */
+
+#endif /* LWIP_HDR_IP6_FIB_H */
@@ -57,52 +57,50 @@ extern "C" {
 /** The IPv6 reassembly timer interval in milliseconds. */
 #define IP6_REASS_TMR_INTERVAL 1000
 
-/** IP6_FRAG_COPYHEADER==1: for platforms where sizeof(void*) > 4, "struct
- * ip6_reass_helper" is too large to be stored in the IPv6 fragment header, and
- * will bleed into the header before it, which may be the IPv6 header or an
- * extension header. This means that for each first fragment packet, we need to
- * 1) make a copy of some IPv6 header fields (src+dest) that we need later on,
- * just in case we do overwrite part of the IPv6 header, and 2) make a copy of
- * the header data that we overwrote, so that we can restore it before either
- * completing reassembly or sending an ICMPv6 reply. The last part is true even
- * if this setting is disabled, but if it is enabled, we need to save a bit
- * more data (up to the size of a pointer) because we overwrite more. */
+/** IPV6_FRAG_COPYHEADER==1: the node that keeps a fragment in the
+ * reassembly tree ("struct ip_reass_node", two pointers and two offsets) is
+ * larger than the IPv6 fragment header, and will bleed into the header before
+ * it, which may be the IPv6 header or an extension header. This means that for
+ * each first fragment packet, we need to 1) make a copy of some IPv6 header
+ * fields (src+dest) that we need later on, just in case we do overwrite part of
+ * the IPv6 header, and 2) make a copy of the header data that we overwrote, so
+ * that we can restore it before either completing reassembly or sending an
+ * ICMPv6 reply.
+ * As this is the case on all platforms, 0 is not supported any more. */
 #ifndef IPV6_FRAG_COPYHEADER
-#define IPV6_FRAG_COPYHEADER   0
+#define IPV6_FRAG_COPYHEADER   1
+#endif
+#if !IPV6_FRAG_COPYHEADER
+#error "IPV6_FRAG_COPYHEADER==0 is not supported any more, remove it from your lwipopts.h"
 #endif
 
-/* With IPV6_FRAG_COPYHEADER==1, a helper structure may (or, depending on the
- * presence of extensions, may not) overwrite part of the IP header. Therefore,
- * we copy the fields that we need from the IP header for as long as the helper
- * structure may still be in place. This is easier than temporarily restoring
- * those fields in the IP header each time we need to perform checks on them. */
-#if IPV6_FRAG_COPYHEADER
+/* A helper structure may (or, depending on the presence of extensions, may
+ * not) overwrite part of the IP header. Therefore, we copy the fields that we
+ * need from the IP header for as long as the helper structure may still be in
+ * place. This is easier than temporarily restoring those fields in the IP
+ * header each time we need to perform checks on them. */
 #define IPV6_FRAG_SRC(ipr) ((ipr)->src)
 #define IPV6_FRAG_DEST(ipr) ((ipr)->dest)
-#else /* IPV6_FRAG_COPYHEADER */
-#define IPV6_FRAG_SRC(ipr) ((ipr)->iphdr->src)
-#define IPV6_FRAG_DEST(ipr) ((ipr)->iphdr->dest)
-#endif /* IPV6_FRAG_COPYHEADER */
 
 /** IPv6 reassembly helper struct.
  * This is exported because memp needs to know the size.
  */
 struct ip6_reassdata {
   struct ip6_reassdata *next;
+  /** root of the fragment tree */
   struct pbuf *p;
   struct ip6_hdr *iphdr; /* pointer to the first (original) IPv6 header */
-#if IPV6_FRAG_COPYHEADER
   ip6_addr_p_t src; /* copy of the source address in the IP header */
   ip6_addr_p_t dest; /* copy of the destination address in the IP header */
   /* This buffer (for the part of the original header that we overwrite) will
    * be slightly oversized, but we cannot compute the exact size from here. */
-  u8_t orig_hdr[sizeof(struct ip6_frag_hdr) + sizeof(void*)];
-#else /* IPV6_FRAG_COPYHEADER */
-  /* In this case we still need the buffer, for sending ICMPv6 replies. */
-  u8_t orig_hdr[sizeof(struct ip6_frag_hdr)];
-#endif /* IPV6_FRAG_COPYHEADER */
+  u8_t orig_hdr[sizeof(struct ip6_frag_hdr) + 2 * sizeof(void*)];
+  /** number of data bytes queued */
+  u32_t received;
   u32_t identification;
   u16_t datagram_len;
+  /** number of pbufs queued */
+  u16_t pbufs;
   u8_t nexth;
   u8_t timer;
 #if LWIP_IPV6_SCOPES
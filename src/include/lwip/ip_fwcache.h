@@ -0,0 +1,116 @@
+/**
+ * @file
+ * IP forwarding flow cache
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+
+#ifndef LWIP_HDR_IP_FWCACHE_H
+#define LWIP_HDR_IP_FWCACHE_H
+
+#include "lwip/opt.h"
+
+#if IP_FORWARD_FLOW_CACHE /* don't build if not configured for use in lwipopts.h */
+
+#include "lwip/ip_addr.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if LWIP_IPV4 && IP_FORWARD
+/** The forwarding decision for packets to 'dest' received on 'inp' */
+struct ip4_fwcache_entry {
+  ip4_addr_t dest;
+#ifdef LWIP_HOOK_IP4_ROUTE_SRC
+  /** the route hook may decide by source address */
+  ip4_addr_t src;
+#endif /* LWIP_HOOK_IP4_ROUTE_SRC */
+  struct netif *inp;
+#if LWIP_FIB_ECMP
+  u32_t flow_hash;
+#endif /* LWIP_FIB_ECMP */
+  /** output netif */
+  struct netif *netif;
+  /** MTU of netif */
+  u16_t mtu;
+#if LWIP_ARP
+  /** address resolved by ARP if netif uses etharp_output(), else IP4_ADDR_ANY */
+  ip4_addr_t next_hop;
+  /** ARP table index of next_hop (ARP_TABLE_SIZE if not known yet) */
+  netif_addr_idx_t arp_idx;
+#endif /* LWIP_ARP */
+  /** entry is valid while this equals the cache generation */
+  u16_t generation;
+};
+
+struct ip4_fwcache_entry *ip4_fwcache_lookup(const ip4_addr_t *src, const ip4_addr_t *dest,
+                                             const struct netif *inp, u32_t flow_hash);
+struct ip4_fwcache_entry *ip4_fwcache_add(const ip4_addr_t *src, const ip4_addr_t *dest,
+                                          struct netif *inp, struct netif *netif, u32_t flow_hash);
+err_t ip4_fwcache_output(struct ip4_fwcache_entry *entry, struct pbuf *p);
+#endif /* LWIP_IPV4 && IP_FORWARD */
+
+#if LWIP_IPV6 && LWIP_IPV6_FORWARD && LWIP_IPV6_FIB
+/** The forwarding decision for packets to 'dest' received on 'inp' */
+struct ip6_fwcache_entry {
+  ip6_addr_t dest;
+  struct netif *inp;
+  /** output netif */
+  struct netif *netif;
+#if LWIP_FIB_ECMP
+  u32_t flow_hash;
+#endif /* LWIP_FIB_ECMP */
+  /** MTU of netif */
+  u16_t mtu;
+  /** entry is valid while this equals the cache generation */
+  u16_t generation;
+};
+
+const struct ip6_fwcache_entry *ip6_fwcache_lookup(const ip6_addr_t *dest, const struct netif *inp, u32_t flow_hash);
+const struct ip6_fwcache_entry *ip6_fwcache_add(const ip6_addr_t *dest, struct netif *inp, struct netif *netif, u32_t flow_hash);
+#endif /* LWIP_IPV6 && LWIP_IPV6_FORWARD && LWIP_IPV6_FIB */
+
+void ip_fwcache_invalidate(void);
+#define IP_FWCACHE_INVALIDATE() ip_fwcache_invalidate()
+
+#ifdef __cplusplus
+}
+#endif
+
+#else /* IP_FORWARD_FLOW_CACHE */
+#define IP_FWCACHE_INVALIDATE()
+#endif /* IP_FORWARD_FLOW_CACHE */
+
+#endif /* LWIP_HDR_IP_FWCACHE_H */
@@ -54,10 +54,30 @@
 extern "C" {
 #endif
 
+#if LWIP_MLD6_SOURCE_FILTER
+/** A source a group is joined for (see mld6_joingroup_source_netif()) */
+struct mld_source {
+  /** next source of the same group */
+  struct mld_source *next;
+  /** unicast address of the source */
+  ip6_addr_t         source_address;
+  /** counter of simultaneous uses */
+  u8_t               use;
+};
+#endif /* LWIP_MLD6_SOURCE_FILTER */
+
 /** MLD group */
 struct mld_group {
   /** next link */
   struct mld_group *next;
+#if MLD6_GROUP_HASH_SIZE
+  /** next group in the same bucket of the membership hash table */
+  struct mld_group *hash_next;
+#endif /* MLD6_GROUP_HASH_SIZE */
+#if LWIP_MLD6_SOURCE_FILTER
+  /** sources joined with mld6_joingroup_source_netif() */
+  struct mld_source *sources;
+#endif /* LWIP_MLD6_SOURCE_FILTER */
   /** multicast address */
   ip6_addr_t         group_address;
   /** signifies we were the last person to report */
@@ -66,8 +86,12 @@ struct mld_group {
   u8_t               group_state;
   /** timer for reporting */
   u16_t              timer;
-  /** counter of simultaneous uses */
+  /** counter of simultaneous uses (joins for any source) */
   u8_t               use;
+#if MLD6_GROUP_HASH_SIZE
+  /** index of the netif the group is joined on */
+  u8_t               netif_idx;
+#endif /* MLD6_GROUP_HASH_SIZE */
 };
 
 #define MLD6_TMR_INTERVAL              100 /* Milliseconds */
@@ -81,6 +105,11 @@ err_t  mld6_joingroup(const ip6_addr_t *srcaddr, const ip6_addr_t *groupaddr);
 err_t  mld6_joingroup_netif(struct netif *netif, const ip6_addr_t *groupaddr);
 err_t  mld6_leavegroup(const ip6_addr_t *srcaddr, const ip6_addr_t *groupaddr);
 err_t  mld6_leavegroup_netif(struct netif *netif, const ip6_addr_t *groupaddr);
+#if LWIP_MLD6_SOURCE_FILTER
+err_t  mld6_joingroup_source_netif(struct netif *netif, const ip6_addr_t *groupaddr, const ip6_addr_t *srcaddr);
+err_t  mld6_leavegroup_source_netif(struct netif *netif, const ip6_addr_t *groupaddr, const ip6_addr_t *srcaddr);
+u8_t   mld6_group_accepts_source(const struct mld_group *group, const ip6_addr_t *srcaddr);
+#endif /* LWIP_MLD6_SOURCE_FILTER */
 
 /** @ingroup mld6
  * Get list head of MLD6 groups for netif.
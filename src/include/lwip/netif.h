@@ -340,6 +340,10 @@ struct netif {
 #if LWIP_CHECKSUM_CTRL_PER_NETIF
   u16_t chksum_flags;
 #endif /* LWIP_CHECKSUM_CTRL_PER_NETIF*/
+#if LWIP_NETIF_FRAG_OFFLOAD
+  /** IP versions this netif fragments itself (NETIF_FRAG_OFFLOAD_*) */
+  u8_t frag_offload;
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
   /** maximum transfer unit (in bytes) */
   u16_t mtu;
 #if LWIP_IPV6 && LWIP_ND6_ALLOW_RA_UPDATES
@@ -416,6 +420,19 @@ struct netif {
 #define IF__NETIF_CHECKSUM_ENABLED(netif, chksumflag)
 #endif /* LWIP_CHECKSUM_CTRL_PER_NETIF */
 
+#if LWIP_NETIF_FRAG_OFFLOAD
+/** The netif fragments IPv4 packets exceeding its MTU itself */
+#define NETIF_FRAG_OFFLOAD_IP4 0x01U
+/** The netif fragments IPv6 packets exceeding the path MTU itself */
+#define NETIF_FRAG_OFFLOAD_IP6 0x02U
+#define NETIF_SET_FRAG_OFFLOAD(netif, offloadflags) do { \
+  (netif)->frag_offload = offloadflags; } while(0)
+#define NETIF_FRAG_OFFLOAD_ENABLED(netif, offloadflag) (((netif)->frag_offload & (offloadflag)) != 0)
+#else /* LWIP_NETIF_FRAG_OFFLOAD */
+#define NETIF_SET_FRAG_OFFLOAD(netif, offloadflags)
+#define NETIF_FRAG_OFFLOAD_ENABLED(netif, offloadflag) 0
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
+
 #if LWIP_SINGLE_NETIF
 #define NETIF_FOREACH(netif) if (((netif) = netif_default) != NULL)
 #else /* LWIP_SINGLE_NETIF */
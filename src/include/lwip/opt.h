@@ -492,6 +492,15 @@
 #define MEMP_NUM_FRAG_PBUF              15
 #endif
 
+/**
+ * MEMP_NUM_IP4_FIB_NODE: the number of IPv4 routing table nodes
+ * (requires LWIP_IPV4_FIB). Every route needs one node, plus up to one
+ * node where the trie branches, so n routes need at most 2 * n - 1 nodes.
+ */
+#if !defined MEMP_NUM_IP4_FIB_NODE || defined __DOXYGEN__
+#define MEMP_NUM_IP4_FIB_NODE           16
+#endif
+
 /**
  * MEMP_NUM_ARP_QUEUE: the number of simultaneously queued outgoing
  * packets (pbufs) that are waiting for an ARP request (to resolve
@@ -512,6 +521,16 @@
 #define MEMP_NUM_IGMP_GROUP             8
 #endif
 
+/**
+ * MEMP_NUM_IGMP_SOURCE: The number of sources that can be joined with
+ * igmp_joingroup_source_netif() at the same time (one per distinct source
+ * and group on a netif).
+ * (requires the LWIP_IGMP_SOURCE_FILTER option)
+ */
+#if !defined MEMP_NUM_IGMP_SOURCE || defined __DOXYGEN__
+#define MEMP_NUM_IGMP_SOURCE            8
+#endif
+
 /**
  * The number of sys timeouts used by the core stack (not apps)
  * The default number of timeouts is calculated here for all enabled modules.
@@ -731,6 +750,23 @@
 #if !defined ETHARP_TABLE_MATCH_NETIF || defined __DOXYGEN__
 #define ETHARP_TABLE_MATCH_NETIF        !LWIP_SINGLE_NETIF
 #endif
+
+/** ETHARP_TABLE_HASH==1: Index the ARP table by IP address in a hash table
+ * and recycle entries in least-recently-updated order, so that finding an
+ * entry does not scan the whole table. Use this with a large ARP_TABLE_SIZE
+ * (e.g. for hundreds of neighbors on one segment).
+ */
+#if !defined ETHARP_TABLE_HASH || defined __DOXYGEN__
+#define ETHARP_TABLE_HASH               0
+#endif
+
+/** ETHARP_TABLE_HASH_SIZE: Number of hash buckets of the ARP table if
+ * ETHARP_TABLE_HASH is enabled (must be a power of 2). ARP_TABLE_SIZE / 4
+ * or more buckets keep the bucket chains short.
+ */
+#if !defined ETHARP_TABLE_HASH_SIZE || defined __DOXYGEN__
+#define ETHARP_TABLE_HASH_SIZE          16
+#endif
 /**
  * @}
  */
@@ -787,6 +823,8 @@
 #define IP_REASSEMBLY                   0
 #undef IP_FRAG
 #define IP_FRAG                         0
+#undef LWIP_IPV4_FIB
+#define LWIP_IPV4_FIB                   0
 #endif /* !LWIP_IPV4 */
 
 /**
@@ -819,6 +857,27 @@
 #define IP_REASS_MAX_PBUFS              10
 #endif
 
+/**
+ * IP_REASS_MAX_PBUFS_PER_SOURCE: Maximum amount of pbufs waiting to be
+ * reassembled for datagrams from one source address. Fragments exceeding this
+ * are dropped instead of evicting other datagrams, so a single (possibly
+ * spoofing) peer cannot monopolize the reassembly buffer.
+ * Applies to IPv4 and IPv6 reassembly separately.
+ */
+#if !defined IP_REASS_MAX_PBUFS_PER_SOURCE || defined __DOXYGEN__
+#define IP_REASS_MAX_PBUFS_PER_SOURCE   IP_REASS_MAX_PBUFS
+#endif
+
+/**
+ * IP_REASS_HASH_SIZE: Number of hash buckets (by source address) the
+ * datagrams being reassembled are kept in. Must be a power of 2.
+ * 1 keeps a single list, which is enough for a few concurrent datagrams.
+ * Applies to IPv4 and IPv6 reassembly separately.
+ */
+#if !defined IP_REASS_HASH_SIZE || defined __DOXYGEN__
+#define IP_REASS_HASH_SIZE              1
+#endif
+
 /**
  * IP_DEFAULT_TTL: Default value for Time-To-Live used by transport layers.
  */
@@ -853,6 +912,106 @@
 #if !defined IP_FORWARD_ALLOW_TX_ON_RX_NETIF || defined __DOXYGEN__
 #define IP_FORWARD_ALLOW_TX_ON_RX_NETIF 0
 #endif
+
+/**
+ * IP_FORWARD_FLOW_CACHE==1: Cache forwarding decisions per (input netif,
+ * destination) (see @ref ip_fwcache) so that forwarded packets skip the route
+ * lookup and, on Ethernet netifs, the gateway selection and ARP table search.
+ * Used by IP_FORWARD and by LWIP_IPV6_FORWARD if LWIP_IPV6_FIB is enabled.
+ * Routing hooks must not route forwarded packets by source address.
+ */
+#if !defined IP_FORWARD_FLOW_CACHE || defined __DOXYGEN__
+#define IP_FORWARD_FLOW_CACHE           0
+#endif
+
+/**
+ * IP_FORWARD_FLOW_CACHE_SIZE: Number of entries of the forwarding flow cache
+ * per IP version (must be a power of 2).
+ */
+#if !defined IP_FORWARD_FLOW_CACHE_SIZE || defined __DOXYGEN__
+#define IP_FORWARD_FLOW_CACHE_SIZE      64
+#endif
+
+/**
+ * LWIP_IPV4_FIB==1: Enable the IPv4 routing table (see @ref ip4_fib): static
+ * routes with per-route gateways, looked up by longest prefix match in
+ * ip4_route() and etharp_output(). Without it, only the netifs' own subnets,
+ * LWIP_HOOK_IP4_ROUTE() and the default netif are used for routing.
+ */
+#if !defined LWIP_IPV4_FIB || defined __DOXYGEN__
+#define LWIP_IPV4_FIB                   0
+#endif
+
+/**
+ * LWIP_IPV4_PMTU==1: Path MTU discovery for IPv4 (RFC 1191, see @ref ip4_pmtu):
+ * TCP segments are sent with the DF flag, ICMP "fragmentation needed"
+ * messages about TCP data in flight update a per-destination PMTU cache and
+ * reduce the MSS of the affected TCP connections. Other TCP connections to
+ * the destination reduce their MSS before sending. Outgoing packets without
+ * DF are fragmented to the cached PMTU, ip4_output_if() rejects packets with
+ * DF with ERR_MTU. Forwarded packets too big for the next hop are answered
+ * with the next-hop MTU regardless of this option.
+ */
+#if !defined LWIP_IPV4_PMTU || defined __DOXYGEN__
+#define LWIP_IPV4_PMTU                  0
+#endif
+
+/**
+ * IP4_PMTU_CACHE_SIZE: Number of destinations with a PMTU below the MTU of
+ * their netif that are remembered. When full, the entry closest to expiry is
+ * replaced.
+ */
+#if !defined IP4_PMTU_CACHE_SIZE || defined __DOXYGEN__
+#define IP4_PMTU_CACHE_SIZE             8
+#endif
+
+/**
+ * IP4_PMTU_TIMEOUT: Seconds after which a learned PMTU is forgotten so that
+ * a larger PMTU can be discovered again (RFC 1191 suggests 10 minutes).
+ */
+#if !defined IP4_PMTU_TIMEOUT || defined __DOXYGEN__
+#define IP4_PMTU_TIMEOUT                600
+#endif
+
+/**
+ * IP4_PMTU_MIN: Lowest PMTU accepted from an ICMP message. Smaller values
+ * (including the 68 bytes allowed by RFC 791) are raised to this, which
+ * limits the damage done by forged messages.
+ */
+#if !defined IP4_PMTU_MIN || defined __DOXYGEN__
+#define IP4_PMTU_MIN                    552
+#endif
+
+/**
+ * LWIP_FIB_ECMP==1: Equal-cost multipath routing. A prefix in the IPv4
+ * routing table may be added once per netif, and equal-metric routes of the
+ * IPv6 routing table are used side by side. TCP, UDP and forwarded packets
+ * are spread across these paths by a hash of their addresses and ports, so
+ * every flow stays on one path. Other traffic uses the first usable path.
+ */
+#if !defined LWIP_FIB_ECMP || defined __DOXYGEN__
+#define LWIP_FIB_ECMP                   0
+#endif
+
+/**
+ * LWIP_IPV4_MROUTE==1: Forward IPv4 multicast between netifs (see
+ * @ref ip4_mroute). Packets to a group are copied to the output netifs of a
+ * (source, group) or (*, group) route if they arrive on the route's input
+ * netif. This does not depend on IP_FORWARD and does not implement a
+ * multicast routing protocol: routes are added by the application, e.g.
+ * from the IGMP reports snooped on the output netifs.
+ */
+#if !defined LWIP_IPV4_MROUTE || defined __DOXYGEN__
+#define LWIP_IPV4_MROUTE                0
+#endif
+
+/**
+ * IP4_MROUTE_CACHE_SIZE: Number of IPv4 multicast routes (must be a power
+ * of 2).
+ */
+#if !defined IP4_MROUTE_CACHE_SIZE || defined __DOXYGEN__
+#define IP4_MROUTE_CACHE_SIZE           16
+#endif
 /**
  * @}
  */
@@ -1131,6 +1290,27 @@
 #undef LWIP_IGMP
 #define LWIP_IGMP                       0
 #endif
+
+/**
+ * IGMP_GROUP_HASH_SIZE: Size of a hash table (a power of 2) used to look up
+ * the groups joined on a netif, e.g. for every multicast packet received.
+ * With 0, the per-netif list of groups is searched instead, which is fine
+ * for a few groups.
+ */
+#if !defined IGMP_GROUP_HASH_SIZE || defined __DOXYGEN__
+#define IGMP_GROUP_HASH_SIZE            0
+#endif
+
+/**
+ * LWIP_IGMP_SOURCE_FILTER==1: Allow joining a group for specific sources
+ * only (source-specific multicast, RFC 4607) with
+ * igmp_joingroup_source_netif(). Packets to the group from other sources are
+ * dropped unless the group is also joined for any source. Reports are sent
+ * as IGMPv2 (without the sources), so the filter is applied by this host.
+ */
+#if !defined LWIP_IGMP_SOURCE_FILTER || defined __DOXYGEN__
+#define LWIP_IGMP_SOURCE_FILTER         0
+#endif
 /**
  * @}
  */
@@ -1548,6 +1728,102 @@
 #define LWIP_TCP_PCB_NUM_EXT_ARGS       0
 #endif
 
+/**
+ * LWIP_TCP_INFO==1: Keep per-connection statistics counters (retransmissions,
+ * duplicate ACKs, zero window events) in every tcp pcb and enable
+ * tcp_get_info(), tcp_pcb_foreach() and the TCP_INFO socket option.
+ */
+#if !defined LWIP_TCP_INFO || defined __DOXYGEN__
+#define LWIP_TCP_INFO                   0
+#endif
+
+/**
+ * LWIP_TCP_FASTOPEN==1: Enable TCP Fast Open (RFC 7413): listening pcbs can
+ * hand out cookies and accept data in SYN segments, active opens using
+ * tcp_connect_flags() with TCP_CONNECT_FLAG_FASTOPEN send their first data
+ * segment with the SYN once a cookie for the remote host is known.
+ */
+#if !defined LWIP_TCP_FASTOPEN || defined __DOXYGEN__
+#define LWIP_TCP_FASTOPEN               0
+#endif
+
+/**
+ * TCP_FASTOPEN_CACHE_SIZE: Number of TCP Fast Open cookies of remote hosts
+ * cached for active opens (oldest entry is replaced when full).
+ */
+#if !defined TCP_FASTOPEN_CACHE_SIZE || defined __DOXYGEN__
+#define TCP_FASTOPEN_CACHE_SIZE         4
+#endif
+
+/**
+ * LWIP_TCP_SYNCOOKIES==1: Answer SYN segments with SYN cookies once the
+ * SYN queue of a listening pcb is full: the <SYN,ACK> is sent without
+ * allocating a pcb, MSS, window scale and SACK_PERM of the SYN are encoded
+ * in its sequence number and the pcb is created when a valid ACK arrives.
+ * With LWIP_TCP_TIMESTAMPS, the cookie also records whether the SYN carried
+ * the timestamp option.
+ * Needs LWIP_CALLBACK_API or TCP_LISTEN_BACKLOG.
+ */
+#if !defined LWIP_TCP_SYNCOOKIES || defined __DOXYGEN__
+#define LWIP_TCP_SYNCOOKIES             0
+#endif
+
+/**
+ * TCP_SYN_QUEUE_LEN: Maximum number of connections per listening pcb in
+ * SYN_RCVD state (half-open) that have a pcb allocated. Further SYNs are
+ * answered with SYN cookies (0: always use SYN cookies).
+ */
+#if !defined TCP_SYN_QUEUE_LEN || defined __DOXYGEN__
+#define TCP_SYN_QUEUE_LEN               4
+#endif
+
+/**
+ * TCP_PLPMTUD==1: Packetization layer path MTU discovery for TCP (RFC 4821).
+ * Connections that keep losing full-sized segments (a PMTU black hole that
+ * drops them without ICMP feedback) fall back to TCP_PLPMTUD_BASE_MSS, and
+ * connections running below their initial MSS probe for a larger one by
+ * sending larger segments, searching between the largest size that got
+ * through and the smallest one that did not.
+ */
+#if !defined TCP_PLPMTUD || defined __DOXYGEN__
+#define TCP_PLPMTUD                     0
+#endif
+
+/**
+ * TCP_PLPMTUD_BASE_MSS: MSS used after a black hole has been detected
+ * (the lower end of the search). Connections not using a larger MSS are
+ * never treated as running into a black hole. The default corresponds to the
+ * 576 byte datagrams every IPv4 host must be able to receive.
+ */
+#if !defined TCP_PLPMTUD_BASE_MSS || defined __DOXYGEN__
+#define TCP_PLPMTUD_BASE_MSS            536
+#endif
+
+/**
+ * TCP_PLPMTUD_BLACKHOLE_RTX: Number of retransmission timeouts in a row
+ * after which a connection sending full-sized segments falls back to
+ * TCP_PLPMTUD_BASE_MSS.
+ */
+#if !defined TCP_PLPMTUD_BLACKHOLE_RTX || defined __DOXYGEN__
+#define TCP_PLPMTUD_BLACKHOLE_RTX       2
+#endif
+
+/**
+ * TCP_PLPMTUD_INTERVAL: Seconds after which a connection running below its
+ * initial MSS starts a new search for a larger MSS.
+ */
+#if !defined TCP_PLPMTUD_INTERVAL || defined __DOXYGEN__
+#define TCP_PLPMTUD_INTERVAL            600
+#endif
+
+/**
+ * TCP_PLPMTUD_SEARCH_DONE: The search ends when the largest MSS known to get
+ * through and the smallest MSS known to get lost differ by less than this.
+ */
+#if !defined TCP_PLPMTUD_SEARCH_DONE || defined __DOXYGEN__
+#define TCP_PLPMTUD_SEARCH_DONE         32
+#endif
+
 /** LWIP_ALTCP==1: enable the altcp API.
  * altcp is an abstraction layer that prevents applications linking against the
  * tcp.h functions but provides the same functionality. It is used to e.g. add
@@ -1747,6 +2023,20 @@
 #define LWIP_NETIF_TX_SINGLE_PBUF       0
 #endif /* LWIP_NETIF_TX_SINGLE_PBUF */
 
+/**
+ * LWIP_NETIF_FRAG_OFFLOAD==1: Support netifs that fragment IP packets
+ * themselves (in the driver or in hardware). For a netif that set
+ * NETIF_FRAG_OFFLOAD_IP4/NETIF_FRAG_OFFLOAD_IP6 via NETIF_SET_FRAG_OFFLOAD(),
+ * ip4_frag()/ip6_frag() pass packets exceeding the MTU on as a whole with
+ * p->frag_size set instead of creating a pbuf chain per fragment.
+ * The driver gets the layout of the fragments from ip_frag_offload_desc()
+ * and their headers from ip_frag_offload_hdr().
+ * This adds a u16_t to struct pbuf.
+ */
+#if !defined LWIP_NETIF_FRAG_OFFLOAD || defined __DOXYGEN__
+#define LWIP_NETIF_FRAG_OFFLOAD         0
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
+
 /**
  * LWIP_NUM_NETIF_CLIENT_DATA: Number of clients that may store
  * data in client_data member array of struct netif (max. 256).
@@ -2524,6 +2814,26 @@
 #define LWIP_IPV6_FORWARD               0
 #endif
 
+/**
+ * LWIP_IPV6_FIB==1: Enable the IPv6 routing table (see @ref ip6_fib): static
+ * routes with gateways and metrics plus the on-link prefixes and default
+ * routers learned from router advertisements, looked up by longest prefix
+ * match in ip6_route() and when resolving the next hop in nd6.
+ */
+#if !defined LWIP_IPV6_FIB || defined __DOXYGEN__
+#define LWIP_IPV6_FIB                   0
+#endif
+
+/**
+ * MEMP_NUM_IP6_FIB_ENTRY: the number of IPv6 routing table entries
+ * (requires LWIP_IPV6_FIB). Every route needs one entry, plus up to one
+ * entry where the trie branches. Routes learned from router advertisements
+ * (up to LWIP_ND6_NUM_PREFIXES + LWIP_ND6_NUM_ROUTERS) are included.
+ */
+#if !defined MEMP_NUM_IP6_FIB_ENTRY || defined __DOXYGEN__
+#define MEMP_NUM_IP6_FIB_ENTRY          16
+#endif
+
 /**
  * LWIP_IPV6_FRAG==1: Fragment outgoing IPv6 packets that are too big.
  */
@@ -2629,6 +2939,34 @@
 #if !defined MEMP_NUM_MLD6_GROUP || defined __DOXYGEN__
 #define MEMP_NUM_MLD6_GROUP             4
 #endif
+
+/**
+ * MLD6_GROUP_HASH_SIZE: Size of a hash table (a power of 2) used to look up
+ * the groups joined on a netif, e.g. for every multicast packet received.
+ * With 0, the per-netif list of groups is searched instead.
+ */
+#if !defined MLD6_GROUP_HASH_SIZE || defined __DOXYGEN__
+#define MLD6_GROUP_HASH_SIZE            0
+#endif
+
+/**
+ * LWIP_MLD6_SOURCE_FILTER==1: Allow joining a group for specific sources
+ * only (source-specific multicast, RFC 4607) with
+ * mld6_joingroup_source_netif(). Packets to the group from other sources are
+ * dropped unless the group is also joined for any source. Reports are sent
+ * as MLDv1 (without the sources), so the filter is applied by this host.
+ */
+#if !defined LWIP_MLD6_SOURCE_FILTER || defined __DOXYGEN__
+#define LWIP_MLD6_SOURCE_FILTER         0
+#endif
+
+/**
+ * MEMP_NUM_MLD6_SOURCE: Max number of sources that can be joined with
+ * mld6_joingroup_source_netif() at the same time.
+ */
+#if !defined MEMP_NUM_MLD6_SOURCE || defined __DOXYGEN__
+#define MEMP_NUM_MLD6_SOURCE            4
+#endif
 /**
  * @}
  */
@@ -2654,7 +2992,8 @@
 #endif
 
 /**
- * LWIP_ND6_NUM_NEIGHBORS: Number of entries in IPv6 neighbor cache
+ * LWIP_ND6_NUM_NEIGHBORS: Number of entries in IPv6 neighbor cache (at most
+ * 32767)
  */
 #if !defined LWIP_ND6_NUM_NEIGHBORS || defined __DOXYGEN__
 #define LWIP_ND6_NUM_NEIGHBORS          10
@@ -2667,6 +3006,26 @@
 #define LWIP_ND6_NUM_DESTINATIONS       10
 #endif
 
+/**
+ * LWIP_ND6_CACHE_HASH==1: Index the neighbor and destination caches by
+ * address in hash tables, recycle destination cache entries in LRU order
+ * and drive neighbor reachability timers from a timer wheel instead of
+ * visiting every entry in nd6_tmr(). Use this with large
+ * LWIP_ND6_NUM_NEIGHBORS/LWIP_ND6_NUM_DESTINATIONS.
+ */
+#if !defined LWIP_ND6_CACHE_HASH || defined __DOXYGEN__
+#define LWIP_ND6_CACHE_HASH             0
+#endif
+
+/**
+ * LWIP_ND6_CACHE_HASH_SIZE: Number of hash buckets of the neighbor and of
+ * the destination cache if LWIP_ND6_CACHE_HASH is enabled (must be a power
+ * of 2).
+ */
+#if !defined LWIP_ND6_CACHE_HASH_SIZE || defined __DOXYGEN__
+#define LWIP_ND6_CACHE_HASH_SIZE        16
+#endif
+
 /**
  * LWIP_ND6_NUM_PREFIXES: number of entries in IPv6 on-link prefixes cache
  */
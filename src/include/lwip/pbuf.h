@@ -220,6 +220,12 @@ struct pbuf {
   /** For incoming packets, this contains the input netif's index */
   u8_t if_idx;
 
+#if LWIP_NETIF_FRAG_OFFLOAD
+  /** For outgoing IP packets exceeding the MTU of a netif doing fragmentation
+   * itself: data bytes per fragment (0: don't fragment) */
+  u16_t frag_size;
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
+
   /** In case the user needs to store data custom data on a pbuf */
   LWIP_PBUF_CUSTOM_DATA
 };
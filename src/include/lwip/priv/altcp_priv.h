@@ -90,6 +90,10 @@ typedef void  (*altcp_keepalive_disable_fn)(struct altcp_pcb *conn);
 typedef void  (*altcp_keepalive_enable_fn)(struct altcp_pcb *conn, u32_t idle, u32_t intvl, u32_t count);
 #endif
 
+#if LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP
+typedef err_t (*altcp_write_chksum_fn)(struct altcp_pcb *conn, const void *dataptr, u16_t len, u8_t apiflags, u16_t chksum);
+#endif
+
 #ifdef LWIP_DEBUG
 typedef enum tcp_state (*altcp_dbg_get_tcp_state_fn)(struct altcp_pcb *conn);
 #endif
@@ -122,6 +126,11 @@ struct altcp_functions {
 #endif
 #ifdef LWIP_DEBUG
   altcp_dbg_get_tcp_state_fn  dbg_get_tcp_state;
+#endif
+  /* new members are appended here so that positional initializers of
+     existing layers stay valid (missing members are NULL) */
+#if LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP
+  altcp_write_chksum_fn       write_chksum;
 #endif
 };
 
@@ -146,6 +155,9 @@ u16_t altcp_default_get_port(struct altcp_pcb *conn, int local);
 void  altcp_default_keepalive_disable(struct altcp_pcb *conn);
 void  altcp_default_keepalive_enable(struct altcp_pcb *conn, u32_t idle, u32_t intvl, u32_t count);
 #endif
+#if LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP
+err_t altcp_default_write_chksum(struct altcp_pcb *conn, const void *dataptr, u16_t len, u8_t apiflags, u16_t chksum);
+#endif
 #ifdef LWIP_DEBUG
 enum tcp_state altcp_default_dbg_get_tcp_state(struct altcp_pcb *conn);
 #endif
@@ -0,0 +1,65 @@
+/**
+ * @file
+ * Hash table helpers (internal, do not use in application code)
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_HASH_PRIV_H
+#define LWIP_HDR_HASH_PRIV_H
+
+#include "lwip/arch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Bucket of a 32-bit hash value in a table of 'size' (power of 2) buckets.
+ * All bytes are folded into the low bits, so the result does not depend on
+ * the byte order the value was built in and tables keyed on addresses in
+ * network order work on big and little endian targets alike.
+ * 'h' is evaluated more than once.
+ */
+#define LWIP_HASH_BUCKET(h, size) \
+  ((u16_t)(((h) ^ ((h) >> 8) ^ ((h) >> 16) ^ ((h) >> 24)) & ((size) - 1)))
+
+/** Links between entries of a static table (hash chains, free and age lists)
+ * are stored as index + 1, so that a zero-initialized table is a valid empty
+ * state without an init function.
+ */
+#define LWIP_HASH_LINK_NONE             0
+#define LWIP_HASH_LINK(type, idx)       ((type)((idx) + 1))
+#define LWIP_HASH_LINK_IDX(link)        ((s16_t)((link) - 1))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HDR_HASH_PRIV_H */
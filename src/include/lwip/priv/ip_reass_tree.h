@@ -0,0 +1,91 @@
+/**
+ * @file
+ * Fragment tree shared by IPv4 and IPv6 reassembly (do not use in application code)
+ */
+
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+#ifndef LWIP_HDR_IP_REASS_TREE_H
+#define LWIP_HDR_IP_REASS_TREE_H
+
+#include "lwip/opt.h"
+
+#if (LWIP_IPV4 && IP_REASSEMBLY) || (LWIP_IPV6 && LWIP_IPV6_REASS)
+
+#include "lwip/pbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if (IP_REASS_HASH_SIZE < 1) || ((IP_REASS_HASH_SIZE & (IP_REASS_HASH_SIZE - 1)) != 0)
+#error "IP_REASS_HASH_SIZE must be a power of 2"
+#endif
+
+/** Fold a 32 bit hash of a source address into a bucket index */
+#define IP_REASS_HASH(h) ((u16_t)(((h) ^ ((h) >> 16) ^ ((h) >> 8)) & (IP_REASS_HASH_SIZE - 1)))
+
+/** The fragments of a datagram are kept in a splay tree sorted by offset.
+ * This node replaces the (already copied) header in front of the fragment
+ * data in memory, so it has the same packing requirements as the IP header.
+ */
+#ifdef PACK_STRUCT_USE_INCLUDES
+#  include "arch/bpstruct.h"
+#endif
+PACK_STRUCT_BEGIN
+struct ip_reass_node {
+  PACK_STRUCT_FIELD(struct pbuf *left);
+  PACK_STRUCT_FIELD(struct pbuf *right);
+  PACK_STRUCT_FIELD(u16_t start);
+  PACK_STRUCT_FIELD(u16_t end);
+} PACK_STRUCT_STRUCT;
+PACK_STRUCT_END
+#ifdef PACK_STRUCT_USE_INCLUDES
+#  include "arch/epstruct.h"
+#endif
+
+/** Get the tree node of a queued fragment */
+#define IP_REASS_NODE(p) ((struct ip_reass_node *)(p)->payload)
+
+u8_t ip_reass_tree_check(struct pbuf **root, u16_t start, u16_t end, u8_t check_overlap);
+void ip_reass_tree_link(struct pbuf **root, struct pbuf *p, u16_t start, u16_t end);
+struct pbuf *ip_reass_tree_first(struct pbuf **root);
+u16_t ip_reass_tree_last_end(struct pbuf *root);
+struct pbuf *ip_reass_tree_to_list(struct pbuf **root);
+u8_t ip_reass_tree_complete(struct pbuf **root, u16_t datagram_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* (LWIP_IPV4 && IP_REASSEMBLY) || (LWIP_IPV6 && LWIP_IPV6_REASS) */
+
+#endif /* LWIP_HDR_IP_REASS_TREE_H */
@@ -59,10 +59,17 @@ LWIP_MEMPOOL(ALTCP_PCB,      MEMP_NUM_ALTCP_PCB,       sizeof(struct altcp_pcb),
 #if LWIP_IPV4 && IP_REASSEMBLY
 LWIP_MEMPOOL(REASSDATA,      MEMP_NUM_REASSDATA,       sizeof(struct ip_reassdata),   "REASSDATA")
 #endif /* LWIP_IPV4 && IP_REASSEMBLY */
+#if LWIP_IPV4 && LWIP_IPV4_FIB
+LWIP_MEMPOOL(IP4_FIB_NODE,   MEMP_NUM_IP4_FIB_NODE,    sizeof(struct ip4_fib_entry),  "IP4_FIB_NODE")
+#endif /* LWIP_IPV4 && LWIP_IPV4_FIB */
 #if (IP_FRAG && !LWIP_NETIF_TX_SINGLE_PBUF) || (LWIP_IPV6 && LWIP_IPV6_FRAG)
 LWIP_MEMPOOL(FRAG_PBUF,      MEMP_NUM_FRAG_PBUF,       sizeof(struct pbuf_custom_ref),"FRAG_PBUF")
 #endif /* IP_FRAG && !LWIP_NETIF_TX_SINGLE_PBUF || (LWIP_IPV6 && LWIP_IPV6_FRAG) */
 
+#if LWIP_IPV6 && LWIP_IPV6_FIB
+LWIP_MEMPOOL(IP6_FIB_ENTRY,  MEMP_NUM_IP6_FIB_ENTRY,   sizeof(struct ip6_fib_entry),  "IP6_FIB_ENTRY")
+#endif /* LWIP_IPV6 && LWIP_IPV6_FIB */
+
 #if LWIP_NETCONN || LWIP_SOCKET
 LWIP_MEMPOOL(NETBUF,         MEMP_NUM_NETBUF,          sizeof(struct netbuf),         "NETBUF")
 LWIP_MEMPOOL(NETCONN,        MEMP_NUM_NETCONN,         sizeof(struct netconn),        "NETCONN")
@@ -97,6 +104,9 @@ LWIP_MEMPOOL(ARP_QUEUE,      MEMP_NUM_ARP_QUEUE,       sizeof(struct etharp_q_en
 #if LWIP_IGMP
 LWIP_MEMPOOL(IGMP_GROUP,     MEMP_NUM_IGMP_GROUP,      sizeof(struct igmp_group),     "IGMP_GROUP")
 #endif /* LWIP_IGMP */
+#if LWIP_IGMP && LWIP_IGMP_SOURCE_FILTER
+LWIP_MEMPOOL(IGMP_SOURCE,    MEMP_NUM_IGMP_SOURCE,     sizeof(struct igmp_source),    "IGMP_SOURCE")
+#endif /* LWIP_IGMP && LWIP_IGMP_SOURCE_FILTER */
 
 #if LWIP_TIMERS && !LWIP_TIMERS_CUSTOM
 LWIP_MEMPOOL(SYS_TIMEOUT,    MEMP_NUM_SYS_TIMEOUT,     sizeof(struct sys_timeo),      "SYS_TIMEOUT")
@@ -120,6 +130,9 @@ LWIP_MEMPOOL(IP6_REASSDATA,  MEMP_NUM_REASSDATA,       sizeof(struct ip6_reassda
 #if LWIP_IPV6 && LWIP_IPV6_MLD
 LWIP_MEMPOOL(MLD6_GROUP,     MEMP_NUM_MLD6_GROUP,      sizeof(struct mld_group),      "MLD6_GROUP")
 #endif /* LWIP_IPV6 && LWIP_IPV6_MLD */
+#if LWIP_IPV6 && LWIP_IPV6_MLD && LWIP_MLD6_SOURCE_FILTER
+LWIP_MEMPOOL(MLD6_SOURCE,    MEMP_NUM_MLD6_SOURCE,     sizeof(struct mld_source),     "MLD6_SOURCE")
+#endif /* LWIP_IPV6 && LWIP_IPV6_MLD && LWIP_MLD6_SOURCE_FILTER */
 
 
 /*
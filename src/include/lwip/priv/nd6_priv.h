@@ -82,6 +82,16 @@ struct nd6_neighbor_cache_entry {
 #endif /* LWIP_ND6_QUEUEING */
   u8_t state;
   u8_t isrouter;
+#if LWIP_ND6_CACHE_HASH
+  /** next entry in the same hash bucket (or on the free list) */
+  u16_t hash_next;
+  /** neighbors on the same timer list */
+  u16_t timer_prev, timer_next;
+  /** timer wheel slot or other timer list the entry is on */
+  u16_t timer_list;
+  /** nd6_tmr() tick at which the reachability timer expires */
+  u32_t timer_expire;
+#endif /* LWIP_ND6_CACHE_HASH */
   union {
     u32_t reachable_time; /* in seconds */
     u32_t delay_time;     /* ticks (ND6_TMR_INTERVAL) */
@@ -94,7 +104,13 @@ struct nd6_destination_cache_entry {
   ip6_addr_t destination_addr;
   ip6_addr_t next_hop_addr;
   u16_t pmtu;
-  u8_t cached_neighbor_idx;
+  u16_t cached_neighbor_idx;
+#if LWIP_ND6_CACHE_HASH
+  /** next entry in the same hash bucket (or on the free list) */
+  u16_t hash_next;
+  /** neighbors on the LRU list */
+  u16_t lru_prev, lru_next;
+#endif /* LWIP_ND6_CACHE_HASH */
   u32_t age;
 };
 
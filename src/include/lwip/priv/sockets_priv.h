@@ -44,6 +44,7 @@
 #include "lwip/err.h"
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
+#include "lwip/tcp.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -97,7 +98,11 @@ struct lwip_sock {
 
 #if !LWIP_TCPIP_CORE_LOCKING
 /** Maximum optlen used by setsockopt/getsockopt */
+#if LWIP_TCP && LWIP_TCP_INFO
+#define LWIP_SETGETSOCKOPT_MAXOPTLEN LWIP_MAX(LWIP_MAX(16, sizeof(struct ifreq)), sizeof(struct tcp_pcb_info))
+#else
 #define LWIP_SETGETSOCKOPT_MAXOPTLEN LWIP_MAX(16, sizeof(struct ifreq))
+#endif
 
 /** This struct is used to pass data to the set/getsockopt_impl
  * functions running in tcpip_thread context (only a void* is allowed) */
@@ -267,6 +267,8 @@ struct tcp_seg {
                                                checksummed into 'chksum' */
 #define TF_SEG_OPTS_WND_SCALE   (u8_t)0x08U /* Include WND SCALE option (only used in SYN segments) */
 #define TF_SEG_OPTS_SACK_PERM   (u8_t)0x10U /* Include SACK Permitted option (only used in SYN segments) */
+#define TF_SEG_OPTS_FASTOPEN    (u8_t)0x20U /* Include Fast Open cookie option (only used in SYN segments) */
+#define TF_SEG_OPTS_FASTOPEN_REQ (u8_t)0x40U /* Include Fast Open cookie request (only used in SYN segments) */
   struct tcp_hdr *tcphdr;  /* the TCP header */
 };
 
@@ -276,6 +278,7 @@ struct tcp_seg {
 #define LWIP_TCP_OPT_WS         3
 #define LWIP_TCP_OPT_SACK_PERM  4
 #define LWIP_TCP_OPT_TS         8
+#define LWIP_TCP_OPT_FASTOPEN   34
 
 #define LWIP_TCP_OPT_LEN_MSS    4
 #if LWIP_TCP_TIMESTAMPS
@@ -298,11 +301,22 @@ struct tcp_seg {
 #define LWIP_TCP_OPT_LEN_SACK_PERM_OUT 0
 #endif
 
+#if LWIP_TCP_FASTOPEN
+#define LWIP_TCP_OPT_LEN_FASTOPEN_MIN     4 /* option header + shortest valid cookie */
+#define LWIP_TCP_OPT_LEN_FASTOPEN_OUT     ((2 + TCP_FASTOPEN_COOKIE_LEN + 3) & ~3) /* aligned for output (includes NOP padding) */
+#define LWIP_TCP_OPT_LEN_FASTOPEN_REQ_OUT 4 /* aligned for output (includes NOP padding) */
+#else
+#define LWIP_TCP_OPT_LEN_FASTOPEN_OUT     0
+#define LWIP_TCP_OPT_LEN_FASTOPEN_REQ_OUT 0
+#endif
+
 #define LWIP_TCP_OPT_LENGTH(flags) \
   ((flags) & TF_SEG_OPTS_MSS       ? LWIP_TCP_OPT_LEN_MSS           : 0) + \
   ((flags) & TF_SEG_OPTS_TS        ? LWIP_TCP_OPT_LEN_TS_OUT        : 0) + \
   ((flags) & TF_SEG_OPTS_WND_SCALE ? LWIP_TCP_OPT_LEN_WS_OUT        : 0) + \
-  ((flags) & TF_SEG_OPTS_SACK_PERM ? LWIP_TCP_OPT_LEN_SACK_PERM_OUT : 0)
+  ((flags) & TF_SEG_OPTS_SACK_PERM ? LWIP_TCP_OPT_LEN_SACK_PERM_OUT : 0) + \
+  ((flags) & TF_SEG_OPTS_FASTOPEN  ? LWIP_TCP_OPT_LEN_FASTOPEN_OUT  : 0) + \
+  ((flags) & TF_SEG_OPTS_FASTOPEN_REQ ? LWIP_TCP_OPT_LEN_FASTOPEN_REQ_OUT : 0)
 
 /** This returns a TCP header option for MSS in an u32_t */
 #define TCP_BUILD_MSS_OPTION(mss) lwip_htonl(0x02040000 | ((mss) & 0xFFFF))
@@ -469,6 +483,7 @@ void tcp_rst_netif(struct netif *netif, u32_t seqno, u32_t ackno,
                    u16_t local_port, u16_t remote_port);
 
 u32_t tcp_next_iss(struct tcp_pcb *pcb);
+struct netif *tcp_route(const struct tcp_pcb *pcb, const ip_addr_t *src, const ip_addr_t *dst);
 
 err_t tcp_keepalive(struct tcp_pcb *pcb);
 err_t tcp_split_unsent_seg(struct tcp_pcb *pcb, u16_t split);
@@ -480,7 +495,27 @@ u16_t tcp_eff_send_mss_netif(u16_t sendmss, struct netif *outif,
                              const ip_addr_t *dest);
 #define tcp_eff_send_mss(sendmss, src, dest) \
     tcp_eff_send_mss_netif(sendmss, ip_route(src, dest), dest)
+struct tcp_pcb *tcp_pmtu_lookup(const ip_addr_t *local_ip, const ip_addr_t *remote_ip,
+                                u16_t local_port, u16_t remote_port, u32_t seqno);
+void tcp_pmtu_update(struct tcp_pcb *pcb);
+u8_t tcp_pmtu_check(struct tcp_pcb *pcb, struct netif *netif);
 #endif /* TCP_CALCULATE_EFF_SEND_MSS */
+void tcp_reduce_mss(struct tcp_pcb *pcb, u16_t mss);
+
+#if TCP_PLPMTUD
+/* pcb->plpmtud_state */
+#define TCP_PLPMTUD_IDLE     0 /* pcb->mss is known to get through (or not searched yet) */
+#define TCP_PLPMTUD_PROBE    1 /* pcb->mss raised to the probe size, no probe sent yet */
+#define TCP_PLPMTUD_INFLIGHT 2 /* probe sent, waiting for its ACK */
+/* TCP_PLPMTUD_INTERVAL in tcp_slowtmr() ticks */
+#define TCP_PLPMTUD_INTERVAL_TICKS ((u16_t)((TCP_PLPMTUD_INTERVAL * 1000UL) / TCP_SLOW_INTERVAL))
+#if (TCP_PLPMTUD_INTERVAL * 1000UL) / TCP_SLOW_INTERVAL > 0xffff
+#error "TCP_PLPMTUD_INTERVAL is too large"
+#endif
+void tcp_plpmtud_tmr(struct tcp_pcb *pcb);
+void tcp_plpmtud_acked(struct tcp_pcb *pcb);
+void tcp_plpmtud_rexmit(struct tcp_pcb *pcb, u8_t rto);
+#endif /* TCP_PLPMTUD */
 
 #if LWIP_CALLBACK_API
 err_t tcp_recv_null(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err);
@@ -514,6 +549,35 @@ void tcp_free_ooseq(struct tcp_pcb *pcb);
 err_t tcp_ext_arg_invoke_callbacks_passive_open(struct tcp_pcb_listen *lpcb, struct tcp_pcb *cpcb);
 #endif
 
+#if LWIP_TCP_FASTOPEN || LWIP_TCP_SYNCOOKIES
+void tcp_keyed_hash(const void *data, u16_t len, u8_t *out, u8_t outlen);
+#endif /* LWIP_TCP_FASTOPEN || LWIP_TCP_SYNCOOKIES */
+#if LWIP_TCP_SYNCOOKIES
+/** Value of the wscale argument of the SYN cookie functions if the SYN
+ * carried no window scale option */
+#define TCP_SYNCOOKIE_NO_WSCALE 0x0F
+u32_t tcp_syncookie_create(const ip_addr_t *local_ip, const ip_addr_t *remote_ip,
+                           u16_t local_port, u16_t remote_port, u32_t irs,
+                           u16_t *mss, u8_t wscale, u8_t sack, u8_t ts);
+u8_t  tcp_syncookie_check(const ip_addr_t *local_ip, const ip_addr_t *remote_ip,
+                          u16_t local_port, u16_t remote_port, u32_t irs, u32_t cookie,
+                          u16_t *mss, u8_t *wscale, u8_t *sack, u8_t *ts);
+void  tcp_syncookie_synack(struct netif *netif, u32_t iss, u32_t ackno,
+                           const ip_addr_t *local_ip, const ip_addr_t *remote_ip,
+                           u16_t local_port, u16_t remote_port, u8_t wscale, u8_t sack,
+                           u8_t ts, u32_t ts_recent);
+void  tcp_syn_queue_remove(struct tcp_pcb *pcb);
+#else /* LWIP_TCP_SYNCOOKIES */
+#define tcp_syn_queue_remove(pcb)
+#endif /* LWIP_TCP_SYNCOOKIES */
+#if LWIP_TCP_FASTOPEN
+void tcp_fastopen_cookie(const ip_addr_t *addr, u8_t *cookie);
+u8_t tcp_fastopen_cache_get(const ip_addr_t *addr, u8_t *cookie);
+void tcp_fastopen_cache_set(const ip_addr_t *addr, const u8_t *cookie, u8_t len);
+void tcp_fastopen_add_syn_data(struct tcp_pcb *pcb);
+struct tcp_seg *tcp_fastopen_syn_data_seg(struct tcp_pcb *pcb, const struct tcp_seg *syn);
+#endif /* LWIP_TCP_FASTOPEN */
+
 #ifdef __cplusplus
 }
 #endif
@@ -290,6 +290,8 @@ struct linger {
 #define TCP_KEEPIDLE   0x03    /* set pcb->keep_idle  - Same as TCP_KEEPALIVE, but use seconds for get/setsockopt */
 #define TCP_KEEPINTVL  0x04    /* set pcb->keep_intvl - Use seconds for get/setsockopt */
 #define TCP_KEEPCNT    0x05    /* set pcb->keep_cnt   - Use number of probes sent for get/setsockopt */
+#define TCP_INFO       0x06    /* get struct tcp_pcb_info (getsockopt only, needs LWIP_TCP_INFO) */
+#define TCP_FASTOPEN   0x07    /* enable TCP Fast Open for passive opens (needs LWIP_TCP_FASTOPEN) */
 #endif /* LWIP_TCP */
 
 #if LWIP_IPV6
@@ -206,6 +206,12 @@ struct tcp_pcb_ext_args {
 typedef u16_t tcpflags_t;
 #define TCP_ALLFLAGS 0xffffU
 
+#if LWIP_TCP_FASTOPEN
+/** Length of the TCP Fast Open cookies generated by lwIP. Cookies received
+ * from other servers are only used if they are not longer than this. */
+#define TCP_FASTOPEN_COOKIE_LEN 8
+#endif /* LWIP_TCP_FASTOPEN */
+
 /**
  * members common to struct tcp_pcb and struct tcp_listen_pcb
  */
@@ -235,6 +241,16 @@ struct tcp_pcb_listen {
   u8_t backlog;
   u8_t accepts_pending;
 #endif /* TCP_LISTEN_BACKLOG */
+
+#if LWIP_TCP_FASTOPEN
+  /* hand out TCP Fast Open cookies and accept data in SYN segments */
+  u8_t fastopen;
+#endif /* LWIP_TCP_FASTOPEN */
+
+#if LWIP_TCP_SYNCOOKIES
+  /* number of connections in SYN_RCVD state */
+  u16_t syn_queued;
+#endif /* LWIP_TCP_SYNCOOKIES */
 };
 
 
@@ -269,6 +285,13 @@ struct tcp_pcb {
 #define TF_RTO         0x0800U /* RTO timer has fired, in-flight data moved to unsent and being retransmitted */
 #if LWIP_TCP_SACK_OUT
 #define TF_SACK        0x1000U /* Selective ACKs enabled */
+#endif
+#if LWIP_TCP_FASTOPEN
+#define TF_FASTOPEN    0x2000U /* Use TCP Fast Open (active open or listen) */
+#define TF_FASTOPEN_ACC 0x4000U /* Accepted from a SYN carrying data (TCP Fast Open) */
+#endif
+#if LWIP_TCP_SYNCOOKIES
+#define TF_SYNQUEUED   0x8000U /* If this is set, a connection pcb is counted in the SYN queue of its listener */
 #endif
 
   /* the rest of the fields are in host byte order
@@ -386,8 +409,85 @@ struct tcp_pcb {
   u8_t snd_scale;
   u8_t rcv_scale;
 #endif
+
+#if LWIP_TCP_INFO
+  /* Statistics counters, see tcp_get_info() */
+  u32_t info_retrans;   /* number of retransmissions (RTO or fast retransmit) */
+  u32_t info_dupacks;   /* number of duplicate ACKs received */
+  u32_t info_zero_wnd;  /* number of times the remote window dropped to zero */
+#endif /* LWIP_TCP_INFO */
+
+#if TCP_PLPMTUD
+  /* Packetization layer path MTU discovery, see tcp_plpmtud_tmr() */
+  u16_t plpmtud_max;   /* MSS before it was first reduced (0: not reduced yet) */
+  u16_t plpmtud_high;  /* largest MSS not known to be too big */
+  u16_t plpmtud_low;   /* MSS known to get through while probing */
+  u16_t plpmtud_tmr;   /* tcp_slowtmr() ticks until the next probe */
+  u32_t plpmtud_probe_end; /* sequence number following the probe */
+  u8_t plpmtud_state;  /* TCP_PLPMTUD_IDLE, TCP_PLPMTUD_PROBE, TCP_PLPMTUD_INFLIGHT */
+#endif /* TCP_PLPMTUD */
+
+#if LWIP_TCP_FASTOPEN
+  /* TCP Fast Open cookie sent in our SYN (active open) or SYN|ACK (passive open) */
+  u8_t tfo_cookie_len;
+  u8_t tfo_cookie[TCP_FASTOPEN_COOKIE_LEN];
+#endif /* LWIP_TCP_FASTOPEN */
 };
 
+#if LWIP_TCP_INFO
+/** Per-connection information returned by @ref tcp_get_info and
+ * the TCP_INFO socket option.
+ * All times are in milliseconds, all window and queue sizes in bytes
+ * unless noted otherwise.
+ */
+struct tcp_pcb_info {
+  /** TCP state (enum tcp_state) */
+  u8_t  state;
+  /** number of consecutive retransmissions of the oldest unacked segment */
+  u8_t  nrtx;
+  /** current duplicate ACK counter */
+  u8_t  dupacks;
+  /** maximum segment size */
+  u16_t mss;
+  /** smoothed round trip time */
+  u32_t srtt;
+  /** round trip time variation */
+  u32_t rttvar;
+  /** current retransmission timeout */
+  u32_t rto;
+  /** congestion window */
+  u32_t cwnd;
+  /** slow start threshold */
+  u32_t ssthresh;
+  /** send window announced by the remote host */
+  u32_t snd_wnd;
+  /** receive window currently available */
+  u32_t rcv_wnd;
+  /** sent but not yet acknowledged bytes */
+  u32_t bytes_in_flight;
+  /** bytes written by the application and not yet acknowledged */
+  u32_t snd_queue;
+  /** number of pbufs in the send queue */
+  u16_t snd_queuelen;
+  /** bytes received but not yet taken by the application (@ref tcp_recved) */
+  u32_t rcv_queue;
+  /** total number of retransmissions */
+  u32_t total_retrans;
+  /** total number of duplicate ACKs received */
+  u32_t total_dupacks;
+  /** number of times the remote host announced a zero window */
+  u32_t zero_wnd_events;
+};
+
+/** Function prototype for @ref tcp_pcb_foreach callbacks.
+ * The pcb must not be closed or aborted from within this callback.
+ *
+ * @param pcb the current pcb
+ * @param arg argument passed to @ref tcp_pcb_foreach
+ */
+typedef void (*tcp_pcb_iter_fn)(struct tcp_pcb *pcb, void *arg);
+#endif /* LWIP_TCP_INFO */
+
 #if LWIP_EVENT_API
 
 enum lwip_event {
@@ -460,6 +560,11 @@ err_t            tcp_bind    (struct tcp_pcb *pcb, const ip_addr_t *ipaddr,
 void             tcp_bind_netif(struct tcp_pcb *pcb, const struct netif *netif);
 err_t            tcp_connect (struct tcp_pcb *pcb, const ip_addr_t *ipaddr,
                               u16_t port, tcp_connected_fn connected);
+err_t            tcp_connect_flags(struct tcp_pcb *pcb, const ip_addr_t *ipaddr,
+                              u16_t port, tcp_connected_fn connected, u8_t flags);
+/** @ingroup tcp_raw
+ * Flag for @ref tcp_connect_flags: use TCP Fast Open (needs LWIP_TCP_FASTOPEN) */
+#define TCP_CONNECT_FLAG_FASTOPEN 0x01
 
 struct tcp_pcb * tcp_listen_with_backlog_and_err(struct tcp_pcb *pcb, u8_t backlog, err_t *err);
 struct tcp_pcb * tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog);
@@ -472,6 +577,10 @@ err_t            tcp_shutdown(struct tcp_pcb *pcb, int shut_rx, int shut_tx);
 
 err_t            tcp_write   (struct tcp_pcb *pcb, const void *dataptr, u16_t len,
                               u8_t apiflags);
+#if LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP
+err_t            tcp_write_chksum(struct tcp_pcb *pcb, const void *dataptr, u16_t len,
+                                  u8_t apiflags, u16_t chksum);
+#endif /* LWIP_CHECKSUM_ON_COPY && CHECKSUM_GEN_TCP */
 
 void             tcp_setprio (struct tcp_pcb *pcb, u8_t prio);
 
@@ -481,6 +590,19 @@ err_t            tcp_tcp_get_tcp_addrinfo(struct tcp_pcb *pcb, int local, ip_add
 
 #define tcp_dbg_get_tcp_state(pcb) ((pcb)->state)
 
+#if LWIP_TCP_INFO
+err_t            tcp_get_info(const struct tcp_pcb *pcb, struct tcp_pcb_info *info);
+void             tcp_pcb_foreach(tcp_pcb_iter_fn fn, void *arg);
+#endif /* LWIP_TCP_INFO */
+
+#if LWIP_TCP_FASTOPEN
+void             tcp_fastopen (struct tcp_pcb *pcb, u8_t enable);
+u8_t             tcp_fastopen_enabled(const struct tcp_pcb *pcb);
+#endif /* LWIP_TCP_FASTOPEN */
+#if LWIP_TCP_FASTOPEN || LWIP_TCP_SYNCOOKIES
+void             tcp_set_secret_key(const u8_t *key);
+#endif /* LWIP_TCP_FASTOPEN || LWIP_TCP_SYNCOOKIES */
+
 /* for compatibility with older implementation */
 #define tcp_new_ip6() tcp_new_ip_type(IPADDR_TYPE_V6)
 
@@ -99,6 +99,7 @@
 #include "lwip/ip6.h" /* for ip6_input() */
 #endif /* PPP_IPV6_SUPPORT */
 #include "lwip/dns.h"
+#include "lwip/ip_fwcache.h"
 
 #include "netif/ppp/ppp_impl.h"
 #include "netif/ppp/pppos.h"
@@ -1332,6 +1333,8 @@ void ppp_netif_set_mtu(ppp_pcb *pcb, int mtu) {
 #if PPP_IPV6_SUPPORT && LWIP_ND6_ALLOW_RA_UPDATES
   pcb->netif->mtu6 = mtu;
 #endif /* PPP_IPV6_SUPPORT && LWIP_ND6_ALLOW_RA_UPDATES */
+  /* the forwarding flow cache keeps the MTU */
+  IP_FWCACHE_INVALIDATE();
   PPPDEBUG(LOG_INFO, ("ppp_netif_set_mtu[%d]: mtu=%d\n", pcb->netif->num, mtu));
 }
 
@@ -0,0 +1,784 @@
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+
+/* clock_gettime() */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/ip.h"
+#include "lwip/ip4_frag.h"
+#include "lwip/ip4_fib.h"
+#include "lwip/pbuf.h"
+#include "lwip/memp.h"
+#include "lwip/mem.h"
+#include "lwip/udp.h"
+#include "lwip/tcp.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/timeouts.h"
+#include "lwip/sys.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * lwIP data path benchmarks.
+ *
+ * lwIP keeps its state in globals, so both endpoints of every benchmark live
+ * in the same stack: two netifs ("A" and "B") are connected back-to-back by an
+ * in-memory wire. Frames sent on one netif are copied into PBUF_POOL pbufs
+ * (like a real driver would do on receive) and queued; the main loop drains the
+ * queue into the peer's input function. Packets are routed by source address
+ * through LWIP_HOOK_IP4_ROUTE_SRC, so each endpoint always transmits through
+ * its own side of the wire. A third netif ("C") only counts and drops the
+ * packets sent to it; it is the output of the forwarding benchmark.
+ *
+ * Results are written to stdout as one JSON object per line.
+ */
+
+#define BENCH_WIRE_QUEUE_LEN  2048
+#define BENCH_TCP_PORT        5001
+#define BENCH_CONN_PORT       5002
+#define BENCH_UDP_PORT        5003
+#define BENCH_RR_SIZE         64
+#define BENCH_UDP_SIZE        64
+#define BENCH_UDP_BATCH       64
+#define BENCH_ALLOC_BATCH     32
+#define BENCH_FWD_ROUTES      64
+#define BENCH_FWD_FLOWS       32
+#define BENCH_FWD_SIZE        64
+
+struct bench_wire_entry {
+  struct pbuf *p;
+  struct netif *to;
+};
+
+static struct netif netif_a, netif_b, netif_c;
+static struct bench_wire_entry wire_queue[BENCH_WIRE_QUEUE_LEN];
+static unsigned wire_head, wire_count;
+static unsigned long wire_drops;
+static int quick;
+
+static u8_t bench_buf[64 * 1024];
+
+/* ---- platform ---- */
+
+static double
+bench_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+u32_t
+sys_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+unsigned int
+lwip_port_rand(void)
+{
+  return (unsigned int)rand();
+}
+
+static void
+bench_report(const char *name, const char *metric, double value, const char *unit,
+             unsigned long iterations, double seconds)
+{
+  printf("{\"benchmark\":\"%s\",\"metric\":\"%s\",\"value\":%.3f,\"unit\":\"%s\","
+         "\"iterations\":%lu,\"seconds\":%.6f}\n",
+         name, metric, value, unit, iterations, seconds);
+  fflush(stdout);
+}
+
+/* ---- the wire ---- */
+
+static err_t
+wire_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  struct pbuf *q;
+  unsigned idx;
+  LWIP_UNUSED_ARG(ipaddr);
+
+  if (wire_count == BENCH_WIRE_QUEUE_LEN) {
+    wire_drops++;
+    return ERR_OK;
+  }
+  q = pbuf_clone(PBUF_RAW, PBUF_POOL, p);
+  if (q == NULL) {
+    wire_drops++;
+    return ERR_OK;
+  }
+  idx = (wire_head + wire_count) % BENCH_WIRE_QUEUE_LEN;
+  wire_queue[idx].p = q;
+  wire_queue[idx].to = (netif == &netif_a) ? &netif_b : &netif_a;
+  wire_count++;
+  return ERR_OK;
+}
+
+/** Deliver everything queued on the wire, including frames queued while
+ * delivering. Returns the number of frames delivered. */
+static unsigned
+wire_drain(void)
+{
+  unsigned n = 0;
+  while (wire_count > 0) {
+    struct bench_wire_entry e = wire_queue[wire_head];
+    wire_head = (wire_head + 1) % BENCH_WIRE_QUEUE_LEN;
+    wire_count--;
+    if (e.to->input(e.p, e.to) != ERR_OK) {
+      pbuf_free(e.p);
+    }
+    n++;
+  }
+  return n;
+}
+
+/** One iteration of the main loop: run the wire and the timers. When the wire
+ * is idle, the TCP fast timer is run right away so that delayed ACKs do not
+ * stall the benchmark for up to TCP_TMR_INTERVAL. */
+static void
+bench_poll(void)
+{
+  if (wire_drain() == 0) {
+    tcp_fasttmr();
+  }
+  sys_check_timeouts();
+}
+
+struct netif *
+lwip_bench_route_src(const ip4_addr_t *src, const ip4_addr_t *dest)
+{
+  LWIP_UNUSED_ARG(dest);
+  if (src != NULL) {
+    if (ip4_addr_eq(src, netif_ip4_addr(&netif_a))) {
+      return &netif_a;
+    }
+    if (ip4_addr_eq(src, netif_ip4_addr(&netif_b))) {
+      return &netif_b;
+    }
+  }
+  return NULL;
+}
+
+static unsigned long sink_packets;
+
+static err_t
+sink_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(p);
+  LWIP_UNUSED_ARG(ipaddr);
+  sink_packets++;
+  return ERR_OK;
+}
+
+static err_t
+sink_netif_init(struct netif *netif)
+{
+  netif->name[0] = 's';
+  netif->name[1] = 'c';
+  netif->output = sink_output;
+  netif->mtu = 1500;
+  netif->flags = NETIF_FLAG_LINK_UP;
+  return ERR_OK;
+}
+
+static err_t
+wire_netif_init(struct netif *netif)
+{
+  netif->name[0] = 'w';
+  netif->name[1] = (netif == &netif_a) ? 'a' : 'b';
+  netif->output = wire_output;
+  netif->mtu = 1500;
+  netif->flags = NETIF_FLAG_LINK_UP;
+  return ERR_OK;
+}
+
+static void
+bench_setup(void)
+{
+  ip4_addr_t addr, mask, gw;
+
+  lwip_init();
+
+  IP4_ADDR(&mask, 255, 255, 255, 0);
+  IP4_ADDR(&gw, 0, 0, 0, 0);
+  IP4_ADDR(&addr, 10, 0, 0, 1);
+  netif_add(&netif_a, &addr, &mask, &gw, NULL, wire_netif_init, ip4_input);
+  IP4_ADDR(&addr, 10, 0, 0, 2);
+  netif_add(&netif_b, &addr, &mask, &gw, NULL, wire_netif_init, ip4_input);
+  IP4_ADDR(&addr, 10, 0, 1, 1);
+  netif_add(&netif_c, &addr, &mask, &gw, NULL, sink_netif_init, ip4_input);
+  netif_set_up(&netif_a);
+  netif_set_up(&netif_b);
+  netif_set_up(&netif_c);
+}
+
+/* ---- TCP helpers ---- */
+
+struct bench_tcp {
+  struct tcp_pcb *listener;
+  struct tcp_pcb *client;
+  struct tcp_pcb *server;
+  unsigned long rx_bytes;
+  unsigned long rr_done;
+  unsigned long accepts;
+  int connected;
+  int failed;
+};
+
+static struct bench_tcp tcp_state;
+
+static void
+bench_tcp_err(void *arg, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+  tcp_state.failed = 1;
+}
+
+static err_t
+bench_tcp_connected(void *arg, struct tcp_pcb *tpcb, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(tpcb);
+  LWIP_UNUSED_ARG(err);
+  tcp_state.connected = 1;
+  return ERR_OK;
+}
+
+static struct tcp_pcb *
+bench_tcp_listen(u16_t port, tcp_accept_fn accept)
+{
+  struct tcp_pcb *pcb = tcp_new();
+  if ((pcb == NULL) || (tcp_bind(pcb, netif_ip_addr4(&netif_b), port) != ERR_OK)) {
+    fprintf(stderr, "lwip_bench: listen failed\n");
+    exit(1);
+  }
+  pcb = tcp_listen(pcb);
+  tcp_accept(pcb, accept);
+  return pcb;
+}
+
+static struct tcp_pcb *
+bench_tcp_connect(u16_t port)
+{
+  struct tcp_pcb *pcb = tcp_new();
+  if ((pcb == NULL) || (tcp_bind(pcb, netif_ip_addr4(&netif_a), 0) != ERR_OK)) {
+    return NULL;
+  }
+  tcp_err(pcb, bench_tcp_err);
+  if (tcp_connect(pcb, netif_ip_addr4(&netif_b), port, bench_tcp_connected) != ERR_OK) {
+    tcp_abort(pcb);
+    return NULL;
+  }
+  return pcb;
+}
+
+static void
+bench_tcp_teardown(void)
+{
+  if (tcp_state.client != NULL) {
+    tcp_abort(tcp_state.client);
+  }
+  if (tcp_state.server != NULL) {
+    tcp_abort(tcp_state.server);
+  }
+  wire_drain();
+  if (tcp_state.listener != NULL) {
+    tcp_close(tcp_state.listener);
+  }
+  memset(&tcp_state, 0, sizeof(tcp_state));
+}
+
+/* ---- TCP bulk throughput ---- */
+
+static err_t
+bulk_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+  if (p == NULL) {
+    return ERR_OK;
+  }
+  tcp_state.rx_bytes += p->tot_len;
+  tcp_recved(tpcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static err_t
+bulk_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+  tcp_state.server = newpcb;
+  tcp_err(newpcb, bench_tcp_err);
+  tcp_recv(newpcb, bulk_recv);
+  return ERR_OK;
+}
+
+static void
+bench_tcp_bulk(void)
+{
+  unsigned long target = quick ? (16UL << 20) : (512UL << 20);
+  unsigned long sent = 0;
+  double start, secs;
+
+  tcp_state.listener = bench_tcp_listen(BENCH_TCP_PORT, bulk_accept);
+  tcp_state.client = bench_tcp_connect(BENCH_TCP_PORT);
+  while ((tcp_state.client != NULL) && !tcp_state.connected && !tcp_state.failed) {
+    bench_poll();
+  }
+  if ((tcp_state.client == NULL) || tcp_state.failed) {
+    fprintf(stderr, "lwip_bench: tcp_bulk: connect failed\n");
+    exit(1);
+  }
+
+  start = bench_time();
+  while ((tcp_state.rx_bytes < target) && !tcp_state.failed) {
+    u16_t space = (u16_t)LWIP_MIN(tcp_sndbuf(tcp_state.client), 0xffff);
+    if ((sent < target) && (space >= TCP_MSS)) {
+      u16_t len = (u16_t)LWIP_MIN(space, LWIP_MIN(sizeof(bench_buf), target - sent));
+      if (tcp_write(tcp_state.client, bench_buf, len, TCP_WRITE_FLAG_COPY) == ERR_OK) {
+        sent += len;
+      }
+    }
+    tcp_output(tcp_state.client);
+    bench_poll();
+  }
+  secs = bench_time() - start;
+
+  bench_report("tcp_bulk", "throughput", (double)tcp_state.rx_bytes / secs / 1e6, "MB/s",
+               tcp_state.rx_bytes, secs);
+  bench_tcp_teardown();
+}
+
+/* ---- TCP request/response latency ---- */
+
+static err_t
+rr_client_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+  if (p == NULL) {
+    return ERR_OK;
+  }
+  tcp_state.rx_bytes += p->tot_len;
+  tcp_recved(tpcb, p->tot_len);
+  pbuf_free(p);
+  if (tcp_state.rx_bytes >= BENCH_RR_SIZE) {
+    tcp_state.rx_bytes -= BENCH_RR_SIZE;
+    tcp_state.rr_done++;
+  }
+  return ERR_OK;
+}
+
+static err_t
+rr_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err)
+{
+  struct pbuf *q;
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+  if (p == NULL) {
+    return ERR_OK;
+  }
+  /* echo */
+  for (q = p; q != NULL; q = q->next) {
+    tcp_write(tpcb, q->payload, q->len, TCP_WRITE_FLAG_COPY);
+  }
+  tcp_recved(tpcb, p->tot_len);
+  pbuf_free(p);
+  tcp_output(tpcb);
+  return ERR_OK;
+}
+
+static err_t
+rr_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+  tcp_state.server = newpcb;
+  tcp_nagle_disable(newpcb);
+  tcp_err(newpcb, bench_tcp_err);
+  tcp_recv(newpcb, rr_server_recv);
+  return ERR_OK;
+}
+
+static void
+bench_tcp_rr(void)
+{
+  unsigned long count = quick ? 20000 : 500000;
+  unsigned long i;
+  double start, secs;
+
+  tcp_state.listener = bench_tcp_listen(BENCH_TCP_PORT, rr_accept);
+  tcp_state.client = bench_tcp_connect(BENCH_TCP_PORT);
+  while ((tcp_state.client != NULL) && !tcp_state.connected && !tcp_state.failed) {
+    bench_poll();
+  }
+  if ((tcp_state.client == NULL) || tcp_state.failed) {
+    fprintf(stderr, "lwip_bench: tcp_rr: connect failed\n");
+    exit(1);
+  }
+  tcp_nagle_disable(tcp_state.client);
+  tcp_recv(tcp_state.client, rr_client_recv);
+
+  start = bench_time();
+  for (i = 0; (i < count) && !tcp_state.failed; i++) {
+    unsigned long done = tcp_state.rr_done;
+    tcp_write(tcp_state.client, bench_buf, BENCH_RR_SIZE, TCP_WRITE_FLAG_COPY);
+    tcp_output(tcp_state.client);
+    while ((tcp_state.rr_done == done) && !tcp_state.failed) {
+      bench_poll();
+    }
+  }
+  secs = bench_time() - start;
+
+  bench_report("tcp_rr", "transactions", (double)tcp_state.rr_done / secs, "trans/s",
+               tcp_state.rr_done, secs);
+  bench_report("tcp_rr", "latency", secs * 1e6 / (double)tcp_state.rr_done, "us",
+               tcp_state.rr_done, secs);
+  bench_tcp_teardown();
+}
+
+/* ---- TCP connection setup rate ---- */
+
+static err_t
+conn_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+  tcp_state.accepts++;
+  /* the RST also frees the client side without going through TIME_WAIT */
+  tcp_abort(newpcb);
+  return ERR_ABRT;
+}
+
+static void
+bench_conn_err(void *arg, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+}
+
+static void
+bench_tcp_connect_rate(void)
+{
+  unsigned long count = quick ? 2000 : 100000;
+  unsigned long i;
+  double start, secs;
+
+  tcp_state.listener = bench_tcp_listen(BENCH_CONN_PORT, conn_accept);
+
+  start = bench_time();
+  for (i = 0; i < count; i++) {
+    unsigned long accepts = tcp_state.accepts;
+    struct tcp_pcb *pcb = bench_tcp_connect(BENCH_CONN_PORT);
+    if (pcb == NULL) {
+      fprintf(stderr, "lwip_bench: tcp_connect_rate: connect failed\n");
+      exit(1);
+    }
+    tcp_err(pcb, bench_conn_err);
+    while (tcp_state.accepts == accepts) {
+      bench_poll();
+    }
+    wire_drain();
+  }
+  secs = bench_time() - start;
+
+  bench_report("tcp_connect_rate", "connections", (double)tcp_state.accepts / secs, "conn/s",
+               tcp_state.accepts, secs);
+  bench_tcp_teardown();
+}
+
+/* ---- UDP packet rate ---- */
+
+static unsigned long udp_rx;
+
+static void
+bench_udp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(pcb);
+  LWIP_UNUSED_ARG(addr);
+  LWIP_UNUSED_ARG(port);
+  udp_rx++;
+  pbuf_free(p);
+}
+
+static void
+bench_udp_pps(void)
+{
+  unsigned long count = quick ? 100000 : 5000000;
+  unsigned long i;
+  struct udp_pcb *tx, *rx;
+  double start, secs;
+
+  rx = udp_new();
+  tx = udp_new();
+  if ((rx == NULL) || (tx == NULL) ||
+      (udp_bind(rx, netif_ip_addr4(&netif_b), BENCH_UDP_PORT) != ERR_OK) ||
+      (udp_bind(tx, netif_ip_addr4(&netif_a), 0) != ERR_OK)) {
+    fprintf(stderr, "lwip_bench: udp_pps: setup failed\n");
+    exit(1);
+  }
+  udp_recv(rx, bench_udp_recv, NULL);
+  udp_rx = 0;
+
+  start = bench_time();
+  for (i = 0; i < count; i++) {
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, BENCH_UDP_SIZE, PBUF_RAM);
+    if (p != NULL) {
+      memcpy(p->payload, bench_buf, BENCH_UDP_SIZE);
+      udp_sendto(tx, p, netif_ip_addr4(&netif_b), BENCH_UDP_PORT);
+      pbuf_free(p);
+    }
+    if ((i % BENCH_UDP_BATCH) == (BENCH_UDP_BATCH - 1)) {
+      wire_drain();
+    }
+  }
+  wire_drain();
+  secs = bench_time() - start;
+
+  bench_report("udp_pps", "packets", (double)udp_rx / secs, "pkt/s", udp_rx, secs);
+  udp_remove(rx);
+  udp_remove(tx);
+}
+
+/* ---- IPv4 forwarding rate ---- */
+
+static void
+bench_ip_forward(void)
+{
+  unsigned long count = quick ? 100000 : 10000000;
+  unsigned long i;
+  u8_t pkts[BENCH_FWD_FLOWS][BENCH_FWD_SIZE];
+  ip4_addr_t prefix, gw;
+  int j;
+  double start, secs;
+
+  /* routes 172.16.j.0/24 via netif C; flows go to every other route */
+  for (j = 0; j < BENCH_FWD_ROUTES; j++) {
+    IP4_ADDR(&prefix, 172, 16, j, 0);
+    IP4_ADDR(&gw, 10, 0, 1, 2 + j);
+    if (ip4_fib_add(&prefix, 24, &gw, &netif_c) != ERR_OK) {
+      fprintf(stderr, "lwip_bench: ip_forward: setup failed\n");
+      exit(1);
+    }
+  }
+  for (j = 0; j < BENCH_FWD_FLOWS; j++) {
+    struct ip_hdr *iphdr = (struct ip_hdr *)pkts[j];
+    memset(pkts[j], 0, BENCH_FWD_SIZE);
+    IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+    IPH_LEN_SET(iphdr, PP_HTONS(BENCH_FWD_SIZE));
+    IPH_TTL_SET(iphdr, 64);
+    IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
+    IP4_ADDR(&iphdr->src, 192, 168, 1, 1);
+    IP4_ADDR(&iphdr->dest, 172, 16, 2 * j, 1);
+    IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+  }
+  sink_packets = 0;
+
+  start = bench_time();
+  for (i = 0; i < count; i++) {
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, BENCH_FWD_SIZE, PBUF_POOL);
+    if (p != NULL) {
+      memcpy(p->payload, pkts[i % BENCH_FWD_FLOWS], BENCH_FWD_SIZE);
+      if (netif_a.input(p, &netif_a) != ERR_OK) {
+        pbuf_free(p);
+      }
+    }
+  }
+  secs = bench_time() - start;
+
+  bench_report("ip_forward", "packets", (double)sink_packets / secs, "pkt/s", sink_packets, secs);
+  for (j = 0; j < BENCH_FWD_ROUTES; j++) {
+    IP4_ADDR(&prefix, 172, 16, j, 0);
+    ip4_fib_remove(&prefix, 24);
+  }
+}
+
+/* ---- allocator and checksum micro-benchmarks ---- */
+
+static void
+bench_memp(void)
+{
+  unsigned long rounds = quick ? 100000 : 2000000;
+  unsigned long i;
+  void *objs[BENCH_ALLOC_BATCH];
+  int j;
+  double start, secs;
+
+  start = bench_time();
+  for (i = 0; i < rounds; i++) {
+    for (j = 0; j < BENCH_ALLOC_BATCH; j++) {
+      objs[j] = memp_malloc(MEMP_PBUF);
+    }
+    for (j = 0; j < BENCH_ALLOC_BATCH; j++) {
+      memp_free(MEMP_PBUF, objs[j]);
+    }
+  }
+  secs = bench_time() - start;
+  bench_report("memp", "alloc_free", secs * 1e9 / ((double)rounds * BENCH_ALLOC_BATCH), "ns/op",
+               rounds * BENCH_ALLOC_BATCH, secs);
+}
+
+static void
+bench_mem(void)
+{
+  static const mem_size_t sizes[] = { 64, 1536, 128, 256, 40, 576, 1024, 96 };
+  unsigned long rounds = quick ? 50000 : 1000000;
+  unsigned long i;
+  void *objs[BENCH_ALLOC_BATCH];
+  int j;
+  double start, secs;
+
+  start = bench_time();
+  for (i = 0; i < rounds; i++) {
+    for (j = 0; j < BENCH_ALLOC_BATCH; j++) {
+      objs[j] = mem_malloc(sizes[(i + (unsigned long)j) % LWIP_ARRAYSIZE(sizes)]);
+    }
+    /* free every other object first to fragment the heap */
+    for (j = 0; j < BENCH_ALLOC_BATCH; j += 2) {
+      mem_free(objs[j]);
+    }
+    for (j = 1; j < BENCH_ALLOC_BATCH; j += 2) {
+      mem_free(objs[j]);
+    }
+  }
+  secs = bench_time() - start;
+  bench_report("mem", "alloc_free", secs * 1e9 / ((double)rounds * BENCH_ALLOC_BATCH), "ns/op",
+               rounds * BENCH_ALLOC_BATCH, secs);
+}
+
+static void
+bench_chksum_len(const char *metric, u16_t len, unsigned long rounds)
+{
+  unsigned long i;
+  volatile u16_t sink = 0;
+  double start, secs;
+
+  start = bench_time();
+  for (i = 0; i < rounds; i++) {
+    /* vary the start to also cover unaligned buffers */
+    sink ^= inet_chksum(&bench_buf[i & 3], len);
+  }
+  secs = bench_time() - start;
+  LWIP_UNUSED_ARG(sink);
+  bench_report("inet_chksum", metric, (double)rounds * len / secs / 1e6, "MB/s", rounds, secs);
+}
+
+static void
+bench_chksum(void)
+{
+  bench_chksum_len("bytes_20", 20, quick ? 1000000 : 50000000);
+  bench_chksum_len("bytes_1500", 1500, quick ? 100000 : 5000000);
+  bench_chksum_len("bytes_65000", 65000, quick ? 2000 : 100000);
+}
+
+/* ---- main ---- */
+
+struct bench_entry {
+  const char *name;
+  void (*fn)(void);
+};
+
+static const struct bench_entry benchmarks[] = {
+  { "tcp_bulk", bench_tcp_bulk },
+  { "tcp_rr", bench_tcp_rr },
+  { "tcp_connect_rate", bench_tcp_connect_rate },
+  { "udp_pps", bench_udp_pps },
+  { "ip_forward", bench_ip_forward },
+  { "memp", bench_memp },
+  { "mem", bench_mem },
+  { "inet_chksum", bench_chksum }
+};
+
+static int
+bench_selected(const char *name, int argc, char **argv, int first)
+{
+  int i;
+  if (first >= argc) {
+    return 1;
+  }
+  for (i = first; i < argc; i++) {
+    if (strcmp(argv[i], name) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+  size_t i;
+  int first = 1;
+
+  if ((argc > 1) && (strcmp(argv[1], "-q") == 0)) {
+    quick = 1;
+    first = 2;
+  }
+  if ((argc > 1) && (strcmp(argv[1], "-h") == 0)) {
+    printf("usage: %s [-q] [benchmark...]\n  -q  quick run (smoke test)\nbenchmarks:", argv[0]);
+    for (i = 0; i < LWIP_ARRAYSIZE(benchmarks); i++) {
+      printf(" %s", benchmarks[i].name);
+    }
+    printf("\n");
+    return 0;
+  }
+
+  for (i = 0; i < sizeof(bench_buf); i++) {
+    bench_buf[i] = (u8_t)i;
+  }
+  bench_setup();
+
+  for (i = 0; i < LWIP_ARRAYSIZE(benchmarks); i++) {
+    if (bench_selected(benchmarks[i].name, argc, argv, first)) {
+      benchmarks[i].fn();
+    }
+  }
+  if (wire_drops != 0) {
+    fprintf(stderr, "lwip_bench: %lu frames dropped on the wire\n", wire_drops);
+  }
+  return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2026 lwIP contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 3. The name of the author may not be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+ * SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ * OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ *
+ * This file is part of the lwIP TCP/IP stack.
+ *
+ */
+#ifndef LWIP_HDR_LWIPOPTS_H
+#define LWIP_HDR_LWIPOPTS_H
+
+/* Options for the lwIP benchmarks: a single threaded NO_SYS stack tuned for
+   throughput (large windows, many segments), checksums on like a real port */
+#define NO_SYS                          1
+#define SYS_LIGHTWEIGHT_PROT            0
+#define LWIP_NETCONN                    0
+#define LWIP_SOCKET                     0
+#define LWIP_IPV4                       1
+#define LWIP_IPV6                       0
+#define LWIP_ARP                        0
+#define LWIP_ETHERNET                   0
+#define LWIP_DHCP                       0
+#define LWIP_NETIF_LOOPBACK             0
+#define LWIP_HAVE_LOOPIF                0
+
+#define MEM_ALIGNMENT                   4
+#define MEM_SIZE                        (4 * 1024 * 1024)
+#define MEMP_NUM_PBUF                   256
+#define MEMP_NUM_UDP_PCB                4
+#define MEMP_NUM_TCP_PCB                64
+#define MEMP_NUM_TCP_PCB_LISTEN         4
+#define MEMP_NUM_TCP_SEG                1024
+#define PBUF_POOL_SIZE                  1024
+#define PBUF_POOL_BUFSIZE               1600 /* one pool pbuf per wire frame */
+
+#define TCP_MSS                         1460
+#define LWIP_WND_SCALE                  1
+#define TCP_RCV_SCALE                   4
+#define TCP_WND                         (256 * TCP_MSS)
+#define TCP_SND_BUF                     (256 * TCP_MSS)
+#define TCP_SND_QUEUELEN                1024
+#define TCP_SNDLOWAT                    (16 * TCP_MSS)
+
+#define LWIP_STATS                      0
+
+/* Router: forwarding via a routing table, with the flow cache unless built
+   with -DIP_FORWARD_FLOW_CACHE=0 for comparison */
+#define IP_FORWARD                      1
+#define LWIP_IPV4_FIB                   1
+#define MEMP_NUM_IP4_FIB_NODE           128
+#ifndef IP_FORWARD_FLOW_CACHE
+#define IP_FORWARD_FLOW_CACHE           1
+#endif
+#define LWIP_STATS_DISPLAY              0
+
+/* Both endpoints live in the same stack: route by source address so that
+   traffic of each endpoint leaves through its own netif of the wire. */
+struct netif;
+struct ip4_addr;
+struct netif *lwip_bench_route_src(const struct ip4_addr *src, const struct ip4_addr *dest);
+#define LWIP_HOOK_IP4_ROUTE_SRC(src, dest) lwip_bench_route_src(src, dest)
+
+#endif /* LWIP_HDR_LWIPOPTS_H */
@@ -117,6 +117,17 @@ static void test_sockets_allfunctions_basic_domain(int domain)
   ret = lwip_listen(s, 0);
   fail_unless(ret == 0);
 
+#if LWIP_TCP_INFO
+  {
+    /* TCP_INFO is not available for listening sockets */
+    struct tcp_pcb_info info;
+    socklen_t infolen = sizeof(info);
+    ret = lwip_getsockopt(s, IPPROTO_TCP, TCP_INFO, &info, &infolen);
+    fail_unless(ret == -1);
+    fail_unless(errno == EINVAL);
+  }
+#endif /* LWIP_TCP_INFO */
+
   addrlen = sizeof(addr);
   ret = lwip_getsockname(s, (struct sockaddr*)&addr, &addrlen);
   fail_unless(ret == 0);
@@ -261,13 +261,81 @@ START_TEST(test_etharp_table)
 }
 END_TEST
 
+START_TEST(test_etharp_table_hash)
+{
+#if ETHARP_TABLE_HASH
+  ip4_addr_t adrs[ARP_TABLE_SIZE + 1];
+  const ip4_addr_t *unused_ipaddr;
+  struct eth_addr *unused_ethaddr;
+  ssize_t idx;
+  err_t err;
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  /* addresses 4 apart share a hash bucket with ETHARP_TABLE_HASH_SIZE 4 */
+  for (i = 0; i < ARP_TABLE_SIZE + 1; i++) {
+    IP4_ADDR(&adrs[i], 192,168,1,4*i+4);
+  }
+  for (i = 0; i < ARP_TABLE_SIZE; i++) {
+    err = etharp_add_static_entry(&adrs[i], &test_ethaddr3);
+    fail_unless(err == ERR_OK);
+  }
+  /* static entries are never recycled */
+  err = etharp_add_static_entry(&adrs[ARP_TABLE_SIZE], &test_ethaddr4);
+  fail_unless(err == ERR_MEM);
+
+  /* remove entries from the head, middle and tail of the bucket chain */
+  err = etharp_remove_static_entry(&adrs[0]);
+  fail_unless(err == ERR_OK);
+  err = etharp_remove_static_entry(&adrs[ARP_TABLE_SIZE / 2]);
+  fail_unless(err == ERR_OK);
+  err = etharp_remove_static_entry(&adrs[ARP_TABLE_SIZE - 1]);
+  fail_unless(err == ERR_OK);
+  for (i = 0; i < ARP_TABLE_SIZE; i++) {
+    idx = etharp_find_addr(NULL, &adrs[i], &unused_ethaddr, &unused_ipaddr);
+    if ((i == 0) || (i == ARP_TABLE_SIZE / 2) || (i == ARP_TABLE_SIZE - 1)) {
+      fail_unless(idx == -1);
+    } else {
+      fail_unless(idx >= 0);
+      fail_unless(ip4_addr_eq(unused_ipaddr, &adrs[i]));
+    }
+  }
+  /* freed entries are reused */
+  err = etharp_add_static_entry(&adrs[ARP_TABLE_SIZE], &test_ethaddr4);
+  fail_unless(err == ERR_OK);
+  idx = etharp_find_addr(NULL, &adrs[ARP_TABLE_SIZE], &unused_ethaddr, &unused_ipaddr);
+  fail_unless(idx >= 0);
+  fail_unless(eth_addr_eq(unused_ethaddr, &test_ethaddr4));
+
+  for (i = 1; i < ARP_TABLE_SIZE + 1; i++) {
+    if ((i != ARP_TABLE_SIZE / 2) && (i != ARP_TABLE_SIZE - 1)) {
+      err = etharp_remove_static_entry(&adrs[i]);
+      fail_unless(err == ERR_OK);
+    }
+  }
+  /* dynamic and static entries share a bucket */
+  err = etharp_add_static_entry(&adrs[1], &test_ethaddr3);
+  fail_unless(err == ERR_OK);
+  create_arp_response(&adrs[0]);
+  idx = etharp_find_addr(NULL, &adrs[0], &unused_ethaddr, &unused_ipaddr);
+  fail_unless(idx >= 0);
+  fail_unless(eth_addr_eq(unused_ethaddr, &test_ethaddr2));
+  err = etharp_remove_static_entry(&adrs[1]);
+  fail_unless(err == ERR_OK);
+#else
+  LWIP_UNUSED_ARG(_i);
+#endif /* ETHARP_TABLE_HASH */
+}
+END_TEST
+
 
 /** Create the suite including all tests for this module */
 Suite *
 etharp_suite(void)
 {
   testfunc tests[] = {
-    TESTFUNC(test_etharp_table)
+    TESTFUNC(test_etharp_table),
+    TESTFUNC(test_etharp_table_hash)
   };
   return create_suite("ETHARP", tests, sizeof(tests)/sizeof(testfunc), etharp_setup, etharp_teardown);
 }
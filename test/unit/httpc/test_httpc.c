@@ -0,0 +1,371 @@
+#include "test_httpc.h"
+
+#include "lwip/apps/http_client.h"
+#include "lwip/tcp.h"
+#include "lwip/tcpip.h"
+#include "lwip/priv/tcp_priv.h"
+#include "../tcp/tcp_helper.h"
+
+#include <string.h>
+
+#define TEST_HTTPC_PORT 8080
+
+/* raw TCP server on the loopback netif, the responses are sent by the tests */
+static struct tcp_pcb *test_httpc_server;
+static int test_httpc_accepts;
+static char test_httpc_request[512];
+static u16_t test_httpc_request_len;
+
+/* result of the last request and the body data passed to the application */
+static httpc_connection_t test_httpc_settings;
+static int test_httpc_done;
+static httpc_result_t test_httpc_result;
+static u32_t test_httpc_rx_content_len;
+static u32_t test_httpc_srv_res;
+static char test_httpc_body[512];
+static u16_t test_httpc_body_len;
+/* number of times recv_fn refuses data (returns ERR_MEM) */
+static int test_httpc_refuse;
+
+static err_t
+test_httpc_server_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+  u16_t len;
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+
+  if (p == NULL) {
+    if (pcb == test_httpc_server) {
+      test_httpc_server = NULL;
+    }
+    tcp_recv(pcb, NULL);
+    tcp_err(pcb, NULL);
+    return tcp_close(pcb);
+  }
+  len = (u16_t)LWIP_MIN(p->tot_len, sizeof(test_httpc_request) - 1 - test_httpc_request_len);
+  pbuf_copy_partial(p, &test_httpc_request[test_httpc_request_len], len, 0);
+  test_httpc_request_len = (u16_t)(test_httpc_request_len + len);
+  test_httpc_request[test_httpc_request_len] = 0;
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static void
+test_httpc_server_err(void *arg, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+  test_httpc_server = NULL;
+}
+
+static err_t
+test_httpc_server_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+
+  test_httpc_server = pcb;
+  test_httpc_accepts++;
+  test_httpc_request_len = 0;
+  test_httpc_request[0] = 0;
+  tcp_nagle_disable(pcb);
+  tcp_recv(pcb, test_httpc_server_recv);
+  tcp_err(pcb, test_httpc_server_err);
+  return ERR_OK;
+}
+
+static void
+test_httpc_result_fn(void *arg, httpc_result_t httpc_result, u32_t rx_content_len, u32_t srv_res, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+  test_httpc_done++;
+  test_httpc_result = httpc_result;
+  test_httpc_rx_content_len = rx_content_len;
+  test_httpc_srv_res = srv_res;
+}
+
+static err_t
+test_httpc_recv_fn(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+  u16_t len;
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+
+  fail_unless(p != NULL);
+  if (test_httpc_refuse > 0) {
+    test_httpc_refuse--;
+    return ERR_MEM;
+  }
+  len = (u16_t)LWIP_MIN(p->tot_len, sizeof(test_httpc_body) - 1 - test_httpc_body_len);
+  pbuf_copy_partial(p, &test_httpc_body[test_httpc_body_len], len, 0);
+  test_httpc_body_len = (u16_t)(test_httpc_body_len + len);
+  test_httpc_body[test_httpc_body_len] = 0;
+  altcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+/** Process all packets on the loopback netif (including delayed ACKs) */
+static void
+test_httpc_poll(void)
+{
+  int i;
+  for (i = 0; i < 10; i++) {
+    while (tcpip_thread_poll_one());
+    tcp_fasttmr();
+  }
+}
+
+/** Run the slow timer (calling the httpc poll callback) until the request is done */
+static void
+test_httpc_poll_slow(void)
+{
+  int i;
+  for (i = 0; (i < 10) && !test_httpc_done; i++) {
+    tcp_slowtmr();
+    test_httpc_poll();
+  }
+}
+
+/** Start a request for "/file", the server must have received it */
+static void
+test_httpc_get(void)
+{
+  ip_addr_t addr;
+  httpc_state_t *connection;
+  err_t err;
+
+  IP_ADDR4(&addr, 127, 0, 0, 1);
+  test_httpc_done = 0;
+  test_httpc_body_len = 0;
+  test_httpc_body[0] = 0;
+  test_httpc_request_len = 0;
+  test_httpc_request[0] = 0;
+  err = httpc_get_file(&addr, TEST_HTTPC_PORT, "/file", &test_httpc_settings,
+                       test_httpc_recv_fn, NULL, &connection);
+  fail_unless(err == ERR_OK);
+  test_httpc_poll();
+  fail_unless(test_httpc_server != NULL);
+  fail_unless(!strncmp(test_httpc_request, "GET /file HTTP/1.1\r\n", 20), "request: %s", test_httpc_request);
+  fail_unless(!strcmp(&test_httpc_request[test_httpc_request_len - 4], "\r\n\r\n"));
+}
+
+/** Send (part of) a response from the server */
+static void
+test_httpc_respond(const char *data)
+{
+  err_t err;
+
+  fail_unless(test_httpc_server != NULL);
+  err = tcp_write(test_httpc_server, data, (u16_t)strlen(data), TCP_WRITE_FLAG_COPY);
+  fail_unless(err == ERR_OK);
+  err = tcp_output(test_httpc_server);
+  fail_unless(err == ERR_OK);
+  test_httpc_poll();
+}
+
+/** Close the connection from the server side */
+static void
+test_httpc_server_close(void)
+{
+  struct tcp_pcb *pcb = test_httpc_server;
+
+  fail_unless(pcb != NULL);
+  test_httpc_server = NULL;
+  tcp_recv(pcb, NULL);
+  tcp_err(pcb, NULL);
+  fail_unless(tcp_close(pcb) == ERR_OK);
+  test_httpc_poll();
+}
+
+/** Check that the request is done with the given result and body */
+static void
+test_httpc_check_done(httpc_result_t result, const char *body)
+{
+  fail_unless(test_httpc_done == 1, "done: %d", test_httpc_done);
+  fail_unless(test_httpc_result == result, "result: %d", test_httpc_result);
+  fail_unless(test_httpc_srv_res == 200);
+  fail_unless(!strcmp(test_httpc_body, body), "body: %s", test_httpc_body);
+  fail_unless(test_httpc_rx_content_len == strlen(body));
+}
+
+/* Setups/teardown functions */
+
+static void
+httpc_setup(void)
+{
+  struct tcp_pcb *pcb;
+  err_t err;
+
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+  memset(&test_httpc_settings, 0, sizeof(test_httpc_settings));
+  test_httpc_settings.result_fn = test_httpc_result_fn;
+  test_httpc_server = NULL;
+  test_httpc_accepts = 0;
+  test_httpc_done = 0;
+  test_httpc_refuse = 0;
+
+  pcb = tcp_new();
+  fail_unless(pcb != NULL);
+  err = tcp_bind(pcb, IP_ANY_TYPE, TEST_HTTPC_PORT);
+  fail_unless(err == ERR_OK);
+  pcb = tcp_listen(pcb);
+  fail_unless(pcb != NULL);
+  tcp_accept(pcb, test_httpc_server_accept);
+}
+
+static void
+httpc_teardown(void)
+{
+#if LWIP_HTTPC_KEEPALIVE
+  httpc_keepalive_close_all();
+#endif /* LWIP_HTTPC_KEEPALIVE */
+  test_httpc_server = NULL;
+  /* closes the listener, too */
+  tcp_remove_all();
+  test_httpc_poll();
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* Test functions */
+
+START_TEST(test_httpc_chunked)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  /* headers and all chunks in one segment: the chunks are split inside a pbuf */
+  test_httpc_get();
+  test_httpc_respond("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                     "5\r\nHello\r\n7;ext=1\r\n, world\r\n0\r\nX-Trailer: 1\r\n\r\n");
+  test_httpc_check_done(HTTPC_RESULT_OK, "Hello, world");
+
+  /* framing split across segments */
+  test_httpc_get();
+  test_httpc_respond("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+  test_httpc_respond("a\r");
+  test_httpc_respond("\n0123");
+  fail_unless(!strcmp(test_httpc_body, "0123"));
+  test_httpc_respond("456789\r");
+  test_httpc_respond("\n3\r\nabc\r\n0\r");
+  fail_unless(test_httpc_done == 0);
+  test_httpc_respond("\n\r\n");
+  test_httpc_check_done(HTTPC_RESULT_OK, "0123456789abc");
+}
+END_TEST
+
+START_TEST(test_httpc_chunked_invalid)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  /* no CRLF after the chunk data */
+  test_httpc_get();
+  test_httpc_respond("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nHelloXX");
+  test_httpc_check_done(HTTPC_RESULT_ERR_CONTENT_LEN, "Hello");
+  /* the client has closed the connection */
+  fail_unless(test_httpc_server == NULL);
+
+  /* closed before the last chunk */
+  test_httpc_get();
+  test_httpc_respond("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nHello\r\n");
+  test_httpc_server_close();
+  test_httpc_check_done(HTTPC_RESULT_ERR_CONTENT_LEN, "Hello");
+}
+END_TEST
+
+START_TEST(test_httpc_refused)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  /* data refused by the application is passed again from the poll callback */
+  test_httpc_get();
+  test_httpc_refuse = 2;
+  test_httpc_respond("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                     "5\r\nHello\r\n7\r\n, world\r\n0\r\n\r\n");
+  fail_unless(test_httpc_done == 0);
+  fail_unless(test_httpc_body_len == 0);
+  test_httpc_poll_slow();
+  fail_unless(test_httpc_refuse == 0);
+  test_httpc_check_done(HTTPC_RESULT_OK, "Hello, world");
+
+  /* closed by the server while data is refused */
+  test_httpc_get();
+  test_httpc_refuse = 1;
+  test_httpc_respond("HTTP/1.1 200 OK\r\nConnection: close\r\n\r\nabc");
+  test_httpc_server_close();
+  fail_unless(test_httpc_done == 0);
+  test_httpc_poll_slow();
+  test_httpc_check_done(HTTPC_RESULT_OK, "abc");
+}
+END_TEST
+
+#if LWIP_HTTPC_KEEPALIVE
+START_TEST(test_httpc_keepalive)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  test_httpc_get();
+  test_httpc_respond("HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nabc");
+  test_httpc_check_done(HTTPC_RESULT_OK, "abc");
+
+  /* the idle connection is reused */
+  test_httpc_get();
+  fail_unless(test_httpc_accepts == 1);
+  test_httpc_respond("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 3\r\n\r\ndef");
+  test_httpc_check_done(HTTPC_RESULT_OK, "def");
+  /* ...but not after "Connection: close" */
+  fail_unless(test_httpc_server == NULL);
+
+  test_httpc_get();
+  fail_unless(test_httpc_accepts == 2);
+  test_httpc_respond("HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nghi");
+  test_httpc_check_done(HTTPC_RESULT_OK, "ghi");
+
+  /* an idle connection closed by the server is removed from the pool */
+  test_httpc_server_close();
+  test_httpc_get();
+  fail_unless(test_httpc_accepts == 3);
+  test_httpc_respond("HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\njkl");
+  test_httpc_check_done(HTTPC_RESULT_OK, "jkl");
+}
+END_TEST
+
+START_TEST(test_httpc_keepalive_retry)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  test_httpc_get();
+  test_httpc_respond("HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nabc");
+  test_httpc_check_done(HTTPC_RESULT_OK, "abc");
+
+  /* the server closes the reused connection instead of answering:
+     the request is sent again on a new connection */
+  test_httpc_get();
+  fail_unless(test_httpc_accepts == 1);
+  test_httpc_server_close();
+  fail_unless(test_httpc_accepts == 2);
+  fail_unless(test_httpc_server != NULL);
+  fail_unless(!strncmp(test_httpc_request, "GET /file HTTP/1.1\r\n", 20), "request: %s", test_httpc_request);
+  fail_unless(test_httpc_done == 0);
+  test_httpc_respond("HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\ndef");
+  test_httpc_check_done(HTTPC_RESULT_OK, "def");
+}
+END_TEST
+#endif /* LWIP_HTTPC_KEEPALIVE */
+
+/** Create the suite including all tests for this module */
+Suite *
+httpc_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_httpc_chunked),
+    TESTFUNC(test_httpc_chunked_invalid),
+    TESTFUNC(test_httpc_refused),
+#if LWIP_HTTPC_KEEPALIVE
+    TESTFUNC(test_httpc_keepalive),
+    TESTFUNC(test_httpc_keepalive_retry),
+#endif /* LWIP_HTTPC_KEEPALIVE */
+  };
+  return create_suite("HTTPC", tests, sizeof(tests)/sizeof(testfunc), httpc_setup, httpc_teardown);
+}
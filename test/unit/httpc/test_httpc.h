@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_HTTPC_H__
+#define LWIP_HDR_TEST_HTTPC_H__
+
+#include "../lwip_check.h"
+
+Suite* httpc_suite(void);
+
+#endif
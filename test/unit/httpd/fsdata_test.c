@@ -0,0 +1,75 @@
+/* File system for the httpd unit tests (included by fs.c via HTTPD_FSDATA_FILE):
+ * small files without included HTTP headers (sent with Content-Length, as
+ * with makefsdata -11), some with validators */
+#include "lwip/apps/fs.h"
+#include "lwip/def.h"
+
+
+#define file_NULL (struct fsdata_file *) NULL
+
+#if HTTPD_PRECALCULATED_CHECKSUM
+#define FSDATA_TEST_CHKSUM        0, NULL,
+#else /* HTTPD_PRECALCULATED_CHECKSUM */
+#define FSDATA_TEST_CHKSUM
+#endif /* HTTPD_PRECALCULATED_CHECKSUM */
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+#define FSDATA_TEST_VALIDATORS(v) v,
+#else /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+#define FSDATA_TEST_VALIDATORS(v)
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+
+#define FSDATA_TEST_FILE(var, next, name, data, flags, validators) \
+  const struct fsdata_file var[] = { { \
+    next, \
+    (const unsigned char *)name, \
+    data, \
+    sizeof(data) - 1, \
+    flags, \
+    FSDATA_TEST_CHKSUM \
+    FSDATA_TEST_VALIDATORS(validators) \
+  } }
+
+static const unsigned char data__404_html[] = "<html><body>404</body></html>";
+static const unsigned char data__enc_html[] = "<html><body>plain</body></html>";
+static const unsigned char data__enc_html_br[] = "brotli";
+static const unsigned char data__enc_html_gz[] = "gzip";
+static const unsigned char data__img_sics_gif[] = "GIF89a";
+static const unsigned char data__index_html[] = "<html><body>index</body></html>";
+static const unsigned char data__test_txt[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+static const unsigned char data__weak_txt[] = "weak";
+
+#define VALIDATORS_TEST_TXT "ETag: \"t1\"\r\nLast-Modified: Sat, 01 Jan 2000 00:00:00 GMT\r\n"
+
+FSDATA_TEST_FILE(file__weak_txt, file_NULL, "/weak.txt", data__weak_txt, FS_FILE_FLAGS_HEADER_PERSISTENT,
+                 "ETag: W/\"w1\"\r\n");
+FSDATA_TEST_FILE(file__test_txt, file__weak_txt, "/test.txt", data__test_txt, FS_FILE_FLAGS_HEADER_PERSISTENT,
+                 VALIDATORS_TEST_TXT);
+FSDATA_TEST_FILE(file__index_html, file__test_txt, "/index.html", data__index_html, FS_FILE_FLAGS_HEADER_PERSISTENT,
+                 "ETag: \"idx\"\r\n");
+FSDATA_TEST_FILE(file__img_sics_gif, file__index_html, "/img/sics.gif", data__img_sics_gif, FS_FILE_FLAGS_HEADER_PERSISTENT,
+                 NULL);
+FSDATA_TEST_FILE(file__enc_html_gz, file__img_sics_gif, "/enc.html.gz", data__enc_html_gz, FS_FILE_FLAGS_HEADER_PERSISTENT | FS_FILE_FLAGS_ENCODING_GZIP,
+                 "ETag: \"enc-gz\"\r\n");
+FSDATA_TEST_FILE(file__enc_html_br, file__enc_html_gz, "/enc.html.br", data__enc_html_br, FS_FILE_FLAGS_HEADER_PERSISTENT | FS_FILE_FLAGS_ENCODING_BR,
+                 "ETag: \"enc-br\"\r\n");
+FSDATA_TEST_FILE(file__enc_html, file__enc_html_br, "/enc.html", data__enc_html, FS_FILE_FLAGS_HEADER_PERSISTENT | FS_FILE_FLAGS_ENCODING_VARIANTS,
+                 "ETag: \"enc\"\r\n");
+FSDATA_TEST_FILE(file__404_html, file__enc_html, "/404.html", data__404_html, FS_FILE_FLAGS_HEADER_PERSISTENT,
+                 NULL);
+
+#define FS_ROOT file__404_html
+#define FS_NUMFILES 8
+
+/* all files sorted by name for binary search in fs_open() */
+const struct fsdata_file *const fsdata_sorted_files[] = {
+  file__404_html,
+  file__enc_html,
+  file__enc_html_br,
+  file__enc_html_gz,
+  file__img_sics_gif,
+  file__index_html,
+  file__test_txt,
+  file__weak_txt,
+};
+
+#define FS_SORTED_FILES fsdata_sorted_files
@@ -0,0 +1,61 @@
+#include "test_fs.h"
+
+#include "lwip/apps/fs.h"
+#include "lwip/def.h"
+
+#include <string.h>
+
+/* Setups/teardown functions */
+
+static void
+fs_setup(void)
+{
+}
+
+static void
+fs_teardown(void)
+{
+}
+
+/* Test functions */
+
+/** Open files of the file system (httpd/fsdata_test.c) and names that sort before, between
+ * and after them */
+START_TEST(test_fs_open)
+{
+  static const char *const files[] = {"/index.html", "/404.html", "/img/sics.gif"};
+  static const char *const missing[] = {"", "/", "/1.html", "/404.htm", "/404.html.gz",
+    "/image.png", "/img/", "/index.htm", "/zzz", "index.html"};
+  struct fs_file file;
+  size_t i;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < LWIP_ARRAYSIZE(files); i++) {
+    memset(&file, 0, sizeof(file));
+    err = fs_open(&file, files[i]);
+    fail_unless(err == ERR_OK);
+    fail_unless(file.data != NULL);
+    fail_unless(file.len > 0);
+    fail_unless(fs_bytes_left(&file) == 0);
+    fs_close(&file);
+  }
+  for (i = 0; i < LWIP_ARRAYSIZE(missing); i++) {
+    memset(&file, 0, sizeof(file));
+    err = fs_open(&file, missing[i]);
+    fail_unless(err == ERR_VAL);
+  }
+  fail_unless(fs_open(NULL, files[0]) == ERR_ARG);
+  fail_unless(fs_open(&file, NULL) == ERR_ARG);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+fs_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_fs_open),
+  };
+  return create_suite("FS", tests, sizeof(tests)/sizeof(testfunc), fs_setup, fs_teardown);
+}
@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_FS_H__
+#define LWIP_HDR_TEST_FS_H__
+
+#include "../lwip_check.h"
+
+Suite* fs_suite(void);
+
+#endif
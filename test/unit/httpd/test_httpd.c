@@ -0,0 +1,987 @@
+#include "test_httpd.h"
+
+#include "lwip/apps/httpd.h"
+#include "lwip/apps/fs.h"
+#include "lwip/tcp.h"
+#include "lwip/tcpip.h"
+#include "lwip/priv/tcp_priv.h"
+#include "../tcp/tcp_helper.h"
+
+#include <string.h>
+
+#if LWIP_HTTPD_FILE_STATE
+/* number of files opened by httpd (see fsdata_test.c) */
+static int test_httpd_file_opens;
+
+void *
+fs_state_init(struct fs_file *file, const char *name)
+{
+  LWIP_UNUSED_ARG(file);
+  LWIP_UNUSED_ARG(name);
+  test_httpd_file_opens++;
+  return NULL;
+}
+
+void
+fs_state_free(struct fs_file *file, void *state)
+{
+  LWIP_UNUSED_ARG(file);
+  LWIP_UNUSED_ARG(state);
+}
+#endif /* LWIP_HTTPD_FILE_STATE */
+
+#if LWIP_HTTPD_WEBSOCKET
+/* WebSocket accepted on "/ws" and the data frames received on it */
+static void *test_httpd_ws_conn;
+static u8_t test_httpd_ws_opcodes[8];
+static u16_t test_httpd_ws_frames;
+static char test_httpd_ws_data[512];
+static u16_t test_httpd_ws_data_len;
+static int test_httpd_ws_closed;
+
+err_t
+httpd_websocket_accept(void *connection, const char *uri, const char *http_request,
+                       u16_t http_request_len)
+{
+  LWIP_UNUSED_ARG(http_request);
+  LWIP_UNUSED_ARG(http_request_len);
+  if (strcmp(uri, "/ws")) {
+    return ERR_VAL;
+  }
+  test_httpd_ws_conn = connection;
+  return ERR_OK;
+}
+
+void
+httpd_websocket_receive(void *connection, u8_t opcode, struct pbuf *p)
+{
+  fail_unless(connection == test_httpd_ws_conn);
+  if (test_httpd_ws_frames < sizeof(test_httpd_ws_opcodes)) {
+    test_httpd_ws_opcodes[test_httpd_ws_frames] = opcode;
+  }
+  test_httpd_ws_frames++;
+  if (p != NULL) {
+    u16_t len = (u16_t)LWIP_MIN(p->tot_len, sizeof(test_httpd_ws_data) - test_httpd_ws_data_len);
+    pbuf_copy_partial(p, &test_httpd_ws_data[test_httpd_ws_data_len], len, 0);
+    test_httpd_ws_data_len = (u16_t)(test_httpd_ws_data_len + len);
+    pbuf_free(p);
+  }
+}
+
+void
+httpd_websocket_closed(void *connection)
+{
+  fail_unless(connection == test_httpd_ws_conn);
+  test_httpd_ws_conn = NULL;
+  test_httpd_ws_closed++;
+}
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
+/* raw TCP client connected to httpd via the loopback netif */
+static struct tcp_pcb *test_httpd_client;
+static char test_httpd_rx[2048];
+static u16_t test_httpd_rx_len;
+static u8_t test_httpd_rx_closed;
+
+static err_t
+test_httpd_client_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+  u16_t len;
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+
+  if (p == NULL) {
+    test_httpd_rx_closed = 1;
+    return ERR_OK;
+  }
+  len = (u16_t)LWIP_MIN(p->tot_len, sizeof(test_httpd_rx) - 1 - test_httpd_rx_len);
+  pbuf_copy_partial(p, &test_httpd_rx[test_httpd_rx_len], len, 0);
+  test_httpd_rx_len = (u16_t)(test_httpd_rx_len + len);
+  test_httpd_rx[test_httpd_rx_len] = 0;
+  tcp_recved(pcb, p->tot_len);
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static void
+test_httpd_client_err(void *arg, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(err);
+  test_httpd_client = NULL;
+  test_httpd_rx_closed = 1;
+}
+
+/** Process all packets on the loopback netif (including delayed ACKs) */
+static void
+test_httpd_poll(void)
+{
+  int i;
+  for (i = 0; i < 10; i++) {
+    while (tcpip_thread_poll_one());
+    tcp_fasttmr();
+  }
+}
+
+static void
+test_httpd_connect(void)
+{
+  ip_addr_t addr;
+  err_t err;
+
+  IP_ADDR4(&addr, 127, 0, 0, 1);
+  test_httpd_rx_len = 0;
+  test_httpd_rx[0] = 0;
+  test_httpd_rx_closed = 0;
+  test_httpd_client = tcp_new();
+  fail_unless(test_httpd_client != NULL);
+  tcp_recv(test_httpd_client, test_httpd_client_recv);
+  tcp_err(test_httpd_client, test_httpd_client_err);
+  err = tcp_connect(test_httpd_client, &addr, HTTPD_SERVER_PORT, NULL);
+  fail_unless(err == ERR_OK);
+  test_httpd_poll();
+  fail_unless(test_httpd_client != NULL);
+  fail_unless(test_httpd_client->state == ESTABLISHED);
+}
+
+static void
+test_httpd_send(const char *data, u16_t len)
+{
+  err_t err;
+
+  fail_unless(test_httpd_client != NULL);
+  err = tcp_write(test_httpd_client, data, len, TCP_WRITE_FLAG_COPY);
+  fail_unless(err == ERR_OK);
+  err = tcp_output(test_httpd_client);
+  fail_unless(err == ERR_OK);
+  test_httpd_poll();
+}
+
+static void
+test_httpd_disconnect(void)
+{
+  if (test_httpd_client != NULL) {
+    tcp_abort(test_httpd_client);
+    test_httpd_poll();
+  }
+}
+
+/** Send a request on a new connection and return the response */
+static const char *
+test_httpd_get(const char *request)
+{
+  test_httpd_connect();
+  test_httpd_send(request, (u16_t)strlen(request));
+  test_httpd_disconnect();
+  return test_httpd_rx;
+}
+
+/** Check that a response has the given status line and body */
+static void
+test_httpd_check_response(const char *response, const char *status, const char *body)
+{
+  const char *hdrs_end;
+
+  fail_unless(!strncmp(response, status, strlen(status)), "response: %s", response);
+  hdrs_end = strstr(response, "\r\n\r\n");
+  fail_unless(hdrs_end != NULL);
+  fail_unless(!strcmp(hdrs_end + 4, body), "body: %s", hdrs_end + 4);
+}
+
+#if LWIP_HTTPD_WEBSOCKET
+static const char test_httpd_ws_request[] =
+  "GET /ws HTTP/1.1\r\nHost: server.example.com\r\nUpgrade: websocket\r\n"
+  "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+  "Sec-WebSocket-Version: 13\r\n\r\n";
+
+/** Build a masked client frame, return its length */
+static u16_t
+test_httpd_ws_frame(u8_t *buf, u8_t b0, const char *data, u16_t len)
+{
+  static const u8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+  u16_t i, hdr_len = 2;
+
+  buf[0] = b0;
+  if (len < 126) {
+    buf[1] = (u8_t)(0x80 | len);
+  } else {
+    buf[1] = 0x80 | 126;
+    buf[2] = (u8_t)(len >> 8);
+    buf[3] = (u8_t)len;
+    hdr_len = 4;
+  }
+  memcpy(&buf[hdr_len], mask, 4);
+  hdr_len += 4;
+  for (i = 0; i < len; i++) {
+    buf[hdr_len + i] = (u8_t)(data[i] ^ mask[i & 3]);
+  }
+  return (u16_t)(hdr_len + len);
+}
+
+/** Send a masked client frame */
+static void
+test_httpd_ws_send(u8_t b0, const char *data, u16_t len)
+{
+  u8_t buf[512];
+  fail_unless((size_t)len + 8 <= sizeof(buf));
+  test_httpd_send((const char *)buf, test_httpd_ws_frame(buf, b0, data, len));
+}
+
+/** Open a WebSocket to "/ws", the received data is reset after the 101 response */
+static void
+test_httpd_ws_open(void)
+{
+  test_httpd_connect();
+  test_httpd_send(test_httpd_ws_request, sizeof(test_httpd_ws_request) - 1);
+  fail_unless(test_httpd_ws_conn != NULL);
+  fail_unless(!strncmp(test_httpd_rx, "HTTP/1.1 101 ", 13), "response: %s", test_httpd_rx);
+  fail_unless(test_httpd_rx_len >= 4);
+  fail_unless(!strcmp(&test_httpd_rx[test_httpd_rx_len - 4], "\r\n\r\n"));
+  test_httpd_rx_len = 0;
+}
+
+/** Check that a close frame with the given status has been received and the
+ * connection has been closed */
+static void
+test_httpd_ws_check_closed(u16_t status)
+{
+  fail_unless(test_httpd_rx_len == 4, "received %d bytes", test_httpd_rx_len);
+  fail_unless((u8_t)test_httpd_rx[0] == 0x88);
+  fail_unless(test_httpd_rx[1] == 2);
+  fail_unless((u8_t)test_httpd_rx[2] == (u8_t)(status >> 8));
+  fail_unless((u8_t)test_httpd_rx[3] == (u8_t)status);
+  fail_unless(test_httpd_rx_closed);
+  fail_unless(test_httpd_ws_conn == NULL);
+  fail_unless(test_httpd_ws_closed == 1);
+}
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
+/* Setups/teardown functions */
+
+static void
+httpd_setup(void)
+{
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+  httpd_init();
+#if LWIP_HTTPD_FILE_STATE
+  test_httpd_file_opens = 0;
+#endif /* LWIP_HTTPD_FILE_STATE */
+#if LWIP_HTTPD_WEBSOCKET
+  test_httpd_ws_conn = NULL;
+  test_httpd_ws_frames = 0;
+  test_httpd_ws_data_len = 0;
+  test_httpd_ws_closed = 0;
+#endif /* LWIP_HTTPD_WEBSOCKET */
+}
+
+static void
+httpd_teardown(void)
+{
+  test_httpd_client = NULL;
+  /* closes the httpd listener, too */
+  tcp_remove_all();
+  test_httpd_poll();
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* Test functions */
+
+START_TEST(test_httpd_get_file)
+{
+  const char *resp;
+  LWIP_UNUSED_ARG(_i);
+
+  resp = test_httpd_get("GET /test.txt HTTP/1.0\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "0123456789abcdefghijklmnopqrstuvwxyz");
+  fail_unless(strstr(resp, "\r\nContent-Type: text/plain\r\n") != NULL);
+  fail_unless(test_httpd_rx_closed);
+
+  resp = test_httpd_get("GET / HTTP/1.0\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "<html><body>index</body></html>");
+
+  resp = test_httpd_get("GET /missing.txt HTTP/1.0\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 404 File not found\r\n", "<html><body>404</body></html>");
+}
+END_TEST
+
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS && LWIP_HTTPD_DYNAMIC_HEADERS
+/** If-None-Match: strong and weak entity tags, lists and '*' */
+START_TEST(test_httpd_if_none_match)
+{
+  static const char *const match[] = {
+    "\"t1\"", "W/\"t1\"", "\"x\", \"t1\"", "\"x\",\"t1\" , \"y\"", "*", " \"t1\" "
+  };
+  static const char *const no_match[] = {
+    "\"t2\"", "t1", "\"t1", "\"x\", \"t11\"", "W/\"t\""
+  };
+  char req[128];
+  const char *resp;
+  size_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < LWIP_ARRAYSIZE(match); i++) {
+    test_httpd_file_opens = 0;
+    snprintf(req, sizeof(req), "GET /test.txt HTTP/1.0\r\nIf-None-Match: %s\r\n\r\n", match[i]);
+    resp = test_httpd_get(req);
+    test_httpd_check_response(resp, "HTTP/1.0 304 Not Modified\r\n", "");
+    fail_unless(strstr(resp, "\r\nETag: \"t1\"\r\n") != NULL);
+    fail_unless(strstr(resp, "Content-Length") == NULL);
+    /* answered from the validators in the file system */
+    fail_unless(test_httpd_file_opens == 0);
+  }
+  for (i = 0; i < LWIP_ARRAYSIZE(no_match); i++) {
+    test_httpd_file_opens = 0;
+    snprintf(req, sizeof(req), "GET /test.txt HTTP/1.0\r\nIf-None-Match: %s\r\n\r\n", no_match[i]);
+    resp = test_httpd_get(req);
+    test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "0123456789abcdefghijklmnopqrstuvwxyz");
+    fail_unless(strstr(resp, "\r\nETag: \"t1\"\r\n") != NULL);
+    fail_unless(test_httpd_file_opens == 1);
+  }
+
+  /* the weak comparison ignores "W/" on the entity tag of the file, too */
+  resp = test_httpd_get("GET /weak.txt HTTP/1.0\r\nIf-None-Match: \"w1\"\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 304 Not Modified\r\n", "");
+  fail_unless(strstr(resp, "\r\nETag: W/\"w1\"\r\n") != NULL);
+
+  /* files without validators are always sent */
+  resp = test_httpd_get("GET /img/sics.gif HTTP/1.0\r\nIf-None-Match: *\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "GIF89a");
+
+  /* the default file is checked after opening it */
+  test_httpd_file_opens = 0;
+  resp = test_httpd_get("GET / HTTP/1.0\r\nIf-None-Match: \"idx\"\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 304 Not Modified\r\n", "");
+  fail_unless(test_httpd_file_opens == 1);
+}
+END_TEST
+
+/** If-Modified-Since, and If-None-Match taking precedence over it */
+START_TEST(test_httpd_if_modified_since)
+{
+  const char *resp;
+  LWIP_UNUSED_ARG(_i);
+
+  resp = test_httpd_get("GET /test.txt HTTP/1.0\r\n"
+                        "If-Modified-Since: Sat, 01 Jan 2000 00:00:00 GMT\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 304 Not Modified\r\n", "");
+  fail_unless(strstr(resp, "\r\nLast-Modified: Sat, 01 Jan 2000 00:00:00 GMT\r\n") != NULL);
+  fail_unless(test_httpd_file_opens == 0);
+
+  resp = test_httpd_get("GET /test.txt HTTP/1.0\r\n"
+                        "If-Modified-Since: Sun, 02 Jan 2000 00:00:00 GMT\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "0123456789abcdefghijklmnopqrstuvwxyz");
+
+  resp = test_httpd_get("GET /test.txt HTTP/1.0\r\nIf-None-Match: \"t2\"\r\n"
+                        "If-Modified-Since: Sat, 01 Jan 2000 00:00:00 GMT\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "0123456789abcdefghijklmnopqrstuvwxyz");
+
+  /* no Last-Modified date */
+  resp = test_httpd_get("GET /weak.txt HTTP/1.0\r\n"
+                        "If-Modified-Since: Sat, 01 Jan 2000 00:00:00 GMT\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "weak");
+}
+END_TEST
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS && LWIP_HTTPD_DYNAMIC_HEADERS */
+
+#if LWIP_HTTPD_RANGE_REQUESTS && LWIP_HTTPD_DYNAMIC_HEADERS
+/** Range: single ranges (first-last, open-ended, suffix), ranges that are
+ * ignored (multiple ranges, invalid) and unsatisfiable ranges */
+START_TEST(test_httpd_range)
+{
+  static const struct {
+    const char *range;
+    const char *content_range;
+    const char *body;
+  } tests[] = {
+    { "bytes=0-9", "bytes 0-9/36", "0123456789" },
+    { "bytes=10-10", "bytes 10-10/36", "a" },
+    { "bytes=30-", "bytes 30-35/36", "uvwxyz" },
+    { "bytes=10-1000", "bytes 10-35/36", "abcdefghijklmnopqrstuvwxyz" },
+    { "bytes=-5", "bytes 31-35/36", "vwxyz" },
+    { "bytes=-100", "bytes 0-35/36", "0123456789abcdefghijklmnopqrstuvwxyz" },
+    { "bytes= 2 - 3", "bytes 2-3/36", "23" },
+    { "BYTES=35-35", "bytes 35-35/36", "z" },
+    /* not satisfiable */
+    { "bytes=36-", "bytes */36", "" },
+    { "bytes=99999999999-", "bytes */36", "" },
+    { "bytes=-0", "bytes */36", "" },
+    /* ignored */
+    { "bytes=0-1,5-6", NULL, "0123456789abcdefghijklmnopqrstuvwxyz" },
+    { "bytes=0-1, -3", NULL, "0123456789abcdefghijklmnopqrstuvwxyz" },
+    { "bytes=5-2", NULL, "0123456789abcdefghijklmnopqrstuvwxyz" },
+    { "bytes=-", NULL, "0123456789abcdefghijklmnopqrstuvwxyz" },
+    { "bytes=1", NULL, "0123456789abcdefghijklmnopqrstuvwxyz" },
+    { "bytes=a-b", NULL, "0123456789abcdefghijklmnopqrstuvwxyz" },
+    { "items=0-5", NULL, "0123456789abcdefghijklmnopqrstuvwxyz" }
+  };
+  char req[128], hdr[64];
+  const char *resp;
+  size_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < LWIP_ARRAYSIZE(tests); i++) {
+    snprintf(req, sizeof(req), "GET /test.txt HTTP/1.1\r\nRange: %s\r\n\r\n", tests[i].range);
+    resp = test_httpd_get(req);
+    if (tests[i].content_range == NULL) {
+      test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", tests[i].body);
+      fail_unless(strstr(resp, "Content-Range") == NULL);
+      continue;
+    }
+    if (tests[i].body[0] != 0) {
+      test_httpd_check_response(resp, "HTTP/1.1 206 Partial Content\r\n", tests[i].body);
+    } else {
+      test_httpd_check_response(resp, "HTTP/1.1 416 Range Not Satisfiable\r\n", "");
+    }
+    snprintf(hdr, sizeof(hdr), "\r\nContent-Range: %s\r\n", tests[i].content_range);
+    fail_unless(strstr(resp, hdr) != NULL, "range %s: %s", tests[i].range, resp);
+    snprintf(hdr, sizeof(hdr), "\r\nContent-Length: %d\r\n", (int)strlen(tests[i].body));
+    fail_unless(strstr(resp, hdr) != NULL, "range %s: %s", tests[i].range, resp);
+  }
+
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+  /* If-Range: the range is only sent if the file has not changed */
+  resp = test_httpd_get("GET /test.txt HTTP/1.1\r\nRange: bytes=0-1\r\nIf-Range: \"t1\"\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.1 206 Partial Content\r\n", "01");
+  resp = test_httpd_get("GET /test.txt HTTP/1.1\r\nRange: bytes=0-1\r\n"
+                        "If-Range: Sat, 01 Jan 2000 00:00:00 GMT\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.1 206 Partial Content\r\n", "01");
+  resp = test_httpd_get("GET /test.txt HTTP/1.1\r\nRange: bytes=0-1\r\nIf-Range: \"t2\"\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "0123456789abcdefghijklmnopqrstuvwxyz");
+  /* the weak entity tag cannot be used with If-Range */
+  resp = test_httpd_get("GET /weak.txt HTTP/1.1\r\nRange: bytes=0-1\r\nIf-Range: W/\"w1\"\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "weak");
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+}
+END_TEST
+#endif /* LWIP_HTTPD_RANGE_REQUESTS && LWIP_HTTPD_DYNAMIC_HEADERS */
+
+#if LWIP_HTTPD_PIPELINING && LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+/** Requests sent at once on a keep-alive connection are answered in order,
+ * including responses without body (304, 416) */
+START_TEST(test_httpd_pipelining)
+{
+  static const char requests[] =
+    "GET /test.txt HTTP/1.1\r\nConnection: keep-alive\r\n\r\n"
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+    "GET /test.txt HTTP/1.1\r\nConnection: keep-alive\r\nIf-None-Match: \"t1\"\r\n\r\n"
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+#if LWIP_HTTPD_RANGE_REQUESTS
+    "GET /test.txt HTTP/1.1\r\nConnection: keep-alive\r\nRange: bytes=100-\r\n\r\n"
+    "GET /test.txt HTTP/1.1\r\nConnection: keep-alive\r\nRange: bytes=-3\r\n\r\n"
+#endif /* LWIP_HTTPD_RANGE_REQUESTS */
+    "GET /missing.txt HTTP/1.1\r\nConnection: keep-alive\r\n\r\n"
+    "GET /weak.txt HTTP/1.1\r\n\r\n";
+  static const char *const responses[] = {
+    "HTTP/1.0 200 OK\r\n",
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+    "HTTP/1.0 304 Not Modified\r\n",
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+#if LWIP_HTTPD_RANGE_REQUESTS
+    "HTTP/1.1 416 Range Not Satisfiable\r\n",
+    "HTTP/1.1 206 Partial Content\r\n",
+#endif /* LWIP_HTTPD_RANGE_REQUESTS */
+    "HTTP/1.0 404 File not found\r\n",
+    "HTTP/1.0 200 OK\r\n"
+  };
+  const char *resp;
+  size_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  test_httpd_connect();
+  test_httpd_send(requests, (u16_t)(sizeof(requests) - 1));
+  /* the last request closes the connection */
+  fail_unless(test_httpd_rx_closed);
+  resp = test_httpd_rx;
+  for (i = 0; i < LWIP_ARRAYSIZE(responses); i++) {
+    fail_unless(!strncmp(resp, responses[i], strlen(responses[i])), "response %d: %s", (int)i, resp);
+    resp = strstr(resp, "\r\n\r\n");
+    fail_unless(resp != NULL);
+    resp += 4;
+    if (i == 0) {
+      fail_unless(!strncmp(resp, "0123456789abcdefghijklmnopqrstuvwxyz", 36));
+      resp += 36;
+#if LWIP_HTTPD_RANGE_REQUESTS
+    } else if (!strcmp(responses[i], "HTTP/1.1 206 Partial Content\r\n")) {
+      fail_unless(!strncmp(resp, "xyz", 3));
+      resp += 3;
+#endif /* LWIP_HTTPD_RANGE_REQUESTS */
+    } else if (!strcmp(responses[i], "HTTP/1.0 404 File not found\r\n")) {
+      fail_unless(!strncmp(resp, "<html><body>404</body></html>", 29));
+      resp += 29;
+    }
+  }
+  fail_unless(!strcmp(resp, "weak"), "rest: %s", resp);
+  test_httpd_disconnect();
+}
+END_TEST
+
+/** A request split over several segments while a response is being sent */
+START_TEST(test_httpd_pipelining_split)
+{
+  static const char requests[] =
+    "GET /img/sics.gif HTTP/1.1\r\nConnection: keep-alive\r\n\r\nGET /weak";
+  const char *resp;
+  LWIP_UNUSED_ARG(_i);
+
+  test_httpd_connect();
+  test_httpd_send(requests, (u16_t)(sizeof(requests) - 1));
+  fail_unless(!test_httpd_rx_closed, "response: %s", test_httpd_rx);
+  resp = strstr(test_httpd_rx, "\r\n\r\nGIF89a");
+  fail_unless(resp != NULL);
+  fail_unless(resp[10] == 0);
+  test_httpd_send(".txt HTTP/1.1\r\nConnection: keep-alive\r\n\r\n", 41);
+  fail_unless(!test_httpd_rx_closed);
+  resp = strstr(resp + 10, "\r\n\r\nweak");
+  fail_unless(resp != NULL, "response: %s", test_httpd_rx);
+  fail_unless(resp[8] == 0);
+  test_httpd_disconnect();
+}
+END_TEST
+#endif /* LWIP_HTTPD_PIPELINING && LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+
+#if LWIP_HTTPD_CONTENT_ENCODING && LWIP_HTTPD_DYNAMIC_HEADERS
+/** Accept-Encoding: q-values, '*' and identity select the variant sent */
+START_TEST(test_httpd_accept_encoding)
+{
+  static const struct {
+    const char *accept_encoding;
+    const char *body;
+  } tests[] = {
+    { "gzip", "gzip" },
+    { "GZip", "gzip" },
+    { "gzip, br", "brotli" },
+    { "gzip, deflate, br", "brotli" },
+    { "br;q=0, gzip", "gzip" },
+    { "br;q=0.000,gzip;q=0.5", "gzip" },
+    { "br ; q=0 , gzip", "gzip" },
+    { "br;q=0.001", "brotli" },
+    { "gzip;q=0", "<html><body>plain</body></html>" },
+    { "identity", "<html><body>plain</body></html>" },
+    { "identity, gzip;q=0.1", "gzip" },
+    { "deflate", "<html><body>plain</body></html>" },
+    { "*", "brotli" },
+    { "*, br;q=0", "gzip" },
+    { "gzip;q=0, *", "brotli" },
+    { "*;q=0", "<html><body>plain</body></html>" },
+    { "*;q=0, gzip", "gzip" },
+    { "", "<html><body>plain</body></html>" }
+  };
+  char req[128];
+  const char *resp;
+  size_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < LWIP_ARRAYSIZE(tests); i++) {
+    snprintf(req, sizeof(req), "GET /enc.html HTTP/1.0\r\nAccept-Encoding: %s\r\n\r\n",
+             tests[i].accept_encoding);
+    resp = test_httpd_get(req);
+    test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", tests[i].body);
+    fail_unless(strstr(resp, "\r\nVary: Accept-Encoding\r\n") != NULL);
+    fail_unless(strstr(resp, "\r\nContent-Type: text/html\r\n") != NULL);
+    if (!strcmp(tests[i].body, "gzip")) {
+      fail_unless(strstr(resp, "\r\nContent-Encoding: gzip\r\n") != NULL);
+    } else if (!strcmp(tests[i].body, "brotli")) {
+      fail_unless(strstr(resp, "\r\nContent-Encoding: br\r\n") != NULL);
+    } else {
+      fail_unless(strstr(resp, "Content-Encoding") == NULL, "response: %s", resp);
+    }
+  }
+
+  /* no Accept-Encoding header */
+  resp = test_httpd_get("GET /enc.html HTTP/1.0\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "<html><body>plain</body></html>");
+  fail_unless(strstr(resp, "\r\nVary: Accept-Encoding\r\n") != NULL);
+
+  /* files without variants are sent unchanged and without "Vary" */
+  resp = test_httpd_get("GET /test.txt HTTP/1.0\r\nAccept-Encoding: gzip, br\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "0123456789abcdefghijklmnopqrstuvwxyz");
+  fail_unless(strstr(resp, "Vary") == NULL);
+  fail_unless(strstr(resp, "Content-Encoding") == NULL);
+}
+END_TEST
+
+/** Variants are not found by their own name */
+START_TEST(test_httpd_encoding_variants_hidden)
+{
+  const char *resp;
+  LWIP_UNUSED_ARG(_i);
+
+  resp = test_httpd_get("GET /enc.html.gz HTTP/1.0\r\nAccept-Encoding: gzip\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 404 File not found\r\n", "<html><body>404</body></html>");
+  resp = test_httpd_get("GET /enc.html.br HTTP/1.0\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 404 File not found\r\n", "<html><body>404</body></html>");
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+  resp = test_httpd_get("GET /enc.html.gz HTTP/1.0\r\nIf-None-Match: \"enc-gz\"\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 404 File not found\r\n", "<html><body>404</body></html>");
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+}
+END_TEST
+
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+/** Each variant has its own entity tag */
+START_TEST(test_httpd_encoding_not_modified)
+{
+  const char *resp;
+  LWIP_UNUSED_ARG(_i);
+
+  resp = test_httpd_get("GET /enc.html HTTP/1.0\r\nAccept-Encoding: gzip\r\n"
+                        "If-None-Match: \"enc-gz\"\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 304 Not Modified\r\n", "");
+  fail_unless(strstr(resp, "\r\nETag: \"enc-gz\"\r\n") != NULL);
+  fail_unless(strstr(resp, "\r\nVary: Accept-Encoding\r\n") != NULL);
+  fail_unless(strstr(resp, "Content-Encoding") == NULL);
+  fail_unless(test_httpd_file_opens == 0);
+
+  resp = test_httpd_get("GET /enc.html HTTP/1.0\r\nAccept-Encoding: br\r\n"
+                        "If-None-Match: \"enc-gz\"\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "brotli");
+  fail_unless(strstr(resp, "\r\nETag: \"enc-br\"\r\n") != NULL);
+
+  resp = test_httpd_get("GET /enc.html HTTP/1.0\r\nIf-None-Match: \"enc\"\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 304 Not Modified\r\n", "");
+  fail_unless(strstr(resp, "\r\nETag: \"enc\"\r\n") != NULL);
+  fail_unless(strstr(resp, "\r\nVary: Accept-Encoding\r\n") != NULL);
+}
+END_TEST
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+#endif /* LWIP_HTTPD_CONTENT_ENCODING && LWIP_HTTPD_DYNAMIC_HEADERS */
+
+#if LWIP_HTTPD_WEBSOCKET
+/** Opening handshake: accept key, bad and denied upgrade requests */
+START_TEST(test_httpd_ws_handshake)
+{
+  const char *resp;
+  LWIP_UNUSED_ARG(_i);
+
+  /* example from RFC 6455 */
+  test_httpd_connect();
+  test_httpd_send(test_httpd_ws_request, sizeof(test_httpd_ws_request) - 1);
+  fail_unless(!strncmp(test_httpd_rx, "HTTP/1.1 101 Switching Protocols\r\n", 34), "response: %s", test_httpd_rx);
+  fail_unless(strstr(test_httpd_rx, "\r\nSec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") != NULL);
+  fail_unless(strstr(test_httpd_rx, "\r\nUpgrade: websocket\r\n") != NULL);
+  fail_unless(test_httpd_ws_conn != NULL);
+  fail_unless(!test_httpd_rx_closed);
+  test_httpd_disconnect();
+  fail_unless(test_httpd_ws_conn == NULL);
+  fail_unless(test_httpd_ws_closed == 1);
+
+  /* unsupported version: bad request (closed as there is no 400 page) */
+  resp = test_httpd_get("GET /ws HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 8\r\n\r\n");
+  fail_unless(resp[0] == 0, "response: %s", resp);
+  fail_unless(test_httpd_rx_closed);
+  fail_unless(test_httpd_ws_closed == 1);
+
+  /* denied by the application: normal GET request */
+  resp = test_httpd_get("GET /test.txt HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+  test_httpd_check_response(resp, "HTTP/1.0 200 OK\r\n", "0123456789abcdefghijklmnopqrstuvwxyz");
+  fail_unless(test_httpd_ws_closed == 1);
+}
+END_TEST
+
+/** Upgrade after a response on the same connection that has not been
+ * acknowledged yet */
+START_TEST(test_httpd_ws_upgrade_keepalive)
+{
+  static const char req[] = "GET /test.txt HTTP/1.1\r\nConnection: keep-alive\r\n\r\n";
+  char both[sizeof(req) + sizeof(test_httpd_ws_request)];
+  struct pbuf *p;
+  const char *resp2;
+  LWIP_UNUSED_ARG(_i);
+
+  memcpy(both, req, sizeof(req) - 1);
+  memcpy(&both[sizeof(req) - 1], test_httpd_ws_request, sizeof(test_httpd_ws_request));
+  test_httpd_connect();
+  test_httpd_send(both, (u16_t)strlen(both));
+  fail_unless(!strncmp(test_httpd_rx, "HTTP/1.0 200 OK\r\n", 17), "response: %s", test_httpd_rx);
+  resp2 = strstr(test_httpd_rx, "0123456789abcdefghijklmnopqrstuvwxyz");
+  fail_unless(resp2 != NULL);
+  resp2 += 36;
+  fail_unless(!strncmp(resp2, "HTTP/1.1 101 ", 13), "response: %s", resp2);
+  fail_unless(test_httpd_ws_conn != NULL);
+
+  /* the WebSocket data is freed when acknowledged, not the HTTP response */
+  test_httpd_rx_len = 0;
+  p = httpd_websocket_alloc(5);
+  fail_unless(p != NULL);
+  memcpy(p->payload, "hello", 5);
+  fail_unless(httpd_websocket_send(test_httpd_ws_conn, HTTPD_WEBSOCKET_TEXT, p) == ERR_OK);
+  test_httpd_poll();
+  fail_unless(test_httpd_rx_len == 7);
+  fail_unless(!memcmp(test_httpd_rx, "\x81\x05hello", 7));
+  test_httpd_disconnect();
+}
+END_TEST
+
+/** Unmasking of frames split across segments, several frames per segment and
+ * frames with a 16 bit length */
+START_TEST(test_httpd_ws_masking)
+{
+  u8_t buf[600];
+  char data[300];
+  u16_t len, len2, i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < sizeof(data); i++) {
+    data[i] = (char)('a' + (i % 26));
+  }
+  test_httpd_ws_open();
+
+  /* one frame in two segments */
+  len = test_httpd_ws_frame(buf, HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_TEXT, "Hello", 5);
+  test_httpd_send((const char *)buf, 4);
+  fail_unless(test_httpd_ws_frames == 0);
+  test_httpd_send((const char *)&buf[4], (u16_t)(len - 4));
+  fail_unless(test_httpd_ws_frames == 1);
+  fail_unless(test_httpd_ws_opcodes[0] == (HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_TEXT));
+  fail_unless(test_httpd_ws_data_len == 5);
+  fail_unless(!memcmp(test_httpd_ws_data, "Hello", 5));
+
+  /* two frames (one with a 16 bit length) in one segment */
+  len = test_httpd_ws_frame(buf, HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_BINARY, data, 300);
+  len2 = test_httpd_ws_frame(&buf[len], HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_TEXT, "!", 1);
+  test_httpd_send((const char *)buf, (u16_t)(len + len2));
+  fail_unless(test_httpd_ws_frames == 3);
+  fail_unless(test_httpd_ws_opcodes[1] == (HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_BINARY));
+  fail_unless(test_httpd_ws_opcodes[2] == (HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_TEXT));
+  fail_unless(test_httpd_ws_data_len == 306);
+  fail_unless(!memcmp(&test_httpd_ws_data[5], data, 300));
+  fail_unless(test_httpd_ws_data[305] == '!');
+  fail_unless(test_httpd_rx_len == 0);
+
+  /* frames from the client must be masked */
+  buf[0] = HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_TEXT;
+  buf[1] = 1;
+  buf[2] = 'x';
+  test_httpd_send((const char *)buf, 3);
+  test_httpd_ws_check_closed(1002);
+  fail_unless(test_httpd_ws_frames == 3);
+  test_httpd_disconnect();
+
+  /* too long */
+  test_httpd_ws_closed = 0;
+  test_httpd_ws_open();
+  buf[0] = HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_BINARY;
+  buf[1] = 0x80 | 126;
+  buf[2] = 0x13;
+  buf[3] = 0x88;
+  test_httpd_send((const char *)buf, 4);
+  test_httpd_ws_check_closed(1009);
+  test_httpd_disconnect();
+}
+END_TEST
+
+/** Fragmented messages with an interleaved ping, invalid continuations */
+START_TEST(test_httpd_ws_fragmentation)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  test_httpd_ws_open();
+  test_httpd_ws_send(HTTPD_WEBSOCKET_TEXT, "Hel", 3);
+  test_httpd_ws_send(HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_PING, "p", 1);
+  /* pong with the same payload */
+  fail_unless(test_httpd_rx_len == 3);
+  fail_unless(!memcmp(test_httpd_rx, "\x8a\x01p", 3));
+  test_httpd_ws_send(HTTPD_WEBSOCKET_CONTINUATION, "l", 1);
+  test_httpd_ws_send(HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_CONTINUATION, "o", 1);
+  fail_unless(test_httpd_ws_frames == 3);
+  fail_unless(test_httpd_ws_opcodes[0] == HTTPD_WEBSOCKET_TEXT);
+  fail_unless(test_httpd_ws_opcodes[1] == HTTPD_WEBSOCKET_CONTINUATION);
+  fail_unless(test_httpd_ws_opcodes[2] == (HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_CONTINUATION));
+  fail_unless(test_httpd_ws_data_len == 5);
+  fail_unless(!memcmp(test_httpd_ws_data, "Hello", 5));
+
+  /* continuation without a message started */
+  test_httpd_rx_len = 0;
+  test_httpd_ws_send(HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_CONTINUATION, "x", 1);
+  test_httpd_ws_check_closed(1002);
+  fail_unless(test_httpd_ws_frames == 3);
+  test_httpd_disconnect();
+
+  /* new message before the last one has been finished */
+  test_httpd_ws_closed = 0;
+  test_httpd_ws_frames = 0;
+  test_httpd_ws_open();
+  test_httpd_ws_send(HTTPD_WEBSOCKET_BINARY, "a", 1);
+  test_httpd_ws_send(HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_BINARY, "b", 1);
+  test_httpd_ws_check_closed(1002);
+  fail_unless(test_httpd_ws_frames == 1);
+  test_httpd_disconnect();
+
+  /* fragmented control frame */
+  test_httpd_ws_closed = 0;
+  test_httpd_ws_open();
+  test_httpd_ws_send(HTTPD_WEBSOCKET_PING, "p", 1);
+  test_httpd_ws_check_closed(1002);
+  test_httpd_disconnect();
+}
+END_TEST
+
+/** Many frames (some without payload) in one segment */
+START_TEST(test_httpd_ws_many_frames)
+{
+  u8_t buf[400];
+  u16_t len = 0, i;
+  LWIP_UNUSED_ARG(_i);
+
+  test_httpd_ws_open();
+  for (i = 0; i < 40; i++) {
+    char c = (char)('a' + (i % 26));
+    if (i % 8 == 7) {
+      len = (u16_t)(len + test_httpd_ws_frame(&buf[len], HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_BINARY, NULL, 0));
+    } else {
+      len = (u16_t)(len + test_httpd_ws_frame(&buf[len], HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_BINARY, &c, 1));
+    }
+  }
+  fail_unless(len <= sizeof(buf));
+  test_httpd_send((const char *)buf, len);
+  fail_unless(test_httpd_ws_frames == 40);
+  fail_unless(test_httpd_ws_data_len == 35);
+  for (i = 0; i < 40; i++) {
+    if (i % 8 != 7) {
+      fail_unless(test_httpd_ws_data[i - i / 8] == (char)('a' + (i % 26)));
+    }
+  }
+  fail_unless(test_httpd_rx_len == 0);
+  test_httpd_disconnect();
+}
+END_TEST
+
+/** Text messages must be valid UTF-8, also across continuation frames */
+START_TEST(test_httpd_ws_utf8)
+{
+  static const char *const invalid[] = {
+    "\xc0\xaf",         /* overlong */
+    "\xe0\x80\xaf",     /* overlong */
+    "\xed\xa0\x80",     /* surrogate */
+    "\xf4\x90\x80\x80", /* above U+10FFFF */
+    "a\xff",
+    "\x80",
+    "\xe2\x82"          /* incomplete */
+  };
+  size_t k;
+  LWIP_UNUSED_ARG(_i);
+
+  test_httpd_ws_open();
+  test_httpd_ws_send(HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_TEXT, "h\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80", 10);
+  /* a character split across frames */
+  test_httpd_ws_send(HTTPD_WEBSOCKET_TEXT, "\xf0\x9f", 2);
+  test_httpd_ws_send(HTTPD_WEBSOCKET_CONTINUATION, "\x98", 1);
+  test_httpd_ws_send(HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_CONTINUATION, "\x80", 1);
+  /* binary messages are not checked */
+  test_httpd_ws_send(HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_BINARY, "\xff", 1);
+  fail_unless(test_httpd_ws_frames == 5);
+  fail_unless(test_httpd_ws_data_len == 15);
+  fail_unless(test_httpd_rx_len == 0);
+  test_httpd_disconnect();
+
+  for (k = 0; k < LWIP_ARRAYSIZE(invalid); k++) {
+    test_httpd_ws_closed = 0;
+    test_httpd_ws_frames = 0;
+    test_httpd_ws_open();
+    test_httpd_ws_send(HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_TEXT, invalid[k], (u16_t)strlen(invalid[k]));
+    test_httpd_ws_check_closed(1007);
+    fail_unless(test_httpd_ws_frames == 0);
+    test_httpd_disconnect();
+  }
+
+  /* in a continuation frame */
+  test_httpd_ws_closed = 0;
+  test_httpd_ws_frames = 0;
+  test_httpd_ws_open();
+  test_httpd_ws_send(HTTPD_WEBSOCKET_TEXT, "a\xe2", 2);
+  test_httpd_ws_send(HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_CONTINUATION, "\x82x", 2);
+  test_httpd_ws_check_closed(1007);
+  fail_unless(test_httpd_ws_frames == 1);
+  test_httpd_disconnect();
+}
+END_TEST
+
+/** Closing handshake initiated by either side, close while data is not
+ * acknowledged yet */
+START_TEST(test_httpd_ws_close)
+{
+  static const char status[2] = {0x03, (char)0xe8};
+  struct pbuf *p;
+  LWIP_UNUSED_ARG(_i);
+
+  /* by the client: the status is echoed */
+  test_httpd_ws_open();
+  test_httpd_ws_send(HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_CLOSE, status, 2);
+  test_httpd_ws_check_closed(1000);
+  test_httpd_disconnect();
+
+  /* by the server: closed when the client has answered */
+  test_httpd_ws_closed = 0;
+  test_httpd_ws_open();
+  fail_unless(httpd_websocket_close(test_httpd_ws_conn, 1001) == ERR_OK);
+  test_httpd_poll();
+  fail_unless(test_httpd_rx_len == 4);
+  fail_unless(!memcmp(test_httpd_rx, "\x88\x02\x03\xe9", 4));
+  fail_unless(!test_httpd_rx_closed);
+  fail_unless(httpd_websocket_send(test_httpd_ws_conn, HTTPD_WEBSOCKET_TEXT, NULL) == ERR_CONN);
+  test_httpd_rx_len = 0;
+  test_httpd_ws_send(HTTPD_WEBSOCKET_FIN | HTTPD_WEBSOCKET_CLOSE, NULL, 0);
+  fail_unless(test_httpd_rx_len == 0);
+  fail_unless(test_httpd_rx_closed);
+  fail_unless(test_httpd_ws_conn == NULL);
+  fail_unless(test_httpd_ws_closed == 1);
+  test_httpd_disconnect();
+
+  /* by the client closing TCP while data is in flight: the data is still
+     delivered and the connection is closed gracefully (no RST) */
+  test_httpd_ws_closed = 0;
+  test_httpd_ws_open();
+  p = httpd_websocket_alloc(3);
+  fail_unless(p != NULL);
+  memcpy(p->payload, "bye", 3);
+  fail_unless(httpd_websocket_send(test_httpd_ws_conn, HTTPD_WEBSOCKET_TEXT, p) == ERR_OK);
+  fail_unless(tcp_shutdown(test_httpd_client, 0, 1) == ERR_OK);
+  test_httpd_poll();
+  fail_unless(test_httpd_client != NULL);
+  fail_unless(test_httpd_rx_len == 5);
+  fail_unless(!memcmp(test_httpd_rx, "\x81\x03" "bye", 5));
+  fail_unless(test_httpd_rx_closed);
+  fail_unless(test_httpd_ws_closed == 1);
+  test_httpd_disconnect();
+}
+END_TEST
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
+/** Create the suite including all tests for this module */
+Suite *
+httpd_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_httpd_get_file),
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS && LWIP_HTTPD_DYNAMIC_HEADERS
+    TESTFUNC(test_httpd_if_none_match),
+    TESTFUNC(test_httpd_if_modified_since),
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS && LWIP_HTTPD_DYNAMIC_HEADERS */
+#if LWIP_HTTPD_RANGE_REQUESTS && LWIP_HTTPD_DYNAMIC_HEADERS
+    TESTFUNC(test_httpd_range),
+#endif /* LWIP_HTTPD_RANGE_REQUESTS && LWIP_HTTPD_DYNAMIC_HEADERS */
+#if LWIP_HTTPD_PIPELINING && LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+    TESTFUNC(test_httpd_pipelining),
+    TESTFUNC(test_httpd_pipelining_split),
+#endif /* LWIP_HTTPD_PIPELINING && LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_CONTENT_ENCODING && LWIP_HTTPD_DYNAMIC_HEADERS
+    TESTFUNC(test_httpd_accept_encoding),
+    TESTFUNC(test_httpd_encoding_variants_hidden),
+#if LWIP_HTTPD_CONDITIONAL_REQUESTS
+    TESTFUNC(test_httpd_encoding_not_modified),
+#endif /* LWIP_HTTPD_CONDITIONAL_REQUESTS */
+#endif /* LWIP_HTTPD_CONTENT_ENCODING && LWIP_HTTPD_DYNAMIC_HEADERS */
+#if LWIP_HTTPD_WEBSOCKET
+    TESTFUNC(test_httpd_ws_handshake),
+    TESTFUNC(test_httpd_ws_upgrade_keepalive),
+    TESTFUNC(test_httpd_ws_masking),
+    TESTFUNC(test_httpd_ws_fragmentation),
+    TESTFUNC(test_httpd_ws_many_frames),
+    TESTFUNC(test_httpd_ws_utf8),
+    TESTFUNC(test_httpd_ws_close),
+#endif /* LWIP_HTTPD_WEBSOCKET */
+  };
+  return create_suite("HTTPD", tests, sizeof(tests)/sizeof(testfunc), httpd_setup, httpd_teardown);
+}
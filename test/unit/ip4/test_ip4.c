@@ -2,6 +2,10 @@
 
 #include "lwip/icmp.h"
 #include "lwip/ip4.h"
+#include "lwip/ip4_fib.h"
+#include "lwip/ip4_frag.h"
+#include "lwip/ip4_mroute.h"
+#include "lwip/igmp.h"
 #include "lwip/etharp.h"
 #include "lwip/inet_chksum.h"
 #include "lwip/stats.h"
@@ -71,7 +75,7 @@ test_netif_remove(void)
 
 /* Helper functions */
 static void
-create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
+create_ip4_input_fragment_from(u8_t src_offset, u16_t ip_id, u16_t start, u16_t len, int last)
 {
   struct pbuf *p;
   struct netif *input_netif = netif_list; /* just use any netif */
@@ -97,7 +101,7 @@ create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
     IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
     IPH_CHKSUM_SET(iphdr, 0);
     ip4_addr_copy(iphdr->src, *netif_ip4_addr(input_netif));
-    iphdr->src.addr = lwip_htonl(lwip_htonl(iphdr->src.addr) + 1);
+    iphdr->src.addr = lwip_htonl(lwip_htonl(iphdr->src.addr) + src_offset);
     ip4_addr_copy(iphdr->dest, *netif_ip4_addr(input_netif));
     IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, sizeof(struct ip_hdr)));
 
@@ -109,6 +113,12 @@ create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
   }
 }
 
+static void
+create_ip4_input_fragment(u16_t ip_id, u16_t start, u16_t len, int last)
+{
+  create_ip4_input_fragment_from(1, ip_id, start, len, last);
+}
+
 static err_t arpless_output(struct netif *netif, struct pbuf *p,
                             const ip4_addr_t *ipaddr) {
   LWIP_UNUSED_ARG(ipaddr);
@@ -163,6 +173,38 @@ START_TEST(test_ip4_frag)
 }
 END_TEST
 
+#if LWIP_NETIF_FRAG_OFFLOAD
+static err_t
+frag_offload_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  struct ip_frag_desc desc;
+  u32_t hdr_buf[IP_HLEN / 4];
+  u8_t *hdr = (u8_t *)hdr_buf;
+  struct ip_hdr *iphdr = (struct ip_hdr *)hdr_buf;
+  u16_t offset, len;
+
+  fail_unless(netif == &test_netif);
+  fail_unless(ip_frag_offload_desc(p, 0, &desc) == ERR_OK);
+  fail_unless(desc.ip_version == 4);
+  fail_unless(desc.hdr_len == IP_HLEN);
+  fail_unless(desc.frag_size == ((netif->mtu - IP_HLEN) & ~7));
+  fail_unless(desc.hdr_len + desc.data_len == p->tot_len);
+
+  for (offset = 0; offset < desc.data_len; offset = (u16_t)(offset + len)) {
+    len = LWIP_MIN(desc.frag_size, (u16_t)(desc.data_len - offset));
+    fail_unless(pbuf_copy_partial(p, hdr, desc.hdr_len, 0) == desc.hdr_len);
+    ip_frag_offload_hdr(netif, &desc, hdr, offset, len);
+    fail_unless(lwip_ntohs(IPH_LEN(iphdr)) == IP_HLEN + len);
+    fail_unless(IPH_OFFSET_BYTES(iphdr) == offset);
+    fail_unless(((IPH_OFFSET(iphdr) & PP_HTONS(IP_MF)) != 0) == (offset + len < desc.data_len));
+    fail_unless(inet_chksum(iphdr, IP_HLEN) == 0);
+    linkoutput_ctr++;
+    linkoutput_byte_ctr += IP_HLEN + len;
+  }
+  return ERR_OK;
+}
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
+
 START_TEST(test_ip4_reass)
 {
   const u16_t ip_id = 128;
@@ -235,6 +277,104 @@ START_TEST(test_ip4_reass)
 }
 END_TEST
 
+START_TEST(test_ip4_reass_tree)
+{
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&lwip_stats.ip_frag, 0, sizeof(lwip_stats.ip_frag));
+  memset(&lwip_stats.mib2, 0, sizeof(lwip_stats.mib2));
+
+  /* out of order, with a duplicate, an overlapping fragment and a fragment
+     beyond the end of the datagram */
+  create_ip4_input_fragment(300, 16, 16, 0);
+  create_ip4_input_fragment(300, 16, 16, 0);
+  fail_unless(lwip_stats.ip_frag.drop == 1);
+  create_ip4_input_fragment(300, 24, 16, 0);
+  fail_unless(lwip_stats.ip_frag.drop == 2);
+  create_ip4_input_fragment(300, 32, 16, 1);
+  create_ip4_input_fragment(300, 48, 8, 0);
+  fail_unless(lwip_stats.ip_frag.drop == 3);
+  create_ip4_input_fragment(300, 8, 8, 0);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 0);
+  create_ip4_input_fragment(300, 0, 8, 0);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 1);
+  fail_unless(lwip_stats.ip_frag.drop == 3);
+
+  /* a second last fragment with a different length is dropped */
+  create_ip4_input_fragment(301, 32, 8, 1);
+  create_ip4_input_fragment(301, 40, 8, 1);
+  fail_unless(lwip_stats.ip_frag.drop == 4);
+  /* so is data beyond the end */
+  create_ip4_input_fragment(301, 40, 8, 0);
+  fail_unless(lwip_stats.ip_frag.drop == 5);
+  create_ip4_input_fragment(301, 8, 24, 0);
+  create_ip4_input_fragment(301, 0, 8, 0);
+  fail_unless(lwip_stats.mib2.ipreasmoks == 2);
+
+  /* fill the reassembly buffer from one source */
+  for (i = 0; i < IP_REASS_MAX_PBUFS_PER_SOURCE; i++) {
+    create_ip4_input_fragment((u16_t)(310 + (i & 1)), (u16_t)(8 + 8 * (i / 2)), 8, 0);
+  }
+  fail_unless(lwip_stats.ip_frag.memerr == 0);
+  /* this source may not enqueue more, not even by freeing its oldest datagram */
+  create_ip4_input_fragment(312, 8, 8, 0);
+  fail_unless(lwip_stats.ip_frag.memerr == 1);
+  fail_unless(lwip_stats.mib2.ipreasmfails == 0);
+#if IP_REASS_MAX_PBUFS_PER_SOURCE >= IP_REASS_MAX_PBUFS
+  /* another source may (dropping one of the old datagrams) */
+  create_ip4_input_fragment_from(2, 312, 8, 8, 0);
+  fail_unless(lwip_stats.ip_frag.memerr == 1);
+  fail_unless(lwip_stats.mib2.ipreasmfails == 1);
+#endif
+
+  /* time out the rest */
+  for (i = 0; i <= IP_REASS_MAXAGE; i++) {
+    ip_reass_tmr();
+  }
+  fail_unless(lwip_stats.mib2.ipreasmoks == 2);
+}
+END_TEST
+
+#if LWIP_NETIF_FRAG_OFFLOAD
+START_TEST(test_ip4_frag_offload)
+{
+  struct pbuf *data = pbuf_alloc(PBUF_IP, 8000, PBUF_RAM);
+  ip_addr_t peer_ip = IPADDR4_INIT_BYTES(192,168,0,5);
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  linkoutput_ctr = 0;
+  linkoutput_byte_ctr = 0;
+
+  /* The whole packet is passed to the netif, which creates the same six
+     fragments as ip4_frag() */
+  fail_unless(data != NULL);
+  test_netif_add();
+  test_netif.output = arpless_output;
+  test_netif.linkoutput = frag_offload_linkoutput;
+  NETIF_SET_FRAG_OFFLOAD(&test_netif, NETIF_FRAG_OFFLOAD_IP4);
+  err = ip4_output_if_src(data, &test_ipaddr, ip_2_ip4(&peer_ip),
+                          16, 0, IP_PROTO_UDP, &test_netif);
+  fail_unless(err == ERR_OK);
+  fail_unless(linkoutput_ctr == 6);
+  fail_unless(linkoutput_byte_ctr == (8000 + (6 * IP_HLEN)));
+  fail_unless(data->frag_size != 0);
+
+  /* A packet that fits is not marked for fragmentation */
+  pbuf_realloc(data, 1000);
+  test_netif.linkoutput = test_netif_linkoutput;
+  err = ip4_output_if_src(data, &test_ipaddr, ip_2_ip4(&peer_ip),
+                          16, 0, IP_PROTO_UDP, &test_netif);
+  fail_unless(err == ERR_OK);
+  fail_unless(linkoutput_ctr == 7);
+  fail_unless(data->frag_size == 0);
+  pbuf_free(data);
+  test_netif_remove();
+}
+END_TEST
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
+
 /* packets to 127.0.0.1 shall not be sent out to netif_default */
 START_TEST(test_127_0_0_1)
 {
@@ -327,17 +467,539 @@ START_TEST(test_ip4_icmp_replylen_first_8)
 }
 END_TEST
 
+#if LWIP_IPV4_FIB
+static err_t
+test_netif2_init(struct netif *netif)
+{
+  fail_unless(netif != NULL);
+  netif->output = arpless_output;
+  netif->mtu = 1500;
+  netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_LINK_UP;
+  return ERR_OK;
+}
+
+START_TEST(test_ip4_fib)
+{
+  struct netif netif2;
+  ip4_addr_t addr, mask, gw, dest;
+  const struct ip4_fib_entry *route;
+  struct pbuf *p;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_netif_add();
+  memset(&netif2, 0, sizeof(netif2));
+  IP4_ADDR(&addr, 172,16,0,1);
+  IP4_ADDR(&mask, 255,255,0,0);
+  IP4_ADDR(&gw, 172,16,0,254);
+  fail_unless(netif_add(&netif2, &addr, &mask, &gw, NULL, test_netif2_init, NULL) == &netif2);
+  netif_set_up(&netif2);
+
+  IP4_ADDR(&addr, 10,0,0,0);
+  IP4_ADDR(&gw, 192,168,0,2);
+  err = ip4_fib_add(&addr, 8, &gw, &test_netif);
+  fail_unless(err == ERR_OK);
+  IP4_ADDR(&addr, 10,1,0,0);
+  IP4_ADDR(&gw, 192,168,0,3);
+  err = ip4_fib_add(&addr, 16, &gw, &test_netif);
+  fail_unless(err == ERR_OK);
+  IP4_ADDR(&addr, 10,1,2,0);
+  err = ip4_fib_add(&addr, 24, NULL, &test_netif);
+  fail_unless(err == ERR_OK);
+  IP4_ADDR(&addr, 10,128,0,0);
+  IP4_ADDR(&gw, 172,16,0,2);
+  err = ip4_fib_add(&addr, 9, &gw, &netif2);
+  fail_unless(err == ERR_OK);
+  IP4_ADDR(&addr, 192,168,5,0);
+  err = ip4_fib_add(&addr, 24, &gw, &netif2);
+  fail_unless(err == ERR_OK);
+  /* duplicate prefix */
+  err = ip4_fib_add(&addr, 24, &gw, &netif2);
+  fail_unless(err == ERR_USE);
+#if !LWIP_FIB_ECMP
+  err = ip4_fib_add(&addr, 24, &gw, &test_netif);
+  fail_unless(err == ERR_USE);
+#endif /* !LWIP_FIB_ECMP */
+  /* host bits set */
+  IP4_ADDR(&addr, 10,1,2,1);
+  err = ip4_fib_add(&addr, 24, &gw, &test_netif);
+  fail_unless(err == ERR_VAL);
+
+  /* longest prefix match */
+  IP4_ADDR(&dest, 10,9,9,9);
+  route = ip4_fib_lookup(&dest);
+  fail_unless((route != NULL) && (route->prefix_len == 8));
+  IP4_ADDR(&dest, 10,1,9,9);
+  route = ip4_fib_lookup(&dest);
+  fail_unless((route != NULL) && (route->prefix_len == 16));
+  IP4_ADDR(&dest, 10,1,2,3);
+  route = ip4_fib_lookup(&dest);
+  fail_unless((route != NULL) && (route->prefix_len == 24));
+  IP4_ADDR(&dest, 10,200,0,1);
+  route = ip4_fib_lookup(&dest);
+  fail_unless((route != NULL) && (route->netif == &netif2));
+  IP4_ADDR(&dest, 11,0,0,1);
+  fail_unless(ip4_fib_lookup(&dest) == NULL);
+
+  /* a more specific route wins over a netif subnet, a less specific one doesn't */
+  IP4_ADDR(&dest, 192,168,5,1);
+  fail_unless(ip4_route(&dest) == &netif2);
+  IP4_ADDR(&dest, 192,168,6,1);
+  fail_unless(ip4_route(&dest) == &test_netif);
+  IP4_ADDR(&dest, 10,200,0,1);
+  fail_unless(ip4_route(&dest) == &netif2);
+
+  /* routes via a netif that is down are skipped */
+  netif_set_down(&netif2);
+  fail_unless(ip4_fib_lookup(&dest) != NULL);
+  fail_unless(ip4_fib_lookup(&dest)->prefix_len == 8);
+  netif_set_up(&netif2);
+
+  /* next hops */
+  IP4_ADDR(&dest, 10,1,9,9);
+  IP4_ADDR(&gw, 192,168,0,3);
+  fail_unless(ip4_addr_eq(ip4_fib_next_hop(&dest, &test_netif), &gw));
+  IP4_ADDR(&dest, 10,1,2,3);
+  fail_unless(ip4_fib_next_hop(&dest, &test_netif) == &dest);
+  fail_unless(ip4_fib_next_hop(&dest, &netif2) == NULL);
+
+  /* etharp_output resolves the gateway of the route */
+  linkoutput_ctr = 0;
+  IP4_ADDR(&dest, 10,1,9,9);
+  p = pbuf_alloc(PBUF_IP, 20, PBUF_RAM);
+  fail_unless(p != NULL);
+  err = etharp_output(&test_netif, p, &dest);
+  fail_unless(err == ERR_OK);
+  pbuf_free(p);
+  fail_unless(linkoutput_ctr == 1);
+  fail_unless(linkoutput_pkt_len >= SIZEOF_ETH_HDR + SIZEOF_ETHARP_HDR);
+  fail_unless(memcmp(&linkoutput_pkt[SIZEOF_ETH_HDR + 24], &gw, sizeof(gw)) == 0);
+  etharp_cleanup_netif(&test_netif);
+
+  /* ... also for a route that is more specific than the netif's subnet */
+  IP4_ADDR(&addr, 192,168,7,0);
+  err = ip4_fib_add(&addr, 24, &gw, &test_netif);
+  fail_unless(err == ERR_OK);
+  IP4_ADDR(&dest, 192,168,7,9);
+  fail_unless(ip4_route(&dest) == &test_netif);
+  fail_unless(ip4_addr_eq(etharp_next_hop(&test_netif, &dest), &gw));
+  linkoutput_ctr = 0;
+  p = pbuf_alloc(PBUF_IP, 20, PBUF_RAM);
+  fail_unless(p != NULL);
+  err = etharp_output(&test_netif, p, &dest);
+  fail_unless(err == ERR_OK);
+  pbuf_free(p);
+  fail_unless(linkoutput_ctr == 1);
+  fail_unless(memcmp(&linkoutput_pkt[SIZEOF_ETH_HDR + 24], &gw, sizeof(gw)) == 0);
+  etharp_cleanup_netif(&test_netif);
+  err = ip4_fib_remove(&addr, 24);
+  fail_unless(err == ERR_OK);
+  /* a less specific route doesn't change on-link destinations */
+  IP4_ADDR(&addr, 192,168,0,0);
+  err = ip4_fib_add(&addr, 15, &gw, &netif2);
+  fail_unless(err == ERR_OK);
+  IP4_ADDR(&dest, 192,168,6,1);
+  fail_unless(ip4_route(&dest) == &test_netif);
+  err = ip4_fib_remove(&addr, 15);
+  fail_unless(err == ERR_OK);
+  err = ip4_fib_add(&addr, 15, &gw, &test_netif);
+  fail_unless(err == ERR_OK);
+  fail_unless(etharp_next_hop(&test_netif, &dest) == &dest);
+  err = ip4_fib_remove(&addr, 15);
+  fail_unless(err == ERR_OK);
+
+  /* removal */
+  IP4_ADDR(&addr, 10,1,0,0);
+  err = ip4_fib_remove(&addr, 16);
+  fail_unless(err == ERR_OK);
+  err = ip4_fib_remove(&addr, 16);
+  fail_unless(err == ERR_VAL);
+  IP4_ADDR(&dest, 10,1,9,9);
+  route = ip4_fib_lookup(&dest);
+  fail_unless((route != NULL) && (route->prefix_len == 8));
+  IP4_ADDR(&dest, 10,1,2,3);
+  route = ip4_fib_lookup(&dest);
+  fail_unless((route != NULL) && (route->prefix_len == 24));
+
+  /* removing a netif removes its routes */
+  netif_remove(&netif2);
+  IP4_ADDR(&dest, 192,168,5,1);
+  fail_unless(ip4_fib_lookup(&dest) == NULL);
+  IP4_ADDR(&addr, 10,0,0,0);
+  err = ip4_fib_remove(&addr, 8);
+  fail_unless(err == ERR_OK);
+  IP4_ADDR(&addr, 10,1,2,0);
+  err = ip4_fib_remove(&addr, 24);
+  fail_unless(err == ERR_OK);
+  IP4_ADDR(&dest, 10,1,2,3);
+  fail_unless(ip4_fib_lookup(&dest) == NULL);
+}
+END_TEST
+#endif /* LWIP_IPV4_FIB */
+
+#if LWIP_IPV4_FIB && LWIP_FIB_ECMP
+START_TEST(test_ip4_fib_ecmp)
+{
+  struct netif netif2;
+  ip4_addr_t addr, mask, gw, gw2, dest;
+  const struct ip4_fib_entry *route;
+  struct netif *netif;
+  int used[2];
+  u16_t port;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_netif_add();
+  memset(&netif2, 0, sizeof(netif2));
+  IP4_ADDR(&addr, 172,16,0,1);
+  IP4_ADDR(&mask, 255,255,0,0);
+  IP4_ADDR(&gw, 0,0,0,0);
+  fail_unless(netif_add(&netif2, &addr, &mask, &gw, NULL, test_netif2_init, NULL) == &netif2);
+  netif_set_up(&netif2);
+
+  /* one prefix, a path via each netif */
+  IP4_ADDR(&addr, 10,0,0,0);
+  IP4_ADDR(&gw, 192,168,0,2);
+  IP4_ADDR(&gw2, 172,16,0,2);
+  err = ip4_fib_add(&addr, 8, &gw, &test_netif);
+  fail_unless(err == ERR_OK);
+  err = ip4_fib_add(&addr, 8, &gw2, &netif2);
+  fail_unless(err == ERR_OK);
+  err = ip4_fib_add(&addr, 8, &gw2, &netif2);
+  fail_unless(err == ERR_USE);
+
+  /* flows are spread across both paths, each flow stays on its path */
+  IP4_ADDR(&dest, 10,7,7,7);
+  used[0] = used[1] = 0;
+  for (port = 1000; port < 1032; port++) {
+    u32_t hash = ip4_flow_hash(NULL, &dest, IP_PROTO_TCP, port, 80);
+    netif = ip4_route_flow(NULL, &dest, hash);
+    fail_unless((netif == &test_netif) || (netif == &netif2));
+    fail_unless(ip4_route_flow(NULL, &dest, hash) == netif);
+    route = ip4_fib_lookup_flow(&dest, hash);
+    fail_unless((route != NULL) && (route->netif == netif) && (route->prefix_len == 8));
+    used[netif == &netif2]++;
+  }
+  fail_unless((used[0] > 0) && (used[1] > 0));
+  /* flow-less lookups use the first path */
+  fail_unless(ip4_route(&dest) == &test_netif);
+
+  /* the next hop depends on the path taken */
+  fail_unless(ip4_addr_eq(ip4_fib_next_hop(&dest, &test_netif), &gw));
+  fail_unless(ip4_addr_eq(ip4_fib_next_hop(&dest, &netif2), &gw2));
+
+  /* paths via a netif that is down are skipped */
+  netif_set_link_down(&test_netif);
+  for (port = 1000; port < 1032; port++) {
+    fail_unless(ip4_route_flow(NULL, &dest, ip4_flow_hash(NULL, &dest, IP_PROTO_TCP, port, 80)) == &netif2);
+  }
+  fail_unless(ip4_fib_next_hop(&dest, &test_netif) == NULL);
+  netif_set_link_up(&test_netif);
+
+  /* removing the first path leaves the second one */
+  err = ip4_fib_remove_path(&addr, 8, &test_netif);
+  fail_unless(err == ERR_OK);
+  err = ip4_fib_remove_path(&addr, 8, &test_netif);
+  fail_unless(err == ERR_VAL);
+  route = ip4_fib_lookup(&dest);
+  fail_unless((route != NULL) && (route->netif == &netif2) && ip4_addr_eq(&route->gw, &gw2));
+
+  /* removing a netif removes its paths only */
+  err = ip4_fib_add(&addr, 8, &gw, &test_netif);
+  fail_unless(err == ERR_OK);
+  netif_remove(&netif2);
+  for (port = 1000; port < 1032; port++) {
+    fail_unless(ip4_route_flow(NULL, &dest, ip4_flow_hash(NULL, &dest, IP_PROTO_TCP, port, 80)) == &test_netif);
+  }
+  err = ip4_fib_remove(&addr, 8);
+  fail_unless(err == ERR_OK);
+  fail_unless(ip4_fib_lookup(&dest) == NULL);
+}
+END_TEST
+#endif /* LWIP_IPV4_FIB && LWIP_FIB_ECMP */
+
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE && LWIP_IPV4_FIB && ETHARP_SUPPORT_STATIC_ENTRIES
+/** Feed a UDP packet from 172.16.0.5 to dest into inp */
+static void
+test_ip4_forward_input(struct netif *inp, const ip4_addr_t *dest)
+{
+  struct pbuf *p;
+  struct ip_hdr *iphdr;
+  err_t err;
+
+  /* leave room for the Ethernet header like a driver does */
+  p = pbuf_alloc(PBUF_LINK, sizeof(struct ip_hdr) + 8, PBUF_RAM);
+  fail_unless(p != NULL);
+  memset(p->payload, 0, p->len);
+  iphdr = (struct ip_hdr *)p->payload;
+  IPH_VHL_SET(iphdr, 4, sizeof(struct ip_hdr) / 4);
+  IPH_LEN_SET(iphdr, lwip_htons(p->tot_len));
+  IPH_TTL_SET(iphdr, 5);
+  IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
+  IP4_ADDR(&iphdr->src, 172,16,0,5);
+  ip4_addr_copy(iphdr->dest, *dest);
+  IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, sizeof(struct ip_hdr)));
+  err = ip4_input(p, inp);
+  fail_unless(err == ERR_OK);
+}
+
+START_TEST(test_ip4_fwcache)
+{
+  struct netif netif2;
+  ip4_addr_t addr, mask, gw, dest;
+  struct eth_addr mac1 = {{0x02, 0, 0, 0, 0, 0x01}};
+  struct eth_addr mac2 = {{0x02, 0, 0, 0, 0, 0x02}};
+  STAT_COUNTER hits;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_netif_add();
+  memset(&netif2, 0, sizeof(netif2));
+  IP4_ADDR(&addr, 172,16,0,1);
+  IP4_ADDR(&mask, 255,255,0,0);
+  IP4_ADDR(&gw, 0,0,0,0);
+  fail_unless(netif_add(&netif2, &addr, &mask, &gw, NULL, test_netif2_init, NULL) == &netif2);
+  netif_set_up(&netif2);
+
+  IP4_ADDR(&addr, 10,0,0,0);
+  IP4_ADDR(&gw, 192,168,0,2);
+  err = ip4_fib_add(&addr, 8, &gw, &test_netif);
+  fail_unless(err == ERR_OK);
+  err = etharp_add_static_entry(&gw, &mac1);
+  fail_unless(err == ERR_OK);
+  IP4_ADDR(&dest, 10,7,7,7);
+
+  /* first packet fills the cache, the second one hits the ARP entry directly */
+  linkoutput_ctr = 0;
+  hits = lwip_stats.etharp.cachehit;
+  test_ip4_forward_input(&netif2, &dest);
+  test_ip4_forward_input(&netif2, &dest);
+  fail_unless(linkoutput_ctr == 2);
+  fail_unless(lwip_stats.etharp.cachehit == hits + 1);
+  fail_unless(memcmp(linkoutput_pkt, &mac1, ETH_HWADDR_LEN) == 0);
+
+  /* a changed ARP entry is noticed without invalidating the cache */
+  err = etharp_remove_static_entry(&gw);
+  fail_unless(err == ERR_OK);
+  err = etharp_add_static_entry(&gw, &mac2);
+  fail_unless(err == ERR_OK);
+  test_ip4_forward_input(&netif2, &dest);
+  fail_unless(linkoutput_ctr == 3);
+  fail_unless(memcmp(linkoutput_pkt, &mac2, ETH_HWADDR_LEN) == 0);
+
+  /* a new route invalidates the cache: its gateway is resolved now */
+  IP4_ADDR(&addr, 10,7,0,0);
+  IP4_ADDR(&gw, 192,168,0,9);
+  err = ip4_fib_add(&addr, 16, &gw, &test_netif);
+  fail_unless(err == ERR_OK);
+  test_ip4_forward_input(&netif2, &dest);
+  fail_unless(linkoutput_ctr == 4);
+  fail_unless(linkoutput_pkt_len >= SIZEOF_ETH_HDR + SIZEOF_ETHARP_HDR);
+  fail_unless(memcmp(&linkoutput_pkt[SIZEOF_ETH_HDR + 24], &gw, sizeof(gw)) == 0);
+
+  /* the output netif going down invalidates the cache */
+  netif_set_down(&test_netif);
+  test_ip4_forward_input(&netif2, &dest);
+  fail_unless(linkoutput_ctr == 4);
+  netif_set_up(&test_netif);
+
+  err = ip4_fib_remove(&addr, 16);
+  fail_unless(err == ERR_OK);
+  IP4_ADDR(&addr, 10,0,0,0);
+  err = ip4_fib_remove(&addr, 8);
+  fail_unless(err == ERR_OK);
+  /* netif_set_down() has removed the ARP entries */
+  netif_remove(&netif2);
+}
+END_TEST
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE && LWIP_IPV4_FIB && ETHARP_SUPPORT_STATIC_ENTRIES */
+
+#if LWIP_IGMP_SOURCE_FILTER || (LWIP_IPV4_MROUTE && LWIP_IPV4_FIB)
+/** Feed a UDP packet from src to a multicast group into inp */
+static void
+test_ip4_mcast_input(struct netif *inp, const ip4_addr_t *src, const ip4_addr_t *group, u8_t ttl)
+{
+  struct pbuf *p;
+  struct ip_hdr *iphdr;
+  err_t err;
+
+  p = pbuf_alloc(PBUF_LINK, sizeof(struct ip_hdr) + 8, PBUF_RAM);
+  fail_unless(p != NULL);
+  memset(p->payload, 0, p->len);
+  iphdr = (struct ip_hdr *)p->payload;
+  IPH_VHL_SET(iphdr, 4, sizeof(struct ip_hdr) / 4);
+  IPH_LEN_SET(iphdr, lwip_htons(p->tot_len));
+  IPH_TTL_SET(iphdr, ttl);
+  IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
+  ip4_addr_copy(iphdr->src, *src);
+  ip4_addr_copy(iphdr->dest, *group);
+  IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, sizeof(struct ip_hdr)));
+  /* UDP length, checksum 0 (none) */
+  ((u8_t *)p->payload)[sizeof(struct ip_hdr) + 5] = 8;
+  err = ip4_input(p, inp);
+  fail_unless(err == ERR_OK);
+}
+#endif /* LWIP_IGMP_SOURCE_FILTER || (LWIP_IPV4_MROUTE && LWIP_IPV4_FIB) */
+
+#if LWIP_IGMP_SOURCE_FILTER
+START_TEST(test_ip4_igmp_source_filter)
+{
+  ip4_addr_t group, src1, src2;
+  STAT_COUNTER recv;
+  int i;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_netif_add();
+  test_netif.flags |= NETIF_FLAG_IGMP;
+  err = igmp_start(&test_netif);
+  fail_unless(err == ERR_OK);
+
+  /* any-source groups are found in the (hashed) group table */
+  for (i = 1; i <= 5; i++) {
+    IP4_ADDR(&group, 239,1,1,i);
+    err = igmp_joingroup_netif(&test_netif, &group);
+    fail_unless(err == ERR_OK);
+  }
+  for (i = 1; i <= 5; i++) {
+    IP4_ADDR(&group, 239,1,1,i);
+    fail_unless(igmp_lookfor_group(&test_netif, &group) != NULL);
+  }
+  IP4_ADDR(&group, 239,1,1,6);
+  fail_unless(igmp_lookfor_group(&test_netif, &group) == NULL);
+  for (i = 1; i <= 5; i++) {
+    IP4_ADDR(&group, 239,1,1,i);
+    err = igmp_leavegroup_netif(&test_netif, &group);
+    fail_unless(err == ERR_OK);
+    fail_unless(igmp_lookfor_group(&test_netif, &group) == NULL);
+  }
+
+  /* a source-specific join only receives from that source */
+  IP4_ADDR(&group, 232,1,1,1);
+  IP4_ADDR(&src1, 10,0,0,1);
+  IP4_ADDR(&src2, 10,0,0,2);
+  err = igmp_joingroup_source_netif(&test_netif, &group, &src1);
+  fail_unless(err == ERR_OK);
+  fail_unless(igmp_leavegroup_netif(&test_netif, &group) == ERR_VAL);
+  recv = lwip_stats.udp.recv;
+  test_ip4_mcast_input(&test_netif, &src1, &group, 5);
+  fail_unless(lwip_stats.udp.recv == recv + 1);
+  test_ip4_mcast_input(&test_netif, &src2, &group, 5);
+  fail_unless(lwip_stats.udp.recv == recv + 1);
+
+  /* an additional any-source join receives from all sources */
+  err = igmp_joingroup_netif(&test_netif, &group);
+  fail_unless(err == ERR_OK);
+  test_ip4_mcast_input(&test_netif, &src2, &group, 5);
+  fail_unless(lwip_stats.udp.recv == recv + 2);
+  err = igmp_leavegroup_netif(&test_netif, &group);
+  fail_unless(err == ERR_OK);
+  test_ip4_mcast_input(&test_netif, &src2, &group, 5);
+  fail_unless(lwip_stats.udp.recv == recv + 2);
+
+  fail_unless(igmp_leavegroup_source_netif(&test_netif, &group, &src2) == ERR_VAL);
+  err = igmp_leavegroup_source_netif(&test_netif, &group, &src1);
+  fail_unless(err == ERR_OK);
+  fail_unless(igmp_lookfor_group(&test_netif, &group) == NULL);
+
+  /* netif_remove() frees the allsystems group */
+  test_netif_remove();
+}
+END_TEST
+#endif /* LWIP_IGMP_SOURCE_FILTER */
+
+#if LWIP_IPV4_MROUTE && LWIP_IPV4_FIB
+START_TEST(test_ip4_mroute)
+{
+  struct netif netif2;
+  ip4_addr_t addr, mask, gw, group, src;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_netif_add();
+  memset(&netif2, 0, sizeof(netif2));
+  IP4_ADDR(&addr, 172,16,0,1);
+  IP4_ADDR(&mask, 255,255,0,0);
+  IP4_ADDR(&gw, 0,0,0,0);
+  fail_unless(netif_add(&netif2, &addr, &mask, &gw, NULL, test_netif2_init, NULL) == &netif2);
+  netif_set_up(&netif2);
+
+  IP4_ADDR(&group, 239,2,2,2);
+  IP4_ADDR(&src, 172,16,0,5);
+  err = ip4_mroute_add(NULL, &group, &netif2, IP4_MROUTE_OIF(&test_netif));
+  fail_unless(err == ERR_OK);
+
+  /* forwarded with decremented TTL and a valid header checksum */
+  linkoutput_ctr = 0;
+  test_ip4_mcast_input(&netif2, &src, &group, 5);
+  fail_unless(linkoutput_ctr == 1);
+  fail_unless(linkoutput_pkt[SIZEOF_ETH_HDR + 8] == 4);
+  fail_unless(inet_chksum(&linkoutput_pkt[SIZEOF_ETH_HDR], sizeof(struct ip_hdr)) == 0);
+  fail_unless(memcmp(&linkoutput_pkt[SIZEOF_ETH_HDR + 16], &group, sizeof(group)) == 0);
+
+  /* wrong input interface (RPF check) and expiring TTL */
+  test_ip4_mcast_input(&test_netif, &src, &group, 5);
+  test_ip4_mcast_input(&netif2, &src, &group, 1);
+  fail_unless(linkoutput_ctr == 1);
+
+  /* link-local groups are never forwarded */
+  IP4_ADDR(&addr, 224,0,0,9);
+  err = ip4_mroute_add(NULL, &addr, &netif2, IP4_MROUTE_OIF(&test_netif));
+  fail_unless(err == ERR_OK);
+  test_ip4_mcast_input(&netif2, &src, &addr, 5);
+  fail_unless(linkoutput_ctr == 1);
+  fail_unless(ip4_mroute_remove(NULL, &addr) == ERR_OK);
+
+  /* an (S,G) route takes precedence over (*,G) */
+  err = ip4_mroute_add(&src, &group, &netif2, 0);
+  fail_unless(err == ERR_OK);
+  test_ip4_mcast_input(&netif2, &src, &group, 5);
+  fail_unless(linkoutput_ctr == 1);
+  IP4_ADDR(&addr, 172,16,0,6);
+  test_ip4_mcast_input(&netif2, &addr, &group, 5);
+  fail_unless(linkoutput_ctr == 2);
+  fail_unless(ip4_mroute_remove(&src, &group) == ERR_OK);
+  fail_unless(ip4_mroute_remove(&src, &group) == ERR_VAL);
+  test_ip4_mcast_input(&netif2, &src, &group, 5);
+  fail_unless(linkoutput_ctr == 3);
+
+  /* removing the input netif removes its routes */
+  netif_remove(&netif2);
+  fail_unless(ip4_mroute_remove(NULL, &group) == ERR_VAL);
+}
+END_TEST
+#endif /* LWIP_IPV4_MROUTE && LWIP_IPV4_FIB */
+
 /** Create the suite including all tests for this module */
 Suite *
 ip4_suite(void)
 {
   testfunc tests[] = {
     TESTFUNC(test_ip4_frag),
+#if LWIP_NETIF_FRAG_OFFLOAD
+    TESTFUNC(test_ip4_frag_offload),
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
     TESTFUNC(test_ip4_reass),
+    TESTFUNC(test_ip4_reass_tree),
     TESTFUNC(test_127_0_0_1),
     TESTFUNC(test_ip4addr_aton),
     TESTFUNC(test_ip4_icmp_replylen_short),
     TESTFUNC(test_ip4_icmp_replylen_first_8),
+#if LWIP_IPV4_FIB
+    TESTFUNC(test_ip4_fib),
+#endif /* LWIP_IPV4_FIB */
+#if LWIP_IPV4_FIB && LWIP_FIB_ECMP
+    TESTFUNC(test_ip4_fib_ecmp),
+#endif /* LWIP_IPV4_FIB && LWIP_FIB_ECMP */
+#if IP_FORWARD && IP_FORWARD_FLOW_CACHE && LWIP_IPV4_FIB && ETHARP_SUPPORT_STATIC_ENTRIES
+    TESTFUNC(test_ip4_fwcache),
+#endif /* IP_FORWARD && IP_FORWARD_FLOW_CACHE && LWIP_IPV4_FIB && ETHARP_SUPPORT_STATIC_ENTRIES */
+#if LWIP_IGMP_SOURCE_FILTER
+    TESTFUNC(test_ip4_igmp_source_filter),
+#endif /* LWIP_IGMP_SOURCE_FILTER */
+#if LWIP_IPV4_MROUTE && LWIP_IPV4_FIB
+    TESTFUNC(test_ip4_mroute),
+#endif /* LWIP_IPV4_MROUTE && LWIP_IPV4_FIB */
   };
   return create_suite("IPv4", tests, sizeof(tests)/sizeof(testfunc), ip4_setup, ip4_teardown);
 }
@@ -2,13 +2,19 @@
 
 #include "lwip/ethip6.h"
 #include "lwip/ip6.h"
+#include "lwip/ip6_fib.h"
+#include "lwip/ip6_frag.h"
 #include "lwip/icmp6.h"
+#include "lwip/mld6.h"
 #include "lwip/inet_chksum.h"
 #include "lwip/nd6.h"
 #include "lwip/stats.h"
+#include "lwip/udp.h"
 #include "lwip/prot/ethernet.h"
 #include "lwip/prot/ip.h"
 #include "lwip/prot/ip6.h"
+#include "lwip/prot/nd6.h"
+#include "lwip/prot/icmp6.h"
 
 #include "lwip/tcpip.h"
 
@@ -476,6 +482,74 @@ START_TEST(test_ip6_frag)
 }
 END_TEST
 
+#if LWIP_NETIF_FRAG_OFFLOAD
+static err_t
+frag_offload_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  struct ip_frag_desc desc;
+  u32_t hdr_buf[(IP6_HLEN + IP6_FRAG_HLEN) / 4];
+  u8_t *hdr = (u8_t *)hdr_buf;
+  struct ip6_hdr *ip6hdr = (struct ip6_hdr *)hdr_buf;
+  struct ip6_frag_hdr *frag_hdr = (struct ip6_frag_hdr *)(hdr + IP6_HLEN);
+  u16_t offset, len;
+
+  fail_unless(netif == &test_netif6);
+  fail_unless(ip_frag_offload_desc(p, 0, &desc) == ERR_OK);
+  fail_unless(desc.ip_version == 6);
+  fail_unless(desc.hdr_len == IP6_HLEN + IP6_FRAG_HLEN);
+  fail_unless(desc.frag_size == ((netif->mtu - IP6_HLEN - IP6_FRAG_HLEN) & ~7));
+  fail_unless(desc.hdr_len + desc.data_len == p->tot_len);
+
+  for (offset = 0; offset < desc.data_len; offset = (u16_t)(offset + len)) {
+    len = LWIP_MIN(desc.frag_size, (u16_t)(desc.data_len - offset));
+    fail_unless(pbuf_copy_partial(p, hdr, desc.hdr_len, 0) == desc.hdr_len);
+    ip_frag_offload_hdr(netif, &desc, hdr, offset, len);
+    fail_unless(IP6H_PLEN(ip6hdr) == IP6_FRAG_HLEN + len);
+    fail_unless(IP6H_NEXTH(ip6hdr) == IP6_NEXTH_FRAGMENT);
+    fail_unless((lwip_ntohs(frag_hdr->_fragment_offset) & IP6_FRAG_OFFSET_MASK) == offset);
+    fail_unless(((lwip_ntohs(frag_hdr->_fragment_offset) & IP6_FRAG_MORE_FLAG) != 0) == (offset + len < desc.data_len));
+    linkoutput_ctr++;
+    linkoutput_byte_ctr += IP6_HLEN + IP6_FRAG_HLEN + len;
+  }
+  return ERR_OK;
+}
+
+START_TEST(test_ip6_frag_offload)
+{
+  ip_addr_t my_addr = IPADDR6_INIT_HOST(0x20010db8, 0x0, 0x0, 0x1);
+  ip_addr_t peer_addr = IPADDR6_INIT_HOST(0x20010db8, 0x0, 0x0, 0x4);
+  struct pbuf *data;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  /* Configure and enable local address */
+  test_netif6.mtu = 1500;
+  netif_set_up(&test_netif6);
+  netif_ip6_addr_set(&test_netif6, 0, ip_2_ip6(&my_addr));
+  netif_ip6_addr_set_state(&test_netif6, 0, IP6_ADDR_VALID);
+  test_netif6.output_ip6 = direct_output;
+  test_netif6.linkoutput = frag_offload_linkoutput;
+  NETIF_SET_FRAG_OFFLOAD(&test_netif6, NETIF_FRAG_OFFLOAD_IP6);
+  /* Reset counters after multicast traffic */
+  linkoutput_ctr = 0;
+  linkoutput_byte_ctr = 0;
+
+  /* The whole packet (with a fragment header) is passed to the netif, which
+     creates the same six fragments as ip6_frag() */
+  data = pbuf_alloc(PBUF_IP, 8000, PBUF_RAM);
+  fail_unless(data != NULL);
+  err = ip6_output_if_src(data, ip_2_ip6(&my_addr), ip_2_ip6(&peer_addr),
+                          15, 0, IP_PROTO_UDP, &test_netif6);
+  fail_unless(err == ERR_OK);
+  fail_unless(linkoutput_ctr == 6);
+  fail_unless(linkoutput_byte_ctr == (8000 + (6 * (IP6_HLEN + IP6_FRAG_HLEN))));
+  pbuf_free(data);
+  NETIF_SET_FRAG_OFFLOAD(&test_netif6, 0);
+  test_netif6.linkoutput = default_netif_linkoutput;
+}
+END_TEST
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
+
 static void test_ip6_reass_helper(u32_t ip_id, const u16_t *segments, size_t num_segs, u16_t seglen)
 {
   ip_addr_t my_addr = IPADDR6_INIT_HOST(0x20010db8, 0x0, 0x0, 0x1);
@@ -521,6 +595,459 @@ START_TEST(test_ip6_reass)
 }
 END_TEST
 
+START_TEST(test_ip6_reass_tree)
+{
+  ip_addr_t my_addr = IPADDR6_INIT_HOST(0x20010db8, 0x0, 0x0, 0x1);
+  int i;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&lwip_stats.mib2, 0, sizeof(lwip_stats.mib2));
+  memset(&lwip_stats.ip6_frag, 0, sizeof(lwip_stats.ip6_frag));
+
+  netif_set_up(&test_netif6);
+  netif_ip6_addr_set(&test_netif6, 0, ip_2_ip6(&my_addr));
+  netif_ip6_addr_set_state(&test_netif6, 0, IP6_ADDR_VALID);
+
+  /* out of order, with a duplicate, an overlapping fragment and a fragment
+     beyond the end of the datagram */
+  create_ip6_input_fragment(200, 16, 16, 0, IP6_NEXTH_UDP);
+  create_ip6_input_fragment(200, 16, 16, 0, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.ip6_frag.drop == 1);
+  create_ip6_input_fragment(200, 24, 16, 0, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.ip6_frag.drop == 2);
+  create_ip6_input_fragment(200, 32, 16, 1, IP6_NEXTH_UDP);
+  create_ip6_input_fragment(200, 48, 8, 0, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.ip6_frag.drop == 3);
+  create_ip6_input_fragment(200, 8, 8, 0, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.mib2.ip6reasmoks == 0);
+  create_ip6_input_fragment(200, 0, 8, 0, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.mib2.ip6reasmoks == 1);
+  fail_unless(lwip_stats.ip6_frag.drop == 3);
+
+  /* a fragment overlapping two others is dropped, too */
+  create_ip6_input_fragment(201, 0, 8, 0, IP6_NEXTH_UDP);
+  create_ip6_input_fragment(201, 16, 8, 1, IP6_NEXTH_UDP);
+  create_ip6_input_fragment(201, 0, 24, 0, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.ip6_frag.drop == 4);
+  create_ip6_input_fragment(201, 8, 8, 0, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.mib2.ip6reasmoks == 2);
+
+  /* a second last fragment with a different length is dropped */
+  create_ip6_input_fragment(202, 32, 8, 1, IP6_NEXTH_UDP);
+  create_ip6_input_fragment(202, 40, 8, 1, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.ip6_frag.drop == 5);
+  /* so is data beyond the end */
+  create_ip6_input_fragment(202, 40, 8, 0, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.ip6_frag.drop == 6);
+  create_ip6_input_fragment(202, 8, 24, 0, IP6_NEXTH_UDP);
+  create_ip6_input_fragment(202, 0, 8, 0, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.mib2.ip6reasmoks == 3);
+
+  /* time out an incomplete datagram */
+  create_ip6_input_fragment(203, 8, 8, 1, IP6_NEXTH_UDP);
+  for (i = 0; i <= IPV6_REASS_MAXAGE; i++) {
+    ip6_reass_tmr();
+  }
+  fail_unless(lwip_stats.mib2.ip6reasmoks == 3);
+  fail_unless(lwip_stats.ip6_frag.err == 0);
+  fail_unless(lwip_stats.ip6_frag.memerr == 0);
+}
+END_TEST
+
+#if LWIP_IPV6_FIB
+static err_t
+test_ip6_fib_netif2_output(struct netif *netif, struct pbuf *p, const ip6_addr_t *ipaddr)
+{
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(p);
+  LWIP_UNUSED_ARG(ipaddr);
+  return ERR_OK;
+}
+
+static err_t
+test_ip6_fib_netif2_init(struct netif *netif)
+{
+  netif->output_ip6 = test_ip6_fib_netif2_output;
+  netif->mtu = 1500;
+  return ERR_OK;
+}
+
+/** Input a router advertisement from fe80::99 for an on-link prefix */
+static void
+test_ip6_fib_input_ra(const char *prefix, u16_t router_lifetime, u32_t valid_lifetime)
+{
+  struct pbuf *p;
+  struct ip6_hdr *ip6hdr;
+  struct ra_header *ra;
+  struct prefix_option *opt;
+  ip6_addr_t src, dst, pfx;
+  const u16_t len = sizeof(struct ra_header) + sizeof(struct prefix_option);
+
+  fail_unless(ip6addr_aton("fe80::99", &src));
+  fail_unless(ip6addr_aton("ff02::1", &dst));
+  fail_unless(ip6addr_aton(prefix, &pfx));
+  p = pbuf_alloc(PBUF_RAW, IP6_HLEN + len, PBUF_RAM);
+  fail_unless(p != NULL);
+  memset(p->payload, 0, p->len);
+  ip6hdr = (struct ip6_hdr *)p->payload;
+  IP6H_VTCFL_SET(ip6hdr, 6, 0, 0);
+  IP6H_PLEN_SET(ip6hdr, len);
+  IP6H_NEXTH_SET(ip6hdr, IP6_NEXTH_ICMP6);
+  IP6H_HOPLIM_SET(ip6hdr, 255);
+  ip6_addr_copy_to_packed(ip6hdr->src, src);
+  ip6_addr_copy_to_packed(ip6hdr->dest, dst);
+  ra = (struct ra_header *)(ip6hdr + 1);
+  ra->type = ICMP6_TYPE_RA;
+  ra->router_lifetime = lwip_htons(router_lifetime);
+  opt = (struct prefix_option *)(ra + 1);
+  opt->type = ND6_OPTION_TYPE_PREFIX_INFO;
+  opt->length = sizeof(struct prefix_option) / 8;
+  opt->prefix_length = 64;
+  opt->flags = ND6_PREFIX_FLAG_ON_LINK;
+  opt->valid_lifetime = lwip_htonl(valid_lifetime);
+  opt->preferred_lifetime = lwip_htonl(valid_lifetime);
+  ip6_addr_copy_to_packed(opt->prefix, pfx);
+  pbuf_remove_header(p, IP6_HLEN);
+  ra->chksum = ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, len, &src, &dst);
+  pbuf_add_header(p, IP6_HLEN);
+  fail_unless(ip6_input(p, &test_netif6) == ERR_OK);
+}
+
+START_TEST(test_ip6_fib)
+{
+  struct netif netif2;
+  ip6_addr_t prefix, gw1, gw2, dest;
+  const struct ip6_fib_entry *route;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  memset(&netif2, 0, sizeof(netif2));
+  fail_unless(netif_add_noaddr(&netif2, NULL, test_ip6_fib_netif2_init, NULL) == &netif2);
+  netif_set_up(&netif2);
+  netif_set_link_up(&netif2);
+  netif_set_up(&test_netif6);
+  netif_set_link_up(&test_netif6);
+
+  /* two routes to the same prefix with different metrics, one more specific */
+  fail_unless(ip6addr_aton("2001:db8:100::", &prefix));
+  fail_unless(ip6addr_aton("fe80::1", &gw1));
+  fail_unless(ip6addr_aton("fe80::2", &gw2));
+  err = ip6_fib_add(&prefix, 48, &gw1, &test_netif6, 10);
+  fail_unless(err == ERR_OK);
+  err = ip6_fib_add(&prefix, 48, &gw2, &netif2, 5);
+  fail_unless(err == ERR_OK);
+  err = ip6_fib_add(&prefix, 48, &gw2, &netif2, 7);
+  fail_unless(err == ERR_USE);
+  fail_unless(ip6addr_aton("2001:db8:100:5::", &prefix));
+  err = ip6_fib_add(&prefix, 64, NULL, &test_netif6, 0);
+  fail_unless(err == ERR_OK);
+  fail_unless(ip6addr_aton("2001:db8:100:5::1", &prefix));
+  err = ip6_fib_add(&prefix, 64, NULL, &test_netif6, 0);
+  fail_unless(err == ERR_VAL);
+
+  fail_unless(ip6addr_aton("2001:db8:100:1::1", &dest));
+  route = ip6_fib_lookup(&dest, NULL);
+  fail_unless((route != NULL) && (route->netif == &netif2) && (route->metric == 5));
+  fail_unless(ip6_route(IP6_ADDR_ANY6, &dest) == &netif2);
+  route = ip6_fib_lookup(&dest, &test_netif6);
+  fail_unless((route != NULL) && ip6_addr_zoneless_eq(&route->gw, &gw1));
+  netif_set_link_down(&netif2);
+  route = ip6_fib_lookup(&dest, NULL);
+  fail_unless((route != NULL) && (route->netif == &test_netif6));
+  netif_set_link_up(&netif2);
+  fail_unless(ip6addr_aton("2001:db8:100:5::1", &dest));
+  route = ip6_fib_lookup(&dest, NULL);
+  fail_unless((route != NULL) && (route->prefix_len == 64) && ip6_addr_isany(&route->gw));
+  fail_unless(ip6addr_aton("2001:db8:200::1", &dest));
+  fail_unless(ip6_fib_lookup(&dest, NULL) == NULL);
+
+  /* routes learned from router advertisements */
+  test_ip6_fib_input_ra("2001:db8:1::", 1800, 3600);
+  fail_unless(ip6addr_aton("2001:db8:1::5", &dest));
+  route = ip6_fib_lookup(&dest, NULL);
+  fail_unless((route != NULL) && (route->origin == IP6_FIB_ORIGIN_RA) && (route->prefix_len == 64));
+  fail_unless(ip6_route(IP6_ADDR_ANY6, &dest) == &test_netif6);
+  fail_unless(ip6addr_aton("2001:db8:200::1", &dest));
+  route = ip6_fib_lookup(&dest, NULL);
+  fail_unless((route != NULL) && (route->origin == IP6_FIB_ORIGIN_RA) && (route->prefix_len == 0));
+  fail_unless(ip6addr_aton("fe80::99", &gw1));
+  fail_unless(ip6_addr_zoneless_eq(&route->gw, &gw1));
+  /* an advertised lifetime of 0 removes the routes */
+  test_ip6_fib_input_ra("2001:db8:1::", 0, 0);
+  fail_unless(ip6_fib_lookup(&dest, NULL) == NULL);
+  fail_unless(ip6addr_aton("2001:db8:1::5", &dest));
+  fail_unless(ip6_fib_lookup(&dest, NULL) == NULL);
+  test_ip6_fib_input_ra("2001:db8:1::", 1800, 3600);
+  fail_unless(ip6_fib_lookup(&dest, NULL) != NULL);
+  /* ... and so does taking the netif down */
+  netif_set_down(&test_netif6);
+  fail_unless(ip6_fib_lookup(&dest, &test_netif6) == NULL);
+
+  /* removal */
+  fail_unless(ip6addr_aton("2001:db8:100::", &prefix));
+  fail_unless(ip6addr_aton("fe80::1", &gw1));
+  err = ip6_fib_remove(&prefix, 48, &gw1, &test_netif6);
+  fail_unless(err == ERR_OK);
+  err = ip6_fib_remove(&prefix, 48, &gw1, &test_netif6);
+  fail_unless(err == ERR_VAL);
+  fail_unless(ip6addr_aton("2001:db8:100:1::1", &dest));
+  route = ip6_fib_lookup(&dest, NULL);
+  fail_unless((route != NULL) && (route->netif == &netif2));
+
+  /* removing a netif removes its routes */
+  netif_remove(&netif2);
+  fail_unless(ip6_fib_lookup(&dest, NULL) == NULL);
+  fail_unless(ip6addr_aton("2001:db8:100:5::", &prefix));
+  err = ip6_fib_remove(&prefix, 64, NULL, &test_netif6);
+  fail_unless(err == ERR_OK);
+}
+END_TEST
+#endif /* LWIP_IPV6_FIB */
+
+#if LWIP_ND6_CACHE_HASH
+/** Input a solicited neighbor advertisement for fe80::n */
+static void
+test_ip6_nd6_input_na(u8_t n)
+{
+  struct pbuf *p;
+  struct ip6_hdr *ip6hdr;
+  struct na_header *na;
+  struct lladdr_option *opt;
+  ip6_addr_t src;
+  const ip6_addr_t *dst = netif_ip6_addr(&test_netif6, 0);
+  const u16_t len = sizeof(struct na_header) + sizeof(struct lladdr_option);
+
+  IP6_ADDR(&src, PP_HTONL(0xfe800000UL), 0, 0, PP_HTONL(n));
+  p = pbuf_alloc(PBUF_RAW, IP6_HLEN + len, PBUF_RAM);
+  fail_unless(p != NULL);
+  memset(p->payload, 0, p->len);
+  ip6hdr = (struct ip6_hdr *)p->payload;
+  IP6H_VTCFL_SET(ip6hdr, 6, 0, 0);
+  IP6H_PLEN_SET(ip6hdr, len);
+  IP6H_NEXTH_SET(ip6hdr, IP6_NEXTH_ICMP6);
+  IP6H_HOPLIM_SET(ip6hdr, 255);
+  ip6_addr_copy_to_packed(ip6hdr->src, src);
+  ip6_addr_copy_to_packed(ip6hdr->dest, *dst);
+  na = (struct na_header *)(ip6hdr + 1);
+  na->type = ICMP6_TYPE_NA;
+  na->flags = ND6_FLAG_SOLICITED | ND6_FLAG_OVERRIDE;
+  ip6_addr_copy_to_packed(na->target_address, src);
+  opt = (struct lladdr_option *)(na + 1);
+  opt->type = ND6_OPTION_TYPE_TARGET_LLADDR;
+  opt->length = sizeof(struct lladdr_option) / 8;
+  opt->addr[0] = 2;
+  opt->addr[5] = n;
+  pbuf_remove_header(p, IP6_HLEN);
+  na->chksum = ip6_chksum_pseudo(p, IP6_NEXTH_ICMP6, len, &src, dst);
+  pbuf_add_header(p, IP6_HLEN);
+  fail_unless(ip6_input(p, &test_netif6) == ERR_OK);
+}
+
+/** Send a UDP packet to fe80::n */
+static void
+test_ip6_nd6_send(struct udp_pcb *pcb, u8_t n)
+{
+  struct pbuf *p;
+  ip_addr_t dst;
+  err_t err;
+
+  IP_ADDR6(&dst, PP_HTONL(0xfe800000UL), 0, 0, PP_HTONL(n));
+  ip6_addr_assign_zone(ip_2_ip6(&dst), IP6_UNICAST, &test_netif6);
+  p = pbuf_alloc(PBUF_TRANSPORT, 8, PBUF_RAM);
+  fail_unless(p != NULL);
+  err = udp_sendto(pcb, p, &dst, 1234);
+  fail_unless(err == ERR_OK);
+  pbuf_free(p);
+}
+
+START_TEST(test_ip6_nd6_cache)
+{
+  struct udp_pcb *pcb;
+  u8_t n;
+  LWIP_UNUSED_ARG(_i);
+
+  netif_create_ip6_linklocal_address(&test_netif6, 1);
+  netif_ip6_addr_set_state(&test_netif6, 0, IP6_ADDR_PREFERRED);
+  netif_set_up(&test_netif6);
+  netif_set_link_up(&test_netif6);
+#if LWIP_IPV6_SEND_ROUTER_SOLICIT
+  test_netif6.rs_count = 0;
+#endif /* LWIP_IPV6_SEND_ROUTER_SOLICIT */
+  pcb = udp_new_ip_type(IPADDR_TYPE_V6);
+  fail_unless(pcb != NULL);
+  linkoutput_ctr = 0;
+
+  /* fill the neighbor cache: one NS each, packets are queued */
+  for (n = 1; n <= LWIP_ND6_NUM_NEIGHBORS; n++) {
+    test_ip6_nd6_send(pcb, n);
+  }
+  fail_unless(linkoutput_ctr == LWIP_ND6_NUM_NEIGHBORS);
+  /* the advertisements make the neighbors reachable and send the queue */
+  for (n = 1; n <= LWIP_ND6_NUM_NEIGHBORS; n++) {
+    test_ip6_nd6_input_na(n);
+  }
+  fail_unless(linkoutput_ctr == 2 * LWIP_ND6_NUM_NEIGHBORS);
+  for (n = 1; n <= LWIP_ND6_NUM_NEIGHBORS; n++) {
+    test_ip6_nd6_send(pcb, n);
+  }
+  fail_unless(linkoutput_ctr == 3 * LWIP_ND6_NUM_NEIGHBORS);
+
+  /* reachable -> stale after LWIP_ND6_REACHABLE_TIME, nothing is sent */
+  ip6_test_handle_timers(LWIP_ND6_REACHABLE_TIME / ND6_TMR_INTERVAL);
+  linkoutput_ctr = 0;
+  /* stale -> delay: sent directly, the first probe follows after
+     LWIP_ND6_DELAY_FIRST_PROBE_TIME */
+  test_ip6_nd6_send(pcb, 2);
+  fail_unless(linkoutput_ctr == 1);
+  ip6_test_handle_timers(LWIP_ND6_DELAY_FIRST_PROBE_TIME / ND6_TMR_INTERVAL);
+  fail_unless(linkoutput_ctr == 1);
+  ip6_test_handle_timers(1);
+  fail_unless(linkoutput_ctr == 2);
+  /* unanswered probes remove the neighbor */
+  ip6_test_handle_timers(LWIP_ND6_MAX_UNICAST_SOLICIT);
+  fail_unless(linkoutput_ctr == 1 + LWIP_ND6_MAX_UNICAST_SOLICIT);
+  linkoutput_ctr = 0;
+  test_ip6_nd6_send(pcb, 2);
+  fail_unless(linkoutput_ctr == 1);
+
+  /* a full cache recycles stale neighbors */
+  test_ip6_nd6_send(pcb, LWIP_ND6_NUM_NEIGHBORS + 1);
+  fail_unless(linkoutput_ctr == 2);
+  test_ip6_nd6_input_na(LWIP_ND6_NUM_NEIGHBORS + 1);
+  fail_unless(linkoutput_ctr == 3);
+  /* the remaining neighbors are still found */
+  test_ip6_nd6_send(pcb, LWIP_ND6_NUM_NEIGHBORS);
+  fail_unless(linkoutput_ctr == 4);
+  test_ip6_nd6_send(pcb, LWIP_ND6_NUM_NEIGHBORS + 1);
+  fail_unless(linkoutput_ctr == 5);
+
+  udp_remove(pcb);
+  netif_set_down(&test_netif6);
+  netif_set_link_down(&test_netif6);
+  netif_ip6_addr_set_state(&test_netif6, 0, IP6_ADDR_INVALID);
+}
+END_TEST
+#endif /* LWIP_ND6_CACHE_HASH */
+
+#if LWIP_IPV6_MLD && LWIP_MLD6_SOURCE_FILTER
+/** Feed a UDP packet from src to a multicast group into test_netif6 */
+static void
+test_ip6_mcast_input(const ip6_addr_t *src, const ip6_addr_t *group, u8_t nexth)
+{
+  struct pbuf *p;
+  struct ip6_hdr *ip6hdr;
+  err_t err;
+
+  p = pbuf_alloc(PBUF_LINK, IP6_HLEN + 8, PBUF_RAM);
+  fail_unless(p != NULL);
+  memset(p->payload, 0, p->len);
+  ip6hdr = (struct ip6_hdr *)p->payload;
+  IP6H_VTCFL_SET(ip6hdr, 6, 0, 0);
+  IP6H_PLEN_SET(ip6hdr, 8);
+  IP6H_NEXTH_SET(ip6hdr, nexth);
+  IP6H_HOPLIM_SET(ip6hdr, 1);
+  ip6_addr_copy_to_packed(ip6hdr->src, *src);
+  ip6_addr_copy_to_packed(ip6hdr->dest, *group);
+  err = ip6_input(p, &test_netif6);
+  fail_unless(err == ERR_OK);
+}
+
+START_TEST(test_ip6_mld_source_filter)
+{
+  ip6_addr_t group, src1, src2;
+  STAT_COUNTER recv, icmp_recv;
+  char buf[32];
+  int i;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  netif_set_up(&test_netif6);
+  netif_set_link_up(&test_netif6);
+
+  /* any-source groups are found in the (hashed) group table, with more
+     groups than buckets */
+  for (i = 1; i <= 3; i++) {
+    snprintf(buf, sizeof(buf), "ff15::%d", i);
+    fail_unless(ip6addr_aton(buf, &group));
+    err = mld6_joingroup_netif(&test_netif6, &group);
+    fail_unless(err == ERR_OK);
+  }
+  for (i = 1; i <= 3; i++) {
+    snprintf(buf, sizeof(buf), "ff15::%d", i);
+    fail_unless(ip6addr_aton(buf, &group));
+    fail_unless(mld6_lookfor_group(&test_netif6, &group) != NULL);
+  }
+  fail_unless(ip6addr_aton("ff15::4", &group));
+  fail_unless(mld6_lookfor_group(&test_netif6, &group) == NULL);
+  for (i = 1; i <= 3; i++) {
+    snprintf(buf, sizeof(buf), "ff15::%d", i);
+    fail_unless(ip6addr_aton(buf, &group));
+    err = mld6_leavegroup_netif(&test_netif6, &group);
+    fail_unless(err == ERR_OK);
+    fail_unless(mld6_lookfor_group(&test_netif6, &group) == NULL);
+  }
+
+  /* a source-specific join only receives from that source */
+  fail_unless(ip6addr_aton("ff35::1", &group));
+  fail_unless(ip6addr_aton("2001:db8::1", &src1));
+  fail_unless(ip6addr_aton("2001:db8::2", &src2));
+  fail_unless(mld6_joingroup_source_netif(&test_netif6, &group, &group) == ERR_VAL);
+  err = mld6_joingroup_source_netif(&test_netif6, &group, &src1);
+  fail_unless(err == ERR_OK);
+  /* joining the same source again only counts the use */
+  err = mld6_joingroup_source_netif(&test_netif6, &group, &src1);
+  fail_unless(err == ERR_OK);
+  fail_unless(mld6_leavegroup_netif(&test_netif6, &group) == ERR_VAL);
+  recv = lwip_stats.udp.recv;
+  test_ip6_mcast_input(&src1, &group, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.udp.recv == recv + 1);
+  test_ip6_mcast_input(&src2, &group, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.udp.recv == recv + 1);
+
+  /* ICMPv6 (MLD) messages to the group are never filtered */
+  icmp_recv = lwip_stats.icmp6.recv;
+  test_ip6_mcast_input(&src2, &group, IP6_NEXTH_ICMP6);
+  fail_unless(lwip_stats.icmp6.recv == icmp_recv + 1);
+
+  /* an additional source is added to the filter */
+  err = mld6_joingroup_source_netif(&test_netif6, &group, &src2);
+  fail_unless(err == ERR_OK);
+  test_ip6_mcast_input(&src2, &group, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.udp.recv == recv + 2);
+  err = mld6_leavegroup_source_netif(&test_netif6, &group, &src2);
+  fail_unless(err == ERR_OK);
+  test_ip6_mcast_input(&src2, &group, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.udp.recv == recv + 2);
+
+  /* an additional any-source join receives from all sources */
+  err = mld6_joingroup_netif(&test_netif6, &group);
+  fail_unless(err == ERR_OK);
+  test_ip6_mcast_input(&src2, &group, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.udp.recv == recv + 3);
+  err = mld6_leavegroup_netif(&test_netif6, &group);
+  fail_unless(err == ERR_OK);
+  test_ip6_mcast_input(&src2, &group, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.udp.recv == recv + 3);
+
+  /* the group is left with the last use of its last source */
+  fail_unless(mld6_leavegroup_source_netif(&test_netif6, &group, &src2) == ERR_VAL);
+  err = mld6_leavegroup_source_netif(&test_netif6, &group, &src1);
+  fail_unless(err == ERR_OK);
+  fail_unless(mld6_lookfor_group(&test_netif6, &group) != NULL);
+  test_ip6_mcast_input(&src1, &group, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.udp.recv == recv + 4);
+  err = mld6_leavegroup_source_netif(&test_netif6, &group, &src1);
+  fail_unless(err == ERR_OK);
+  fail_unless(mld6_lookfor_group(&test_netif6, &group) == NULL);
+  test_ip6_mcast_input(&src1, &group, IP6_NEXTH_UDP);
+  fail_unless(lwip_stats.udp.recv == recv + 4);
+
+  netif_set_link_down(&test_netif6);
+  netif_set_down(&test_netif6);
+}
+END_TEST
+#endif /* LWIP_IPV6_MLD && LWIP_MLD6_SOURCE_FILTER */
+
 /** Create the suite including all tests for this module */
 Suite *
 ip6_suite(void)
@@ -534,7 +1061,20 @@ ip6_suite(void)
     TESTFUNC(test_ip6_dest_unreachable_chained_pbuf),
     TESTFUNC(test_ip6_frag_pbuf_len_assert),
     TESTFUNC(test_ip6_frag),
-    TESTFUNC(test_ip6_reass)
+#if LWIP_NETIF_FRAG_OFFLOAD
+    TESTFUNC(test_ip6_frag_offload),
+#endif /* LWIP_NETIF_FRAG_OFFLOAD */
+    TESTFUNC(test_ip6_reass),
+    TESTFUNC(test_ip6_reass_tree),
+#if LWIP_IPV6_FIB
+    TESTFUNC(test_ip6_fib),
+#endif /* LWIP_IPV6_FIB */
+#if LWIP_ND6_CACHE_HASH
+    TESTFUNC(test_ip6_nd6_cache),
+#endif /* LWIP_ND6_CACHE_HASH */
+#if LWIP_IPV6_MLD && LWIP_MLD6_SOURCE_FILTER
+    TESTFUNC(test_ip6_mld_source_filter),
+#endif /* LWIP_IPV6_MLD && LWIP_MLD6_SOURCE_FILTER */
   };
   return create_suite("IPv6", tests, sizeof(tests)/sizeof(testfunc), ip6_setup, ip6_teardown);
 }
@@ -14,8 +14,12 @@
 #include "core/test_timers.h"
 #include "etharp/test_etharp.h"
 #include "dhcp/test_dhcp.h"
+#include "httpc/test_httpc.h"
+#include "httpd/test_fs.h"
+#include "httpd/test_httpd.h"
 #include "mdns/test_mdns.h"
 #include "mqtt/test_mqtt.h"
+#include "pcapng/test_pcapng.h"
 #include "api/test_sockets.h"
 #include "ppp/test_pppos.h"
 
@@ -95,8 +99,12 @@ int main(void)
     timers_suite,
     etharp_suite,
     dhcp_suite,
+    fs_suite,
+    httpc_suite,
+    httpd_suite,
     mdns_suite,
     mqtt_suite,
+    pcapng_suite,
     sockets_suite
 #if PPP_SUPPORT && PPPOS_SUPPORT
     , pppos_suite
@@ -66,6 +66,9 @@
 #define TCP_WND                         (10 * TCP_MSS)
 #define LWIP_WND_SCALE                  1
 #define TCP_RCV_SCALE                   0
+#define LWIP_TCP_INFO                   1
+#define LWIP_TCP_FASTOPEN               1
+#define LWIP_TCP_SYNCOOKIES             1
 #define PBUF_POOL_SIZE                  400 /* pbuf tests need ~200KByte */
 
 /* Enable IGMP and MDNS for MDNS tests */
@@ -79,9 +82,60 @@
 
 /* Minimal changes to opt.h required for etharp unit tests: */
 #define ETHARP_SUPPORT_STATIC_ENTRIES   1
+/* Hashed ARP table with few buckets so that bucket chains get exercised */
+#define ETHARP_TABLE_HASH               1
+#define ETHARP_TABLE_HASH_SIZE          4
+
+/* Routing tables for the IPv4/IPv6 unit tests */
+#define LWIP_IPV4_FIB                   1
+#define LWIP_IPV6_FIB                   1
+#define LWIP_FIB_ECMP                   1
+
+/* Forwarding with a small flow cache for the IPv4 unit tests */
+#define IP_FORWARD                      1
+#define IP_FORWARD_FLOW_CACHE           1
+#define IP_FORWARD_FLOW_CACHE_SIZE      4
+
+/* Several reassembly buckets for the IPv4/IPv6 reassembly tests */
+#define IP_REASS_HASH_SIZE              4
+
+/* Fragmentation offload for the IPv4/IPv6 fragmentation tests */
+#define LWIP_NETIF_FRAG_OFFLOAD         1
+
+/* Path MTU discovery for the TCP PMTU tests */
+#define LWIP_IPV4_PMTU                  1
+#define TCP_PLPMTUD                     1
+
+/* Multicast membership hashing, source filters and forwarding for the IGMP
+   and MLD tests (few buckets so that buckets are shared) */
+#define IGMP_GROUP_HASH_SIZE            2
+#define LWIP_IGMP_SOURCE_FILTER         1
+#define MLD6_GROUP_HASH_SIZE            2
+#define LWIP_MLD6_SOURCE_FILTER         1
+#define LWIP_IPV4_MROUTE                1
+
+/* Hashed neighbor/destination caches with few buckets so that bucket
+   chains get exercised */
+#define LWIP_ND6_CACHE_HASH             1
+#define LWIP_ND6_CACHE_HASH_SIZE        4
 
 #define MEMP_NUM_SYS_TIMEOUT            (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 8)
 
+/* httpd features for the httpd tests, with a test file system and
+   fs_state_init() counting opened files */
+#define LWIP_HTTPD_DYNAMIC_HEADERS      1
+#define LWIP_HTTPD_SUPPORT_11_KEEPALIVE 1
+#define LWIP_HTTPD_CONTENT_ENCODING     1
+#define LWIP_HTTPD_CONDITIONAL_REQUESTS 1
+#define LWIP_HTTPD_RANGE_REQUESTS       1
+#define LWIP_HTTPD_PIPELINING           1
+#define LWIP_HTTPD_WEBSOCKET            1
+#define LWIP_HTTPD_FILE_STATE           1
+#define HTTPD_FSDATA_FILE               "httpd/fsdata_test.c"
+
+/* http client: test the pool of idle connections, too */
+#define LWIP_HTTPC_KEEPALIVE            1
+
 /* MIB2 stats are required to check IPv4 reassembly results */
 #define MIB2_STATS                      1
 
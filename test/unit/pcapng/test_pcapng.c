@@ -0,0 +1,283 @@
+#include "test_pcapng.h"
+
+#include "lwip/apps/pcapng.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "lwip/stats.h"
+
+#define TEST_FRAME_LEN 100
+
+static struct netif pcapng_netif;
+static int rx_calls;
+static int tx_calls;
+static u8_t out_buf[PCAPNG_RINGBUF_SIZE];
+
+/* Setups/teardown functions */
+
+static void
+pcapng_setup(void)
+{
+  pcapng_init();
+  rx_calls = 0;
+  tx_calls = 0;
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+static void
+pcapng_teardown(void)
+{
+  pcapng_init();
+  lwip_check_ensure_no_alloc(SKIP_POOL(MEMP_SYS_TIMEOUT));
+}
+
+/* test helper functions */
+
+static err_t
+testif_input(struct pbuf *p, struct netif *inp)
+{
+  LWIP_UNUSED_ARG(inp);
+  rx_calls++;
+  pbuf_free(p);
+  return ERR_OK;
+}
+
+static err_t
+testif_linkoutput(struct netif *netif, struct pbuf *p)
+{
+  LWIP_UNUSED_ARG(netif);
+  LWIP_UNUSED_ARG(p);
+  tx_calls++;
+  return ERR_OK;
+}
+
+static void
+testif_setup(void)
+{
+  memset(&pcapng_netif, 0, sizeof(pcapng_netif));
+  pcapng_netif.name[0] = 'e';
+  pcapng_netif.name[1] = 'n';
+  pcapng_netif.input = testif_input;
+  pcapng_netif.linkoutput = testif_linkoutput;
+  pcapng_netif.flags = NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET;
+}
+
+/* create an ethernet/IPv4/TCP frame */
+static struct pbuf *
+create_tcp_frame(u16_t sport, u16_t dport)
+{
+  struct pbuf *p = pbuf_alloc(PBUF_RAW, TEST_FRAME_LEN, PBUF_RAM);
+  u8_t *f;
+  if (p == NULL) {
+    return NULL;
+  }
+  f = (u8_t *)p->payload;
+  memset(f, 0, TEST_FRAME_LEN);
+  /* ethertype IPv4 */
+  f[12] = 0x08;
+  /* IPv4 header: 192.168.0.1 -> 192.168.0.2, TCP */
+  f[14] = 0x45;
+  f[14 + 9] = 6;
+  f[14 + 12] = 192; f[14 + 13] = 168; f[14 + 14] = 0; f[14 + 15] = 1;
+  f[14 + 16] = 192; f[14 + 17] = 168; f[14 + 18] = 0; f[14 + 19] = 2;
+  /* TCP ports */
+  f[34] = (u8_t)(sport >> 8);
+  f[35] = (u8_t)sport;
+  f[36] = (u8_t)(dport >> 8);
+  f[37] = (u8_t)dport;
+  return p;
+}
+
+static void
+input_tcp_frame(u16_t sport, u16_t dport)
+{
+  struct pbuf *p = create_tcp_frame(sport, dport);
+  EXPECT_RET(p != NULL);
+  pcapng_netif.input(p, &pcapng_netif);
+}
+
+static u32_t
+get32(const u8_t *buf)
+{
+  u32_t val;
+  memcpy(&val, buf, 4);
+  return val;
+}
+
+/* Test functions */
+
+START_TEST(test_pcapng_filter_syntax)
+{
+  LWIP_UNUSED_ARG(_i);
+
+  fail_unless(pcapng_set_filter(NULL) == ERR_OK);
+  fail_unless(pcapng_set_filter("") == ERR_OK);
+  fail_unless(pcapng_set_filter("tcp") == ERR_OK);
+  fail_unless(pcapng_set_filter("tcp port 80") == ERR_OK);
+  fail_unless(pcapng_set_filter("udp and (src port 53 or dst port 53)") == ERR_OK);
+  fail_unless(pcapng_set_filter("!arp && inbound || host 10.0.0.1") == ERR_OK);
+  fail_unless(pcapng_set_filter("not icmp6 and dst host fe80::1") == ERR_OK);
+
+  fail_unless(pcapng_set_filter("foo") == ERR_ARG);
+  fail_unless(pcapng_set_filter("port") == ERR_ARG);
+  fail_unless(pcapng_set_filter("port 65536") == ERR_ARG);
+  fail_unless(pcapng_set_filter("host 1.2.3.x") == ERR_ARG);
+  fail_unless(pcapng_set_filter("(tcp") == ERR_ARG);
+  fail_unless(pcapng_set_filter("tcp)") == ERR_ARG);
+  fail_unless(pcapng_set_filter("tcp and") == ERR_ARG);
+  fail_unless(pcapng_set_filter("tcp or udp or arp or ip or ip6 or icmp or icmp6 or inbound or outbound") == ERR_MEM);
+}
+END_TEST
+
+/** Build "((...(tcp)...))" or "!!...!tcp" nested 'depth' times */
+static const char *
+test_pcapng_nested_filter(char *buf, int depth, u8_t parens)
+{
+  int i;
+
+  for (i = 0; i < depth; i++) {
+    buf[i] = parens ? '(' : '!';
+  }
+  memcpy(&buf[depth], "tcp", 3);
+  for (i = 0; i < (parens ? depth : 0); i++) {
+    buf[depth + 3 + i] = ')';
+  }
+  buf[depth + 3 + i] = 0;
+  return buf;
+}
+
+START_TEST(test_pcapng_filter_nesting)
+{
+  char expr[2 * 64 + 4];
+  LWIP_UNUSED_ARG(_i);
+
+  /* nesting up to PCAPNG_FILTER_MAX_DEPTH is accepted */
+  fail_unless(pcapng_set_filter(test_pcapng_nested_filter(expr, PCAPNG_FILTER_MAX_DEPTH, 1)) == ERR_OK);
+  fail_unless(pcapng_set_filter(test_pcapng_nested_filter(expr, PCAPNG_FILTER_MAX_DEPTH, 0)) == ERR_OK);
+  fail_unless(pcapng_set_filter("!(!(!tcp))") == ERR_OK);
+
+  /* deeper (otherwise valid) nesting is rejected */
+  fail_unless(pcapng_set_filter(test_pcapng_nested_filter(expr, PCAPNG_FILTER_MAX_DEPTH + 1, 1)) == ERR_ARG);
+  fail_unless(pcapng_set_filter(test_pcapng_nested_filter(expr, PCAPNG_FILTER_MAX_DEPTH + 1, 0)) == ERR_ARG);
+  fail_unless(pcapng_set_filter(test_pcapng_nested_filter(expr, 64, 1)) == ERR_ARG);
+}
+END_TEST
+
+START_TEST(test_pcapng_capture_filter)
+{
+  struct pcapng_stats stats;
+  struct pbuf *p;
+  u16_t hdr_len;
+  u32_t len;
+  LWIP_UNUSED_ARG(_i);
+
+  testif_setup();
+  fail_unless(pcapng_attach(&pcapng_netif) == ERR_OK);
+  fail_unless(pcapng_attach(&pcapng_netif) == ERR_ALREADY);
+  fail_unless(pcapng_set_filter("tcp and dst port 80") == ERR_OK);
+
+  /* not started: nothing captured */
+  input_tcp_frame(1024, 80);
+  fail_unless(rx_calls == 1);
+  fail_unless(pcapng_read(out_buf, sizeof(out_buf)) == 0);
+
+  pcapng_start();
+  input_tcp_frame(1024, 80);
+  input_tcp_frame(80, 1024);
+  input_tcp_frame(1024, 81);
+  fail_unless(rx_calls == 4);
+  p = create_tcp_frame(2000, 80);
+  EXPECT_RET(p != NULL);
+  pcapng_netif.linkoutput(&pcapng_netif, p);
+  pbuf_free(p);
+  fail_unless(tx_calls == 1);
+
+  pcapng_get_stats(&stats);
+  fail_unless(stats.captured == 2);
+  fail_unless(stats.filtered == 2);
+  fail_unless(stats.dropped == 0);
+
+  /* file header: SHB + 1 IDB */
+  fail_unless(pcapng_get_header(out_buf, 10) == 0);
+  hdr_len = pcapng_get_header(out_buf, sizeof(out_buf));
+  fail_unless(hdr_len > 28);
+  fail_unless(get32(&out_buf[0]) == 0x0A0D0D0A);
+  fail_unless(get32(&out_buf[8]) == 0x1A2B3C4D);
+  fail_unless(get32(&out_buf[28]) == 1);
+
+  /* the first block does not fit */
+  fail_unless(pcapng_read(out_buf, 40) == 0);
+  len = pcapng_read(out_buf, sizeof(out_buf));
+  fail_unless(len == 2 * (44 + TEST_FRAME_LEN));
+  /* first EPB: inbound to port 80 */
+  fail_unless(get32(&out_buf[0]) == 6);
+  fail_unless(get32(&out_buf[4]) == 44 + TEST_FRAME_LEN);
+  fail_unless(get32(&out_buf[8]) == 0);
+  fail_unless(get32(&out_buf[20]) == TEST_FRAME_LEN);
+  fail_unless(get32(&out_buf[24]) == TEST_FRAME_LEN);
+  fail_unless(out_buf[28 + 37] == 80);
+  fail_unless(get32(&out_buf[28 + TEST_FRAME_LEN + 4]) == 1);
+  /* second EPB: outbound from 2000 */
+  fail_unless(out_buf[44 + TEST_FRAME_LEN + 28 + 34] == (2000 >> 8));
+  fail_unless(get32(&out_buf[44 + TEST_FRAME_LEN + 28 + TEST_FRAME_LEN + 4]) == 2);
+  fail_unless(pcapng_read(out_buf, sizeof(out_buf)) == 0);
+
+  fail_unless(pcapng_detach(&pcapng_netif) == ERR_OK);
+  fail_unless(pcapng_netif.input == testif_input);
+  fail_unless(pcapng_netif.linkoutput == testif_linkoutput);
+  fail_unless(pcapng_detach(&pcapng_netif) == ERR_VAL);
+}
+END_TEST
+
+START_TEST(test_pcapng_ring_full)
+{
+  struct pcapng_stats stats;
+  u32_t per_ring = PCAPNG_RINGBUF_SIZE / (44 + TEST_FRAME_LEN);
+  u32_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  testif_setup();
+  fail_unless(pcapng_attach(&pcapng_netif) == ERR_OK);
+  pcapng_start();
+
+  /* drop new packets when full */
+  for (i = 0; i < per_ring + 3; i++) {
+    input_tcp_frame((u16_t)i, 80);
+  }
+  pcapng_get_stats(&stats);
+  fail_unless(stats.captured == per_ring);
+  fail_unless(stats.dropped == 3);
+  fail_unless(pcapng_read(out_buf, sizeof(out_buf)) == per_ring * (44 + TEST_FRAME_LEN));
+
+  /* overwrite old packets when full */
+  pcapng_set_mode(PCAPNG_MODE_OVERWRITE);
+  for (i = 0; i < per_ring + 3; i++) {
+    input_tcp_frame((u16_t)i, 80);
+  }
+  pcapng_get_stats(&stats);
+  fail_unless(stats.dropped == 3);
+  fail_unless(stats.overwritten == 3);
+  fail_unless(pcapng_read(out_buf, sizeof(out_buf)) == per_ring * (44 + TEST_FRAME_LEN));
+  /* the oldest packet left is the 4th one (source port 3) */
+  fail_unless(out_buf[28 + 35] == 3);
+
+  /* snaplen */
+  pcapng_set_snaplen(20);
+  input_tcp_frame(1, 80);
+  fail_unless(pcapng_read(out_buf, sizeof(out_buf)) == 44 + 20);
+  fail_unless(get32(&out_buf[20]) == 20);
+  fail_unless(get32(&out_buf[24]) == TEST_FRAME_LEN);
+}
+END_TEST
+
+/** Create the suite including all tests for this module */
+Suite *
+pcapng_suite(void)
+{
+  testfunc tests[] = {
+    TESTFUNC(test_pcapng_filter_syntax),
+    TESTFUNC(test_pcapng_filter_nesting),
+    TESTFUNC(test_pcapng_capture_filter),
+    TESTFUNC(test_pcapng_ring_full)
+  };
+  return create_suite("PCAPNG", tests, sizeof(tests)/sizeof(testfunc), pcapng_setup, pcapng_teardown);
+}
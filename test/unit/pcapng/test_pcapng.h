@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TEST_PCAPNG_H
+#define LWIP_HDR_TEST_PCAPNG_H
+
+#include "../lwip_check.h"
+
+Suite *pcapng_suite(void);
+
+#endif
@@ -5,6 +5,10 @@
 #include "lwip/inet.h"
 #include "tcp_helper.h"
 #include "lwip/inet_chksum.h"
+#include "lwip/icmp.h"
+#include "lwip/ip4.h"
+#include "lwip/ip4_pmtu.h"
+#include "lwip/prot/ip4.h"
 
 #ifdef _MSC_VER
 #pragma warning(disable: 4307) /* we explicitly wrap around TCP seqnos */
@@ -1667,6 +1671,860 @@ START_TEST(test_tcp_persist_split)
 }
 END_TEST
 
+#if LWIP_TCP_INFO
+static void
+test_tcp_info_count_pcbs(struct tcp_pcb *pcb, void *arg)
+{
+  LWIP_UNUSED_ARG(pcb);
+  (*(int *)arg)++;
+}
+
+/** Check the counters returned by tcp_get_info() for dupacks, fast
+ * retransmission and zero window announcements */
+START_TEST(test_tcp_info)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb* pcb;
+  struct tcp_pcb_info info;
+  struct pbuf* p;
+  err_t err;
+  int i, num_pcbs;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < (int)sizeof(tx_data); i++) {
+    tx_data[i] = (u8_t)i;
+  }
+
+  /* initialize local vars */
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+
+  /* create and initialize the pcb */
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  /* disable initial congestion window (we don't send a SYN here...) */
+  pcb->cwnd = pcb->snd_wnd;
+
+  EXPECT(tcp_get_info(pcb, &info) == ERR_OK);
+  EXPECT(info.state == ESTABLISHED);
+  EXPECT(info.mss == TCP_MSS);
+  EXPECT(info.bytes_in_flight == 0);
+  EXPECT(info.total_retrans == 0);
+  EXPECT(info.total_dupacks == 0);
+  EXPECT(info.zero_wnd_events == 0);
+
+  /* send 2 segments */
+  err = tcp_write(pcb, tx_data, 2 * TCP_MSS, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT_RET(txcounters.num_tx_calls == 2);
+  EXPECT(tcp_get_info(pcb, &info) == ERR_OK);
+  EXPECT(info.bytes_in_flight == 2 * TCP_MSS);
+  EXPECT(info.snd_queue == 2 * TCP_MSS);
+  EXPECT(info.snd_queuelen == pcb->snd_queuelen);
+
+  /* 3 duplicate ACKs trigger fast retransmission */
+  for (i = 0; i < 3; i++) {
+    p = tcp_create_rx_segment(pcb, NULL, 0, 0, 0, TCP_ACK);
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, &netif);
+  }
+  EXPECT(tcp_get_info(pcb, &info) == ERR_OK);
+  EXPECT(info.dupacks == 3);
+  EXPECT(info.total_dupacks == 3);
+  EXPECT(info.total_retrans == 1);
+  EXPECT(info.nrtx == 1);
+
+  /* ACK everything but close the window */
+  p = tcp_create_rx_segment_wnd(pcb, NULL, 0, 0, 2 * TCP_MSS, TCP_ACK, 0);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(tcp_get_info(pcb, &info) == ERR_OK);
+  EXPECT(info.dupacks == 0);
+  EXPECT(info.total_dupacks == 3);
+  EXPECT(info.bytes_in_flight == 0);
+  EXPECT(info.snd_queue == 0);
+  EXPECT(info.snd_wnd == 0);
+  EXPECT(info.zero_wnd_events == 1);
+
+  /* the pcb is found by the iterator */
+  num_pcbs = 0;
+  tcp_pcb_foreach(test_tcp_info_count_pcbs, &num_pcbs);
+  EXPECT(num_pcbs == 1);
+
+  /* make sure the pcb is freed */
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 1);
+  tcp_abort(pcb);
+  EXPECT_RET(MEMP_STATS_GET(used, MEMP_TCP_PCB) == 0);
+  num_pcbs = 0;
+  tcp_pcb_foreach(test_tcp_info_count_pcbs, &num_pcbs);
+  EXPECT(num_pcbs == 0);
+}
+END_TEST
+#endif /* LWIP_TCP_INFO */
+
+#if LWIP_TCP_FASTOPEN
+static struct tcp_pcb *test_tcp_fastopen_accepted;
+
+static err_t
+test_tcp_fastopen_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  EXPECT_RETX(err == ERR_OK, ERR_VAL);
+  test_tcp_fastopen_accepted = newpcb;
+  tcp_recv(newpcb, test_tcp_counters_recv);
+  tcp_err(newpcb, test_tcp_counters_err);
+  return ERR_OK;
+}
+
+/** Create a segment carrying a TCP Fast Open option (cookie_len 0: request) */
+static struct pbuf *
+test_tcp_fastopen_segment(const ip_addr_t *src_ip, const ip_addr_t *dst_ip, u16_t src_port, u16_t dst_port,
+                          const u8_t *cookie, u8_t cookie_len, const void *data, u16_t data_len,
+                          u32_t seqno, u32_t ackno, u8_t headerflags)
+{
+  u8_t buf[64];
+  u8_t optlen = (u8_t)((2 + cookie_len + 3) & ~3);
+  ip_addr_t src = *src_ip;
+  ip_addr_t dst = *dst_ip;
+  struct tcp_hdr *tcphdr;
+  struct pbuf *p;
+
+  EXPECT_RETNULL(optlen + data_len <= sizeof(buf));
+  memset(buf, LWIP_TCP_OPT_NOP, optlen);
+  buf[0] = LWIP_TCP_OPT_FASTOPEN;
+  buf[1] = (u8_t)(2 + cookie_len);
+  if (cookie_len > 0) {
+    memcpy(&buf[2], cookie, cookie_len);
+  }
+  if (data_len > 0) {
+    memcpy(&buf[optlen], data, data_len);
+  }
+  p = tcp_create_segment(&src, &dst, src_port, dst_port, buf, optlen + data_len, seqno, ackno, headerflags);
+  EXPECT_RETNULL(p != NULL);
+  /* move the option bytes from the data into the header */
+  pbuf_header(p, -(s16_t)sizeof(struct ip_hdr));
+  tcphdr = (struct tcp_hdr *)p->payload;
+  TCPH_HDRLEN_SET(tcphdr, (sizeof(struct tcp_hdr) + optlen) / 4);
+  tcphdr->chksum = 0;
+  tcphdr->chksum = ip_chksum_pseudo(p, IP_PROTO_TCP, p->tot_len, &src, &dst);
+  pbuf_header(p, sizeof(struct ip_hdr));
+  return p;
+}
+
+/** Find the TCP Fast Open option in a transmitted packet (IP header first):
+ * returns the cookie length or -1 if there is no such option */
+static int
+test_tcp_fastopen_tx_option(struct pbuf *p, u8_t *cookie, u8_t *tcp_flags)
+{
+  u8_t hdr[60];
+  struct tcp_hdr *tcphdr = (struct tcp_hdr *)hdr;
+  u16_t hdrlen, i;
+
+  EXPECT_RETX(pbuf_copy_partial(p, hdr, sizeof(struct tcp_hdr), IP_HLEN) == sizeof(struct tcp_hdr), -1);
+  hdrlen = TCPH_HDRLEN_BYTES(tcphdr);
+  *tcp_flags = TCPH_FLAGS(tcphdr);
+  EXPECT_RETX(pbuf_copy_partial(p, hdr, hdrlen, IP_HLEN) == hdrlen, -1);
+  for (i = sizeof(struct tcp_hdr); i < hdrlen; ) {
+    if (hdr[i] == LWIP_TCP_OPT_NOP) {
+      i++;
+    } else if ((hdr[i] == LWIP_TCP_OPT_EOL) || (i + 1 >= hdrlen) || (hdr[i + 1] < 2)) {
+      break;
+    } else if (hdr[i] == LWIP_TCP_OPT_FASTOPEN) {
+      memcpy(cookie, &hdr[i + 2], (size_t)(hdr[i + 1] - 2));
+      return hdr[i + 1] - 2;
+    } else {
+      i = (u16_t)(i + hdr[i + 1]);
+    }
+  }
+  return -1;
+}
+
+/** Passive open: a cookie request is answered with a cookie, data in a SYN
+ * carrying a valid cookie is passed to the application before the
+ * handshake completes */
+START_TEST(test_tcp_fastopen_passive)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb, *lpcb;
+  struct pbuf *p;
+  char data[] = "hello";
+  u8_t cookie[TCP_FASTOPEN_COOKIE_LEN];
+  u8_t expected[TCP_FASTOPEN_COOKIE_LEN];
+  u8_t tcp_flags;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+  counters.expected_data = data;
+  counters.expected_data_len = sizeof(data);
+  test_tcp_fastopen_accepted = NULL;
+
+  pcb = tcp_new();
+  EXPECT_RET(pcb != NULL);
+  err = tcp_bind(pcb, &test_local_ip, TEST_LOCAL_PORT);
+  EXPECT_RET(err == ERR_OK);
+  tcp_fastopen(pcb, 1);
+  lpcb = tcp_listen(pcb);
+  EXPECT_RET(lpcb != NULL);
+  EXPECT(tcp_fastopen_enabled(lpcb));
+  tcp_arg(lpcb, &counters);
+  tcp_accept(lpcb, test_tcp_fastopen_accept);
+
+  /* cookie request: <SYN,ACK> carries our cookie */
+  txcounters.copy_tx_packets = 1;
+  p = test_tcp_fastopen_segment(&test_remote_ip, &test_local_ip, TEST_REMOTE_PORT, TEST_LOCAL_PORT,
+                                NULL, 0, NULL, 0, 1000, 0, TCP_SYN);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT_RET(txcounters.num_tx_calls == 1);
+  EXPECT_RET(txcounters.tx_packets != NULL);
+  EXPECT(test_tcp_fastopen_tx_option(txcounters.tx_packets, cookie, &tcp_flags) == TCP_FASTOPEN_COOKIE_LEN);
+  EXPECT(tcp_flags == (TCP_SYN | TCP_ACK));
+  tcp_fastopen_cookie(&test_remote_ip, expected);
+  EXPECT(memcmp(cookie, expected, TCP_FASTOPEN_COOKIE_LEN) == 0);
+  pbuf_free(txcounters.tx_packets);
+  txcounters.tx_packets = NULL;
+  EXPECT(test_tcp_fastopen_accepted == NULL);
+
+  /* data with an invalid cookie is not accepted early */
+  cookie[0] ^= 0xff;
+  p = test_tcp_fastopen_segment(&test_remote_ip, &test_local_ip, TEST_REMOTE_PORT + 1, TEST_LOCAL_PORT,
+                                cookie, TCP_FASTOPEN_COOKIE_LEN, data, sizeof(data), 2000, 0, TCP_SYN);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(test_tcp_fastopen_accepted == NULL);
+  EXPECT(counters.recv_calls == 0);
+  EXPECT_RET(txcounters.num_tx_calls == 2);
+  pbuf_free(txcounters.tx_packets);
+  txcounters.tx_packets = NULL;
+
+  /* data with a valid cookie: accepted, passed on and acknowledged by the <SYN,ACK> */
+  p = test_tcp_fastopen_segment(&test_remote_ip, &test_local_ip, TEST_REMOTE_PORT + 2, TEST_LOCAL_PORT,
+                                expected, TCP_FASTOPEN_COOKIE_LEN, data, sizeof(data), 3000, 0, TCP_SYN | TCP_PSH);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT_RET(test_tcp_fastopen_accepted != NULL);
+  EXPECT(test_tcp_fastopen_accepted->state == SYN_RCVD);
+  EXPECT(test_tcp_fastopen_accepted->rcv_nxt == 3000 + 1 + sizeof(data));
+  EXPECT(counters.recv_calls == 1);
+  EXPECT(counters.recved_bytes == sizeof(data));
+  EXPECT_RET(txcounters.num_tx_calls == 3);
+  EXPECT(test_tcp_fastopen_tx_option(txcounters.tx_packets, cookie, &tcp_flags) == -1);
+  txcounters.copy_tx_packets = 0;
+  pbuf_free(txcounters.tx_packets);
+  txcounters.tx_packets = NULL;
+
+  /* the ACK completes the handshake without a second accept */
+  pcb = test_tcp_fastopen_accepted;
+  test_tcp_fastopen_accepted = NULL;
+  p = tcp_create_rx_segment(pcb, NULL, 0, 0, 1, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->state == ESTABLISHED);
+  EXPECT(test_tcp_fastopen_accepted == NULL);
+  EXPECT(counters.err_calls == 0);
+}
+END_TEST
+
+/** Active open: request a cookie, then send data with the SYN; data not
+ * acknowledged by the <SYN,ACK> is sent again */
+START_TEST(test_tcp_fastopen_active)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf *p;
+  u8_t data[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  u8_t server_cookie[TCP_FASTOPEN_COOKIE_LEN] = {0xde, 0xad, 0xbe, 0xef, 0x01, 0x02, 0x03, 0x04};
+  u8_t cookie[TCP_FASTOPEN_COOKIE_LEN];
+  u8_t tcp_flags;
+  u32_t iss;
+  int round;
+  err_t err;
+  ip_addr_t local_ip = test_local_ip;
+  ip_addr_t remote_ip = test_remote_ip;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+  tcp_fastopen_cache_set(&test_remote_ip, NULL, 0);
+
+  /* no cookie yet: the SYN is sent right away with a cookie request */
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  txcounters.copy_tx_packets = 1;
+  err = tcp_connect_flags(pcb, &test_remote_ip, TEST_REMOTE_PORT, NULL, TCP_CONNECT_FLAG_FASTOPEN);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT_RET(txcounters.num_tx_calls == 1);
+  EXPECT(test_tcp_fastopen_tx_option(txcounters.tx_packets, cookie, &tcp_flags) == 0);
+  EXPECT(tcp_flags == TCP_SYN);
+  pbuf_free(txcounters.tx_packets);
+  txcounters.tx_packets = NULL;
+
+  /* the <SYN,ACK> carries the cookie, which is cached */
+  iss = pcb->lastack;
+  p = test_tcp_fastopen_segment(&test_remote_ip, &test_local_ip, TEST_REMOTE_PORT, pcb->local_port,
+                                server_cookie, sizeof(server_cookie), NULL, 0, 5000, iss + 1, TCP_SYN | TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(pcb->state == ESTABLISHED);
+  EXPECT(tcp_fastopen_cache_get(&test_remote_ip, cookie) == sizeof(server_cookie));
+  EXPECT(memcmp(cookie, server_cookie, sizeof(server_cookie)) == 0);
+  tcp_abort(pcb);
+  pbuf_free(txcounters.tx_packets);
+  txcounters.tx_packets = NULL;
+
+  /* round 0: the server acknowledges the data in the SYN,
+     round 1: the server only acknowledges the SYN */
+  for (round = 0; round < 2; round++) {
+    memset(&txcounters, 0, sizeof(txcounters));
+    txcounters.copy_tx_packets = 1;
+    pcb = test_tcp_new_counters_pcb(&counters);
+    EXPECT_RET(pcb != NULL);
+    err = tcp_connect_flags(pcb, &test_remote_ip, TEST_REMOTE_PORT, NULL, TCP_CONNECT_FLAG_FASTOPEN);
+    EXPECT_RET(err == ERR_OK);
+    /* the SYN waits for data */
+    EXPECT_RET(txcounters.num_tx_calls == 0);
+    err = tcp_write(pcb, data, sizeof(data), TCP_WRITE_FLAG_COPY);
+    EXPECT_RET(err == ERR_OK);
+    err = tcp_output(pcb);
+    EXPECT_RET(err == ERR_OK);
+    EXPECT_RET(txcounters.num_tx_calls == 1);
+    EXPECT(txcounters.num_tx_bytes == 40 + LWIP_TCP_OPT_LEN_MSS + LWIP_TCP_OPT_LEN_WS_OUT +
+           LWIP_TCP_OPT_LEN_FASTOPEN_OUT + sizeof(data));
+    EXPECT(test_tcp_fastopen_tx_option(txcounters.tx_packets, cookie, &tcp_flags) == sizeof(server_cookie));
+    EXPECT(tcp_flags & TCP_SYN);
+    EXPECT(memcmp(cookie, server_cookie, sizeof(server_cookie)) == 0);
+    EXPECT(pcb->snd_nxt == pcb->lastack + 1 + sizeof(data));
+    pbuf_free(txcounters.tx_packets);
+    txcounters.tx_packets = NULL;
+    txcounters.num_tx_calls = 0;
+    txcounters.num_tx_bytes = 0;
+
+    iss = pcb->lastack;
+    if (round == 0) {
+      p = test_tcp_fastopen_segment(&test_remote_ip, &test_local_ip, TEST_REMOTE_PORT, pcb->local_port,
+                                    server_cookie, sizeof(server_cookie), NULL, 0, 5000,
+                                    iss + 1 + sizeof(data), TCP_SYN | TCP_ACK);
+    } else {
+      p = tcp_create_segment(&remote_ip, &local_ip, TEST_REMOTE_PORT,
+                             pcb->local_port, NULL, 0, 5000, iss + 1, TCP_SYN | TCP_ACK);
+    }
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, &netif);
+    EXPECT(pcb->state == ESTABLISHED);
+    EXPECT(txcounters.num_tx_calls == 1);
+    if (round == 0) {
+      /* only an ACK */
+      EXPECT(pcb->snd_buf == TCP_SND_BUF);
+      EXPECT(txcounters.num_tx_bytes == 40);
+      EXPECT(pcb->unsent == NULL);
+      EXPECT(pcb->unacked == NULL);
+      EXPECT(pcb->snd_queuelen == 0);
+      EXPECT(tcp_fastopen_cache_get(&test_remote_ip, cookie) == sizeof(server_cookie));
+    } else {
+      /* the data is sent again, the cookie is forgotten */
+      EXPECT(txcounters.num_tx_bytes == 40 + sizeof(data));
+      EXPECT(pcb->snd_buf == TCP_SND_BUF - sizeof(data));
+      EXPECT(pcb->unacked != NULL);
+      EXPECT(pcb->snd_nxt == iss + 1 + sizeof(data));
+      EXPECT(tcp_fastopen_cache_get(&test_remote_ip, cookie) == 0);
+    }
+    txcounters.copy_tx_packets = 0;
+    pbuf_free(txcounters.tx_packets);
+    txcounters.tx_packets = NULL;
+    tcp_abort(pcb);
+  }
+  EXPECT(counters.err_calls == 3);
+}
+END_TEST
+#endif /* LWIP_TCP_FASTOPEN */
+
+#if LWIP_TCP_SYNCOOKIES
+static struct tcp_pcb *test_tcp_syncookie_accepted;
+
+static err_t
+test_tcp_syncookie_accept(void *arg, struct tcp_pcb *newpcb, err_t err)
+{
+  LWIP_UNUSED_ARG(arg);
+  EXPECT_RETX(err == ERR_OK, ERR_VAL);
+  test_tcp_syncookie_accepted = newpcb;
+  return ERR_OK;
+}
+
+static int
+test_tcp_syncookie_count_pcbs(void)
+{
+  struct tcp_pcb *pcb;
+  int n = 0;
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+    n++;
+  }
+  return n;
+}
+
+/** With the SYN queue full, a SYN is answered statelessly and the pcb is
+ * only created by a valid ACK */
+START_TEST(test_tcp_syncookies)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct tcp_pcb *pcb, *lpcb;
+  struct tcp_hdr hdr;
+  struct pbuf *p;
+  ip_addr_t remote_ip = test_remote_ip;
+  ip_addr_t local_ip = test_local_ip;
+  u32_t iss;
+  u16_t i;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  test_tcp_syncookie_accepted = NULL;
+
+  pcb = tcp_new();
+  EXPECT_RET(pcb != NULL);
+  err = tcp_bind(pcb, &test_local_ip, TEST_LOCAL_PORT);
+  EXPECT_RET(err == ERR_OK);
+  lpcb = tcp_listen(pcb);
+  EXPECT_RET(lpcb != NULL);
+  tcp_accept(lpcb, test_tcp_syncookie_accept);
+
+  /* fill the SYN queue */
+  for (i = 0; i < TCP_SYN_QUEUE_LEN; i++) {
+    p = tcp_create_segment(&remote_ip, &local_ip, (u16_t)(TEST_REMOTE_PORT + i), TEST_LOCAL_PORT,
+                           NULL, 0, 1000, 0, TCP_SYN);
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, &netif);
+  }
+  EXPECT_RET(txcounters.num_tx_calls == TCP_SYN_QUEUE_LEN);
+  EXPECT(test_tcp_syncookie_count_pcbs() == TCP_SYN_QUEUE_LEN);
+  EXPECT(((struct tcp_pcb_listen *)lpcb)->syn_queued == TCP_SYN_QUEUE_LEN);
+
+  /* the next SYN gets a <SYN,ACK> without a pcb being allocated */
+  txcounters.copy_tx_packets = 1;
+  p = tcp_create_segment(&remote_ip, &local_ip, TEST_REMOTE_PORT + 100, TEST_LOCAL_PORT,
+                         NULL, 0, 5000, 0, TCP_SYN);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT_RET(txcounters.num_tx_calls == TCP_SYN_QUEUE_LEN + 1);
+  EXPECT_RET(txcounters.tx_packets != NULL);
+  EXPECT_RET(pbuf_copy_partial(txcounters.tx_packets, &hdr, sizeof(hdr), IP_HLEN) == sizeof(hdr));
+  EXPECT(TCPH_FLAGS(&hdr) == (TCP_SYN | TCP_ACK));
+  EXPECT(lwip_ntohl(hdr.ackno) == 5001);
+  iss = lwip_ntohl(hdr.seqno);
+  pbuf_free(txcounters.tx_packets);
+  txcounters.tx_packets = NULL;
+  EXPECT(test_tcp_syncookie_count_pcbs() == TCP_SYN_QUEUE_LEN);
+
+  /* an ACK with a wrong cookie is reset */
+  p = tcp_create_segment(&remote_ip, &local_ip, TEST_REMOTE_PORT + 100, TEST_LOCAL_PORT,
+                         NULL, 0, 5001, iss + 2, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT_RET(txcounters.num_tx_calls == TCP_SYN_QUEUE_LEN + 2);
+  EXPECT_RET(txcounters.tx_packets != NULL);
+  EXPECT_RET(pbuf_copy_partial(txcounters.tx_packets, &hdr, sizeof(hdr), IP_HLEN) == sizeof(hdr));
+  EXPECT(TCPH_FLAGS(&hdr) & TCP_RST);
+  pbuf_free(txcounters.tx_packets);
+  txcounters.tx_packets = NULL;
+  txcounters.copy_tx_packets = 0;
+  EXPECT(test_tcp_syncookie_accepted == NULL);
+
+  /* the valid ACK creates the connection */
+  p = tcp_create_segment(&remote_ip, &local_ip, TEST_REMOTE_PORT + 100, TEST_LOCAL_PORT,
+                         NULL, 0, 5001, iss + 1, TCP_ACK);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT_RET(test_tcp_syncookie_accepted != NULL);
+  pcb = test_tcp_syncookie_accepted;
+  EXPECT(pcb->state == ESTABLISHED);
+  EXPECT(pcb->remote_port == TEST_REMOTE_PORT + 100);
+  EXPECT(pcb->rcv_nxt == 5001);
+  EXPECT(pcb->snd_nxt == iss + 1);
+  EXPECT(pcb->lastack == iss + 1);
+  EXPECT(pcb->mss == 536);
+  EXPECT(txcounters.num_tx_calls == TCP_SYN_QUEUE_LEN + 2);
+  EXPECT(((struct tcp_pcb_listen *)lpcb)->syn_queued == TCP_SYN_QUEUE_LEN);
+
+  /* removing a half-open connection makes room in the SYN queue again */
+  for (pcb = tcp_active_pcbs; pcb != NULL; pcb = pcb->next) {
+    if (pcb->state == SYN_RCVD) {
+      break;
+    }
+  }
+  EXPECT_RET(pcb != NULL);
+  tcp_abort(pcb);
+  EXPECT(((struct tcp_pcb_listen *)lpcb)->syn_queued == TCP_SYN_QUEUE_LEN - 1);
+  i = (u16_t)test_tcp_syncookie_count_pcbs();
+  p = tcp_create_segment(&remote_ip, &local_ip, TEST_REMOTE_PORT + 101, TEST_LOCAL_PORT,
+                         NULL, 0, 7000, 0, TCP_SYN);
+  EXPECT_RET(p != NULL);
+  test_tcp_input(p, &netif);
+  EXPECT(test_tcp_syncookie_count_pcbs() == i + 1);
+  EXPECT(((struct tcp_pcb_listen *)lpcb)->syn_queued == TCP_SYN_QUEUE_LEN);
+}
+END_TEST
+#endif /* LWIP_TCP_SYNCOOKIES */
+
+#if LWIP_IPV4_PMTU
+/** Create an ICMP 'fragmentation needed' message (sent by the remote host)
+ * for a segment sent by pcb */
+static struct pbuf *
+test_tcp_create_frag_needed(struct tcp_pcb *pcb, u32_t seqno, u16_t mtu)
+{
+  struct pbuf *p;
+  struct ip_hdr *iphdr, *orig_iphdr;
+  struct icmp_hdr *icmphdr;
+  struct tcp_hdr *tcphdr;
+  const u16_t len = IP_HLEN + sizeof(struct icmp_hdr) + IP_HLEN + 8;
+
+  p = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+  if (p == NULL) {
+    return NULL;
+  }
+  memset(p->payload, 0, len);
+  iphdr = (struct ip_hdr *)p->payload;
+  icmphdr = (struct icmp_hdr *)((u8_t *)p->payload + IP_HLEN);
+  orig_iphdr = (struct ip_hdr *)((u8_t *)icmphdr + sizeof(struct icmp_hdr));
+  tcphdr = (struct tcp_hdr *)((u8_t *)orig_iphdr + IP_HLEN);
+
+  /* the first 8 bytes of the segment that was too big */
+  tcphdr->src = lwip_htons(pcb->local_port);
+  tcphdr->dest = lwip_htons(pcb->remote_port);
+  tcphdr->seqno = lwip_htonl(seqno);
+  IPH_VHL_SET(orig_iphdr, 4, IP_HLEN / 4);
+  IPH_LEN_SET(orig_iphdr, lwip_htons(1500));
+  IPH_OFFSET_SET(orig_iphdr, PP_HTONS(IP_DF));
+  IPH_TTL_SET(orig_iphdr, 64);
+  IPH_PROTO_SET(orig_iphdr, IP_PROTO_TCP);
+  ip4_addr_copy(orig_iphdr->src, *ip_2_ip4(&pcb->local_ip));
+  ip4_addr_copy(orig_iphdr->dest, *ip_2_ip4(&pcb->remote_ip));
+  IPH_CHKSUM_SET(orig_iphdr, inet_chksum(orig_iphdr, IP_HLEN));
+
+  ICMPH_TYPE_SET(icmphdr, ICMP_DUR);
+  ICMPH_CODE_SET(icmphdr, ICMP_DUR_FRAG);
+  icmphdr->data = lwip_htonl(mtu);
+  icmphdr->chksum = inet_chksum(icmphdr, (u16_t)(len - IP_HLEN));
+
+  IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+  IPH_LEN_SET(iphdr, lwip_htons(len));
+  IPH_TTL_SET(iphdr, 64);
+  IPH_PROTO_SET(iphdr, IP_PROTO_ICMP);
+  ip4_addr_copy(iphdr->src, *ip_2_ip4(&pcb->remote_ip));
+  ip4_addr_copy(iphdr->dest, *ip_2_ip4(&pcb->local_ip));
+  IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+  return p;
+}
+
+/** Check that an ICMP 'fragmentation needed' message for data in flight
+ * reduces the MSS and retransmits in smaller segments, and that other
+ * connections to that destination send smaller segments right away */
+START_TEST(test_tcp_pmtu)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  struct pbuf *p;
+  u8_t pmtu_data[3 * TCP_MSS];
+  int i;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < (int)sizeof(pmtu_data); i++) {
+    pmtu_data[i] = (u8_t)i;
+  }
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  netif.mtu = 1500;
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  pcb->cwnd = TCP_WND;
+  tcp_nagle_disable(pcb);
+
+  err = tcp_write(pcb, pmtu_data, sizeof(pmtu_data), TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT_RET(txcounters.num_tx_calls == 3);
+  memset(&txcounters, 0, sizeof(txcounters));
+
+  /* a message about data not in flight is ignored */
+  p = test_tcp_create_frag_needed(pcb, pcb->lastack - TCP_MSS, 500);
+  EXPECT_RET(p != NULL);
+  EXPECT(ip4_input(p, &netif) == ERR_OK);
+  EXPECT(ip4_pmtu_get(ip_2_ip4(&test_remote_ip), &netif) == 1500);
+  EXPECT(pcb->mss == TCP_MSS);
+  /* so is a message about another connection */
+  pcb->local_port++;
+  p = test_tcp_create_frag_needed(pcb, pcb->lastack, 500);
+  pcb->local_port--;
+  EXPECT_RET(p != NULL);
+  EXPECT(ip4_input(p, &netif) == ERR_OK);
+  EXPECT(ip4_pmtu_get(ip_2_ip4(&test_remote_ip), &netif) == 1500);
+  EXPECT(pcb->mss == TCP_MSS);
+  EXPECT(txcounters.num_tx_calls == 0);
+
+  /* the first segment was too big: everything in flight is resent */
+  p = test_tcp_create_frag_needed(pcb, pcb->lastack, 500);
+  EXPECT_RET(p != NULL);
+  EXPECT(ip4_input(p, &netif) == ERR_OK);
+  EXPECT(pcb->mss == IP4_PMTU_MIN - 40);
+  EXPECT(txcounters.num_tx_calls == 6);
+  EXPECT(txcounters.num_tx_bytes == 3 * (IP4_PMTU_MIN + 24 + 40U));
+  EXPECT(pcb->unsent == NULL);
+  EXPECT(pcb->cwnd == TCP_WND);
+  EXPECT(ip4_pmtu_get(ip_2_ip4(&test_remote_ip), &netif) == IP4_PMTU_MIN);
+  EXPECT(counters.err_calls == 0);
+  tcp_abort(pcb);
+  memset(&counters, 0, sizeof(counters));
+
+  /* another connection to the same destination reduces its MSS before
+     sending, without waiting for a retransmission timeout */
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  pcb->cwnd = TCP_WND;
+  tcp_nagle_disable(pcb);
+  memset(&txcounters, 0, sizeof(txcounters));
+  err = tcp_write(pcb, pmtu_data, TCP_MSS, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(pcb->mss == IP4_PMTU_MIN - 40);
+  EXPECT(txcounters.num_tx_calls == 2);
+  EXPECT(txcounters.num_tx_bytes == TCP_MSS + 2 * 40U);
+  EXPECT(pcb->unsent == NULL);
+  EXPECT(pcb->cwnd == TCP_WND);
+
+  /* ensure no errors have been recorded */
+  EXPECT(counters.err_calls == 0);
+  tcp_abort(pcb);
+
+  /* other DF packets exceeding the PMTU are rejected */
+  memset(&txcounters, 0, sizeof(txcounters));
+  p = pbuf_alloc(PBUF_IP, IP4_PMTU_MIN, PBUF_RAM);
+  EXPECT_RET(p != NULL);
+  memset(p->payload, 0, p->len);
+  EXPECT(ip4_output_if(p, ip_2_ip4(&test_local_ip), ip_2_ip4(&test_remote_ip), 64, 0,
+                       IP_PROTO_TCP, &netif) == ERR_MTU);
+  EXPECT(txcounters.num_tx_calls == 0);
+  pbuf_free(p);
+
+  /* let the PMTU expire */
+  for (i = 0; i < IP4_PMTU_TIMEOUT; i++) {
+    ip4_pmtu_tmr();
+  }
+  EXPECT(ip4_pmtu_get(ip_2_ip4(&test_remote_ip), &netif) == 1500);
+  EXPECT(ip4_pmtu_lowest == 0xffff);
+}
+END_TEST
+#endif /* LWIP_IPV4_PMTU */
+
+#if TCP_PLPMTUD
+/** Acknowledge everything sent so far */
+static void
+test_tcp_ack_all(struct tcp_pcb *pcb, struct netif *netif)
+{
+  int i;
+
+  for (i = 0; (i < 10) && ((pcb->unacked != NULL) || (pcb->unsent != NULL)); i++) {
+    struct pbuf *p = tcp_create_rx_segment(pcb, NULL, 0, 0, pcb->snd_nxt - pcb->lastack, TCP_ACK);
+    EXPECT_RET(p != NULL);
+    test_tcp_input(p, netif);
+  }
+  EXPECT(pcb->unacked == NULL);
+  EXPECT(pcb->unsent == NULL);
+}
+
+/** Check black hole detection and the PLPMTUD search */
+START_TEST(test_tcp_plpmtud)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  u8_t pmtu_data[1460];
+  u16_t probe;
+  int i;
+  err_t err;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < (int)sizeof(pmtu_data); i++) {
+    pmtu_data[i] = (u8_t)i;
+  }
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  netif.mtu = 1500;
+  memset(&counters, 0, sizeof(counters));
+
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = 1460;
+  pcb->cwnd = TCP_WND;
+  tcp_nagle_disable(pcb);
+
+  err = tcp_write(pcb, pmtu_data, sizeof(pmtu_data), TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT_RET(txcounters.num_tx_calls == 1);
+
+  /* the first retransmission keeps the MSS */
+  for (i = 0; (pcb->nrtx == 0) && (i < 100); i++) {
+    test_tcp_tmr();
+  }
+  EXPECT_RET(pcb->nrtx == 1);
+  EXPECT(pcb->mss == 1460);
+  memset(&txcounters, 0, sizeof(txcounters));
+
+  /* the second one is taken as a black hole */
+  for (i = 0; (pcb->nrtx == 1) && (i < 100); i++) {
+    test_tcp_tmr();
+  }
+  EXPECT_RET(pcb->nrtx == 2);
+  EXPECT(pcb->mss == TCP_PLPMTUD_BASE_MSS);
+  EXPECT(pcb->plpmtud_max == 1460);
+  EXPECT(pcb->plpmtud_high == 1459);
+  EXPECT(txcounters.num_tx_calls == 1);
+  EXPECT(txcounters.num_tx_bytes == TCP_PLPMTUD_BASE_MSS + 40U);
+  test_tcp_ack_all(pcb, &netif);
+
+  /* the search starts in the middle of the range */
+  for (i = 0; (pcb->plpmtud_state == TCP_PLPMTUD_IDLE) && (i < 4); i++) {
+    test_tcp_tmr();
+  }
+  probe = (TCP_PLPMTUD_BASE_MSS + 1459 + 1) / 2;
+  EXPECT_RET(pcb->plpmtud_state == TCP_PLPMTUD_PROBE);
+  EXPECT(pcb->mss == probe);
+  memset(&txcounters, 0, sizeof(txcounters));
+  pcb->cwnd = TCP_WND;
+  err = tcp_write(pcb, pmtu_data, probe, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(txcounters.num_tx_bytes == probe + 40U);
+  EXPECT(pcb->plpmtud_state == TCP_PLPMTUD_INFLIGHT);
+
+  /* the probe is acknowledged: the larger MSS is kept */
+  test_tcp_ack_all(pcb, &netif);
+  EXPECT(pcb->plpmtud_state == TCP_PLPMTUD_IDLE);
+  EXPECT(pcb->mss == probe);
+
+  /* the next probe is lost */
+  for (i = 0; (pcb->plpmtud_state == TCP_PLPMTUD_IDLE) && (i < 4); i++) {
+    test_tcp_tmr();
+  }
+  EXPECT_RET(pcb->plpmtud_state == TCP_PLPMTUD_PROBE);
+  EXPECT(pcb->mss == (probe + 1459 + 1) / 2);
+  pcb->cwnd = TCP_WND;
+  err = tcp_write(pcb, pmtu_data, pcb->mss, TCP_WRITE_FLAG_COPY);
+  EXPECT_RET(err == ERR_OK);
+  err = tcp_output(pcb);
+  EXPECT_RET(err == ERR_OK);
+  EXPECT(pcb->plpmtud_state == TCP_PLPMTUD_INFLIGHT);
+  memset(&txcounters, 0, sizeof(txcounters));
+  for (i = 0; (pcb->nrtx == 0) && (i < 100); i++) {
+    test_tcp_tmr();
+  }
+  EXPECT_RET(pcb->nrtx == 1);
+  EXPECT(pcb->mss == probe);
+  EXPECT(pcb->plpmtud_high == (probe + 1459 + 1) / 2 - 1);
+  /* the retransmission fits the old MSS */
+  EXPECT(txcounters.num_tx_calls == 1);
+  EXPECT(txcounters.num_tx_bytes == probe + 40U);
+
+  /* ensure no errors have been recorded */
+  EXPECT(counters.err_calls == 0);
+  tcp_abort(pcb);
+}
+END_TEST
+#endif /* TCP_PLPMTUD */
+
+#if TCP_CHECKSUM_ON_COPY
+/** Send data with checksums calculated in advance. Wrong checksums of
+ * segments are detected by TCP_CHECKSUM_ON_COPY_SANITY_CHECK. */
+START_TEST(test_tcp_write_chksum)
+{
+  struct netif netif;
+  struct test_tcp_txcounters txcounters;
+  struct test_tcp_counters counters;
+  struct tcp_pcb *pcb;
+  err_t err;
+  u16_t i;
+  LWIP_UNUSED_ARG(_i);
+
+  for (i = 0; i < 3 * TCP_MSS; i++) {
+    tx_data[i] = (u8_t)(i * 7);
+  }
+
+  test_tcp_init_netif(&netif, &txcounters, &test_local_ip, &test_netmask);
+  memset(&counters, 0, sizeof(counters));
+  tcp_ticks = SEQNO1 - ISS;
+  pcb = test_tcp_new_counters_pcb(&counters);
+  EXPECT_RET(pcb != NULL);
+  tcp_set_state(pcb, ESTABLISHED, &test_local_ip, &test_remote_ip, TEST_LOCAL_PORT, TEST_REMOTE_PORT);
+  pcb->mss = TCP_MSS;
+  pcb->cwnd = 5 * TCP_MSS;
+  pcb->snd_wnd = 5 * TCP_MSS;
+  pcb->snd_wnd_max = 5 * TCP_MSS;
+  tcp_nagle_disable(pcb);
+
+  /* a full segment */
+  err = tcp_write_chksum(pcb, &tx_data[0], TCP_MSS, 0, (u16_t)~inet_chksum(&tx_data[0], TCP_MSS));
+  EXPECT(err == ERR_OK);
+  EXPECT(pcb->unsent != NULL);
+  EXPECT(pcb->unsent->len == TCP_MSS);
+
+  /* an odd-sized chunk appended to a segment with space left */
+  err = tcp_write(pcb, &tx_data[TCP_MSS], 10, 0);
+  EXPECT(err == ERR_OK);
+  err = tcp_write_chksum(pcb, &tx_data[TCP_MSS + 10], 101, 0, (u16_t)~inet_chksum(&tx_data[TCP_MSS + 10], 101));
+  EXPECT(err == ERR_OK);
+  EXPECT_RET(pcb->unsent->next != NULL);
+  EXPECT(pcb->unsent->next->len == 111);
+  EXPECT(pcb->unsent->next->next == NULL);
+
+  /* a chunk that does not fit into the segment with space left is not split */
+  err = tcp_write_chksum(pcb, &tx_data[TCP_MSS + 111], TCP_MSS - 100, 0,
+                         (u16_t)~inet_chksum(&tx_data[TCP_MSS + 111], TCP_MSS - 100));
+  EXPECT(err == ERR_OK);
+  EXPECT(pcb->unsent->next->len == 111);
+  EXPECT_RET(pcb->unsent->next->next != NULL);
+  EXPECT(pcb->unsent->next->next->len == TCP_MSS - 100);
+
+  /* data that has to be split is checksummed in parts (a wrong checksum is ignored) */
+  err = tcp_write_chksum(pcb, &tx_data[2 * TCP_MSS + 11], TCP_MSS + 1, 0, 0x1234);
+  EXPECT(err == ERR_OK);
+
+  err = tcp_output(pcb);
+  EXPECT(err == ERR_OK);
+  EXPECT(pcb->unsent == NULL);
+  EXPECT(txcounters.num_tx_bytes == (3 * TCP_MSS + 12) + (40U * txcounters.num_tx_calls));
+
+  /* ensure no errors have been recorded */
+  EXPECT(counters.err_calls == 0);
+  tcp_abort(pcb);
+}
+END_TEST
+#endif /* TCP_CHECKSUM_ON_COPY */
+
+
 /** Create the suite including all tests for this module */
 Suite *
 tcp_suite(void)
@@ -1692,7 +2550,26 @@ tcp_suite(void)
     TESTFUNC(test_tcp_rto_timeout_syn_sent_link_down),
     TESTFUNC(test_tcp_zwp_timeout),
     TESTFUNC(test_tcp_zwp_timeout_link_down),
-    TESTFUNC(test_tcp_persist_split)
+    TESTFUNC(test_tcp_persist_split),
+#if LWIP_TCP_INFO
+    TESTFUNC(test_tcp_info),
+#endif /* LWIP_TCP_INFO */
+#if LWIP_TCP_FASTOPEN
+    TESTFUNC(test_tcp_fastopen_passive),
+    TESTFUNC(test_tcp_fastopen_active),
+#endif /* LWIP_TCP_FASTOPEN */
+#if LWIP_TCP_SYNCOOKIES
+    TESTFUNC(test_tcp_syncookies),
+#endif /* LWIP_TCP_SYNCOOKIES */
+#if LWIP_IPV4_PMTU
+    TESTFUNC(test_tcp_pmtu),
+#endif /* LWIP_IPV4_PMTU */
+#if TCP_PLPMTUD
+    TESTFUNC(test_tcp_plpmtud),
+#endif /* TCP_PLPMTUD */
+#if TCP_CHECKSUM_ON_COPY
+    TESTFUNC(test_tcp_write_chksum),
+#endif /* TCP_CHECKSUM_ON_COPY */
   };
   return create_suite("TCP", tests, sizeof(tests)/sizeof(testfunc), tcp_setup, tcp_teardown);
 }